@@ -32,10 +32,28 @@
 #include <sapi/tpm20.h>
 #include "debug.h"
 
+static DEBUG_PRINTF_HOOK volatile debugPrintfHook = 0;
+static DEBUG_PRINT_BUFFER_HOOK volatile debugPrintBufferHook = 0;
+
+void SetDebugHooks( DEBUG_PRINTF_HOOK printfHook, DEBUG_PRINT_BUFFER_HOOK printBufferHook )
+{
+    debugPrintfHook = printfHook;
+    debugPrintBufferHook = printBufferHook;
+}
+
 int DebugPrintf( printf_type type, const char *format, ...)
 {
     va_list args;
     int rval = 0;
+    DEBUG_PRINTF_HOOK hook = debugPrintfHook;
+
+    if( hook != 0 )
+    {
+        va_start( args, format );
+        rval = hook( type, format, args );
+        va_end( args );
+        return rval;
+    }
 
     if( type == RM_PREFIX )
         printf( "||  " );
@@ -55,6 +73,15 @@ int DebugPrintfCallback( void *data, printf_type type, const char *format, ...)
 {
     va_list args;
     int rval = 0;
+    DEBUG_PRINTF_HOOK hook = debugPrintfHook;
+
+    if( hook != 0 )
+    {
+        va_start( args, format );
+        rval = hook( type, format, args );
+        va_end( args );
+        return rval;
+    }
 
     if( type == RM_PREFIX )
         DebugPrintfCallback( data, NO_PREFIX,  "||  " );
@@ -69,6 +96,13 @@ int DebugPrintfCallback( void *data, printf_type type, const char *format, ...)
 void DebugPrintBuffer( printf_type type, UINT8 *buffer, UINT32 length )
 {
     UINT32  i;
+    DEBUG_PRINT_BUFFER_HOOK hook = debugPrintBufferHook;
+
+    if( hook != 0 )
+    {
+        hook( type, buffer, length );
+        return;
+    }
 
     for( i = 0; i < length; i++ )
     {
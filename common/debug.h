@@ -31,6 +31,7 @@
 #include <sapi/tpm20.h>
 #include <tcti/tcti_socket.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include "sockets.h"
 
 #ifdef __cplusplus
@@ -45,6 +46,13 @@ void DebugPrintBuffer( printf_type type, UINT8 *command_buffer, UINT32 cnt1 );
 int DebugPrintBufferCallback( void *data, printf_type type, UINT8 *buffer, UINT32 length );
 const char* strTpmCommandCode( TPM_CC code );
 
+// When set, DebugPrintf, DebugPrintfCallback and DebugPrintBuffer hand
+// their arguments to these instead of writing to stdout; see
+// resourcemgr/asynclog.h.
+typedef int (*DEBUG_PRINTF_HOOK)( printf_type type, const char *format, va_list args );
+typedef void (*DEBUG_PRINT_BUFFER_HOOK)( printf_type type, UINT8 *buffer, UINT32 length );
+void SetDebugHooks( DEBUG_PRINTF_HOOK printfHook, DEBUG_PRINT_BUFFER_HOOK printBufferHook );
+
 #ifdef DEBUG
 #define DEBUG_PRINT_BUFFER( type, buffer, length )  DebugPrintBuffer( type, buffer, length )
 #else
@@ -69,6 +69,83 @@ TSS2_SYS_CONTEXT *InitSysContext(
     }
 }
 
+// Allocates a system context whose command and response buffers are
+// separate and sized by the caller, e.g. from GetTpmBufferSizes.  The
+// context and both buffers are one allocation, so TeardownSysContext
+// frees it.
+// Returns:
+//   ptr to system context, if successful
+//   NULL pointer, if not successful.
+
+TSS2_SYS_CONTEXT *InitSysContextWithBuffers(
+    UINT32 maxCommandSize,
+    UINT32 maxResponseSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion
+ )
+{
+    size_t contextSize = Tss2_Sys_GetContextSize( 1 );
+    TSS2_RC rval;
+    UINT8 *block;
+
+    block = malloc( contextSize + maxCommandSize + maxResponseSize );
+    if( block == 0 )
+        return 0;
+
+    rval = Tss2_Sys_InitializeWithBuffers( (TSS2_SYS_CONTEXT *)block, contextSize,
+            tctiContext, abiVersion,
+            block + contextSize, maxCommandSize,
+            block + contextSize + maxCommandSize, maxResponseSize );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        free( block );
+        return 0;
+    }
+
+    return (TSS2_SYS_CONTEXT *)block;
+}
+
+//
+// Gets TPM_PT_MAX_COMMAND_SIZE and TPM_PT_MAX_RESPONSE_SIZE; they are
+// adjacent fixed properties, so one GetCapability returns both.
+//
+TSS2_RC GetTpmBufferSizes(
+    TSS2_SYS_CONTEXT *sysContext,
+    UINT32 *maxCommandSize,
+    UINT32 *maxResponseSize
+ )
+{
+    TPMI_YES_NO moreData;
+    TPMS_CAPABILITY_DATA capabilityData;
+    TPML_TAGGED_TPM_PROPERTY *properties = &capabilityData.data.tpmProperties;
+    TSS2_RC rval;
+    UINT32 i;
+
+    if( maxCommandSize == 0 || maxResponseSize == 0 )
+        return TSS2_SYS_RC_BAD_REFERENCE;
+
+    *maxCommandSize = 0;
+    *maxResponseSize = 0;
+
+    rval = Tss2_Sys_GetCapability( sysContext, 0, TPM_CAP_TPM_PROPERTIES,
+            TPM_PT_MAX_COMMAND_SIZE, 2, &moreData, &capabilityData, 0 );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    for( i = 0; i < properties->count && i < MAX_TPM_PROPERTIES; i++ )
+    {
+        if( properties->tpmProperty[i].property == TPM_PT_MAX_COMMAND_SIZE )
+            *maxCommandSize = properties->tpmProperty[i].value;
+        else if( properties->tpmProperty[i].property == TPM_PT_MAX_RESPONSE_SIZE )
+            *maxResponseSize = properties->tpmProperty[i].value;
+    }
+
+    if( *maxCommandSize == 0 || *maxResponseSize == 0 )
+        return TSS2_SYS_RC_MALFORMED_RESPONSE;
+
+    return TSS2_RC_SUCCESS;
+}
+
 void TeardownSysContext( TSS2_SYS_CONTEXT **sysContext )
 {
     if( *sysContext != 0 )
@@ -79,3 +156,112 @@ void TeardownSysContext( TSS2_SYS_CONTEXT **sysContext )
         *sysContext = 0;
     }
 }
+
+//
+// Per-thread pool of initialized sys contexts.
+//
+// AcquireSysContext hands out a context bound to tctiContext, reusing one
+// released earlier on the same thread if there is one big enough; only the
+// per-command state is reset, so there is no malloc or Tss2_Sys_Initialize.
+// ReleaseSysContext puts a context back, or frees it if the pool is full.
+// Contexts from InitSysContext can be released into the pool too (those
+// from InitSysContextWithBuffers are just freed), but a
+// context from AcquireSysContext must not be passed to TeardownSysContext
+// unless it is never going to be released.
+//
+// Each thread should call DrainSysContextPool before it exits; contexts
+// left in its pool are otherwise lost.
+//
+
+#define SYS_CONTEXT_POOL_SIZE 8
+
+#ifdef _WIN32
+#define SYS_CONTEXT_POOL_THREAD __declspec( thread )
+#else
+#define SYS_CONTEXT_POOL_THREAD __thread
+#endif
+
+typedef struct {
+    TSS2_SYS_CONTEXT *sysContext;
+    TSS2_TCTI_CONTEXT *tctiContext;
+    size_t contextSize;
+} SYS_CONTEXT_POOL_ENTRY;
+
+static SYS_CONTEXT_POOL_THREAD SYS_CONTEXT_POOL_ENTRY sysContextPool[SYS_CONTEXT_POOL_SIZE];
+static SYS_CONTEXT_POOL_THREAD UINT32 sysContextPoolCount;
+
+// Size the context was created with; a pending authorization reservation
+// moves the command buffer and its size together, so the sum is constant.
+static size_t GetSysContextSize( TSS2_SYS_CONTEXT *sysContext )
+{
+    return (size_t)( SYS_CONTEXT->tpmInBuffPtr - (UINT8 *)SYS_CONTEXT ) + SYS_CONTEXT->maxCommandSize;
+}
+
+TSS2_SYS_CONTEXT *AcquireSysContext(
+    UINT16 maxCommandSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion
+ )
+{
+    size_t contextSize = Tss2_Sys_GetContextSize( maxCommandSize );
+    TSS2_SYS_CONTEXT *sysContext;
+    UINT32 i;
+
+    // Most recently released first; it is the most likely to be in cache.
+    for( i = sysContextPoolCount; i > 0; i-- )
+    {
+        if( sysContextPool[i - 1].tctiContext == tctiContext &&
+                sysContextPool[i - 1].contextSize >= contextSize )
+        {
+            sysContext = sysContextPool[i - 1].sysContext;
+            contextSize = sysContextPool[i - 1].contextSize;
+            sysContextPool[i - 1] = sysContextPool[--sysContextPoolCount];
+
+            // Reset the state Tss2_Sys_Initialize would; the buffer pointers
+            // too, in case a reservation was left behind.
+            InitSysContextPtrs( sysContext, contextSize );
+            InitSysContextFields( sysContext );
+            SYS_CONTEXT->previousStage = CMD_STAGE_INITIALIZE;
+
+            return sysContext;
+        }
+    }
+
+    return InitSysContext( maxCommandSize, tctiContext, abiVersion );
+}
+
+void ReleaseSysContext( TSS2_SYS_CONTEXT **sysContext )
+{
+    TSS2_SYS_CONTEXT *context = *sysContext;
+
+    if( context == 0 )
+        return;
+
+    // Caller-supplied buffers can't be recovered by InitSysContextPtrs.
+    if( ( (_TSS2_SYS_CONTEXT_BLOB *)context )->separateBuffers )
+    {
+        TeardownSysContext( sysContext );
+    }
+    else if( sysContextPoolCount < SYS_CONTEXT_POOL_SIZE )
+    {
+        sysContextPool[sysContextPoolCount].sysContext = context;
+        sysContextPool[sysContextPoolCount].tctiContext = ( (_TSS2_SYS_CONTEXT_BLOB *)context )->tctiContext;
+        sysContextPool[sysContextPoolCount].contextSize = GetSysContextSize( context );
+        sysContextPoolCount++;
+        *sysContext = 0;
+    }
+    else
+    {
+        TeardownSysContext( sysContext );
+    }
+}
+
+//
+// Frees every context in this thread's pool; call it before tearing down
+// a TCTI that pooled contexts may still point to.
+//
+void DrainSysContextPool()
+{
+    while( sysContextPoolCount > 0 )
+        TeardownSysContext( &sysContextPool[--sysContextPoolCount].sysContext );
+}
@@ -39,6 +39,29 @@ TSS2_SYS_CONTEXT *InitSysContext(
     TSS2_ABI_VERSION *abiVersion
  );
 
+TSS2_SYS_CONTEXT *InitSysContextWithBuffers(
+    UINT32 maxCommandSize,
+    UINT32 maxResponseSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion
+ );
+
+TSS2_RC GetTpmBufferSizes(
+    TSS2_SYS_CONTEXT *sysContext,
+    UINT32 *maxCommandSize,
+    UINT32 *maxResponseSize
+ );
+
 void TeardownSysContext( TSS2_SYS_CONTEXT **sysContext );
 
+TSS2_SYS_CONTEXT *AcquireSysContext(
+    UINT16 maxCommandSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion
+ );
+
+void ReleaseSysContext( TSS2_SYS_CONTEXT **sysContext );
+
+void DrainSysContextPool();
+
 #endif
@@ -689,6 +689,11 @@ TPM_RC Tss2_Sys_Unseal_Complete(
     TPM2B_SENSITIVE_DATA	*outData
     );
 
+TPM_RC Tss2_Sys_Unseal_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outData
+    );
+
 TPM_RC Tss2_Sys_Unseal(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	itemHandle,
@@ -840,6 +845,11 @@ TPM_RC Tss2_Sys_RSA_Decrypt_Complete(
     TPM2B_PUBLIC_KEY_RSA	*message
     );
 
+TPM_RC Tss2_Sys_RSA_Decrypt_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*message
+    );
+
 TPM_RC Tss2_Sys_RSA_Decrypt(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	keyHandle,
@@ -952,6 +962,12 @@ TPM_RC Tss2_Sys_EncryptDecrypt_Complete(
     TPM2B_IV	*ivOut
     );
 
+TPM_RC Tss2_Sys_EncryptDecrypt_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outData,
+    TSS2_SYS_BUFFER_VIEW	*ivOut
+    );
+
 TPM_RC Tss2_Sys_EncryptDecrypt(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	keyHandle,
@@ -978,6 +994,12 @@ TPM_RC Tss2_Sys_Hash_Complete(
     TPMT_TK_HASHCHECK	*validation
     );
 
+TPM_RC Tss2_Sys_Hash_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outHash,
+    TPMT_TK_HASHCHECK	*validation
+    );
+
 TPM_RC Tss2_Sys_Hash(
     TSS2_SYS_CONTEXT *sysContext,
     TSS2_SYS_CMD_AUTHS const *cmdAuthsArray,
@@ -1021,6 +1043,11 @@ TPM_RC Tss2_Sys_GetRandom_Complete(
     TPM2B_DIGEST	*randomBytes
     );
 
+TPM_RC Tss2_Sys_GetRandom_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*randomBytes
+    );
+
 TPM_RC Tss2_Sys_GetRandom(
     TSS2_SYS_CONTEXT *sysContext,
     TSS2_SYS_CMD_AUTHS const *cmdAuthsArray,
@@ -1110,6 +1137,12 @@ TPM_RC Tss2_Sys_SequenceComplete_Complete(
     TPMT_TK_HASHCHECK	*validation
     );
 
+TPM_RC Tss2_Sys_SequenceComplete_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*result,
+    TPMT_TK_HASHCHECK	*validation
+    );
+
 TPM_RC Tss2_Sys_SequenceComplete(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	sequenceHandle,
@@ -2119,6 +2152,11 @@ TPM_RC Tss2_Sys_ContextSave_Complete(
     TPMS_CONTEXT	*context
     );
 
+TPM_RC Tss2_Sys_ContextSave_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_CONTEXT_VIEW	*context
+    );
+
 TPM_RC Tss2_Sys_ContextSave(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_CONTEXT	saveHandle,
@@ -2412,6 +2450,11 @@ TPM_RC Tss2_Sys_NV_Read_Complete(
     TPM2B_MAX_NV_BUFFER	*data
     );
 
+TPM_RC Tss2_Sys_NV_Read_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*data
+    );
+
 TPM_RC Tss2_Sys_NV_Read(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_RH_NV_AUTH	authHandle,
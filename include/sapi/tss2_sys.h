@@ -67,6 +67,28 @@ typedef struct {
     TPMS_AUTH_RESPONSE **rspAuths;
 } TSS2_SYS_RSP_AUTHS;
 
+//
+// Borrowed view of a sized (TPM2B) response parameter.  buffer points
+// directly into the response buffer held by the SAPI context; it is only
+// valid until the next _Prepare call (or any other call that reuses the
+// context's buffers) on that context.  The caller must not free it.
+//
+typedef struct {
+    uint16_t size;
+    const uint8_t *buffer;
+} TSS2_SYS_BUFFER_VIEW;
+
+//
+// Borrowed view of a TPMS_CONTEXT; contextBlob follows the same rules as
+// TSS2_SYS_BUFFER_VIEW.
+//
+typedef struct {
+    UINT64 sequence;
+    TPMI_DH_CONTEXT savedHandle;
+    TPMI_RH_HIERARCHY hierarchy;
+    TSS2_SYS_BUFFER_VIEW contextBlob;
+} TSS2_SYS_CONTEXT_VIEW;
+
 
 //
 // SAPI data types
@@ -92,6 +114,27 @@ TSS2_RC Tss2_Sys_Initialize(
     TSS2_ABI_VERSION *abiVersion
     );
 
+//
+// Optional: like Tss2_Sys_Initialize, but commands are built in cmdBuffer
+// and responses received into rspBuffer, both owned by the caller and
+// typically sized from TPM_PT_MAX_COMMAND_SIZE / TPM_PT_MAX_RESPONSE_SIZE.
+// contextSize need only be Tss2_Sys_GetContextSize( 1 ).  The buffers must
+// not overlap and must outlive the context.  Because the response does not
+// overwrite the command, a command that fails with a TPM warning such as
+// TPM_RC_RETRY can be sent again with Tss2_Sys_ExecuteAsync or
+// Tss2_Sys_Execute without calling _Prepare again.
+//
+TSS2_RC Tss2_Sys_InitializeWithBuffers(
+    TSS2_SYS_CONTEXT *sysContext,
+    size_t contextSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion,
+    uint8_t *cmdBuffer,
+    size_t cmdBufferSize,
+    uint8_t *rspBuffer,
+    size_t rspBufferSize
+    );
+
 TSS2_RC Tss2_Sys_Finalize(
     TSS2_SYS_CONTEXT *sysContext
     );
@@ -121,6 +164,18 @@ TPM_RC Tss2_Sys_GetCpBuffer(
     size_t *cpBufferUsedSize,
     const uint8_t **cpBuffer);
 
+//
+// Optional: declare, before the next _Prepare (or one-call function), the
+// authorization area that will be passed to Tss2_Sys_SetCmdAuths.  Only the
+// session count and the nonce/hmac sizes are used.  _Prepare then leaves
+// room for the area so that SetCmdAuths does not have to move the already
+// marshalled parameters.  Applies to the next command only.
+//
+TSS2_RC Tss2_Sys_ReserveCmdAuths(
+    TSS2_SYS_CONTEXT *sysContext,
+    const TSS2_SYS_CMD_AUTHS *cmdAuthsArray
+    );
+
 TPM_RC Tss2_Sys_SetCmdAuths(
     TSS2_SYS_CONTEXT * sysContext,
     const TSS2_SYS_CMD_AUTHS *cmdAuthsArray
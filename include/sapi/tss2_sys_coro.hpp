@@ -0,0 +1,362 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TSS2_SYS_CORO_HPP
+#define TSS2_SYS_CORO_HPP
+
+//
+// C++20 coroutine layer over the SAPI _Prepare/_Complete pairs.
+//
+//     tss2::PollScheduler scheduler;
+//     tss2::Tpm tpm( sysContext, scheduler );
+//
+//     auto result = co_await tpm.Sign( keyHandle, &digest, &scheme, &ticket,
+//                                      &cmdAuths, &rspAuths );
+//     if( result.rc == TSS2_RC_SUCCESS )
+//         use( result.signature );
+//
+// co_await prepares the command, sends it with Tss2_Sys_ExecuteAsync and,
+// unless the response is already there, hands the TCTI poll handles to the
+// scheduler and suspends.  The coroutine resumes once the response has been
+// received; the response parameters are returned by value in a Result, so
+// they live in the awaiting coroutine's frame.  Nothing is allocated per
+// command.  Errors are the TSS2_RC the one-call function would have returned.
+//
+// A TCTI without poll handles (getPollHandles not implemented) is waited for
+// with a blocking Tss2_Sys_ExecuteFinish instead, as is one whose handles the
+// scheduler cannot take.
+//
+// Only one command can be in flight per TSS2_SYS_CONTEXT: await each call
+// before starting the next on the same Tpm.  The command methods are
+// generated into tss2_sys_coro_commands.hpp by script/gen-sys-coro.py.
+//
+
+#include <coroutine>
+#include <exception>
+#include <string.h>
+#include <sapi/tpm20.h>
+
+#ifndef TSS2_CORO_MAX_POLL_HANDLES
+#define TSS2_CORO_MAX_POLL_HANDLES  4
+#endif
+#ifndef TSS2_CORO_MAX_WATCHES
+#define TSS2_CORO_MAX_WATCHES       32
+#endif
+
+// The response header check the one-call functions of commands without
+// response parameters end with; see CommonOneCallForNoResponseCmds.
+extern "C" TSS2_RC CommonComplete( TSS2_SYS_CONTEXT *sysContext );
+
+namespace tss2 {
+
+//
+// What co_await on a command returns: the response parameters, valid only
+// when rc is TSS2_RC_SUCCESS.
+//
+template< typename Out >
+struct Result : Out
+{
+    TSS2_RC rc;
+
+    bool Ok() const { return rc == TSS2_RC_SUCCESS; }
+
+    // Which layer reported the error: TSS2_TPM_ERROR_LEVEL, TSS2_SYS_ERROR_LEVEL,
+    // TSS2_TCTI_ERROR_LEVEL, ...
+    TSS2_RC Level() const { return rc & TSS2_ERROR_LEVEL_MASK; }
+};
+
+// Response parameters of a command that has none.
+struct NoOutput
+{
+    void Init() {}
+};
+
+class PendingCommand
+{
+public:
+    // Called by the scheduler once one of the handles the command is
+    // waiting on is readable.
+    virtual void Readable() = 0;
+
+protected:
+    ~PendingCommand() {}
+};
+
+class Scheduler
+{
+public:
+    virtual ~Scheduler() {}
+
+    // Calls command->Readable() once, when any of the handles becomes
+    // readable; with no handles, on the next pass of the event loop.  The
+    // handles are copied.  Fails if the scheduler has no room for them.
+    virtual TSS2_RC Watch( const TSS2_TCTI_POLL_HANDLE *handles, size_t count,
+                           PendingCommand *command ) = 0;
+};
+
+#if defined(__linux__) || defined(__unix__)
+
+//
+// A poll() loop for callers that don't have an event loop of their own.
+//
+class PollScheduler : public Scheduler
+{
+public:
+    PollScheduler() : watchCount( 0 ) {}
+
+    TSS2_RC Watch( const TSS2_TCTI_POLL_HANDLE *handles, size_t count,
+                   PendingCommand *command ) override
+    {
+        if( watchCount == TSS2_CORO_MAX_WATCHES || count > TSS2_CORO_MAX_POLL_HANDLES )
+            return TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+
+        WATCH &watch = watches[watchCount++];
+        memcpy( watch.handles, handles, count * sizeof( *handles ) );
+        watch.count = count;
+        watch.command = command;
+
+        return TSS2_RC_SUCCESS;
+    }
+
+    bool Empty() const { return watchCount == 0; }
+
+    // Waits up to timeoutMs (-1 for ever) for a watched handle and resumes
+    // every command that is ready.  Returns the number resumed, or -1 if
+    // poll() failed.
+    int RunOnce( int timeoutMs )
+    {
+        struct pollfd fds[TSS2_CORO_MAX_WATCHES * TSS2_CORO_MAX_POLL_HANDLES];
+        PendingCommand *ready[TSS2_CORO_MAX_WATCHES];
+        size_t nfds = 0, readyCount = 0, i, j, kept = 0;
+
+        for( i = 0; i < watchCount; i++ )
+        {
+            if( watches[i].count == 0 )
+                timeoutMs = 0;
+            memcpy( &fds[nfds], watches[i].handles, watches[i].count * sizeof( fds[0] ) );
+            nfds += watches[i].count;
+        }
+
+        if( poll( fds, nfds, timeoutMs ) < 0 )
+            return -1;
+
+        // Take the ready commands off the list before resuming any of
+        // them; a resumed coroutine may start, and watch, its next command.
+        for( i = 0, nfds = 0; i < watchCount; i++ )
+        {
+            bool readable = watches[i].count == 0;
+
+            for( j = 0; j < watches[i].count; j++ )
+                if( fds[nfds + j].revents != 0 )
+                    readable = true;
+            nfds += watches[i].count;
+
+            if( readable )
+                ready[readyCount++] = watches[i].command;
+            else
+                watches[kept++] = watches[i];
+        }
+        watchCount = kept;
+
+        for( i = 0; i < readyCount; i++ )
+            ready[i]->Readable();
+
+        return (int)readyCount;
+    }
+
+    // Runs until no command is waiting.
+    void Run()
+    {
+        while( !Empty() && RunOnce( -1 ) >= 0 )
+            ;
+    }
+
+private:
+    struct WATCH
+    {
+        TSS2_TCTI_POLL_HANDLE handles[TSS2_CORO_MAX_POLL_HANDLES];
+        size_t count;
+        PendingCommand *command;
+    };
+
+    WATCH watches[TSS2_CORO_MAX_WATCHES];
+    size_t watchCount;
+};
+
+#endif
+
+//
+// The awaitable returned by every command method.  It is a temporary in the
+// awaiting coroutine's frame for as long as the command is in flight.
+//
+template< typename Out >
+class Command : public PendingCommand
+{
+public:
+    typedef TSS2_RC (*COMPLETE_FUNCTION)( TSS2_SYS_CONTEXT *sysContext, Out *out );
+
+    Command( TSS2_SYS_CONTEXT *sysContext, Scheduler &scheduler, TSS2_RC prepareRval,
+             const TSS2_SYS_CMD_AUTHS *cmdAuths, TSS2_SYS_RSP_AUTHS *rspAuths,
+             COMPLETE_FUNCTION complete ) :
+        sysContext( sysContext ), scheduler( scheduler ), rval( prepareRval ),
+        cmdAuths( cmdAuths ), rspAuths( rspAuths ), complete( complete )
+    {
+    }
+
+    Command( const Command & ) = delete;
+    Command &operator=( const Command & ) = delete;
+
+    bool await_ready()
+    {
+        if( rval == TSS2_RC_SUCCESS && cmdAuths != 0 )
+            rval = Tss2_Sys_SetCmdAuths( sysContext, cmdAuths );
+        if( rval == TSS2_RC_SUCCESS )
+            rval = Tss2_Sys_ExecuteAsync( sysContext );
+        if( rval != TSS2_RC_SUCCESS )
+            return true;
+
+        rval = Tss2_Sys_ExecuteFinish( sysContext, TSS2_TCTI_TIMEOUT_NONE );
+        return rval != TSS2_TCTI_RC_TRY_AGAIN;
+    }
+
+    bool await_suspend( std::coroutine_handle<> awaiting )
+    {
+        waiter = awaiting;
+        return Wait();
+    }
+
+    Result< Out > await_resume()
+    {
+        Result< Out > result = {};
+
+        result.Init();
+        if( rval == TSS2_RC_SUCCESS )
+            rval = complete != 0 ? complete( sysContext, &result ) : CommonComplete( sysContext );
+        if( rval == TSS2_RC_SUCCESS && cmdAuths != 0 && rspAuths != 0 )
+            rval = Tss2_Sys_GetRspAuths( sysContext, rspAuths );
+        result.rc = rval;
+
+        return result;
+    }
+
+    void Readable() override
+    {
+        rval = Tss2_Sys_ExecuteFinish( sysContext, TSS2_TCTI_TIMEOUT_NONE );
+        if( rval == TSS2_TCTI_RC_TRY_AGAIN && Wait() )
+            return;
+        waiter.resume();
+    }
+
+private:
+    // Asks the scheduler for a call back when the response can be read.
+    // If that isn't possible, receives it blocking and returns false.
+    bool Wait()
+    {
+        TSS2_TCTI_POLL_HANDLE handles[TSS2_CORO_MAX_POLL_HANDLES];
+        size_t count = TSS2_CORO_MAX_POLL_HANDLES;
+        TSS2_TCTI_CONTEXT *tctiContext = 0;
+        TSS2_RC rc;
+
+        rc = Tss2_Sys_GetTctiContext( sysContext, &tctiContext );
+        if( rc == TSS2_RC_SUCCESS )
+            rc = tss2_tcti_get_poll_handles( tctiContext, handles, &count );
+        if( rc == TSS2_RC_SUCCESS )
+            rc = scheduler.Watch( handles, count, this );
+        if( rc == TSS2_RC_SUCCESS )
+            return true;
+
+        rval = Tss2_Sys_ExecuteFinish( sysContext, TSS2_TCTI_TIMEOUT_BLOCK );
+        return false;
+    }
+
+    TSS2_SYS_CONTEXT *sysContext;
+    Scheduler &scheduler;
+    TSS2_RC rval;
+    const TSS2_SYS_CMD_AUTHS *cmdAuths;
+    TSS2_SYS_RSP_AUTHS *rspAuths;
+    COMPLETE_FUNCTION complete;
+    std::coroutine_handle<> waiter;
+};
+
+class TpmBase
+{
+public:
+    TpmBase( TSS2_SYS_CONTEXT *sysContext, Scheduler &scheduler ) :
+        sysContext( sysContext ), scheduler( scheduler )
+    {
+    }
+
+    TSS2_SYS_CONTEXT *SysContext() const { return sysContext; }
+
+protected:
+    TSS2_SYS_CONTEXT *sysContext;
+    Scheduler &scheduler;
+};
+
+//
+// A minimal coroutine type for callers without one of their own: it starts
+// at once, runs to its first suspension and is resumed by the scheduler.
+// Destroying a Task that is still waiting on a command is not allowed.
+//
+class Task
+{
+public:
+    struct promise_type
+    {
+        Task get_return_object()
+        {
+            return Task( std::coroutine_handle< promise_type >::from_promise( *this ) );
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task( Task &&other ) : handle( other.handle ) { other.handle = 0; }
+    Task( const Task & ) = delete;
+    Task &operator=( const Task & ) = delete;
+
+    ~Task()
+    {
+        if( handle )
+            handle.destroy();
+    }
+
+    bool Done() const { return !handle || handle.done(); }
+
+private:
+    explicit Task( std::coroutine_handle< promise_type > handle ) : handle( handle ) {}
+
+    std::coroutine_handle< promise_type > handle;
+};
+
+} // namespace tss2
+
+#include <sapi/tss2_sys_coro_commands.hpp>
+
+#endif
@@ -0,0 +1,2225 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+// Generated by script/gen-sys-coro.py from sys_api_part3.h; do not edit.
+// Included by tss2_sys_coro.hpp.
+
+#ifndef TSS2_SYS_CORO_COMMANDS_HPP
+#define TSS2_SYS_CORO_COMMANDS_HPP
+
+namespace tss2 {
+
+struct ActivateCredentialOut
+{
+    TPM2B_DIGEST certInfo;
+
+    void Init()
+    {
+        certInfo.t.size = sizeof( certInfo.t.buffer );
+    }
+};
+
+struct CertifyOut
+{
+    TPM2B_ATTEST certifyInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        certifyInfo.t.size = sizeof( certifyInfo.t.attestationData );
+    }
+};
+
+struct CertifyCreationOut
+{
+    TPM2B_ATTEST certifyInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        certifyInfo.t.size = sizeof( certifyInfo.t.attestationData );
+    }
+};
+
+struct CommitOut
+{
+    TPM2B_ECC_POINT K;
+    TPM2B_ECC_POINT L;
+    TPM2B_ECC_POINT E;
+    UINT16 counter;
+
+    void Init()
+    {
+    }
+};
+
+struct ContextLoadOut
+{
+    TPMI_DH_CONTEXT loadedHandle;
+
+    void Init()
+    {
+    }
+};
+
+struct ContextSaveOut
+{
+    TPMS_CONTEXT context;
+
+    void Init()
+    {
+    }
+};
+
+struct CreateOut
+{
+    TPM2B_PRIVATE outPrivate;
+    TPM2B_PUBLIC outPublic;
+    TPM2B_CREATION_DATA creationData;
+    TPM2B_DIGEST creationHash;
+    TPMT_TK_CREATION creationTicket;
+
+    void Init()
+    {
+        outPrivate.t.size = sizeof( outPrivate.t.buffer );
+        creationHash.t.size = sizeof( creationHash.t.buffer );
+    }
+};
+
+struct CreatePrimaryOut
+{
+    TPM_HANDLE objectHandle;
+    TPM2B_PUBLIC outPublic;
+    TPM2B_CREATION_DATA creationData;
+    TPM2B_DIGEST creationHash;
+    TPMT_TK_CREATION creationTicket;
+    TPM2B_NAME name;
+
+    void Init()
+    {
+        creationHash.t.size = sizeof( creationHash.t.buffer );
+        name.t.size = sizeof( name.t.name );
+    }
+};
+
+struct DuplicateOut
+{
+    TPM2B_DATA encryptionKeyOut;
+    TPM2B_PRIVATE duplicate;
+    TPM2B_ENCRYPTED_SECRET outSymSeed;
+
+    void Init()
+    {
+        encryptionKeyOut.t.size = sizeof( encryptionKeyOut.t.buffer );
+        duplicate.t.size = sizeof( duplicate.t.buffer );
+        outSymSeed.t.size = sizeof( outSymSeed.t.secret );
+    }
+};
+
+struct ECC_ParametersOut
+{
+    TPMS_ALGORITHM_DETAIL_ECC parameters;
+
+    void Init()
+    {
+    }
+};
+
+struct ECDH_KeyGenOut
+{
+    TPM2B_ECC_POINT zPoint;
+    TPM2B_ECC_POINT pubPoint;
+
+    void Init()
+    {
+    }
+};
+
+struct ECDH_ZGenOut
+{
+    TPM2B_ECC_POINT outPoint;
+
+    void Init()
+    {
+    }
+};
+
+struct EC_EphemeralOut
+{
+    TPM2B_ECC_POINT Q;
+    UINT16 counter;
+
+    void Init()
+    {
+    }
+};
+
+struct EncryptDecryptOut
+{
+    TPM2B_MAX_BUFFER outData;
+    TPM2B_IV ivOut;
+
+    void Init()
+    {
+        outData.t.size = sizeof( outData.t.buffer );
+        ivOut.t.size = sizeof( ivOut.t.buffer );
+    }
+};
+
+struct EventSequenceCompleteOut
+{
+    TPML_DIGEST_VALUES results;
+
+    void Init()
+    {
+    }
+};
+
+struct FieldUpgradeDataOut
+{
+    TPMT_HA nextDigest;
+    TPMT_HA firstDigest;
+
+    void Init()
+    {
+    }
+};
+
+struct FirmwareReadOut
+{
+    TPM2B_MAX_BUFFER fuData;
+
+    void Init()
+    {
+        fuData.t.size = sizeof( fuData.t.buffer );
+    }
+};
+
+struct GetCapabilityOut
+{
+    TPMI_YES_NO moreData;
+    TPMS_CAPABILITY_DATA capabilityData;
+
+    void Init()
+    {
+    }
+};
+
+struct GetCommandAuditDigestOut
+{
+    TPM2B_ATTEST auditInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        auditInfo.t.size = sizeof( auditInfo.t.attestationData );
+    }
+};
+
+struct GetRandomOut
+{
+    TPM2B_DIGEST randomBytes;
+
+    void Init()
+    {
+        randomBytes.t.size = sizeof( randomBytes.t.buffer );
+    }
+};
+
+struct GetSessionAuditDigestOut
+{
+    TPM2B_ATTEST auditInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        auditInfo.t.size = sizeof( auditInfo.t.attestationData );
+    }
+};
+
+struct GetTestResultOut
+{
+    TPM2B_MAX_BUFFER outData;
+    TPM_RC testResult;
+
+    void Init()
+    {
+        outData.t.size = sizeof( outData.t.buffer );
+    }
+};
+
+struct GetTimeOut
+{
+    TPM2B_ATTEST timeInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        timeInfo.t.size = sizeof( timeInfo.t.attestationData );
+    }
+};
+
+struct HMACOut
+{
+    TPM2B_DIGEST outHMAC;
+
+    void Init()
+    {
+        outHMAC.t.size = sizeof( outHMAC.t.buffer );
+    }
+};
+
+struct HMAC_StartOut
+{
+    TPMI_DH_OBJECT sequenceHandle;
+
+    void Init()
+    {
+    }
+};
+
+struct HashOut
+{
+    TPM2B_DIGEST outHash;
+    TPMT_TK_HASHCHECK validation;
+
+    void Init()
+    {
+        outHash.t.size = sizeof( outHash.t.buffer );
+    }
+};
+
+struct HashSequenceStartOut
+{
+    TPMI_DH_OBJECT sequenceHandle;
+
+    void Init()
+    {
+    }
+};
+
+struct ImportOut
+{
+    TPM2B_PRIVATE outPrivate;
+
+    void Init()
+    {
+        outPrivate.t.size = sizeof( outPrivate.t.buffer );
+    }
+};
+
+struct IncrementalSelfTestOut
+{
+    TPML_ALG toDoList;
+
+    void Init()
+    {
+    }
+};
+
+struct LoadOut
+{
+    TPM_HANDLE objectHandle;
+    TPM2B_NAME name;
+
+    void Init()
+    {
+        name.t.size = sizeof( name.t.name );
+    }
+};
+
+struct LoadExternalOut
+{
+    TPM_HANDLE objectHandle;
+    TPM2B_NAME name;
+
+    void Init()
+    {
+        name.t.size = sizeof( name.t.name );
+    }
+};
+
+struct MakeCredentialOut
+{
+    TPM2B_ID_OBJECT credentialBlob;
+    TPM2B_ENCRYPTED_SECRET secret;
+
+    void Init()
+    {
+        credentialBlob.t.size = sizeof( credentialBlob.t.credential );
+        secret.t.size = sizeof( secret.t.secret );
+    }
+};
+
+struct NV_CertifyOut
+{
+    TPM2B_ATTEST certifyInfo;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        certifyInfo.t.size = sizeof( certifyInfo.t.attestationData );
+    }
+};
+
+struct NV_ReadOut
+{
+    TPM2B_MAX_NV_BUFFER data;
+
+    void Init()
+    {
+        data.t.size = sizeof( data.t.buffer );
+    }
+};
+
+struct NV_ReadPublicOut
+{
+    TPM2B_NV_PUBLIC nvPublic;
+    TPM2B_NAME nvName;
+
+    void Init()
+    {
+        nvName.t.size = sizeof( nvName.t.name );
+    }
+};
+
+struct ObjectChangeAuthOut
+{
+    TPM2B_PRIVATE outPrivate;
+
+    void Init()
+    {
+        outPrivate.t.size = sizeof( outPrivate.t.buffer );
+    }
+};
+
+struct PCR_AllocateOut
+{
+    TPMI_YES_NO allocationSuccess;
+    UINT32 maxPCR;
+    UINT32 sizeNeeded;
+    UINT32 sizeAvailable;
+
+    void Init()
+    {
+    }
+};
+
+struct PCR_EventOut
+{
+    TPML_DIGEST_VALUES digests;
+
+    void Init()
+    {
+    }
+};
+
+struct PCR_ReadOut
+{
+    UINT32 pcrUpdateCounter;
+    TPML_PCR_SELECTION pcrSelectionOut;
+    TPML_DIGEST pcrValues;
+
+    void Init()
+    {
+    }
+};
+
+struct PolicyGetDigestOut
+{
+    TPM2B_DIGEST policyDigest;
+
+    void Init()
+    {
+        policyDigest.t.size = sizeof( policyDigest.t.buffer );
+    }
+};
+
+struct PolicySecretOut
+{
+    TPM2B_TIMEOUT timeout;
+    TPMT_TK_AUTH policyTicket;
+
+    void Init()
+    {
+    }
+};
+
+struct PolicySignedOut
+{
+    TPM2B_TIMEOUT timeout;
+    TPMT_TK_AUTH policyTicket;
+
+    void Init()
+    {
+    }
+};
+
+struct QuoteOut
+{
+    TPM2B_ATTEST quoted;
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+        quoted.t.size = sizeof( quoted.t.attestationData );
+    }
+};
+
+struct RSA_DecryptOut
+{
+    TPM2B_PUBLIC_KEY_RSA message;
+
+    void Init()
+    {
+        message.t.size = sizeof( message.t.buffer );
+    }
+};
+
+struct RSA_EncryptOut
+{
+    TPM2B_PUBLIC_KEY_RSA outData;
+
+    void Init()
+    {
+        outData.t.size = sizeof( outData.t.buffer );
+    }
+};
+
+struct ReadClockOut
+{
+    TPMS_TIME_INFO currentTime;
+
+    void Init()
+    {
+    }
+};
+
+struct ReadPublicOut
+{
+    TPM2B_PUBLIC outPublic;
+    TPM2B_NAME name;
+    TPM2B_NAME qualifiedName;
+
+    void Init()
+    {
+        name.t.size = sizeof( name.t.name );
+        qualifiedName.t.size = sizeof( qualifiedName.t.name );
+    }
+};
+
+struct RewrapOut
+{
+    TPM2B_PRIVATE outDuplicate;
+    TPM2B_ENCRYPTED_SECRET outSymSeed;
+
+    void Init()
+    {
+        outDuplicate.t.size = sizeof( outDuplicate.t.buffer );
+        outSymSeed.t.size = sizeof( outSymSeed.t.secret );
+    }
+};
+
+struct SequenceCompleteOut
+{
+    TPM2B_DIGEST result;
+    TPMT_TK_HASHCHECK validation;
+
+    void Init()
+    {
+        result.t.size = sizeof( result.t.buffer );
+    }
+};
+
+struct SignOut
+{
+    TPMT_SIGNATURE signature;
+
+    void Init()
+    {
+    }
+};
+
+struct StartAuthSessionOut
+{
+    TPMI_SH_AUTH_SESSION sessionHandle;
+    TPM2B_NONCE nonceTPM;
+
+    void Init()
+    {
+    }
+};
+
+struct UnsealOut
+{
+    TPM2B_SENSITIVE_DATA outData;
+
+    void Init()
+    {
+        outData.t.size = sizeof( outData.t.buffer );
+    }
+};
+
+struct Vendor_TCG_TestOut
+{
+    TPM2B_DATA outputData;
+
+    void Init()
+    {
+        outputData.t.size = sizeof( outputData.t.buffer );
+    }
+};
+
+struct VerifySignatureOut
+{
+    TPMT_TK_VERIFIED validation;
+
+    void Init()
+    {
+    }
+};
+
+struct ZGen_2PhaseOut
+{
+    TPM2B_ECC_POINT outZ1;
+    TPM2B_ECC_POINT outZ2;
+
+    void Init()
+    {
+    }
+};
+
+class Tpm : public TpmBase
+{
+public:
+    Tpm( TSS2_SYS_CONTEXT *sysContext, Scheduler &scheduler ) :
+        TpmBase( sysContext, scheduler )
+    {
+    }
+
+    Command< ActivateCredentialOut > ActivateCredential(
+        TPMI_DH_OBJECT activateHandle,
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_ID_OBJECT *credentialBlob,
+        TPM2B_ENCRYPTED_SECRET *secret,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ActivateCredentialOut >( sysContext, scheduler,
+            Tss2_Sys_ActivateCredential_Prepare( sysContext, activateHandle, keyHandle, credentialBlob, secret ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ActivateCredentialOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ActivateCredential_Complete( sysContext, &out->certInfo );
+            } );
+    }
+
+    Command< CertifyOut > Certify(
+        TPMI_DH_OBJECT objectHandle,
+        TPMI_DH_OBJECT signHandle,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< CertifyOut >( sysContext, scheduler,
+            Tss2_Sys_Certify_Prepare( sysContext, objectHandle, signHandle, qualifyingData, inScheme ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, CertifyOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Certify_Complete( sysContext, &out->certifyInfo, &out->signature );
+            } );
+    }
+
+    Command< CertifyCreationOut > CertifyCreation(
+        TPMI_DH_OBJECT signHandle,
+        TPMI_DH_OBJECT objectHandle,
+        TPM2B_DATA *qualifyingData,
+        TPM2B_DIGEST *creationHash,
+        TPMT_SIG_SCHEME *inScheme,
+        TPMT_TK_CREATION *creationTicket,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< CertifyCreationOut >( sysContext, scheduler,
+            Tss2_Sys_CertifyCreation_Prepare( sysContext, signHandle, objectHandle, qualifyingData, creationHash, inScheme, creationTicket ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, CertifyCreationOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_CertifyCreation_Complete( sysContext, &out->certifyInfo, &out->signature );
+            } );
+    }
+
+    Command< NoOutput > ChangeEPS(
+        TPMI_RH_PLATFORM authHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_ChangeEPS_Prepare( sysContext, authHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > ChangePPS(
+        TPMI_RH_PLATFORM authHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_ChangePPS_Prepare( sysContext, authHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > Clear(
+        TPMI_RH_CLEAR authHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_Clear_Prepare( sysContext, authHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > ClearControl(
+        TPMI_RH_CLEAR auth,
+        TPMI_YES_NO disable,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_ClearControl_Prepare( sysContext, auth, disable ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > ClockRateAdjust(
+        TPMI_RH_PROVISION auth,
+        TPM_CLOCK_ADJUST rateAdjust,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_ClockRateAdjust_Prepare( sysContext, auth, rateAdjust ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > ClockSet(
+        TPMI_RH_PROVISION auth,
+        UINT64 newTime,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_ClockSet_Prepare( sysContext, auth, newTime ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< CommitOut > Commit(
+        TPMI_DH_OBJECT signHandle,
+        TPM2B_ECC_POINT *P1,
+        TPM2B_SENSITIVE_DATA *s2,
+        TPM2B_ECC_PARAMETER *y2,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< CommitOut >( sysContext, scheduler,
+            Tss2_Sys_Commit_Prepare( sysContext, signHandle, P1, s2, y2 ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, CommitOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Commit_Complete( sysContext, &out->K, &out->L, &out->E, &out->counter );
+            } );
+    }
+
+    Command< ContextLoadOut > ContextLoad(
+        TPMS_CONTEXT *context )
+    {
+        return Command< ContextLoadOut >( sysContext, scheduler,
+            Tss2_Sys_ContextLoad_Prepare( sysContext, context ),
+            0, 0,
+            []( TSS2_SYS_CONTEXT *sysContext, ContextLoadOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ContextLoad_Complete( sysContext, &out->loadedHandle );
+            } );
+    }
+
+    Command< ContextSaveOut > ContextSave(
+        TPMI_DH_CONTEXT saveHandle )
+    {
+        return Command< ContextSaveOut >( sysContext, scheduler,
+            Tss2_Sys_ContextSave_Prepare( sysContext, saveHandle ),
+            0, 0,
+            []( TSS2_SYS_CONTEXT *sysContext, ContextSaveOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ContextSave_Complete( sysContext, &out->context );
+            } );
+    }
+
+    Command< CreateOut > Create(
+        TPMI_DH_OBJECT parentHandle,
+        TPM2B_SENSITIVE_CREATE *inSensitive,
+        TPM2B_PUBLIC *inPublic,
+        TPM2B_DATA *outsideInfo,
+        TPML_PCR_SELECTION *creationPCR,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< CreateOut >( sysContext, scheduler,
+            Tss2_Sys_Create_Prepare( sysContext, parentHandle, inSensitive, inPublic, outsideInfo, creationPCR ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, CreateOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Create_Complete( sysContext, &out->outPrivate, &out->outPublic, &out->creationData, &out->creationHash, &out->creationTicket );
+            } );
+    }
+
+    Command< CreatePrimaryOut > CreatePrimary(
+        TPMI_RH_HIERARCHY primaryHandle,
+        TPM2B_SENSITIVE_CREATE *inSensitive,
+        TPM2B_PUBLIC *inPublic,
+        TPM2B_DATA *outsideInfo,
+        TPML_PCR_SELECTION *creationPCR,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< CreatePrimaryOut >( sysContext, scheduler,
+            Tss2_Sys_CreatePrimary_Prepare( sysContext, primaryHandle, inSensitive, inPublic, outsideInfo, creationPCR ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, CreatePrimaryOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_CreatePrimary_Complete( sysContext, &out->objectHandle, &out->outPublic, &out->creationData, &out->creationHash, &out->creationTicket, &out->name );
+            } );
+    }
+
+    Command< NoOutput > DictionaryAttackLockReset(
+        TPMI_RH_LOCKOUT lockHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_DictionaryAttackLockReset_Prepare( sysContext, lockHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > DictionaryAttackParameters(
+        TPMI_RH_LOCKOUT lockHandle,
+        UINT32 newMaxTries,
+        UINT32 newRecoveryTime,
+        UINT32 lockoutRecovery,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_DictionaryAttackParameters_Prepare( sysContext, lockHandle, newMaxTries, newRecoveryTime, lockoutRecovery ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< DuplicateOut > Duplicate(
+        TPMI_DH_OBJECT objectHandle,
+        TPMI_DH_OBJECT newParentHandle,
+        TPM2B_DATA *encryptionKeyIn,
+        TPMT_SYM_DEF_OBJECT *symmetricAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< DuplicateOut >( sysContext, scheduler,
+            Tss2_Sys_Duplicate_Prepare( sysContext, objectHandle, newParentHandle, encryptionKeyIn, symmetricAlg ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, DuplicateOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Duplicate_Complete( sysContext, &out->encryptionKeyOut, &out->duplicate, &out->outSymSeed );
+            } );
+    }
+
+    Command< ECC_ParametersOut > ECC_Parameters(
+        TPMI_ECC_CURVE curveID,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ECC_ParametersOut >( sysContext, scheduler,
+            Tss2_Sys_ECC_Parameters_Prepare( sysContext, curveID ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ECC_ParametersOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ECC_Parameters_Complete( sysContext, &out->parameters );
+            } );
+    }
+
+    Command< ECDH_KeyGenOut > ECDH_KeyGen(
+        TPMI_DH_OBJECT keyHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ECDH_KeyGenOut >( sysContext, scheduler,
+            Tss2_Sys_ECDH_KeyGen_Prepare( sysContext, keyHandle ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ECDH_KeyGenOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ECDH_KeyGen_Complete( sysContext, &out->zPoint, &out->pubPoint );
+            } );
+    }
+
+    Command< ECDH_ZGenOut > ECDH_ZGen(
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_ECC_POINT *inPoint,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ECDH_ZGenOut >( sysContext, scheduler,
+            Tss2_Sys_ECDH_ZGen_Prepare( sysContext, keyHandle, inPoint ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ECDH_ZGenOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ECDH_ZGen_Complete( sysContext, &out->outPoint );
+            } );
+    }
+
+    Command< EC_EphemeralOut > EC_Ephemeral(
+        TPMI_ECC_CURVE curveID,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< EC_EphemeralOut >( sysContext, scheduler,
+            Tss2_Sys_EC_Ephemeral_Prepare( sysContext, curveID ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, EC_EphemeralOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_EC_Ephemeral_Complete( sysContext, &out->Q, &out->counter );
+            } );
+    }
+
+    Command< EncryptDecryptOut > EncryptDecrypt(
+        TPMI_DH_OBJECT keyHandle,
+        TPMI_YES_NO decrypt,
+        TPMI_ALG_SYM_MODE mode,
+        TPM2B_IV *ivIn,
+        TPM2B_MAX_BUFFER *inData,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< EncryptDecryptOut >( sysContext, scheduler,
+            Tss2_Sys_EncryptDecrypt_Prepare( sysContext, keyHandle, decrypt, mode, ivIn, inData ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, EncryptDecryptOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_EncryptDecrypt_Complete( sysContext, &out->outData, &out->ivOut );
+            } );
+    }
+
+    Command< EventSequenceCompleteOut > EventSequenceComplete(
+        TPMI_DH_PCR pcrHandle,
+        TPMI_DH_OBJECT sequenceHandle,
+        TPM2B_MAX_BUFFER *buffer,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< EventSequenceCompleteOut >( sysContext, scheduler,
+            Tss2_Sys_EventSequenceComplete_Prepare( sysContext, pcrHandle, sequenceHandle, buffer ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, EventSequenceCompleteOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_EventSequenceComplete_Complete( sysContext, &out->results );
+            } );
+    }
+
+    Command< NoOutput > EvictControl(
+        TPMI_RH_PROVISION auth,
+        TPMI_DH_OBJECT objectHandle,
+        TPMI_DH_PERSISTENT persistentHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_EvictControl_Prepare( sysContext, auth, objectHandle, persistentHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< FieldUpgradeDataOut > FieldUpgradeData(
+        TPM2B_MAX_BUFFER *fuData,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< FieldUpgradeDataOut >( sysContext, scheduler,
+            Tss2_Sys_FieldUpgradeData_Prepare( sysContext, fuData ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, FieldUpgradeDataOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_FieldUpgradeData_Complete( sysContext, &out->nextDigest, &out->firstDigest );
+            } );
+    }
+
+    Command< NoOutput > FieldUpgradeStart(
+        TPMI_RH_PLATFORM authorization,
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_DIGEST *fuDigest,
+        TPMT_SIGNATURE *manifestSignature,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_FieldUpgradeStart_Prepare( sysContext, authorization, keyHandle, fuDigest, manifestSignature ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< FirmwareReadOut > FirmwareRead(
+        UINT32 sequenceNumber,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< FirmwareReadOut >( sysContext, scheduler,
+            Tss2_Sys_FirmwareRead_Prepare( sysContext, sequenceNumber ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, FirmwareReadOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_FirmwareRead_Complete( sysContext, &out->fuData );
+            } );
+    }
+
+    Command< NoOutput > FlushContext(
+        TPMI_DH_CONTEXT flushHandle )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_FlushContext_Prepare( sysContext, flushHandle ),
+            0, 0,
+            0 );
+    }
+
+    Command< GetCapabilityOut > GetCapability(
+        TPM_CAP capability,
+        UINT32 property,
+        UINT32 propertyCount,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetCapabilityOut >( sysContext, scheduler,
+            Tss2_Sys_GetCapability_Prepare( sysContext, capability, property, propertyCount ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetCapabilityOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetCapability_Complete( sysContext, &out->moreData, &out->capabilityData );
+            } );
+    }
+
+    Command< GetCommandAuditDigestOut > GetCommandAuditDigest(
+        TPMI_RH_ENDORSEMENT privacyHandle,
+        TPMI_DH_OBJECT signHandle,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetCommandAuditDigestOut >( sysContext, scheduler,
+            Tss2_Sys_GetCommandAuditDigest_Prepare( sysContext, privacyHandle, signHandle, qualifyingData, inScheme ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetCommandAuditDigestOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetCommandAuditDigest_Complete( sysContext, &out->auditInfo, &out->signature );
+            } );
+    }
+
+    Command< GetRandomOut > GetRandom(
+        UINT16 bytesRequested,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetRandomOut >( sysContext, scheduler,
+            Tss2_Sys_GetRandom_Prepare( sysContext, bytesRequested ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetRandomOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetRandom_Complete( sysContext, &out->randomBytes );
+            } );
+    }
+
+    Command< GetSessionAuditDigestOut > GetSessionAuditDigest(
+        TPMI_RH_ENDORSEMENT privacyAdminHandle,
+        TPMI_DH_OBJECT signHandle,
+        TPMI_SH_HMAC sessionHandle,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetSessionAuditDigestOut >( sysContext, scheduler,
+            Tss2_Sys_GetSessionAuditDigest_Prepare( sysContext, privacyAdminHandle, signHandle, sessionHandle, qualifyingData, inScheme ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetSessionAuditDigestOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetSessionAuditDigest_Complete( sysContext, &out->auditInfo, &out->signature );
+            } );
+    }
+
+    Command< GetTestResultOut > GetTestResult(
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetTestResultOut >( sysContext, scheduler,
+            Tss2_Sys_GetTestResult_Prepare( sysContext ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetTestResultOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetTestResult_Complete( sysContext, &out->outData, &out->testResult );
+            } );
+    }
+
+    Command< GetTimeOut > GetTime(
+        TPMI_RH_ENDORSEMENT privacyAdminHandle,
+        TPMI_DH_OBJECT signHandle,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< GetTimeOut >( sysContext, scheduler,
+            Tss2_Sys_GetTime_Prepare( sysContext, privacyAdminHandle, signHandle, qualifyingData, inScheme ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, GetTimeOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_GetTime_Complete( sysContext, &out->timeInfo, &out->signature );
+            } );
+    }
+
+    Command< HMACOut > HMAC(
+        TPMI_DH_OBJECT handle,
+        TPM2B_MAX_BUFFER *buffer,
+        TPMI_ALG_HASH hashAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< HMACOut >( sysContext, scheduler,
+            Tss2_Sys_HMAC_Prepare( sysContext, handle, buffer, hashAlg ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, HMACOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_HMAC_Complete( sysContext, &out->outHMAC );
+            } );
+    }
+
+    Command< HMAC_StartOut > HMAC_Start(
+        TPMI_DH_OBJECT handle,
+        TPM2B_AUTH *auth,
+        TPMI_ALG_HASH hashAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< HMAC_StartOut >( sysContext, scheduler,
+            Tss2_Sys_HMAC_Start_Prepare( sysContext, handle, auth, hashAlg ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, HMAC_StartOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_HMAC_Start_Complete( sysContext, &out->sequenceHandle );
+            } );
+    }
+
+    Command< HashOut > Hash(
+        TPM2B_MAX_BUFFER *data,
+        TPMI_ALG_HASH hashAlg,
+        TPMI_RH_HIERARCHY hierarchy,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< HashOut >( sysContext, scheduler,
+            Tss2_Sys_Hash_Prepare( sysContext, data, hashAlg, hierarchy ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, HashOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Hash_Complete( sysContext, &out->outHash, &out->validation );
+            } );
+    }
+
+    Command< HashSequenceStartOut > HashSequenceStart(
+        TPM2B_AUTH *auth,
+        TPMI_ALG_HASH hashAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< HashSequenceStartOut >( sysContext, scheduler,
+            Tss2_Sys_HashSequenceStart_Prepare( sysContext, auth, hashAlg ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, HashSequenceStartOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_HashSequenceStart_Complete( sysContext, &out->sequenceHandle );
+            } );
+    }
+
+    Command< NoOutput > HierarchyChangeAuth(
+        TPMI_RH_HIERARCHY_AUTH authHandle,
+        TPM2B_AUTH *newAuth,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_HierarchyChangeAuth_Prepare( sysContext, authHandle, newAuth ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > HierarchyControl(
+        TPMI_RH_HIERARCHY authHandle,
+        TPMI_RH_ENABLES enable,
+        TPMI_YES_NO state,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_HierarchyControl_Prepare( sysContext, authHandle, enable, state ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< ImportOut > Import(
+        TPMI_DH_OBJECT parentHandle,
+        TPM2B_DATA *encryptionKey,
+        TPM2B_PUBLIC *objectPublic,
+        TPM2B_PRIVATE *duplicate,
+        TPM2B_ENCRYPTED_SECRET *inSymSeed,
+        TPMT_SYM_DEF_OBJECT *symmetricAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ImportOut >( sysContext, scheduler,
+            Tss2_Sys_Import_Prepare( sysContext, parentHandle, encryptionKey, objectPublic, duplicate, inSymSeed, symmetricAlg ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ImportOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Import_Complete( sysContext, &out->outPrivate );
+            } );
+    }
+
+    Command< IncrementalSelfTestOut > IncrementalSelfTest(
+        TPML_ALG *toTest,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< IncrementalSelfTestOut >( sysContext, scheduler,
+            Tss2_Sys_IncrementalSelfTest_Prepare( sysContext, toTest ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, IncrementalSelfTestOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_IncrementalSelfTest_Complete( sysContext, &out->toDoList );
+            } );
+    }
+
+    Command< LoadOut > Load(
+        TPMI_DH_OBJECT parentHandle,
+        TPM2B_PRIVATE *inPrivate,
+        TPM2B_PUBLIC *inPublic,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< LoadOut >( sysContext, scheduler,
+            Tss2_Sys_Load_Prepare( sysContext, parentHandle, inPrivate, inPublic ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, LoadOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Load_Complete( sysContext, &out->objectHandle, &out->name );
+            } );
+    }
+
+    Command< LoadExternalOut > LoadExternal(
+        TPM2B_SENSITIVE *inPrivate,
+        TPM2B_PUBLIC *inPublic,
+        TPMI_RH_HIERARCHY hierarchy,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< LoadExternalOut >( sysContext, scheduler,
+            Tss2_Sys_LoadExternal_Prepare( sysContext, inPrivate, inPublic, hierarchy ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, LoadExternalOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_LoadExternal_Complete( sysContext, &out->objectHandle, &out->name );
+            } );
+    }
+
+    Command< MakeCredentialOut > MakeCredential(
+        TPMI_DH_OBJECT handle,
+        TPM2B_DIGEST *credential,
+        TPM2B_NAME *objectName,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< MakeCredentialOut >( sysContext, scheduler,
+            Tss2_Sys_MakeCredential_Prepare( sysContext, handle, credential, objectName ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, MakeCredentialOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_MakeCredential_Complete( sysContext, &out->credentialBlob, &out->secret );
+            } );
+    }
+
+    Command< NV_CertifyOut > NV_Certify(
+        TPMI_DH_OBJECT signHandle,
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        UINT16 size,
+        UINT16 offset,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NV_CertifyOut >( sysContext, scheduler,
+            Tss2_Sys_NV_Certify_Prepare( sysContext, signHandle, authHandle, nvIndex, qualifyingData, inScheme, size, offset ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, NV_CertifyOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_NV_Certify_Complete( sysContext, &out->certifyInfo, &out->signature );
+            } );
+    }
+
+    Command< NoOutput > NV_ChangeAuth(
+        TPMI_RH_NV_INDEX nvIndex,
+        TPM2B_AUTH *newAuth,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_ChangeAuth_Prepare( sysContext, nvIndex, newAuth ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_DefineSpace(
+        TPMI_RH_PROVISION authHandle,
+        TPM2B_AUTH *auth,
+        TPM2B_NV_PUBLIC *publicInfo,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_DefineSpace_Prepare( sysContext, authHandle, auth, publicInfo ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_Extend(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        TPM2B_MAX_NV_BUFFER *data,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_Extend_Prepare( sysContext, authHandle, nvIndex, data ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_GlobalWriteLock(
+        TPMI_RH_PROVISION authHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_GlobalWriteLock_Prepare( sysContext, authHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_Increment(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_Increment_Prepare( sysContext, authHandle, nvIndex ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NV_ReadOut > NV_Read(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        UINT16 size,
+        UINT16 offset,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NV_ReadOut >( sysContext, scheduler,
+            Tss2_Sys_NV_Read_Prepare( sysContext, authHandle, nvIndex, size, offset ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, NV_ReadOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_NV_Read_Complete( sysContext, &out->data );
+            } );
+    }
+
+    Command< NoOutput > NV_ReadLock(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_ReadLock_Prepare( sysContext, authHandle, nvIndex ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NV_ReadPublicOut > NV_ReadPublic(
+        TPMI_RH_NV_INDEX nvIndex,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NV_ReadPublicOut >( sysContext, scheduler,
+            Tss2_Sys_NV_ReadPublic_Prepare( sysContext, nvIndex ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, NV_ReadPublicOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_NV_ReadPublic_Complete( sysContext, &out->nvPublic, &out->nvName );
+            } );
+    }
+
+    Command< NoOutput > NV_SetBits(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        UINT64 bits,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_SetBits_Prepare( sysContext, authHandle, nvIndex, bits ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_UndefineSpace(
+        TPMI_RH_PROVISION authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_UndefineSpace_Prepare( sysContext, authHandle, nvIndex ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_UndefineSpaceSpecial(
+        TPMI_RH_NV_INDEX nvIndex,
+        TPMI_RH_PLATFORM platform,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_UndefineSpaceSpecial_Prepare( sysContext, nvIndex, platform ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_Write(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        TPM2B_MAX_NV_BUFFER *data,
+        UINT16 offset,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_Write_Prepare( sysContext, authHandle, nvIndex, data, offset ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > NV_WriteLock(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_NV_WriteLock_Prepare( sysContext, authHandle, nvIndex ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< ObjectChangeAuthOut > ObjectChangeAuth(
+        TPMI_DH_OBJECT objectHandle,
+        TPMI_DH_OBJECT parentHandle,
+        TPM2B_AUTH *newAuth,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ObjectChangeAuthOut >( sysContext, scheduler,
+            Tss2_Sys_ObjectChangeAuth_Prepare( sysContext, objectHandle, parentHandle, newAuth ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ObjectChangeAuthOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ObjectChangeAuth_Complete( sysContext, &out->outPrivate );
+            } );
+    }
+
+    Command< PCR_AllocateOut > PCR_Allocate(
+        TPMI_RH_PLATFORM authHandle,
+        TPML_PCR_SELECTION *pcrAllocation,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PCR_AllocateOut >( sysContext, scheduler,
+            Tss2_Sys_PCR_Allocate_Prepare( sysContext, authHandle, pcrAllocation ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PCR_AllocateOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PCR_Allocate_Complete( sysContext, &out->allocationSuccess, &out->maxPCR, &out->sizeNeeded, &out->sizeAvailable );
+            } );
+    }
+
+    Command< PCR_EventOut > PCR_Event(
+        TPMI_DH_PCR pcrHandle,
+        TPM2B_EVENT *eventData,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PCR_EventOut >( sysContext, scheduler,
+            Tss2_Sys_PCR_Event_Prepare( sysContext, pcrHandle, eventData ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PCR_EventOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PCR_Event_Complete( sysContext, &out->digests );
+            } );
+    }
+
+    Command< NoOutput > PCR_Extend(
+        TPMI_DH_PCR pcrHandle,
+        TPML_DIGEST_VALUES *digests,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PCR_Extend_Prepare( sysContext, pcrHandle, digests ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< PCR_ReadOut > PCR_Read(
+        TPML_PCR_SELECTION *pcrSelectionIn,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PCR_ReadOut >( sysContext, scheduler,
+            Tss2_Sys_PCR_Read_Prepare( sysContext, pcrSelectionIn ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PCR_ReadOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PCR_Read_Complete( sysContext, &out->pcrUpdateCounter, &out->pcrSelectionOut, &out->pcrValues );
+            } );
+    }
+
+    Command< NoOutput > PCR_Reset(
+        TPMI_DH_PCR pcrHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PCR_Reset_Prepare( sysContext, pcrHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PCR_SetAuthPolicy(
+        TPMI_RH_PLATFORM authHandle,
+        TPM2B_DIGEST *authPolicy,
+        TPMI_ALG_HASH hashAlg,
+        TPMI_DH_PCR pcrNum,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PCR_SetAuthPolicy_Prepare( sysContext, authHandle, authPolicy, hashAlg, pcrNum ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PCR_SetAuthValue(
+        TPMI_DH_PCR pcrHandle,
+        TPM2B_DIGEST *auth,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PCR_SetAuthValue_Prepare( sysContext, pcrHandle, auth ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PP_Commands(
+        TPMI_RH_PLATFORM auth,
+        TPML_CC *setList,
+        TPML_CC *clearList,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PP_Commands_Prepare( sysContext, auth, setList, clearList ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyAuthValue(
+        TPMI_SH_POLICY policySession,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyAuthValue_Prepare( sysContext, policySession ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyAuthorize(
+        TPMI_SH_POLICY policySession,
+        TPM2B_DIGEST *approvedPolicy,
+        TPM2B_NONCE *policyRef,
+        TPM2B_NAME *keySign,
+        TPMT_TK_VERIFIED *checkTicket,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyAuthorize_Prepare( sysContext, policySession, approvedPolicy, policyRef, keySign, checkTicket ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyCommandCode(
+        TPMI_SH_POLICY policySession,
+        TPM_CC code,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyCommandCode_Prepare( sysContext, policySession, code ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyCounterTimer(
+        TPMI_SH_POLICY policySession,
+        TPM2B_OPERAND *operandB,
+        UINT16 offset,
+        TPM_EO operation,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyCounterTimer_Prepare( sysContext, policySession, operandB, offset, operation ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyCpHash(
+        TPMI_SH_POLICY policySession,
+        TPM2B_DIGEST *cpHashA,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyCpHash_Prepare( sysContext, policySession, cpHashA ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyDuplicationSelect(
+        TPMI_SH_POLICY policySession,
+        TPM2B_NAME *objectName,
+        TPM2B_NAME *newParentName,
+        TPMI_YES_NO includeObject,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyDuplicationSelect_Prepare( sysContext, policySession, objectName, newParentName, includeObject ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< PolicyGetDigestOut > PolicyGetDigest(
+        TPMI_SH_POLICY policySession,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PolicyGetDigestOut >( sysContext, scheduler,
+            Tss2_Sys_PolicyGetDigest_Prepare( sysContext, policySession ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PolicyGetDigestOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PolicyGetDigest_Complete( sysContext, &out->policyDigest );
+            } );
+    }
+
+    Command< NoOutput > PolicyLocality(
+        TPMI_SH_POLICY policySession,
+        TPMA_LOCALITY locality,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyLocality_Prepare( sysContext, policySession, locality ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyNV(
+        TPMI_RH_NV_AUTH authHandle,
+        TPMI_RH_NV_INDEX nvIndex,
+        TPMI_SH_POLICY policySession,
+        TPM2B_OPERAND *operandB,
+        UINT16 offset,
+        TPM_EO operation,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyNV_Prepare( sysContext, authHandle, nvIndex, policySession, operandB, offset, operation ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyNameHash(
+        TPMI_SH_POLICY policySession,
+        TPM2B_DIGEST *nameHash,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyNameHash_Prepare( sysContext, policySession, nameHash ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyNvWritten(
+        TPMI_SH_POLICY policySession,
+        TPMI_YES_NO writtenSet,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyNvWritten_Prepare( sysContext, policySession, writtenSet ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyOR(
+        TPMI_SH_POLICY policySession,
+        TPML_DIGEST *pHashList,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyOR_Prepare( sysContext, policySession, pHashList ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyPCR(
+        TPMI_SH_POLICY policySession,
+        TPM2B_DIGEST *pcrDigest,
+        TPML_PCR_SELECTION *pcrs,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyPCR_Prepare( sysContext, policySession, pcrDigest, pcrs ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyPassword(
+        TPMI_SH_POLICY policySession,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyPassword_Prepare( sysContext, policySession ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyPhysicalPresence(
+        TPMI_SH_POLICY policySession,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyPhysicalPresence_Prepare( sysContext, policySession ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > PolicyRestart(
+        TPMI_SH_POLICY sessionHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyRestart_Prepare( sysContext, sessionHandle ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< PolicySecretOut > PolicySecret(
+        TPMI_DH_ENTITY authHandle,
+        TPMI_SH_POLICY policySession,
+        TPM2B_NONCE *nonceTPM,
+        TPM2B_DIGEST *cpHashA,
+        TPM2B_NONCE *policyRef,
+        INT32 expiration,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PolicySecretOut >( sysContext, scheduler,
+            Tss2_Sys_PolicySecret_Prepare( sysContext, authHandle, policySession, nonceTPM, cpHashA, policyRef, expiration ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PolicySecretOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PolicySecret_Complete( sysContext, &out->timeout, &out->policyTicket );
+            } );
+    }
+
+    Command< PolicySignedOut > PolicySigned(
+        TPMI_DH_OBJECT authObject,
+        TPMI_SH_POLICY policySession,
+        TPM2B_NONCE *nonceTPM,
+        TPM2B_DIGEST *cpHashA,
+        TPM2B_NONCE *policyRef,
+        INT32 expiration,
+        TPMT_SIGNATURE *auth,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< PolicySignedOut >( sysContext, scheduler,
+            Tss2_Sys_PolicySigned_Prepare( sysContext, authObject, policySession, nonceTPM, cpHashA, policyRef, expiration, auth ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, PolicySignedOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_PolicySigned_Complete( sysContext, &out->timeout, &out->policyTicket );
+            } );
+    }
+
+    Command< NoOutput > PolicyTicket(
+        TPMI_SH_POLICY policySession,
+        TPM2B_TIMEOUT *timeout,
+        TPM2B_DIGEST *cpHashA,
+        TPM2B_NONCE *policyRef,
+        TPM2B_NAME *authName,
+        TPMT_TK_AUTH *ticket,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_PolicyTicket_Prepare( sysContext, policySession, timeout, cpHashA, policyRef, authName, ticket ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< QuoteOut > Quote(
+        TPMI_DH_OBJECT signHandle,
+        TPM2B_DATA *qualifyingData,
+        TPMT_SIG_SCHEME *inScheme,
+        TPML_PCR_SELECTION *PCRselect,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< QuoteOut >( sysContext, scheduler,
+            Tss2_Sys_Quote_Prepare( sysContext, signHandle, qualifyingData, inScheme, PCRselect ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, QuoteOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Quote_Complete( sysContext, &out->quoted, &out->signature );
+            } );
+    }
+
+    Command< RSA_DecryptOut > RSA_Decrypt(
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_PUBLIC_KEY_RSA *cipherText,
+        TPMT_RSA_DECRYPT *inScheme,
+        TPM2B_DATA *label,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< RSA_DecryptOut >( sysContext, scheduler,
+            Tss2_Sys_RSA_Decrypt_Prepare( sysContext, keyHandle, cipherText, inScheme, label ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, RSA_DecryptOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_RSA_Decrypt_Complete( sysContext, &out->message );
+            } );
+    }
+
+    Command< RSA_EncryptOut > RSA_Encrypt(
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_PUBLIC_KEY_RSA *message,
+        TPMT_RSA_DECRYPT *inScheme,
+        TPM2B_DATA *label,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< RSA_EncryptOut >( sysContext, scheduler,
+            Tss2_Sys_RSA_Encrypt_Prepare( sysContext, keyHandle, message, inScheme, label ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, RSA_EncryptOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_RSA_Encrypt_Complete( sysContext, &out->outData );
+            } );
+    }
+
+    Command< ReadClockOut > ReadClock()
+    {
+        return Command< ReadClockOut >( sysContext, scheduler,
+            Tss2_Sys_ReadClock_Prepare( sysContext ),
+            0, 0,
+            []( TSS2_SYS_CONTEXT *sysContext, ReadClockOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ReadClock_Complete( sysContext, &out->currentTime );
+            } );
+    }
+
+    Command< ReadPublicOut > ReadPublic(
+        TPMI_DH_OBJECT objectHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ReadPublicOut >( sysContext, scheduler,
+            Tss2_Sys_ReadPublic_Prepare( sysContext, objectHandle ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ReadPublicOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ReadPublic_Complete( sysContext, &out->outPublic, &out->name, &out->qualifiedName );
+            } );
+    }
+
+    Command< RewrapOut > Rewrap(
+        TPMI_DH_OBJECT oldParent,
+        TPMI_DH_OBJECT newParent,
+        TPM2B_PRIVATE *inDuplicate,
+        TPM2B_NAME *name,
+        TPM2B_ENCRYPTED_SECRET *inSymSeed,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< RewrapOut >( sysContext, scheduler,
+            Tss2_Sys_Rewrap_Prepare( sysContext, oldParent, newParent, inDuplicate, name, inSymSeed ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, RewrapOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Rewrap_Complete( sysContext, &out->outDuplicate, &out->outSymSeed );
+            } );
+    }
+
+    Command< NoOutput > SelfTest(
+        TPMI_YES_NO fullTest,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_SelfTest_Prepare( sysContext, fullTest ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< SequenceCompleteOut > SequenceComplete(
+        TPMI_DH_OBJECT sequenceHandle,
+        TPM2B_MAX_BUFFER *buffer,
+        TPMI_RH_HIERARCHY hierarchy,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< SequenceCompleteOut >( sysContext, scheduler,
+            Tss2_Sys_SequenceComplete_Prepare( sysContext, sequenceHandle, buffer, hierarchy ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, SequenceCompleteOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_SequenceComplete_Complete( sysContext, &out->result, &out->validation );
+            } );
+    }
+
+    Command< NoOutput > SequenceUpdate(
+        TPMI_DH_OBJECT sequenceHandle,
+        TPM2B_MAX_BUFFER *buffer,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_SequenceUpdate_Prepare( sysContext, sequenceHandle, buffer ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > SetAlgorithmSet(
+        TPMI_RH_PLATFORM authHandle,
+        UINT32 algorithmSet,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_SetAlgorithmSet_Prepare( sysContext, authHandle, algorithmSet ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > SetCommandCodeAuditStatus(
+        TPMI_RH_PROVISION auth,
+        TPMI_ALG_HASH auditAlg,
+        TPML_CC *setList,
+        TPML_CC *clearList,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_SetCommandCodeAuditStatus_Prepare( sysContext, auth, auditAlg, setList, clearList ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > SetPrimaryPolicy(
+        TPMI_RH_HIERARCHY_AUTH authHandle,
+        TPM2B_DIGEST *authPolicy,
+        TPMI_ALG_HASH hashAlg,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_SetPrimaryPolicy_Prepare( sysContext, authHandle, authPolicy, hashAlg ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > Shutdown(
+        TPM_SU shutdownType,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_Shutdown_Prepare( sysContext, shutdownType ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< SignOut > Sign(
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_DIGEST *digest,
+        TPMT_SIG_SCHEME *inScheme,
+        TPMT_TK_HASHCHECK *validation,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< SignOut >( sysContext, scheduler,
+            Tss2_Sys_Sign_Prepare( sysContext, keyHandle, digest, inScheme, validation ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, SignOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Sign_Complete( sysContext, &out->signature );
+            } );
+    }
+
+    Command< StartAuthSessionOut > StartAuthSession(
+        TPMI_DH_OBJECT tpmKey,
+        TPMI_DH_ENTITY bind,
+        TPM2B_NONCE *nonceCaller,
+        TPM2B_ENCRYPTED_SECRET *encryptedSalt,
+        TPM_SE sessionType,
+        TPMT_SYM_DEF *symmetric,
+        TPMI_ALG_HASH authHash,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< StartAuthSessionOut >( sysContext, scheduler,
+            Tss2_Sys_StartAuthSession_Prepare( sysContext, tpmKey, bind, nonceCaller, encryptedSalt, sessionType, symmetric, authHash ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, StartAuthSessionOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_StartAuthSession_Complete( sysContext, &out->sessionHandle, &out->nonceTPM );
+            } );
+    }
+
+    Command< NoOutput > Startup(
+        TPM_SU startupType )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_Startup_Prepare( sysContext, startupType ),
+            0, 0,
+            0 );
+    }
+
+    Command< NoOutput > StirRandom(
+        TPM2B_SENSITIVE_DATA *inData,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_StirRandom_Prepare( sysContext, inData ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< NoOutput > TestParms(
+        TPMT_PUBLIC_PARMS *parameters,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< NoOutput >( sysContext, scheduler,
+            Tss2_Sys_TestParms_Prepare( sysContext, parameters ),
+            cmdAuths, rspAuths,
+            0 );
+    }
+
+    Command< UnsealOut > Unseal(
+        TPMI_DH_OBJECT itemHandle,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< UnsealOut >( sysContext, scheduler,
+            Tss2_Sys_Unseal_Prepare( sysContext, itemHandle ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, UnsealOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Unseal_Complete( sysContext, &out->outData );
+            } );
+    }
+
+    Command< Vendor_TCG_TestOut > Vendor_TCG_Test(
+        TPM2B_DATA *inputData,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< Vendor_TCG_TestOut >( sysContext, scheduler,
+            Tss2_Sys_Vendor_TCG_Test_Prepare( sysContext, inputData ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, Vendor_TCG_TestOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_Vendor_TCG_Test_Complete( sysContext, &out->outputData );
+            } );
+    }
+
+    Command< VerifySignatureOut > VerifySignature(
+        TPMI_DH_OBJECT keyHandle,
+        TPM2B_DIGEST *digest,
+        TPMT_SIGNATURE *signature,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< VerifySignatureOut >( sysContext, scheduler,
+            Tss2_Sys_VerifySignature_Prepare( sysContext, keyHandle, digest, signature ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, VerifySignatureOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_VerifySignature_Complete( sysContext, &out->validation );
+            } );
+    }
+
+    Command< ZGen_2PhaseOut > ZGen_2Phase(
+        TPMI_DH_OBJECT keyA,
+        TPM2B_ECC_POINT *inQsB,
+        TPM2B_ECC_POINT *inQeB,
+        TPMI_ECC_KEY_EXCHANGE inScheme,
+        UINT16 counter,
+        const TSS2_SYS_CMD_AUTHS *cmdAuths = 0,
+        TSS2_SYS_RSP_AUTHS *rspAuths = 0 )
+    {
+        return Command< ZGen_2PhaseOut >( sysContext, scheduler,
+            Tss2_Sys_ZGen_2Phase_Prepare( sysContext, keyA, inQsB, inQeB, inScheme, counter ),
+            cmdAuths, rspAuths,
+            []( TSS2_SYS_CONTEXT *sysContext, ZGen_2PhaseOut *out ) -> TSS2_RC
+            {
+                return Tss2_Sys_ZGen_2Phase_Complete( sysContext, &out->outZ1, &out->outZ2 );
+            } );
+    }
+};
+
+#ifdef TSS2_SYS_CORO_INSTANTIATE_ALL
+template class Command< NoOutput >;
+template class Command< ActivateCredentialOut >;
+template class Command< CertifyOut >;
+template class Command< CertifyCreationOut >;
+template class Command< CommitOut >;
+template class Command< ContextLoadOut >;
+template class Command< ContextSaveOut >;
+template class Command< CreateOut >;
+template class Command< CreatePrimaryOut >;
+template class Command< DuplicateOut >;
+template class Command< ECC_ParametersOut >;
+template class Command< ECDH_KeyGenOut >;
+template class Command< ECDH_ZGenOut >;
+template class Command< EC_EphemeralOut >;
+template class Command< EncryptDecryptOut >;
+template class Command< EventSequenceCompleteOut >;
+template class Command< FieldUpgradeDataOut >;
+template class Command< FirmwareReadOut >;
+template class Command< GetCapabilityOut >;
+template class Command< GetCommandAuditDigestOut >;
+template class Command< GetRandomOut >;
+template class Command< GetSessionAuditDigestOut >;
+template class Command< GetTestResultOut >;
+template class Command< GetTimeOut >;
+template class Command< HMACOut >;
+template class Command< HMAC_StartOut >;
+template class Command< HashOut >;
+template class Command< HashSequenceStartOut >;
+template class Command< ImportOut >;
+template class Command< IncrementalSelfTestOut >;
+template class Command< LoadOut >;
+template class Command< LoadExternalOut >;
+template class Command< MakeCredentialOut >;
+template class Command< NV_CertifyOut >;
+template class Command< NV_ReadOut >;
+template class Command< NV_ReadPublicOut >;
+template class Command< ObjectChangeAuthOut >;
+template class Command< PCR_AllocateOut >;
+template class Command< PCR_EventOut >;
+template class Command< PCR_ReadOut >;
+template class Command< PolicyGetDigestOut >;
+template class Command< PolicySecretOut >;
+template class Command< PolicySignedOut >;
+template class Command< QuoteOut >;
+template class Command< RSA_DecryptOut >;
+template class Command< RSA_EncryptOut >;
+template class Command< ReadClockOut >;
+template class Command< ReadPublicOut >;
+template class Command< RewrapOut >;
+template class Command< SequenceCompleteOut >;
+template class Command< SignOut >;
+template class Command< StartAuthSessionOut >;
+template class Command< UnsealOut >;
+template class Command< Vendor_TCG_TestOut >;
+template class Command< VerifySignatureOut >;
+template class Command< ZGen_2PhaseOut >;
+#endif
+
+} // namespace tss2
+
+#endif
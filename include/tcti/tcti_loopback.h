@@ -0,0 +1,109 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TCTI_LOOPBACK_H
+#define TCTI_LOOPBACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sapi/tpm20.h>
+#include <tcti/common.h>
+
+//
+// In-process TCTI that answers commands from memory instead of a TPM, for
+// benchmarking and testing the SAPI and the resource manager without a
+// simulator.
+//
+// A response is looked up first in the canned responses set with
+// LoopbackTctiSetResponse, then produced by the responder callback, if
+// any; otherwise the command fails with TPM_RC_COMMAND_CODE.
+//
+
+#define TCTI_LOOPBACK_MAX_RESPONSES 32
+
+// Writes the response to command into response (at most *responseSize
+// bytes) and sets *responseSize to its length.  Anything other than
+// TSS2_RC_SUCCESS is returned by transmit.
+typedef TSS2_RC (*TCTI_LOOPBACK_RESPONDER)(
+    void *data,
+    const uint8_t *command,
+    size_t commandSize,
+    uint8_t *response,
+    size_t *responseSize
+    );
+
+typedef struct {
+    TCTI_LOOPBACK_RESPONDER responder;  // May be NULL.
+    void *responderData;
+    uint32_t latency;                   // Simulated execution time per command, in ns.
+    TCTI_LOG_CALLBACK logCallback;
+    void *logData;
+} TCTI_LOOPBACK_CONF;
+
+TSS2_RC InitLoopbackTcti (
+    TSS2_TCTI_CONTEXT *tctiContext, // OUT
+    size_t *contextSize,            // IN/OUT
+    const TCTI_LOOPBACK_CONF *config  // IN
+    );
+
+// Answers every command with commandCode with the given response.  The
+// response is not copied and must stay valid while it is in use; a NULL
+// response removes the entry.
+TSS2_RC LoopbackTctiSetResponse(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TPM_CC commandCode,
+    const uint8_t *response,
+    size_t responseSize
+    );
+
+// Changes the simulated execution time, in ns, from the next command on.
+// Canceling a command before it has "executed" makes it fail with
+// TPM_RC_CANCELED.
+TSS2_RC LoopbackTctiSetLatency(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    uint32_t latency
+    );
+
+// A wedged TCTI ignores cancel, like a TPM that has hung: the command
+// takes its full latency whatever happens.
+TSS2_RC LoopbackTctiSetWedged(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    uint8_t wedged
+    );
+
+// Number of commands transmitted so far.
+uint32_t LoopbackTctiGetCommandCount(
+    TSS2_TCTI_CONTEXT *tctiContext
+    );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCTI_LOOPBACK_H */
@@ -0,0 +1,122 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TCTI_RECORD_H
+#define TCTI_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sapi/tpm20.h>
+#include <tcti/common.h>
+
+//
+// TCTI wrapper that passes every command through to a downstream TCTI and
+// appends each command/response pair to a log file, for replaying
+// production traffic later (see test/bench/replay).
+//
+// The log is a TCTI_RECORD_FILE_HEADER followed by records.  Each record
+// is a TCTI_RECORD_HEADER, the command bytes, the response bytes and
+// padding up to a multiple of 8 bytes.  Records are appended with a single
+// write, so several processes may record to the same log.  All fields are
+// in host byte order.
+//
+
+#define TCTI_RECORD_FILE_MAGIC      0x43455254  // "TREC"
+#define TCTI_RECORD_FILE_VERSION    1
+#define TCTI_RECORD_MAX_COMMAND     4096
+#define TCTI_RECORD_MAX_RESPONSE    4096
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} TCTI_RECORD_FILE_HEADER;
+
+typedef struct {
+    uint64_t timestamp;     // CLOCK_MONOTONIC, in ns, when the command was sent.
+    uint32_t latency;       // ns from sending the command to receiving the response.
+    uint32_t connection;
+    uint32_t commandSize;
+    uint32_t responseSize;
+    uint8_t locality;
+    uint8_t reserved[7];
+} TCTI_RECORD_HEADER;
+
+#define TCTI_RECORD_COMMAND( header ) ( (const uint8_t *)( (header) + 1 ) )
+#define TCTI_RECORD_RESPONSE( header ) ( TCTI_RECORD_COMMAND( header ) + (header)->commandSize )
+
+typedef struct {
+    TSS2_TCTI_CONTEXT *downstream;  // Not finalized with the recording TCTI.
+    const char *logFile;
+    uint32_t connection;            // Tags the records; 0 means the process id.
+    TCTI_LOG_CALLBACK logCallback;
+    void *logData;
+} TCTI_RECORD_CONF;
+
+TSS2_RC InitRecordTcti (
+    TSS2_TCTI_CONTEXT *tctiContext, // OUT
+    size_t *contextSize,            // IN/OUT
+    const TCTI_RECORD_CONF *config  // IN
+    );
+
+// Number of command/response pairs that could not be written to the log.
+// A failed write never fails the command itself.
+uint32_t RecordTctiGetDroppedCount(
+    TSS2_TCTI_CONTEXT *tctiContext
+    );
+
+//
+// Read side: the whole log is mapped into memory.
+//
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    size_t offset;
+} TCTI_RECORD_LOG;
+
+TSS2_RC RecordLogOpen(
+    TCTI_RECORD_LOG *log,
+    const char *logFile
+    );
+
+// Returns the next record, or NULL at the end of the log.  A record that
+// is only partly written, e.g. by a process that is still recording, ends
+// the log too.
+const TCTI_RECORD_HEADER *RecordLogNext(
+    TCTI_RECORD_LOG *log
+    );
+
+void RecordLogClose(
+    TCTI_RECORD_LOG *log
+    );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCTI_RECORD_H */
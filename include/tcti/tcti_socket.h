@@ -70,6 +70,15 @@ TSS2_RC SendSessionEndSocketTcti(
     UINT8 tpmCmdServer
     );
 
+// Asks a resource manager to keep this connection's objects, sequences and
+// sessions for a client that reconnects with *token after the RM restarts.
+// If *token is 0, a new token is returned in it; otherwise the entities
+// left with that token become this connection's.
+TSS2_RC ReattachSocketTcti(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    UINT64 *token
+    );
+
 // Commands to send to OTHER port.
 #define MS_SIM_POWER_ON         1
 #define MS_SIM_POWER_OFF        2
@@ -78,6 +87,7 @@ TSS2_RC SendSessionEndSocketTcti(
 #define MS_SIM_CANCEL_OFF       10
 #define MS_SIM_NV_ON            11
 #define TPM_SESSION_END         20
+#define TPM_RESMGR_REATTACH     21
 
 #ifdef __cplusplus
 }
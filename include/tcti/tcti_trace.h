@@ -0,0 +1,87 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TCTI_TRACE_H
+#define TCTI_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// Per-command tracing in the device and socket TCTIs.
+//
+// When enabled, every command that completes with a response adds one
+// fixed-size record to a ring buffer owned by the calling thread.  Writers
+// never lock or allocate (except for a thread's first record); when a
+// ring is full the record is dropped and counted.  When disabled, the cost
+// is a test of one flag per transmit and receive.
+//
+// Timestamps are CLOCK_MONOTONIC, in ns.  firstByteTime is when the
+// response started to become available: for the socket TCTI, when the
+// socket became readable; for the device TCTI, when poll reported the
+// device readable or, for blocking receives, when read returned.
+//
+
+typedef struct {
+    uint64_t sendTime;
+    uint64_t firstByteTime;
+    uint64_t completeTime;
+    uint32_t commandCode;
+    uint32_t responseCode;
+    uint32_t commandSize;
+    uint32_t responseSize;
+    uint8_t locality;
+    uint8_t reserved[7];
+} TCTI_TRACE_RECORD;
+
+// Enables tracing with rings of at least recordsPerThread records, or
+// disables it if recordsPerThread is 0.  Records already traced stay in
+// the rings until drained.  The first call that enables tracing sets the
+// ring size for the life of the process.
+void TctiTraceEnable(
+    uint32_t recordsPerThread
+    );
+
+// Moves up to count records out of the rings, oldest first within each
+// thread, and returns how many it moved.  May be called from any thread.
+size_t TctiTraceDrain(
+    TCTI_TRACE_RECORD *records,
+    size_t count
+    );
+
+// Records dropped because a ring was full.
+uint64_t TctiTraceGetDroppedCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCTI_TRACE_H */
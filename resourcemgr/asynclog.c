@@ -0,0 +1,372 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sapi/tpm20.h>
+#include "asynclog.h"
+
+#define LOG_SLOT_SIZE 64
+#define LOG_SLOT_DATA ( LOG_SLOT_SIZE - sizeof( UINT64 ) )
+#define LOG_MIN_SLOTS 64
+#define LOG_MAX_SLOTS ( 1 << 20 )
+#define LOG_WRITE_INTERVAL_NS ( 10 * 1000 * 1000 )
+
+enum { LOG_TEXT = 1, LOG_BUFFER = 2 };
+
+//
+// Bounded multi-producer, single-consumer ring.  Slot i starts with
+// sequence i.  A producer claims 'slots' consecutive positions starting at
+// enqueuePos once the last of them is free, fills them and publishes each
+// with sequence position + 1, the first one last.  The consumer copies a
+// published record out and frees its slots for the next lap by setting
+// their sequence to position + ring size.  Since slots are freed in
+// order, the last one being free means they all are.
+//
+typedef struct {
+    UINT64 sequence;
+    UINT8 data[LOG_SLOT_DATA];
+} LOG_SLOT;
+
+typedef struct {
+    UINT8 kind;
+    UINT8 type;
+    UINT16 slots;
+    UINT32 length;       // bytes stored
+    UINT32 fullLength;   // bytes the caller had
+} LOG_RECORD_HEADER;
+
+#define LOG_HEAD_DATA ( LOG_SLOT_DATA - sizeof( LOG_RECORD_HEADER ) )
+
+static LOG_SLOT *logRing = 0;
+static UINT32 logMask;
+static UINT32 maxRecordSlots;
+static UINT32 maxPayload;
+static UINT8 *recordBuffer;
+static UINT64 enqueuePos = 0;
+static UINT64 dequeuePos = 0;
+static UINT64 dropped = 0;
+static UINT64 reportedDropped = 0;
+
+static pthread_mutex_t initMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drainMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t writerThread;
+static int writerStarted = 0;
+static int writerRunning = 0;
+static FILE *writerOut = 0;
+
+static UINT32 SlotsFor( UINT32 length )
+{
+    if( length <= LOG_HEAD_DATA )
+        return 1;
+    return 1 + ( length - LOG_HEAD_DATA + LOG_SLOT_DATA - 1 ) / LOG_SLOT_DATA;
+}
+
+static void CopyIn( UINT64 pos, LOG_RECORD_HEADER *header, const UINT8 *payload )
+{
+    LOG_SLOT *slot = &logRing[pos & logMask];
+    UINT32 done = header->length < LOG_HEAD_DATA ? header->length : LOG_HEAD_DATA;
+    UINT32 chunk;
+
+    memcpy( slot->data, header, sizeof( *header ) );
+    memcpy( slot->data + sizeof( *header ), payload, done );
+    while( done < header->length )
+    {
+        slot = &logRing[++pos & logMask];
+        chunk = header->length - done < LOG_SLOT_DATA ? header->length - done : LOG_SLOT_DATA;
+        memcpy( slot->data, payload + done, chunk );
+        done += chunk;
+    }
+}
+
+static void CopyOut( UINT64 pos, LOG_RECORD_HEADER *header, UINT8 *payload )
+{
+    LOG_SLOT *slot = &logRing[pos & logMask];
+    UINT32 done;
+    UINT32 chunk;
+
+    memcpy( header, slot->data, sizeof( *header ) );
+    done = header->length < LOG_HEAD_DATA ? header->length : LOG_HEAD_DATA;
+    memcpy( payload, slot->data + sizeof( *header ), done );
+    while( done < header->length )
+    {
+        slot = &logRing[++pos & logMask];
+        chunk = header->length - done < LOG_SLOT_DATA ? header->length - done : LOG_SLOT_DATA;
+        memcpy( payload + done, slot->data, chunk );
+        done += chunk;
+    }
+}
+
+static void Enqueue( UINT8 kind, printf_type type, const UINT8 *payload, UINT32 length )
+{
+    LOG_RECORD_HEADER header;
+    UINT64 pos;
+    UINT64 last;
+    UINT64 sequence;
+    UINT32 i;
+
+    header.kind = kind;
+    header.type = (UINT8)type;
+    header.fullLength = length;
+    header.length = length < maxPayload ? length : maxPayload;
+    header.slots = (UINT16)SlotsFor( header.length );
+
+    pos = __atomic_load_n( &enqueuePos, __ATOMIC_RELAXED );
+    for( ;; )
+    {
+        last = pos + header.slots - 1;
+        sequence = __atomic_load_n( &logRing[last & logMask].sequence, __ATOMIC_ACQUIRE );
+        if( sequence == last )
+        {
+            if( __atomic_compare_exchange_n( &enqueuePos, &pos, pos + header.slots, 1,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+                break;
+        }
+        else if( (INT64)( sequence - last ) < 0 )
+        {
+            // Still holds a record from the previous lap: full.
+            __atomic_fetch_add( &dropped, 1, __ATOMIC_RELAXED );
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n( &enqueuePos, __ATOMIC_RELAXED );
+        }
+    }
+
+    CopyIn( pos, &header, payload );
+    for( i = header.slots; i-- > 0; )
+        __atomic_store_n( &logRing[( pos + i ) & logMask].sequence, pos + i + 1, __ATOMIC_RELEASE );
+}
+
+int AsyncLogPrintf( printf_type type, const char *format, va_list args )
+{
+    char text[ASYNC_LOG_MAX_TEXT];
+    int rval;
+
+    if( logRing == 0 )
+    {
+        if( type == RM_PREFIX )
+            printf( "||  " );
+        return vprintf( format, args );
+    }
+
+    rval = vsnprintf( text, sizeof( text ), format, args );
+    if( rval > 0 || ( rval == 0 && type == RM_PREFIX ) )
+        Enqueue( LOG_TEXT, type, (UINT8 *)text,
+                rval < (int)sizeof( text ) ? (UINT32)rval : (UINT32)sizeof( text ) - 1 );
+
+    return rval;
+}
+
+void AsyncLogBuffer( printf_type type, UINT8 *buffer, UINT32 length )
+{
+    if( logRing == 0 )
+        return;
+
+    Enqueue( LOG_BUFFER, type, buffer, length );
+}
+
+static void WriteRecord( FILE *out, LOG_RECORD_HEADER *header, UINT8 *payload )
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    char line[1 + 4 + 16 * 3];
+    UINT32 used;
+    UINT32 i;
+    UINT32 j;
+
+    if( header->kind == LOG_TEXT )
+    {
+        if( header->type == RM_PREFIX )
+            fputs( "||  ", out );
+        fwrite( payload, 1, header->length, out );
+        if( header->length < header->fullLength )
+            fputs( "...\n", out );
+        return;
+    }
+
+    // Same layout as DebugPrintBuffer, written a line at a time.
+    for( i = 0; i < header->length; i += 16 )
+    {
+        used = 0;
+        line[used++] = '\n';
+        if( header->type == RM_PREFIX )
+        {
+            memcpy( &line[used], "||  ", 4 );
+            used += 4;
+        }
+        for( j = i; j < header->length && j < i + 16; j++ )
+        {
+            line[used++] = hexDigits[payload[j] >> 4];
+            line[used++] = hexDigits[payload[j] & 0xf];
+            line[used++] = ' ';
+        }
+        fwrite( line, 1, used, out );
+    }
+    if( header->length < header->fullLength )
+        fprintf( out, "\n... %u more bytes", header->fullLength - header->length );
+    fputs( "\n\n", out );
+}
+
+size_t AsyncLogDrain( FILE *out )
+{
+    LOG_RECORD_HEADER header;
+    UINT64 droppedNow;
+    size_t count = 0;
+    UINT32 i;
+
+    pthread_mutex_lock( &drainMutex );
+
+    if( logRing == 0 )
+        goto exit;
+
+    while( __atomic_load_n( &logRing[dequeuePos & logMask].sequence, __ATOMIC_ACQUIRE ) == dequeuePos + 1 )
+    {
+        CopyOut( dequeuePos, &header, recordBuffer );
+        for( i = 0; i < header.slots; i++ )
+        {
+            __atomic_store_n( &logRing[( dequeuePos + i ) & logMask].sequence,
+                    dequeuePos + i + logMask + 1, __ATOMIC_RELEASE );
+        }
+        dequeuePos += header.slots;
+
+        WriteRecord( out, &header, recordBuffer );
+        count++;
+    }
+
+    droppedNow = __atomic_load_n( &dropped, __ATOMIC_RELAXED );
+    if( droppedNow != reportedDropped )
+    {
+        fprintf( out, "asynclog: %llu messages dropped\n",
+                (unsigned long long)( droppedNow - reportedDropped ) );
+        reportedDropped = droppedNow;
+    }
+
+    if( count != 0 )
+        fflush( out );
+
+exit:
+    pthread_mutex_unlock( &drainMutex );
+    return count;
+}
+
+UINT64 AsyncLogGetDroppedCount()
+{
+    return __atomic_load_n( &dropped, __ATOMIC_RELAXED );
+}
+
+int AsyncLogInit( UINT32 slots )
+{
+    UINT32 size = LOG_MIN_SLOTS;
+    UINT32 i;
+    int rval = 0;
+
+    pthread_mutex_lock( &initMutex );
+
+    if( logRing == 0 )
+    {
+        while( size < slots && size < LOG_MAX_SLOTS )
+            size <<= 1;
+
+        maxRecordSlots = size / 4;
+        maxPayload = LOG_HEAD_DATA + ( maxRecordSlots - 1 ) * LOG_SLOT_DATA;
+        recordBuffer = malloc( maxPayload );
+        logRing = calloc( size, sizeof( LOG_SLOT ) );
+        if( logRing == 0 || recordBuffer == 0 )
+        {
+            free( logRing );
+            free( recordBuffer );
+            logRing = 0;
+            recordBuffer = 0;
+            rval = -1;
+            goto exit;
+        }
+        for( i = 0; i < size; i++ )
+            logRing[i].sequence = i;
+        logMask = size - 1;
+    }
+
+    SetDebugHooks( AsyncLogPrintf, AsyncLogBuffer );
+
+exit:
+    pthread_mutex_unlock( &initMutex );
+    return rval;
+}
+
+static void *AsyncLogWriter( void *data )
+{
+    FILE *out = (FILE *)data;
+    struct timespec interval = { 0, LOG_WRITE_INTERVAL_NS };
+
+    while( __atomic_load_n( &writerRunning, __ATOMIC_ACQUIRE ) )
+    {
+        if( AsyncLogDrain( out ) == 0 )
+            nanosleep( &interval, 0 );
+    }
+
+    return 0;
+}
+
+int AsyncLogStart( FILE *out, UINT32 slots )
+{
+    int rval;
+
+    if( writerStarted )
+        return 0;
+
+    rval = AsyncLogInit( slots );
+    if( rval != 0 )
+        return rval;
+
+    writerOut = out;
+    __atomic_store_n( &writerRunning, 1, __ATOMIC_RELEASE );
+    rval = pthread_create( &writerThread, 0, AsyncLogWriter, out );
+    if( rval != 0 )
+    {
+        SetDebugHooks( 0, 0 );
+        return rval;
+    }
+    writerStarted = 1;
+
+    return 0;
+}
+
+void AsyncLogStop()
+{
+    SetDebugHooks( 0, 0 );
+
+    if( writerStarted )
+    {
+        __atomic_store_n( &writerRunning, 0, __ATOMIC_RELEASE );
+        pthread_join( writerThread, 0 );
+        writerStarted = 0;
+        AsyncLogDrain( writerOut );
+    }
+}
@@ -0,0 +1,79 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <sapi/tpm20.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include "debug.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Asynchronous backend for DebugPrintf and DebugPrintBuffer.  Once
+// started, callers only copy their message into a bounded lock-free ring
+// and return; a writer thread does the hex formatting and the I/O.  When
+// the ring is full the message is counted as dropped rather than waiting
+// for room.
+//
+// Printf-style messages are formatted into the record with vsnprintf and
+// truncated to ASYNC_LOG_MAX_TEXT bytes; buffers are copied raw, up to a
+// quarter of the ring.
+//
+#define ASYNC_LOG_DEFAULT_SLOTS 8192
+#define ASYNC_LOG_MAX_TEXT 256
+
+// Allocates the ring (the first call fixes its size in 64 byte slots) and
+// routes the debug functions into it.  Returns 0 on success.
+int AsyncLogInit( UINT32 slots );
+
+// AsyncLogInit, plus a thread that drains the ring to out every few
+// milliseconds.  Returns 0 on success.
+int AsyncLogStart( FILE *out, UINT32 slots );
+
+// Routes the debug functions back to stdout, stops the writer thread and
+// writes whatever is still queued.  Suitable for atexit().
+void AsyncLogStop();
+
+// Writes out all complete records queued so far, plus a note of any
+// newly dropped ones.  Returns the number of records written.
+size_t AsyncLogDrain( FILE *out );
+
+UINT64 AsyncLogGetDroppedCount();
+
+int AsyncLogPrintf( printf_type type, const char *format, va_list args );
+void AsyncLogBuffer( printf_type type, UINT8 *buffer, UINT32 length );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,18 +28,70 @@
 #include "sapi/tpm20.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "sysapi_util.h"
 
-// Get the TPM 2.0 commands supported by the TPM.
-TSS2_RC GetCommands( TSS2_SYS_CONTEXT *resMgrSysContext, TPML_CCA **supportedCommands )
+#define COMMAND_CACHE_MAGIC 0x434d4443     // "CMDC"
+
+// Command cache file header; the command attributes follow.
+typedef struct {
+    UINT32 magic;
+    UINT32 manufacturer;
+    UINT32 firmwareVersion1;
+    UINT32 firmwareVersion2;
+    UINT32 count;
+} COMMAND_CACHE_HEADER;
+
+// Reads numCommands command attributes from the TPM.  Each GetCapability
+// carries on from the command after the last one the previous returned.
+static TSS2_RC ReadCommands( TSS2_SYS_CONTEXT *resMgrSysContext, UINT32 numCommands, TPML_CCA **supportedCommands )
 {
-    UINT32      numCommands;
     TPMI_YES_NO	moreData;
     TPMS_CAPABILITY_DATA capabilityData;
-    TPMA_CC *commandPtr;
+    TPM_CC commandCode = TPM_CC_FIRST;
     TSS2_RC rval = TSS2_RC_SUCCESS;
     UINT32 i;
 
+    // Allocate memory for them
+    *supportedCommands = (TPML_CCA *)malloc( numCommands * sizeof( TPMA_CC ) + sizeof( UINT32 ) );
+    if( !*supportedCommands )
+    {
+        return TSS2_BASE_RC_INSUFFICIENT_BUFFER + TSS2_RESMGR_ERROR_LEVEL;
+    }
+
+    ( *supportedCommands )->count = 0;
+    while( ( *supportedCommands )->count < numCommands )
+    {
+        // Now get the command structures for all of them.
+        rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
+                TPM_CAP_COMMANDS, commandCode,
+                numCommands - ( *supportedCommands )->count, &moreData, &capabilityData, 0 );
+
+        if( rval != TPM_RC_SUCCESS ||
+                capabilityData.capability != TPM_CAP_COMMANDS  ||
+                capabilityData.data.command.count < 1 )
+        {
+            break;
+        }
+
+        for( i = 0; i < capabilityData.data.command.count &&
+                ( *supportedCommands )->count < numCommands; i++ )
+        {
+            ( *supportedCommands )->commandAttributes[( *supportedCommands )->count++].val =
+                    capabilityData.data.command.commandAttributes[i].val;
+        }
+        commandCode = capabilityData.data.command.commandAttributes[i - 1].commandIndex + 1;
+    }
+
+    return rval;
+}
+
+// Get the TPM 2.0 commands supported by the TPM.
+TSS2_RC GetCommands( TSS2_SYS_CONTEXT *resMgrSysContext, TPML_CCA **supportedCommands )
+{
+    TPMS_CAPABILITY_DATA capabilityData;
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+
     // First get the number of commands
     rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
             TPM_CAP_TPM_PROPERTIES, TPM_PT_TOTAL_COMMANDS,
@@ -49,48 +101,75 @@ TSS2_RC GetCommands( TSS2_SYS_CONTEXT *resMgrSysContext, TPML_CCA **supportedCom
             capabilityData.data.tpmProperties.count == 1 &&
             capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_TOTAL_COMMANDS )
     {
-        numCommands = capabilityData.data.tpmProperties.tpmProperty[0].value;
-    }
-    else
-    {
-        goto returnFromGetCommands;
+        rval = ReadCommands( resMgrSysContext, capabilityData.data.tpmProperties.tpmProperty[0].value,
+                supportedCommands );
     }
 
-    // Allocate memory for them
-    *supportedCommands = (TPML_CCA *)malloc( numCommands * sizeof( TPMA_CC ) + sizeof( UINT32 ) );
-    if( !*supportedCommands )
-    {
-        rval = TSS2_BASE_RC_INSUFFICIENT_BUFFER + TSS2_RESMGR_ERROR_LEVEL;
-        goto returnFromGetCommands;
-    }
+    return rval;
+}
 
-    for( commandPtr = &( ( *supportedCommands )->commandAttributes[0] ), ( *supportedCommands )->count = 0;
-            ( *supportedCommands )->count < numCommands;
-            ( *supportedCommands )->count += capabilityData.data.command.count,
-                    commandPtr += capabilityData.data.command.count )
-    {
-        // Now get the command structures for all of them.
-        rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-                TPM_CAP_COMMANDS, TPM_CC_FIRST,
-                numCommands, &moreData, &capabilityData, 0 );
+static UINT8 LoadCommandCache( const char *cacheFile, const COMMAND_CACHE_HEADER *key, TPML_CCA **supportedCommands )
+{
+    COMMAND_CACHE_HEADER header;
+    FILE *file;
+    UINT8 loaded = 0;
 
-        if( rval == TPM_RC_SUCCESS &&
-                capabilityData.capability == TPM_CAP_COMMANDS  &&
-                capabilityData.data.command.count >= 1 )
-        {
-            for( i = 0; i < capabilityData.data.command.count; i ++ )
-            {
-                commandPtr[ ( *supportedCommands )->count + i ].val =
-                        capabilityData.data.command.commandAttributes[i].val;
-            }
-        }
-        else
+    file = fopen( cacheFile, "rb" );
+    if( file == 0 )
+        return 0;
+
+    if( fread( &header, sizeof( header ), 1, file ) == 1 &&
+            0 == memcmp( &header, key, sizeof( header ) ) )
+    {
+        *supportedCommands = (TPML_CCA *)malloc( key->count * sizeof( TPMA_CC ) + sizeof( UINT32 ) );
+        if( *supportedCommands != 0 )
         {
-            break;
+            ( *supportedCommands )->count = key->count;
+            loaded = fread( &( *supportedCommands )->commandAttributes[0], sizeof( TPMA_CC ), key->count, file ) == key->count;
+            if( !loaded )
+                free( *supportedCommands );
         }
     }
 
-returnFromGetCommands:
+    fclose( file );
+    return loaded;
+}
+
+static void SaveCommandCache( const char *cacheFile, const COMMAND_CACHE_HEADER *key, TPML_CCA *supportedCommands )
+{
+    FILE *file;
+
+    file = fopen( cacheFile, "wb" );
+    if( file == 0 )
+        return;
+
+    // A cache cut short won't load, so there is no need to check.
+    fwrite( key, sizeof( *key ), 1, file );
+    fwrite( &supportedCommands->commandAttributes[0], sizeof( TPMA_CC ), supportedCommands->count, file );
+    fclose( file );
+}
+
+//
+// Same as GetCommands, but the TPM's answer is kept in cacheFile.  The
+// command attributes of a TPM model only change with its firmware, so a
+// later call for a TPM from the same manufacturer with the same firmware
+// version reads them back without asking the TPM.  numCommands is the
+// TPM's TPM_PT_TOTAL_COMMANDS.
+//
+TSS2_RC GetCommandsCached( TSS2_SYS_CONTEXT *resMgrSysContext, const char *cacheFile,
+        UINT32 manufacturer, UINT32 firmwareVersion1, UINT32 firmwareVersion2,
+        UINT32 numCommands, TPML_CCA **supportedCommands )
+{
+    COMMAND_CACHE_HEADER key = { COMMAND_CACHE_MAGIC, manufacturer, firmwareVersion1, firmwareVersion2, numCommands };
+    TSS2_RC rval;
+
+    if( cacheFile != 0 && LoadCommandCache( cacheFile, &key, supportedCommands ) )
+        return TSS2_RC_SUCCESS;
+
+    rval = ReadCommands( resMgrSysContext, numCommands, supportedCommands );
+    if( rval == TSS2_RC_SUCCESS && cacheFile != 0 && ( *supportedCommands )->count == numCommands )
+        SaveCommandCache( cacheFile, &key, *supportedCommands );
+
     return rval;
 }
 
@@ -31,6 +31,7 @@
 #include <sapi/tpm20.h>
 #include <tcti/tcti_device.h>
 #include <tcti/tcti_socket.h>
+#include <tcti/tcti_trace.h>
 #include "tcti_util.h"
 #include "resourcemgr.h"
 //#include <sample.h>
@@ -38,11 +39,13 @@
 #include "sysapi_util.h"
 #include "syscontext.h"
 #include "debug.h"
+#include "asynclog.h"
+#include "rmstore.h"
 
 #if defined(_WIN32)
 
 typedef HANDLE THREAD_TYPE;
-#define MAX_COMMAND_LINE_ARGS 6
+#define MAX_COMMAND_LINE_ARGS 20
 
 #elif defined(__linux__) || defined(__unix__)
 
@@ -57,9 +60,9 @@ typedef pthread_t THREAD_TYPE ;
 #define CloseHandle( handle )
 
 #ifdef DEBUG
-#define MAX_COMMAND_LINE_ARGS 9
+#define MAX_COMMAND_LINE_ARGS 27
 #else
-#define MAX_COMMAND_LINE_ARGS 7
+#define MAX_COMMAND_LINE_ARGS 25
 #endif
 
 #else
@@ -74,6 +77,9 @@ TPM_MUTEX tpmMutex;
 int debugLevel = 0xff;
 
 extern TSS2_RC GetCommands( TSS2_SYS_CONTEXT *resMgrSysContext, TPML_CCA **supportedCommands );
+extern TSS2_RC GetCommandsCached( TSS2_SYS_CONTEXT *resMgrSysContext, const char *cacheFile,
+        UINT32 manufacturer, UINT32 firmwareVersion1, UINT32 firmwareVersion2,
+        UINT32 numCommands, TPML_CCA **supportedCommands );
 extern UINT8 GetCommandAttributes( TPM_CC commandCode, TPML_CCA *supportedCommands, TPMA_CC *cmdAttributes );
 
 char otherCmdStr[] = "Other CMD";
@@ -218,16 +224,7 @@ TSS2_RC ResmgrFixupErrorlevel( TSS2_RC errCode )
     if( responseRval != TSS2_RC_SUCCESS ) goto exitLoc;
 
 #define RESMGR_UNMARSHAL_TPMS_CONTEXT( buffer, size, currentPtr, value, rval, exitLoc ) \
-    Unmarshal_UINT64( (buffer), (size), (currentPtr), &( (value)->sequence ), (rval) ); \
-    responseRval = ResmgrFixupErrorlevel( *rval ); \
-	if( responseRval != TSS2_RC_SUCCESS ) goto exitLoc; \
-    Unmarshal_UINT32( (buffer), (size), (currentPtr), &( (value)->savedHandle ), (rval) ); \
-    responseRval = ResmgrFixupErrorlevel( *rval ); \
-    if( responseRval != TSS2_RC_SUCCESS ) goto exitLoc; \
-    Unmarshal_UINT32( (buffer), (size), (currentPtr), &( (value)->hierarchy ), (rval) ); \
-    responseRval = ResmgrFixupErrorlevel( *rval ); \
-    if( responseRval != TSS2_RC_SUCCESS ) goto exitLoc; \
-    Unmarshal_Simple_TPM2B_NoSizeCheck( (buffer), (size), (currentPtr), (TPM2B *)&( (value)->contextBlob ), (rval) ); \
+    Unmarshal_Table( (buffer), (size), (currentPtr), &MarshalType_TPMS_CONTEXT, (value), (rval) ); \
     responseRval = ResmgrFixupErrorlevel( *rval ); \
     if( responseRval != TSS2_RC_SUCCESS ) goto exitLoc;
 
@@ -305,11 +302,37 @@ typedef struct RESOURCE_MANAGER_ENTRY_STRUCT {
                                     //  flushed.
     UINT64 connectionId;            // Used to identify which connection owns the object,
                                     // sequence, or session.
+    UINT8 backend;                  // Index in backends of the TPM that holds the object,
+                                    // sequence, or session.
+    UINT64 token;                   // Reattach token of the owning connection; 0 if none.
     RESOURCE_MANAGER_ENTRY_PTR nextEntry; // Next entry in the list; 0 to terminate list.
 } RESOURCE_MANAGER_ENTRY;
 
 RESOURCE_MANAGER_ENTRY_PTR entryList = 0;
 
+// Owner of restored entries until a client reattaches to them.
+#define RESTORED_CONNECTION_ID 0xffffffffffffffffULL
+
+//
+// Connections that have a reattach token.  Their entries carry the token
+// in the store, for a client that reconnects to a restarted RM.
+//
+typedef struct RESMGR_CONNECTION_STRUCT {
+    UINT64 connectionId;
+    UINT64 token;
+    struct RESMGR_CONNECTION_STRUCT *next;
+} RESMGR_CONNECTION;
+
+static RESMGR_CONNECTION *connectionList = 0;
+
+// storeDirty is set when an entry for the primary changes, and cleared
+// when the table is next written to the store.  The primary's boot counts
+// are read again after it has been started up.
+static UINT8 storeOpen = 0;
+static UINT8 storeDirty = 0;
+static UINT8 storeClockStale = 1;
+static RM_STORE_STATE storeState;
+
 typedef struct
 {
     TPM_HANDLE sessionHandle;
@@ -362,6 +385,74 @@ static UINT32 maxActiveSessions;
 static UINT32 gapMaxValue;
 static UINT32 activeSessionCount = 0;
 
+// Command last sent downstream, kept so that it can be resent as is.
+static uint8_t *sentCommandBuffer;
+static size_t sentCommandSize;
+
+//
+// When the response to a command is due, in NowMs() time; due is 0 if it
+// has no timeout.  Once the command has been canceled, due is when the RM
+// gives up on it, and abandoned is set if it does.
+//
+typedef struct {
+    UINT64 due;
+    UINT8 canceled;
+    UINT8 abandoned;
+} COMMAND_DEADLINE;
+
+// For the command in progress.
+static COMMAND_DEADLINE commandDeadline;
+
+typedef struct {
+    TPM_CC commandCode;
+    UINT32 timeoutMs;
+} COMMAND_TIMEOUT;
+
+UINT32 rmDefaultCommandTimeoutMs = 0;
+UINT32 rmCancelWaitMs = RESMGR_DEFAULT_CANCEL_WAIT_MS;
+static COMMAND_TIMEOUT commandTimeouts[RESMGR_MAX_COMMAND_TIMEOUTS];
+static UINT32 commandTimeoutCount = 0;
+
+const char *rmCommandCacheFile = 0;
+
+UINT32 rmRetryLimit = RESMGR_DEFAULT_RETRY_LIMIT;
+UINT32 rmRetryInitialSleepUs = RESMGR_DEFAULT_RETRY_INITIAL_SLEEP_US;
+UINT32 rmRetryMaxSleepUs = RESMGR_DEFAULT_RETRY_MAX_SLEEP_US;
+
+static RESMGR_STATS rmStats;
+
+//
+// A downstream TPM.  The RM's tables cover all of them, under tpmMutex;
+// each also has a mutex of its own, held while a command runs on it, so
+// that stateless commands can run on it without tpmMutex.  load counts
+// the commands running on or waiting for it.
+//
+typedef struct {
+    TSS2_TCTI_CONTEXT *tctiContext;
+    TSS2_SYS_CONTEXT *sysContext;
+    TPM_MUTEX mutex;
+    UINT32 load;
+    UINT64 commands;
+    RESMGR_STATS stats;         // for stateless commands
+    UINT32 loadedSessions;      // nonzero if sessions may be loaded
+    UINT8 responsePending;      // the TPM owes the answer to a command given up on
+    UINT8 flushPending;         // what that command left loaded is to be flushed
+} RESMGR_BACKEND;
+
+#define LEAST_LOADED_BACKEND 0xffffffff
+
+static RESMGR_BACKEND backends[RESMGR_MAX_BACKENDS];
+static UINT32 backendCount = 0;
+
+// Backend of the command in progress under tpmMutex; the primary otherwise.
+static UINT32 currentBackend = 0;
+
+// Guards load and commands, and where the search for the least loaded
+// backend starts, so that equally loaded backends take turns.
+static TPM_MUTEX backendLoadMutex;
+static UINT32 nextBackend = 0;
+static char backendMutexStr[] = "backend";
+
 void  SetDebug( int debugLevel )
 {
     if( debugLevel == 0 )
@@ -452,6 +543,9 @@ UINT8 IsObjectHandle( TPM_HANDLE handle )
 TPM_HANDLE freedSessionHandles[FREED_HANDLE_ARRAY_SIZE];
 TPM_HANDLE freedObjectHandles[FREED_HANDLE_ARRAY_SIZE];
 
+static UINT32 lastSessionVirtualHandle = 0xffffffff;
+static UINT32 lastObjectVirtualHandle = 0xffffffff;
+
 // This code keeps track of freed virtual handles.
 // If no empty slot is available, the virtual handle
 // will be lost.
@@ -491,8 +585,6 @@ TSS2_RC	GetNewVirtualHandle( TPM_HANDLE realHandle, TPM_HANDLE *newVirtualHandle
     TSS2_RC rval = TSS2_RC_SUCCESS;
     int i;
 
-    static UINT32 lastSessionVirtualHandle = 0xffffffff;
-    static UINT32 lastObjectVirtualHandle = 0xffffffff;
     UINT8 foundReclaimedHandle = 0;
 
     UINT32 *lastVirtualHandle;
@@ -546,6 +638,43 @@ TSS2_RC	GetNewVirtualHandle( TPM_HANDLE realHandle, TPM_HANDLE *newVirtualHandle
     return rval;
 }
 
+// Takes a virtual handle restored from the store out of the ones
+// GetNewVirtualHandle hands out.
+static void ClaimVirtualHandle( TPM_HANDLE virtualHandle )
+{
+    UINT32 *lastVirtualHandle;
+    TPM_HANDLE *freedHandleArray;
+    UINT32 handleNum = virtualHandle & MAX_VIRTUAL_HANDLE;
+    int i;
+
+    if( IsSessionHandle( virtualHandle ) )
+    {
+        lastVirtualHandle = &lastSessionVirtualHandle;
+        freedHandleArray = freedSessionHandles;
+    }
+    else if( IsObjectHandle( virtualHandle ) )
+    {
+        lastVirtualHandle = &lastObjectVirtualHandle;
+        freedHandleArray = freedObjectHandles;
+    }
+    else
+    {
+        return;
+    }
+
+    for( i = 0; i < FREED_HANDLE_ARRAY_SIZE; i++ )
+    {
+        if( freedHandleArray[i] != UNAVAILABLE_FREED_HANDLE &&
+                ( freedHandleArray[i] & MAX_VIRTUAL_HANDLE ) == handleNum )
+        {
+            freedHandleArray[i] = UNAVAILABLE_FREED_HANDLE;
+        }
+    }
+
+    if( *lastVirtualHandle == 0xffffffff || handleNum > *lastVirtualHandle )
+        *lastVirtualHandle = handleNum;
+}
+
 void SetRmErrorLevel( TSS2_RC *rval, TSS2_RC errorLevel )
 {
     if( ( ( *rval & TSS2_ERROR_LEVEL_MASK ) == TSS2_SYS_ERROR_LEVEL ) || ( *rval & TSS2_ERROR_LEVEL_MASK ) != 0 )
@@ -579,14 +708,362 @@ void PrintRMTables()
     DebugPrintf( NO_PREFIX, "RM entryList:\n" );
     for( i = 0, entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry, i++ )
     {
-        DebugPrintf( NO_PREFIX, "Entry: #%d, loaded: %d, virtual/real/parent handle: %8.8x/%8.8x/%8.8x, hierarchy: %8.8x, sequence: %016llX, connectionId: 0x%x\n",
+        DebugPrintf( NO_PREFIX, "Entry: #%d, loaded: %d, virtual/real/parent handle: %8.8x/%8.8x/%8.8x, hierarchy: %8.8x, sequence: %016llX, connectionId: 0x%x, backend: %d\n",
                 i, entryPtr->status.loaded, entryPtr->virtualHandle, entryPtr->realHandle, entryPtr->parentHandle,
-                entryPtr->hierarchy, entryPtr->context.sequence, entryPtr->connectionId );
+                entryPtr->hierarchy, entryPtr->context.sequence, entryPtr->connectionId, entryPtr->backend );
+    }
+
+    for( i = 0; i < (int)backendCount; i++ )
+    {
+        DebugPrintf( NO_PREFIX, "Backend #%d: commands: %llu, stateless: %llu\n",
+                i, backends[i].commands, backends[i].stats.commands );
     }
 
     DebugPrintf( NO_PREFIX, "lastSessionSequenceNum = %8.8llx\n", lastSessionSequenceNum );
+    DebugPrintf( NO_PREFIX, "commands: %llu, retried: %llu, retries: %llu, retries exhausted: %llu, retry sleep: %llu us, timeouts: %llu, abandoned: %llu\n",
+            rmStats.commands, rmStats.retriedCommands, rmStats.retries,
+            rmStats.retriesExhausted, rmStats.retrySleepUs, rmStats.timeouts,
+            rmStats.abandoned );
+}
+#endif
+
+// Stateless commands are counted under their backends' mutexes, not
+// tpmMutex, so while they run the totals may be a command or two behind.
+void ResMgrGetStats( RESMGR_STATS *stats )
+{
+    UINT32 i;
+
+    *stats = rmStats;
+    for( i = 0; i < backendCount; i++ )
+    {
+        stats->commands += backends[i].stats.commands;
+        stats->retriedCommands += backends[i].stats.retriedCommands;
+        stats->retries += backends[i].stats.retries;
+        stats->retriesExhausted += backends[i].stats.retriesExhausted;
+        stats->retrySleepUs += backends[i].stats.retrySleepUs;
+        stats->timeouts += backends[i].stats.timeouts;
+        stats->abandoned += backends[i].stats.abandoned;
+    }
+}
+
+TSS2_RC ResMgrSetCommandTimeout( TPM_CC commandCode, UINT32 timeoutMs )
+{
+    UINT32 i;
+
+    for( i = 0; i < commandTimeoutCount; i++ )
+    {
+        if( commandTimeouts[i].commandCode == commandCode )
+            break;
+    }
+
+    if( i == RESMGR_MAX_COMMAND_TIMEOUTS )
+        return TSS2_RESMGR_TOO_MANY_TIMEOUTS;
+
+    commandTimeouts[i].commandCode = commandCode;
+    commandTimeouts[i].timeoutMs = timeoutMs;
+    if( i == commandTimeoutCount )
+        commandTimeoutCount++;
+
+    return TSS2_RC_SUCCESS;
+}
+
+UINT32 ResMgrGetCommandTimeout( TPM_CC commandCode )
+{
+    UINT32 i;
+
+    for( i = 0; i < commandTimeoutCount; i++ )
+    {
+        if( commandTimeouts[i].commandCode == commandCode )
+            return commandTimeouts[i].timeoutMs;
+    }
+
+    return rmDefaultCommandTimeoutMs;
+}
+
+static UINT64 NowMs()
+{
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+// The caller's receive timeout, shortened if the command's deadline comes
+// first, in which case *deadlineLimited is set.
+static int32_t ReceiveTimeout( UINT64 deadline, int32_t timeout, UINT8 *deadlineLimited )
+{
+    UINT64 now;
+    int32_t remaining;
+
+    *deadlineLimited = 0;
+    if( deadline == 0 )
+        return timeout;
+
+    now = NowMs();
+    remaining = deadline > now ? (int32_t)( deadline - now ) : 0;
+    if( timeout == TSS2_TCTI_TIMEOUT_BLOCK || remaining < timeout )
+    {
+        *deadlineLimited = 1;
+        return remaining;
+    }
+
+    return timeout;
+}
+
+static void RetrySleep( UINT32 microseconds )
+{
+#ifdef _WIN32
+    Sleep( ( microseconds + 999 ) / 1000 );
+#else
+    struct timespec interval;
+
+    interval.tv_sec = microseconds / 1000000;
+    interval.tv_nsec = ( microseconds % 1000000 ) * 1000;
+    nanosleep( &interval, 0 );
+#endif
+}
+
+// These mean the TPM didn't execute the command and it can be sent again.
+static UINT8 RetryableResponse( const uint8_t *response_buffer, size_t response_size )
+{
+    TPM_RC responseCode;
+
+    if( response_size < sizeof( TPM20_ErrorResponse ) )
+        return 0;
+
+    responseCode = CHANGE_ENDIAN_DWORD( ( (TPM20_ErrorResponse *)response_buffer )->responseCode );
+    return responseCode == TPM_RC_RETRY || responseCode == TPM_RC_YIELDED ||
+            responseCode == TPM_RC_TESTING;
+}
+
+static UINT32 FormatErrorResponse( TSS2_RC responseCode, uint8_t *response_buffer );
+
+//
+// Receives the response to the command just sent to a TPM.  While the TPM
+// answers TPM_RC_RETRY, TPM_RC_YIELDED or TPM_RC_TESTING the command is
+// resent as is, and once the deadline passes the command is canceled.  If
+// the TPM ignores that too, the RM gives up on the command: the response
+// is made TPM_RC_CANCELED and deadline->abandoned is set, the TPM's own
+// answer being still to come.
+//
+static TSS2_RC ReceiveWithRetries(
+    TSS2_TCTI_CONTEXT *tpmTctiContext,
+    TPM_CC commandCode,
+    uint8_t *command_buffer,
+    size_t command_size,
+    uint8_t *response_buffer,
+    size_t *response_size,
+    int32_t timeout,
+    COMMAND_DEADLINE *deadline,
+    RESMGR_STATS *stats )
+{
+    TSS2_RC rval;
+    size_t bufferSize = *response_size;
+    UINT32 retries = 0;
+    UINT32 sleepUs = rmRetryInitialSleepUs;
+    UINT8 deadlineLimited;
+
+    for( ;; )
+    {
+        // Receive response from TPM.
+        *response_size = bufferSize;
+        rval = tss2_tcti_receive( tpmTctiContext, response_size, response_buffer,
+                ReceiveTimeout( deadline->due, timeout, &deadlineLimited ) );
+        if( rval == TSS2_TCTI_RC_TRY_AGAIN && deadlineLimited && deadline->canceled )
+        {
+            // A wedged TPM mustn't hold up every other client.
+            DebugPrintf( NO_PREFIX, "%s not canceled after %u ms, giving up on it\n",
+                    strTpmCommandCode( commandCode ), rmCancelWaitMs );
+            stats->abandoned++;
+            deadline->due = 0;
+            deadline->abandoned = 1;
+            *response_size = FormatErrorResponse( TPM_RC_CANCELED, response_buffer );
+            rval = TSS2_RC_SUCCESS;
+            break;
+        }
+        if( rval == TSS2_TCTI_RC_TRY_AGAIN && deadlineLimited )
+        {
+            // The command is overdue.  Cancel it and wait for the
+            // TPM's answer, normally TPM_RC_CANCELED: until it
+            // comes the TPM holds the contexts loaded for the
+            // command.
+            DebugPrintf( NO_PREFIX, "%s timed out, canceling it\n", strTpmCommandCode( commandCode ) );
+            stats->timeouts++;
+            deadline->canceled = 1;
+            deadline->due = ( rmCancelWaitMs != 0 ) ? NowMs() + rmCancelWaitMs : 0;
+            tss2_tcti_cancel( tpmTctiContext );
+            continue;
+        }
+        if( rval != TSS2_RC_SUCCESS || !RetryableResponse( response_buffer, *response_size ) )
+            break;
+
+        // Resend the command, handles already virtualized and
+        // contexts still loaded, while we hold the TPM rather
+        // than make the client queue for it again.
+        if( retries == rmRetryLimit )
+        {
+            stats->retriesExhausted++;
+            break;
+        }
+        if( retries++ == 0 )
+            stats->retriedCommands++;
+        stats->retries++;
+
+        RetrySleep( sleepUs );
+        stats->retrySleepUs += sleepUs;
+        sleepUs = sleepUs * 2 < rmRetryMaxSleepUs ? sleepUs * 2 : rmRetryMaxSleepUs;
+
+        rval = tss2_tcti_transmit( tpmTctiContext, command_size, command_buffer );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            *response_size = 0;
+            break;
+        }
+    }
+
+    return rval;
 }
+
+static TSS2_RC InitMutex( TPM_MUTEX *mutex )
+{
+#ifdef _WIN32
+    *mutex = CreateMutex( NULL, FALSE, NULL );
+    return ( *mutex != NULL ) ? TSS2_RC_SUCCESS : TSS2_RESMGR_INIT_FAILED;
+#else
+    return ( sem_init( mutex, 0, 1 ) == 0 ) ? TSS2_RC_SUCCESS : TSS2_RESMGR_INIT_FAILED;
 #endif
+}
+
+// The first backend added is the primary.
+TSS2_RC ResMgrAddBackend( TSS2_TCTI_CONTEXT *tctiContext )
+{
+    RESMGR_BACKEND *backend;
+    TSS2_RC rval;
+
+    if( backendCount == RESMGR_MAX_BACKENDS )
+        return TSS2_RESMGR_TOO_MANY_BACKENDS;
+
+    if( backendCount == 0 )
+    {
+        rval = InitMutex( &backendLoadMutex );
+        if( rval != TSS2_RC_SUCCESS )
+            return rval;
+    }
+
+    backend = &backends[backendCount];
+    rval = InitMutex( &backend->mutex );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    // Used to send RM specific TPM commands to the TPM.
+    backend->sysContext = InitSysContext( 0, tctiContext, &abiVersion );
+    if( backend->sysContext == 0 )
+        return TSS2_RESMGR_INIT_SYS_CONTEXT_FAILED;
+
+    backend->tctiContext = tctiContext;
+    if( backendCount == 0 )
+    {
+        downstreamTctiContext = tctiContext;
+        resMgrSysContext = backend->sysContext;
+    }
+    backendCount++;
+
+    return TSS2_RC_SUCCESS;
+}
+
+// Makes the RM's own TPM commands go to a backend.
+static void SelectBackend( UINT32 backend )
+{
+    currentBackend = backend;
+    downstreamTctiContext = backends[backend].tctiContext;
+    resMgrSysContext = backends[backend].sysContext;
+}
+
+//
+// Waits for a backend, counting the wait in its load.  If *backend is
+// LEAST_LOADED_BACKEND, it is set to the backend with the least load;
+// equally loaded ones take turns.
+//
+static TSS2_RC AcquireBackend( UINT32 *backend )
+{
+    TSS2_RC rval;
+    UINT32 i, candidate;
+
+    rval = StartCriticalSection( &backendLoadMutex, &backendMutexStr[0] );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    if( *backend == LEAST_LOADED_BACKEND )
+    {
+        *backend = nextBackend % backendCount;
+        for( i = 1; i < backendCount; i++ )
+        {
+            candidate = ( nextBackend + i ) % backendCount;
+            if( backends[candidate].load < backends[*backend].load )
+                *backend = candidate;
+        }
+        nextBackend = *backend + 1;
+    }
+    backends[*backend].load++;
+    backends[*backend].commands++;
+
+    EndCriticalSection( &backendLoadMutex, &backendMutexStr[0] );
+
+    rval = StartCriticalSection( &backends[*backend].mutex, &backendMutexStr[0] );
+    if( rval != TSS2_RC_SUCCESS &&
+            StartCriticalSection( &backendLoadMutex, &backendMutexStr[0] ) == TSS2_RC_SUCCESS )
+    {
+        backends[*backend].load--;
+        EndCriticalSection( &backendLoadMutex, &backendMutexStr[0] );
+    }
+
+    return rval;
+}
+
+static void ReleaseBackend( UINT32 backend )
+{
+    EndCriticalSection( &backends[backend].mutex, &backendMutexStr[0] );
+
+    if( StartCriticalSection( &backendLoadMutex, &backendMutexStr[0] ) == TSS2_RC_SUCCESS )
+    {
+        backends[backend].load--;
+        EndCriticalSection( &backendLoadMutex, &backendMutexStr[0] );
+    }
+}
+
+//
+// A backend whose TPM owes the answer to a command the RM gave up on is out
+// of use until the answer comes; this looks for it without waiting.  The
+// caller holds the backend.
+//
+static TSS2_RC CheckBackendResponsive( UINT32 backend )
+{
+    uint8_t *response;
+    size_t responseSize = maxRspSize;
+    TSS2_RC rval;
+
+    if( !backends[backend].responsePending )
+        return TSS2_RC_SUCCESS;
+
+    response = (*rmMalloc)( maxRspSize );
+    if( response == 0 )
+        return TSS2_RESMGR_MEMALLOC_FAILED;
+    rval = tss2_tcti_receive( backends[backend].tctiContext, &responseSize, response,
+            TSS2_TCTI_TIMEOUT_NONE );
+    (*rmFree)( response );
+    if( rval == TSS2_TCTI_RC_TRY_AGAIN )
+        return TSS2_RESMGR_BACKEND_UNRESPONSIVE;
+
+    // Whatever the answer, nobody is waiting for it any more.
+    DebugPrintf( NO_PREFIX, "Resource Mgr backend #%d has answered\n", backend );
+    backends[backend].responsePending = 0;
+
+    return TSS2_RC_SUCCESS;
+}
 
 TSS2_RC TestForLoadedHandles()
 {
@@ -656,25 +1133,26 @@ UINT8 PersistentHandle( TPM_HANDLE handle )
         return 0;
 }
 
-TSS2_RC FlushAllLoadedHandles()
+//
+// Flushes the handles of one type loaded in the TPM.  Each GetCapability
+// asks for as many as a response holds, and is only repeated if the TPM
+// had more.
+//
+static TSS2_RC FlushLoadedHandlesFrom( TPM_HANDLE firstHandle )
 {
     TPMS_CAPABILITY_DATA capabilityData;
     TSS2_RC rval = TSS2_RC_SUCCESS;
     TPMI_YES_NO moreData;
     UINT32 i;
 
-    ENABLE_RM_TPM_CMD_DEBUG_MSGS;
-
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_HANDLES, TRANSIENT_FIRST,
-            20, &moreData, &capabilityData, 0 );
-    if( rval != TSS2_RC_SUCCESS )
-        goto endFlushAllLoadedHandles;
-
-    if( capabilityData.data.handles.count != 0 )
+    do
     {
-        DebugPrintf( NO_PREFIX, "Flush loaded transient object handles: \n" );
-        DebugPrintf( NO_PREFIX, "" );
+        rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
+                TPM_CAP_HANDLES, firstHandle,
+                MAX_CAP_HANDLES, &moreData, &capabilityData, 0 );
+        if( rval != TSS2_RC_SUCCESS )
+            return rval;
+
         for( i = 0; i < capabilityData.data.handles.count; i++ )
         {
             DebugPrintf( NO_PREFIX, "0x%8x, ", capabilityData.data.handles.handle[i] );
@@ -682,32 +1160,38 @@ TSS2_RC FlushAllLoadedHandles()
             if( rval != TSS2_RC_SUCCESS )
             {
                 SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-                goto endFlushAllLoadedHandles;
+                return rval;
             }
         }
-        DebugPrintf( NO_PREFIX, "\n" );
-    }
+    } while( moreData == YES && capabilityData.data.handles.count != 0 );
 
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_HANDLES, LOADED_SESSION_FIRST,
-            20, &moreData, &capabilityData, 0 );
+    return rval;
+}
+
+//
+// The count of loaded sessions read when the backend was brought up saves
+// asking for their handles when there are none, which is the usual case:
+// the RM context saves every session after each command.
+//
+TSS2_RC FlushAllLoadedHandles()
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+
+    ENABLE_RM_TPM_CMD_DEBUG_MSGS;
+
+    DebugPrintf( NO_PREFIX, "Flush loaded transient object handles: \n" );
+    rval = FlushLoadedHandlesFrom( TRANSIENT_FIRST );
+    DebugPrintf( NO_PREFIX, "\n" );
     if( rval != TSS2_RC_SUCCESS )
         goto endFlushAllLoadedHandles;
 
-    if( capabilityData.data.handles.count != 0 )
+    if( backends[currentBackend].loadedSessions != 0 )
     {
         DebugPrintf( NO_PREFIX, "Flush loaded session handles: \n" );
-        for( i = 0; i < capabilityData.data.handles.count; i++ )
-        {
-            DebugPrintf( NO_PREFIX, "0x%8x, ", capabilityData.data.handles.handle[i] );
-            rval = Tss2_Sys_FlushContext( resMgrSysContext, capabilityData.data.handles.handle[i] );
-            if( rval != TSS2_RC_SUCCESS )
-            {
-                SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-                goto endFlushAllLoadedHandles;
-            }
-        }
+        rval = FlushLoadedHandlesFrom( LOADED_SESSION_FIRST );
         DebugPrintf( NO_PREFIX, "\n" );
+        if( rval == TSS2_RC_SUCCESS )
+            backends[currentBackend].loadedSessions = 0;
     }
 
 endFlushAllLoadedHandles:
@@ -717,19 +1201,48 @@ endFlushAllLoadedHandles:
 }
 
 
-
-TSS2_RC AddEntry( TPM_HANDLE virtualHandle, TPM_HANDLE realHandle, TPM_HANDLE parentHandle,
-    TPMI_RH_HIERARCHY hierarchy, UINT64 connectionId )
+static RESMGR_CONNECTION *FindConnection( UINT64 connectionId )
 {
-    RESOURCE_MANAGER_ENTRY_PTR *entryPtr, newEntry;
+    RESMGR_CONNECTION *connection;
 
-    // Find end of list
-    for( entryPtr = &entryList; *entryPtr != 0; entryPtr = &( (*entryPtr)->nextEntry ) )
-        ;
+    for( connection = connectionList; connection != 0; connection = connection->next )
+    {
+        if( connection->connectionId == connectionId )
+            break;
+    }
 
-    // Allocate space for new record
-    newEntry = (*rmMalloc)( sizeof( RESOURCE_MANAGER_ENTRY ) );
-    if( newEntry == 0 )
+    return connection;
+}
+
+static void ForgetConnection( UINT64 connectionId )
+{
+    RESMGR_CONNECTION **connectionPtr, *connection;
+
+    for( connectionPtr = &connectionList; *connectionPtr != 0; connectionPtr = &( (*connectionPtr)->next ) )
+    {
+        if( (*connectionPtr)->connectionId == connectionId )
+        {
+            connection = *connectionPtr;
+            *connectionPtr = connection->next;
+            (*rmFree)( connection );
+            break;
+        }
+    }
+}
+
+TSS2_RC AddEntry( TPM_HANDLE virtualHandle, TPM_HANDLE realHandle, TPM_HANDLE parentHandle,
+    TPMI_RH_HIERARCHY hierarchy, UINT64 connectionId )
+{
+    RESOURCE_MANAGER_ENTRY_PTR *entryPtr, newEntry;
+    RESMGR_CONNECTION *connection;
+
+    // Find end of list
+    for( entryPtr = &entryList; *entryPtr != 0; entryPtr = &( (*entryPtr)->nextEntry ) )
+        ;
+
+    // Allocate space for new record
+    newEntry = (*rmMalloc)( sizeof( RESOURCE_MANAGER_ENTRY ) );
+    if( newEntry == 0 )
         return TSS2_RESMGR_MEMALLOC_FAILED;
 
     // Populate it.
@@ -739,10 +1252,19 @@ TSS2_RC AddEntry( TPM_HANDLE virtualHandle, TPM_HANDLE realHandle, TPM_HANDLE pa
     newEntry->parentHandle = parentHandle;
     newEntry->hierarchy = hierarchy;
     newEntry->connectionId = connectionId;
+    newEntry->backend = (UINT8)currentBackend;
+    newEntry->token = 0;
     newEntry->status.loaded = 1;
     newEntry->status.stClear = 0;
     newEntry->nextEntry = 0;
 
+    connection = FindConnection( connectionId );
+    if( connection != 0 )
+        newEntry->token = connection->token;
+
+    if( currentBackend == 0 )
+        storeDirty = 1;
+
     return TSS2_RC_SUCCESS;
 }
 
@@ -767,6 +1289,9 @@ TSS2_RC RemoveEntry(RESOURCE_MANAGER_ENTRY_PTR entry)
         (*predEntryPtr)->nextEntry = entry->nextEntry;
     }
 
+    if( entry->backend == 0 )
+        storeDirty = 1;
+
     (*rmFree)(entry);
 
     return TSS2_RC_SUCCESS;
@@ -839,6 +1364,78 @@ TSS2_RC FindEntry(RESOURCE_MANAGER_ENTRY_PTR firstEntry,
         return TSS2_RC_SUCCESS;
 }
 
+static TSS2_RC ReadBootCounts()
+{
+    TPMS_TIME_INFO currentTime;
+    TSS2_RC rval;
+
+    rval = Tss2_Sys_ReadClock( resMgrSysContext, &currentTime );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
+        return rval;
+    }
+
+    storeState.resetCount = currentTime.clockInfo.resetCount;
+    storeState.restartCount = currentTime.clockInfo.restartCount;
+    storeClockStale = 0;
+
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Writes the primary's entries to the store if they have changed.  The
+// caller holds the primary backend.  A table too big for the store is
+// written as an empty one rather than left stale.
+//
+static TSS2_RC SaveStore()
+{
+    RESOURCE_MANAGER_ENTRY_PTR entryPtr;
+    UINT32 count = 0, i = 0;
+    TSS2_RC rval;
+
+    if( !storeOpen || !storeDirty )
+        return TSS2_RC_SUCCESS;
+
+    if( storeClockStale )
+    {
+        rval = ReadBootCounts();
+        if( rval != TSS2_RC_SUCCESS )
+            return rval;
+    }
+
+    for( entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry )
+    {
+        if( entryPtr->backend == 0 )
+            count++;
+    }
+
+    if( RmStoreBegin( count ) == 0 )
+    {
+        DebugPrintf( NO_PREFIX, "Resource Mgr table too big for store: %d entries\n", count );
+        count = 0;
+        if( RmStoreBegin( 0 ) == 0 )
+            return TSS2_RESMGR_STORE_FAILED;
+    }
+    else
+    {
+        for( entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry )
+        {
+            if( entryPtr->backend != 0 )
+                continue;
+
+            RmStorePut( i++, entryPtr->virtualHandle, entryPtr->realHandle, entryPtr->parentHandle,
+                    entryPtr->hierarchy, entryPtr->token, entryPtr->status.stClear, &entryPtr->context );
+        }
+    }
+
+    storeState.lastSessionSequenceNum = lastSessionSequenceNum;
+    RmStoreCommit( &storeState, count );
+    storeDirty = 0;
+
+    return TSS2_RC_SUCCESS;
+}
+
 //
 // This function is used when a connection is terminated.
 // It flushes all the connection's sessions to remove
@@ -896,11 +1493,46 @@ TSS2_RC FlushSessionsAndClearTable( UINT64 connectionId )
         }
     }
 
+    ForgetConnection( connectionId );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = SaveStore();
+
     DISABLE_RM_TPM_CMD_DEBUG_MSGS;
 
     return rval;
 }
 
+//
+// Puts the tables right for a command the RM gave up on, with the TPM still
+// holding what was loaded for it.  Sessions, whose saved contexts loading
+// them used up, are dropped; objects and sequences go back to their saved
+// contexts.  The loaded copies are flushed once the TPM answers.
+//
+static void AbandonCommand()
+{
+    RESOURCE_MANAGER_ENTRY_PTR entryPtr, nextEntry;
+
+    for( entryPtr = entryList; entryPtr != 0; entryPtr = nextEntry )
+    {
+        nextEntry = entryPtr->nextEntry;
+        if( entryPtr->backend != currentBackend || !entryPtr->status.loaded )
+            continue;
+
+        if( IsSessionHandle( entryPtr->virtualHandle ) )
+        {
+            (void)RemoveEntry( entryPtr );
+            activeSessionCount--;
+        }
+        else
+        {
+            entryPtr->status.loaded = 0;
+        }
+    }
+
+    backends[currentBackend].responsePending = 1;
+    backends[currentBackend].flushPending = 1;
+}
+
 TSS2_RC EvictContext(TPM_HANDLE virtualHandle)
 {
     TSS2_RC rval = TSS2_RC_SUCCESS;
@@ -921,7 +1553,12 @@ TSS2_RC EvictContext(TPM_HANDLE virtualHandle)
         rval = Tss2_Sys_ContextSave( resMgrSysContext, foundEntryPtr->realHandle, &(foundEntryPtr->context) );
         if( rval == TSS2_RC_SUCCESS )
         {
-            lastSessionSequenceNum = foundEntryPtr->context.sequence;
+            // Sessions, and so gap handling, are the primary's alone.
+            if( currentBackend == 0 )
+            {
+                lastSessionSequenceNum = foundEntryPtr->context.sequence;
+                storeDirty = 1;
+            }
 
             if( !IsSessionHandle( virtualHandle ) )
             {
@@ -1217,23 +1854,18 @@ UINT8 HandleWeCareAbout( TPM_HANDLE handle )
     }
 }
 
+// Only the current backend's hierarchy has changed.
 void ClearHierarchy( TPMI_RH_HIERARCHY hierarchy )
 {
-    RESOURCE_MANAGER_ENTRY_PTR foundEntryPtr, nextEntry;
-    TSS2_RC rval;
+    RESOURCE_MANAGER_ENTRY_PTR entryPtr, nextEntry;
 
-    nextEntry = entryList;
-
-    while( nextEntry )
+    for( entryPtr = entryList; entryPtr != 0; entryPtr = nextEntry )
     {
-        rval = FindEntry( nextEntry, RMFIND_HIERARCHY, hierarchy, &foundEntryPtr);
-        if( rval == TSS2_RC_SUCCESS )
+        nextEntry = entryPtr->nextEntry;
+        if( entryPtr->hierarchy == hierarchy && entryPtr->backend == currentBackend )
         {
-            nextEntry = foundEntryPtr->nextEntry;
-            (void) RemoveEntry( foundEntryPtr );
+            (void) RemoveEntry( entryPtr );
         }
-        else
-            break;
     }
 }
 
@@ -1242,11 +1874,21 @@ UINT8 GetStClear( TPM2B_PUBLIC *inPublic )
     return( inPublic->t.publicArea.objectAttributes.stClear );
 }
 
+// Returns the size of the response.
+static UINT32 FormatErrorResponse( TSS2_RC responseCode, uint8_t *response_buffer )
+{
+    TPM20_ErrorResponse *response = (TPM20_ErrorResponse *)response_buffer;
+
+    response->tag = CHANGE_ENDIAN_WORD( TPM_ST_NO_SESSIONS );
+    response->responseSize = CHANGE_ENDIAN_DWORD( sizeof( TPM20_ErrorResponse ) );
+    response->responseCode = CHANGE_ENDIAN_DWORD( responseCode );
+
+    return sizeof( TPM20_ErrorResponse );
+}
+
 void CreateErrorResponse( TSS2_RC responseCode )
 {
-    errorResponse.tag = CHANGE_ENDIAN_WORD( TPM_ST_NO_SESSIONS );
-    errorResponse.responseSize = CHANGE_ENDIAN_DWORD( sizeof( TPM20_ErrorResponse ) );
-    errorResponse.responseCode = CHANGE_ENDIAN_DWORD( responseCode );
+    FormatErrorResponse( responseCode, (uint8_t *)&errorResponse );
 }
 
 void SendErrorResponse( SOCKET sock )
@@ -1363,12 +2005,14 @@ TSS2_RC ResourceMgrSendTpmCommand(
     TPM_ST tag;
 	UINT32 authAreaSize;
 	TPM2B_PUBLIC inPublic = { { CHANGE_ENDIAN_DWORD( sizeof( TPM2B_PUBLIC ) - 2), } };
+    UINT32 timeoutMs;
 
     RESMGR_UNMARSHAL_UINT16( command_buffer, command_size, &currentPtr, &tag, &responseRval, SendCommand );
     RESMGR_UNMARSHAL_UINT32( command_buffer, command_size, &currentPtr, 0, &responseRval, SendCommand );
     RESMGR_UNMARSHAL_UINT32( command_buffer, command_size, &currentPtr, &currentCommandCode, &responseRval, SendCommand );
 
     rmErrorDuringSend = 0;
+    rmStats.commands++;
 
     //
     // DO RESOURCE MGR THINGS.
@@ -1656,6 +2300,12 @@ SendCommand:
             //
             // SEND COMMAND TO TPM.
             //
+            sentCommandBuffer = command_buffer;
+            sentCommandSize = command_size;
+            timeoutMs = ResMgrGetCommandTimeout( currentCommandCode );
+            commandDeadline.due = ( timeoutMs != 0 ) ? NowMs() + timeoutMs : 0;
+            commandDeadline.canceled = 0;
+            commandDeadline.abandoned = 0;
             rval = (((TSS2_TCTI_CONTEXT_COMMON_CURRENT *)downstreamTctiContext)->transmit)(
                     (TSS2_TCTI_CONTEXT *)downstreamTctiContext,
                     command_size, command_buffer );
@@ -1797,12 +2447,24 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
         //
         if( rval == TSS2_RC_SUCCESS )
         {
-            // Receive response from TPM.
-            rval = (((TSS2_TCTI_CONTEXT_COMMON_CURRENT *)downstreamTctiContext)->receive) (
-                    (TSS2_TCTI_CONTEXT *)downstreamTctiContext,
-                    (size_t *)response_size, response_buffer, timeout );
+            // The TCTI takes a size_t; don't let it write past our UINT32.
+            size_t receivedSize = *response_size;
 
-            if( rval == TSS2_RC_SUCCESS )
+            rval = ReceiveWithRetries( downstreamTctiContext, currentCommandCode,
+                    sentCommandBuffer, sentCommandSize, response_buffer, &receivedSize,
+                    timeout, &commandDeadline, &rmStats );
+            *response_size = (UINT32)receivedSize;
+
+            if( rval == TSS2_RC_SUCCESS && commandDeadline.abandoned )
+            {
+                // The TPM can't be asked to evict anything, and the
+                // downstream TCTI still waits for its answer, so skip
+                // straight to the made up TPM_RC_CANCELED.
+                ((TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext)->status.debugMsgEnabled = 0;
+                AbandonCommand();
+                return rval;
+            }
+            else if( rval == TSS2_RC_SUCCESS )
             {
                 ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.commandSent = 0;
                 ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->currentTctiContext = 0;
@@ -1963,6 +2625,7 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
                     }
 
                     foundEntryPtr->status.loaded = 0;
+                    storeDirty = 1;
 
                     RESMGR_UNMARSHAL_TPMS_CONTEXT( response_buffer, *response_size, &currentPtr, &( foundEntryPtr->context ), &responseRval, returnFromResourceMgrReceiveTpmResponse );
                 }
@@ -2021,7 +2684,7 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
                     // TBD:  need to add tests for all of this code.
 
                     UINT8 shutdownStartupSequence = TPM_RESET;
-                    RESOURCE_MANAGER_ENTRY_PTR entryPtr;
+                    RESOURCE_MANAGER_ENTRY_PTR entryPtr, nextEntry;
 
                     if( shutdown_state )
                     {
@@ -2031,10 +2694,18 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
                             shutdownStartupSequence  = TPM_RESUME;
                     }
 
+                    // Only entries for this TPM are affected.
                     if( shutdownStartupSequence == TPM_RESET )
                     {
                         // Remove all TAB/RM entries.
-                        entryList = 0;
+                        for( entryPtr = entryList; entryPtr != 0; entryPtr = nextEntry )
+                        {
+                            nextEntry = entryPtr->nextEntry;
+                            if( entryPtr->backend == currentBackend )
+                            {
+                                RemoveEntry( entryPtr );
+                            }
+                        }
                     }
                     else if( shutdownStartupSequence == TPM_RESTART )
                     {
@@ -2043,9 +2714,10 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
                         // objects with stClear attribute.  Such objects will have
                         // their contexts invalidated.
                         //
-                        for( i = 0, entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry )
+                        for( entryPtr = entryList; entryPtr != 0; entryPtr = nextEntry )
                         {
-                            if( entryPtr->status.stClear )
+                            nextEntry = entryPtr->nextEntry;
+                            if( entryPtr->status.stClear && entryPtr->backend == currentBackend )
                             {
                                 RemoveEntry( entryPtr );
                             }
@@ -2053,6 +2725,10 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
                     }
                     // Clear shutdown_state;
                     shutdown_state = 0;
+
+                    // Contexts saved before this are tied to the old boot counts.
+                    if( currentBackend == 0 )
+                        storeClockStale = 1;
                 }
                 else if( currentCommandCode == TPM_CC_EvictControl )
                 {
@@ -2269,6 +2945,453 @@ exitResourceMgrReceiveTpmResponse:
     return rval;
 }
 
+// Sessions and persistent objects stay in the primary; so must anything
+// that would make one.
+static UINT8 PrimaryOnlyCommand( TPM_CC commandCode )
+{
+    return commandCode == TPM_CC_StartAuthSession || commandCode == TPM_CC_EvictControl;
+}
+
+// Notes the backend holding the entity a command names, if the RM manages
+// it; fails if the command has already named one in another backend.
+static TSS2_RC NoteBackend( TPM_HANDLE handle, UINT32 *backend, UINT8 *found )
+{
+    RESOURCE_MANAGER_ENTRY_PTR foundEntryPtr;
+
+    if( !HandleWeCareAbout( handle ) ||
+            FindEntry( entryList, RMFIND_VIRTUAL_HANDLE, handle, &foundEntryPtr ) != TSS2_RC_SUCCESS )
+    {
+        return TSS2_RC_SUCCESS;
+    }
+
+    if( *found && *backend != foundEntryPtr->backend )
+        return TSS2_RESMGR_BACKEND_MISMATCH;
+
+    *backend = foundEntryPtr->backend;
+    *found = 1;
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Works out which backend a command runs on: the one holding the objects,
+// sequences and sessions it names; the least loaded one for a LoadExternal
+// into the NULL hierarchy that names none; otherwise the primary.  Other
+// external keys stay in the primary because tickets made with them are
+// only good there.
+//
+static TSS2_RC CommandBackend( uint8_t *command_buffer, UINT32 command_size, UINT32 *backend )
+{
+    UINT8 *currentPtr = command_buffer;
+    UINT8 *endAuth;
+    TPM_ST tag = 0;
+    TPM_CC commandCode = 0;
+    TPM_HANDLE handle;
+    TPMI_RH_HIERARCHY hierarchy = 0;
+    UINT32 authAreaSize = 0;
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    TSS2_RC routeRval = TSS2_RC_SUCCESS;
+    UINT8 found = 0;
+    int cmdHandleCount, i;
+
+    *backend = 0;
+
+    Unmarshal_UINT16( command_buffer, command_size, &currentPtr, &tag, &rval );
+    Unmarshal_UINT32( command_buffer, command_size, &currentPtr, 0, &rval );
+    Unmarshal_UINT32( command_buffer, command_size, &currentPtr, &commandCode, &rval );
+
+    cmdHandleCount = GetNumCmdHandles( commandCode, supportedCommands );
+    for( i = 0; i < cmdHandleCount && rval == TSS2_RC_SUCCESS && routeRval == TSS2_RC_SUCCESS; i++ )
+    {
+        Unmarshal_UINT32( command_buffer, command_size, &currentPtr, &handle, &rval );
+        if( rval == TSS2_RC_SUCCESS )
+            routeRval = NoteBackend( handle, backend, &found );
+    }
+
+    if( tag == TPM_ST_SESSIONS && cmdHandleCount != -1 )
+    {
+        Unmarshal_UINT32( command_buffer, command_size, &currentPtr, &authAreaSize, &rval );
+        endAuth = currentPtr + authAreaSize;
+        while( rval == TSS2_RC_SUCCESS && routeRval == TSS2_RC_SUCCESS && currentPtr < endAuth )
+        {
+            Unmarshal_UINT32( command_buffer, command_size, &currentPtr, &handle, &rval );
+            if( rval == TSS2_RC_SUCCESS )
+                routeRval = NoteBackend( handle, backend, &found );
+
+            // Skip past nonce, session attributes and auth.
+            Unmarshal_Simple_TPM2B( command_buffer, command_size, &currentPtr, 0, &rval );
+            Unmarshal_UINT8( command_buffer, command_size, &currentPtr, 0, &rval );
+            Unmarshal_Simple_TPM2B( command_buffer, command_size, &currentPtr, 0, &rval );
+        }
+    }
+
+    if( commandCode == TPM_CC_LoadExternal )
+    {
+        // Skip past inPrivate and inPublic.
+        Unmarshal_Simple_TPM2B( command_buffer, command_size, &currentPtr, 0, &rval );
+        Unmarshal_Simple_TPM2B( command_buffer, command_size, &currentPtr, 0, &rval );
+        Unmarshal_UINT32( command_buffer, command_size, &currentPtr, &hierarchy, &rval );
+    }
+
+    // Let the primary report what's wrong with a malformed command.
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        *backend = 0;
+        return TSS2_RC_SUCCESS;
+    }
+
+    if( routeRval != TSS2_RC_SUCCESS )
+        return routeRval;
+
+    if( found )
+    {
+        if( *backend != 0 && PrimaryOnlyCommand( commandCode ) )
+            return TSS2_RESMGR_BACKEND_MISMATCH;
+    }
+    else if( commandCode == TPM_CC_LoadExternal && hierarchy == TPM_RH_NULL )
+    {
+        *backend = LEAST_LOADED_BACKEND;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC ResMgrExecuteCommand(
+    SOCKET              connectSock,
+    UINT8               locality,
+    uint8_t             *command_buffer,
+    UINT32              command_size,
+    uint8_t             *response_buffer,
+    UINT32              *response_size
+    )
+{
+    UINT32 backend;
+    TSS2_RC rval;
+
+    rval = CommandBackend( command_buffer, command_size, &backend );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        *response_size = FormatErrorResponse( rval, response_buffer );
+        return TSS2_RC_SUCCESS;
+    }
+
+    rval = AcquireBackend( &backend );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+    SelectBackend( backend );
+
+    rval = CheckBackendResponsive( backend );
+    if( rval == TSS2_RC_SUCCESS && backends[backend].flushPending )
+    {
+        // A command given up on may have left objects and sessions loaded.
+        backends[backend].loadedSessions = 1;
+        rval = FlushAllLoadedHandles();
+        if( rval == TSS2_RC_SUCCESS )
+            backends[backend].flushPending = 0;
+    }
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        *response_size = FormatErrorResponse( rval, response_buffer );
+        rval = TSS2_RC_SUCCESS;
+        goto exitResMgrExecuteCommand;
+    }
+
+    // Set client specific locality for command we're about to send
+    (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.locality = locality;
+    (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.commandSent = 1;
+    (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.rmDebugPrefix = NO_PREFIX;
+    ((TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext)->currentConnectSock = connectSock;
+
+    // Send TPM command to TPM.
+    rval = ResourceMgrSendTpmCommand( downstreamTctiContext, command_size, command_buffer );
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        // Receive response from TPM.
+        rval = ResourceMgrReceiveTpmResponse( downstreamTctiContext, response_size, response_buffer, TSS2_TCTI_TIMEOUT_BLOCK );
+    }
+
+    if( backend == 0 && !backends[0].responsePending && SaveStore() != TSS2_RC_SUCCESS )
+        DebugPrintf( NO_PREFIX, "Resource Mgr failed to update store\n" );
+
+exitResMgrExecuteCommand:
+    SelectBackend( 0 );
+    ReleaseBackend( backend );
+
+    return rval;
+}
+
+UINT8 ResMgrStatelessCommand( const uint8_t *command_buffer, UINT32 command_size )
+{
+    const UINT8 *parameters = command_buffer + sizeof( TPM20_Header_In );
+    UINT32 parametersSize;
+    UINT16 dataSize;
+
+    if( command_size < sizeof( TPM20_Header_In ) ||
+            CHANGE_ENDIAN_WORD( ( (TPM20_Header_In *)command_buffer )->tag ) != TPM_ST_NO_SESSIONS )
+    {
+        return 0;
+    }
+    parametersSize = command_size - sizeof( TPM20_Header_In );
+
+    switch( CHANGE_ENDIAN_DWORD( ( (TPM20_Header_In *)command_buffer )->commandCode ) )
+    {
+        case TPM_CC_GetRandom:
+        case TPM_CC_TestParms:
+            return 1;
+        case TPM_CC_GetCapability:
+            // Handles in a TPM mean nothing to a client of the RM.
+            return parametersSize >= 4 &&
+                    CHANGE_ENDIAN_DWORD( *(UINT32 *)parameters ) != TPM_CAP_HANDLES;
+        case TPM_CC_Hash:
+            // A ticket for another hierarchy would be good only in the
+            // TPM that made it.
+            if( parametersSize < 2 )
+                return 0;
+            dataSize = CHANGE_ENDIAN_WORD( *(UINT16 *)parameters );
+            return parametersSize >= 2 + (UINT32)dataSize + 2 + 4 &&
+                    CHANGE_ENDIAN_DWORD( *(UINT32 *)( parameters + 2 + dataSize + 2 ) ) == TPM_RH_NULL;
+        default:
+            return 0;
+    }
+}
+
+TSS2_RC ResMgrSendStatelessCommand(
+    UINT8               locality,
+    uint8_t             *command_buffer,
+    UINT32              command_size,
+    uint8_t             *response_buffer,
+    UINT32              *response_size
+    )
+{
+    UINT32 backend = LEAST_LOADED_BACKEND;
+    TSS2_TCTI_CONTEXT *tpmTctiContext;
+    TPM_CC commandCode = CHANGE_ENDIAN_DWORD( ( (TPM20_Header_In *)command_buffer )->commandCode );
+    UINT32 timeoutMs = ResMgrGetCommandTimeout( commandCode );
+    COMMAND_DEADLINE deadline = { 0, 0, 0 };
+    size_t receivedSize = *response_size;
+    TSS2_RC rval;
+
+    rval = AcquireBackend( &backend );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    // Stateless commands load nothing, so there is nothing to flush.
+    rval = CheckBackendResponsive( backend );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        *response_size = FormatErrorResponse( rval, response_buffer );
+        ReleaseBackend( backend );
+        return TSS2_RC_SUCCESS;
+    }
+
+    tpmTctiContext = backends[backend].tctiContext;
+    ((TSS2_TCTI_CONTEXT_INTEL *)tpmTctiContext)->status.debugMsgEnabled = ( commandDebug == 1 );
+    ((TSS2_TCTI_CONTEXT_INTEL *)tpmTctiContext)->status.rmDebugPrefix = NO_PREFIX;
+    backends[backend].stats.commands++;
+
+    rval = tss2_tcti_set_locality( tpmTctiContext, locality );
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        if( timeoutMs != 0 )
+            deadline.due = NowMs() + timeoutMs;
+        rval = tss2_tcti_transmit( tpmTctiContext, command_size, command_buffer );
+    }
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        rval = ReceiveWithRetries( tpmTctiContext, commandCode, command_buffer, command_size,
+                response_buffer, &receivedSize, TSS2_TCTI_TIMEOUT_BLOCK, &deadline,
+                &backends[backend].stats );
+    }
+    if( rval == TSS2_RC_SUCCESS )
+        *response_size = (UINT32)receivedSize;
+    if( deadline.abandoned )
+        backends[backend].responsePending = 1;
+
+    ((TSS2_TCTI_CONTEXT_INTEL *)tpmTctiContext)->status.debugMsgEnabled = 0;
+    ReleaseBackend( backend );
+
+    return rval;
+}
+
+//
+// Entries for another boot of the TPM are dropped.  The others are put
+// back in the table; those that no client can reattach to, having no
+// token, are flushed instead.
+//
+static TSS2_RC RestoreStore()
+{
+    const RM_STORE_ENTRY *record;
+    RM_STORE_STATE state;
+    RESOURCE_MANAGER_ENTRY_PTR entryPtr;
+    UINT32 count, i;
+    TSS2_RC rval;
+
+    rval = ReadBootCounts();
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    // Whatever is restored, the file must end up matching the table.
+    storeDirty = 1;
+
+    record = RmStoreCurrent( &state, &count );
+    if( record == 0 || state.resetCount != storeState.resetCount ||
+            state.restartCount != storeState.restartCount )
+    {
+        DebugPrintf( NO_PREFIX, "Resource Mgr store is empty or from another TPM boot\n" );
+        return TSS2_RC_SUCCESS;
+    }
+
+    ENABLE_RM_TPM_CMD_DEBUG_MSGS;
+
+    for( i = 0; i < count; i++, record++ )
+    {
+        if( record->token == 0 )
+        {
+            if( IsSessionHandle( record->virtualHandle ) )
+                (void)Tss2_Sys_FlushContext( resMgrSysContext, record->realHandle );
+            continue;
+        }
+
+        rval = AddEntry( record->virtualHandle, record->realHandle, record->parentHandle,
+                record->hierarchy, RESTORED_CONNECTION_ID );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        rval = FindEntry( entryList, RMFIND_VIRTUAL_HANDLE, record->virtualHandle, &entryPtr );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        // Persistent entries count as loaded for as long as they exist.
+        entryPtr->status.loaded = PersistentHandle( record->virtualHandle );
+        entryPtr->status.stClear = record->stClear;
+        entryPtr->token = record->token;
+        entryPtr->context = record->context;
+        ClaimVirtualHandle( record->virtualHandle );
+
+        if( IsSessionHandle( record->virtualHandle ) )
+            activeSessionCount++;
+    }
+
+    lastSessionSequenceNum = state.lastSessionSequenceNum;
+
+    DISABLE_RM_TPM_CMD_DEBUG_MSGS;
+
+    DebugPrintf( NO_PREFIX, "Resource Mgr restored %d of %d stored entries\n", i, count );
+
+    return rval;
+}
+
+TSS2_RC ResMgrOpenStore( const char *fileName )
+{
+    TSS2_RC rval;
+
+    if( 0 != RmStoreOpen( fileName, RESMGR_STORE_CAPACITY ) )
+        return TSS2_RESMGR_STORE_FAILED;
+    storeOpen = 1;
+
+    rval = RestoreStore();
+    if( rval == TSS2_RC_SUCCESS )
+        rval = SaveStore();
+
+    if( rval != TSS2_RC_SUCCESS )
+        ResMgrCloseStore();
+
+    return rval;
+}
+
+void ResMgrCloseStore( void )
+{
+    RmStoreClose();
+    storeOpen = 0;
+}
+
+TSS2_RC ResMgrReattach( UINT64 connectionId, UINT64 *token )
+{
+    RESMGR_CONNECTION *connection;
+    RESOURCE_MANAGER_ENTRY_PTR entryPtr;
+    TPM2B_DIGEST randomBytes;
+    UINT32 primary = 0;
+    UINT8 claimed = 0;
+    TSS2_RC rval;
+
+    if( *token != 0 )
+    {
+        for( connection = connectionList; connection != 0; connection = connection->next )
+        {
+            if( connection->token == *token && connection->connectionId != connectionId )
+                return TSS2_RESMGR_UNKNOWN_TOKEN;
+        }
+
+        for( entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry )
+        {
+            if( entryPtr->connectionId == RESTORED_CONNECTION_ID && entryPtr->token == *token )
+            {
+                entryPtr->connectionId = connectionId;
+                claimed = 1;
+            }
+        }
+
+        if( !claimed )
+            return TSS2_RESMGR_UNKNOWN_TOKEN;
+    }
+
+    rval = AcquireBackend( &primary );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    ENABLE_RM_TPM_CMD_DEBUG_MSGS;
+
+    while( *token == 0 )
+    {
+        randomBytes.t.size = sizeof( randomBytes.t.buffer );
+        rval = Tss2_Sys_GetRandom( resMgrSysContext, 0, sizeof( *token ), &randomBytes, 0 );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
+            goto exitReattach;
+        }
+        if( randomBytes.t.size != sizeof( *token ) )
+        {
+            rval = TSS2_RESMGR_INSUFFICIENT_RESPONSE;
+            goto exitReattach;
+        }
+        memcpy( token, randomBytes.t.buffer, sizeof( *token ) );
+    }
+
+    connection = FindConnection( connectionId );
+    if( connection == 0 )
+    {
+        connection = (*rmMalloc)( sizeof( RESMGR_CONNECTION ) );
+        if( connection == 0 )
+        {
+            rval = TSS2_RESMGR_MEMALLOC_FAILED;
+            goto exitReattach;
+        }
+        connection->connectionId = connectionId;
+        connection->next = connectionList;
+        connectionList = connection;
+    }
+    connection->token = *token;
+
+    for( entryPtr = entryList; entryPtr != 0; entryPtr = entryPtr->nextEntry )
+    {
+        if( entryPtr->connectionId == connectionId )
+        {
+            entryPtr->token = *token;
+            if( entryPtr->backend == 0 )
+                storeDirty = 1;
+        }
+    }
+
+    rval = SaveStore();
+
+exitReattach:
+    DISABLE_RM_TPM_CMD_DEBUG_MSGS;
+
+    ReleaseBackend( primary );
+
+    return rval;
+}
+
 typedef UINT8 (*SERVER_FN)(void *serverStruct);
 
 typedef struct serverStruct
@@ -2279,11 +3402,32 @@ typedef struct serverStruct
     THREAD_TYPE threadHandle;
 } SERVER_STRUCT;
 
+// Returns the TpmCmdServer break value for a failure, 0 if none.
+static UINT8 SendResponse( SOCKET sock, UINT8 *response_buffer, UINT32 numBytes )
+{
+    UINT32 trash = 0;
+    UINT32 size = CHANGE_ENDIAN_DWORD( numBytes );
+
+    // Send size of TPM response to calling application.
+    if( rmSendBytes( sock, (unsigned char *)&size, 4 ) != TSS2_RC_SUCCESS )
+        return 5;
+
+    // Send TPM or RM response to calling application.
+    if( sendBytes( sock, (unsigned char *)response_buffer, numBytes ) != TSS2_RC_SUCCESS )
+        return 6;
+
+    // Send the appended four bytes of 0's
+    if( rmSendBytes( sock, (unsigned char *)&trash, 4 ) != TSS2_RC_SUCCESS )
+        return 7;
+
+    return 0;
+}
+
 #define MUTEX_DBG_FUNCTION_STR "TpmCmdServer"
 
 UINT8 TpmCmdServer( SERVER_STRUCT *serverStruct )
 {
-    UINT32 numBytes, sendCmd, trash = 0;
+    UINT32 numBytes, rspSize, sendCmd;
     UINT8 locality;
     TSS2_RC rval = TSS2_RC_SUCCESS;
 
@@ -2297,8 +3441,12 @@ UINT8 TpmCmdServer( SERVER_STRUCT *serverStruct )
 
     // buffer to hold TPM command from client
     UINT8 *cmdBuffer;
+    // buffer for responses to stateless commands, which don't hold tpmMutex
+    UINT8 *statelessRspBuffer;
+
     cmdBuffer = (*rmMalloc)( maxCmdSize );
-    if( cmdBuffer == NULL )
+    statelessRspBuffer = (*rmMalloc)( maxRspSize );
+    if( cmdBuffer == NULL || statelessRspBuffer == NULL )
     {
         // failure to allocate memory, kill the server
         rval = TSS2_RESMGR_MEMALLOC_FAILED;
@@ -2351,9 +3499,36 @@ UINT8 TpmCmdServer( SERVER_STRUCT *serverStruct )
             // Do nothing except kill the server.
             tpmCmdServerBreakValue = 3;
         }
+        else if( sendCmd == TPM_RESMGR_REATTACH )
+        {
+            UINT64 token;
+            UINT32 responseCode;
+
+            // Receive the token; 0 asks for a new one.
+            rval = rmRecvBytes( serverStruct->connectSock, (unsigned char *)&token, 8 );
+            if( rval != TSS2_RC_SUCCESS )
+            {
+                tpmCmdServerBreakValue = 2;
+                goto tpmCmdServerDone;
+            }
+
+            // CRITICAL SECTION STARTS HERE.
+            rval = StartCriticalSection( &tpmMutex, &functionString[0] );
+            if( rval != TSS2_RC_SUCCESS )
+                goto tpmCmdServerDone;
+            criticalSectionEntered = 1;
+
+            responseCode = CHANGE_ENDIAN_DWORD( ResMgrReattach( serverStruct->connectSock, &token ) );
+            if( rmSendBytes( serverStruct->connectSock, (unsigned char *)&responseCode, 4 ) != TSS2_RC_SUCCESS ||
+                    rmSendBytes( serverStruct->connectSock, (unsigned char *)&token, 8 ) != TSS2_RC_SUCCESS )
+            {
+                tpmCmdServerBreakValue = 9;
+                goto tpmCmdServerDone;
+            }
+        }
         else if( sendCmd != MS_SIM_TPM_SEND_COMMAND )
         {
-            // We received some value other than TPM_SESSION_END or MS_SIM_TPM_SEND_COMMAND.
+            // We received some value other than TPM_SESSION_END, TPM_RESMGR_REATTACH or MS_SIM_TPM_SEND_COMMAND.
             // Kill the server.
             tpmCmdServerBreakValue = 4;
         }
@@ -2395,6 +3570,24 @@ UINT8 TpmCmdServer( SERVER_STRUCT *serverStruct )
                 continue;
             }
 
+            if( ResMgrStatelessCommand( cmdBuffer, numBytes ) )
+            {
+                // Nothing the RM manages is involved, so don't queue
+                // behind commands that are.
+                rspSize = maxRspSize;
+                rval = ResMgrSendStatelessCommand( locality, cmdBuffer, numBytes, statelessRspBuffer, &rspSize );
+                if( rval != TSS2_RC_SUCCESS )
+                {
+                    rspSize = FormatErrorResponse( TSS2_TCTI_RC_IO_ERROR, statelessRspBuffer );
+                }
+
+                tpmCmdServerBreakValue = SendResponse( serverStruct->connectSock, statelessRspBuffer, rspSize );
+                if( tpmCmdServerBreakValue != 0 )
+                    goto tpmCmdServerDone;
+
+                continue;
+            }
+
             // CRITICAL SECTION STARTS HERE.
             rval = StartCriticalSection( &tpmMutex, &functionString[0] );
 
@@ -2405,61 +3598,20 @@ UINT8 TpmCmdServer( SERVER_STRUCT *serverStruct )
             else
             {
                 criticalSectionEntered = 1;
-            }
-
-            // Set client specific locality for command we're about to send
-            (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.locality = locality;
-            (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.commandSent = 1;
-            (( TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext )->status.rmDebugPrefix = NO_PREFIX;
-
-            // Send TPM command to TPM.
-            ((TSS2_TCTI_CONTEXT_INTEL *)downstreamTctiContext)->currentConnectSock = serverStruct->connectSock;
-            rval = ResourceMgrSendTpmCommand( downstreamTctiContext, numBytes, cmdBuffer );
-            if( rval != TSS2_RC_SUCCESS )
-            {
-                CreateErrorResponse( TSS2_TCTI_RC_IO_ERROR );
-                SendErrorResponse( serverStruct->connectSock );
-            }
-            else
-            {
-                // Receive response from TPM.
-                numBytes = maxRspSize;
-                rval = ResourceMgrReceiveTpmResponse( downstreamTctiContext, &numBytes, rspBuffer, TSS2_TCTI_TIMEOUT_BLOCK );
-                if( rval != TSS2_RC_SUCCESS )
-                {
-                    CreateErrorResponse( TSS2_TCTI_RC_IO_ERROR );
-                    SendErrorResponse( serverStruct->connectSock );
-                }
-                else
-                {
-                    numBytes = CHANGE_ENDIAN_DWORD( numBytes );
-
-                    // Send size of TPM response to calling application.
-                    rval = rmSendBytes( serverStruct->connectSock, (unsigned char *)&numBytes, 4 );
-                    if( rval != TSS2_RC_SUCCESS )
-                    {
-                        tpmCmdServerBreakValue = 5;
-                        goto tpmCmdServerDone;
-                    }
-
-                    numBytes = CHANGE_ENDIAN_DWORD( numBytes );
-
-                    // Send TPM or RM response to calling application.
-                    rval = sendBytes( serverStruct->connectSock, (unsigned char *)rspBuffer, numBytes );
-                    if( rval != TSS2_RC_SUCCESS )
-                    {
-                        tpmCmdServerBreakValue = 6;
-                        goto tpmCmdServerDone;
-                    }
+            }
 
-                    // Send the appended four bytes of 0's
-                    rmSendBytes( serverStruct->connectSock, (unsigned char *)&trash, 4 );
-                    if( rval != TSS2_RC_SUCCESS )
-                    {
-                        tpmCmdServerBreakValue = 7;
-                        goto tpmCmdServerDone;
-                    }
-                }
+            rspSize = maxRspSize;
+            rval = ResMgrExecuteCommand( serverStruct->connectSock, locality, cmdBuffer, numBytes, rspBuffer, &rspSize );
+            if( rval != TSS2_RC_SUCCESS )
+            {
+                CreateErrorResponse( TSS2_TCTI_RC_IO_ERROR );
+                SendErrorResponse( serverStruct->connectSock );
+            }
+            else
+            {
+                tpmCmdServerBreakValue = SendResponse( serverStruct->connectSock, rspBuffer, rspSize );
+                if( tpmCmdServerBreakValue != 0 )
+                    goto tpmCmdServerDone;
             }
         }
         if( tpmCmdServerBreakValue != 0 )
@@ -2501,7 +3653,14 @@ tpmCmdServerDone:
     }
     if( criticalSectionEntered )
     {
-        (void)FlushSessionsAndClearTable( serverStruct->connectSock );
+        // The connection's sessions all live in the primary backend.
+        UINT32 primary = 0;
+
+        if( AcquireBackend( &primary ) == TSS2_RC_SUCCESS )
+        {
+            (void)FlushSessionsAndClearTable( serverStruct->connectSock );
+            ReleaseBackend( primary );
+        }
 
         // CRITICAL SECTION ENDS HERE.
         rval = EndCriticalSection( &tpmMutex, &functionString[0] );
@@ -2513,6 +3672,10 @@ tpmCmdServerDone:
     if (cmdBuffer != NULL)
     {
         free(cmdBuffer);
+    }
+    if (statelessRspBuffer != NULL)
+    {
+        free(statelessRspBuffer);
     }
 	ExitThread( 0 );
 
@@ -2614,22 +3777,25 @@ UINT8 OtherCmdServer( SERVER_STRUCT *serverStruct )
             }
         }
 
+        // Platform commands are for the primary backend's simulator.  The
+        // cancel and power ones are sent without tpmMutex, while another
+        // thread may have pointed downstreamTctiContext at another backend.
         switch( command )
         {
             case MS_SIM_POWER_ON:
-                rval = PlatformCommand( downstreamTctiContext, MS_SIM_POWER_ON );
+                rval = PlatformCommand( backends[0].tctiContext, MS_SIM_POWER_ON );
                 break;
             case MS_SIM_POWER_OFF:
-                rval = PlatformCommand( downstreamTctiContext, MS_SIM_POWER_OFF );
+                rval = PlatformCommand( backends[0].tctiContext, MS_SIM_POWER_OFF );
                 break;
             case MS_SIM_CANCEL_ON:
-                rval = PlatformCommand( downstreamTctiContext, MS_SIM_CANCEL_ON );
+                rval = PlatformCommand( backends[0].tctiContext, MS_SIM_CANCEL_ON );
                 break;
             case MS_SIM_CANCEL_OFF:
-                rval = PlatformCommand( downstreamTctiContext, MS_SIM_CANCEL_OFF );
+                rval = PlatformCommand( backends[0].tctiContext, MS_SIM_CANCEL_OFF );
                 break;
             case MS_SIM_NV_ON:
-                rval = PlatformCommand( downstreamTctiContext, MS_SIM_NV_ON );
+                rval = PlatformCommand( backends[0].tctiContext, MS_SIM_NV_ON );
                 break;
             case TPM_SESSION_END:
                 returnValue = 1;
@@ -2683,7 +3849,14 @@ retOtherCmdServer:
 
     if( criticalSectionEntered )
     {
-        (void)FlushSessionsAndClearTable( serverStruct->connectSock );
+        // The connection's sessions all live in the primary backend.
+        UINT32 primary = 0;
+
+        if( AcquireBackend( &primary ) == TSS2_RC_SUCCESS )
+        {
+            (void)FlushSessionsAndClearTable( serverStruct->connectSock );
+            ReleaseBackend( primary );
+        }
 
         // CRITICAL SECTION ENDS HERE.
         rval = EndCriticalSection( &tpmMutex, &functionString[0] );
@@ -2789,10 +3962,99 @@ TCTI_SOCKET_CONF simInterfaceConfig = {
 SOCKET simOtherSock;
 SOCKET simTpmSock;
 
+typedef struct {
+    TPM_PT property;
+    UINT32 *value;
+} TPM_PROPERTY_REQUEST;
+
+//
+// Reads TPM properties, given in increasing order, in as few round trips
+// as the TPM allows: each GetCapability asks for as many properties as a
+// response holds, from the first one still missing.  Fails if the TPM
+// doesn't have one of them.
+//
+static TSS2_RC GetTpmProperties( TSS2_SYS_CONTEXT *sysContext, TPM_PROPERTY_REQUEST *requests, UINT32 count )
+{
+    TPMS_CAPABILITY_DATA capabilityData;
+    TPMS_TAGGED_PROPERTY *tagged;
+    UINT32 next = 0, first, i;
+    TSS2_RC rval;
+
+    while( next < count )
+    {
+        rval = Tss2_Sys_GetCapability( sysContext, 0,
+                TPM_CAP_TPM_PROPERTIES, requests[next].property,
+                MAX_TPM_PROPERTIES, 0, &capabilityData, 0 );
+        if( rval != TPM_RC_SUCCESS )
+            return rval;
+
+        first = next;
+        for( i = 0; i < capabilityData.data.tpmProperties.count && next < count; i++ )
+        {
+            tagged = &capabilityData.data.tpmProperties.tpmProperty[i];
+            if( tagged->property > requests[next].property )
+                break;
+            if( tagged->property == requests[next].property )
+                *requests[next++].value = tagged->value;
+        }
+
+        if( next == first )
+            return TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+// Brings up a secondary backend.  Backends are assumed to be the same TPM
+// model, so only the buffer sizes are checked against the primary's.
+static TSS2_RC InitBackend( UINT32 backend )
+{
+    TSS2_RC rval;
+    UINT32 backendMaxCmdSize, backendMaxRspSize;
+    TPM_PROPERTY_REQUEST properties[] = {
+        { TPM_PT_MAX_COMMAND_SIZE, &backendMaxCmdSize },
+        { TPM_PT_MAX_RESPONSE_SIZE, &backendMaxRspSize },
+        { TPM_PT_HR_LOADED, &backends[backend].loadedSessions },
+    };
+    TSS2_SYS_CONTEXT *sysContext = backends[backend].sysContext;
+
+    rval = Tss2_Sys_Startup( sysContext, TPM_SU_CLEAR );
+    if( rval != TPM_RC_SUCCESS && rval != TPM_RC_INITIALIZE )
+        return rval;
+
+    rval = GetTpmProperties( sysContext, properties, sizeof( properties ) / sizeof( properties[0] ) );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    // Clients can only send what every backend accepts, and the response
+    // buffer must hold what any backend returns.
+    if( backendMaxCmdSize < maxCmdSize )
+        maxCmdSize = backendMaxCmdSize;
+    if( backendMaxRspSize > maxRspSize )
+        maxRspSize = backendMaxRspSize;
+
+    SelectBackend( backend );
+    rval = FlushAllLoadedHandles();
+    SelectBackend( 0 );
+
+    return rval;
+}
+
 TSS2_RC InitResourceMgr( int debugLevel)
 {
     TSS2_RC rval = TSS2_RC_SUCCESS;
-    TPMS_CAPABILITY_DATA capabilityData;
+    UINT32 manufacturer, firmwareVersion1, firmwareVersion2, totalCommands;
+    TPM_PROPERTY_REQUEST properties[] = {
+        { TPM_PT_MANUFACTURER, &manufacturer },
+        { TPM_PT_FIRMWARE_VERSION_1, &firmwareVersion1 },
+        { TPM_PT_FIRMWARE_VERSION_2, &firmwareVersion2 },
+        { TPM_PT_ACTIVE_SESSIONS_MAX, &maxActiveSessions },
+        { TPM_PT_CONTEXT_GAP_MAX, &gapMaxValue },
+        { TPM_PT_MAX_COMMAND_SIZE, &maxCmdSize },
+        { TPM_PT_MAX_RESPONSE_SIZE, &maxRspSize },
+        { TPM_PT_TOTAL_COMMANDS, &totalCommands },
+        { TPM_PT_HR_LOADED, &backends[0].loadedSessions },
+    };
     int i;
 
     SetDebug( DBG_COMMAND_RM_TABLES );
@@ -2825,132 +4087,43 @@ TSS2_RC InitResourceMgr( int debugLevel)
         goto returnFromInitResourceMgr;
     }
 
-    // Need to get some capabilities.
-
-    // Get max command size.
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_TPM_PROPERTIES, TPM_PT_MAX_COMMAND_SIZE,
-            1, 0, &capabilityData, 0 );
-
-    if( rval != TPM_RC_SUCCESS )
-    {
-        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-        goto returnFromInitResourceMgr;
-    }
-
-    if( capabilityData.data.tpmProperties.count == 1 &&
-            (capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_MAX_COMMAND_SIZE) )
-    {
-        maxCmdSize = capabilityData.data.tpmProperties.tpmProperty[0].value;
-    }
-    else
-    {
-        rval = TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
-        goto returnFromInitResourceMgr;
-    }
-
-    // Get max response size.
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_TPM_PROPERTIES, TPM_PT_MAX_RESPONSE_SIZE,
-            1, 0, &capabilityData, 0 );
-
-    if( rval != TPM_RC_SUCCESS )
-    {
-        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-        goto returnFromInitResourceMgr;
-    }
-
-    if( capabilityData.data.tpmProperties.count == 1 &&
-            (capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_MAX_RESPONSE_SIZE) )
-    {
-        maxRspSize = capabilityData.data.tpmProperties.tpmProperty[0].value;
-    }
-    else
-    {
-        rval = TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
-        goto returnFromInitResourceMgr;
-    }
-
-    // Get max active sessions.
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_TPM_PROPERTIES, TPM_PT_ACTIVE_SESSIONS_MAX,
-            1, 0, &capabilityData, 0 );
-
-    if( rval != TPM_RC_SUCCESS )
-    {
-        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-        goto returnFromInitResourceMgr;
-    }
-
-    if( capabilityData.data.tpmProperties.count == 1 &&
-            (capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_ACTIVE_SESSIONS_MAX) )
-    {
-        maxActiveSessions = capabilityData.data.tpmProperties.tpmProperty[0].value;
-    }
-    else
-    {
-        rval = TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
-        goto returnFromInitResourceMgr;
-    }
-
-    // Get max loaded sessions.
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_TPM_PROPERTIES, TPM_PT_HR_LOADED,
-            1, 0, &capabilityData, 0 );
+    // Get the capabilities the RM needs, and what identifies the TPM's
+    // command set, all at once.
+    rval = GetTpmProperties( resMgrSysContext, properties, sizeof( properties ) / sizeof( properties[0] ) );
     if( rval != TPM_RC_SUCCESS )
     {
-        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
+        if( rval != TSS2_SIMULATOR_INTERFACE_INIT_FAILED )
+            SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
         goto returnFromInitResourceMgr;
     }
 
-    if( capabilityData.data.tpmProperties.count == 1 &&
-            (capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_HR_LOADED) )
-    {
 #ifndef DEBUG_GAP_HANDLING
-        maxActiveSessions += capabilityData.data.tpmProperties.tpmProperty[0].value;
+    maxActiveSessions += backends[0].loadedSessions;
 #else
-        maxActiveSessions = DEBUG_MAX_ACTIVE_SESSIONS;
+    maxActiveSessions = DEBUG_MAX_ACTIVE_SESSIONS;
+    gapMaxValue = DEBUG_GAP_MAX;
 #endif
-        DebugPrintf( NO_PREFIX, "maxActiveSessions = %d\n", maxActiveSessions );
-    }
-    else
-    {
-        rval = TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
-        goto returnFromInitResourceMgr;
-    }
+    DebugPrintf( NO_PREFIX, "maxActiveSessions = %d\n", maxActiveSessions );
+    DebugPrintf( NO_PREFIX, "gapMaxValue = %d\n", gapMaxValue );
 
-    // Get gap value for sessions.
-    rval = Tss2_Sys_GetCapability( resMgrSysContext, 0,
-            TPM_CAP_TPM_PROPERTIES, TPM_PT_CONTEXT_GAP_MAX,
-            1, 0, &capabilityData, 0 );
+    // Get the TPM 2.0 commands supported by the TPM.
+    rval = GetCommandsCached( resMgrSysContext, rmCommandCacheFile,
+            manufacturer, firmwareVersion1, firmwareVersion2, totalCommands, &supportedCommands );
     if( rval != TPM_RC_SUCCESS )
     {
         SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
         goto returnFromInitResourceMgr;
     }
 
-    if( capabilityData.data.tpmProperties.count == 1 &&
-            (capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_CONTEXT_GAP_MAX))
-    {
-#ifndef DEBUG_GAP_HANDLING
-        gapMaxValue = capabilityData.data.tpmProperties.tpmProperty[0].value;
-#else
-        gapMaxValue = DEBUG_GAP_MAX;
-#endif
-        DebugPrintf( NO_PREFIX, "gapMaxValue = %d\n", gapMaxValue );
-    }
-    else
-    {
-        rval = TSS2_SIMULATOR_INTERFACE_INIT_FAILED;
-        goto returnFromInitResourceMgr;
-    }
-
-    // Get the TPM 2.0 commands supported by the TPM.
-    rval = GetCommands( resMgrSysContext, &supportedCommands );
-    if( rval != TPM_RC_SUCCESS )
+    for( i = 1; i < (int)backendCount; i++ )
     {
-        SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
-        goto returnFromInitResourceMgr;
+        rval = InitBackend( i );
+        if( rval != TPM_RC_SUCCESS )
+        {
+            DebugPrintf( NO_PREFIX, "Backend %d failed to initialize, rval: 0x%8.8x\n", i, rval );
+            SetRmErrorLevel( &rval, TSS2_RESMGR_ERROR_LEVEL );
+            goto returnFromInitResourceMgr;
+        }
     }
 
     rspBuffer = (*rmMalloc)( maxRspSize );
@@ -2977,7 +4150,12 @@ void PrintHelp()
 #if __linux || __unix
             "[-sim] "
 #endif
-            "[-tpmhost hostname|ip_addr] [-tpmport port] [-apport port]\n"
+            "[-tpmhost hostname|ip_addr] [-tpmport port] [-apport port]"
+            " [-timeout ms] [-cctimeout cc:ms[,cc:ms...]] [-cancelwait ms] [-backend tpm]... [-cmdcache file]"
+#if __linux || __unix
+            " [-trace file] [-store file]"
+#endif
+            "\n"
             "\n"
             "where:\n"
             "\n"
@@ -2987,13 +4165,27 @@ void PrintHelp()
             "-tpmhost specifies the host IP address for communicating with the TPM (default: %s; only valid if -sim used)\n"
             "-tpmport specifies the port number for communicating with the TPM (default: %d; only valid if -sim used)\n"
             "-apport specifies the port number for communicating with the calling application (default: %d)\n"
+            "-timeout cancels commands still running after ms milliseconds (default: 0, never)\n"
+            "-cctimeout sets the timeout for individual command codes, e.g. 0x131:60000 for CreatePrimary\n"
+            "-cancelwait gives up on a canceled command the TPM hasn't answered within ms milliseconds\n"
+            "   (default: %d; 0, never)\n"
+            "-backend adds a TPM that stateless commands (GetRandom, Hash, ...) and keys loaded on it are\n"
+            "   spread over, up to %d in all; tpm is hostname:port with -sim, else a device path such as /dev/tpm1\n"
+            "-cmdcache keeps the TPM's command attributes in file, so that they are read from the TPM only\n"
+            "   when its firmware changes\n"
+#if __linux || __unix
+            "-trace appends a record of every TPM command's timing to file; see test/bench/tracestat\n"
+            "-store keeps the resource manager's table in file, so that clients can reattach to their objects\n"
+            "   and sessions after a restart of the resource manager\n"
+#endif
 #ifdef DEBUG
             "-dbg specifies level of debug messages:\n"
             "   0 (application TPM command send/receive byte streams)\n"
             "   1 (resource manager internal TPM command send/receive byte streams)\n"
             "   2 (resource manager tables)\n"
 #endif
-            , version, DEFAULT_HOSTNAME, DEFAULT_SIMULATOR_TPM_PORT, DEFAULT_RESMGR_TPM_PORT );
+            , version, DEFAULT_HOSTNAME, DEFAULT_SIMULATOR_TPM_PORT, DEFAULT_RESMGR_TPM_PORT,
+            RESMGR_DEFAULT_CANCEL_WAIT_MS, RESMGR_MAX_BACKENDS );
 }
 
 void InitSysContextFailure()
@@ -3001,6 +4193,91 @@ void InitSysContextFailure()
     DebugPrintf( NO_PREFIX,  "In Resource Manager;  InitSysContext failed, exiting...\n" );
 }
 
+// RESMGR_NO_MAIN lets test programs, e.g. test/bench, link the resource
+// manager and drive it in process.
+#ifndef RESMGR_NO_MAIN
+// Parses "cc:ms[,cc:ms...]"; command codes may be in hex.
+static int ParseCommandTimeouts( char *list )
+{
+    char *next = list;
+    unsigned long commandCode, timeoutMs;
+
+    for( ;; )
+    {
+        commandCode = strtoul( next, &next, 0 );
+        if( *next != ':' )
+            return 0;
+        timeoutMs = strtoul( next + 1, &next, 0 );
+        if( ResMgrSetCommandTimeout( (TPM_CC)commandCode, (UINT32)timeoutMs ) != TSS2_RC_SUCCESS )
+            return 0;
+        if( *next == '\0' )
+            return 1;
+        if( *next != ',' )
+            return 0;
+        next++;
+    }
+}
+
+#if __linux || __unix
+//
+// With -trace, the downstream TCTI traces every command and this thread
+// appends the records to the trace file (see test/bench/tracestat).
+//
+#define TRACE_RECORDS_PER_THREAD 4096
+#define TRACE_DRAIN_INTERVAL_MS 100
+
+static void *TraceWriter( void *data )
+{
+    FILE *traceFile = (FILE *)data;
+    TCTI_TRACE_RECORD records[256];
+    struct timespec interval = { 0, TRACE_DRAIN_INTERVAL_MS * 1000000 };
+    size_t count;
+
+    for( ;; )
+    {
+        nanosleep( &interval, 0 );
+        while( ( count = TctiTraceDrain( records, sizeof( records ) / sizeof( records[0] ) ) ) != 0 )
+        {
+            if( fwrite( records, sizeof( records[0] ), count, traceFile ) != count )
+                break;
+        }
+        fflush( traceFile );
+    }
+
+    return 0;
+}
+#endif
+
+//
+// Opens the TCTI for a -backend spec: a device path, or hostname[:port]
+// when talking to simulators.
+//
+static TSS2_RC InitBackendTctiContext( char *spec, TSS2_TCTI_CONTEXT **tctiContext )
+{
+    TCTI_SOCKET_CONF socketConfig = simInterfaceConfig;
+    char *port;
+
+#if __linux || __unix
+    if( !simulator )
+    {
+        TCTI_DEVICE_CONF deviceTctiConfig = { spec, DebugPrintfCallback, NULL };
+
+        return InitDeviceTctiContext( &deviceTctiConfig, tctiContext, resDeviceTctiName );
+    }
+#endif
+
+    socketConfig.hostname = spec;
+    socketConfig.port = DEFAULT_SIMULATOR_TPM_PORT;
+    port = strrchr( spec, ':' );
+    if( port != 0 )
+    {
+        *port = '\0';
+        socketConfig.port = strtoul( port + 1, NULL, 10 );
+    }
+
+    return InitSocketTctiContext( &socketConfig, tctiContext );
+}
+
 int main(int argc, char* argv[])
 {
     char appHostName[200] = DEFAULT_HOSTNAME;
@@ -3012,6 +4289,15 @@ int main(int argc, char* argv[])
     SERVER_STRUCT tpmCmdServerStruct = { 0, (SERVER_FN)&TpmCmdServer, "TPM CMD" };
     THREAD_TYPE sockServerThread;
     UINT8 tpmHostNameSpecified = 0, tpmPortSpecified = 0;
+    char *backendSpecs[RESMGR_MAX_BACKENDS - 1];
+    int backendSpecCount = 0;
+    TSS2_TCTI_CONTEXT *backendTctiContext;
+#if __linux || __unix
+    const char *traceFileName = 0;
+    const char *storeFileName = 0;
+    FILE *traceFile;
+    THREAD_TYPE traceThread;
+#endif
 
 #ifdef  _WIN32
 	SECURITY_ATTRIBUTES mutexAttributes = { sizeof( SECURITY_ATTRIBUTES ), NULL, TRUE };
@@ -3032,6 +4318,26 @@ int main(int argc, char* argv[])
             {
                 simulator = 1;
             }
+            else if( 0 == strcmp( argv[count], "-trace" ) )
+            {
+                count++;
+                if( count >= argc )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+                traceFileName = argv[count];
+            }
+            else if( 0 == strcmp( argv[count], "-store" ) )
+            {
+                count++;
+                if( count >= argc )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+                storeFileName = argv[count];
+            }
             else
 #endif
             if( 0 == strcmp( argv[count], "-tpmhost" ) )
@@ -3066,6 +4372,53 @@ int main(int argc, char* argv[])
                     return 1;
                 }
             }
+            else if( 0 == strcmp( argv[count], "-timeout" ) )
+            {
+                count++;
+                if( count >= argc || 1 != sscanf_s( argv[count], "%u", &rmDefaultCommandTimeoutMs ) )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+            }
+            else if( 0 == strcmp( argv[count], "-cancelwait" ) )
+            {
+                count++;
+                if( count >= argc || 1 != sscanf_s( argv[count], "%u", &rmCancelWaitMs ) )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+            }
+            else if( 0 == strcmp( argv[count], "-cctimeout" ) )
+            {
+                count++;
+                if( count >= argc || !ParseCommandTimeouts( argv[count] ) )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+            }
+            else if( 0 == strcmp( argv[count], "-backend" ) )
+            {
+                count++;
+                if( count >= argc || backendSpecCount == RESMGR_MAX_BACKENDS - 1 )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+                backendSpecs[backendSpecCount++] = argv[count];
+            }
+            else if( 0 == strcmp( argv[count], "-cmdcache" ) )
+            {
+                count++;
+                if( count >= argc )
+                {
+                    PrintHelp();
+                    return 1;
+                }
+                rmCommandCacheFile = argv[count];
+            }
 #ifdef DEBUG
             else if( 0 == strcmp( argv[count], "-dbg" ) )
             {
@@ -3094,6 +4447,28 @@ int main(int argc, char* argv[])
 #endif
     }
 #if __linux || __unix
+    // Debug output is queued and written by a separate thread, so that
+    // -dbg doesn't lengthen the time tpmMutex is held.
+    if( AsyncLogStart( stdout, ASYNC_LOG_DEFAULT_SLOTS ) == 0 )
+        atexit( AsyncLogStop );
+
+    if( traceFileName != 0 )
+    {
+        traceFile = fopen( traceFileName, "ab" );
+        if( traceFile == 0 )
+        {
+            printf( "Resource Mgr failed to open trace file %s.  Exiting...\n", traceFileName );
+            return( 1 );
+        }
+        TctiTraceEnable( TRACE_RECORDS_PER_THREAD );
+        rval = pthread_create( &traceThread, 0, TraceWriter, traceFile );
+        if( rval != 0 )
+        {
+            printf( "Resource Mgr failed to create trace thread, error #%d.  Exiting...\n", rval );
+            return( 1 );
+        }
+    }
+
     if( !simulator )
     {
         // Use device driver for local TPM.
@@ -3121,13 +4496,30 @@ int main(int argc, char* argv[])
         }
     }
     // Init sysContext for use by RM.  Used to send RM specific TPM commands to the TPM.
-    resMgrSysContext = InitSysContext( 0, downstreamTctiContext, &abiVersion );
-    if( resMgrSysContext == 0 )
+    // The TPM given by -tpmhost/-tpmport or /dev/tpm0 is the primary backend.
+    rval = ResMgrAddBackend( downstreamTctiContext );
+    if( rval != TSS2_RC_SUCCESS )
     {
         InitSysContextFailure();
         goto initDone;
     }
 
+    for( count = 0; count < backendSpecCount; count++ )
+    {
+        rval = InitBackendTctiContext( backendSpecs[count], &backendTctiContext );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            DebugPrintf( NO_PREFIX,  "Resource Mgr, backend %s failed initialization: 0x%x.  Exiting...\n", backendSpecs[count], rval );
+            return( 1 );
+        }
+        rval = ResMgrAddBackend( backendTctiContext );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            InitSysContextFailure();
+            goto initDone;
+        }
+    }
+
 #ifdef  _WIN32
     // Create mutex.
     tpmMutex = CreateMutex( &mutexAttributes, FALSE, NULL );
@@ -3155,6 +4547,20 @@ int main(int argc, char* argv[])
         return( 1 );
     }
 
+#if __linux || __unix
+    // Saved contexts survive the flush below; only what a dead RM left
+    // loaded goes.
+    if( storeFileName != 0 )
+    {
+        rval = ResMgrOpenStore( storeFileName );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            printf( "Resource Mgr failed to open store %s: 0x%x.  Exiting...\n", storeFileName, rval );
+            return( 1 );
+        }
+    }
+#endif
+
     // Flush all loaded handles
     rval = FlushAllLoadedHandles();
     if( rval != TSS2_RC_SUCCESS )
@@ -3206,10 +4612,16 @@ int main(int argc, char* argv[])
 
     CloseHandle( tpmMutex );
 
-    TeardownSysContext( &resMgrSysContext );
-    TeardownTctiContext( &downstreamTctiContext );
+    ResMgrCloseStore();
+
+    for( count = (int)backendCount - 1; count >= 0; count-- )
+    {
+        TeardownSysContext( &backends[count].sysContext );
+        TeardownTctiContext( &backends[count].tctiContext );
+    }
 
 initDone:
 
     return 0;
 }
+#endif // RESMGR_NO_MAIN
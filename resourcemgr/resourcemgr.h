@@ -46,6 +46,12 @@
 #define TSS2_RESMGR_GAP_HANDLING_FAILED             ((TSS2_RC)( (11<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
 #define TSS2_RESMGR_UNLOADED_OBJECTS                ((TSS2_RC)( (12<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
 #define TSS2_RESMGR_UNLOADED_SESSIONS               ((TSS2_RC)( (13<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
+#define TSS2_RESMGR_TOO_MANY_TIMEOUTS               ((TSS2_RC)( (14<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
+#define TSS2_RESMGR_BACKEND_UNRESPONSIVE            ((TSS2_RC)( (15<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL)) // TPM hasn't answered a command the RM gave up on.
+#define TSS2_RESMGR_BACKEND_MISMATCH                ((TSS2_RC)( (16<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL)) // Command's objects and sessions are in different TPMs.
+#define TSS2_RESMGR_TOO_MANY_BACKENDS               ((TSS2_RC)( (17<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
+#define TSS2_RESMGR_STORE_FAILED                    ((TSS2_RC)( (18<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL))
+#define TSS2_RESMGR_UNKNOWN_TOKEN                   ((TSS2_RC)( (19<<TSS2_LEVEL_IMPLEMENTATION_SPECIFIC_SHIFT) + TSS2_RESMGR_ERROR_LEVEL)) // No entities left with this reattach token.
 
 #ifdef __cplusplus
 extern "C" {
@@ -68,6 +74,103 @@ TSS2_RC ResourceMgrReceiveTpmResponse(
 
 void ResourceMgrInit( int debugLevel );
 
+// A TPM_RC_RETRY, TPM_RC_YIELDED or TPM_RC_TESTING response makes the RM
+// send the command again itself, up to rmRetryLimit times.  It sleeps
+// rmRetryInitialSleepUs before the first resend and twice as long before
+// each one after that, up to rmRetryMaxSleepUs.
+#define RESMGR_DEFAULT_RETRY_LIMIT 8
+#define RESMGR_DEFAULT_RETRY_INITIAL_SLEEP_US 1000
+#define RESMGR_DEFAULT_RETRY_MAX_SLEEP_US 100000
+
+extern UINT32 rmRetryLimit;
+extern UINT32 rmRetryInitialSleepUs;
+extern UINT32 rmRetryMaxSleepUs;
+
+// A command whose response hasn't come within its timeout, in ms, is
+// canceled through the downstream TCTI; the client gets the TPM's answer to
+// that, normally TPM_RC_CANCELED.  Commands without a timeout of their own
+// get rmDefaultCommandTimeoutMs; 0 waits for ever.
+//
+// If the TPM doesn't answer within rmCancelWaitMs of the cancel either, the
+// RM gives up on the command and the client gets TPM_RC_CANCELED.  The
+// command's sessions are dropped and its objects go back to their saved
+// contexts; the backend fails commands with TSS2_RESMGR_BACKEND_UNRESPONSIVE
+// until the TPM's answer comes, then has what the command left loaded
+// flushed.  0 waits for ever.
+#define RESMGR_MAX_COMMAND_TIMEOUTS 32
+#define RESMGR_DEFAULT_CANCEL_WAIT_MS 1000
+
+extern UINT32 rmDefaultCommandTimeoutMs;
+extern UINT32 rmCancelWaitMs;
+
+TSS2_RC ResMgrSetCommandTimeout( TPM_CC commandCode, UINT32 timeoutMs );
+UINT32 ResMgrGetCommandTimeout( TPM_CC commandCode );
+
+typedef struct {
+    UINT64 commands;            // commands handled
+    UINT64 retriedCommands;     // commands resent at least once
+    UINT64 retries;             // resends
+    UINT64 retriesExhausted;    // commands given up on after rmRetryLimit resends
+    UINT64 retrySleepUs;        // time spent sleeping before resends
+    UINT64 timeouts;            // commands canceled for taking too long
+    UINT64 abandoned;           // canceled commands the TPM didn't answer in time
+} RESMGR_STATS;
+
+void ResMgrGetStats( RESMGR_STATS *stats );
+
+// The RM can drive several TPMs, or backends; the first one added is the
+// primary.  Sessions, persistent objects and the hierarchies live in the
+// primary.  An object loaded with LoadExternal in the NULL hierarchy goes
+// to the least loaded backend, and commands naming it follow it there.
+// Commands that use no state the RM manages run on the least loaded
+// backend without waiting for tpmMutex, so they scale with the number of
+// TPMs.
+#define RESMGR_MAX_BACKENDS 4
+
+TSS2_RC ResMgrAddBackend( TSS2_TCTI_CONTEXT *tctiContext );
+
+// Runs a client command through the RM's tables, on the backend that
+// holds what it names; the caller holds tpmMutex.
+TSS2_RC ResMgrExecuteCommand(
+    SOCKET              connectSock,
+    UINT8               locality,
+    uint8_t             *command_buffer,    /* in */
+    UINT32              command_size,
+    uint8_t             *response_buffer,   /* out */
+    UINT32              *response_size      /* in/out */
+    );
+
+// GetRandom, TestParms, Hash in the NULL hierarchy and GetCapability for
+// anything but handles, sent without sessions.
+UINT8 ResMgrStatelessCommand( const uint8_t *command_buffer, UINT32 command_size );
+
+// Sends a command ResMgrStatelessCommand accepts to the least loaded
+// backend; the caller need not hold tpmMutex.
+TSS2_RC ResMgrSendStatelessCommand(
+    UINT8               locality,
+    uint8_t             *command_buffer,    /* in */
+    UINT32              command_size,
+    uint8_t             *response_buffer,   /* out */
+    UINT32              *response_size      /* in/out */
+    );
+
+// With a store, the RM keeps a copy of its table for the primary in a
+// file, so that a restarted RM can take back the objects, sequences and
+// sessions whose contexts the TPM still accepts, which it does until the
+// TPM is reset or restarted.  ResMgrOpenStore is called once the RM is
+// initialized; the entries it restores belong to no connection until a
+// client reattaches with the token their connection had.
+#define RESMGR_STORE_CAPACITY 1024
+
+TSS2_RC ResMgrOpenStore( const char *fileName );
+void ResMgrCloseStore( void );
+
+// Gives connectionId a reattach token, kept with its entities in the store.
+// If *token is 0, a new one is made and returned in it; otherwise the
+// restored entities left with that token become connectionId's.  The
+// caller holds tpmMutex.
+TSS2_RC ResMgrReattach( UINT64 connectionId, UINT64 *token );
+
 // Uncommentting DEBUG_GAP_HANDLING instruments the max active sessions and gap
 // max values to something small that allows us to debug this feature.
 //
@@ -97,6 +200,11 @@ void ResourceMgrInit( int debugLevel );
 #define DEBUG_GAP_MAX   255
 #endif
 
+// If set, InitResourceMgr keeps the TPM's command attributes in this file
+// and reads them from the TPM only when its manufacturer or firmware
+// version changes.
+extern const char *rmCommandCacheFile;
+
 TSS2_RC InitResMgr( int debugLevel );
 
 #ifdef __cplusplus
@@ -0,0 +1,297 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <sapi/tpm20.h>
+#include "rmstore.h"
+
+#define RM_STORE_MAGIC 0x524d5354     // "RMST"
+
+typedef struct {
+    UINT32 magic;
+    UINT32 entrySize;
+    UINT64 generation;
+    UINT32 count;
+    UINT32 reserved;
+    RM_STORE_STATE state;
+    UINT64 checksum;        // Over the rest of the header and the entries' checksums.
+} RM_STORE_IMAGE;
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static UINT8 *storeMap = 0;
+static size_t storeMapSize;
+static size_t imageSize;
+static UINT32 storeCapacity;
+static int storeFd = -1;
+static int currentImage = -1;      // -1 when neither image is complete.
+
+// How many leading entries of each image are known to match their
+// checksums, and so can be kept by RmStorePut if unchanged.
+static UINT32 checkedCount[2];
+
+static RM_STORE_IMAGE *Image( int i )
+{
+    return (RM_STORE_IMAGE *)( storeMap + i * imageSize );
+}
+
+static RM_STORE_ENTRY *ImageEntries( int i )
+{
+    return (RM_STORE_ENTRY *)( storeMap + i * imageSize + sizeof( RM_STORE_IMAGE ) );
+}
+
+// FNV-1a, taken a word at a time where it can be.
+static UINT64 Checksum( UINT64 hash, const UINT8 *data, size_t size )
+{
+    UINT64 word;
+
+    for( ; size >= sizeof( word ); size -= sizeof( word ), data += sizeof( word ) )
+    {
+        memcpy( &word, data, sizeof( word ) );
+        hash ^= word;
+        hash *= FNV_PRIME;
+    }
+    while( size-- != 0 )
+    {
+        hash ^= *data++;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// Bytes of an entry that are in use: the fixed fields, and the context up
+// to the end of its blob.  The blob size must already be known to fit.
+static size_t EntryUsedSize( const RM_STORE_ENTRY *entry )
+{
+    return offsetof( RM_STORE_ENTRY, context.contextBlob.t.buffer ) + entry->context.contextBlob.t.size;
+}
+
+static UINT64 EntryChecksum( const RM_STORE_ENTRY *entry )
+{
+    const UINT8 *start = (const UINT8 *)entry + offsetof( RM_STORE_ENTRY, virtualHandle );
+
+    return Checksum( FNV_OFFSET_BASIS, start, EntryUsedSize( entry ) - offsetof( RM_STORE_ENTRY, virtualHandle ) );
+}
+
+static UINT64 ImageChecksum( int i )
+{
+    RM_STORE_IMAGE *image = Image( i );
+    RM_STORE_ENTRY *entries = ImageEntries( i );
+    UINT64 hash = FNV_OFFSET_BASIS;
+    UINT32 j;
+
+    hash = Checksum( hash, (UINT8 *)image, offsetof( RM_STORE_IMAGE, checksum ) );
+    for( j = 0; j < image->count; j++ )
+    {
+        hash ^= entries[j].checksum;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static UINT8 ImageComplete( int i )
+{
+    RM_STORE_IMAGE *image = Image( i );
+    RM_STORE_ENTRY *entries = ImageEntries( i );
+    UINT32 j;
+
+    if( image->magic != RM_STORE_MAGIC ||
+            image->entrySize != sizeof( RM_STORE_ENTRY ) ||
+            image->count > storeCapacity ||
+            image->checksum != ImageChecksum( i ) )
+    {
+        return 0;
+    }
+
+    for( j = 0; j < image->count; j++ )
+    {
+        if( entries[j].context.contextBlob.t.size > sizeof( entries[j].context.contextBlob.t.buffer ) ||
+                entries[j].checksum != EntryChecksum( &entries[j] ) )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int RmStoreOpen( const char *fileName, UINT32 capacity )
+{
+    struct stat status;
+    int i;
+
+    if( storeMap != 0 || capacity == 0 )
+        return -1;
+
+    imageSize = sizeof( RM_STORE_IMAGE ) + (size_t)capacity * sizeof( RM_STORE_ENTRY );
+    storeMapSize = 2 * imageSize;
+    storeCapacity = capacity;
+
+    storeFd = open( fileName, O_RDWR | O_CREAT, 0600 );
+    if( storeFd < 0 )
+        return -1;
+
+    if( fstat( storeFd, &status ) != 0 ||
+            ( (size_t)status.st_size != storeMapSize &&
+              ( ftruncate( storeFd, 0 ) != 0 || ftruncate( storeFd, storeMapSize ) != 0 ) ) )
+    {
+        goto fail;
+    }
+
+    storeMap = mmap( 0, storeMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, storeFd, 0 );
+    if( storeMap == MAP_FAILED )
+    {
+        storeMap = 0;
+        goto fail;
+    }
+
+    currentImage = -1;
+    for( i = 0; i < 2; i++ )
+    {
+        checkedCount[i] = 0;
+        if( ImageComplete( i ) &&
+                ( currentImage == -1 || Image( i )->generation > Image( currentImage )->generation ) )
+        {
+            currentImage = i;
+        }
+    }
+    if( currentImage != -1 )
+        checkedCount[currentImage] = Image( currentImage )->count;
+
+    return 0;
+
+fail:
+    close( storeFd );
+    storeFd = -1;
+    return -1;
+}
+
+void RmStoreClose( void )
+{
+    if( storeMap == 0 )
+        return;
+
+    munmap( storeMap, storeMapSize );
+    close( storeFd );
+    storeMap = 0;
+    storeFd = -1;
+    currentImage = -1;
+}
+
+const RM_STORE_ENTRY *RmStoreCurrent( RM_STORE_STATE *state, UINT32 *count )
+{
+    if( storeMap == 0 || currentImage == -1 )
+        return 0;
+
+    *state = Image( currentImage )->state;
+    *count = Image( currentImage )->count;
+    return ImageEntries( currentImage );
+}
+
+RM_STORE_ENTRY *RmStoreBegin( UINT32 count )
+{
+    if( storeMap == 0 || count > storeCapacity )
+        return 0;
+
+    return ImageEntries( currentImage == 0 ? 1 : 0 );
+}
+
+void RmStorePut( UINT32 index, TPM_HANDLE virtualHandle, TPM_HANDLE realHandle,
+        TPM_HANDLE parentHandle, TPMI_RH_HIERARCHY hierarchy, UINT64 token, UINT8 stClear,
+        const TPMS_CONTEXT *context )
+{
+    int next = currentImage == 0 ? 1 : 0;
+    RM_STORE_ENTRY *entry;
+    size_t contextSize;
+
+    if( storeMap == 0 || index >= storeCapacity ||
+            context->contextBlob.t.size > sizeof( context->contextBlob.t.buffer ) )
+    {
+        return;
+    }
+
+    entry = &ImageEntries( next )[index];
+    contextSize = offsetof( TPMS_CONTEXT, contextBlob.t.buffer ) + context->contextBlob.t.size;
+
+    if( index < checkedCount[next] &&
+            entry->virtualHandle == virtualHandle &&
+            entry->realHandle == realHandle &&
+            entry->parentHandle == parentHandle &&
+            entry->hierarchy == hierarchy &&
+            entry->token == token &&
+            entry->stClear == stClear &&
+            memcmp( &entry->context, context, contextSize ) == 0 )
+    {
+        return;
+    }
+
+    entry->virtualHandle = virtualHandle;
+    entry->realHandle = realHandle;
+    entry->parentHandle = parentHandle;
+    entry->hierarchy = hierarchy;
+    entry->token = token;
+    entry->stClear = stClear;
+    memcpy( &entry->context, context, contextSize );
+    entry->checksum = EntryChecksum( entry );
+}
+
+//
+// The checksum is written last.  If the RM dies before that, the image
+// being written doesn't check out and the previous one stays current.
+// Nothing needs to reach the disk for that: after a crash of the RM the
+// kernel still has the pages, and a power loss resets the TPM, which
+// makes every saved context useless anyway.
+//
+void RmStoreCommit( const RM_STORE_STATE *state, UINT32 count )
+{
+    int next = currentImage == 0 ? 1 : 0;
+    RM_STORE_IMAGE *image;
+
+    if( storeMap == 0 || count > storeCapacity )
+        return;
+
+    image = Image( next );
+
+    image->magic = RM_STORE_MAGIC;
+    image->entrySize = sizeof( RM_STORE_ENTRY );
+    image->generation = currentImage == -1 ? 1 : Image( currentImage )->generation + 1;
+    image->count = count;
+    image->reserved = 0;
+    image->state = *state;
+    __sync_synchronize();
+    image->checksum = ImageChecksum( next );
+
+    checkedCount[next] = count;
+    currentImage = next;
+}
@@ -0,0 +1,102 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+
+#ifndef RM_STORE_H
+#define RM_STORE_H
+
+#include <sapi/tpm20.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// File-backed copy of the resource manager's table, so that a restarted
+// RM can give clients back the objects, sequences and sessions they had.
+//
+// The file is mapped and holds two images of the table.  Each commit
+// writes the image not in use and then marks it current with a higher
+// generation and a checksum over its contents, so a crash part way
+// through a commit leaves the previous image in force.  Every entry has
+// its own checksum, over only the part of its context blob in use, so a
+// commit rewrites and rehashes just the entries that changed since that
+// image was last written.
+//
+
+// One table entry.  Entries are only ever read back by the process that
+// wrote them, or a later build of it on the same machine, so they are
+// stored as laid out in memory; a change of layout invalidates the file.
+typedef struct {
+    UINT64 checksum;                // Over the rest of the entry, up to the end of the blob in use.
+    TPM_HANDLE virtualHandle;
+    TPM_HANDLE realHandle;
+    TPM_HANDLE parentHandle;
+    TPMI_RH_HIERARCHY hierarchy;
+    UINT64 token;                   // Reattach token of the owning connection; 0 if none.
+    UINT8 stClear;
+    TPMS_CONTEXT context;
+} RM_STORE_ENTRY;
+
+// Identifies the TPM boot the contexts were saved in; they are good only
+// while resetCount and restartCount stay the same.
+typedef struct {
+    UINT32 resetCount;
+    UINT32 restartCount;
+    UINT64 lastSessionSequenceNum;
+} RM_STORE_STATE;
+
+// Maps fileName, creating it for capacity entries if need be.  A file
+// made for another capacity or entry layout is emptied.  Returns 0 on
+// success.
+int RmStoreOpen( const char *fileName, UINT32 capacity );
+
+void RmStoreClose( void );
+
+// The current image's entries, or 0 if there is no complete image.
+const RM_STORE_ENTRY *RmStoreCurrent( RM_STORE_STATE *state, UINT32 *count );
+
+// Space for count entries in the image being written, or 0 if count is
+// more than the capacity.  The current image is untouched until
+// RmStoreCommit.  The entries are filled in with RmStorePut.
+RM_STORE_ENTRY *RmStoreBegin( UINT32 count );
+
+// Sets entry index of the image being written.  Only the used part of
+// context's blob is copied; an entry the same as what the slot already
+// holds is left alone.
+void RmStorePut( UINT32 index, TPM_HANDLE virtualHandle, TPM_HANDLE realHandle,
+        TPM_HANDLE parentHandle, TPMI_RH_HIERARCHY hierarchy, UINT64 token, UINT8 stClear,
+        const TPMS_CONTEXT *context );
+
+// Makes the image filled in since RmStoreBegin current.
+void RmStoreCommit( const RM_STORE_STATE *state, UINT32 count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
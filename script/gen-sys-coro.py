@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+# Generates include/sapi/tss2_sys_coro_commands.hpp, the command methods of
+# the C++ coroutine layer in tss2_sys_coro.hpp, from the _Prepare, _Complete
+# and one-call prototypes in include/sapi/sys_api_part3.h.
+#
+# Run from the top of the source tree after changing sys_api_part3.h:
+#
+#     python3 script/gen-sys-coro.py
+#
+import re
+import sys
+
+PART3 = 'include/sapi/sys_api_part3.h'
+TYPE_HEADERS = ['include/sapi/tss2_tpm2_types.h', 'include/sapi/implementation.h']
+CORO = 'include/sapi/tss2_sys_coro.hpp'
+OUTPUT = 'include/sapi/tss2_sys_coro_commands.hpp'
+
+CXX_KEYWORDS = {'class', 'delete', 'new', 'operator', 'private', 'protected',
+                'public', 'template', 'this', 'typename', 'virtual'}
+
+
+def prototypes(text):
+    functions = {}
+    for match in re.finditer(r'TPM_RC\s+Tss2_Sys_(\w+)\s*\((.*?)\)\s*;', text, re.S):
+        params = []
+        for param in match.group(2).split(',')[1:]:     # drop sysContext
+            param = re.sub(r'\s+', ' ', param).strip()
+            name = re.search(r'(\w+)$', param).group(1)
+            if name in CXX_KEYWORDS:
+                sys.exit('%s: parameter %s is a C++ keyword' % (match.group(1), name))
+            params.append((param[:-len(name)].strip(), name))
+        functions[match.group(1)] = params
+    return functions
+
+
+def byte_buffers():
+    # TPM2B types holding a byte array: their _Complete output must come in
+    # with size set to the capacity.  The others must come in with size 0.
+    buffers = {}
+    for header in TYPE_HEADERS:
+        text = open(header).read()
+        for name, field in re.findall(r'^TPM2B_TYPE1\(\s*(\w+)\s*,.*?,\s*(\w+)\s*\);', text, re.M):
+            buffers['TPM2B_' + name] = field
+        for name in re.findall(r'^TPM2B_TYPE\(\s*(\w+)\s*,', text, re.M):
+            buffers['TPM2B_' + name] = 'buffer'
+    return buffers
+
+
+def generate(functions, buffers):
+    license = []
+    for line in open(CORO):
+        license.append(line)
+        if line.startswith('//****') and len(license) > 1:
+            break
+
+    out = license + [
+        '\n',
+        '// Generated by script/gen-sys-coro.py from sys_api_part3.h; do not edit.\n',
+        '// Included by tss2_sys_coro.hpp.\n',
+        '\n',
+        '#ifndef TSS2_SYS_CORO_COMMANDS_HPP\n',
+        '#define TSS2_SYS_CORO_COMMANDS_HPP\n',
+        '\n',
+        'namespace tss2 {\n',
+    ]
+    commands = sorted(name[:-len('_Prepare')] for name in functions if name.endswith('_Prepare'))
+    methods = []
+    outTypes = []
+
+    for command in commands:
+        prepare = functions[command + '_Prepare']
+        complete = functions.get(command + '_Complete')
+        oneCall = functions.get(command, [])
+        hasAuths = any(name == 'cmdAuthsArray' for _, name in oneCall)
+
+        if complete is None:
+            outType = 'NoOutput'
+        else:
+            outType = command + 'Out'
+            outTypes.append(outType)
+            out.append('\nstruct %s\n{\n' % outType)
+            for ctype, name in complete:
+                out.append('    %s %s;\n' % (ctype.rstrip('*').strip(), name))
+            out.append('\n    void Init()\n    {\n')
+            for ctype, name in complete:
+                base = ctype.rstrip('*').strip()
+                if base in buffers:
+                    out.append('        %s.t.size = sizeof( %s.t.%s );\n' % (name, name, buffers[base]))
+            out.append('    }\n};\n')
+
+        params = [ctype + name if ctype.endswith('*') else '%s %s' % (ctype, name)
+                  for ctype, name in prepare]
+        if hasAuths:
+            params += ['const TSS2_SYS_CMD_AUTHS *cmdAuths = 0',
+                       'TSS2_SYS_RSP_AUTHS *rspAuths = 0']
+        args = ', '.join(['sysContext'] + [name for _, name in prepare])
+
+        m = ['\n    Command< %s > %s(' % (outType, command)]
+        if params:
+            m.append('\n        ' + ',\n        '.join(params) + ' )\n')
+        else:
+            m.append(')\n')
+        m.append('    {\n')
+        m.append('        return Command< %s >( sysContext, scheduler,\n' % outType)
+        m.append('            Tss2_Sys_%s_Prepare( %s ),\n' % (command, args))
+        m.append('            %s,\n' % ('cmdAuths, rspAuths' if hasAuths else '0, 0'))
+        if complete is None:
+            m.append('            0 );\n')
+        else:
+            outArgs = ', '.join(['sysContext'] + ['&out->' + name for _, name in complete])
+            m.append('            []( TSS2_SYS_CONTEXT *sysContext, %s *out ) -> TSS2_RC\n' % outType)
+            m.append('            {\n')
+            m.append('                return Tss2_Sys_%s_Complete( %s );\n' % (command, outArgs))
+            m.append('            } );\n')
+        m.append('    }\n')
+        methods.append(''.join(m))
+
+    out.append('\n')
+    out.append('class Tpm : public TpmBase\n{\n')
+    out.append('public:\n')
+    out.append('    Tpm( TSS2_SYS_CONTEXT *sysContext, Scheduler &scheduler ) :\n')
+    out.append('        TpmBase( sysContext, scheduler )\n    {\n    }\n')
+    out += methods
+    out.append('};\n')
+
+    # Lets a compile test check every command's await path, not just the
+    # ones it happens to call.
+    out.append('\n#ifdef TSS2_SYS_CORO_INSTANTIATE_ALL\n')
+    out.append('template class Command< NoOutput >;\n')
+    for outType in outTypes:
+        out.append('template class Command< %s >;\n' % outType)
+    out.append('#endif\n')
+    out.append('\n} // namespace tss2\n\n#endif\n')
+
+    return ''.join(out), len(commands)
+
+
+def main():
+    functions = prototypes(open(PART3).read())
+    text, count = generate(functions, byte_buffers())
+    open(OUTPUT, 'w').write(text)
+    print('%s: %d commands' % (OUTPUT, count))
+
+
+if __name__ == '__main__':
+    main()
@@ -50,6 +50,18 @@ UINT16 ChangeEndianWord( UINT16 p );
 #define CHANGE_ENDIAN_DWORD(p) ( ChangeEndianDword(p) )
 
 #define CHANGE_ENDIAN_QWORD(p) ( ChangeEndianQword(p) )
+
+// Byte swaps for the fixed-size marshalling fast path.  These expand
+// inline so the compiler can fold them into a single bswap/movbe.
+#if defined(__GNUC__)
+#define FAST_ENDIAN_WORD(p)  ( __builtin_bswap16 (p) )
+#define FAST_ENDIAN_DWORD(p) ( __builtin_bswap32 (p) )
+#define FAST_ENDIAN_QWORD(p) ( __builtin_bswap64 (p) )
+#else
+#define FAST_ENDIAN_WORD(p)  CHANGE_ENDIAN_WORD(p)
+#define FAST_ENDIAN_DWORD(p) CHANGE_ENDIAN_DWORD(p)
+#define FAST_ENDIAN_QWORD(p) CHANGE_ENDIAN_QWORD(p)
+#endif
 #else
  // If CPU is big-endian, no need to do endianness swapping.
 
@@ -58,6 +70,12 @@ UINT16 ChangeEndianWord( UINT16 p );
 #define CHANGE_ENDIAN_DWORD(p) p
 
 #define CHANGE_ENDIAN_QWORD(p) p
+
+#define FAST_ENDIAN_WORD(p)  p
+
+#define FAST_ENDIAN_DWORD(p) p
+
+#define FAST_ENDIAN_QWORD(p) p
 #endif
 
 #ifdef __cplusplus
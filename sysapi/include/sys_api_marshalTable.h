@@ -0,0 +1,134 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TSS2_SYS_API_MARSHAL_TABLE_H
+#define TSS2_SYS_API_MARSHAL_TABLE_H
+
+//
+// Table-driven marshalling.
+//
+// Each structure type is described by a constant MARSHAL_TYPE: a list of
+// MARSHAL_FIELD entries giving the kind of each field, its offset within the
+// structure and, for lists and unions, where to find the element count or
+// the union selector.  Marshal_Table / Unmarshal_Table walk these tables in a
+// single loop and produce exactly the same wire format as the hand-written
+// Marshal_* / Unmarshal_* functions.
+//
+// Scalar kinds are equal to their size on the wire, so a field's kind is
+// also the number of bytes it occupies.  Bit-field attribute types (TPMA_*)
+// are described as scalars of the same size.
+//
+typedef enum
+{
+    MARSHAL_KIND_UINT8 = 1,
+    MARSHAL_KIND_UINT16 = 2,
+    MARSHAL_KIND_UINT32 = 4,
+    MARSHAL_KIND_UINT64 = 8,
+    MARSHAL_KIND_TPM2B,     // Simple TPM2B: UINT16 size followed by bytes.
+    MARSHAL_KIND_STRUCT,    // Nested structure described by 'type'.
+    MARSHAL_KIND_ARRAY,     // Counted array of scalars or structures.
+    MARSHAL_KIND_UNION      // Union; arm chosen by the selector field.
+} MARSHAL_KIND;
+
+typedef struct
+{
+    UINT8       kind;           // MARSHAL_KIND_*
+    UINT8       elementKind;    // ARRAY: kind of each element (scalar or STRUCT).
+    UINT8       selectorSize;   // ARRAY, UNION: size of the count / selector field.
+    UINT16      offset;         // Offset of this field within the structure.
+    UINT16      selector;       // ARRAY, UNION: offset of the count / selector field.
+    UINT16      capacity;       // ARRAY: max number of elements; TPM2B: buffer size.
+    UINT16      elementSize;    // ARRAY: in-memory size of one element.
+    const void  *type;          // STRUCT, ARRAY of STRUCT: MARSHAL_TYPE; UNION: MARSHAL_UNION.
+} MARSHAL_FIELD;
+
+typedef struct
+{
+    UINT16      fixedSize;      // Wire size if every field is a scalar, else 0.
+    UINT16      fieldCount;
+    const MARSHAL_FIELD *fields;
+} MARSHAL_TYPE;
+
+typedef struct
+{
+    UINT32      selector;
+    const MARSHAL_TYPE *type;
+} MARSHAL_UNION_ARM;
+
+typedef struct
+{
+    UINT16      armCount;
+    const MARSHAL_UNION_ARM *arms;
+} MARSHAL_UNION;
+
+void Marshal_Table( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_TYPE *type, const void *value, TSS2_RC *rval );
+void Unmarshal_Table( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_TYPE *type, void *value, TSS2_RC *rval );
+
+#define MARSHAL_TABLE( sysContext, type, value ) \
+    Marshal_Table( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &( SYS_CONTEXT->nextData ), type, value, &(SYS_CONTEXT->rval ) )
+
+#define UNMARSHAL_TABLE( sysContext, type, value ) \
+    Unmarshal_Table( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &( SYS_CONTEXT->nextData ), type, value, &(SYS_CONTEXT->rval ) )
+
+// Type descriptors, defined in marshal_table_types.c.
+extern const MARSHAL_TYPE MarshalType_TPMS_PCR_SELECTION;
+extern const MARSHAL_TYPE MarshalType_TPML_PCR_SELECTION;
+extern const MARSHAL_TYPE MarshalType_TPMS_CLOCK_INFO;
+extern const MARSHAL_TYPE MarshalType_TPMS_TIME_INFO;
+extern const MARSHAL_TYPE MarshalType_TPM2B_DIGEST;
+extern const MARSHAL_TYPE MarshalType_TPML_DIGEST;
+extern const MARSHAL_TYPE MarshalType_TPMS_CONTEXT;
+extern const MARSHAL_TYPE MarshalType_TPMS_TAGGED_PROPERTY;
+extern const MARSHAL_TYPE MarshalType_TPML_TAGGED_TPM_PROPERTY;
+extern const MARSHAL_TYPE MarshalType_TPMS_ALG_PROPERTY;
+extern const MARSHAL_TYPE MarshalType_TPML_ALG_PROPERTY;
+extern const MARSHAL_TYPE MarshalType_TPML_HANDLE;
+extern const MARSHAL_TYPE MarshalType_TPML_CC;
+extern const MARSHAL_TYPE MarshalType_TPML_CCA;
+extern const MARSHAL_TYPE MarshalType_TPMS_TAGGED_PCR_SELECT;
+extern const MARSHAL_TYPE MarshalType_TPML_TAGGED_PCR_PROPERTY;
+extern const MARSHAL_TYPE MarshalType_TPML_ECC_CURVE;
+extern const MARSHAL_TYPE MarshalType_TPMS_CAPABILITY_DATA;
+extern const MARSHAL_TYPE MarshalType_UINT16;
+extern const MARSHAL_TYPE MarshalType_TPMS_SCHEME_HASH;
+extern const MARSHAL_TYPE MarshalType_TPMS_SCHEME_ECDAA;
+extern const MARSHAL_TYPE MarshalType_TPMS_SCHEME_XOR;
+extern const MARSHAL_TYPE MarshalType_TPMT_KEYEDHASH_SCHEME;
+extern const MARSHAL_TYPE MarshalType_TPMS_KEYEDHASH_PARMS;
+extern const MARSHAL_TYPE MarshalType_TPMT_SYM_DEF_OBJECT;
+extern const MARSHAL_TYPE MarshalType_TPMS_SYMCIPHER_PARMS;
+extern const MARSHAL_TYPE MarshalType_TPMT_RSA_SCHEME;
+extern const MARSHAL_TYPE MarshalType_TPMT_ECC_SCHEME;
+extern const MARSHAL_TYPE MarshalType_TPMT_KDF_SCHEME;
+extern const MARSHAL_TYPE MarshalType_TPMS_RSA_PARMS;
+extern const MARSHAL_TYPE MarshalType_TPMS_ECC_PARMS;
+extern const MARSHAL_TYPE MarshalType_TPMT_PUBLIC_PARMS;
+extern const MARSHAL_TYPE MarshalType_TPM2B_PUBLIC_KEY_RSA;
+extern const MARSHAL_TYPE MarshalType_TPMS_ECC_POINT;
+extern const MARSHAL_TYPE MarshalType_TPMT_PUBLIC;
+
+#endif
@@ -28,9 +28,14 @@
 #ifndef TSS2_SYS_API_MARSHAL_UNMARSHAL_H
 #define TSS2_SYS_API_MARSHAL_UNMARSHAL_H
 
+#include <string.h>
+#include "endianConv.h"
+
 void Marshal_Simple_TPM2B( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, TPM2B *value, TSS2_RC *rval );
 void Unmarshal_Simple_TPM2B( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TPM2B *value, TSS2_RC *rval );
 void Unmarshal_Simple_TPM2B_NoSizeCheck( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TPM2B *value, TSS2_RC *rval );
+void Unmarshal_TPM2B_View( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TSS2_SYS_BUFFER_VIEW *view, TSS2_RC *rval );
+void Unmarshal_TPMS_CONTEXT_View( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TSS2_SYS_CONTEXT_VIEW *view, TSS2_RC *rval );
 void Marshal_UINT64( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, UINT64 value, TSS2_RC *rval );
 void Marshal_UINT32( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, UINT32 value, TSS2_RC *rval );
 void Marshal_UINT16( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, UINT16 value, TSS2_RC *rval );
@@ -44,6 +49,80 @@ void Unmarshal_TPMS_EMPTY( TSS2_SYS_CONTEXT *sysContext, TPMS_EMPTY *empty );
 
 TSS2_RC CheckOverflow( UINT8 *buffer, UINT32 bufferSize, UINT8 *nextData, UINT32 size );
 TSS2_RC CheckDataPointers( UINT8 *buffer, UINT8 **nextData );
+TSS2_RC CheckFixedRegion( UINT8 *buffer, UINT32 bufferSize, UINT8 **nextData, UINT32 size, TSS2_RC *rval );
+
+//
+// Fixed-size fast path.
+//
+// When the size of a run of fields is known up front (handles, UINT16/32/64
+// parameters, fixed structure prefixes), call CheckFixedRegion once for the
+// whole run and then use the Put_* / Get_* helpers below.  These do no
+// pointer, overflow or rval checks of their own; they must only be used
+// after CheckFixedRegion has returned TSS2_RC_SUCCESS for at least as many
+// bytes as they consume.  Variable-size data (TPM2Bs, lists, unions) keeps
+// going through the checked Marshal_* / Unmarshal_* functions.
+//
+static inline void Put_UINT8( UINT8 **nextData, UINT8 value )
+{
+    **nextData = value;
+    *nextData += sizeof( UINT8 );
+}
+
+static inline void Put_UINT16( UINT8 **nextData, UINT16 value )
+{
+    value = FAST_ENDIAN_WORD( value );
+    memcpy( *nextData, &value, sizeof( UINT16 ) );
+    *nextData += sizeof( UINT16 );
+}
+
+static inline void Put_UINT32( UINT8 **nextData, UINT32 value )
+{
+    value = FAST_ENDIAN_DWORD( value );
+    memcpy( *nextData, &value, sizeof( UINT32 ) );
+    *nextData += sizeof( UINT32 );
+}
+
+static inline void Put_UINT64( UINT8 **nextData, UINT64 value )
+{
+    value = FAST_ENDIAN_QWORD( value );
+    memcpy( *nextData, &value, sizeof( UINT64 ) );
+    *nextData += sizeof( UINT64 );
+}
+
+static inline UINT8 Get_UINT8( UINT8 **nextData )
+{
+    UINT8 value = **nextData;
+
+    *nextData += sizeof( UINT8 );
+    return value;
+}
+
+static inline UINT16 Get_UINT16( UINT8 **nextData )
+{
+    UINT16 value;
+
+    memcpy( &value, *nextData, sizeof( UINT16 ) );
+    *nextData += sizeof( UINT16 );
+    return FAST_ENDIAN_WORD( value );
+}
+
+static inline UINT32 Get_UINT32( UINT8 **nextData )
+{
+    UINT32 value;
+
+    memcpy( &value, *nextData, sizeof( UINT32 ) );
+    *nextData += sizeof( UINT32 );
+    return FAST_ENDIAN_DWORD( value );
+}
+
+static inline UINT64 Get_UINT64( UINT8 **nextData )
+{
+    UINT64 value;
+
+    memcpy( &value, *nextData, sizeof( UINT64 ) );
+    *nextData += sizeof( UINT64 );
+    return FAST_ENDIAN_QWORD( value );
+}
 
 
 // Macro for unmarshalling/marshalling in SYSAPI code.  We needed access to generic base functions in resource manager and
@@ -54,6 +133,12 @@ TSS2_RC CheckDataPointers( UINT8 *buffer, UINT8 **nextData );
 #define UNMARSHAL_SIMPLE_TPM2B_NO_SIZE_CHECK( sysContext, value ) \
     Unmarshal_Simple_TPM2B_NoSizeCheck( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &( SYS_CONTEXT->nextData ), value, &(SYS_CONTEXT->rval ) )
 
+#define UNMARSHAL_TPM2B_VIEW( sysContext, view ) \
+    Unmarshal_TPM2B_View( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &( SYS_CONTEXT->nextData ), view, &(SYS_CONTEXT->rval ) )
+
+#define UNMARSHAL_TPMS_CONTEXT_VIEW( sysContext, view ) \
+    Unmarshal_TPMS_CONTEXT_View( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &( SYS_CONTEXT->nextData ), view, &(SYS_CONTEXT->rval ) )
+
 #define UNMARSHAL_TPMS_CONTEXT( sysContext, value ) \
     Unmarshal_TPMS_CONTEXT( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &( SYS_CONTEXT->nextData ), value, &(SYS_CONTEXT->rval ) )
 
@@ -315,11 +400,6 @@ void Marshal_TPMA_ALGORITHM(
 	TPMA_ALGORITHM algorithm
 	);
 
-void Marshal_TPMA_OBJECT(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMA_OBJECT object
-	);
-
 void Marshal_TPMA_SESSION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMA_SESSION session
@@ -373,11 +453,6 @@ void Marshal_TPMU_SYM_MODE(
 	UINT32 selector
 	);
 
-void Marshal_TPMS_SYMCIPHER_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_SYMCIPHER_PARMS *symcipherParms
-	);
-
 void Marshal_TPMS_SENSITIVE_CREATE(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_SENSITIVE_CREATE *sensitiveCreate
@@ -393,60 +468,23 @@ void Marshal_TPMS_SCHEME_ECDAA(
 	TPMS_SCHEME_ECDAA *schemeEcdaa
 	);
 
-void Marshal_TPMS_SCHEME_XOR(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_SCHEME_XOR *schemeXor
-	);
-
-void Marshal_TPMU_SCHEME_KEYEDHASH(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_SCHEME_KEYEDHASH *schemeKeyedhash,
-	UINT32 selector
-	);
-
-void Marshal_TPMT_KEYEDHASH_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_KEYEDHASH_SCHEME *keyedhashScheme
-	);
-
 void Marshal_TPMU_SIG_SCHEME(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMU_SIG_SCHEME *sigScheme,
 	UINT32 selector
 	);
 
-void Marshal_TPMU_KDF_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_KDF_SCHEME *kdfScheme,
-	UINT32 selector
-	);
-
-void Marshal_TPMT_KDF_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_KDF_SCHEME *kdfScheme
-	);
-
 void Marshal_TPMU_ASYM_SCHEME(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMU_ASYM_SCHEME *asymScheme,
 	UINT32 selector
 	);
 
-void Marshal_TPMT_RSA_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_RSA_SCHEME *rsaScheme
-	);
-
 void Marshal_TPMS_ECC_POINT(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_ECC_POINT *eccPoint
 	);
 
-void Marshal_TPMT_ECC_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_ECC_SCHEME *eccScheme
-	);
-
 void Marshal_TPMS_SIGNATURE_RSA(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_SIGNATURE_RSA *signatureRsa
@@ -463,38 +501,6 @@ void Marshal_TPMU_SIGNATURE(
 	UINT32 selector
 	);
 
-void Marshal_TPMU_PUBLIC_ID(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_PUBLIC_ID *publicVarId,
-	UINT32 selector
-	);
-
-void Marshal_TPMS_KEYEDHASH_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_KEYEDHASH_PARMS *keyedhashParms
-	);
-
-void Marshal_TPMS_RSA_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_RSA_PARMS *rsaParms
-	);
-
-void Marshal_TPMS_ECC_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_ECC_PARMS *eccParms
-	);
-
-void Marshal_TPMU_PUBLIC_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_PUBLIC_PARMS *publicVarParms,
-	UINT32 selector
-	);
-
-void Marshal_TPMT_PUBLIC(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_PUBLIC *publicVar
-	);
-
 void Marshal_TPMU_SENSITIVE_COMPOSITE(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMU_SENSITIVE_COMPOSITE *sensitiveComposite,
@@ -621,11 +627,6 @@ void Unmarshal_TPMA_ALGORITHM(
 	TPMA_ALGORITHM *algorithm
 	);
 
-void Unmarshal_TPMA_OBJECT(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMA_OBJECT *object
-	);
-
 void Unmarshal_TPMA_SESSION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMA_SESSION *session
@@ -672,62 +673,6 @@ void Unmarshal_TPMS_PCR_SELECTION(
 	TPMS_PCR_SELECTION *pcrSelection
 	);
 
-void Unmarshal_TPMS_ALG_PROPERTY(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_ALG_PROPERTY *algProperty
-	);
-
-void Unmarshal_TPMS_TAGGED_PROPERTY(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_TAGGED_PROPERTY *taggedProperty
-	);
-
-void Unmarshal_TPMS_TAGGED_PCR_SELECT(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_TAGGED_PCR_SELECT *taggedPcrSelect
-	);
-
-void Unmarshal_TPML_CC(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_CC *cc
-	);
-
-void Unmarshal_TPML_CCA(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_CCA *cca
-	);
-
-void Unmarshal_TPML_HANDLE(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_HANDLE *handle
-	);
-
-void Unmarshal_TPML_ALG_PROPERTY(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_ALG_PROPERTY *algProperty
-	);
-
-void Unmarshal_TPML_TAGGED_TPM_PROPERTY(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_TAGGED_TPM_PROPERTY *taggedTpmProperty
-	);
-
-void Unmarshal_TPML_TAGGED_PCR_PROPERTY(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_TAGGED_PCR_PROPERTY *taggedPcrProperty
-	);
-
-void Unmarshal_TPML_ECC_CURVE(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPML_ECC_CURVE *eccCurve
-	);
-
-void Unmarshal_TPMU_CAPABILITIES(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_CAPABILITIES *capabilities,
-	UINT32 selector
-	);
-
 void Unmarshal_TPMS_CLOCK_INFO(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_CLOCK_INFO *clockInfo
@@ -801,16 +746,6 @@ void Unmarshal_TPMT_SYM_DEF(
 	TPMT_SYM_DEF *symDef
 	);
 
-void Unmarshal_TPMT_SYM_DEF_OBJECT(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_SYM_DEF_OBJECT *symDefObject
-	);
-
-void Unmarshal_TPMS_SYMCIPHER_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_SYMCIPHER_PARMS *symcipherParms
-	);
-
 void Unmarshal_TPMS_SCHEME_HASH(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_SCHEME_HASH *schemeHash
@@ -821,22 +756,6 @@ void Unmarshal_TPMS_SCHEME_ECDAA(
 	TPMS_SCHEME_ECDAA *schemeEcdaa
 	);
 
-void Unmarshal_TPMS_SCHEME_XOR(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_SCHEME_XOR *schemeXor
-	);
-
-void Unmarshal_TPMU_SCHEME_KEYEDHASH(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_SCHEME_KEYEDHASH *schemeKeyedhash,
-	UINT32 selector
-	);
-
-void Unmarshal_TPMT_KEYEDHASH_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_KEYEDHASH_SCHEME *keyedhashScheme
-	);
-
 void Unmarshal_TPMU_SIG_SCHEME(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMU_SIG_SCHEME *sigScheme,
@@ -865,11 +784,6 @@ void Unmarshal_TPMU_ASYM_SCHEME(
 	UINT32 selector
 	);
 
-void Unmarshal_TPMT_RSA_SCHEME(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_RSA_SCHEME *rsaScheme
-	);
-
 void Unmarshal_TPMT_RSA_DECRYPT(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMT_RSA_DECRYPT *rsaDecrypt
@@ -901,43 +815,11 @@ void Unmarshal_TPMU_SIGNATURE(
 	UINT32 selector
 	);
 
-void Unmarshal_TPMU_PUBLIC_ID(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_PUBLIC_ID *publicVarId,
-	UINT32 selector
-	);
-
-void Unmarshal_TPMS_KEYEDHASH_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_KEYEDHASH_PARMS *keyedhashParms
-	);
-
-void Unmarshal_TPMS_RSA_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_RSA_PARMS *rsaParms
-	);
-
-void Unmarshal_TPMS_ECC_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMS_ECC_PARMS *eccParms
-	);
-
-void Unmarshal_TPMU_PUBLIC_PARMS(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMU_PUBLIC_PARMS *publicVarParms,
-	UINT32 selector
-	);
-
 void Unmarshal_TPMT_PUBLIC_PARMS(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMT_PUBLIC_PARMS *publicVarParms
 	);
 
-void Unmarshal_TPMT_PUBLIC(
-	TSS2_SYS_CONTEXT *sysContext,
-	TPMT_PUBLIC *publicVar
-	);
-
 void Unmarshal_TPMU_SENSITIVE_COMPOSITE(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMU_SENSITIVE_COMPOSITE *sensitiveComposite,
@@ -66,6 +66,12 @@ typedef struct {
     TPM_RC responseCode;
     UINT8 authsCount;
     UINT8 numResponseHandles;
+
+    // Authorization area reservation, see Tss2_Sys_ReserveCmdAuths.  While a
+    // gap is reserved, tpmInBuffPtr/maxCommandSize are advanced/shrunk by
+    // cmdAuthsGap so that parameters are marshalled where they will be sent.
+    UINT32 cmdAuthsReserve;         // Bytes requested for the next _Prepare.
+    UINT32 cmdAuthsGap;             // Bytes still unused in front of the command header.
     struct
     {
         UINT16 tpmVersionInfoValid:1;  // Identifies whether the TPM version info fields are valid; if not valid
@@ -81,6 +87,8 @@ typedef struct {
         UINT16 encryptSession:1; // If true, complex TPM2B's are not unmarshalled but instead treated as simple TPM2B's.
         UINT16 prepareCalledFromOneCall:1;    // Indicates that the _Prepare call was called from the one-call.
         UINT16 completeCalledFromOneCall:1;    // Indicates that the _Prepare call was called from the one-call.
+        UINT16 separateBuffers:1; // Command and response buffers were supplied by the caller and don't overlap,
+                                  // see Tss2_Sys_InitializeWithBuffers.
     };
 
     // Used to maintain state of SAPI functions.
@@ -204,6 +212,7 @@ TSS2_SYS_CONTEXT *InitSysContext(
 void TeardownSysContext( TSS2_SYS_CONTEXT **sysContext );
 
 #include "sys_api_marshalUnmarshal.h"
+#include "sys_api_marshalTable.h"
 
 #ifdef __cplusplus
 }
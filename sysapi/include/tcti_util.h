@@ -45,6 +45,7 @@
 #endif
 
 #include <tcti/common.h>
+#include <tcti/tcti_trace.h>
 
 #define TCTI_MAGIC   0x7e18e9defa8bc9e2
 #define TCTI_VERSION 0x1
@@ -101,6 +102,7 @@ typedef struct {
     TCTI_LOG_CALLBACK logCallback;
     TCTI_LOG_BUFFER_CALLBACK logBufferCallback;
     void *logData;
+    TCTI_TRACE_RECORD traceRecord;  // Command in flight, when tracing; see tcti/tracehooks.h.
 } TSS2_TCTI_CONTEXT_INTEL;
 
 #define TCTI_CONTEXT ( (TSS2_TCTI_CONTEXT_COMMON_CURRENT *)(SYS_CONTEXT->tctiContext) )
@@ -93,3 +93,52 @@ end_Tss2_Sys_Initialize:
     return rval;
 }
 
+
+TSS2_RC Tss2_Sys_InitializeWithBuffers(
+    TSS2_SYS_CONTEXT *sysContext,
+    size_t contextSize,
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_ABI_VERSION *abiVersion,
+    uint8_t *cmdBuffer,
+    size_t cmdBufferSize,
+    uint8_t *rspBuffer,
+    size_t rspBufferSize
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+
+    if( cmdBuffer == NULL || rspBuffer == NULL )
+    {
+        rval = TSS2_SYS_RC_BAD_REFERENCE;
+        goto end_Tss2_Sys_InitializeWithBuffers;
+    }
+
+    if( cmdBufferSize < sizeof( TPM20_Header_In ) || cmdBufferSize > UINT32_MAX ||
+        rspBufferSize < sizeof( TPM20_ErrorResponse ) || rspBufferSize > UINT32_MAX )
+    {
+        rval = TSS2_SYS_RC_BAD_SIZE;
+        goto end_Tss2_Sys_InitializeWithBuffers;
+    }
+
+    // The command must survive the response, or it couldn't be resent.
+    if( cmdBuffer < rspBuffer + rspBufferSize && rspBuffer < cmdBuffer + cmdBufferSize )
+    {
+        rval = TSS2_SYS_RC_BAD_VALUE;
+        goto end_Tss2_Sys_InitializeWithBuffers;
+    }
+
+    rval = Tss2_Sys_Initialize( sysContext, contextSize, tctiContext, abiVersion );
+
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        SYS_CONTEXT->tpmInBuffPtr = cmdBuffer;
+        SYS_CONTEXT->maxCommandSize = (UINT32)cmdBufferSize;
+        SYS_CONTEXT->tpmOutBuffPtr = rspBuffer;
+        SYS_CONTEXT->maxResponseSize = (UINT32)rspBufferSize;
+        SYS_CONTEXT->separateBuffers = 1;
+        SYS_CONTEXT->nextData = SYS_CONTEXT->tpmInBuffPtr;
+    }
+
+end_Tss2_Sys_InitializeWithBuffers:
+    return rval;
+}
@@ -88,7 +88,7 @@ TPM_RC Tss2_Sys_Commit_Complete(
 
     Unmarshal_TPM2B_ECC_POINT( sysContext, E );
 
-    Unmarshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), counter, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), counter, &(SYS_CONTEXT->rval) );
 
     return SYS_CONTEXT->rval;
 }
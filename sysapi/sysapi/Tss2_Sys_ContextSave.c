@@ -42,7 +42,11 @@ TPM_RC Tss2_Sys_ContextSave_Prepare(
 
     CommonPreparePrologue( sysContext, TPM_CC_ContextSave );
 
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), saveHandle, &(SYS_CONTEXT->rval) );
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            sizeof( UINT32 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT32( &(SYS_CONTEXT->nextData), saveHandle );
+    }
 
 
 
@@ -72,6 +76,23 @@ TPM_RC Tss2_Sys_ContextSave_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_ContextSave_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_CONTEXT_VIEW	*context
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPMS_CONTEXT_VIEW( sysContext, context );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_ContextSave(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_CONTEXT	saveHandle,
@@ -70,7 +70,7 @@ TPM_RC Tss2_Sys_EC_Ephemeral_Complete(
 
     Unmarshal_TPM2B_ECC_POINT( sysContext, Q );
 
-    Unmarshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), counter, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), counter, &(SYS_CONTEXT->rval) );
 
     return SYS_CONTEXT->rval;
 }
@@ -87,6 +87,26 @@ TPM_RC Tss2_Sys_EncryptDecrypt_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_EncryptDecrypt_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outData,
+    TSS2_SYS_BUFFER_VIEW	*ivOut
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, outData );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, ivOut );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_EncryptDecrypt(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	keyHandle,
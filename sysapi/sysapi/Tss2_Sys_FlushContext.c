@@ -42,7 +42,11 @@ TPM_RC Tss2_Sys_FlushContext_Prepare(
 
     CommonPreparePrologue( sysContext, TPM_CC_FlushContext );
 
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), flushHandle, &(SYS_CONTEXT->rval) );
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            sizeof( UINT32 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT32( &(SYS_CONTEXT->nextData), flushHandle );
+    }
 
 
 
@@ -46,11 +46,13 @@ TPM_RC Tss2_Sys_GetCapability_Prepare(
 
 
 
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), capability, &(SYS_CONTEXT->rval) );
-
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), property, &(SYS_CONTEXT->rval) );
-
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), propertyCount, &(SYS_CONTEXT->rval) );
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            3 * sizeof( UINT32 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT32( &(SYS_CONTEXT->nextData), capability );
+        Put_UINT32( &(SYS_CONTEXT->nextData), property );
+        Put_UINT32( &(SYS_CONTEXT->nextData), propertyCount );
+    }
 
     SYS_CONTEXT->decryptAllowed = 0;
     SYS_CONTEXT->encryptAllowed = 0;
@@ -74,7 +76,7 @@ TPM_RC Tss2_Sys_GetCapability_Complete(
 
     CommonComplete( sysContext );
 
-    Unmarshal_UINT8( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), moreData, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), moreData, &(SYS_CONTEXT->rval) );
 
     Unmarshal_TPMS_CAPABILITY_DATA( sysContext, capabilityData );
 
@@ -44,7 +44,11 @@ TPM_RC Tss2_Sys_GetRandom_Prepare(
 
 
 
-    Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), bytesRequested, &(SYS_CONTEXT->rval) );
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            sizeof( UINT16 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT16( &(SYS_CONTEXT->nextData), bytesRequested );
+    }
 
     SYS_CONTEXT->decryptAllowed = 0;
     SYS_CONTEXT->encryptAllowed = 1;
@@ -72,6 +76,23 @@ TPM_RC Tss2_Sys_GetRandom_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_GetRandom_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*randomBytes
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, randomBytes );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_GetRandom(
     TSS2_SYS_CONTEXT *sysContext,
     TSS2_SYS_CMD_AUTHS const *cmdAuthsArray,
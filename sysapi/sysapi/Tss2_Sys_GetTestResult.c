@@ -67,7 +67,7 @@ TPM_RC Tss2_Sys_GetTestResult_Complete(
 
     UNMARSHAL_SIMPLE_TPM2B( sysContext, &( outData->b ) );
 
-    Unmarshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), testResult, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), testResult, &(SYS_CONTEXT->rval) );
 
     return SYS_CONTEXT->rval;
 }
@@ -84,6 +84,26 @@ TPM_RC Tss2_Sys_Hash_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_Hash_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outHash,
+    TPMT_TK_HASHCHECK	*validation
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, outHash );
+
+    Unmarshal_TPMT_TK_HASHCHECK( sysContext, validation );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_Hash(
     TSS2_SYS_CONTEXT *sysContext,
     TSS2_SYS_CMD_AUTHS const *cmdAuthsArray,
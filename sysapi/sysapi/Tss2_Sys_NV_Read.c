@@ -45,15 +45,15 @@ TPM_RC Tss2_Sys_NV_Read_Prepare(
 
     CommonPreparePrologue( sysContext, TPM_CC_NV_Read );
 
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), authHandle, &(SYS_CONTEXT->rval) );
-
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), nvIndex, &(SYS_CONTEXT->rval) );
-
-
-
-    Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), size, &(SYS_CONTEXT->rval) );
-
-    Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), offset, &(SYS_CONTEXT->rval) );
+    // Handles, size and offset are all fixed size: check once, then store.
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            2 * sizeof( UINT32 ) + 2 * sizeof( UINT16 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT32( &(SYS_CONTEXT->nextData), authHandle );
+        Put_UINT32( &(SYS_CONTEXT->nextData), nvIndex );
+        Put_UINT16( &(SYS_CONTEXT->nextData), size );
+        Put_UINT16( &(SYS_CONTEXT->nextData), offset );
+    }
 
     SYS_CONTEXT->decryptAllowed = 0;
     SYS_CONTEXT->encryptAllowed = 1;
@@ -81,6 +81,23 @@ TPM_RC Tss2_Sys_NV_Read_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_NV_Read_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*data
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, data );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_NV_Read(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_RH_NV_AUTH	authHandle,
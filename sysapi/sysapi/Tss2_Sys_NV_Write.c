@@ -45,9 +45,12 @@ TPM_RC Tss2_Sys_NV_Write_Prepare(
 
     CommonPreparePrologue( sysContext, TPM_CC_NV_Write );
 
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), authHandle, &(SYS_CONTEXT->rval) );
-
-    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), nvIndex, &(SYS_CONTEXT->rval) );
+    if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+            2 * sizeof( UINT32 ), &(SYS_CONTEXT->rval) ) == TSS2_RC_SUCCESS )
+    {
+        Put_UINT32( &(SYS_CONTEXT->nextData), authHandle );
+        Put_UINT32( &(SYS_CONTEXT->nextData), nvIndex );
+    }
 
     if( data == 0 )
 	{
@@ -76,13 +76,13 @@ TPM_RC Tss2_Sys_PCR_Allocate_Complete(
 
     CommonComplete( sysContext );
 
-    Unmarshal_UINT8( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), allocationSuccess, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), allocationSuccess, &(SYS_CONTEXT->rval) );
 
-    Unmarshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), maxPCR, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), maxPCR, &(SYS_CONTEXT->rval) );
 
-    Unmarshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), sizeNeeded, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), sizeNeeded, &(SYS_CONTEXT->rval) );
 
-    Unmarshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), sizeAvailable, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), sizeAvailable, &(SYS_CONTEXT->rval) );
 
     return SYS_CONTEXT->rval;
 }
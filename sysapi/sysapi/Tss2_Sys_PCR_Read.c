@@ -72,7 +72,7 @@ TPM_RC Tss2_Sys_PCR_Read_Complete(
 
     CommonComplete( sysContext );
 
-    Unmarshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), pcrUpdateCounter, &(SYS_CONTEXT->rval) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), pcrUpdateCounter, &(SYS_CONTEXT->rval) );
 
     Unmarshal_TPML_PCR_SELECTION( sysContext, pcrSelectionOut );
 
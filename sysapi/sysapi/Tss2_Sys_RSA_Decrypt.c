@@ -87,6 +87,23 @@ TPM_RC Tss2_Sys_RSA_Decrypt_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_RSA_Decrypt_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*message
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, message );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_RSA_Decrypt(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	keyHandle,
@@ -84,6 +84,26 @@ TPM_RC Tss2_Sys_SequenceComplete_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_SequenceComplete_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*result,
+    TPMT_TK_HASHCHECK	*validation
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, result );
+
+    Unmarshal_TPMT_TK_HASHCHECK( sysContext, validation );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_SequenceComplete(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	sequenceHandle,
@@ -72,6 +72,23 @@ TPM_RC Tss2_Sys_Unseal_Complete(
     return SYS_CONTEXT->rval;
 }
 
+TPM_RC Tss2_Sys_Unseal_CompleteView(
+    TSS2_SYS_CONTEXT *sysContext,
+    TSS2_SYS_BUFFER_VIEW	*outData
+    )
+{
+    if( sysContext == NULL )
+    {
+        return( TSS2_SYS_RC_BAD_REFERENCE );
+    }
+
+    CommonComplete( sysContext );
+
+    UNMARSHAL_TPM2B_VIEW( sysContext, outData );
+
+    return SYS_CONTEXT->rval;
+}
+
 TPM_RC Tss2_Sys_Unseal(
     TSS2_SYS_CONTEXT *sysContext,
     TPMI_DH_OBJECT	itemHandle,
@@ -28,6 +28,68 @@
 #include <sapi/tpm20.h>
 #include "sysapi_util.h"
 
+//
+// Size of the authorization area, including its UINT32 size field, that
+// CopySessionsDataIn will write for cmdAuthsArray.
+//
+static TSS2_RC GetCmdAuthsSize(
+    const TSS2_SYS_CMD_AUTHS    *cmdAuthsArray,
+    UINT32                      *authSize
+    )
+{
+    uint8_t i;
+
+    *authSize = 0;
+
+    for( i = 0; i < cmdAuthsArray->cmdAuthsCount; i++ )
+    {
+        // Check for null pointer.
+        if( cmdAuthsArray->cmdAuths[i] == 0 )
+        {
+            return TSS2_SYS_RC_BAD_VALUE;
+        }
+        *authSize += sizeof( TPMI_SH_AUTH_SESSION ); // Handle
+        *authSize += sizeof( UINT16 ) + cmdAuthsArray->cmdAuths[i]->nonce.t.size; // nonce
+        *authSize += sizeof( UINT8 ); // sessionAttribues
+        *authSize += sizeof( UINT16 ) + cmdAuthsArray->cmdAuths[i]->hmac.t.size; // hmac
+    }
+
+    *authSize += sizeof( UINT32 ); // authorization size field
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC Tss2_Sys_ReserveCmdAuths(
+    TSS2_SYS_CONTEXT            *sysContext,
+    const TSS2_SYS_CMD_AUTHS    *cmdAuthsArray
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    UINT32 authSize = 0;
+
+    if( sysContext == NULL )
+    {
+        rval = TSS2_SYS_RC_BAD_REFERENCE;
+    }
+    else if( cmdAuthsArray == 0 || cmdAuthsArray->cmdAuthsCount == 0 )
+    {
+        SYS_CONTEXT->cmdAuthsReserve = 0;
+    }
+    else if( cmdAuthsArray->cmdAuthsCount > MAX_SESSION_NUM )
+    {
+        rval = TSS2_SYS_RC_BAD_VALUE;
+    }
+    else
+    {
+        rval = GetCmdAuthsSize( cmdAuthsArray, &authSize );
+        if( rval == TSS2_RC_SUCCESS )
+        {
+            SYS_CONTEXT->cmdAuthsReserve = authSize;
+        }
+    }
+    return rval;
+}
+
 TSS2_RC Tss2_Sys_SetCmdAuths(
     TSS2_SYS_CONTEXT            *sysContext,
     const TSS2_SYS_CMD_AUTHS 	*cmdAuthsArray
@@ -70,20 +132,11 @@ TSS2_RC Tss2_Sys_SetCmdAuths(
 
                 // Calculate size needed for authorization area
                 // and check for any null pointers.
+                rval = GetCmdAuthsSize( cmdAuthsArray, &authSize );
+
                 // Also check for decrypt/encrypt sessions.
-                for( i = 0; i < cmdAuthsArray->cmdAuthsCount; i++ )
+                for( i = 0; rval == TSS2_RC_SUCCESS && i < cmdAuthsArray->cmdAuthsCount; i++ )
                 {
-                    // Check for null pointer.
-                    if( cmdAuthsArray->cmdAuths[i] == 0 )
-                    {
-                        rval = TSS2_SYS_RC_BAD_VALUE;
-                        break;
-                    }
-                    authSize += sizeof( TPMI_SH_AUTH_SESSION ); // Handle
-                    authSize += sizeof( UINT16 ) + cmdAuthsArray->cmdAuths[i]->nonce.t.size; // nonce
-                    authSize += sizeof( UINT8 ); // sessionAttribues
-                    authSize += sizeof( UINT16 ) + cmdAuthsArray->cmdAuths[i]->hmac.t.size; // hmac
-
                     // Check for decrypt/encrypt sessions and set flags.   This is
                     // done to support the one-call function.
                     if( cmdAuthsArray->cmdAuths[i]->sessionAttributes.decrypt )
@@ -95,10 +148,29 @@ TSS2_RC Tss2_Sys_SetCmdAuths(
 
                 if( rval == TSS2_RC_SUCCESS )
                 {
-                    authSize += sizeof( UINT32 ); // authorization size field
                     newCmdSize = (UINT64)authSize + (UINT64)CHANGE_ENDIAN_DWORD( ( (TPM20_Header_In *)( SYS_CONTEXT->tpmInBuffPtr ) )->commandSize );
 
-                    if( newCmdSize > (UINT64)( SYS_CONTEXT->maxCommandSize ) )
+                    if( authSize <= SYS_CONTEXT->cmdAuthsGap )
+                    {
+                        void *otherData;
+                        size_t prefixSize = SYS_CONTEXT->cpBuffer - SYS_CONTEXT->tpmInBuffPtr;
+
+                        // The gap was reserved at _Prepare time: slide the header
+                        // and handles back into it and write the authorization
+                        // area between them and the parameters, which stay put.
+                        memmove( SYS_CONTEXT->tpmInBuffPtr - authSize, SYS_CONTEXT->tpmInBuffPtr, prefixSize );
+                        SYS_CONTEXT->tpmInBuffPtr -= authSize;
+                        SYS_CONTEXT->maxCommandSize += authSize;
+                        SYS_CONTEXT->cmdAuthsGap -= authSize;
+
+                        otherData = SYS_CONTEXT->cpBuffer - authSize;
+                        rval = CopySessionsDataIn( &otherData, cmdAuthsArray );
+
+                        ( (TPM20_Header_In *)( SYS_CONTEXT->tpmInBuffPtr ) )->commandSize = CHANGE_ENDIAN_DWORD( (UINT32)newCmdSize );
+
+                        SYS_CONTEXT->authsCount = cmdAuthsArray->cmdAuthsCount;
+                    }
+                    else if( newCmdSize > (UINT64)( SYS_CONTEXT->maxCommandSize ) )
                     {
                         rval = TSS2_SYS_RC_INSUFFICIENT_CONTEXT;
                     }
@@ -38,8 +38,13 @@ TSS2_RC Tss2_Sys_ExecuteAsync(
     {
         rval = TSS2_SYS_RC_BAD_REFERENCE;
     }
-    else if( SYS_CONTEXT->previousStage != CMD_STAGE_PREPARE )
+    else if( SYS_CONTEXT->previousStage != CMD_STAGE_PREPARE &&
+             !( SYS_CONTEXT->previousStage == CMD_STAGE_RECEIVE_RESPONSE &&
+                SYS_CONTEXT->separateBuffers &&
+                SYS_CONTEXT->responseCode != TPM_RC_SUCCESS ) )
     {
+        // A command can only be resent after the TPM rejected it (e.g.
+        // TPM_RC_RETRY), and only if the response didn't overwrite it.
         rval = TSS2_SYS_RC_BAD_SEQUENCE;
     }
     else
@@ -100,8 +105,8 @@ TSS2_RC Tss2_Sys_ExecuteFinish(
             // in each Part 3 command's Complete function for this.
             SYS_CONTEXT->nextData = SYS_CONTEXT->tpmOutBuffPtr;
 
-            Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), 0, &(SYS_CONTEXT->rval) );
-            Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), (UINT32 *)&responseSize, &(SYS_CONTEXT->rval) );
+            Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), 0, &(SYS_CONTEXT->rval) );
+            Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), (UINT32 *)&responseSize, &(SYS_CONTEXT->rval) );
 
             if( responseSize < ( sizeof( TPM20_Header_Out ) - 1 ) )
             {
@@ -109,7 +114,7 @@ TSS2_RC Tss2_Sys_ExecuteFinish(
             }
             else
             {
-                Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), &rval, &(SYS_CONTEXT->rval) );
+                Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &rval, &(SYS_CONTEXT->rval) );
 
                 // Return TPM return code if no other errors have occured.
                 if( rval == TSS2_RC_SUCCESS )
@@ -82,6 +82,9 @@ void InitSysContextPtrs(
     SYS_CONTEXT->maxCommandSize =
         contextSize - ((UINT8 *)SYS_CONTEXT->tpmInBuffPtr - (UINT8 *)SYS_CONTEXT);
     SYS_CONTEXT->maxResponseSize = SYS_CONTEXT->maxCommandSize;
+    SYS_CONTEXT->cmdAuthsReserve = 0;
+    SYS_CONTEXT->cmdAuthsGap = 0;
+    SYS_CONTEXT->separateBuffers = 0;
 }
 
 
@@ -145,6 +148,21 @@ TSS2_RC CommonPreparePrologue(
     }
     else
     {
+        // Hand back whatever is left of the previous command's authorization
+        // gap, then reserve the one requested for this command, if any.
+        SYS_CONTEXT->tpmInBuffPtr -= SYS_CONTEXT->cmdAuthsGap;
+        SYS_CONTEXT->maxCommandSize += SYS_CONTEXT->cmdAuthsGap;
+        SYS_CONTEXT->cmdAuthsGap = 0;
+
+        if( SYS_CONTEXT->cmdAuthsReserve != 0 &&
+                (UINT64)SYS_CONTEXT->cmdAuthsReserve + sizeof( TPM20_Header_In ) < SYS_CONTEXT->maxCommandSize )
+        {
+            SYS_CONTEXT->tpmInBuffPtr += SYS_CONTEXT->cmdAuthsReserve;
+            SYS_CONTEXT->maxCommandSize -= SYS_CONTEXT->cmdAuthsReserve;
+            SYS_CONTEXT->cmdAuthsGap = SYS_CONTEXT->cmdAuthsReserve;
+        }
+        SYS_CONTEXT->cmdAuthsReserve = 0;
+
         CopyCommandHeader( SYS_CONTEXT, commandCode );
 
         SYS_CONTEXT->numResponseHandles = GetNumResponseHandles( commandCode );
@@ -33,17 +33,10 @@ void Marshal_TPML_DIGEST(
 	TPML_DIGEST *digest
 	)
 {
-	UINT32	i;
-
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), digest->count, &( SYS_CONTEXT->rval ) );
-
-	for( i = 0; i < digest->count; i++ )
-	{
-		MARSHAL_SIMPLE_TPM2B( sysContext, (TPM2B *)&digest->digests[i] );
-	}
+	MARSHAL_TABLE( sysContext, &MarshalType_TPML_DIGEST, digest );
 
 	return;
 }
@@ -28,6 +28,11 @@
 #include <sapi/tpm20.h>
 #include "sysapi_util.h"
 
+//
+// Hand-written rather than table-driven: PCR selections are on the hot
+// path and the table engine's per-field dispatch costs more than the few
+// bytes they hold.  test/unit/marshal-table checks both against each other.
+//
 void Marshal_TPML_PCR_SELECTION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPML_PCR_SELECTION *pcrSelection
@@ -38,7 +43,23 @@ void Marshal_TPML_PCR_SELECTION(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), pcrSelection->count, &( SYS_CONTEXT->rval ) );
+	if( pcrSelection == 0 )
+	{
+		SYS_CONTEXT->rval = TSS2_SYS_RC_BAD_REFERENCE;
+		return;
+	}
+
+	if( pcrSelection->count > HASH_COUNT )
+	{
+		SYS_CONTEXT->rval = TSS2_SYS_RC_BAD_VALUE;
+		return;
+	}
+
+	if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+			sizeof( UINT32 ), &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	Put_UINT32( &(SYS_CONTEXT->nextData), pcrSelection->count );
 
 	for( i = 0; i < pcrSelection->count; i++ )
 	{
@@ -36,10 +36,7 @@ void Marshal_TPMS_CONTEXT(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	Marshal_UINT64( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), context->sequence, &( SYS_CONTEXT->rval ) );
-	Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), context->savedHandle, &( SYS_CONTEXT->rval ) );
-	Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), context->hierarchy, &( SYS_CONTEXT->rval ) );
-	MARSHAL_SIMPLE_TPM2B( sysContext, (TPM2B *)&context->contextBlob );
+	MARSHAL_TABLE( sysContext, &MarshalType_TPMS_CONTEXT, context );
 
 	return;
 }
@@ -28,23 +28,33 @@
 #include <sapi/tpm20.h>
 #include "sysapi_util.h"
 
+//
+// PCR selections go out with nearly every PCR, quote and policy command,
+// so they are marshalled here directly instead of through the table: one
+// overflow check per selection, then plain stores.
+//
 void Marshal_TPMS_PCR_SELECTION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_PCR_SELECTION *pcrSelection
 	)
 {
-	UINT32	i;
-
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), pcrSelection->hash, &( SYS_CONTEXT->rval ) );
-	Marshal_UINT8( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), pcrSelection->sizeofSelect, &( SYS_CONTEXT->rval ) );
-
-	for( i = 0; i < pcrSelection->sizeofSelect; i++ )
+	if( pcrSelection->sizeofSelect > PCR_SELECT_MAX )
 	{
-		Marshal_UINT8( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), pcrSelection->pcrSelect[i], &( SYS_CONTEXT->rval ) );
+		SYS_CONTEXT->rval = TSS2_SYS_RC_BAD_VALUE;
+		return;
 	}
 
+	if( CheckFixedRegion( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData),
+			sizeof( UINT16 ) + sizeof( UINT8 ) + pcrSelection->sizeofSelect, &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	Put_UINT16( &(SYS_CONTEXT->nextData), pcrSelection->hash );
+	Put_UINT8( &(SYS_CONTEXT->nextData), pcrSelection->sizeofSelect );
+	memcpy( SYS_CONTEXT->nextData, pcrSelection->pcrSelect, pcrSelection->sizeofSelect );
+	SYS_CONTEXT->nextData += pcrSelection->sizeofSelect;
+
 	return;
 }
@@ -36,8 +36,7 @@ void Marshal_TPMT_PUBLIC_PARMS(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), publicVarParms->type, &( SYS_CONTEXT->rval ) );
-	Marshal_TPMU_PUBLIC_PARMS( sysContext, &publicVarParms->parameters, publicVarParms->type );
+	MARSHAL_TABLE( sysContext, &MarshalType_TPMT_PUBLIC_PARMS, publicVarParms );
 
 	return;
 }
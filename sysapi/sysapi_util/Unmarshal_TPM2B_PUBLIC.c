@@ -43,7 +43,7 @@ void Unmarshal_TPM2B_PUBLIC(
 		SYS_CONTEXT->rval = TSS2_SYS_RC_BAD_VALUE;
 
 	Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &publicVar->t.size, &( SYS_CONTEXT->rval ) );
-	Unmarshal_TPMT_PUBLIC( sysContext, &publicVar->t.publicArea );
+	UNMARSHAL_TABLE( sysContext, &MarshalType_TPMT_PUBLIC, &publicVar->t.publicArea );
 
 	return;
 }
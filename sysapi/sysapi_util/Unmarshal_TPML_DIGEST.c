@@ -33,20 +33,10 @@ void Unmarshal_TPML_DIGEST(
 	TPML_DIGEST *digest
 	)
 {
-	UINT32	i;
-
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	if( digest == 0 )
-		return;
-
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &digest->count, &( SYS_CONTEXT->rval ) );
-
-	for( i = 0; i < digest->count; i++ )
-	{
-		UNMARSHAL_SIMPLE_TPM2B_NO_SIZE_CHECK( sysContext, (TPM2B *)&digest->digests[i] );
-	}
+	UNMARSHAL_TABLE( sysContext, &MarshalType_TPML_DIGEST, digest );
 
 	return;
 }
@@ -28,6 +28,9 @@
 #include <sapi/tpm20.h>
 #include "sysapi_util.h"
 
+//
+// Hand-written like Marshal_TPML_PCR_SELECTION; see there.
+//
 void Unmarshal_TPML_PCR_SELECTION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPML_PCR_SELECTION *pcrSelection
@@ -41,7 +44,17 @@ void Unmarshal_TPML_PCR_SELECTION(
 	if( pcrSelection == 0 )
 		return;
 
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &pcrSelection->count, &( SYS_CONTEXT->rval ) );
+	if( CheckFixedRegion( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData),
+			sizeof( UINT32 ), &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	pcrSelection->count = Get_UINT32( &(SYS_CONTEXT->nextData) );
+
+	if( pcrSelection->count > HASH_COUNT )
+	{
+		SYS_CONTEXT->rval = TSS2_SYS_RC_MALFORMED_RESPONSE;
+		return;
+	}
 
 	for( i = 0; i < pcrSelection->count; i++ )
 	{
@@ -36,11 +36,7 @@ void Unmarshal_TPMS_CAPABILITY_DATA(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	if( capabilityData == 0 )
-		return;
-
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &capabilityData->capability, &( SYS_CONTEXT->rval ) );
-	Unmarshal_TPMU_CAPABILITIES( sysContext, &capabilityData->data, capabilityData->capability );
+	UNMARSHAL_TABLE( sysContext, &MarshalType_TPMS_CAPABILITY_DATA, capabilityData );
 
 	return;
 }
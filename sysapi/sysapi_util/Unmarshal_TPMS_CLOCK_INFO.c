@@ -39,10 +39,14 @@ void Unmarshal_TPMS_CLOCK_INFO(
 	if( clockInfo == 0 )
 		return;
 
-	Unmarshal_UINT64( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &clockInfo->clock, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &clockInfo->resetCount, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &clockInfo->restartCount, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &clockInfo->safe, &( SYS_CONTEXT->rval ) );
+	if( CheckFixedRegion( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData),
+			sizeof( UINT64 ) + 2 * sizeof( UINT32 ) + sizeof( UINT8 ), &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	clockInfo->clock = Get_UINT64( &(SYS_CONTEXT->nextData) );
+	clockInfo->resetCount = Get_UINT32( &(SYS_CONTEXT->nextData) );
+	clockInfo->restartCount = Get_UINT32( &(SYS_CONTEXT->nextData) );
+	clockInfo->safe = Get_UINT8( &(SYS_CONTEXT->nextData) );
 
 	return;
 }
@@ -36,13 +36,7 @@ void Unmarshal_TPMS_CONTEXT(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	if( context == 0 )
-		return;
-
-	Unmarshal_UINT64( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &context->sequence, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &context->savedHandle, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &context->hierarchy, &( SYS_CONTEXT->rval ) );
-	UNMARSHAL_SIMPLE_TPM2B_NO_SIZE_CHECK( sysContext, (TPM2B *)&context->contextBlob );
+	UNMARSHAL_TABLE( sysContext, &MarshalType_TPMS_CONTEXT, context );
 
 	return;
 }
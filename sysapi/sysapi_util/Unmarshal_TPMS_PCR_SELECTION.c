@@ -28,26 +28,39 @@
 #include <sapi/tpm20.h>
 #include "sysapi_util.h"
 
+//
+// Hand-written like Marshal_TPMS_PCR_SELECTION; see there.
+//
 void Unmarshal_TPMS_PCR_SELECTION(
 	TSS2_SYS_CONTEXT *sysContext,
 	TPMS_PCR_SELECTION *pcrSelection
 	)
 {
-	UINT32	i;
-
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
 	if( pcrSelection == 0 )
 		return;
 
-	Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &pcrSelection->hash, &( SYS_CONTEXT->rval ) );
-	Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &pcrSelection->sizeofSelect, &( SYS_CONTEXT->rval ) );
+	if( CheckFixedRegion( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData),
+			sizeof( UINT16 ) + sizeof( UINT8 ), &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	pcrSelection->hash = Get_UINT16( &(SYS_CONTEXT->nextData) );
+	pcrSelection->sizeofSelect = Get_UINT8( &(SYS_CONTEXT->nextData) );
 
-	for( i = 0; i < pcrSelection->sizeofSelect; i++ )
+	if( pcrSelection->sizeofSelect > PCR_SELECT_MAX )
 	{
-		Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &pcrSelection->pcrSelect[i], &( SYS_CONTEXT->rval ) );
+		SYS_CONTEXT->rval = TSS2_SYS_RC_MALFORMED_RESPONSE;
+		return;
 	}
 
+	if( CheckFixedRegion( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData),
+			pcrSelection->sizeofSelect, &( SYS_CONTEXT->rval ) ) != TSS2_RC_SUCCESS )
+		return;
+
+	memcpy( pcrSelection->pcrSelect, SYS_CONTEXT->nextData, pcrSelection->sizeofSelect );
+	SYS_CONTEXT->nextData += pcrSelection->sizeofSelect;
+
 	return;
 }
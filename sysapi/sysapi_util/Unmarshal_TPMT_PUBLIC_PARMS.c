@@ -36,11 +36,7 @@ void Unmarshal_TPMT_PUBLIC_PARMS(
 	if( SYS_CONTEXT->rval != TSS2_RC_SUCCESS )
 		return;
 
-	if( publicVarParms == 0 )
-		return;
-
-	Unmarshal_UINT16( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &publicVarParms->type, &( SYS_CONTEXT->rval ) );
-	Unmarshal_TPMU_PUBLIC_PARMS( sysContext, &publicVarParms->parameters, publicVarParms->type );
+	UNMARSHAL_TABLE( sysContext, &MarshalType_TPMT_PUBLIC_PARMS, publicVarParms );
 
 	return;
 }
@@ -59,3 +59,27 @@ TSS2_RC CheckDataPointers( UINT8 *buffer, UINT8 **nextData )
 
     return TSS2_RC_SUCCESS;
 }
+/**
+ * Validate a fixed-size region of 'size' bytes at *nextData in one go.
+ * This folds the rval, CheckDataPointers and CheckOverflow checks that each
+ * Marshal_* / Unmarshal_* call would otherwise repeat into a single test so
+ * that the caller can follow up with the unchecked Put_* / Get_* helpers.
+ * Because the used size only grows as nextData advances, checking the whole
+ * region is equivalent to checking each field in turn.
+ *
+ * The result is stored in *rval (if it was TSS2_RC_SUCCESS on entry) and
+ * also returned.
+ */
+TSS2_RC CheckFixedRegion( UINT8 *buffer, UINT32 bufferSize, UINT8 **nextData, UINT32 size, TSS2_RC *rval )
+{
+    if( *rval != TSS2_RC_SUCCESS )
+        return *rval;
+
+    *rval = CheckDataPointers( buffer, nextData );
+    if( *rval != TSS2_RC_SUCCESS )
+        return *rval;
+
+    *rval = CheckOverflow( buffer, bufferSize, *nextData, size );
+
+    return *rval;
+}
@@ -0,0 +1,383 @@
+/***********************************************************************;
+ * Copyright (c) 2015, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ ***********************************************************************/
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+
+static UINT32 ReadSelector( const UINT8 *field, UINT8 size )
+{
+    UINT8 u8;
+    UINT16 u16;
+    UINT32 u32;
+
+    switch( size )
+    {
+        case sizeof( UINT8 ):
+            u8 = *field;
+            return u8;
+        case sizeof( UINT16 ):
+            memcpy( &u16, field, sizeof( u16 ) );
+            return u16;
+        default:
+            memcpy( &u32, field, sizeof( u32 ) );
+            return u32;
+    }
+}
+
+static void PutScalar( UINT8 **nextData, UINT8 kind, const UINT8 *field )
+{
+    UINT16 u16;
+    UINT32 u32;
+    UINT64 u64;
+
+    switch( kind )
+    {
+        case MARSHAL_KIND_UINT8:
+            Put_UINT8( nextData, *field );
+            break;
+        case MARSHAL_KIND_UINT16:
+            memcpy( &u16, field, sizeof( u16 ) );
+            Put_UINT16( nextData, u16 );
+            break;
+        case MARSHAL_KIND_UINT32:
+            memcpy( &u32, field, sizeof( u32 ) );
+            Put_UINT32( nextData, u32 );
+            break;
+        case MARSHAL_KIND_UINT64:
+            memcpy( &u64, field, sizeof( u64 ) );
+            Put_UINT64( nextData, u64 );
+            break;
+    }
+}
+
+static void GetScalar( UINT8 **nextData, UINT8 kind, UINT8 *field )
+{
+    UINT16 u16;
+    UINT32 u32;
+    UINT64 u64;
+
+    switch( kind )
+    {
+        case MARSHAL_KIND_UINT8:
+            *field = Get_UINT8( nextData );
+            break;
+        case MARSHAL_KIND_UINT16:
+            u16 = Get_UINT16( nextData );
+            memcpy( field, &u16, sizeof( u16 ) );
+            break;
+        case MARSHAL_KIND_UINT32:
+            u32 = Get_UINT32( nextData );
+            memcpy( field, &u32, sizeof( u32 ) );
+            break;
+        case MARSHAL_KIND_UINT64:
+            u64 = Get_UINT64( nextData );
+            memcpy( field, &u64, sizeof( u64 ) );
+            break;
+    }
+}
+
+static void MarshalType( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_TYPE *type, const UINT8 *base, TSS2_RC *rval );
+
+static void MarshalTpm2b( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_FIELD *field, const UINT8 *base, TSS2_RC *rval )
+{
+    UINT16 size;
+
+    memcpy( &size, base + field->offset, sizeof( size ) );
+    if( size > field->capacity )
+    {
+        *rval = TSS2_SYS_RC_BAD_VALUE;
+        return;
+    }
+
+    // Same check, and same error, as Marshal_Simple_TPM2B.
+    if( (INT64)( *nextData - inBuffPtr ) + sizeof( UINT16 ) > (INT64)maxCommandSize )
+    {
+        *rval = TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+        return;
+    }
+
+    if( CheckFixedRegion( inBuffPtr, maxCommandSize, nextData, sizeof( UINT16 ) + size, rval ) != TSS2_RC_SUCCESS )
+        return;
+
+    Put_UINT16( nextData, size );
+    memcpy( *nextData, base + field->offset + sizeof( UINT16 ), size );
+    *nextData += size;
+}
+
+static void MarshalArray( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_FIELD *field, const UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_TYPE *elementType = (const MARSHAL_TYPE *)field->type;
+    const UINT8 *element = base + field->offset;
+    UINT32 count, i;
+
+    count = ReadSelector( base + field->selector, field->selectorSize );
+    if( count > field->capacity )
+    {
+        *rval = TSS2_SYS_RC_BAD_VALUE;
+        return;
+    }
+
+    if( field->elementKind != MARSHAL_KIND_STRUCT )
+    {
+        // Array of scalars: one overflow check for the whole array.
+        if( CheckFixedRegion( inBuffPtr, maxCommandSize, nextData, count * field->elementKind, rval ) != TSS2_RC_SUCCESS )
+            return;
+
+        for( i = 0; i < count; i++, element += field->elementSize )
+        {
+            PutScalar( nextData, field->elementKind, element );
+        }
+    }
+    else
+    {
+        for( i = 0; i < count && *rval == TSS2_RC_SUCCESS; i++, element += field->elementSize )
+        {
+            MarshalType( inBuffPtr, maxCommandSize, nextData, elementType, element, rval );
+        }
+    }
+}
+
+static void MarshalUnion( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_FIELD *field, const UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_UNION *unionType = (const MARSHAL_UNION *)field->type;
+    UINT32 selector;
+    UINT16 i;
+
+    selector = ReadSelector( base + field->selector, field->selectorSize );
+
+    for( i = 0; i < unionType->armCount; i++ )
+    {
+        if( unionType->arms[i].selector == selector )
+        {
+            MarshalType( inBuffPtr, maxCommandSize, nextData, unionType->arms[i].type, base + field->offset, rval );
+            break;
+        }
+    }
+}
+
+static void MarshalType( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_TYPE *type, const UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_FIELD *field = type->fields;
+    const MARSHAL_FIELD *end = type->fields + type->fieldCount;
+
+    if( type->fixedSize != 0 )
+    {
+        // All scalars: check the whole structure once, then store.
+        if( CheckFixedRegion( inBuffPtr, maxCommandSize, nextData, type->fixedSize, rval ) != TSS2_RC_SUCCESS )
+            return;
+
+        for( ; field < end; field++ )
+        {
+            PutScalar( nextData, field->kind, base + field->offset );
+        }
+        return;
+    }
+
+    for( ; field < end && *rval == TSS2_RC_SUCCESS; field++ )
+    {
+        switch( field->kind )
+        {
+            case MARSHAL_KIND_UINT8:
+            case MARSHAL_KIND_UINT16:
+            case MARSHAL_KIND_UINT32:
+            case MARSHAL_KIND_UINT64:
+                if( CheckFixedRegion( inBuffPtr, maxCommandSize, nextData, field->kind, rval ) == TSS2_RC_SUCCESS )
+                {
+                    PutScalar( nextData, field->kind, base + field->offset );
+                }
+                break;
+            case MARSHAL_KIND_TPM2B:
+                MarshalTpm2b( inBuffPtr, maxCommandSize, nextData, field, base, rval );
+                break;
+            case MARSHAL_KIND_STRUCT:
+                MarshalType( inBuffPtr, maxCommandSize, nextData, (const MARSHAL_TYPE *)field->type, base + field->offset, rval );
+                break;
+            case MARSHAL_KIND_ARRAY:
+                MarshalArray( inBuffPtr, maxCommandSize, nextData, field, base, rval );
+                break;
+            case MARSHAL_KIND_UNION:
+                MarshalUnion( inBuffPtr, maxCommandSize, nextData, field, base, rval );
+                break;
+        }
+    }
+}
+
+void Marshal_Table( UINT8 *inBuffPtr, UINT32 maxCommandSize, UINT8 **nextData, const MARSHAL_TYPE *type, const void *value, TSS2_RC *rval )
+{
+    if( *rval != TSS2_RC_SUCCESS )
+        return;
+
+    if( type == 0 || value == 0 )
+    {
+        *rval = TSS2_SYS_RC_BAD_REFERENCE;
+        return;
+    }
+
+    MarshalType( inBuffPtr, maxCommandSize, nextData, type, (const UINT8 *)value, rval );
+}
+
+static void UnmarshalType( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_TYPE *type, UINT8 *base, TSS2_RC *rval );
+
+static void UnmarshalTpm2b( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_FIELD *field, UINT8 *base, TSS2_RC *rval )
+{
+    UINT16 size;
+
+    if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, sizeof( UINT16 ), rval ) != TSS2_RC_SUCCESS )
+        return;
+
+    size = Get_UINT16( nextData );
+    if( size > field->capacity )
+    {
+        *rval = TSS2_SYS_RC_INSUFFICIENT_BUFFER;
+        return;
+    }
+
+    if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, size, rval ) != TSS2_RC_SUCCESS )
+        return;
+
+    memcpy( base + field->offset, &size, sizeof( size ) );
+    memcpy( base + field->offset + sizeof( UINT16 ), *nextData, size );
+    *nextData += size;
+}
+
+static void UnmarshalArray( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_FIELD *field, UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_TYPE *elementType = (const MARSHAL_TYPE *)field->type;
+    UINT8 *element = base + field->offset;
+    UINT32 count, i;
+
+    // The count precedes the array, so it has already been unmarshalled.
+    count = ReadSelector( base + field->selector, field->selectorSize );
+    if( count > field->capacity )
+    {
+        *rval = TSS2_SYS_RC_MALFORMED_RESPONSE;
+        return;
+    }
+
+    if( field->elementKind != MARSHAL_KIND_STRUCT )
+    {
+        if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, count * field->elementKind, rval ) != TSS2_RC_SUCCESS )
+            return;
+
+        for( i = 0; i < count; i++, element += field->elementSize )
+        {
+            GetScalar( nextData, field->elementKind, element );
+        }
+    }
+    else
+    {
+        for( i = 0; i < count && *rval == TSS2_RC_SUCCESS; i++, element += field->elementSize )
+        {
+            UnmarshalType( outBuffPtr, maxResponseSize, nextData, elementType, element, rval );
+        }
+    }
+}
+
+static void UnmarshalUnion( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_FIELD *field, UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_UNION *unionType = (const MARSHAL_UNION *)field->type;
+    UINT32 selector;
+    UINT16 i;
+
+    selector = ReadSelector( base + field->selector, field->selectorSize );
+
+    for( i = 0; i < unionType->armCount; i++ )
+    {
+        if( unionType->arms[i].selector == selector )
+        {
+            UnmarshalType( outBuffPtr, maxResponseSize, nextData, unionType->arms[i].type, base + field->offset, rval );
+            break;
+        }
+    }
+}
+
+static void UnmarshalType( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_TYPE *type, UINT8 *base, TSS2_RC *rval )
+{
+    const MARSHAL_FIELD *field = type->fields;
+    const MARSHAL_FIELD *end = type->fields + type->fieldCount;
+
+    if( type->fixedSize != 0 )
+    {
+        if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, type->fixedSize, rval ) != TSS2_RC_SUCCESS )
+            return;
+
+        for( ; field < end; field++ )
+        {
+            GetScalar( nextData, field->kind, base + field->offset );
+        }
+        return;
+    }
+
+    for( ; field < end && *rval == TSS2_RC_SUCCESS; field++ )
+    {
+        switch( field->kind )
+        {
+            case MARSHAL_KIND_UINT8:
+            case MARSHAL_KIND_UINT16:
+            case MARSHAL_KIND_UINT32:
+            case MARSHAL_KIND_UINT64:
+                if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, field->kind, rval ) == TSS2_RC_SUCCESS )
+                {
+                    GetScalar( nextData, field->kind, base + field->offset );
+                }
+                break;
+            case MARSHAL_KIND_TPM2B:
+                UnmarshalTpm2b( outBuffPtr, maxResponseSize, nextData, field, base, rval );
+                break;
+            case MARSHAL_KIND_STRUCT:
+                UnmarshalType( outBuffPtr, maxResponseSize, nextData, (const MARSHAL_TYPE *)field->type, base + field->offset, rval );
+                break;
+            case MARSHAL_KIND_ARRAY:
+                UnmarshalArray( outBuffPtr, maxResponseSize, nextData, field, base, rval );
+                break;
+            case MARSHAL_KIND_UNION:
+                UnmarshalUnion( outBuffPtr, maxResponseSize, nextData, field, base, rval );
+                break;
+        }
+    }
+}
+
+/*
+ * As with the hand-written Unmarshal_* functions, a NULL 'value' is not an
+ * error: nothing is unmarshalled and nextData is left where it is.
+ */
+void Unmarshal_Table( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, const MARSHAL_TYPE *type, void *value, TSS2_RC *rval )
+{
+    if( *rval != TSS2_RC_SUCCESS )
+        return;
+
+    if( type == 0 )
+    {
+        *rval = TSS2_SYS_RC_BAD_REFERENCE;
+        return;
+    }
+
+    if( value == 0 )
+        return;
+
+    UnmarshalType( outBuffPtr, maxResponseSize, nextData, type, (UINT8 *)value, rval );
+}
@@ -0,0 +1,466 @@
+/***********************************************************************;
+ * Copyright (c) 2015, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ ***********************************************************************/
+
+#include <stddef.h>
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+
+//
+// Type descriptors for the table-driven marshaller (marshal_table.c).
+//
+// Fields must be listed in wire order.  The count of an ARRAY and the
+// selector of a UNION must be described by an earlier field of the same
+// structure so that they have already been unmarshalled when used.
+//
+
+#define MEMBER_SIZE( type, member ) sizeof( ( (type *)0 )->member )
+#define MEMBER_COUNT( type, member ) ( MEMBER_SIZE( type, member ) / MEMBER_SIZE( type, member[0] ) )
+
+#define FIELD_SCALAR( type, member ) \
+    { MEMBER_SIZE( type, member ), 0, 0, offsetof( type, member ), 0, 0, 0, 0 }
+
+#define FIELD_TPM2B( type, member ) \
+    { MARSHAL_KIND_TPM2B, 0, 0, offsetof( type, member ), 0, MEMBER_SIZE( type, member.t.buffer ), 0, 0 }
+
+#define FIELD_STRUCT( type, member, desc ) \
+    { MARSHAL_KIND_STRUCT, 0, 0, offsetof( type, member ), 0, 0, 0, &desc }
+
+#define FIELD_SCALAR_ARRAY( type, member, count ) \
+    { MARSHAL_KIND_ARRAY, MEMBER_SIZE( type, member[0] ), MEMBER_SIZE( type, count ), offsetof( type, member ), \
+      offsetof( type, count ), MEMBER_COUNT( type, member ), MEMBER_SIZE( type, member[0] ), 0 }
+
+#define FIELD_STRUCT_ARRAY( type, member, count, desc ) \
+    { MARSHAL_KIND_ARRAY, MARSHAL_KIND_STRUCT, MEMBER_SIZE( type, count ), offsetof( type, member ), \
+      offsetof( type, count ), MEMBER_COUNT( type, member ), MEMBER_SIZE( type, member[0] ), &desc }
+
+#define FIELD_UNION( type, member, selector, desc ) \
+    { MARSHAL_KIND_UNION, 0, MEMBER_SIZE( type, selector ), offsetof( type, member ), \
+      offsetof( type, selector ), 0, 0, &desc }
+
+#define MARSHAL_TYPE_DEF( name, fixedSize ) \
+    const MARSHAL_TYPE MarshalType_##name = { \
+        fixedSize, sizeof( name##_Fields ) / sizeof( MARSHAL_FIELD ), name##_Fields }
+
+static const MARSHAL_FIELD TPMS_PCR_SELECTION_Fields[] = {
+    FIELD_SCALAR( TPMS_PCR_SELECTION, hash ),
+    FIELD_SCALAR( TPMS_PCR_SELECTION, sizeofSelect ),
+    FIELD_SCALAR_ARRAY( TPMS_PCR_SELECTION, pcrSelect, sizeofSelect ),
+};
+MARSHAL_TYPE_DEF( TPMS_PCR_SELECTION, 0 );
+
+static const MARSHAL_FIELD TPML_PCR_SELECTION_Fields[] = {
+    FIELD_SCALAR( TPML_PCR_SELECTION, count ),
+    FIELD_STRUCT_ARRAY( TPML_PCR_SELECTION, pcrSelections, count, MarshalType_TPMS_PCR_SELECTION ),
+};
+MARSHAL_TYPE_DEF( TPML_PCR_SELECTION, 0 );
+
+static const MARSHAL_FIELD TPMS_CLOCK_INFO_Fields[] = {
+    FIELD_SCALAR( TPMS_CLOCK_INFO, clock ),
+    FIELD_SCALAR( TPMS_CLOCK_INFO, resetCount ),
+    FIELD_SCALAR( TPMS_CLOCK_INFO, restartCount ),
+    FIELD_SCALAR( TPMS_CLOCK_INFO, safe ),
+};
+MARSHAL_TYPE_DEF( TPMS_CLOCK_INFO, sizeof( UINT64 ) + 2 * sizeof( UINT32 ) + sizeof( UINT8 ) );
+
+static const MARSHAL_FIELD TPMS_TIME_INFO_Fields[] = {
+    FIELD_SCALAR( TPMS_TIME_INFO, time ),
+    FIELD_STRUCT( TPMS_TIME_INFO, clockInfo, MarshalType_TPMS_CLOCK_INFO ),
+};
+MARSHAL_TYPE_DEF( TPMS_TIME_INFO, 0 );
+
+static const MARSHAL_FIELD TPM2B_DIGEST_Fields[] = {
+    { MARSHAL_KIND_TPM2B, 0, 0, 0, 0, MEMBER_SIZE( TPM2B_DIGEST, t.buffer ), 0, 0 },
+};
+MARSHAL_TYPE_DEF( TPM2B_DIGEST, 0 );
+
+static const MARSHAL_FIELD TPML_DIGEST_Fields[] = {
+    FIELD_SCALAR( TPML_DIGEST, count ),
+    FIELD_STRUCT_ARRAY( TPML_DIGEST, digests, count, MarshalType_TPM2B_DIGEST ),
+};
+MARSHAL_TYPE_DEF( TPML_DIGEST, 0 );
+
+static const MARSHAL_FIELD TPMS_CONTEXT_Fields[] = {
+    FIELD_SCALAR( TPMS_CONTEXT, sequence ),
+    FIELD_SCALAR( TPMS_CONTEXT, savedHandle ),
+    FIELD_SCALAR( TPMS_CONTEXT, hierarchy ),
+    FIELD_TPM2B( TPMS_CONTEXT, contextBlob ),
+};
+MARSHAL_TYPE_DEF( TPMS_CONTEXT, 0 );
+
+static const MARSHAL_FIELD TPMS_TAGGED_PROPERTY_Fields[] = {
+    FIELD_SCALAR( TPMS_TAGGED_PROPERTY, property ),
+    FIELD_SCALAR( TPMS_TAGGED_PROPERTY, value ),
+};
+MARSHAL_TYPE_DEF( TPMS_TAGGED_PROPERTY, 2 * sizeof( UINT32 ) );
+
+static const MARSHAL_FIELD TPML_TAGGED_TPM_PROPERTY_Fields[] = {
+    FIELD_SCALAR( TPML_TAGGED_TPM_PROPERTY, count ),
+    FIELD_STRUCT_ARRAY( TPML_TAGGED_TPM_PROPERTY, tpmProperty, count, MarshalType_TPMS_TAGGED_PROPERTY ),
+};
+MARSHAL_TYPE_DEF( TPML_TAGGED_TPM_PROPERTY, 0 );
+
+static const MARSHAL_FIELD TPMS_ALG_PROPERTY_Fields[] = {
+    FIELD_SCALAR( TPMS_ALG_PROPERTY, alg ),
+    FIELD_SCALAR( TPMS_ALG_PROPERTY, algProperties ),
+};
+MARSHAL_TYPE_DEF( TPMS_ALG_PROPERTY, sizeof( UINT16 ) + sizeof( UINT32 ) );
+
+static const MARSHAL_FIELD TPML_ALG_PROPERTY_Fields[] = {
+    FIELD_SCALAR( TPML_ALG_PROPERTY, count ),
+    FIELD_STRUCT_ARRAY( TPML_ALG_PROPERTY, algProperties, count, MarshalType_TPMS_ALG_PROPERTY ),
+};
+MARSHAL_TYPE_DEF( TPML_ALG_PROPERTY, 0 );
+
+static const MARSHAL_FIELD TPML_HANDLE_Fields[] = {
+    FIELD_SCALAR( TPML_HANDLE, count ),
+    FIELD_SCALAR_ARRAY( TPML_HANDLE, handle, count ),
+};
+MARSHAL_TYPE_DEF( TPML_HANDLE, 0 );
+
+static const MARSHAL_FIELD TPML_CC_Fields[] = {
+    FIELD_SCALAR( TPML_CC, count ),
+    FIELD_SCALAR_ARRAY( TPML_CC, commandCodes, count ),
+};
+MARSHAL_TYPE_DEF( TPML_CC, 0 );
+
+static const MARSHAL_FIELD TPML_CCA_Fields[] = {
+    FIELD_SCALAR( TPML_CCA, count ),
+    FIELD_SCALAR_ARRAY( TPML_CCA, commandAttributes, count ),
+};
+MARSHAL_TYPE_DEF( TPML_CCA, 0 );
+
+static const MARSHAL_FIELD TPMS_TAGGED_PCR_SELECT_Fields[] = {
+    FIELD_SCALAR( TPMS_TAGGED_PCR_SELECT, tag ),
+    FIELD_SCALAR( TPMS_TAGGED_PCR_SELECT, sizeofSelect ),
+    FIELD_SCALAR_ARRAY( TPMS_TAGGED_PCR_SELECT, pcrSelect, sizeofSelect ),
+};
+MARSHAL_TYPE_DEF( TPMS_TAGGED_PCR_SELECT, 0 );
+
+static const MARSHAL_FIELD TPML_TAGGED_PCR_PROPERTY_Fields[] = {
+    FIELD_SCALAR( TPML_TAGGED_PCR_PROPERTY, count ),
+    FIELD_STRUCT_ARRAY( TPML_TAGGED_PCR_PROPERTY, pcrProperty, count, MarshalType_TPMS_TAGGED_PCR_SELECT ),
+};
+MARSHAL_TYPE_DEF( TPML_TAGGED_PCR_PROPERTY, 0 );
+
+static const MARSHAL_FIELD TPML_ECC_CURVE_Fields[] = {
+    FIELD_SCALAR( TPML_ECC_CURVE, count ),
+    FIELD_SCALAR_ARRAY( TPML_ECC_CURVE, eccCurves, count ),
+};
+MARSHAL_TYPE_DEF( TPML_ECC_CURVE, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_CAPABILITIES_Arms[] = {
+#ifdef TPM_CAP_ALGS
+    { TPM_CAP_ALGS, &MarshalType_TPML_ALG_PROPERTY },
+#endif
+#ifdef TPM_CAP_HANDLES
+    { TPM_CAP_HANDLES, &MarshalType_TPML_HANDLE },
+#endif
+#ifdef TPM_CAP_COMMANDS
+    { TPM_CAP_COMMANDS, &MarshalType_TPML_CCA },
+#endif
+#ifdef TPM_CAP_PP_COMMANDS
+    { TPM_CAP_PP_COMMANDS, &MarshalType_TPML_CC },
+#endif
+#ifdef TPM_CAP_AUDIT_COMMANDS
+    { TPM_CAP_AUDIT_COMMANDS, &MarshalType_TPML_CC },
+#endif
+#ifdef TPM_CAP_PCRS
+    { TPM_CAP_PCRS, &MarshalType_TPML_PCR_SELECTION },
+#endif
+#ifdef TPM_CAP_TPM_PROPERTIES
+    { TPM_CAP_TPM_PROPERTIES, &MarshalType_TPML_TAGGED_TPM_PROPERTY },
+#endif
+#ifdef TPM_CAP_PCR_PROPERTIES
+    { TPM_CAP_PCR_PROPERTIES, &MarshalType_TPML_TAGGED_PCR_PROPERTY },
+#endif
+#ifdef TPM_CAP_ECC_CURVES
+    { TPM_CAP_ECC_CURVES, &MarshalType_TPML_ECC_CURVE },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_CAPABILITIES_Union = {
+    sizeof( TPMU_CAPABILITIES_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_CAPABILITIES_Arms
+};
+
+static const MARSHAL_FIELD TPMS_CAPABILITY_DATA_Fields[] = {
+    FIELD_SCALAR( TPMS_CAPABILITY_DATA, capability ),
+    FIELD_UNION( TPMS_CAPABILITY_DATA, data, capability, TPMU_CAPABILITIES_Union ),
+};
+MARSHAL_TYPE_DEF( TPMS_CAPABILITY_DATA, 0 );
+
+//
+// TPMT_PUBLIC and everything under it.  Arms with nothing on the wire
+// (TPM_ALG_NULL, TPM_ALG_RSAES, the mode of TPM_ALG_XOR) are left out of
+// the unions: a selector without an arm marshals nothing, as in the
+// hand-written switch statements these tables replace.
+//
+
+// A union member that is a single UINT16, e.g. a key size or a mode.
+static const MARSHAL_FIELD UINT16_Fields[] = {
+    { MARSHAL_KIND_UINT16, 0, 0, 0, 0, 0, 0, 0 },
+};
+MARSHAL_TYPE_DEF( UINT16, sizeof( UINT16 ) );
+
+static const MARSHAL_FIELD TPMS_SCHEME_HASH_Fields[] = {
+    FIELD_SCALAR( TPMS_SCHEME_HASH, hashAlg ),
+};
+MARSHAL_TYPE_DEF( TPMS_SCHEME_HASH, sizeof( UINT16 ) );
+
+static const MARSHAL_FIELD TPMS_SCHEME_ECDAA_Fields[] = {
+    FIELD_SCALAR( TPMS_SCHEME_ECDAA, hashAlg ),
+    FIELD_SCALAR( TPMS_SCHEME_ECDAA, count ),
+};
+MARSHAL_TYPE_DEF( TPMS_SCHEME_ECDAA, 2 * sizeof( UINT16 ) );
+
+static const MARSHAL_FIELD TPMS_SCHEME_XOR_Fields[] = {
+    FIELD_SCALAR( TPMS_SCHEME_XOR, hashAlg ),
+    FIELD_SCALAR( TPMS_SCHEME_XOR, kdf ),
+};
+MARSHAL_TYPE_DEF( TPMS_SCHEME_XOR, 2 * sizeof( UINT16 ) );
+
+static const MARSHAL_UNION_ARM TPMU_SCHEME_KEYEDHASH_Arms[] = {
+#ifdef TPM_ALG_HMAC
+    { TPM_ALG_HMAC, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_XOR
+    { TPM_ALG_XOR, &MarshalType_TPMS_SCHEME_XOR },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_SCHEME_KEYEDHASH_Union = {
+    sizeof( TPMU_SCHEME_KEYEDHASH_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_SCHEME_KEYEDHASH_Arms
+};
+
+static const MARSHAL_FIELD TPMT_KEYEDHASH_SCHEME_Fields[] = {
+    FIELD_SCALAR( TPMT_KEYEDHASH_SCHEME, scheme ),
+    FIELD_UNION( TPMT_KEYEDHASH_SCHEME, details, scheme, TPMU_SCHEME_KEYEDHASH_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_KEYEDHASH_SCHEME, 0 );
+
+static const MARSHAL_FIELD TPMS_KEYEDHASH_PARMS_Fields[] = {
+    FIELD_STRUCT( TPMS_KEYEDHASH_PARMS, scheme, MarshalType_TPMT_KEYEDHASH_SCHEME ),
+};
+MARSHAL_TYPE_DEF( TPMS_KEYEDHASH_PARMS, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_SYM_KEY_BITS_Arms[] = {
+#ifdef TPM_ALG_AES
+    { TPM_ALG_AES, &MarshalType_UINT16 },
+#endif
+#ifdef TPM_ALG_SM4
+    { TPM_ALG_SM4, &MarshalType_UINT16 },
+#endif
+#ifdef TPM_ALG_CAMELLIA
+    { TPM_ALG_CAMELLIA, &MarshalType_UINT16 },
+#endif
+#ifdef TPM_ALG_XOR
+    { TPM_ALG_XOR, &MarshalType_UINT16 },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_SYM_KEY_BITS_Union = {
+    sizeof( TPMU_SYM_KEY_BITS_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_SYM_KEY_BITS_Arms
+};
+
+static const MARSHAL_UNION_ARM TPMU_SYM_MODE_Arms[] = {
+#ifdef TPM_ALG_AES
+    { TPM_ALG_AES, &MarshalType_UINT16 },
+#endif
+#ifdef TPM_ALG_SM4
+    { TPM_ALG_SM4, &MarshalType_UINT16 },
+#endif
+#ifdef TPM_ALG_CAMELLIA
+    { TPM_ALG_CAMELLIA, &MarshalType_UINT16 },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_SYM_MODE_Union = {
+    sizeof( TPMU_SYM_MODE_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_SYM_MODE_Arms
+};
+
+static const MARSHAL_FIELD TPMT_SYM_DEF_OBJECT_Fields[] = {
+    FIELD_SCALAR( TPMT_SYM_DEF_OBJECT, algorithm ),
+    FIELD_UNION( TPMT_SYM_DEF_OBJECT, keyBits, algorithm, TPMU_SYM_KEY_BITS_Union ),
+    FIELD_UNION( TPMT_SYM_DEF_OBJECT, mode, algorithm, TPMU_SYM_MODE_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_SYM_DEF_OBJECT, 0 );
+
+static const MARSHAL_FIELD TPMS_SYMCIPHER_PARMS_Fields[] = {
+    FIELD_STRUCT( TPMS_SYMCIPHER_PARMS, sym, MarshalType_TPMT_SYM_DEF_OBJECT ),
+};
+MARSHAL_TYPE_DEF( TPMS_SYMCIPHER_PARMS, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_ASYM_SCHEME_Arms[] = {
+#ifdef TPM_ALG_ECDH
+    { TPM_ALG_ECDH, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_ECMQV
+    { TPM_ALG_ECMQV, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_RSASSA
+    { TPM_ALG_RSASSA, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_RSAPSS
+    { TPM_ALG_RSAPSS, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_ECDSA
+    { TPM_ALG_ECDSA, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_ECDAA
+    { TPM_ALG_ECDAA, &MarshalType_TPMS_SCHEME_ECDAA },
+#endif
+#ifdef TPM_ALG_SM2
+    { TPM_ALG_SM2, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_ECSCHNORR
+    { TPM_ALG_ECSCHNORR, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_OAEP
+    { TPM_ALG_OAEP, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_ASYM_SCHEME_Union = {
+    sizeof( TPMU_ASYM_SCHEME_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_ASYM_SCHEME_Arms
+};
+
+static const MARSHAL_FIELD TPMT_RSA_SCHEME_Fields[] = {
+    FIELD_SCALAR( TPMT_RSA_SCHEME, scheme ),
+    FIELD_UNION( TPMT_RSA_SCHEME, details, scheme, TPMU_ASYM_SCHEME_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_RSA_SCHEME, 0 );
+
+static const MARSHAL_FIELD TPMT_ECC_SCHEME_Fields[] = {
+    FIELD_SCALAR( TPMT_ECC_SCHEME, scheme ),
+    FIELD_UNION( TPMT_ECC_SCHEME, details, scheme, TPMU_ASYM_SCHEME_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_ECC_SCHEME, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_KDF_SCHEME_Arms[] = {
+#ifdef TPM_ALG_MGF1
+    { TPM_ALG_MGF1, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_KDF1_SP800_56A
+    { TPM_ALG_KDF1_SP800_56A, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_KDF2
+    { TPM_ALG_KDF2, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+#ifdef TPM_ALG_KDF1_SP800_108
+    { TPM_ALG_KDF1_SP800_108, &MarshalType_TPMS_SCHEME_HASH },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_KDF_SCHEME_Union = {
+    sizeof( TPMU_KDF_SCHEME_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_KDF_SCHEME_Arms
+};
+
+static const MARSHAL_FIELD TPMT_KDF_SCHEME_Fields[] = {
+    FIELD_SCALAR( TPMT_KDF_SCHEME, scheme ),
+    FIELD_UNION( TPMT_KDF_SCHEME, details, scheme, TPMU_KDF_SCHEME_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_KDF_SCHEME, 0 );
+
+static const MARSHAL_FIELD TPMS_RSA_PARMS_Fields[] = {
+    FIELD_STRUCT( TPMS_RSA_PARMS, symmetric, MarshalType_TPMT_SYM_DEF_OBJECT ),
+    FIELD_STRUCT( TPMS_RSA_PARMS, scheme, MarshalType_TPMT_RSA_SCHEME ),
+    FIELD_SCALAR( TPMS_RSA_PARMS, keyBits ),
+    FIELD_SCALAR( TPMS_RSA_PARMS, exponent ),
+};
+MARSHAL_TYPE_DEF( TPMS_RSA_PARMS, 0 );
+
+static const MARSHAL_FIELD TPMS_ECC_PARMS_Fields[] = {
+    FIELD_STRUCT( TPMS_ECC_PARMS, symmetric, MarshalType_TPMT_SYM_DEF_OBJECT ),
+    FIELD_STRUCT( TPMS_ECC_PARMS, scheme, MarshalType_TPMT_ECC_SCHEME ),
+    FIELD_SCALAR( TPMS_ECC_PARMS, curveID ),
+    FIELD_STRUCT( TPMS_ECC_PARMS, kdf, MarshalType_TPMT_KDF_SCHEME ),
+};
+MARSHAL_TYPE_DEF( TPMS_ECC_PARMS, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_PUBLIC_PARMS_Arms[] = {
+#ifdef TPM_ALG_KEYEDHASH
+    { TPM_ALG_KEYEDHASH, &MarshalType_TPMS_KEYEDHASH_PARMS },
+#endif
+#ifdef TPM_ALG_SYMCIPHER
+    { TPM_ALG_SYMCIPHER, &MarshalType_TPMS_SYMCIPHER_PARMS },
+#endif
+#ifdef TPM_ALG_RSA
+    { TPM_ALG_RSA, &MarshalType_TPMS_RSA_PARMS },
+#endif
+#ifdef TPM_ALG_ECC
+    { TPM_ALG_ECC, &MarshalType_TPMS_ECC_PARMS },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_PUBLIC_PARMS_Union = {
+    sizeof( TPMU_PUBLIC_PARMS_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_PUBLIC_PARMS_Arms
+};
+
+static const MARSHAL_FIELD TPMT_PUBLIC_PARMS_Fields[] = {
+    FIELD_SCALAR( TPMT_PUBLIC_PARMS, type ),
+    FIELD_UNION( TPMT_PUBLIC_PARMS, parameters, type, TPMU_PUBLIC_PARMS_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_PUBLIC_PARMS, 0 );
+
+static const MARSHAL_FIELD TPM2B_PUBLIC_KEY_RSA_Fields[] = {
+    { MARSHAL_KIND_TPM2B, 0, 0, 0, 0, MEMBER_SIZE( TPM2B_PUBLIC_KEY_RSA, t.buffer ), 0, 0 },
+};
+MARSHAL_TYPE_DEF( TPM2B_PUBLIC_KEY_RSA, 0 );
+
+static const MARSHAL_FIELD TPMS_ECC_POINT_Fields[] = {
+    FIELD_TPM2B( TPMS_ECC_POINT, x ),
+    FIELD_TPM2B( TPMS_ECC_POINT, y ),
+};
+MARSHAL_TYPE_DEF( TPMS_ECC_POINT, 0 );
+
+static const MARSHAL_UNION_ARM TPMU_PUBLIC_ID_Arms[] = {
+#ifdef TPM_ALG_KEYEDHASH
+    { TPM_ALG_KEYEDHASH, &MarshalType_TPM2B_DIGEST },
+#endif
+#ifdef TPM_ALG_SYMCIPHER
+    { TPM_ALG_SYMCIPHER, &MarshalType_TPM2B_DIGEST },
+#endif
+#ifdef TPM_ALG_RSA
+    { TPM_ALG_RSA, &MarshalType_TPM2B_PUBLIC_KEY_RSA },
+#endif
+#ifdef TPM_ALG_ECC
+    { TPM_ALG_ECC, &MarshalType_TPMS_ECC_POINT },
+#endif
+};
+
+static const MARSHAL_UNION TPMU_PUBLIC_ID_Union = {
+    sizeof( TPMU_PUBLIC_ID_Arms ) / sizeof( MARSHAL_UNION_ARM ), TPMU_PUBLIC_ID_Arms
+};
+
+static const MARSHAL_FIELD TPMT_PUBLIC_Fields[] = {
+    FIELD_SCALAR( TPMT_PUBLIC, type ),
+    FIELD_SCALAR( TPMT_PUBLIC, nameAlg ),
+    FIELD_SCALAR( TPMT_PUBLIC, objectAttributes ),
+    FIELD_TPM2B( TPMT_PUBLIC, authPolicy ),
+    FIELD_UNION( TPMT_PUBLIC, parameters, type, TPMU_PUBLIC_PARMS_Union ),
+    FIELD_UNION( TPMT_PUBLIC, unique, type, TPMU_PUBLIC_ID_Union ),
+};
+MARSHAL_TYPE_DEF( TPMT_PUBLIC, 0 );
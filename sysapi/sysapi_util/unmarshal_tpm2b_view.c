@@ -0,0 +1,85 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+
+//
+// Zero-copy counterparts of Unmarshal_Simple_TPM2B and Unmarshal_TPMS_CONTEXT.
+// Instead of copying the payload into a caller-allocated, maximum-sized
+// structure, the view is pointed at the bytes in the response buffer.
+// A NULL view skips the parameter, as the copying versions do.
+//
+void Unmarshal_TPM2B_View( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TSS2_SYS_BUFFER_VIEW *view, TSS2_RC *rval )
+{
+    UINT16 length;
+
+    if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, sizeof( UINT16 ), rval ) != TSS2_RC_SUCCESS )
+    {
+        return;
+    }
+
+    length = Get_UINT16( nextData );
+
+    if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData, length, rval ) != TSS2_RC_SUCCESS )
+    {
+        return;
+    }
+
+    if( view != 0 )
+    {
+        view->size = length;
+        view->buffer = *nextData;
+    }
+
+    *nextData += length;
+}
+
+void Unmarshal_TPMS_CONTEXT_View( UINT8 *outBuffPtr, UINT32 maxResponseSize, UINT8 **nextData, TSS2_SYS_CONTEXT_VIEW *view, TSS2_RC *rval )
+{
+    UINT64 sequence;
+    UINT32 savedHandle, hierarchy;
+
+    if( CheckFixedRegion( outBuffPtr, maxResponseSize, nextData,
+            sizeof( UINT64 ) + 2 * sizeof( UINT32 ), rval ) != TSS2_RC_SUCCESS )
+    {
+        return;
+    }
+
+    sequence = Get_UINT64( nextData );
+    savedHandle = Get_UINT32( nextData );
+    hierarchy = Get_UINT32( nextData );
+
+    if( view != 0 )
+    {
+        view->sequence = sequence;
+        view->savedHandle = savedHandle;
+        view->hierarchy = hierarchy;
+    }
+
+    Unmarshal_TPM2B_View( outBuffPtr, maxResponseSize, nextData, view ? &( view->contextBlob ) : 0, rval );
+}
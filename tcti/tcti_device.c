@@ -27,6 +27,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>   // Needed for _wtoi
+#include <string.h>
+#include <limits.h>
 
 #include <sapi/tpm20.h>
 //#include "resourcemgr.h"
@@ -36,10 +38,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <poll.h>
 #include "debug.h"
 #include "commonchecks.h"
 #include <tcti/tcti_device.h>
 #include "logging.h"
+#include "tracehooks.h"
 
 #ifdef  _WIN32
 #define ssize_t int
@@ -87,6 +91,8 @@ TSS2_RC LocalTpmSendTpmCommand(
         }
 #endif
 
+        TCTI_TRACE( TctiTraceSend( tctiContext, command_buffer, command_size ) );
+
         size = write( ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext )->devFile, command_buffer, command_size );
 
         if( size < 0 )
@@ -137,6 +143,38 @@ TSS2_RC LocalTpmReceiveTpmResponse(
 
     if( ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.tagReceived == 0 )
     {
+        if( timeout != TSS2_TCTI_TIMEOUT_BLOCK )
+        {
+            struct pollfd pollFd;
+            int pollResult;
+
+            // Wait for the driver to signal that a response is ready so
+            // that callers driving the TCTI from an event loop
+            // (ExecuteAsync/ExecuteFinish) aren't stalled in read().
+            pollFd.fd = ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext )->devFile;
+            pollFd.events = POLLIN;
+            pollFd.revents = 0;
+
+            do
+            {
+                pollResult = poll( &pollFd, 1, timeout );
+            } while( pollResult < 0 && errno == EINTR );
+
+            if( pollResult == 0 )
+            {
+                rval = TSS2_TCTI_RC_TRY_AGAIN;
+                goto retLocalTpmReceive;
+            }
+            else if( pollResult < 0 )
+            {
+                TCTI_LOG( tctiContext, rmPrefix, "poll failed with error: %d\n", errno );
+                rval = TSS2_TCTI_RC_IO_ERROR;
+                goto retLocalTpmReceive;
+            }
+
+            TCTI_TRACE( TctiTraceFirstByte( tctiContext ) );
+        }
+
         size = read( ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext )->devFile, &((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->responseBuffer[0], 4096 );
 
         if( size < 0 )
@@ -147,6 +185,7 @@ TSS2_RC LocalTpmReceiveTpmResponse(
         }
         else
         {
+            TCTI_TRACE( TctiTraceFirstByte( tctiContext ) );
             ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.tagReceived = 1;
             ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->responseSize = size;
         }
@@ -187,6 +226,8 @@ TSS2_RC LocalTpmReceiveTpmResponse(
 
     ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.commandSent = 0;
 
+    TCTI_TRACE( TctiTraceComplete( tctiContext, response_buffer, *response_size ) );
+
 retLocalTpmReceive:
 
     if( rval == TSS2_RC_SUCCESS &&
@@ -208,15 +249,92 @@ void LocalTpmFinalize(
     }
 }
 
+//
+// The Linux TPM driver cancels the command in progress on a write to the
+// device's sysfs "cancel" attribute, e.g. /sys/class/tpm/tpm0/device/cancel
+// for /dev/tpm0; /dev/tpmrm0 shares tpm0's.
+//
 TSS2_RC LocalTpmCancel(
     TSS2_TCTI_CONTEXT *tctiContext
     )
 {
-    TSS2_RC rval = TSS2_RC_SUCCESS;
+    char path[PATH_MAX];
+    char devicePath[PATH_MAX];
+    const char *name;
+    ssize_t length;
+    int cancelFile;
+
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
 
-    // TBD.  Needs support from device driver.
+    if( ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->previousStage != TCTI_STAGE_SEND_COMMAND )
+    {
+        return TSS2_TCTI_RC_BAD_SEQUENCE;
+    }
 
-    return rval;
+    snprintf( path, sizeof( path ), "/proc/self/fd/%d", ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext )->devFile );
+    length = readlink( path, devicePath, sizeof( devicePath ) - 1 );
+    if( length <= 0 )
+    {
+        return TSS2_TCTI_RC_NOT_SUPPORTED;
+    }
+    devicePath[length] = '\0';
+
+    name = strrchr( devicePath, '/' );
+    name = ( name != NULL ) ? name + 1 : devicePath;
+    if( strncmp( name, "tpmrm", 5 ) == 0 )
+    {
+        snprintf( path, sizeof( path ), "/sys/class/tpm/tpm%.32s/device/cancel", name + 5 );
+    }
+    else
+    {
+        snprintf( path, sizeof( path ), "/sys/class/tpm/%.32s/device/cancel", name );
+    }
+
+    cancelFile = open( path, O_WRONLY );
+    if( cancelFile < 0 )
+    {
+        return TSS2_TCTI_RC_NOT_SUPPORTED;
+    }
+
+    length = write( cancelFile, "1", 1 );
+    close( cancelFile );
+
+    return ( length == 1 ) ? TSS2_RC_SUCCESS : TSS2_TCTI_RC_IO_ERROR;
+}
+
+TSS2_RC LocalTpmGetPollHandles(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    TSS2_TCTI_POLL_HANDLE *handles,     /* out */
+    size_t *num_handles                 /* in/out */
+    )
+{
+    if( tctiContext == NULL || num_handles == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    if( handles == NULL )
+    {
+        // In this case, just return the number of handles.
+        *num_handles = 1;
+        return TSS2_RC_SUCCESS;
+    }
+
+    if( *num_handles < 1 )
+    {
+        *num_handles = 1;
+        return TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+    }
+
+    handles[0].fd = ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext )->devFile;
+    handles[0].events = POLLIN;
+    handles[0].revents = 0;
+    *num_handles = 1;
+
+    return TSS2_RC_SUCCESS;
 }
 
 TSS2_RC LocalTpmSetLocality(
@@ -259,7 +377,7 @@ TSS2_RC InitDeviceTcti (
         TSS2_TCTI_RECEIVE( tctiContext ) = LocalTpmReceiveTpmResponse;
         TSS2_TCTI_FINALIZE( tctiContext ) = LocalTpmFinalize;
         TSS2_TCTI_CANCEL( tctiContext ) = LocalTpmCancel;
-        TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = 0;
+        TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = LocalTpmGetPollHandles;
         TSS2_TCTI_SET_LOCALITY( tctiContext ) = LocalTpmSetLocality;
         ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.locality = 3;
         ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.commandSent = 0;
@@ -0,0 +1,452 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+#include "debug.h"
+#include "commonchecks.h"
+#include <tcti/tcti_loopback.h>
+#include "logging.h"
+
+const char *loopbackTctiName = "loopback TCTI";
+
+typedef struct {
+    TPM_CC commandCode;
+    const uint8_t *response;
+    size_t responseSize;
+} LOOPBACK_RESPONSE;
+
+//
+// The Intel context comes first so that code which looks into it, e.g.
+// the resource manager setting status bits on its downstream TCTI, works
+// with this TCTI too.
+//
+typedef struct {
+    TSS2_TCTI_CONTEXT_INTEL intel;
+    TCTI_LOOPBACK_RESPONDER responder;
+    void *responderData;
+    uint32_t latency;
+    uint8_t wedged;                 // Ignores cancel.
+    struct timespec ready;          // When the pending response is "ready".
+    uint32_t commandCount;
+    uint32_t responseCount;
+    LOOPBACK_RESPONSE responses[TCTI_LOOPBACK_MAX_RESPONSES];
+} TSS2_TCTI_CONTEXT_LOOPBACK;
+
+#define LOOPBACK_CONTEXT ( (TSS2_TCTI_CONTEXT_LOOPBACK *)tctiContext )
+
+static void AddNanoseconds( struct timespec *time, uint64_t ns )
+{
+    ns += time->tv_nsec;
+    time->tv_sec += ns / 1000000000;
+    time->tv_nsec = ns % 1000000000;
+}
+
+static int TimeBefore( const struct timespec *a, const struct timespec *b )
+{
+    return a->tv_sec < b->tv_sec ||
+        ( a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec );
+}
+
+//
+// Busy waits; sleeping would make short latencies far too coarse.
+//
+static void SpinUntil( const struct timespec *deadline )
+{
+    struct timespec now;
+
+    do
+    {
+        clock_gettime( CLOCK_MONOTONIC, &now );
+    } while( TimeBefore( &now, deadline ) );
+}
+
+static void BuildErrorResponse( TSS2_TCTI_CONTEXT *tctiContext, TPM_RC responseCode )
+{
+    TPM20_ErrorResponse *response = (TPM20_ErrorResponse *)&LOOPBACK_CONTEXT->intel.responseBuffer[0];
+
+    response->tag = CHANGE_ENDIAN_WORD( TPM_ST_NO_SESSIONS );
+    response->responseSize = CHANGE_ENDIAN_DWORD( sizeof( TPM20_ErrorResponse ) );
+    response->responseCode = CHANGE_ENDIAN_DWORD( responseCode );
+    LOOPBACK_CONTEXT->intel.responseSize = sizeof( TPM20_ErrorResponse );
+}
+
+TSS2_RC LoopbackSendTpmCommand(
+    TSS2_TCTI_CONTEXT *tctiContext,       /* in */
+    size_t             command_size,      /* in */
+    uint8_t           *command_buffer     /* in */
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    TPM_CC commandCode;
+    size_t responseSize;
+    uint32_t i;
+
+    rval = CommonSendChecks( tctiContext, command_buffer );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        goto retLoopbackSend;
+    }
+
+    if( command_size < sizeof( TPM20_Header_In ) )
+    {
+        rval = TSS2_TCTI_RC_BAD_VALUE;
+        goto retLoopbackSend;
+    }
+
+    commandCode = CHANGE_ENDIAN_DWORD( ( (TPM20_Header_In *)command_buffer )->commandCode );
+
+#ifdef DEBUG
+    if( LOOPBACK_CONTEXT->intel.status.debugMsgEnabled == 1 )
+    {
+        TCTI_LOG( tctiContext, NO_PREFIX, "" );
+        TCTI_LOG( tctiContext, NO_PREFIX, "Cmd sent: %s\n", strTpmCommandCode( commandCode ) );
+        DEBUG_PRINT_BUFFER( NO_PREFIX, command_buffer, command_size );
+    }
+#endif
+
+    for( i = 0; i < LOOPBACK_CONTEXT->responseCount; i++ )
+    {
+        if( LOOPBACK_CONTEXT->responses[i].commandCode == commandCode )
+            break;
+    }
+
+    if( i < LOOPBACK_CONTEXT->responseCount )
+    {
+        memcpy( &LOOPBACK_CONTEXT->intel.responseBuffer[0],
+                LOOPBACK_CONTEXT->responses[i].response,
+                LOOPBACK_CONTEXT->responses[i].responseSize );
+        LOOPBACK_CONTEXT->intel.responseSize = LOOPBACK_CONTEXT->responses[i].responseSize;
+    }
+    else if( LOOPBACK_CONTEXT->responder != NULL )
+    {
+        responseSize = sizeof( LOOPBACK_CONTEXT->intel.responseBuffer );
+        rval = LOOPBACK_CONTEXT->responder( LOOPBACK_CONTEXT->responderData,
+                command_buffer, command_size,
+                &LOOPBACK_CONTEXT->intel.responseBuffer[0], &responseSize );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            goto retLoopbackSend;
+        }
+        if( responseSize > sizeof( LOOPBACK_CONTEXT->intel.responseBuffer ) )
+        {
+            rval = TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+            goto retLoopbackSend;
+        }
+        LOOPBACK_CONTEXT->intel.responseSize = (TPM_RC)responseSize;
+    }
+    else
+    {
+        BuildErrorResponse( tctiContext, TPM_RC_COMMAND_CODE );
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &LOOPBACK_CONTEXT->ready );
+    AddNanoseconds( &LOOPBACK_CONTEXT->ready, LOOPBACK_CONTEXT->latency );
+
+    LOOPBACK_CONTEXT->commandCount++;
+    LOOPBACK_CONTEXT->intel.previousStage = TCTI_STAGE_SEND_COMMAND;
+    LOOPBACK_CONTEXT->intel.status.commandSent = 1;
+
+retLoopbackSend:
+    return rval;
+}
+
+TSS2_RC LoopbackReceiveTpmResponse(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    size_t          *response_size,     /* out */
+    unsigned char   *response_buffer,    /* in */
+    int32_t         timeout
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    struct timespec deadline;
+
+    rval = CommonReceiveChecks( tctiContext, response_size, response_buffer );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        goto retLoopbackReceive;
+    }
+
+    if( LOOPBACK_CONTEXT->intel.status.commandSent == 0 )
+    {
+        rval = TSS2_TCTI_RC_BAD_SEQUENCE;
+        goto retLoopbackReceive;
+    }
+
+    if( LOOPBACK_CONTEXT->latency != 0 )
+    {
+        if( timeout != TSS2_TCTI_TIMEOUT_BLOCK )
+        {
+            clock_gettime( CLOCK_MONOTONIC, &deadline );
+            AddNanoseconds( &deadline, (uint64_t)timeout * 1000000 );
+            if( TimeBefore( &deadline, &LOOPBACK_CONTEXT->ready ) )
+            {
+                SpinUntil( &deadline );
+                rval = TSS2_TCTI_RC_TRY_AGAIN;
+                goto retLoopbackReceive;
+            }
+        }
+        SpinUntil( &LOOPBACK_CONTEXT->ready );
+    }
+
+    if( response_buffer == NULL )
+    {
+        // In this case, just return the size
+        *response_size = LOOPBACK_CONTEXT->intel.responseSize;
+        goto retLoopbackReceive;
+    }
+
+    if( *response_size < LOOPBACK_CONTEXT->intel.responseSize )
+    {
+        rval = TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+        *response_size = LOOPBACK_CONTEXT->intel.responseSize;
+        goto retLoopbackReceive;
+    }
+
+    *response_size = LOOPBACK_CONTEXT->intel.responseSize;
+    memcpy( response_buffer, &LOOPBACK_CONTEXT->intel.responseBuffer[0], *response_size );
+
+#ifdef DEBUG
+    if( LOOPBACK_CONTEXT->intel.status.debugMsgEnabled == 1 )
+    {
+        TCTI_LOG( tctiContext, NO_PREFIX, "\n" );
+        TCTI_LOG( tctiContext, NO_PREFIX, "Response Received: " );
+        DEBUG_PRINT_BUFFER( NO_PREFIX, response_buffer, *response_size );
+    }
+#endif
+
+    LOOPBACK_CONTEXT->intel.status.commandSent = 0;
+    LOOPBACK_CONTEXT->intel.previousStage = TCTI_STAGE_RECEIVE_RESPONSE;
+
+retLoopbackReceive:
+    return rval;
+}
+
+void LoopbackFinalize(
+    TSS2_TCTI_CONTEXT *tctiContext       /* in */
+    )
+{
+}
+
+//
+// Like a TPM that honours cancel: a command still "executing" fails at
+// once with TPM_RC_CANCELED; one that has finished is unaffected.
+//
+TSS2_RC LoopbackCancel(
+    TSS2_TCTI_CONTEXT *tctiContext
+    )
+{
+    struct timespec now;
+
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    if( LOOPBACK_CONTEXT->intel.status.commandSent == 0 )
+    {
+        return TSS2_TCTI_RC_BAD_SEQUENCE;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    if( !LOOPBACK_CONTEXT->wedged && TimeBefore( &now, &LOOPBACK_CONTEXT->ready ) )
+    {
+        BuildErrorResponse( tctiContext, TPM_RC_CANCELED );
+        LOOPBACK_CONTEXT->ready = now;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC LoopbackGetPollHandles(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    TSS2_TCTI_POLL_HANDLE *handles,     /* out */
+    size_t *num_handles                 /* in/out */
+    )
+{
+    if( tctiContext == NULL || num_handles == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    // Responses are always ready after the latency; nothing to poll.
+    *num_handles = 0;
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC LoopbackSetLocality(
+    TSS2_TCTI_CONTEXT *tctiContext,       /* in */
+    uint8_t           locality     /* in */
+    )
+{
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    LOOPBACK_CONTEXT->intel.status.locality = locality;
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC LoopbackTctiSetResponse(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    TPM_CC commandCode,
+    const uint8_t *response,
+    size_t responseSize
+    )
+{
+    uint32_t i;
+
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    if( response != NULL &&
+        ( responseSize < sizeof( TPM20_ErrorResponse ) ||
+          responseSize > sizeof( LOOPBACK_CONTEXT->intel.responseBuffer ) ) )
+    {
+        return TSS2_TCTI_RC_BAD_VALUE;
+    }
+
+    for( i = 0; i < LOOPBACK_CONTEXT->responseCount; i++ )
+    {
+        if( LOOPBACK_CONTEXT->responses[i].commandCode == commandCode )
+            break;
+    }
+
+    if( response == NULL )
+    {
+        if( i < LOOPBACK_CONTEXT->responseCount )
+        {
+            LOOPBACK_CONTEXT->responses[i] =
+                LOOPBACK_CONTEXT->responses[--LOOPBACK_CONTEXT->responseCount];
+        }
+        return TSS2_RC_SUCCESS;
+    }
+
+    if( i == TCTI_LOOPBACK_MAX_RESPONSES )
+    {
+        return TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+    }
+
+    LOOPBACK_CONTEXT->responses[i].commandCode = commandCode;
+    LOOPBACK_CONTEXT->responses[i].response = response;
+    LOOPBACK_CONTEXT->responses[i].responseSize = responseSize;
+    if( i == LOOPBACK_CONTEXT->responseCount )
+    {
+        LOOPBACK_CONTEXT->responseCount++;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC LoopbackTctiSetLatency(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    uint32_t latency
+    )
+{
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    LOOPBACK_CONTEXT->latency = latency;
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC LoopbackTctiSetWedged(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    uint8_t wedged
+    )
+{
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    LOOPBACK_CONTEXT->wedged = wedged;
+
+    return TSS2_RC_SUCCESS;
+}
+
+uint32_t LoopbackTctiGetCommandCount(
+    TSS2_TCTI_CONTEXT *tctiContext
+    )
+{
+    return tctiContext == NULL ? 0 : LOOPBACK_CONTEXT->commandCount;
+}
+
+TSS2_RC InitLoopbackTcti (
+    TSS2_TCTI_CONTEXT *tctiContext, // OUT
+    size_t *contextSize,            // IN/OUT
+    const TCTI_LOOPBACK_CONF *config  // IN
+    )
+{
+    if( tctiContext == NULL && contextSize == NULL )
+        return TSS2_TCTI_RC_BAD_VALUE;
+    if( tctiContext == NULL )
+    {
+        *contextSize = sizeof( TSS2_TCTI_CONTEXT_LOOPBACK );
+        return TSS2_RC_SUCCESS;
+    }
+    else if( config == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_VALUE;
+    }
+
+    memset( tctiContext, 0, sizeof( TSS2_TCTI_CONTEXT_LOOPBACK ) );
+
+    // Init TCTI context.
+    TSS2_TCTI_MAGIC( tctiContext ) = TCTI_MAGIC;
+    TSS2_TCTI_VERSION( tctiContext ) = TCTI_VERSION;
+    TSS2_TCTI_TRANSMIT( tctiContext ) = LoopbackSendTpmCommand;
+    TSS2_TCTI_RECEIVE( tctiContext ) = LoopbackReceiveTpmResponse;
+    TSS2_TCTI_FINALIZE( tctiContext ) = LoopbackFinalize;
+    TSS2_TCTI_CANCEL( tctiContext ) = LoopbackCancel;
+    TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = LoopbackGetPollHandles;
+    TSS2_TCTI_SET_LOCALITY( tctiContext ) = LoopbackSetLocality;
+    LOOPBACK_CONTEXT->intel.status.locality = 3;
+    LOOPBACK_CONTEXT->intel.previousStage = TCTI_STAGE_INITIALIZE;
+    LOOPBACK_CONTEXT->intel.devFile = -1;
+    TCTI_LOG_CALLBACK( tctiContext ) = config->logCallback;
+    TCTI_LOG_DATA( tctiContext ) = config->logData;
+
+    LOOPBACK_CONTEXT->responder = config->responder;
+    LOOPBACK_CONTEXT->responderData = config->responderData;
+    LOOPBACK_CONTEXT->latency = config->latency;
+
+    return TSS2_RC_SUCCESS;
+}
@@ -0,0 +1,419 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+#include "debug.h"
+#include "commonchecks.h"
+#include <tcti/tcti_record.h>
+#include "logging.h"
+
+const char *recordTctiName = "record TCTI";
+
+#define RECORD_PAD( size ) ( ( (size) + 7 ) & ~(size_t)7 )
+
+//
+// The record being built: the command is copied in at transmit, the
+// response is appended at receive and the whole record is written at once.
+//
+typedef struct {
+    TCTI_RECORD_HEADER header;
+    uint8_t data[TCTI_RECORD_MAX_COMMAND + TCTI_RECORD_MAX_RESPONSE + 8];
+} RECORD_BUFFER;
+
+typedef struct {
+    TSS2_TCTI_CONTEXT_INTEL intel;
+    TSS2_TCTI_CONTEXT *downstream;
+    int logFd;
+    uint32_t connection;
+    uint32_t dropped;
+    uint8_t pending;                // A command of recordable size was sent.
+    RECORD_BUFFER record;
+} TSS2_TCTI_CONTEXT_RECORD;
+
+#define RECORD_CONTEXT ( (TSS2_TCTI_CONTEXT_RECORD *)tctiContext )
+
+static uint64_t NowNs()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void WriteRecord( TSS2_TCTI_CONTEXT *tctiContext )
+{
+    TCTI_RECORD_HEADER *header = &RECORD_CONTEXT->record.header;
+    size_t size = RECORD_PAD( sizeof( TCTI_RECORD_HEADER ) + header->commandSize + header->responseSize );
+    ssize_t written;
+
+    memset( (uint8_t *)header + sizeof( TCTI_RECORD_HEADER ) + header->commandSize + header->responseSize,
+            0, size - sizeof( TCTI_RECORD_HEADER ) - header->commandSize - header->responseSize );
+
+    do
+    {
+        written = write( RECORD_CONTEXT->logFd, header, size );
+    } while( written < 0 && errno == EINTR );
+
+    if( written != (ssize_t)size )
+    {
+        RECORD_CONTEXT->dropped++;
+    }
+}
+
+TSS2_RC RecordSendTpmCommand(
+    TSS2_TCTI_CONTEXT *tctiContext,       /* in */
+    size_t             command_size,      /* in */
+    uint8_t           *command_buffer     /* in */
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    uint64_t timestamp;
+
+    rval = CommonSendChecks( tctiContext, command_buffer );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        goto retRecordSend;
+    }
+
+    timestamp = NowNs();
+    rval = tss2_tcti_transmit( RECORD_CONTEXT->downstream, command_size, command_buffer );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        goto retRecordSend;
+    }
+
+    RECORD_CONTEXT->pending = command_size <= TCTI_RECORD_MAX_COMMAND;
+    if( RECORD_CONTEXT->pending )
+    {
+        RECORD_CONTEXT->record.header.timestamp = timestamp;
+        RECORD_CONTEXT->record.header.connection = RECORD_CONTEXT->connection;
+        RECORD_CONTEXT->record.header.locality = RECORD_CONTEXT->intel.status.locality;
+        RECORD_CONTEXT->record.header.commandSize = (uint32_t)command_size;
+        memcpy( RECORD_CONTEXT->record.data, command_buffer, command_size );
+    }
+    else
+    {
+        RECORD_CONTEXT->dropped++;
+    }
+
+    RECORD_CONTEXT->intel.previousStage = TCTI_STAGE_SEND_COMMAND;
+
+retRecordSend:
+    return rval;
+}
+
+TSS2_RC RecordReceiveTpmResponse(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    size_t          *response_size,     /* out */
+    unsigned char   *response_buffer,    /* in */
+    int32_t         timeout
+    )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    TCTI_RECORD_HEADER *header = &RECORD_CONTEXT->record.header;
+
+    rval = CommonReceiveChecks( tctiContext, response_size, response_buffer );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        goto retRecordReceive;
+    }
+
+    rval = tss2_tcti_receive( RECORD_CONTEXT->downstream, response_size, response_buffer, timeout );
+    if( rval != TSS2_RC_SUCCESS || response_buffer == NULL )
+    {
+        // Nothing received yet, or just the size.
+        goto retRecordReceive;
+    }
+
+    if( RECORD_CONTEXT->pending )
+    {
+        if( *response_size <= TCTI_RECORD_MAX_RESPONSE )
+        {
+            header->latency = (uint32_t)( NowNs() - header->timestamp );
+            header->responseSize = (uint32_t)*response_size;
+            memcpy( RECORD_CONTEXT->record.data + header->commandSize, response_buffer, *response_size );
+            WriteRecord( tctiContext );
+        }
+        else
+        {
+            RECORD_CONTEXT->dropped++;
+        }
+        RECORD_CONTEXT->pending = 0;
+    }
+
+    RECORD_CONTEXT->intel.previousStage = TCTI_STAGE_RECEIVE_RESPONSE;
+
+retRecordReceive:
+    return rval;
+}
+
+void RecordFinalize(
+    TSS2_TCTI_CONTEXT *tctiContext       /* in */
+    )
+{
+    if( tctiContext != NULL && RECORD_CONTEXT->logFd >= 0 )
+    {
+        close( RECORD_CONTEXT->logFd );
+        RECORD_CONTEXT->logFd = -1;
+    }
+}
+
+TSS2_RC RecordCancel(
+    TSS2_TCTI_CONTEXT *tctiContext
+    )
+{
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    // The response to a canceled command is still received, and recorded,
+    // as usual.
+    return tss2_tcti_cancel( RECORD_CONTEXT->downstream );
+}
+
+TSS2_RC RecordGetPollHandles(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    TSS2_TCTI_POLL_HANDLE *handles,     /* out */
+    size_t *num_handles                 /* in/out */
+    )
+{
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    return tss2_tcti_get_poll_handles( RECORD_CONTEXT->downstream, handles, num_handles );
+}
+
+TSS2_RC RecordSetLocality(
+    TSS2_TCTI_CONTEXT *tctiContext,       /* in */
+    uint8_t           locality     /* in */
+    )
+{
+    TSS2_RC rval;
+
+    if( tctiContext == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    rval = tss2_tcti_set_locality( RECORD_CONTEXT->downstream, locality );
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        RECORD_CONTEXT->intel.status.locality = locality;
+    }
+
+    return rval;
+}
+
+uint32_t RecordTctiGetDroppedCount(
+    TSS2_TCTI_CONTEXT *tctiContext
+    )
+{
+    return tctiContext == NULL ? 0 : RECORD_CONTEXT->dropped;
+}
+
+//
+// Opens the log for appending, writing the file header if this creates it.
+// Recorders should start one after the other: a record appended between
+// another process creating the log and writing its header would come first.
+//
+static int OpenLog( const char *logFile )
+{
+    TCTI_RECORD_FILE_HEADER fileHeader = { TCTI_RECORD_FILE_MAGIC, TCTI_RECORD_FILE_VERSION };
+    int fd;
+
+    fd = open( logFile, O_WRONLY | O_APPEND | O_CREAT | O_EXCL, 0600 );
+    if( fd >= 0 )
+    {
+        if( write( fd, &fileHeader, sizeof( fileHeader ) ) != sizeof( fileHeader ) )
+        {
+            close( fd );
+            return -1;
+        }
+        return fd;
+    }
+    else if( errno == EEXIST )
+    {
+        return open( logFile, O_WRONLY | O_APPEND );
+    }
+
+    return -1;
+}
+
+TSS2_RC InitRecordTcti (
+    TSS2_TCTI_CONTEXT *tctiContext, // OUT
+    size_t *contextSize,            // IN/OUT
+    const TCTI_RECORD_CONF *config  // IN
+    )
+{
+    if( tctiContext == NULL && contextSize == NULL )
+        return TSS2_TCTI_RC_BAD_VALUE;
+    if( tctiContext == NULL )
+    {
+        *contextSize = sizeof( TSS2_TCTI_CONTEXT_RECORD );
+        return TSS2_RC_SUCCESS;
+    }
+    else if( config == NULL || config->downstream == NULL || config->logFile == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_VALUE;
+    }
+
+    memset( tctiContext, 0, sizeof( TSS2_TCTI_CONTEXT_RECORD ) );
+
+    RECORD_CONTEXT->logFd = OpenLog( config->logFile );
+    if( RECORD_CONTEXT->logFd < 0 )
+    {
+        return TSS2_TCTI_RC_IO_ERROR;
+    }
+
+    // Init TCTI context.
+    TSS2_TCTI_MAGIC( tctiContext ) = TCTI_MAGIC;
+    TSS2_TCTI_VERSION( tctiContext ) = TCTI_VERSION;
+    TSS2_TCTI_TRANSMIT( tctiContext ) = RecordSendTpmCommand;
+    TSS2_TCTI_RECEIVE( tctiContext ) = RecordReceiveTpmResponse;
+    TSS2_TCTI_FINALIZE( tctiContext ) = RecordFinalize;
+    TSS2_TCTI_CANCEL( tctiContext ) = RecordCancel;
+    TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = RecordGetPollHandles;
+    TSS2_TCTI_SET_LOCALITY( tctiContext ) = RecordSetLocality;
+    RECORD_CONTEXT->intel.status.locality = 3;
+    RECORD_CONTEXT->intel.previousStage = TCTI_STAGE_INITIALIZE;
+    RECORD_CONTEXT->intel.devFile = -1;
+    TCTI_LOG_CALLBACK( tctiContext ) = config->logCallback;
+    TCTI_LOG_DATA( tctiContext ) = config->logData;
+
+    RECORD_CONTEXT->downstream = config->downstream;
+    RECORD_CONTEXT->connection = config->connection != 0 ? config->connection : (uint32_t)getpid();
+
+    return TSS2_RC_SUCCESS;
+}
+
+TSS2_RC RecordLogOpen(
+    TCTI_RECORD_LOG *log,
+    const char *logFile
+    )
+{
+    const TCTI_RECORD_FILE_HEADER *fileHeader;
+    struct stat fileStat;
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    void *base;
+    int fd;
+
+    if( log == NULL || logFile == NULL )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    fd = open( logFile, O_RDONLY );
+    if( fd < 0 )
+    {
+        return TSS2_TCTI_RC_IO_ERROR;
+    }
+
+    if( fstat( fd, &fileStat ) != 0 || fileStat.st_size < (off_t)sizeof( TCTI_RECORD_FILE_HEADER ) )
+    {
+        rval = TSS2_TCTI_RC_BAD_VALUE;
+        goto retRecordLogOpen;
+    }
+
+    base = mmap( NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( base == MAP_FAILED )
+    {
+        rval = TSS2_TCTI_RC_IO_ERROR;
+        goto retRecordLogOpen;
+    }
+
+    fileHeader = (const TCTI_RECORD_FILE_HEADER *)base;
+    if( fileHeader->magic != TCTI_RECORD_FILE_MAGIC ||
+        fileHeader->version != TCTI_RECORD_FILE_VERSION )
+    {
+        munmap( base, fileStat.st_size );
+        rval = TSS2_TCTI_RC_BAD_VALUE;
+        goto retRecordLogOpen;
+    }
+
+    log->base = (const uint8_t *)base;
+    log->size = fileStat.st_size;
+    log->offset = sizeof( TCTI_RECORD_FILE_HEADER );
+
+retRecordLogOpen:
+    close( fd );
+    return rval;
+}
+
+const TCTI_RECORD_HEADER *RecordLogNext(
+    TCTI_RECORD_LOG *log
+    )
+{
+    const TCTI_RECORD_HEADER *header;
+    size_t size;
+
+    if( log == NULL || log->base == NULL ||
+        log->size - log->offset < sizeof( TCTI_RECORD_HEADER ) )
+    {
+        return NULL;
+    }
+
+    header = (const TCTI_RECORD_HEADER *)( log->base + log->offset );
+    if( header->commandSize > TCTI_RECORD_MAX_COMMAND ||
+        header->responseSize > TCTI_RECORD_MAX_RESPONSE )
+    {
+        return NULL;
+    }
+
+    size = RECORD_PAD( sizeof( TCTI_RECORD_HEADER ) + header->commandSize + header->responseSize );
+    if( log->size - log->offset < size )
+    {
+        return NULL;
+    }
+
+    log->offset += size;
+    return header;
+}
+
+void RecordLogClose(
+    TCTI_RECORD_LOG *log
+    )
+{
+    if( log != NULL && log->base != NULL )
+    {
+        munmap( (void *)log->base, log->size );
+        log->base = NULL;
+    }
+}
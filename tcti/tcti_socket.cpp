@@ -34,6 +34,7 @@
 #include "debug.h"
 #include "commonchecks.h"
 #include "logging.h"
+#include "tracehooks.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -93,6 +94,34 @@ TSS2_RC SendSessionEndSocketTcti(
     return( rval );
 }
 
+// The token is opaque to the client, so it goes over the wire as is.
+TSS2_RC ReattachSocketTcti(
+    TSS2_TCTI_CONTEXT *tctiContext,       /* in */
+    UINT64 *token )                       /* in/out */
+{
+    UINT32 tpmSendCommand = CHANGE_ENDIAN_DWORD( TPM_RESMGR_REATTACH );
+    UINT32 responseCode;
+    TSS2_RC rval;
+
+    if( tctiContext == 0 || token == 0 )
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+
+    if( ( (TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.commandSent == 1 )
+        return TSS2_TCTI_RC_BAD_SEQUENCE;
+
+    rval = tctiSendBytes( tctiContext, TCTI_CONTEXT_INTEL->tpmSock, (unsigned char *)&tpmSendCommand, 4 );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = tctiSendBytes( tctiContext, TCTI_CONTEXT_INTEL->tpmSock, (unsigned char *)token, 8 );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = tctiRecvBytes( tctiContext, TCTI_CONTEXT_INTEL->tpmSock, (unsigned char *)&responseCode, 4 );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = tctiRecvBytes( tctiContext, TCTI_CONTEXT_INTEL->tpmSock, (unsigned char *)token, 8 );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = CHANGE_ENDIAN_DWORD( responseCode );
+
+    return rval;
+}
+
 TSS2_RC SocketSendTpmCommand(
     TSS2_TCTI_CONTEXT *tctiContext,       /* in */
     size_t             command_size,      /* in */
@@ -136,6 +165,8 @@ TSS2_RC SocketSendTpmCommand(
     // either 1.2 or 2.0 header to get the size.
     cnt = CHANGE_ENDIAN_DWORD(((TPM20_Header_In *) command_buffer)->commandSize);
 
+    TCTI_TRACE( TctiTraceSend( tctiContext, command_buffer, cnt ) );
+
     // Send TPM_SEND_COMMAND
     tpmSendCommand = CHANGE_ENDIAN_DWORD(tpmSendCommand);
     rval = tctiSendBytes( tctiContext, TCTI_CONTEXT_INTEL->tpmSock, (unsigned char *)&tpmSendCommand, 4 );
@@ -246,6 +277,40 @@ TSS2_RC SocketSetLocality(
     return rval;
 }
 
+TSS2_RC SocketGetPollHandles(
+    TSS2_TCTI_CONTEXT *tctiContext,     /* in */
+    TSS2_TCTI_POLL_HANDLE *handles,     /* out */
+    size_t *num_handles                 /* in/out */
+    )
+{
+    if( tctiContext == 0 || num_handles == 0 )
+    {
+        return TSS2_TCTI_RC_BAD_REFERENCE;
+    }
+
+    if( handles == 0 )
+    {
+        // In this case, just return the number of handles.
+        *num_handles = 1;
+        return TSS2_RC_SUCCESS;
+    }
+
+    if( *num_handles < 1 )
+    {
+        *num_handles = 1;
+        return TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+    }
+
+    // Only the TPM command socket carries responses; the platform socket
+    // is used synchronously by PlatformCommand.
+    handles[0].fd = TCTI_CONTEXT_INTEL->tpmSock;
+    handles[0].events = POLLIN;
+    handles[0].revents = 0;
+    *num_handles = 1;
+
+    return TSS2_RC_SUCCESS;
+}
+
 void SocketFinalize(
     TSS2_TCTI_CONTEXT *tctiContext       /* in */
     )
@@ -321,6 +386,8 @@ TSS2_RC SocketReceiveTpmResponse(
         goto retSocketReceiveTpmResponse;
     }
 
+    TCTI_TRACE( TctiTraceFirstByte( tctiContext ) );
+
     if( ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.protocolResponseSizeReceived != 1 )
     {
         // Receive the size of the response.
@@ -446,6 +513,10 @@ retSocketReceiveTpmResponse:
 		response_buffer != NULL )
     {
         ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->previousStage = TCTI_STAGE_RECEIVE_RESPONSE;
+
+        // response_buffer was moved past the tag and size if those were
+        // received by an earlier, too small, receive.
+        TCTI_TRACE( TctiTraceComplete( tctiContext, response_buffer - responseSizeDelta, *response_size ) );
     }
 
     return rval;
@@ -515,7 +586,7 @@ TSS2_RC InitSocketTcti (
         TSS2_TCTI_RECEIVE( tctiContext ) = SocketReceiveTpmResponse;
         TSS2_TCTI_FINALIZE( tctiContext ) = SocketFinalize;
         TSS2_TCTI_CANCEL( tctiContext ) = SocketCancel;
-        TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = 0;
+        TSS2_TCTI_GET_POLL_HANDLES( tctiContext ) = SocketGetPollHandles;
         TSS2_TCTI_SET_LOCALITY( tctiContext ) = SocketSetLocality;
         ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.debugMsgEnabled = 0;
         ((TSS2_TCTI_CONTEXT_INTEL *)tctiContext)->status.locality = 3;
@@ -0,0 +1,230 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+#include <tcti/tcti_trace.h>
+#include "tracehooks.h"
+
+#define TRACE_MIN_RING_SIZE 16
+#define TRACE_MAX_RING_SIZE ( 1 << 20 )
+
+//
+// Single-producer, single-consumer ring.  Only the owning thread advances
+// head and only TctiTraceDrain advances tail; both only ever increase, so
+// head - tail is the number of records waiting.  A thread that exits
+// gives its ring back, records and all, for the next new thread to take.
+//
+typedef struct TRACE_RING {
+    struct TRACE_RING *next;
+    uint32_t inUse;
+    uint32_t mask;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+    TCTI_TRACE_RECORD records[1];
+} TRACE_RING;
+
+volatile uint32_t tctiTraceEnabled = 0;
+
+static uint32_t traceRingSize = 0;
+static TRACE_RING *traceRings = 0;
+static __thread TRACE_RING *threadRing = 0;
+static pthread_key_t threadRingKey;
+static pthread_once_t threadRingKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t drainMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t NowNs()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void ReleaseRing( void *ring )
+{
+    __atomic_store_n( &( (TRACE_RING *)ring )->inUse, 0, __ATOMIC_RELEASE );
+}
+
+static void CreateRingKey()
+{
+    pthread_key_create( &threadRingKey, ReleaseRing );
+}
+
+//
+// Takes a ring given back by an exited thread, or adds a new one to the
+// list.  Rings are never freed, so the list can be walked without locks.
+//
+static TRACE_RING *ClaimRing()
+{
+    uint32_t size = __atomic_load_n( &traceRingSize, __ATOMIC_RELAXED );
+    TRACE_RING *ring;
+
+    if( size == 0 )
+        return 0;
+
+    pthread_once( &threadRingKeyOnce, CreateRingKey );
+
+    for( ring = __atomic_load_n( &traceRings, __ATOMIC_ACQUIRE ); ring != 0; ring = ring->next )
+    {
+        if( ring->mask + 1 == size &&
+                __atomic_exchange_n( &ring->inUse, 1, __ATOMIC_ACQUIRE ) == 0 )
+        {
+            goto claimed;
+        }
+    }
+
+    ring = calloc( 1, sizeof( TRACE_RING ) + ( size - 1 ) * sizeof( TCTI_TRACE_RECORD ) );
+    if( ring == 0 )
+        return 0;
+    ring->inUse = 1;
+    ring->mask = size - 1;
+    ring->next = __atomic_load_n( &traceRings, __ATOMIC_RELAXED );
+    while( !__atomic_compare_exchange_n( &traceRings, &ring->next, ring, 1,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED ) )
+        ;
+
+claimed:
+    pthread_setspecific( threadRingKey, ring );
+    return ring;
+}
+
+static void AddRecord( const TCTI_TRACE_RECORD *record )
+{
+    TRACE_RING *ring = threadRing;
+    uint64_t head;
+
+    if( ring == 0 )
+    {
+        ring = threadRing = ClaimRing();
+        if( ring == 0 )
+            return;
+    }
+
+    head = ring->head;
+    if( head - __atomic_load_n( &ring->tail, __ATOMIC_ACQUIRE ) > ring->mask )
+    {
+        __atomic_store_n( &ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED );
+        return;
+    }
+    ring->records[head & ring->mask] = *record;
+    __atomic_store_n( &ring->head, head + 1, __ATOMIC_RELEASE );
+}
+
+void TctiTraceEnable( uint32_t recordsPerThread )
+{
+    uint32_t size = TRACE_MIN_RING_SIZE;
+
+    if( recordsPerThread == 0 )
+    {
+        tctiTraceEnabled = 0;
+        return;
+    }
+
+    while( size < recordsPerThread && size < TRACE_MAX_RING_SIZE )
+        size <<= 1;
+
+    // Threads that already have a ring keep it.
+    if( __atomic_load_n( &traceRingSize, __ATOMIC_RELAXED ) == 0 )
+        __atomic_store_n( &traceRingSize, size, __ATOMIC_RELAXED );
+    tctiTraceEnabled = 1;
+}
+
+size_t TctiTraceDrain( TCTI_TRACE_RECORD *records, size_t count )
+{
+    TRACE_RING *ring;
+    uint64_t head, tail;
+    size_t drained = 0;
+
+    pthread_mutex_lock( &drainMutex );
+    for( ring = __atomic_load_n( &traceRings, __ATOMIC_ACQUIRE );
+            ring != 0 && drained < count; ring = ring->next )
+    {
+        head = __atomic_load_n( &ring->head, __ATOMIC_ACQUIRE );
+        for( tail = ring->tail; tail != head && drained < count; tail++ )
+            records[drained++] = ring->records[tail & ring->mask];
+        __atomic_store_n( &ring->tail, tail, __ATOMIC_RELEASE );
+    }
+    pthread_mutex_unlock( &drainMutex );
+
+    return drained;
+}
+
+uint64_t TctiTraceGetDroppedCount()
+{
+    TRACE_RING *ring;
+    uint64_t dropped = 0;
+
+    for( ring = __atomic_load_n( &traceRings, __ATOMIC_ACQUIRE ); ring != 0; ring = ring->next )
+        dropped += __atomic_load_n( &ring->dropped, __ATOMIC_RELAXED );
+
+    return dropped;
+}
+
+void TctiTraceSend( TSS2_TCTI_CONTEXT *tctiContext, const uint8_t *command, size_t command_size )
+{
+    TCTI_TRACE_RECORD *record = &TCTI_CONTEXT_INTEL->traceRecord;
+
+    memset( record, 0, sizeof( *record ) );
+    record->sendTime = NowNs();
+    record->commandCode = CHANGE_ENDIAN_DWORD( ( (TPM20_Header_In *)command )->commandCode );
+    record->commandSize = (uint32_t)command_size;
+    record->locality = (uint8_t)TCTI_CONTEXT_INTEL->status.locality;
+}
+
+void TctiTraceFirstByte( TSS2_TCTI_CONTEXT *tctiContext )
+{
+    TCTI_TRACE_RECORD *record = &TCTI_CONTEXT_INTEL->traceRecord;
+
+    if( record->sendTime != 0 && record->firstByteTime == 0 )
+        record->firstByteTime = NowNs();
+}
+
+void TctiTraceComplete( TSS2_TCTI_CONTEXT *tctiContext, const uint8_t *response, size_t response_size )
+{
+    TCTI_TRACE_RECORD *record = &TCTI_CONTEXT_INTEL->traceRecord;
+
+    // Tracing was enabled after the command was sent.
+    if( record->sendTime == 0 )
+        return;
+
+    record->completeTime = NowNs();
+    if( record->firstByteTime == 0 )
+        record->firstByteTime = record->completeTime;
+    record->responseSize = (uint32_t)response_size;
+    if( response_size >= sizeof( TPM20_ErrorResponse ) )
+        record->responseCode = CHANGE_ENDIAN_DWORD( ( (TPM20_ErrorResponse *)response )->responseCode );
+
+    AddRecord( record );
+    record->sendTime = 0;
+}
@@ -0,0 +1,64 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+#ifndef TRACEHOOKS_H
+#define TRACEHOOKS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Hooks the TCTIs call around each command; see tcti/tcti_trace.h.  The
+// pending record lives in the TCTI context, so hooks for different
+// contexts may run on different threads.
+//
+extern volatile uint32_t tctiTraceEnabled;
+
+#define TCTI_TRACE( hook ) do { if( tctiTraceEnabled ) { hook; } } while( 0 )
+
+void TctiTraceSend(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    const uint8_t *command,
+    size_t command_size
+    );
+
+void TctiTraceFirstByte(
+    TSS2_TCTI_CONTEXT *tctiContext
+    );
+
+void TctiTraceComplete(
+    TSS2_TCTI_CONTEXT *tctiContext,
+    const uint8_t *response,
+    size_t response_size
+    );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,301 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Measures SAPI and resource manager overhead against the loopback TCTI,
+// so that neither the simulator nor the network is part of the numbers.
+//
+// Usage: bench [iterations [latency-ns]]
+//
+// Every figure is in ns per iteration.  "tcti" is one transmit/receive
+// round trip on the loopback TCTI; the "prepare+complete" rows subtract
+// it from the time for _Prepare, Tss2_Sys_Execute and _Complete.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include <tcti/tcti_loopback.h>
+#include "sysapi_util.h"
+#include "syscontext.h"
+#include "resourcemgr.h"
+
+// Defined by the resource manager.
+extern TSS2_TCTI_CONTEXT *downstreamTctiContext;
+extern TSS2_SYS_CONTEXT *resMgrSysContext;
+extern TSS2_ABI_VERSION abiVersion;
+extern TSS2_RC InitResourceMgr( int debugLevel );
+
+#define DEFAULT_ITERATIONS 100000
+
+// Properties reported for TPM_CAP_TPM_PROPERTIES, in increasing order.
+static const UINT32 benchProperties[][2] = {
+    { TPM_PT_MANUFACTURER, 0x494e5443 },    // "INTC"
+    { TPM_PT_FIRMWARE_VERSION_1, 0x00010002 },
+    { TPM_PT_FIRMWARE_VERSION_2, 0x00030004 },
+    { TPM_PT_ACTIVE_SESSIONS_MAX, 64 },
+    { TPM_PT_CONTEXT_GAP_MAX, 255 },
+    { TPM_PT_MAX_COMMAND_SIZE, 4096 },
+    { TPM_PT_MAX_RESPONSE_SIZE, 4096 },
+    { TPM_PT_TOTAL_COMMANDS, 3 },
+    { TPM_PT_HR_LOADED, 3 },
+};
+
+// Commands reported for TPM_CAP_COMMANDS; none of them take handles.
+static const TPM_CC benchCommands[] = {
+    TPM_CC_Startup, TPM_CC_GetCapability, TPM_CC_GetRandom,
+};
+
+static const UINT8 getRandomResponse[] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static UINT8 *Put32( UINT8 *buffer, UINT32 value )
+{
+    buffer[0] = (UINT8)( value >> 24 );
+    buffer[1] = (UINT8)( value >> 16 );
+    buffer[2] = (UINT8)( value >> 8 );
+    buffer[3] = (UINT8)value;
+    return buffer + 4;
+}
+
+static UINT32 Get32( const UINT8 *buffer )
+{
+    return ( (UINT32)buffer[0] << 24 ) | ( (UINT32)buffer[1] << 16 ) |
+           ( (UINT32)buffer[2] << 8 ) | buffer[3];
+}
+
+//
+// Answers what InitResourceMgr and the benchmarks send: TPM2_Startup and
+// the GetCapability queries.  GetRandom has a canned response.
+//
+static TSS2_RC BenchResponder( void *data, const uint8_t *command, size_t commandSize,
+        uint8_t *response, size_t *responseSize )
+{
+    TPM_CC commandCode = Get32( command + 6 );
+    UINT32 capability, property, count, found = 0, i;
+    UINT8 *next = response + sizeof( TPM20_ErrorResponse );
+    UINT8 *countPtr;
+    TPM_RC responseCode = TPM_RC_SUCCESS;
+
+    if( commandCode == TPM_CC_GetCapability && commandSize >= 22 )
+    {
+        capability = Get32( command + 10 );
+        property = Get32( command + 14 );
+        count = Get32( command + 18 );
+
+        *next++ = 0;    // moreData
+        next = Put32( next, capability );
+        countPtr = next;
+        next += 4;
+
+        if( capability == TPM_CAP_TPM_PROPERTIES )
+        {
+            for( i = 0; i < sizeof( benchProperties ) / sizeof( benchProperties[0] ) && found < count; i++ )
+            {
+                if( benchProperties[i][0] >= property )
+                {
+                    next = Put32( next, benchProperties[i][0] );
+                    next = Put32( next, benchProperties[i][1] );
+                    found++;
+                }
+            }
+        }
+        else if( capability == TPM_CAP_COMMANDS )
+        {
+            for( i = 0; i < sizeof( benchCommands ) / sizeof( benchCommands[0] ) && found < count; i++ )
+            {
+                next = Put32( next, benchCommands[i] & 0xffff );
+                found++;
+            }
+        }
+        Put32( countPtr, found );
+    }
+    else if( commandCode != TPM_CC_Startup )
+    {
+        responseCode = TPM_RC_COMMAND_CODE;
+        next = response + sizeof( TPM20_ErrorResponse );
+    }
+
+    *responseSize = next - response;
+    ( (TPM20_ErrorResponse *)response )->tag = CHANGE_ENDIAN_WORD( TPM_ST_NO_SESSIONS );
+    ( (TPM20_ErrorResponse *)response )->responseSize = CHANGE_ENDIAN_DWORD( (UINT32)*responseSize );
+    ( (TPM20_ErrorResponse *)response )->responseCode = CHANGE_ENDIAN_DWORD( responseCode );
+
+    return TSS2_RC_SUCCESS;
+}
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Figures with the tcti round trip taken out can go negative under latency jitter.
+static void Report( const char *name, INT64 ns, UINT32 iterations )
+{
+    printf( "%-36s %10.1f\n", name, (double)ns / iterations );
+}
+
+static void Fail( const char *what, TSS2_RC rval )
+{
+    printf( "%s failed: 0x%x\n", what, rval );
+    exit( 1 );
+}
+
+int main( int argc, char *argv[] )
+{
+    UINT32 iterations = DEFAULT_ITERATIONS;
+    TCTI_LOOPBACK_CONF config = { BenchResponder, NULL, 0, NULL, NULL };
+    TSS2_TCTI_CONTEXT *tctiContext;
+    TSS2_SYS_CONTEXT *sysContext;
+    TPM2B_DIGEST randomBytes;
+    TPMI_YES_NO moreData;
+    TPMS_CAPABILITY_DATA capabilityData;
+    UINT8 command[] = { 0x80, 0x01, 0x00, 0x00, 0x00, 0x0c,
+                        0x00, 0x00, 0x01, 0x7b, 0x00, 0x10 };
+    UINT8 response[4096];
+    UINT32 responseSize;
+    size_t size;
+    UINT64 start, tcti;
+    TSS2_RC rval;
+    UINT32 i;
+
+    if( argc > 1 )
+        iterations = strtoul( argv[1], NULL, 10 );
+    if( argc > 2 )
+        config.latency = strtoul( argv[2], NULL, 10 );
+    if( iterations == 0 || argc > 3 )
+    {
+        printf( "Usage: %s [iterations [latency-ns]]\n", argv[0] );
+        return 1;
+    }
+
+    rval = InitLoopbackTcti( NULL, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+    tctiContext = malloc( size );
+    rval = InitLoopbackTcti( tctiContext, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+    LoopbackTctiSetResponse( tctiContext, TPM_CC_GetRandom, getRandomResponse, sizeof( getRandomResponse ) );
+
+    sysContext = InitSysContext( 0, tctiContext, &abiVersion );
+    if( sysContext == 0 )
+        Fail( "InitSysContext", TSS2_SYS_RC_INSUFFICIENT_CONTEXT );
+
+    printf( "%u iterations, %u ns latency, ns per iteration:\n", iterations, config.latency );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        size = sizeof( response );
+        tss2_tcti_transmit( tctiContext, sizeof( command ), command );
+        rval = tss2_tcti_receive( tctiContext, &size, response, TSS2_TCTI_TIMEOUT_BLOCK );
+    }
+    tcti = Now() - start;
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "loopback round trip", rval );
+    Report( "tcti", (INT64)tcti, iterations );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        Tss2_Sys_GetRandom_Prepare( sysContext, 16 );
+        Tss2_Sys_Execute( sysContext );
+        randomBytes.t.size = sizeof( randomBytes ) - 2;
+        rval = Tss2_Sys_GetRandom_Complete( sysContext, &randomBytes );
+    }
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "GetRandom _Prepare/_Complete", rval );
+    Report( "GetRandom prepare+complete", (INT64)( Now() - start ) - (INT64)tcti, iterations );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        randomBytes.t.size = sizeof( randomBytes ) - 2;
+        rval = Tss2_Sys_GetRandom( sysContext, 0, 16, &randomBytes, 0 );
+    }
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "Tss2_Sys_GetRandom", rval );
+    Report( "Tss2_Sys_GetRandom", (INT64)( Now() - start ), iterations );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        Tss2_Sys_GetCapability_Prepare( sysContext, TPM_CAP_TPM_PROPERTIES, TPM_PT_MANUFACTURER, 8 );
+        Tss2_Sys_Execute( sysContext );
+        rval = Tss2_Sys_GetCapability_Complete( sysContext, &moreData, &capabilityData );
+    }
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "GetCapability _Prepare/_Complete", rval );
+    Report( "GetCapability prepare+complete", (INT64)( Now() - start ) - (INT64)tcti, iterations );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        rval = Tss2_Sys_GetCapability( sysContext, 0, TPM_CAP_TPM_PROPERTIES,
+                TPM_PT_MANUFACTURER, 8, &moreData, &capabilityData, 0 );
+    }
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "Tss2_Sys_GetCapability", rval );
+    Report( "Tss2_Sys_GetCapability", (INT64)( Now() - start ), iterations );
+
+    // The resource manager talks to the same loopback TCTI, in process.
+    downstreamTctiContext = tctiContext;
+    resMgrSysContext = InitSysContext( 0, downstreamTctiContext, &abiVersion );
+    if( resMgrSysContext == 0 )
+        Fail( "InitSysContext", TSS2_SYS_RC_INSUFFICIENT_CONTEXT );
+    rval = InitResourceMgr( -1 );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitResourceMgr", rval );
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        responseSize = sizeof( response );
+        ResourceMgrSendTpmCommand( downstreamTctiContext, sizeof( command ), command );
+        rval = ResourceMgrReceiveTpmResponse( downstreamTctiContext, &responseSize, response, TSS2_TCTI_TIMEOUT_BLOCK );
+    }
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "resource manager round trip", rval );
+    Report( "ResourceMgr send/receive", (INT64)( Now() - start ) - (INT64)tcti, iterations );
+
+    TeardownSysContext( &resMgrSysContext );
+    TeardownSysContext( &sysContext );
+    tss2_tcti_finalize( tctiContext );
+    free( tctiContext );
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+
+//
+// Times the fixed-size fast path of the _Prepare and _Complete functions
+// against the checked path it replaced, with no TPM round trip.
+//
+// Usage: fixedbench [iterations]
+//
+// Every figure is in ns per call.  The "fast path" rows call the
+// functions as built, with one CheckFixedRegion for the fixed-size
+// fields; the "checked" rows make a Marshal_UINTxx / Unmarshal_UINTxx call
+// per field, the way those functions were written before.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+
+#define DEFAULT_ITERATIONS 1000000
+
+static TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+// ReadClock response: time, then TPMS_CLOCK_INFO.
+static const UINT8 readClockResponse[] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0xd6, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0xd6, 0x87,
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x01,
+};
+
+//
+// Just enough of a TCTI to get the ReadClock response into the sys
+// context once; every command is answered with it.
+//
+static TSS2_RC BenchTransmit( TSS2_TCTI_CONTEXT *tctiContext, size_t size, uint8_t *command )
+{
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC BenchReceive( TSS2_TCTI_CONTEXT *tctiContext, size_t *size, uint8_t *response, int32_t timeout )
+{
+    if( *size < sizeof( readClockResponse ) )
+        return TSS2_TCTI_RC_INSUFFICIENT_BUFFER;
+
+    memcpy( response, readClockResponse, sizeof( readClockResponse ) );
+    *size = sizeof( readClockResponse );
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_TCTI_CONTEXT_COMMON_V1 benchTcti = { 0, 1, BenchTransmit, BenchReceive, NULL, NULL, NULL, NULL };
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void Report( const char *name, INT64 ns, UINT32 iterations )
+{
+    printf( "%-36s %10.1f\n", name, (double)ns / iterations );
+}
+
+static void Fail( const char *what, TSS2_RC rval )
+{
+    printf( "%s failed: 0x%x\n", what, rval );
+    exit( 1 );
+}
+
+typedef TSS2_RC (*BENCH_STEP)( TSS2_SYS_CONTEXT *sysContext );
+
+static TSS2_RC FastGetCapabilityPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    return Tss2_Sys_GetCapability_Prepare( sysContext, TPM_CAP_TPM_PROPERTIES, TPM_PT_MANUFACTURER, 8 );
+}
+
+static TSS2_RC CheckedGetCapabilityPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    CommonPreparePrologue( sysContext, TPM_CC_GetCapability );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), TPM_CAP_TPM_PROPERTIES, &(SYS_CONTEXT->rval) );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), TPM_PT_MANUFACTURER, &(SYS_CONTEXT->rval) );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), 8, &(SYS_CONTEXT->rval) );
+    SYS_CONTEXT->decryptAllowed = 0;
+    SYS_CONTEXT->encryptAllowed = 0;
+    SYS_CONTEXT->authAllowed = 1;
+    CommonPrepareEpilogue( sysContext );
+
+    return SYS_CONTEXT->rval;
+}
+
+static TSS2_RC FastNvReadPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    return Tss2_Sys_NV_Read_Prepare( sysContext, NV_INDEX_FIRST, NV_INDEX_FIRST, 64, 0 );
+}
+
+static TSS2_RC CheckedNvReadPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    CommonPreparePrologue( sysContext, TPM_CC_NV_Read );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), NV_INDEX_FIRST, &(SYS_CONTEXT->rval) );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), NV_INDEX_FIRST, &(SYS_CONTEXT->rval) );
+    Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), 64, &(SYS_CONTEXT->rval) );
+    Marshal_UINT16( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), 0, &(SYS_CONTEXT->rval) );
+    SYS_CONTEXT->decryptAllowed = 0;
+    SYS_CONTEXT->encryptAllowed = 1;
+    SYS_CONTEXT->authAllowed = 1;
+    CommonPrepareEpilogue( sysContext );
+
+    return SYS_CONTEXT->rval;
+}
+
+static TSS2_RC FastFlushContextPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    return Tss2_Sys_FlushContext_Prepare( sysContext, TRANSIENT_FIRST );
+}
+
+static TSS2_RC CheckedFlushContextPrepare( TSS2_SYS_CONTEXT *sysContext )
+{
+    CommonPreparePrologue( sysContext, TPM_CC_FlushContext );
+    Marshal_UINT32( SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &(SYS_CONTEXT->nextData), TRANSIENT_FIRST, &(SYS_CONTEXT->rval) );
+    SYS_CONTEXT->decryptAllowed = 0;
+    SYS_CONTEXT->encryptAllowed = 0;
+    SYS_CONTEXT->authAllowed = 0;
+    CommonPrepareEpilogue( sysContext );
+
+    return SYS_CONTEXT->rval;
+}
+
+static TSS2_RC FastReadClockComplete( TSS2_SYS_CONTEXT *sysContext )
+{
+    TPMS_TIME_INFO currentTime;
+
+    return Tss2_Sys_ReadClock_Complete( sysContext, &currentTime );
+}
+
+static TSS2_RC CheckedReadClockComplete( TSS2_SYS_CONTEXT *sysContext )
+{
+    TPMS_TIME_INFO currentTime;
+
+    CommonComplete( sysContext );
+    Unmarshal_UINT64( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &currentTime.time, &( SYS_CONTEXT->rval ) );
+    Unmarshal_UINT64( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &currentTime.clockInfo.clock, &( SYS_CONTEXT->rval ) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &currentTime.clockInfo.resetCount, &( SYS_CONTEXT->rval ) );
+    Unmarshal_UINT32( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &currentTime.clockInfo.restartCount, &( SYS_CONTEXT->rval ) );
+    Unmarshal_UINT8( SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &(SYS_CONTEXT->nextData), &currentTime.clockInfo.safe, &( SYS_CONTEXT->rval ) );
+
+    return SYS_CONTEXT->rval;
+}
+
+typedef struct
+{
+    const char  *fastName;
+    const char  *checkedName;
+    BENCH_STEP  fast;
+    BENCH_STEP  checked;
+} BENCH_STEP_PAIR;
+
+static const BENCH_STEP_PAIR prepareSteps[] = {
+    { "GetCapability prepare, fast path", "GetCapability prepare, checked",
+      FastGetCapabilityPrepare, CheckedGetCapabilityPrepare },
+    { "NV_Read prepare, fast path", "NV_Read prepare, checked",
+      FastNvReadPrepare, CheckedNvReadPrepare },
+    { "FlushContext prepare, fast path", "FlushContext prepare, checked",
+      FastFlushContextPrepare, CheckedFlushContextPrepare },
+};
+
+static const BENCH_STEP_PAIR readClockSteps = {
+    "ReadClock complete, fast path", "ReadClock complete, checked",
+    FastReadClockComplete, CheckedReadClockComplete,
+};
+
+// Runs step 'iterations' times and reports the time per call.  A _Prepare
+// can be repeated as is, and so can a _Complete on the last response.
+static void TimeStep( TSS2_SYS_CONTEXT *sysContext, const char *name, BENCH_STEP step, UINT32 iterations )
+{
+    UINT64 start;
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+        rval = step( sysContext );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( name, rval );
+    Report( name, (INT64)( Now() - start ), iterations );
+}
+
+static void TimeStepPair( TSS2_SYS_CONTEXT *sysContext, const BENCH_STEP_PAIR *pair, UINT32 iterations )
+{
+    TimeStep( sysContext, pair->fastName, pair->fast, iterations );
+    TimeStep( sysContext, pair->checkedName, pair->checked, iterations );
+}
+
+int main( int argc, char *argv[] )
+{
+    UINT32 iterations = DEFAULT_ITERATIONS;
+    TSS2_SYS_CONTEXT *sysContext;
+    size_t size;
+    TSS2_RC rval;
+    UINT32 i;
+
+    if( argc > 1 )
+        iterations = strtoul( argv[1], NULL, 10 );
+    if( iterations == 0 || argc > 2 )
+    {
+        printf( "Usage: %s [iterations]\n", argv[0] );
+        return 1;
+    }
+
+    size = Tss2_Sys_GetContextSize( 0 );
+    sysContext = malloc( size );
+    if( sysContext == 0 )
+        Fail( "malloc", TSS2_SYS_RC_INSUFFICIENT_CONTEXT );
+    rval = Tss2_Sys_Initialize( sysContext, size, (TSS2_TCTI_CONTEXT *)&benchTcti, &abiVersion );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "Tss2_Sys_Initialize", rval );
+
+    printf( "%u iterations, ns per call:\n", iterations );
+
+    for( i = 0; i < sizeof( prepareSteps ) / sizeof( prepareSteps[0] ); i++ )
+        TimeStepPair( sysContext, &prepareSteps[i], iterations );
+
+    Tss2_Sys_ReadClock_Prepare( sysContext );
+    rval = Tss2_Sys_Execute( sysContext );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "ReadClock", rval );
+    TimeStepPair( sysContext, &readClockSteps, iterations );
+
+    Tss2_Sys_Finalize( sysContext );
+    free( sysContext );
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Shows how the sample code's entity and session bookkeeping
+// (test/common/sample/HandleTable.c, Entity.c) scales with the number of
+// entries.  For each table size it times AddEntity, GetEntity on present
+// and absent handles, a HandleTableFind on session handles (what
+// GetSessionStruct does per session per command) and DeleteEntity.  The
+// "scan" column is a lookup done by walking an array of ENTITYs, the way
+// the fixed entities[] array used to be searched, for comparison.
+//
+// Usage: handlebench [lookups]
+//
+// Every figure is in ns per call.  Lookups go through the handles in a
+// shuffled order, 'lookups' calls per table size.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+
+#define DEFAULT_LOOKUPS 1000000
+#define MAX_ENTRIES 65536
+
+static const UINT32 tableSizes[] = { 16, 64, 256, 1024, 4096, 16384, MAX_ENTRIES };
+
+static TPM_HANDLE handles[MAX_ENTRIES];
+static TPM_HANDLE absentHandles[MAX_ENTRIES];
+static ENTITY scanEntities[MAX_ENTRIES];
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void Fail( const char *what, TPM_HANDLE handle )
+{
+    printf( "%s failed for handle 0x%8.8x\n", what, handle );
+    exit( 1 );
+}
+
+// Half NV indices, half persistent keys, like an application keeping both,
+// in a random order.
+static void InitHandles()
+{
+    TPM_HANDLE tmp;
+    UINT32 i, j;
+
+    for( i = 0; i < MAX_ENTRIES; i++ )
+    {
+        handles[i] = ( i & 1 ? PERSISTENT_FIRST : NV_INDEX_FIRST ) + i / 2;
+        absentHandles[i] = ( i & 1 ? PERSISTENT_FIRST : NV_INDEX_FIRST ) + MAX_ENTRIES + i / 2;
+    }
+
+    srand( 1 );
+    for( i = MAX_ENTRIES - 1; i > 0; i-- )
+    {
+        j = (UINT32)rand() % ( i + 1 );
+        tmp = handles[i];
+        handles[i] = handles[j];
+        handles[j] = tmp;
+    }
+}
+
+static ENTITY *ScanEntities( UINT32 count, TPM_HANDLE handle )
+{
+    UINT32 i;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( scanEntities[i].entityHandle == handle )
+            return &scanEntities[i];
+    }
+
+    return 0;
+}
+
+static double TimeAdd( UINT32 count, TPM2B_AUTH *auth )
+{
+    UINT64 start;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < count; i++ )
+    {
+        if( AddEntity( handles[i], auth ) != TPM_RC_SUCCESS )
+            Fail( "AddEntity", handles[i] );
+    }
+
+    return (double)( Now() - start ) / count;
+}
+
+// The i-th lookup goes to handle i * stride, so successive lookups don't
+// walk the table in insertion order.
+static double TimeGet( UINT32 count, const TPM_HANDLE *lookupHandles, UINT32 lookups, TPM_RC expected )
+{
+    ENTITY *entity;
+    UINT32 stride = 7919 % count | 1;
+    UINT64 start;
+    UINT32 i, index = 0;
+
+    start = Now();
+    for( i = 0; i < lookups; i++ )
+    {
+        if( GetEntity( lookupHandles[index], &entity ) != expected )
+            Fail( "GetEntity", lookupHandles[index] );
+        index = ( index + stride ) % count;
+    }
+
+    return (double)( Now() - start ) / lookups;
+}
+
+static double TimeSessionFind( UINT32 count, UINT32 lookups )
+{
+    static SESSION session;
+    HANDLE_TABLE sessionTable = { 0, 0, 0 };
+    UINT32 stride = 7919 % count | 1;
+    UINT64 start;
+    UINT32 i, index = 0;
+
+    for( i = 0; i < count; i++ )
+        HandleTableInsert( &sessionTable, HMAC_SESSION_FIRST + i, &session, 0 );
+
+    start = Now();
+    for( i = 0; i < lookups; i++ )
+    {
+        if( HandleTableFind( &sessionTable, HMAC_SESSION_FIRST + index ) != &session )
+            Fail( "HandleTableFind", HMAC_SESSION_FIRST + index );
+        index = ( index + stride ) % count;
+    }
+    start = Now() - start;
+
+    HandleTableClear( &sessionTable, 0 );
+
+    return (double)start / lookups;
+}
+
+static double TimeDelete( UINT32 count )
+{
+    UINT64 start;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < count; i++ )
+    {
+        if( DeleteEntity( handles[i] ) != TPM_RC_SUCCESS )
+            Fail( "DeleteEntity", handles[i] );
+    }
+
+    return (double)( Now() - start ) / count;
+}
+
+static double TimeScan( UINT32 count, UINT32 lookups )
+{
+    UINT32 stride = 7919 % count | 1;
+    UINT64 start;
+    UINT32 i, index = 0;
+
+    for( i = 0; i < count; i++ )
+        scanEntities[i].entityHandle = handles[i];
+
+    start = Now();
+    for( i = 0; i < lookups; i++ )
+    {
+        if( ScanEntities( count, handles[index] ) == 0 )
+            Fail( "scan", handles[index] );
+        index = ( index + stride ) % count;
+    }
+
+    return (double)( Now() - start ) / lookups;
+}
+
+int main( int argc, char *argv[] )
+{
+    TPM2B_AUTH auth;
+    UINT32 lookups = DEFAULT_LOOKUPS, scanLookups, count;
+    size_t i;
+
+    if( argc > 1 )
+        lookups = strtoul( argv[1], NULL, 10 );
+    if( lookups == 0 || argc > 2 )
+    {
+        printf( "Usage: %s [lookups]\n", argv[0] );
+        return 1;
+    }
+
+    auth.t.size = 20;
+    memset( auth.t.buffer, 0xa5, auth.t.size );
+    InitHandles();
+
+    printf( "ns per call:\n" );
+    printf( "%8s %10s %10s %10s %10s %10s %10s\n",
+            "entries", "add", "get", "get miss", "session", "delete", "scan" );
+
+    for( i = 0; i < sizeof( tableSizes ) / sizeof( tableSizes[0] ); i++ )
+    {
+        count = tableSizes[i];
+
+        // A scan costs O(count); keep its total work about the same as
+        // the other columns so large sizes don't take minutes.
+        scanLookups = lookups / ( count / 16 );
+        if( scanLookups == 0 )
+            scanLookups = 1;
+
+        InitEntities();
+        printf( "%8u %10.1f", count, TimeAdd( count, &auth ) );
+        printf( " %10.1f", TimeGet( count, handles, lookups, TPM_RC_SUCCESS ) );
+        printf( " %10.1f", TimeGet( count, absentHandles, lookups, TPM_RC_FAILURE ) );
+        printf( " %10.1f", TimeSessionFind( count, lookups ) );
+        printf( " %10.1f", TimeDelete( count ) );
+        printf( " %10.1f\n", TimeScan( count, scanLookups ) );
+
+        if( GetEntityCount() != 0 )
+        {
+            printf( "%u entities left after deleting all of them\n", GetEntityCount() );
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Times the SAPI's marshalling of some common types against field-by-field
+// marshalling of the same types, the way the hand-written Marshal_* /
+// Unmarshal_* functions did it (test/unit/marshal-reference.c).  The "sapi"
+// column is the table-driven marshaller (sysapi_util/marshal_table.c),
+// except for PCR selections, which the SAPI marshals by hand.
+//
+// Usage: marshalbench [iterations]
+//
+// Every figure is in ns per call, marshalling into or unmarshalling from a
+// buffer in memory.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include "sysapi_util.h"
+#include "marshal-reference.h"
+
+#define DEFAULT_ITERATIONS 1000000
+
+typedef void (*BENCH_FN)( TSS2_SYS_CONTEXT *sysContext, void *value );
+
+typedef struct
+{
+    const char  *name;
+    void        *value;
+    size_t      size;
+    BENCH_FN    refMarshal;
+    BENCH_FN    refUnmarshal;
+    BENCH_FN    sapiMarshal;
+    BENCH_FN    sapiUnmarshal;
+} BENCH_CASE;
+
+// Puts the reference and table functions for a type behind BENCH_FN.
+#define BENCH_WRAPPERS( type ) \
+    static void RefMarshal_##type( TSS2_SYS_CONTEXT *sysContext, void *value ) \
+    { \
+        ref_marshal_##type( sysContext, (const type *)value ); \
+    } \
+    static void RefUnmarshal_##type( TSS2_SYS_CONTEXT *sysContext, void *value ) \
+    { \
+        ref_unmarshal_##type( sysContext, (type *)value ); \
+    } \
+    static void SapiMarshal_##type( TSS2_SYS_CONTEXT *sysContext, void *value ) \
+    { \
+        MARSHAL_TABLE( sysContext, &MarshalType_##type, value ); \
+    } \
+    static void SapiUnmarshal_##type( TSS2_SYS_CONTEXT *sysContext, void *value ) \
+    { \
+        UNMARSHAL_TABLE( sysContext, &MarshalType_##type, value ); \
+    }
+
+#define BENCH_FUNCTIONS( type ) \
+    RefMarshal_##type, RefUnmarshal_##type, SapiMarshal_##type, SapiUnmarshal_##type
+
+BENCH_WRAPPERS( TPMS_CONTEXT )
+BENCH_WRAPPERS( TPML_DIGEST )
+BENCH_WRAPPERS( TPMS_CAPABILITY_DATA )
+
+// TPM2B_PUBLIC goes through the SAPI's own functions, which put the size
+// around the table-driven TPMT_PUBLIC.  Unmarshalling wants a zero size.
+static void RefMarshal_TPM2B_PUBLIC( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    ref_marshal_TPM2B_PUBLIC( sysContext, (const TPM2B_PUBLIC *)value );
+}
+
+static void RefUnmarshal_TPM2B_PUBLIC( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    ( (TPM2B_PUBLIC *)value )->t.size = 0;
+    ref_unmarshal_TPM2B_PUBLIC( sysContext, (TPM2B_PUBLIC *)value );
+}
+
+static void SapiMarshal_TPM2B_PUBLIC( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    Marshal_TPM2B_PUBLIC( sysContext, (TPM2B_PUBLIC *)value );
+}
+
+static void SapiUnmarshal_TPM2B_PUBLIC( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    ( (TPM2B_PUBLIC *)value )->t.size = 0;
+    Unmarshal_TPM2B_PUBLIC( sysContext, (TPM2B_PUBLIC *)value );
+}
+
+static void RefMarshal_TPML_PCR_SELECTION( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    ref_marshal_TPML_PCR_SELECTION( sysContext, (const TPML_PCR_SELECTION *)value );
+}
+
+static void RefUnmarshal_TPML_PCR_SELECTION( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    ref_unmarshal_TPML_PCR_SELECTION( sysContext, (TPML_PCR_SELECTION *)value );
+}
+
+static void SapiMarshal_TPML_PCR_SELECTION( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    Marshal_TPML_PCR_SELECTION( sysContext, (TPML_PCR_SELECTION *)value );
+}
+
+static void SapiUnmarshal_TPML_PCR_SELECTION( TSS2_SYS_CONTEXT *sysContext, void *value )
+{
+    Unmarshal_TPML_PCR_SELECTION( sysContext, (TPML_PCR_SELECTION *)value );
+}
+
+static TPM2B_PUBLIC rsaPublic;
+static TPM2B_PUBLIC eccPublic;
+static TPMS_CONTEXT context;
+static TPML_PCR_SELECTION pcrSelection;
+static TPML_DIGEST digests;
+static TPMS_CAPABILITY_DATA properties;
+
+static BENCH_CASE benchCases[] = {
+    { "TPM2B_PUBLIC (RSA)", &rsaPublic, sizeof( rsaPublic ), BENCH_FUNCTIONS( TPM2B_PUBLIC ) },
+    { "TPM2B_PUBLIC (ECC)", &eccPublic, sizeof( eccPublic ), BENCH_FUNCTIONS( TPM2B_PUBLIC ) },
+    { "TPMS_CONTEXT", &context, sizeof( context ), BENCH_FUNCTIONS( TPMS_CONTEXT ) },
+    { "TPML_PCR_SELECTION", &pcrSelection, sizeof( pcrSelection ), BENCH_FUNCTIONS( TPML_PCR_SELECTION ) },
+    { "TPML_DIGEST", &digests, sizeof( digests ), BENCH_FUNCTIONS( TPML_DIGEST ) },
+    { "TPMS_CAPABILITY_DATA", &properties, sizeof( properties ), BENCH_FUNCTIONS( TPMS_CAPABILITY_DATA ) },
+};
+
+// Typical values: a 2048-bit RSA storage key, an ECDSA P-256 signing key,
+// a saved session, two PCR banks, a full digest list and a full page of
+// TPM properties.
+static void InitValues()
+{
+    TPMT_PUBLIC *area;
+    UINT32 attributes = 0x00030072, i;
+
+    area = &rsaPublic.t.publicArea;
+    area->type = TPM_ALG_RSA;
+    area->nameAlg = TPM_ALG_SHA256;
+    memcpy( &area->objectAttributes, &attributes, sizeof( attributes ) );
+    area->authPolicy.t.size = 32;
+    area->parameters.rsaDetail.symmetric.algorithm = TPM_ALG_AES;
+    area->parameters.rsaDetail.symmetric.keyBits.aes = 128;
+    area->parameters.rsaDetail.symmetric.mode.aes = TPM_ALG_CFB;
+    area->parameters.rsaDetail.scheme.scheme = TPM_ALG_NULL;
+    area->parameters.rsaDetail.keyBits = 2048;
+    area->unique.rsa.t.size = 256;
+
+    area = &eccPublic.t.publicArea;
+    area->type = TPM_ALG_ECC;
+    area->nameAlg = TPM_ALG_SHA256;
+    memcpy( &area->objectAttributes, &attributes, sizeof( attributes ) );
+    area->parameters.eccDetail.symmetric.algorithm = TPM_ALG_NULL;
+    area->parameters.eccDetail.scheme.scheme = TPM_ALG_ECDSA;
+    area->parameters.eccDetail.scheme.details.ecdsa.hashAlg = TPM_ALG_SHA256;
+    area->parameters.eccDetail.curveID = TPM_ECC_NIST_P256;
+    area->parameters.eccDetail.kdf.scheme = TPM_ALG_NULL;
+    area->unique.ecc.x.t.size = 32;
+    area->unique.ecc.y.t.size = 32;
+
+    context.sequence = 0x1234;
+    context.savedHandle = 0x02000000;
+    context.hierarchy = TPM_RH_OWNER;
+    context.contextBlob.t.size = 1024;
+
+    pcrSelection.count = 2;
+    pcrSelection.pcrSelections[0].hash = TPM_ALG_SHA1;
+    pcrSelection.pcrSelections[1].hash = TPM_ALG_SHA256;
+    for( i = 0; i < pcrSelection.count; i++ )
+    {
+        pcrSelection.pcrSelections[i].sizeofSelect = 3;
+        memset( pcrSelection.pcrSelections[i].pcrSelect, 0xff, 3 );
+    }
+
+    digests.count = sizeof( digests.digests ) / sizeof( digests.digests[0] );
+    for( i = 0; i < digests.count; i++ )
+    {
+        digests.digests[i].t.size = 32;
+    }
+
+    properties.capability = TPM_CAP_TPM_PROPERTIES;
+    properties.data.tpmProperties.count = MAX_TPM_PROPERTIES;
+    for( i = 0; i < MAX_TPM_PROPERTIES; i++ )
+    {
+        properties.data.tpmProperties.tpmProperty[i].property = PT_FIXED + i;
+        properties.data.tpmProperties.tpmProperty[i].value = i;
+    }
+}
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void Fail( const char *what, TSS2_RC rval )
+{
+    printf( "%s failed: 0x%x\n", what, rval );
+    exit( 1 );
+}
+
+// Runs fn 'iterations' times from the start of the buffer and returns the
+// time per call.
+static double Time( _TSS2_SYS_CONTEXT_BLOB *sysContext, BENCH_FN fn, void *value, UINT32 iterations )
+{
+    UINT64 start;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        sysContext->nextData = sysContext->tpmInBuffPtr;
+        sysContext->rval = TSS2_RC_SUCCESS;
+        fn( (TSS2_SYS_CONTEXT *)sysContext, value );
+    }
+    if( sysContext->rval != TSS2_RC_SUCCESS )
+        Fail( "marshalling", sysContext->rval );
+
+    return (double)( Now() - start ) / iterations;
+}
+
+int main( int argc, char *argv[] )
+{
+    static UINT8 refBuffer[8192], sapiBuffer[8192];
+    _TSS2_SYS_CONTEXT_BLOB ref = { 0 }, sapi = { 0 };
+    UINT32 iterations = DEFAULT_ITERATIONS;
+    BENCH_CASE *benchCase;
+    void *out;
+    size_t i;
+
+    if( argc > 1 )
+        iterations = strtoul( argv[1], NULL, 10 );
+    if( iterations == 0 || argc > 2 )
+    {
+        printf( "Usage: %s [iterations]\n", argv[0] );
+        return 1;
+    }
+
+    // Each path marshals into, and unmarshals from, its own buffer.
+    ref.tpmInBuffPtr = ref.tpmOutBuffPtr = refBuffer;
+    ref.maxCommandSize = ref.maxResponseSize = sizeof( refBuffer );
+    sapi.tpmInBuffPtr = sapi.tpmOutBuffPtr = sapiBuffer;
+    sapi.maxCommandSize = sapi.maxResponseSize = sizeof( sapiBuffer );
+
+    InitValues();
+
+    printf( "%u iterations, ns per call:\n", iterations );
+    printf( "%-24s %-10s %10s %10s\n", "", "", "reference", "sapi" );
+
+    for( i = 0; i < sizeof( benchCases ) / sizeof( benchCases[0] ); i++ )
+    {
+        benchCase = &benchCases[i];
+        out = malloc( benchCase->size );
+
+        printf( "%-24s %-10s %10.1f %10.1f\n", benchCase->name, "marshal",
+                Time( &ref, benchCase->refMarshal, benchCase->value, iterations ),
+                Time( &sapi, benchCase->sapiMarshal, benchCase->value, iterations ) );
+
+        // Both paths must have put the same bytes on the wire.
+        if( ref.nextData - refBuffer != sapi.nextData - sapiBuffer ||
+            memcmp( refBuffer, sapiBuffer, ref.nextData - refBuffer ) != 0 )
+        {
+            printf( "%s: reference and sapi output differ\n", benchCase->name );
+            return 1;
+        }
+
+        printf( "%-24s %-10s %10.1f %10.1f\n", "", "unmarshal",
+                Time( &ref, benchCase->refUnmarshal, out, iterations ),
+                Time( &sapi, benchCase->sapiUnmarshal, out, iterations ) );
+
+        free( out );
+    }
+
+    return 0;
+}
@@ -0,0 +1,585 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Throughput of 1 KiB NV_Write commands through an HMAC session that
+// also encrypts the data parameter with AES-128-CFB, the encryption done
+// by the TPM (EncryptCFB) and by the host (HostEncryptCFB).
+//
+// Usage: nvwritebench [iterations [latency-ns]]
+//
+// The TPM is played in process, behind the loopback TCTI: it answers
+// StartAuthSession and NV_Write, checking the command HMAC, decrypting
+// the data and comparing it with what was meant to be written, and the
+// LoadExternal, EncryptDecrypt and FlushContext commands EncryptCFB
+// sends.  latency-ns is added to every command; "commands" is how many
+// commands each write cost in all.  Hashes and HMACs are done on the
+// host throughout; the "portable" row turns off acceleration for them
+// as well as for AES.
+//
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include <tcti/tcti_loopback.h>
+#include "sample.h"
+
+#define DEFAULT_ITERATIONS 10000
+
+#define BENCH_SESSION_HANDLE    ( HMAC_SESSION_FIRST )
+#define BENCH_NV_INDEX          ( NV_INDEX_FIRST + 0x1500200 )
+#define BENCH_KEY_HANDLE        ( TRANSIENT_FIRST + 2 )
+
+#define BENCH_WRITE_SIZE 1024
+
+#define SESSION_ATTRIBUTE_DECRYPT 0x20
+
+//
+// Globals the sample code expects.
+//
+TSS2_TCTI_CONTEXT *resMgrTctiContext = 0;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+UINT32 ( *ComputeSessionHmacPtr )(
+    TSS2_SYS_CONTEXT *sysContext,
+    TPMS_AUTH_COMMAND *cmdAuth,
+    TPM_HANDLE entityHandle,
+    TPM_RC responseCode,
+    TPM_HANDLE handle1,
+    TPM_HANDLE handle2,
+    TPMA_SESSION sessionAttributes,
+    TPM2B_DIGEST *result,
+    TPM_RC sessionCmdRval ) = TpmComputeSessionHmac;
+
+TPM_RC ( *CalcPHash )( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDLE handle2,
+    TPMI_ALG_HASH authHash, TPM_RC responseCode, TPM2B_DIGEST *pHash ) = TpmCalcPHash;
+
+UINT32 (*HmacFunctionPtr)( TPMI_ALG_HASH hashAlg, TPM2B *key,TPM2B **bufferList, TPM2B_DIGEST *result ) = HostHmac;
+
+UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = HostHash;
+
+static UINT32 BenchHandleToName( TPM_HANDLE handle, TPM2B_NAME *name );
+
+UINT32 (*HandleToNameFunctionPtr)( TPM_HANDLE handle, TPM2B_NAME *name ) = BenchHandleToName;
+
+TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue ) = EncryptCFB;
+
+TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue ) = DecryptCFB;
+
+//
+// The NV index written.  A real client has its name from NV_ReadPublic;
+// here it is just a nameAlg and a digest's worth of bytes.
+//
+static const TPM2B_AUTH nvAuth = { { 8, { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6 } } };
+static TPM2B_NAME nvName;
+static TPM2B_MAX_NV_BUFFER writeData;
+
+//
+// What the TPM played behind the loopback TCTI remembers.
+//
+typedef struct {
+    TPM2B_NONCE nonceTpm;           // The HMAC session's current TPM nonce.
+    UINT16 nonceSize;               // nonceCaller's size at StartAuthSession.
+    UINT32 nonceCount;
+    TPM2B_DIGEST aesKey;            // Loaded by LoadExternal.
+} BENCH_TPM;
+
+static UINT16 Get16( const UINT8 *buffer )
+{
+    return (UINT16)( ( buffer[0] << 8 ) | buffer[1] );
+}
+
+static UINT32 Get32( const UINT8 *buffer )
+{
+    return ( (UINT32)Get16( buffer ) << 16 ) | Get16( buffer + 2 );
+}
+
+static UINT8 *Put16( UINT8 *buffer, UINT16 value )
+{
+    buffer[0] = (UINT8)( value >> 8 );
+    buffer[1] = (UINT8)value;
+    return buffer + 2;
+}
+
+static UINT8 *Put32( UINT8 *buffer, UINT32 value )
+{
+    return Put16( Put16( buffer, (UINT16)( value >> 16 ) ), (UINT16)value );
+}
+
+static UINT8 *PutSized( UINT8 *buffer, const TPM2B *data )
+{
+    buffer = Put16( buffer, data->size );
+    memcpy( buffer, data->buffer, data->size );
+    return buffer + data->size;
+}
+
+// Copies the TPM2B at *next into data, if it fits, and steps past it.
+static int GetSized( const UINT8 **next, const UINT8 *end, TPM2B *data, UINT16 maxSize )
+{
+    UINT16 size;
+
+    if( end - *next < 2 )
+        return 0;
+    size = Get16( *next );
+    if( size > maxSize || end - *next - 2 < size )
+        return 0;
+    data->size = size;
+    memcpy( data->buffer, *next + 2, size );
+    *next += 2 + size;
+    return 1;
+}
+
+static void NextNonce( BENCH_TPM *tpm )
+{
+    tpm->nonceCount++;
+    tpm->nonceTpm.t.size = tpm->nonceSize;
+    memset( tpm->nonceTpm.t.buffer, 0x4e, tpm->nonceTpm.t.size );
+    Put32( tpm->nonceTpm.t.buffer, tpm->nonceCount );
+}
+
+//
+// Checks an NV_Write's command HMAC, decrypts and checks its data and
+// builds its response, with the response HMAC.  The session is unbound
+// and unsalted, so the HMAC and CFB keys come from the index's authValue.
+//
+static TPM_RC BenchNvWrite( BENCH_TPM *tpm, const UINT8 *command, const UINT8 *end, UINT8 **next )
+{
+    UINT8 hashInput[sizeof( TPM_CC ) + 2 * sizeof( TPMU_NAME ) + sizeof( TPM2B_MAX_NV_BUFFER ) + 2];
+    TPM2B_NONCE nonceCaller;
+    TPM2B_DIGEST hmac, pHash, expected;
+    TPM2B_MAX_BUFFER cfbKey;
+    TPM2B_IV iv;
+    TPM2B_MAX_NV_BUFFER data;
+    TPM2B attributes = { 1, { 0 } };
+    TPM2B *bufferList[5];
+    const UINT8 *auth = command + 22;
+    const UINT8 *parameters;
+    UINT8 *hashNext;
+
+    if( Get16( command ) != TPM_ST_SESSIONS || end - auth < 4 ||
+            Get32( command + 10 ) != BENCH_NV_INDEX || Get32( command + 14 ) != BENCH_NV_INDEX ||
+            Get32( auth ) != BENCH_SESSION_HANDLE )
+    {
+        return TPM_RC_VALUE;
+    }
+
+    parameters = auth + Get32( command + 18 );
+    auth += 4;
+    if( !GetSized( &auth, end, &nonceCaller.b, sizeof( nonceCaller.t.buffer ) ) || auth == end )
+        return TPM_RC_SIZE;
+    attributes.buffer[0] = *auth++;
+    if( !GetSized( &auth, end, &hmac.b, sizeof( hmac.t.buffer ) ) || auth != parameters ||
+            end - parameters > (ptrdiff_t)sizeof( data ) + 2 )
+    {
+        return TPM_RC_SIZE;
+    }
+
+    // cpHash = H( commandCode || authHandle name || nvIndex name || parameters ).
+    hashNext = hashInput;
+    memcpy( hashNext, command + 6, 4 );
+    hashNext += 4;
+    memcpy( hashNext, nvName.t.name, nvName.t.size );
+    hashNext += nvName.t.size;
+    memcpy( hashNext, nvName.t.name, nvName.t.size );
+    hashNext += nvName.t.size;
+    memcpy( hashNext, parameters, end - parameters );
+    hashNext += end - parameters;
+    HostHash( TPM_ALG_SHA256, (UINT16)( hashNext - hashInput ), hashInput, &pHash );
+
+    bufferList[0] = &pHash.b;
+    bufferList[1] = &nonceCaller.b;
+    bufferList[2] = &tpm->nonceTpm.b;
+    bufferList[3] = &attributes;
+    bufferList[4] = 0;
+    HostHmac( TPM_ALG_SHA256, (TPM2B *)&nvAuth.b, bufferList, &expected );
+    if( expected.t.size != hmac.t.size || memcmp( expected.t.buffer, hmac.t.buffer, hmac.t.size ) != 0 )
+        return TPM_RC_S + TPM_RC_1 + TPM_RC_AUTH_FAIL;
+
+    if( !GetSized( &parameters, end, &data.b, sizeof( data.t.buffer ) ) || end - parameters != 2 )
+        return TPM_RC_SIZE;
+
+    if( attributes.buffer[0] & SESSION_ATTRIBUTE_DECRYPT )
+    {
+        // KDFa( sessionAlg, authValue, "CFB", nonceCaller, nonceTPM ): the key, then the IV.
+        KDFa( TPM_ALG_SHA256, (TPM2B *)&nvAuth.b, "CFB", &nonceCaller.b, &tpm->nonceTpm.b,
+                128 + 128, &cfbKey );
+        iv.t.size = 16;
+        memcpy( iv.t.buffer, cfbKey.t.buffer + 16, iv.t.size );
+        cfbKey.t.size = 16;
+        HostAesCfb( YES, &cfbKey.b, &iv, data.t.buffer, data.t.size );
+    }
+    if( data.t.size != writeData.t.size || memcmp( data.t.buffer, writeData.t.buffer, data.t.size ) != 0 )
+        return TPM_RC_P + TPM_RC_1 + TPM_RC_VALUE;
+
+    NextNonce( tpm );
+
+    // No response parameters: rpHash = H( responseCode || commandCode ).
+    *next = Put32( *next, 0 );
+    Put32( hashInput, TPM_RC_SUCCESS );
+    memcpy( hashInput + 4, command + 6, 4 );
+    HostHash( TPM_ALG_SHA256, 8, hashInput, &pHash );
+
+    bufferList[1] = &tpm->nonceTpm.b;
+    bufferList[2] = &nonceCaller.b;
+    HostHmac( TPM_ALG_SHA256, (TPM2B *)&nvAuth.b, bufferList, &hmac );
+
+    *next = PutSized( *next, &tpm->nonceTpm.b );
+    *( *next )++ = attributes.buffer[0];
+    *next = PutSized( *next, &hmac.b );
+
+    return TPM_RC_SUCCESS;
+}
+
+static TSS2_RC BenchResponder( void *data, const uint8_t *command, size_t commandSize,
+        uint8_t *response, size_t *responseSize )
+{
+    BENCH_TPM *tpm = (BENCH_TPM *)data;
+    const UINT8 *end = command + commandSize;
+    const UINT8 *parameters;
+    UINT8 *next = response + sizeof( TPM20_ErrorResponse );
+    TPM_ST tag = TPM_ST_NO_SESSIONS;
+    TPM_RC responseCode = TPM_RC_SUCCESS;
+    TPM2B_MAX_BUFFER buffer;
+    TPM2B_IV iv;
+    UINT32 handles = 0;
+    UINT8 decrypt;
+
+    switch( Get32( command + 6 ) )
+    {
+        case TPM_CC_StartAuthSession:
+            handles = 2;
+            break;
+
+        case TPM_CC_EncryptDecrypt:
+            handles = 1;
+            break;
+    }
+
+    // Skip the handles and any (password) sessions to the parameters.
+    parameters = command + 10 + 4 * handles;
+    if( Get16( command ) == TPM_ST_SESSIONS && Get32( command + 6 ) != TPM_CC_NV_Write )
+    {
+        tag = TPM_ST_SESSIONS;
+        parameters += 4 + Get32( parameters );
+    }
+    if( parameters > end )
+    {
+        responseCode = TPM_RC_COMMAND_SIZE;
+        goto done;
+    }
+
+    switch( Get32( command + 6 ) )
+    {
+        case TPM_CC_StartAuthSession:
+            if( !GetSized( &parameters, end, &buffer.b, sizeof( tpm->nonceTpm.t.buffer ) ) ||
+                    buffer.t.size < sizeof( UINT32 ) )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            tpm->nonceSize = buffer.t.size;
+            NextNonce( tpm );
+            next = Put32( next, BENCH_SESSION_HANDLE );
+            next = PutSized( next, &tpm->nonceTpm.b );
+            break;
+
+        case TPM_CC_NV_Write:
+            tag = TPM_ST_SESSIONS;
+            responseCode = BenchNvWrite( tpm, command, end, &next );
+            break;
+
+        case TPM_CC_LoadExternal:
+            // TPM2B_SENSITIVE: size, sensitiveType, authValue, seedValue, then the key.
+            parameters += 2 + 2;
+            if( !GetSized( &parameters, end, &buffer.b, sizeof( buffer.t.buffer ) ) ||
+                    !GetSized( &parameters, end, &buffer.b, sizeof( buffer.t.buffer ) ) ||
+                    !GetSized( &parameters, end, &buffer.b, sizeof( tpm->aesKey.t.buffer ) ) )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            tpm->aesKey.t.size = buffer.t.size;
+            memcpy( tpm->aesKey.t.buffer, buffer.t.buffer, buffer.t.size );
+            next = Put32( next, BENCH_KEY_HANDLE );
+            next = PutSized( next, &nvName.b );
+            break;
+
+        case TPM_CC_EncryptDecrypt:
+            if( end - parameters < 3 )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            decrypt = parameters[0];
+            parameters += 3;
+            if( !GetSized( &parameters, end, &iv.b, sizeof( iv.t.buffer ) ) ||
+                    !GetSized( &parameters, end, &buffer.b, sizeof( buffer.t.buffer ) ) )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            HostAesCfb( decrypt, &tpm->aesKey.b, &iv, buffer.t.buffer, buffer.t.size );
+            next = Put32( next, 2 + buffer.t.size + 2 + iv.t.size );
+            next = PutSized( next, &buffer.b );
+            next = PutSized( next, &iv.b );
+            // The password session's response: no nonce, no attributes, no HMAC.
+            next = Put16( next, 0 );
+            *next++ = 0;
+            next = Put16( next, 0 );
+            break;
+
+        case TPM_CC_FlushContext:
+            break;
+
+        default:
+            responseCode = TPM_RC_COMMAND_CODE;
+            break;
+    }
+
+done:
+    if( responseCode != TPM_RC_SUCCESS )
+    {
+        tag = TPM_ST_NO_SESSIONS;
+        next = response + sizeof( TPM20_ErrorResponse );
+    }
+
+    *responseSize = next - response;
+    Put16( response, tag );
+    Put32( response + 2, (UINT32)*responseSize );
+    Put32( response + 6, responseCode );
+
+    return TSS2_RC_SUCCESS;
+}
+
+static UINT32 BenchHandleToName( TPM_HANDLE handle, TPM2B_NAME *name )
+{
+    if( handle == BENCH_NV_INDEX )
+    {
+        *name = nvName;
+    }
+    else
+    {
+        name->t.size = sizeof( TPM_HANDLE );
+        Put32( name->t.name, handle );
+    }
+    return TPM_RC_SUCCESS;
+}
+
+// The sample session code's debug output would otherwise be timed too.
+static int QuietPrintf( printf_type type, const char *format, va_list args )
+{
+    return 0;
+}
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void Fail( const char *what, TSS2_RC rval )
+{
+    printf( "%s failed: 0x%x\n", what, rval );
+    exit( 1 );
+}
+
+//
+// One NV_Write through the session: the data encrypted if encrypt is
+// set, the command HMAC over the encrypted data, the command itself and
+// a check of the response HMAC, the session continuing.
+//
+static TSS2_RC NvWrite( TSS2_SYS_CONTEXT *sysContext, SESSION *session, UINT8 encrypt )
+{
+    TPMS_AUTH_COMMAND sessionAuth;
+    TPMS_AUTH_COMMAND *sessionAuthArray[1] = { &sessionAuth };
+    TSS2_SYS_CMD_AUTHS sessionAuths = { 1, &sessionAuthArray[0] };
+    TPMS_AUTH_RESPONSE responseAuth;
+    TPMS_AUTH_RESPONSE *responseAuthArray[1] = { &responseAuth };
+    TSS2_SYS_RSP_AUTHS responseAuths = { 1, &responseAuthArray[0] };
+    TPM2B_MAX_BUFFER encryptedData;
+    TSS2_RC rval;
+
+    rval = Tss2_Sys_NV_Write_Prepare( sysContext, BENCH_NV_INDEX, BENCH_NV_INDEX, &writeData, 0 );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    sessionAuth.sessionHandle = session->sessionHandle;
+    sessionAuth.nonce.t.size = 16;
+    memset( sessionAuth.nonce.t.buffer, 0xa5, sessionAuth.nonce.t.size );
+    *( (UINT8 *)&sessionAuth.sessionAttributes ) = 0;
+    sessionAuth.sessionAttributes.continueSession = 1;
+    sessionAuth.sessionAttributes.decrypt = encrypt;
+    sessionAuth.hmac.t.size = 0;
+    RollNonces( session, &sessionAuth.nonce );
+
+    if( encrypt )
+    {
+        rval = EncryptCommandParam( session, &encryptedData, (TPM2B_MAX_BUFFER *)&writeData,
+                (TPM2B_AUTH *)&nvAuth );
+        if( rval != TPM_RC_SUCCESS )
+            return rval;
+
+        rval = Tss2_Sys_SetDecryptParam( sysContext, encryptedData.t.size, encryptedData.t.buffer );
+        if( rval != TPM_RC_SUCCESS )
+            return rval;
+    }
+
+    rval = ComputeCommandHmacs( sysContext, BENCH_NV_INDEX, BENCH_NV_INDEX, &sessionAuths,
+            TPM_RC_FAILURE );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    rval = Tss2_Sys_SetCmdAuths( sysContext, &sessionAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    rval = Tss2_Sys_Execute( sysContext );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    rval = Tss2_Sys_GetRspAuths( sysContext, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    RollNonces( session, &responseAuths.rspAuths[0]->nonce );
+    return CheckResponseHMACs( sysContext, TPM_RC_SUCCESS, &sessionAuths, BENCH_NV_INDEX,
+            BENCH_NV_INDEX, &responseAuths );
+}
+
+static void TimeNvWrite( TSS2_SYS_CONTEXT *sysContext, SESSION *session, const char *name,
+        UINT8 encrypt, UINT32 iterations )
+{
+    UINT32 commands = LoopbackTctiGetCommandCount( resMgrTctiContext );
+    UINT64 start, elapsed;
+    TSS2_RC rval;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        rval = NvWrite( sysContext, session, encrypt );
+        if( rval != TPM_RC_SUCCESS )
+            Fail( name, rval );
+    }
+    elapsed = Now() - start;
+    commands = LoopbackTctiGetCommandCount( resMgrTctiContext ) - commands;
+
+    printf( "%-24s %10.0f %10.1f %10.1f %10.1f\n", name, (double)iterations * 1000000000 / elapsed,
+            (double)iterations * BENCH_WRITE_SIZE * 1000000000 / elapsed / ( 1024 * 1024 ),
+            (double)elapsed / iterations / 1000, (double)commands / iterations );
+}
+
+int main( int argc, char *argv[] )
+{
+    UINT32 iterations = DEFAULT_ITERATIONS;
+    BENCH_TPM tpm;
+    TCTI_LOOPBACK_CONF config = { BenchResponder, &tpm, 0, NULL, NULL };
+    TSS2_SYS_CONTEXT *sysContext;
+    SESSION *session;
+    TPM2B_NONCE nonceCaller;
+    TPM2B_ENCRYPTED_SECRET encryptedSalt;
+    TPMT_SYM_DEF symmetric;
+    size_t size;
+    TSS2_RC rval;
+    UINT32 i;
+
+    if( argc > 1 )
+        iterations = strtoul( argv[1], NULL, 10 );
+    if( argc > 2 )
+        config.latency = strtoul( argv[2], NULL, 10 );
+    if( iterations == 0 || argc > 3 )
+    {
+        printf( "Usage: %s [iterations [latency-ns]]\n", argv[0] );
+        return 1;
+    }
+
+    SetDebugHooks( QuietPrintf, 0 );
+
+    memset( &tpm, 0, sizeof( tpm ) );
+    nvName.t.size = sizeof( TPM_ALG_ID ) + SHA256_DIGEST_SIZE;
+    Put16( nvName.t.name, TPM_ALG_SHA256 );
+    memset( nvName.t.name + 2, 0x1d, SHA256_DIGEST_SIZE );
+    writeData.t.size = BENCH_WRITE_SIZE;
+    for( i = 0; i < writeData.t.size; i++ )
+        writeData.t.buffer[i] = (UINT8)i;
+
+    rval = InitLoopbackTcti( NULL, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+    resMgrTctiContext = malloc( size );
+    rval = InitLoopbackTcti( resMgrTctiContext, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+
+    sysContext = InitSysContext( 0, resMgrTctiContext, &abiVersion );
+    if( sysContext == 0 )
+        Fail( "InitSysContext", TSS2_SYS_RC_INSUFFICIENT_CONTEXT );
+
+    InitEntities();
+    rval = AddEntity( BENCH_NV_INDEX, (TPM2B_AUTH *)&nvAuth );
+    if( rval != TPM_RC_SUCCESS )
+        Fail( "AddEntity", rval );
+
+    nonceCaller.t.size = 0;
+    encryptedSalt.t.size = 0;
+    symmetric.algorithm = TPM_ALG_AES;
+    symmetric.keyBits.aes = 128;
+    symmetric.mode.aes = TPM_ALG_CFB;
+    rval = StartAuthSessionWithParams( &session, TPM_RH_NULL, 0, TPM_RH_NULL, 0,
+            &nonceCaller, &encryptedSalt, TPM_SE_HMAC, &symmetric, TPM_ALG_SHA256,
+            resMgrTctiContext );
+    if( rval != TPM_RC_SUCCESS )
+        Fail( "StartAuthSessionWithParams", rval );
+
+    printf( "%u iterations of %u bytes, %u ns latency:\n", iterations, BENCH_WRITE_SIZE, config.latency );
+    printf( "%-24s %10s %10s %10s %10s\n", "", "writes/s", "MiB/s", "us/write", "commands" );
+
+    TimeNvWrite( sysContext, session, "no encryption", 0, iterations );
+
+    EncryptCfbFunctionPtr = EncryptCFB;
+    TimeNvWrite( sysContext, session, "TPM AES-CFB", 1, iterations );
+
+    EncryptCfbFunctionPtr = HostEncryptCFB;
+    HostCryptoUseAcceleration( 0 );
+    TimeNvWrite( sysContext, session, "host AES-CFB, portable", 1, iterations );
+
+    HostCryptoUseAcceleration( 1 );
+    TimeNvWrite( sysContext, session, "host AES-CFB, accel.", 1, iterations );
+
+    EndAuthSession( session );
+    TeardownSysContext( &sysContext );
+    tss2_tcti_finalize( resMgrTctiContext );
+    free( resMgrTctiContext );
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Replays a log written by the record TCTI against a TPM, a simulator or
+// the resource manager, and reports throughput and latency percentiles.
+//
+// Usage: replay [-tpm device | -host host [-port port]] [-clients n] [-max] log
+//
+// Each virtual client has its own TCTI and replays the commands of one
+// recorded connection; with more clients than connections, connections are
+// replayed more than once, concurrently.  Commands are sent at the
+// recorded times unless -max is given.
+//
+// Object and session handles returned by the TPM, or by the resource
+// manager, differ from the recorded ones, so each client maps the handles
+// in the recorded responses to the ones it got and rewrites the commands.
+// Commands authorized with HMAC sessions will not verify on replay; they
+// are counted as mismatches like any other response code that differs from
+// the recorded one.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sapi/tpm20.h>
+#include <tcti/tcti_record.h>
+#include "sysapi_util.h"
+#include "tcti_util.h"
+
+#define MAX_MAPPED_HANDLES 64
+
+typedef struct {
+    TPM_HANDLE recorded;
+    TPM_HANDLE live;
+} HANDLE_MAPPING;
+
+typedef struct {
+    UINT32 connection;
+    UINT32 recordCount;
+    const TCTI_RECORD_HEADER **records;
+} REPLAY_CONNECTION;
+
+typedef struct {
+    pthread_t thread;
+    REPLAY_CONNECTION *connection;
+    TSS2_TCTI_CONTEXT *tctiContext;
+    HANDLE_MAPPING handles[MAX_MAPPED_HANDLES];
+    UINT32 handleCount;
+    UINT64 *latencies;
+    UINT32 commandCount;
+    UINT32 mismatches;
+    TSS2_RC rval;
+} REPLAY_CLIENT;
+
+static UINT64 firstTimestamp;
+static UINT64 startTime;
+static UINT8 maxSpeed = 0;
+
+static UINT16 Get16( const UINT8 *buffer )
+{
+    return (UINT16)( ( buffer[0] << 8 ) | buffer[1] );
+}
+
+static UINT32 Get32( const UINT8 *buffer )
+{
+    return ( (UINT32)buffer[0] << 24 ) | ( (UINT32)buffer[1] << 16 ) |
+           ( (UINT32)buffer[2] << 8 ) | buffer[3];
+}
+
+static void Put32( UINT8 *buffer, UINT32 value )
+{
+    buffer[0] = (UINT8)( value >> 24 );
+    buffer[1] = (UINT8)( value >> 16 );
+    buffer[2] = (UINT8)( value >> 8 );
+    buffer[3] = (UINT8)value;
+}
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void SleepUntil( UINT64 ns )
+{
+    struct timespec deadline = { (time_t)( ns / 1000000000 ), (long)( ns % 1000000000 ) };
+
+    while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL ) != 0 )
+        ;
+}
+
+//
+// Only handles the TPM assigns at run time are remapped; persistent, NV,
+// PCR and permanent handles are the same on replay.
+//
+static int IsMappedHandle( TPM_HANDLE handle )
+{
+    UINT8 type = (UINT8)( handle >> HR_SHIFT );
+
+    return type == TPM_HT_TRANSIENT || type == TPM_HT_HMAC_SESSION ||
+           type == TPM_HT_POLICY_SESSION;
+}
+
+static HANDLE_MAPPING *FindMapping( REPLAY_CLIENT *client, TPM_HANDLE recorded )
+{
+    UINT32 i;
+
+    for( i = 0; i < client->handleCount; i++ )
+    {
+        if( client->handles[i].recorded == recorded )
+            return &client->handles[i];
+    }
+    return NULL;
+}
+
+static void AddMapping( REPLAY_CLIENT *client, TPM_HANDLE recorded, TPM_HANDLE live )
+{
+    HANDLE_MAPPING *mapping = FindMapping( client, recorded );
+
+    if( mapping == NULL && client->handleCount < MAX_MAPPED_HANDLES )
+        mapping = &client->handles[client->handleCount++];
+    if( mapping != NULL )
+    {
+        mapping->recorded = recorded;
+        mapping->live = live;
+    }
+}
+
+static void RemoveMapping( REPLAY_CLIENT *client, TPM_HANDLE recorded )
+{
+    HANDLE_MAPPING *mapping = FindMapping( client, recorded );
+
+    if( mapping != NULL )
+        *mapping = client->handles[--client->handleCount];
+}
+
+static void RemapHandle( REPLAY_CLIENT *client, UINT8 *buffer )
+{
+    TPM_HANDLE handle = Get32( buffer );
+    HANDLE_MAPPING *mapping;
+
+    if( IsMappedHandle( handle ) && ( mapping = FindMapping( client, handle ) ) != NULL )
+        Put32( buffer, mapping->live );
+}
+
+//
+// Rewrites the handle area, the session handles in the authorization area
+// and the handle parameter of TPM2_FlushContext.
+//
+static void RemapCommand( REPLAY_CLIENT *client, UINT8 *command, UINT32 commandSize )
+{
+    UINT8 *next = command + sizeof( TPM20_Header_In );
+    UINT8 *end = command + commandSize;
+    UINT8 *authEnd;
+    TPM_CC commandCode;
+    int numHandles;
+
+    if( commandSize < sizeof( TPM20_Header_In ) )
+        return;
+
+    commandCode = Get32( command + 6 );
+    numHandles = GetNumCommandHandles( commandCode );
+    for( ; numHandles > 0 && next + 4 <= end; numHandles--, next += 4 )
+        RemapHandle( client, next );
+
+    if( commandCode == TPM_CC_FlushContext && next + 4 <= end )
+    {
+        RemapHandle( client, next );
+    }
+    else if( Get16( command ) == TPM_ST_SESSIONS && next + 4 <= end )
+    {
+        authEnd = next + 4 + Get32( next );
+        if( authEnd > end )
+            authEnd = end;
+        next += 4;
+        while( next + 4 + 2 <= authEnd )
+        {
+            RemapHandle( client, next );
+            next += 4;
+            next += 2 + Get16( next );     // nonce
+            next += 1;                      // session attributes
+            if( next + 2 > authEnd )
+                break;
+            next += 2 + Get16( next );     // hmac
+        }
+    }
+}
+
+//
+// Learns the handles created by a command that succeeded both when it was
+// recorded and now, and forgets the ones it flushed.
+//
+static void LearnHandles( REPLAY_CLIENT *client, const TCTI_RECORD_HEADER *record,
+        const UINT8 *response, size_t responseSize )
+{
+    const UINT8 *command = TCTI_RECORD_COMMAND( record );
+    const UINT8 *recordedResponse = TCTI_RECORD_RESPONSE( record );
+    TPM_CC commandCode = Get32( command + 6 );
+    int numHandles = GetNumResponseHandles( commandCode );
+    size_t offset = sizeof( TPM20_ErrorResponse );
+    int i;
+
+    for( i = 0; i < numHandles; i++, offset += 4 )
+    {
+        if( offset + 4 > responseSize || offset + 4 > record->responseSize )
+            break;
+        AddMapping( client, Get32( recordedResponse + offset ), Get32( response + offset ) );
+    }
+
+    if( commandCode == TPM_CC_FlushContext && record->commandSize >= sizeof( TPM20_Header_In ) + 4 )
+    {
+        RemoveMapping( client, Get32( command + sizeof( TPM20_Header_In ) ) );
+    }
+}
+
+static void *ReplayClient( void *data )
+{
+    REPLAY_CLIENT *client = (REPLAY_CLIENT *)data;
+    REPLAY_CONNECTION *connection = client->connection;
+    const TCTI_RECORD_HEADER *record;
+    UINT8 command[TCTI_RECORD_MAX_COMMAND];
+    UINT8 response[TCTI_RECORD_MAX_RESPONSE];
+    size_t responseSize;
+    UINT8 locality = 0xff;
+    UINT64 sent;
+    UINT32 i;
+
+    for( i = 0; i < connection->recordCount; i++ )
+    {
+        record = connection->records[i];
+        if( record->commandSize < sizeof( TPM20_Header_In ) ||
+            record->responseSize < sizeof( TPM20_ErrorResponse ) )
+            continue;
+
+        memcpy( command, TCTI_RECORD_COMMAND( record ), record->commandSize );
+        RemapCommand( client, command, record->commandSize );
+
+        if( record->locality != locality )
+        {
+            client->rval = tss2_tcti_set_locality( client->tctiContext, record->locality );
+            if( client->rval != TSS2_RC_SUCCESS )
+                break;
+            locality = record->locality;
+        }
+
+        if( !maxSpeed )
+            SleepUntil( startTime + ( record->timestamp - firstTimestamp ) );
+
+        sent = Now();
+        client->rval = tss2_tcti_transmit( client->tctiContext, record->commandSize, command );
+        if( client->rval != TSS2_RC_SUCCESS )
+            break;
+        responseSize = sizeof( response );
+        client->rval = tss2_tcti_receive( client->tctiContext, &responseSize, response, TSS2_TCTI_TIMEOUT_BLOCK );
+        if( client->rval != TSS2_RC_SUCCESS )
+            break;
+        client->latencies[client->commandCount++] = Now() - sent;
+
+        if( responseSize < sizeof( TPM20_ErrorResponse ) ||
+            Get32( response + 6 ) != Get32( TCTI_RECORD_RESPONSE( record ) + 6 ) )
+        {
+            client->mismatches++;
+        }
+        else if( Get32( response + 6 ) == TPM_RC_SUCCESS )
+        {
+            LearnHandles( client, record, response, responseSize );
+        }
+    }
+
+    return NULL;
+}
+
+static int CompareLatencies( const void *a, const void *b )
+{
+    UINT64 x = *(const UINT64 *)a, y = *(const UINT64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void PrintHelp( const char *name )
+{
+    printf( "Usage: %s [-tpm device | -host host [-port port]] [-clients n] [-max] log\n"
+            "\n"
+            "-tpm     replay to a TPM device (default /dev/tpm0)\n"
+            "-host    replay over the socket interface, e.g. to the resource manager\n"
+            "-port    socket port (default %d)\n"
+            "-clients number of concurrent virtual clients (default: one per recorded connection)\n"
+            "-max     send commands as fast as possible instead of at the recorded times\n",
+            name, DEFAULT_RESMGR_TPM_PORT );
+}
+
+int main( int argc, char *argv[] )
+{
+    TCTI_DEVICE_CONF deviceConfig = { "/dev/tpm0", NULL, NULL };
+    TCTI_SOCKET_CONF socketConfig = { NULL, DEFAULT_RESMGR_TPM_PORT, NULL, NULL, NULL };
+    const char *logFile = NULL;
+    TCTI_RECORD_LOG log;
+    const TCTI_RECORD_HEADER *record;
+    REPLAY_CONNECTION *connections = NULL;
+    REPLAY_CLIENT *clients;
+    UINT32 connectionCount = 0, clientCount = 0, recordCount = 0;
+    UINT32 total = 0, mismatches = 0, failed = 0, i, j;
+    UINT64 *latencies, elapsed;
+    TSS2_RC rval;
+    int count;
+
+    for( count = 1; count < argc; count++ )
+    {
+        if( 0 == strcmp( argv[count], "-tpm" ) && count + 1 < argc )
+        {
+            deviceConfig.device_path = argv[++count];
+        }
+        else if( 0 == strcmp( argv[count], "-host" ) && count + 1 < argc )
+        {
+            socketConfig.hostname = argv[++count];
+        }
+        else if( 0 == strcmp( argv[count], "-port" ) && count + 1 < argc )
+        {
+            socketConfig.port = strtoul( argv[++count], NULL, 10 );
+        }
+        else if( 0 == strcmp( argv[count], "-clients" ) && count + 1 < argc )
+        {
+            clientCount = strtoul( argv[++count], NULL, 10 );
+        }
+        else if( 0 == strcmp( argv[count], "-max" ) )
+        {
+            maxSpeed = 1;
+        }
+        else if( argv[count][0] != '-' && logFile == NULL )
+        {
+            logFile = argv[count];
+        }
+        else
+        {
+            PrintHelp( argv[0] );
+            return 1;
+        }
+    }
+    if( logFile == NULL )
+    {
+        PrintHelp( argv[0] );
+        return 1;
+    }
+
+    rval = RecordLogOpen( &log, logFile );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        printf( "Can't open %s: 0x%x\n", logFile, rval );
+        return 1;
+    }
+
+    //
+    // Sort the records by connection, keeping their order.
+    //
+    while( ( record = RecordLogNext( &log ) ) != NULL )
+    {
+        if( recordCount++ == 0 || record->timestamp < firstTimestamp )
+            firstTimestamp = record->timestamp;
+        for( i = 0; i < connectionCount; i++ )
+        {
+            if( connections[i].connection == record->connection )
+                break;
+        }
+        if( i == connectionCount )
+        {
+            connections = realloc( connections, ( connectionCount + 1 ) * sizeof( REPLAY_CONNECTION ) );
+            connections[connectionCount].connection = record->connection;
+            connections[connectionCount].recordCount = 0;
+            connections[connectionCount].records = NULL;
+            connectionCount++;
+        }
+        connections[i].records = realloc( connections[i].records,
+                ( connections[i].recordCount + 1 ) * sizeof( TCTI_RECORD_HEADER * ) );
+        connections[i].records[connections[i].recordCount++] = record;
+    }
+    if( recordCount == 0 )
+    {
+        printf( "%s has no records\n", logFile );
+        return 1;
+    }
+    if( clientCount == 0 )
+        clientCount = connectionCount;
+
+    clients = calloc( clientCount, sizeof( REPLAY_CLIENT ) );
+    for( i = 0; i < clientCount; i++ )
+    {
+        clients[i].connection = &connections[i % connectionCount];
+        clients[i].latencies = malloc( clients[i].connection->recordCount * sizeof( UINT64 ) );
+        if( socketConfig.hostname != NULL )
+            rval = InitSocketTctiContext( &socketConfig, &clients[i].tctiContext );
+        else
+            rval = InitDeviceTctiContext( &deviceConfig, &clients[i].tctiContext, "replay" );
+        if( rval != TSS2_RC_SUCCESS )
+        {
+            printf( "Client %u: TCTI initialization failed: 0x%x\n", i, rval );
+            return 1;
+        }
+    }
+
+    printf( "%u records, %u connections, %u clients, %s\n", recordCount, connectionCount,
+            clientCount, maxSpeed ? "max speed" : "recorded speed" );
+
+    startTime = Now();
+    for( i = 0; i < clientCount; i++ )
+        pthread_create( &clients[i].thread, NULL, ReplayClient, &clients[i] );
+    for( i = 0; i < clientCount; i++ )
+        pthread_join( clients[i].thread, NULL );
+    elapsed = Now() - startTime;
+
+    for( i = 0; i < clientCount; i++ )
+    {
+        total += clients[i].commandCount;
+        mismatches += clients[i].mismatches;
+        if( clients[i].rval != TSS2_RC_SUCCESS )
+        {
+            printf( "Client %u stopped after %u commands: 0x%x\n", i, clients[i].commandCount, clients[i].rval );
+            failed++;
+        }
+    }
+
+    latencies = malloc( ( total + 1 ) * sizeof( UINT64 ) );
+    for( i = 0, j = 0; i < clientCount; i++ )
+    {
+        memcpy( &latencies[j], clients[i].latencies, clients[i].commandCount * sizeof( UINT64 ) );
+        j += clients[i].commandCount;
+    }
+    qsort( latencies, total, sizeof( UINT64 ), CompareLatencies );
+
+    printf( "%u commands in %.3f s: %.1f commands/s, %u response codes differ from the log\n",
+            total, elapsed / 1e9, total / ( elapsed / 1e9 ), mismatches );
+    if( total != 0 )
+    {
+        printf( "latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                latencies[total / 2] / 1e3,
+                latencies[(UINT64)total * 90 / 100] / 1e3,
+                latencies[(UINT64)total * 99 / 100] / 1e3,
+                latencies[(UINT64)total * 999 / 1000] / 1e3,
+                latencies[total - 1] / 1e3 );
+    }
+
+    for( i = 0; i < clientCount; i++ )
+    {
+        TeardownTctiContext( &clients[i].tctiContext );
+        free( clients[i].latencies );
+    }
+    for( i = 0; i < connectionCount; i++ )
+        free( connections[i].records );
+    free( connections );
+    free( clients );
+    free( latencies );
+    RecordLogClose( &log );
+
+    return failed != 0;
+}
@@ -0,0 +1,760 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Multi-client stress test and latency benchmark for the resource manager.
+//
+// Usage: rmstress [-host host] [-port port] [-clients n] [-ops n]
+//                 [-workload name]... [-baseline file]
+//
+// Each client is a separate process with its own connection; the sample
+// session code keeps its sessions and entities in process-wide tables, so
+// clients can't share a process.  For every workload, all clients do their
+// setup, start together and run the same number of operations; the time
+// of each operation is sent back to the parent, which prints one line of
+// key=value pairs per workload:
+//
+//   workload=hmac clients=4 ops=400 commands=800 errors=0 seconds=1.234
+//   ops_per_sec=324.1 p50_us=... p90_us=... p99_us=... p999_us=...
+//   us_per_command=...
+//
+// The resource manager's own cost per command is the difference between
+// us_per_command measured through it and measured without it.  The
+// simulator only accepts one connection, so the two can't be measured in
+// one run: save the output of a single-client run made directly against
+// the simulator (or the resource manager's downstream TPM) and pass it
+// with -baseline; every workload found in it then also gets
+// rm_overhead_us_per_command.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "tcti_util.h"
+
+#define MAX_WORKLOADS 8
+#define MAX_CLIENTS 64
+
+//
+// Each client gets its own NV index so that clients don't contend on NV
+// state; the index is removed again when the workload is done.
+//
+#define RMSTRESS_NV_INDEX_BASE 0x01500100
+#define RMSTRESS_NV_SIZE 16
+
+typedef struct {
+    UINT32 index;
+    TSS2_SYS_CONTEXT *sysContext;
+    TPMI_RH_NV_INDEX nvIndex;
+    TPM2B_AUTH nvAuth;
+    TPM_HANDLE parentHandle;
+    TPM2B_PRIVATE keyPrivate;
+    TPM2B_PUBLIC keyPublic;
+} CLIENT;
+
+typedef struct {
+    const char *name;
+    UINT32 commandsPerOp;
+    TSS2_RC (*setup)( CLIENT *client );
+    TSS2_RC (*op)( CLIENT *client );
+    void (*teardown)( CLIENT *client );
+} WORKLOAD;
+
+//
+// What a client sends back to the parent, followed by opCount latencies
+// in nanoseconds.
+//
+typedef struct {
+    TSS2_RC rval;
+    UINT32 opCount;
+    UINT64 finished;
+} CLIENT_RESULT;
+
+//
+// Globals the sample code expects.
+//
+TSS2_TCTI_CONTEXT *resMgrTctiContext = 0;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+UINT32 ( *ComputeSessionHmacPtr )(
+    TSS2_SYS_CONTEXT *sysContext,
+    TPMS_AUTH_COMMAND *cmdAuth,
+    TPM_HANDLE entityHandle,
+    TPM_RC responseCode,
+    TPM_HANDLE handle1,
+    TPM_HANDLE handle2,
+    TPMA_SESSION sessionAttributes,
+    TPM2B_DIGEST *result,
+    TPM_RC sessionCmdRval ) = TpmComputeSessionHmac;
+
+TPM_RC ( *CalcPHash )( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDLE handle2,
+    TPMI_ALG_HASH authHash, TPM_RC responseCode, TPM2B_DIGEST *pHash ) = TpmCalcPHash;
+
+UINT32 (*HmacFunctionPtr)( TPMI_ALG_HASH hashAlg, TPM2B *key,TPM2B **bufferList, TPM2B_DIGEST *result ) = HostHmac;
+
+UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = HostHash;
+
+UINT32 (*HandleToNameFunctionPtr)( TPM_HANDLE handle, TPM2B_NAME *name ) = CachedHandleToName;
+
+TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue ) = EncryptCFB;
+
+TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue ) = DecryptCFB;
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+//
+// Password authorization area with a single session.
+//
+static TPMS_AUTH_COMMAND passwordAuth;
+static TPMS_AUTH_COMMAND *passwordAuthArray[1] = { &passwordAuth };
+static TSS2_SYS_CMD_AUTHS passwordAuths = { 1, &passwordAuthArray[0] };
+
+static TPMS_AUTH_RESPONSE responseAuth;
+static TPMS_AUTH_RESPONSE *responseAuthArray[1] = { &responseAuth };
+static TSS2_SYS_RSP_AUTHS responseAuths = { 1, &responseAuthArray[0] };
+
+static TSS2_SYS_CMD_AUTHS *PasswordAuths( TPM2B_AUTH *auth )
+{
+    passwordAuth.sessionHandle = TPM_RS_PW;
+    passwordAuth.nonce.t.size = 0;
+    *( (UINT8 *)&passwordAuth.sessionAttributes ) = 0;
+    if( auth != 0 )
+        passwordAuth.hmac = *auth;
+    else
+        passwordAuth.hmac.t.size = 0;
+    return &passwordAuths;
+}
+
+//
+// HMAC key in the NULL hierarchy, used both as the signing key and as the
+// CreatePrimary storm's primary; keyedhash keys are cheap to create, so
+// the figures show the resource manager rather than key generation.
+//
+static void InitHmacKeyTemplate( TPM2B_PUBLIC *inPublic )
+{
+    memset( inPublic, 0, sizeof( *inPublic ) );
+    inPublic->t.publicArea.type = TPM_ALG_KEYEDHASH;
+    inPublic->t.publicArea.nameAlg = TPM_ALG_SHA256;
+    *(UINT32 *)&( inPublic->t.publicArea.objectAttributes ) = 0;
+    inPublic->t.publicArea.objectAttributes.sign = 1;
+    inPublic->t.publicArea.objectAttributes.userWithAuth = 1;
+    inPublic->t.publicArea.objectAttributes.fixedTPM = 1;
+    inPublic->t.publicArea.objectAttributes.fixedParent = 1;
+    inPublic->t.publicArea.objectAttributes.sensitiveDataOrigin = 1;
+    inPublic->t.publicArea.authPolicy.t.size = 0;
+    inPublic->t.publicArea.parameters.keyedHashDetail.scheme.scheme = TPM_ALG_HMAC;
+    inPublic->t.publicArea.parameters.keyedHashDetail.scheme.details.hmac.hashAlg = TPM_ALG_SHA256;
+    inPublic->t.publicArea.unique.keyedHash.t.size = 0;
+}
+
+static TSS2_RC CreatePrimary( CLIENT *client, TPM2B_PUBLIC *inPublic, TPM_HANDLE *handle )
+{
+    TPM2B_SENSITIVE_CREATE inSensitive = { { sizeof( TPM2B_SENSITIVE_CREATE ) - 2, } };
+    TPM2B_DATA outsideInfo = { { 0, } };
+    TPML_PCR_SELECTION creationPCR = { 0, };
+    TPM2B_PUBLIC outPublic = { { 0, } };
+    TPM2B_CREATION_DATA creationData = { { 0, } };
+    TPM2B_DIGEST creationHash = { { sizeof( TPM2B_DIGEST ) - 2, } };
+    TPMT_TK_CREATION creationTicket = { 0, 0, { { sizeof( TPM2B_DIGEST ) - 2, } } };
+    TPM2B_NAME name = { { sizeof( TPM2B_NAME ) - 2, } };
+
+    inSensitive.t.sensitive.userAuth.t.size = 0;
+    inSensitive.t.sensitive.data.t.size = 0;
+    inSensitive.t.size = 4;
+
+    return Tss2_Sys_CreatePrimary( client->sysContext, TPM_RH_NULL, PasswordAuths( 0 ),
+            &inSensitive, inPublic, &outsideInfo, &creationPCR, handle, &outPublic,
+            &creationData, &creationHash, &creationTicket, &name, &responseAuths );
+}
+
+//
+// getrandom: one TPM2_GetRandom per operation.
+//
+static TSS2_RC GetRandomOp( CLIENT *client )
+{
+    TPM2B_DIGEST randomBytes = { { sizeof( TPM2B_DIGEST ) - 2, } };
+
+    return Tss2_Sys_GetRandom( client->sysContext, 0, 16, &randomBytes, 0 );
+}
+
+//
+// nvread: an NV index authorized by its password, read once per operation.
+//
+static TSS2_RC NvSetup( CLIENT *client )
+{
+    TPM2B_NV_PUBLIC publicInfo;
+    TPM2B_MAX_NV_BUFFER nvData;
+    TSS2_RC rval;
+
+    client->nvIndex = RMSTRESS_NV_INDEX_BASE + client->index;
+    client->nvAuth.t.size = 8;
+    memset( client->nvAuth.t.buffer, 0xa0 + ( client->index & 0xf ), client->nvAuth.t.size );
+
+    // Left over from an interrupted run; ignore the error if it isn't.
+    Tss2_Sys_NV_UndefineSpace( client->sysContext, TPM_RH_OWNER, client->nvIndex,
+            PasswordAuths( 0 ), 0 );
+
+    publicInfo.t.nvPublic.nvIndex = client->nvIndex;
+    publicInfo.t.nvPublic.nameAlg = TPM_ALG_SHA256;
+    *(UINT32 *)&( publicInfo.t.nvPublic.attributes ) = 0;
+    publicInfo.t.nvPublic.attributes.TPMA_NV_AUTHREAD = 1;
+    publicInfo.t.nvPublic.attributes.TPMA_NV_AUTHWRITE = 1;
+    publicInfo.t.nvPublic.authPolicy.t.size = 0;
+    publicInfo.t.nvPublic.dataSize = RMSTRESS_NV_SIZE;
+    publicInfo.t.size = sizeof( TPMI_RH_NV_INDEX ) + sizeof( TPMI_ALG_HASH ) +
+            sizeof( TPMA_NV ) + sizeof( UINT16 ) + sizeof( UINT16 );
+
+    rval = Tss2_Sys_NV_DefineSpace( client->sysContext, TPM_RH_OWNER, PasswordAuths( 0 ),
+            &client->nvAuth, &publicInfo, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    nvData.t.size = RMSTRESS_NV_SIZE;
+    memset( nvData.t.buffer, client->index, nvData.t.size );
+    rval = Tss2_Sys_NV_Write( client->sysContext, client->nvIndex, client->nvIndex,
+            PasswordAuths( &client->nvAuth ), &nvData, 0, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    // The write changed the index's name; the HMAC workload needs the new one.
+    NameCacheInvalidate( client->nvIndex );
+    return AddEntity( client->nvIndex, &client->nvAuth );
+}
+
+static TSS2_RC NvReadOp( CLIENT *client )
+{
+    TPM2B_MAX_NV_BUFFER nvData = { { sizeof( TPM2B_MAX_NV_BUFFER ) - 2, } };
+
+    return Tss2_Sys_NV_Read( client->sysContext, client->nvIndex, client->nvIndex,
+            PasswordAuths( &client->nvAuth ), RMSTRESS_NV_SIZE, 0, &nvData, &responseAuths );
+}
+
+static void NvTeardown( CLIENT *client )
+{
+    Tss2_Sys_NV_UndefineSpace( client->sysContext, TPM_RH_OWNER, client->nvIndex,
+            PasswordAuths( 0 ), 0 );
+    DeleteEntity( client->nvIndex );
+}
+
+//
+// hmac: start an unbound, unsalted HMAC session and use it, once, to
+// authorize a read of the client's NV index.  The session ends with the
+// read, so every operation is a StartAuthSession and an NV_Read.
+//
+static TSS2_RC HmacOp( CLIENT *client )
+{
+    SESSION *session;
+    TPM2B_NONCE nonceCaller;
+    TPM2B_ENCRYPTED_SECRET encryptedSalt;
+    TPMT_SYM_DEF symmetric;
+    TPMS_AUTH_COMMAND sessionAuth;
+    TPMS_AUTH_COMMAND *sessionAuthArray[1] = { &sessionAuth };
+    TSS2_SYS_CMD_AUTHS sessionAuths = { 1, &sessionAuthArray[0] };
+    TPM2B_MAX_NV_BUFFER nvData = { { sizeof( TPM2B_MAX_NV_BUFFER ) - 2, } };
+    TSS2_RC rval, sessionCmdRval;
+
+    nonceCaller.t.size = 0;
+    encryptedSalt.t.size = 0;
+    symmetric.algorithm = TPM_ALG_NULL;
+
+    rval = StartAuthSessionWithParams( &session, TPM_RH_NULL, 0, TPM_RH_NULL, 0,
+            &nonceCaller, &encryptedSalt, TPM_SE_HMAC, &symmetric, TPM_ALG_SHA256,
+            resMgrTctiContext );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    rval = (*HandleToNameFunctionPtr)( session->sessionHandle, &session->name );
+    if( rval != TPM_RC_SUCCESS )
+        goto exit;
+
+    rval = Tss2_Sys_NV_Read_Prepare( client->sysContext, client->nvIndex, client->nvIndex,
+            RMSTRESS_NV_SIZE, 0 );
+    if( rval != TPM_RC_SUCCESS )
+        goto exit;
+
+    sessionAuth.sessionHandle = session->sessionHandle;
+    sessionAuth.nonce.t.size = 16;
+    memset( sessionAuth.nonce.t.buffer, 0xa5, sessionAuth.nonce.t.size );
+    *( (UINT8 *)&sessionAuth.sessionAttributes ) = 0;
+    RollNonces( session, &sessionAuth.nonce );
+
+    rval = ComputeCommandHmacs( client->sysContext, client->nvIndex, client->nvIndex,
+            &sessionAuths, TPM_RC_FAILURE );
+    if( rval != TPM_RC_SUCCESS )
+        goto exit;
+
+    sessionCmdRval = Tss2_Sys_NV_Read( client->sysContext, client->nvIndex, client->nvIndex,
+            &sessionAuths, RMSTRESS_NV_SIZE, 0, &nvData, &responseAuths );
+    if( sessionCmdRval != TPM_RC_SUCCESS )
+    {
+        // A failed command leaves the session loaded.
+        Tss2_Sys_FlushContext( client->sysContext, session->sessionHandle );
+        rval = sessionCmdRval;
+        goto exit;
+    }
+
+    RollNonces( session, &responseAuths.rspAuths[0]->nonce );
+    rval = CheckResponseHMACs( client->sysContext, sessionCmdRval, &sessionAuths,
+            client->nvIndex, client->nvIndex, &responseAuths );
+
+exit:
+    EndAuthSession( session );
+    return rval;
+}
+
+//
+// sign: a storage primary and an HMAC key created under it at setup; each
+// operation loads the key, signs a digest with it and flushes it.
+//
+static TSS2_RC SignSetup( CLIENT *client )
+{
+    TPM2B_SENSITIVE_CREATE inSensitive = { { sizeof( TPM2B_SENSITIVE_CREATE ) - 2, } };
+    TPM2B_PUBLIC inPublic;
+    TPM2B_DATA outsideInfo = { { 0, } };
+    TPML_PCR_SELECTION creationPCR = { 0, };
+    TPM2B_CREATION_DATA creationData = { { 0, } };
+    TPM2B_DIGEST creationHash = { { sizeof( TPM2B_DIGEST ) - 2, } };
+    TPMT_TK_CREATION creationTicket = { 0, 0, { { sizeof( TPM2B_DIGEST ) - 2, } } };
+    TSS2_RC rval;
+
+    memset( &inPublic, 0, sizeof( inPublic ) );
+    inPublic.t.publicArea.type = TPM_ALG_SYMCIPHER;
+    inPublic.t.publicArea.nameAlg = TPM_ALG_SHA256;
+    *(UINT32 *)&( inPublic.t.publicArea.objectAttributes ) = 0;
+    inPublic.t.publicArea.objectAttributes.restricted = 1;
+    inPublic.t.publicArea.objectAttributes.decrypt = 1;
+    inPublic.t.publicArea.objectAttributes.userWithAuth = 1;
+    inPublic.t.publicArea.objectAttributes.fixedTPM = 1;
+    inPublic.t.publicArea.objectAttributes.fixedParent = 1;
+    inPublic.t.publicArea.objectAttributes.sensitiveDataOrigin = 1;
+    inPublic.t.publicArea.authPolicy.t.size = 0;
+    inPublic.t.publicArea.parameters.symDetail.sym.algorithm = TPM_ALG_AES;
+    inPublic.t.publicArea.parameters.symDetail.sym.keyBits.aes = 128;
+    inPublic.t.publicArea.parameters.symDetail.sym.mode.aes = TPM_ALG_CFB;
+    inPublic.t.publicArea.unique.sym.t.size = 0;
+
+    rval = CreatePrimary( client, &inPublic, &client->parentHandle );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    inSensitive.t.sensitive.userAuth.t.size = 0;
+    inSensitive.t.sensitive.data.t.size = 0;
+    inSensitive.t.size = 4;
+    InitHmacKeyTemplate( &inPublic );
+    client->keyPublic.t.size = 0;
+    INIT_SIMPLE_TPM2B_SIZE( client->keyPrivate );
+
+    return Tss2_Sys_Create( client->sysContext, client->parentHandle, PasswordAuths( 0 ),
+            &inSensitive, &inPublic, &outsideInfo, &creationPCR, &client->keyPrivate,
+            &client->keyPublic, &creationData, &creationHash, &creationTicket, &responseAuths );
+}
+
+static TSS2_RC SignOp( CLIENT *client )
+{
+    TPM_HANDLE keyHandle;
+    TPM2B_NAME name = { { sizeof( TPM2B_NAME ) - 2, } };
+    TPM2B_DIGEST digest;
+    TPMT_SIG_SCHEME inScheme;
+    TPMT_TK_HASHCHECK validation;
+    TPMT_SIGNATURE signature;
+    TSS2_RC rval;
+
+    rval = Tss2_Sys_Load( client->sysContext, client->parentHandle, PasswordAuths( 0 ),
+            &client->keyPrivate, &client->keyPublic, &keyHandle, &name, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    digest.t.size = 32;
+    memset( digest.t.buffer, 0x5a, digest.t.size );
+    inScheme.scheme = TPM_ALG_NULL;
+    validation.tag = TPM_ST_HASHCHECK;
+    validation.hierarchy = TPM_RH_NULL;
+    validation.digest.t.size = 0;
+
+    rval = Tss2_Sys_Sign( client->sysContext, keyHandle, PasswordAuths( 0 ), &digest,
+            &inScheme, &validation, &signature, &responseAuths );
+
+    if( rval == TPM_RC_SUCCESS )
+        rval = Tss2_Sys_FlushContext( client->sysContext, keyHandle );
+    else
+        Tss2_Sys_FlushContext( client->sysContext, keyHandle );
+    return rval;
+}
+
+static void SignTeardown( CLIENT *client )
+{
+    Tss2_Sys_FlushContext( client->sysContext, client->parentHandle );
+}
+
+//
+// createprimary: CreatePrimary followed by FlushContext, back to back.
+//
+static TSS2_RC CreatePrimaryOp( CLIENT *client )
+{
+    TPM2B_PUBLIC inPublic;
+    TPM_HANDLE handle;
+    TSS2_RC rval;
+
+    InitHmacKeyTemplate( &inPublic );
+    rval = CreatePrimary( client, &inPublic, &handle );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+    return Tss2_Sys_FlushContext( client->sysContext, handle );
+}
+
+static const WORKLOAD workloads[] = {
+    { "getrandom",     1, 0,         GetRandomOp,     0 },
+    { "nvread",        1, NvSetup,   NvReadOp,        NvTeardown },
+    { "hmac",          2, NvSetup,   HmacOp,          NvTeardown },
+    { "sign",          3, SignSetup, SignOp,          SignTeardown },
+    { "createprimary", 2, 0,         CreatePrimaryOp, 0 },
+};
+
+#define WORKLOAD_COUNT ( sizeof( workloads ) / sizeof( workloads[0] ) )
+
+static int WriteAll( int fd, const void *buffer, size_t size )
+{
+    const UINT8 *next = (const UINT8 *)buffer;
+    ssize_t written;
+
+    while( size > 0 )
+    {
+        written = write( fd, next, size );
+        if( written <= 0 )
+            return -1;
+        next += written;
+        size -= written;
+    }
+    return 0;
+}
+
+static int ReadAll( int fd, void *buffer, size_t size )
+{
+    UINT8 *next = (UINT8 *)buffer;
+    ssize_t count;
+
+    while( size > 0 )
+    {
+        count = read( fd, next, size );
+        if( count <= 0 )
+            return -1;
+        next += count;
+        size -= count;
+    }
+    return 0;
+}
+
+//
+// Body of a client process.  Reports readiness (or a setup failure) with
+// a CLIENT_RESULT whose opCount is zero, waits for the start pipe to be
+// closed, runs the operations and reports the results.
+//
+static int RunClient( const WORKLOAD *workload, UINT32 index, const TCTI_SOCKET_CONF *socketConfig,
+        UINT32 opCount, int startFd, int resultFd )
+{
+    CLIENT client;
+    CLIENT_RESULT result = { TSS2_RC_SUCCESS, 0, 0 };
+    UINT64 *latencies = calloc( opCount, sizeof( UINT64 ) );
+    UINT64 started;
+    UINT8 start;
+
+    memset( &client, 0, sizeof( client ) );
+    client.index = index;
+
+    InitEntities();
+    result.rval = InitSocketTctiContext( socketConfig, &resMgrTctiContext );
+    if( result.rval == TSS2_RC_SUCCESS )
+    {
+        client.sysContext = InitSysContext( 0, resMgrTctiContext, &abiVersion );
+        if( client.sysContext == 0 )
+            result.rval = TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
+    }
+    if( result.rval == TSS2_RC_SUCCESS && workload->setup != 0 )
+        result.rval = workload->setup( &client );
+
+    WriteAll( resultFd, &result, sizeof( result ) );
+    if( result.rval == TSS2_RC_SUCCESS )
+    {
+        read( startFd, &start, 1 );
+
+        for( ; result.opCount < opCount; result.opCount++ )
+        {
+            started = Now();
+            result.rval = workload->op( &client );
+            if( result.rval != TSS2_RC_SUCCESS )
+                break;
+            latencies[result.opCount] = Now() - started;
+        }
+        result.finished = Now();
+
+        WriteAll( resultFd, &result, sizeof( result ) );
+        WriteAll( resultFd, latencies, result.opCount * sizeof( UINT64 ) );
+    }
+
+    if( client.sysContext != 0 )
+    {
+        if( workload->teardown != 0 )
+            workload->teardown( &client );
+        TeardownSysContext( &client.sysContext );
+    }
+    if( resMgrTctiContext != 0 )
+        TeardownTctiContext( &resMgrTctiContext );
+    free( latencies );
+    return result.rval != TSS2_RC_SUCCESS;
+}
+
+static int CompareLatencies( const void *a, const void *b )
+{
+    UINT64 x = *(const UINT64 *)a, y = *(const UINT64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+//
+// Looks up us_per_command for a workload in the output of an earlier run.
+//
+static int GetBaseline( const char *baselineFile, const char *workload, double *usPerCommand )
+{
+    FILE *file = fopen( baselineFile, "r" );
+    char line[512], name[64];
+    const char *value;
+    int found = 0;
+
+    if( file == 0 )
+        return 0;
+    while( !found && fgets( line, sizeof( line ), file ) != 0 )
+    {
+        if( sscanf( line, "workload=%63s", name ) != 1 || strcmp( name, workload ) != 0 )
+            continue;
+        value = strstr( line, " us_per_command=" );
+        if( value != 0 )
+            found = sscanf( value, " us_per_command=%lf", usPerCommand ) == 1;
+    }
+    fclose( file );
+    return found;
+}
+
+static UINT32 RunWorkload( const WORKLOAD *workload, const TCTI_SOCKET_CONF *socketConfig,
+        UINT32 clientCount, UINT32 opCount, const char *baselineFile )
+{
+    int startPipe[2], resultPipes[MAX_CLIENTS][2];
+    pid_t pids[MAX_CLIENTS];
+    CLIENT_RESULT result;
+    UINT64 *latencies = malloc( (size_t)clientCount * opCount * sizeof( UINT64 ) + sizeof( UINT64 ) );
+    UINT64 started, finished = 0, sum = 0;
+    UINT32 total = 0, errors = 0, i;
+    double seconds, usPerCommand, baseline;
+
+    fflush( stdout );
+    pipe( startPipe );
+    for( i = 0; i < clientCount; i++ )
+    {
+        pipe( resultPipes[i] );
+        pids[i] = fork();
+        if( pids[i] == 0 )
+        {
+            close( startPipe[1] );
+            close( resultPipes[i][0] );
+            exit( RunClient( workload, i, socketConfig, opCount, startPipe[0],
+                    resultPipes[i][1] ) );
+        }
+        close( resultPipes[i][1] );
+    }
+    close( startPipe[0] );
+
+    //
+    // Wait for every client to finish its setup, then start them all.
+    //
+    for( i = 0; i < clientCount; i++ )
+    {
+        if( ReadAll( resultPipes[i][0], &result, sizeof( result ) ) != 0 ||
+            result.rval != TSS2_RC_SUCCESS )
+        {
+            printf( "# %s: client %u setup failed: 0x%x\n", workload->name, i,
+                    result.rval );
+            close( resultPipes[i][0] );
+            resultPipes[i][0] = -1;
+            errors++;
+        }
+    }
+    started = Now();
+    close( startPipe[1] );
+
+    for( i = 0; i < clientCount; i++ )
+    {
+        if( resultPipes[i][0] < 0 )
+            continue;
+        if( ReadAll( resultPipes[i][0], &result, sizeof( result ) ) != 0 ||
+            ReadAll( resultPipes[i][0], &latencies[total], result.opCount * sizeof( UINT64 ) ) != 0 )
+        {
+            printf( "# %s: client %u died\n", workload->name, i );
+            errors++;
+        }
+        else
+        {
+            if( result.rval != TSS2_RC_SUCCESS )
+            {
+                printf( "# %s: client %u failed after %u operations: 0x%x\n",
+                        workload->name, i, result.opCount, result.rval );
+                errors++;
+            }
+            total += result.opCount;
+            if( result.finished > finished )
+                finished = result.finished;
+        }
+        close( resultPipes[i][0] );
+    }
+    for( i = 0; i < clientCount; i++ )
+        waitpid( pids[i], 0, 0 );
+
+    for( i = 0; i < total; i++ )
+        sum += latencies[i];
+    qsort( latencies, total, sizeof( UINT64 ), CompareLatencies );
+    seconds = finished > started ? ( finished - started ) / 1e9 : 0;
+    usPerCommand = total != 0 ? sum / 1e3 / total / workload->commandsPerOp : 0;
+
+    printf( "workload=%s clients=%u ops=%u commands=%u errors=%u seconds=%.3f ops_per_sec=%.1f",
+            workload->name, clientCount, total, total * workload->commandsPerOp, errors,
+            seconds, seconds > 0 ? total / seconds : 0 );
+    if( total != 0 )
+    {
+        printf( " p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f",
+                latencies[total / 2] / 1e3,
+                latencies[(UINT64)total * 90 / 100] / 1e3,
+                latencies[(UINT64)total * 99 / 100] / 1e3,
+                latencies[(UINT64)total * 999 / 1000] / 1e3,
+                latencies[total - 1] / 1e3 );
+    }
+    printf( " us_per_command=%.1f", usPerCommand );
+    if( baselineFile != 0 && GetBaseline( baselineFile, workload->name, &baseline ) )
+        printf( " rm_overhead_us_per_command=%.1f", usPerCommand - baseline );
+    printf( "\n" );
+    fflush( stdout );
+
+    free( latencies );
+    return errors;
+}
+
+static void PrintHelp( const char *name )
+{
+    UINT32 i;
+
+    printf( "Usage: %s [-host host] [-port port] [-clients n] [-ops n] [-workload name]... [-baseline file]\n"
+            "\n"
+            "-host     resource manager host (default %s)\n"
+            "-port     resource manager TPM port (default %d)\n"
+            "-clients  number of concurrent clients, at most %d (default 4)\n"
+            "-ops      operations per client and workload (default 100)\n"
+            "-workload run only the named workloads:",
+            name, DEFAULT_HOSTNAME, DEFAULT_RESMGR_TPM_PORT, MAX_CLIENTS );
+    for( i = 0; i < WORKLOAD_COUNT; i++ )
+        printf( " %s", workloads[i].name );
+    printf( "\n"
+            "-baseline output of an earlier run without the resource manager, to report\n"
+            "          rm_overhead_us_per_command\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+    TCTI_SOCKET_CONF socketConfig = { DEFAULT_HOSTNAME, DEFAULT_RESMGR_TPM_PORT, NULL, NULL, NULL };
+    const WORKLOAD *selected[MAX_WORKLOADS];
+    const char *baselineFile = 0;
+    UINT32 selectedCount = 0, clientCount = 4, opCount = 100, errors = 0, i;
+    int count;
+
+    for( count = 1; count < argc; count++ )
+    {
+        if( 0 == strcmp( argv[count], "-host" ) && count + 1 < argc )
+        {
+            socketConfig.hostname = argv[++count];
+        }
+        else if( 0 == strcmp( argv[count], "-port" ) && count + 1 < argc )
+        {
+            socketConfig.port = strtoul( argv[++count], NULL, 10 );
+        }
+        else if( 0 == strcmp( argv[count], "-clients" ) && count + 1 < argc )
+        {
+            clientCount = strtoul( argv[++count], NULL, 10 );
+        }
+        else if( 0 == strcmp( argv[count], "-ops" ) && count + 1 < argc )
+        {
+            opCount = strtoul( argv[++count], NULL, 10 );
+        }
+        else if( 0 == strcmp( argv[count], "-baseline" ) && count + 1 < argc )
+        {
+            baselineFile = argv[++count];
+        }
+        else if( 0 == strcmp( argv[count], "-workload" ) && count + 1 < argc &&
+                 selectedCount < MAX_WORKLOADS )
+        {
+            count++;
+            for( i = 0; i < WORKLOAD_COUNT; i++ )
+            {
+                if( 0 == strcmp( argv[count], workloads[i].name ) )
+                    break;
+            }
+            if( i == WORKLOAD_COUNT )
+            {
+                PrintHelp( argv[0] );
+                return 1;
+            }
+            selected[selectedCount++] = &workloads[i];
+        }
+        else
+        {
+            PrintHelp( argv[0] );
+            return 1;
+        }
+    }
+    if( clientCount == 0 || clientCount > MAX_CLIENTS || opCount == 0 )
+    {
+        PrintHelp( argv[0] );
+        return 1;
+    }
+    if( selectedCount == 0 )
+    {
+        for( i = 0; i < WORKLOAD_COUNT; i++ )
+            selected[selectedCount++] = &workloads[i];
+    }
+
+    for( i = 0; i < selectedCount; i++ )
+        errors += RunWorkload( selected[i], &socketConfig, clientCount, opCount, baselineFile );
+
+    return errors != 0;
+}
@@ -0,0 +1,194 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Reads trace records written by the resource manager's -trace option (a
+// plain array of TCTI_TRACE_RECORDs, see tcti/tcti_trace.h) and prints,
+// for each command code, latency percentiles and a histogram of the time
+// from sending the command to having the whole response.
+//
+// Usage: tracestat file...
+//
+// "tpm" is the time from sending the command to the first byte of the
+// response, i.e. mostly the TPM's own time; "total" adds reading the
+// response.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sapi/tpm20.h>
+#include <tcti/tcti_trace.h>
+#include "debug.h"
+
+#define HISTOGRAM_BUCKETS 32
+
+typedef struct {
+    TPM_CC commandCode;
+    UINT32 count;
+    UINT32 errors;
+    UINT64 *total;
+    UINT64 *tpm;
+} COMMAND_STATS;
+
+static int CompareLatencies( const void *a, const void *b )
+{
+    UINT64 x = *(const UINT64 *)a, y = *(const UINT64 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int CompareCounts( const void *a, const void *b )
+{
+    const COMMAND_STATS *x = (const COMMAND_STATS *)a, *y = (const COMMAND_STATS *)b;
+
+    return x->count > y->count ? -1 : x->count < y->count;
+}
+
+static COMMAND_STATS *FindStats( COMMAND_STATS **stats, UINT32 *statsCount, TPM_CC commandCode )
+{
+    UINT32 i;
+
+    for( i = 0; i < *statsCount; i++ )
+    {
+        if( (*stats)[i].commandCode == commandCode )
+            return &(*stats)[i];
+    }
+
+    *stats = realloc( *stats, ( *statsCount + 1 ) * sizeof( COMMAND_STATS ) );
+    memset( &(*stats)[i], 0, sizeof( COMMAND_STATS ) );
+    (*stats)[i].commandCode = commandCode;
+    (*statsCount)++;
+    return &(*stats)[i];
+}
+
+static void AddRecord( COMMAND_STATS *stats, const TCTI_TRACE_RECORD *record )
+{
+    if( ( stats->count & ( stats->count - 1 ) ) == 0 )
+    {
+        stats->total = realloc( stats->total, ( stats->count ? stats->count * 2 : 1 ) * sizeof( UINT64 ) );
+        stats->tpm = realloc( stats->tpm, ( stats->count ? stats->count * 2 : 1 ) * sizeof( UINT64 ) );
+    }
+    stats->total[stats->count] = record->completeTime - record->sendTime;
+    stats->tpm[stats->count] = record->firstByteTime - record->sendTime;
+    stats->count++;
+    if( record->responseCode != TPM_RC_SUCCESS )
+        stats->errors++;
+}
+
+static void PrintStats( COMMAND_STATS *stats )
+{
+    UINT32 histogram[HISTOGRAM_BUCKETS] = { 0 };
+    UINT32 i, bucket, largest = 0, first = HISTOGRAM_BUCKETS, last = 0;
+    UINT64 us;
+
+    qsort( stats->total, stats->count, sizeof( UINT64 ), CompareLatencies );
+    qsort( stats->tpm, stats->count, sizeof( UINT64 ), CompareLatencies );
+
+    printf( "%s (0x%x): %u commands, %u errors\n", strTpmCommandCode( stats->commandCode ),
+            stats->commandCode, stats->count, stats->errors );
+    printf( "  total us: p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+            stats->total[stats->count / 2] / 1e3,
+            stats->total[(UINT64)stats->count * 90 / 100] / 1e3,
+            stats->total[(UINT64)stats->count * 99 / 100] / 1e3,
+            stats->total[stats->count - 1] / 1e3 );
+    printf( "  tpm us:   p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+            stats->tpm[stats->count / 2] / 1e3,
+            stats->tpm[(UINT64)stats->count * 90 / 100] / 1e3,
+            stats->tpm[(UINT64)stats->count * 99 / 100] / 1e3,
+            stats->tpm[stats->count - 1] / 1e3 );
+
+    // Power-of-two buckets of total latency in us; bucket 0 is under 1 us.
+    for( i = 0; i < stats->count; i++ )
+    {
+        us = stats->total[i] / 1000;
+        for( bucket = 0; us != 0 && bucket < HISTOGRAM_BUCKETS - 1; bucket++ )
+            us >>= 1;
+        histogram[bucket]++;
+        if( histogram[bucket] > largest )
+            largest = histogram[bucket];
+        if( bucket < first )
+            first = bucket;
+        if( bucket > last )
+            last = bucket;
+    }
+    for( bucket = first; bucket <= last; bucket++ )
+    {
+        printf( "  %9lu - %9lu us %8u ", bucket ? 1UL << ( bucket - 1 ) : 0UL, 1UL << bucket,
+                histogram[bucket] );
+        for( i = 0; i < ( histogram[bucket] * 40 + largest - 1 ) / largest; i++ )
+            printf( "#" );
+        printf( "\n" );
+    }
+    printf( "\n" );
+}
+
+int main( int argc, char *argv[] )
+{
+    TCTI_TRACE_RECORD record;
+    COMMAND_STATS *stats = 0;
+    UINT32 statsCount = 0, records = 0, i;
+    FILE *file;
+    int count;
+
+    if( argc < 2 )
+    {
+        printf( "Usage: %s file...\n", argv[0] );
+        return 1;
+    }
+
+    for( count = 1; count < argc; count++ )
+    {
+        file = fopen( argv[count], "rb" );
+        if( file == 0 )
+        {
+            printf( "Can't open %s\n", argv[count] );
+            return 1;
+        }
+        while( fread( &record, sizeof( record ), 1, file ) == 1 )
+        {
+            if( record.completeTime < record.firstByteTime || record.firstByteTime < record.sendTime )
+                continue;
+            AddRecord( FindStats( &stats, &statsCount, record.commandCode ), &record );
+            records++;
+        }
+        fclose( file );
+    }
+
+    printf( "%u records, %u command codes\n\n", records, statsCount );
+    qsort( stats, statsCount, sizeof( COMMAND_STATS ), CompareCounts );
+    for( i = 0; i < statsCount; i++ )
+    {
+        PrintStats( &stats[i] );
+        free( stats[i].total );
+        free( stats[i].tpm );
+    }
+    free( stats );
+
+    return 0;
+}
@@ -0,0 +1,588 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Unseal commands per second through an HMAC session, with the session's
+// hashes and HMACs done by the TPM (TpmHash/TpmHmac) and by the host
+// (HostHash/HostHmac).
+//
+// Usage: unsealbench [iterations [latency-ns]]
+//
+// The TPM is played in process, behind the loopback TCTI: it answers
+// StartAuthSession and Unseal, checking the command HMAC and computing
+// the response HMAC, and the Hash, LoadExternal, HMAC_Start,
+// SequenceUpdate, SequenceComplete and FlushContext commands TpmHash and
+// TpmHmac send.  latency-ns is added to every command, so a real TPM's
+// command time can be put back in; "commands" is how many commands each
+// Unseal cost in all.  The played TPM hashes with the host code, so its
+// own work is in every row, and is portable code in the "portable" row.
+//
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sapi/tpm20.h>
+#include <tcti/tcti_loopback.h>
+#include "sample.h"
+
+#define DEFAULT_ITERATIONS 10000
+
+#define BENCH_SESSION_HANDLE    ( HMAC_SESSION_FIRST )
+#define BENCH_OBJECT_HANDLE     ( TRANSIENT_FIRST + 1 )
+#define BENCH_KEY_HANDLE        ( TRANSIENT_FIRST + 2 )
+#define BENCH_SEQUENCE_HANDLE   ( TRANSIENT_FIRST + 3 )
+
+#define BENCH_SEQUENCE_MAX 4096
+
+//
+// Globals the sample code expects.
+//
+TSS2_TCTI_CONTEXT *resMgrTctiContext = 0;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+UINT32 ( *ComputeSessionHmacPtr )(
+    TSS2_SYS_CONTEXT *sysContext,
+    TPMS_AUTH_COMMAND *cmdAuth,
+    TPM_HANDLE entityHandle,
+    TPM_RC responseCode,
+    TPM_HANDLE handle1,
+    TPM_HANDLE handle2,
+    TPMA_SESSION sessionAttributes,
+    TPM2B_DIGEST *result,
+    TPM_RC sessionCmdRval ) = TpmComputeSessionHmac;
+
+TPM_RC ( *CalcPHash )( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDLE handle2,
+    TPMI_ALG_HASH authHash, TPM_RC responseCode, TPM2B_DIGEST *pHash ) = TpmCalcPHash;
+
+UINT32 (*HmacFunctionPtr)( TPMI_ALG_HASH hashAlg, TPM2B *key,TPM2B **bufferList, TPM2B_DIGEST *result ) = TpmHmac;
+
+UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = TpmHash;
+
+static UINT32 BenchHandleToName( TPM_HANDLE handle, TPM2B_NAME *name );
+
+UINT32 (*HandleToNameFunctionPtr)( TPM_HANDLE handle, TPM2B_NAME *name ) = BenchHandleToName;
+
+TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue ) = EncryptCFB;
+
+TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue ) = DecryptCFB;
+
+//
+// The sealed object.  A real client has its name from Load; here it is
+// just a nameAlg and a digest's worth of bytes.
+//
+static const TPM2B_AUTH objectAuth = { { 8, { 0x5e, 0xa1, 0xed, 0x00, 0x0b, 0x1e, 0xc7, 0x01 } } };
+static TPM2B_NAME objectName;
+static TPM2B_SENSITIVE_DATA objectSecret;
+
+//
+// What the TPM played behind the loopback TCTI remembers.
+//
+typedef struct {
+    TPM2B_NONCE nonceTpm;           // The HMAC session's current TPM nonce.
+    UINT16 nonceSize;               // nonceCaller's size at StartAuthSession.
+    UINT32 nonceCount;
+    TPM2B_DIGEST hmacKey;           // Loaded by LoadExternal.
+    TPMI_ALG_HASH sequenceAlg;
+    TPM2B_DIGEST sequenceKey;
+    UINT32 sequenceSize;
+    UINT8 sequence[BENCH_SEQUENCE_MAX];
+} BENCH_TPM;
+
+static UINT16 Get16( const UINT8 *buffer )
+{
+    return (UINT16)( ( buffer[0] << 8 ) | buffer[1] );
+}
+
+static UINT32 Get32( const UINT8 *buffer )
+{
+    return ( (UINT32)Get16( buffer ) << 16 ) | Get16( buffer + 2 );
+}
+
+static UINT8 *Put16( UINT8 *buffer, UINT16 value )
+{
+    buffer[0] = (UINT8)( value >> 8 );
+    buffer[1] = (UINT8)value;
+    return buffer + 2;
+}
+
+static UINT8 *Put32( UINT8 *buffer, UINT32 value )
+{
+    return Put16( Put16( buffer, (UINT16)( value >> 16 ) ), (UINT16)value );
+}
+
+static UINT8 *PutSized( UINT8 *buffer, const TPM2B *data )
+{
+    buffer = Put16( buffer, data->size );
+    memcpy( buffer, data->buffer, data->size );
+    return buffer + data->size;
+}
+
+// Copies the TPM2B at *next into data, if it fits, and steps past it.
+static int GetSized( const UINT8 **next, const UINT8 *end, TPM2B *data, UINT16 maxSize )
+{
+    UINT16 size;
+
+    if( end - *next < 2 )
+        return 0;
+    size = Get16( *next );
+    if( size > maxSize || end - *next - 2 < size )
+        return 0;
+    data->size = size;
+    memcpy( data->buffer, *next + 2, size );
+    *next += 2 + size;
+    return 1;
+}
+
+static void NextNonce( BENCH_TPM *tpm )
+{
+    tpm->nonceCount++;
+    tpm->nonceTpm.t.size = tpm->nonceSize;
+    memset( tpm->nonceTpm.t.buffer, 0x4e, tpm->nonceTpm.t.size );
+    Put32( tpm->nonceTpm.t.buffer, tpm->nonceCount );
+}
+
+// Appends a password session's response: no nonce, the attributes, no HMAC.
+static UINT8 *PutPasswordResponse( UINT8 *next, UINT8 sessionAttributes )
+{
+    next = Put16( next, 0 );
+    *next++ = sessionAttributes;
+    return Put16( next, 0 );
+}
+
+// Appends a HMAC-sequence result: the digest and a NULL hierarchy ticket.
+static UINT8 *PutDigestAndTicket( UINT8 *next, const TPM2B_DIGEST *digest )
+{
+    next = PutSized( next, &digest->b );
+    next = Put16( next, TPM_ST_HASHCHECK );
+    next = Put32( next, TPM_RH_NULL );
+    return Put16( next, 0 );
+}
+
+//
+// Checks an Unseal's command HMAC and builds its response, with the
+// response HMAC.  The session is unbound and unsalted, so the HMAC key
+// is the object's authValue.
+//
+static TPM_RC BenchUnseal( BENCH_TPM *tpm, const UINT8 *command, const UINT8 *end, UINT8 **next )
+{
+    UINT8 hashInput[sizeof( TPM_CC ) + sizeof( TPMU_NAME ) + sizeof( TPM2B_SENSITIVE_DATA ) + 8];
+    TPM2B_NONCE nonceCaller;
+    TPM2B_DIGEST hmac, pHash, expected;
+    TPM2B attributes = { 1, { 0 } };
+    TPM2B *bufferList[5];
+    const UINT8 *auth = command + 18;
+    UINT8 *parameters, *parametersEnd;
+
+    if( Get16( command ) != TPM_ST_SESSIONS || end - auth < 4 + 2 ||
+            Get32( command + 10 ) != BENCH_OBJECT_HANDLE || Get32( auth ) != BENCH_SESSION_HANDLE )
+    {
+        return TPM_RC_VALUE;
+    }
+
+    auth += 4;
+    if( !GetSized( &auth, end, &nonceCaller.b, sizeof( nonceCaller.t.buffer ) ) || auth == end )
+        return TPM_RC_SIZE;
+    attributes.buffer[0] = *auth++;
+    if( !GetSized( &auth, end, &hmac.b, sizeof( hmac.t.buffer ) ) )
+        return TPM_RC_SIZE;
+
+    // cpHash = H( commandCode || name ), Unseal having no parameters.
+    memcpy( hashInput, command + 6, 4 );
+    memcpy( hashInput + 4, objectName.t.name, objectName.t.size );
+    HostHash( TPM_ALG_SHA256, 4 + objectName.t.size, hashInput, &pHash );
+
+    bufferList[0] = &pHash.b;
+    bufferList[1] = &nonceCaller.b;
+    bufferList[2] = &tpm->nonceTpm.b;
+    bufferList[3] = &attributes;
+    bufferList[4] = 0;
+    HostHmac( TPM_ALG_SHA256, (TPM2B *)&objectAuth.b, bufferList, &expected );
+    if( expected.t.size != hmac.t.size || memcmp( expected.t.buffer, hmac.t.buffer, hmac.t.size ) != 0 )
+        return TPM_RC_S + TPM_RC_1 + TPM_RC_AUTH_FAIL;
+
+    NextNonce( tpm );
+
+    parameters = *next + 4;
+    parametersEnd = PutSized( parameters, &objectSecret.b );
+    Put32( *next, (UINT32)( parametersEnd - parameters ) );
+
+    // rpHash = H( responseCode || commandCode || parameters ).
+    Put32( hashInput, TPM_RC_SUCCESS );
+    memcpy( hashInput + 4, command + 6, 4 );
+    memcpy( hashInput + 8, parameters, parametersEnd - parameters );
+    HostHash( TPM_ALG_SHA256, (UINT16)( 8 + ( parametersEnd - parameters ) ), hashInput, &pHash );
+
+    bufferList[1] = &tpm->nonceTpm.b;
+    bufferList[2] = &nonceCaller.b;
+    HostHmac( TPM_ALG_SHA256, (TPM2B *)&objectAuth.b, bufferList, &hmac );
+
+    *next = PutSized( parametersEnd, &tpm->nonceTpm.b );
+    *( *next )++ = attributes.buffer[0];
+    *next = PutSized( *next, &hmac.b );
+
+    return TPM_RC_SUCCESS;
+}
+
+static TSS2_RC BenchResponder( void *data, const uint8_t *command, size_t commandSize,
+        uint8_t *response, size_t *responseSize )
+{
+    BENCH_TPM *tpm = (BENCH_TPM *)data;
+    const UINT8 *end = command + commandSize;
+    const UINT8 *parameters;
+    UINT8 *next = response + sizeof( TPM20_ErrorResponse );
+    TPM_ST tag = TPM_ST_NO_SESSIONS;
+    TPM_RC responseCode = TPM_RC_SUCCESS;
+    TPM2B_MAX_BUFFER buffer;
+    TPM2B_SENSITIVE_DATA bits;
+    TPM2B_DIGEST digest;
+    TPM2B *bufferList[2] = { &buffer.b, 0 };
+    UINT32 handles = 0;
+
+    switch( Get32( command + 6 ) )
+    {
+        case TPM_CC_StartAuthSession:
+            handles = 2;
+            break;
+
+        case TPM_CC_Unseal:
+        case TPM_CC_HMAC_Start:
+        case TPM_CC_SequenceUpdate:
+        case TPM_CC_SequenceComplete:
+            handles = 1;
+            break;
+    }
+
+    // Skip the handles and any (password) sessions to the parameters.
+    parameters = command + 10 + 4 * handles;
+    if( Get16( command ) == TPM_ST_SESSIONS )
+    {
+        tag = TPM_ST_SESSIONS;
+        parameters += 4 + Get32( parameters );
+    }
+    if( parameters > end )
+    {
+        responseCode = TPM_RC_COMMAND_SIZE;
+        goto done;
+    }
+
+    switch( Get32( command + 6 ) )
+    {
+        case TPM_CC_StartAuthSession:
+            if( !GetSized( &parameters, end, &buffer.b, sizeof( tpm->nonceTpm.t.buffer ) ) ||
+                    buffer.t.size < sizeof( UINT32 ) )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            tpm->nonceSize = buffer.t.size;
+            NextNonce( tpm );
+            next = Put32( next, BENCH_SESSION_HANDLE );
+            next = PutSized( next, &tpm->nonceTpm.b );
+            break;
+
+        case TPM_CC_Unseal:
+            responseCode = BenchUnseal( tpm, command, end, &next );
+            break;
+
+        case TPM_CC_Hash:
+            if( !GetSized( &parameters, end, &buffer.b, sizeof( buffer.t.buffer ) ) || end - parameters < 2 )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            HostHash( Get16( parameters ), buffer.t.size, buffer.t.buffer, &digest );
+            next = PutDigestAndTicket( next, &digest );
+            break;
+
+        case TPM_CC_LoadExternal:
+            // TPM2B_SENSITIVE: size, sensitiveType, authValue, seedValue, then the key.
+            parameters += 2 + 2;
+            if( !GetSized( &parameters, end, &bits.b, sizeof( bits.t.buffer ) ) ||
+                    !GetSized( &parameters, end, &bits.b, sizeof( bits.t.buffer ) ) ||
+                    !GetSized( &parameters, end, &bits.b, sizeof( tpm->hmacKey.t.buffer ) ) )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            tpm->hmacKey.t.size = bits.t.size;
+            memcpy( tpm->hmacKey.t.buffer, bits.t.buffer, bits.t.size );
+            next = Put32( next, BENCH_KEY_HANDLE );
+            next = PutSized( next, &objectName.b );
+            break;
+
+        case TPM_CC_HMAC_Start:
+            if( !GetSized( &parameters, end, &bits.b, sizeof( bits.t.buffer ) ) || end - parameters < 2 )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            tpm->sequenceAlg = Get16( parameters );
+            tpm->sequenceKey = tpm->hmacKey;
+            tpm->sequenceSize = 0;
+            next = Put32( next, BENCH_SEQUENCE_HANDLE );
+            next = Put32( next, 0 );
+            next = PutPasswordResponse( next, 0 );
+            break;
+
+        case TPM_CC_SequenceUpdate:
+        case TPM_CC_SequenceComplete:
+            if( !GetSized( &parameters, end, &buffer.b, sizeof( buffer.t.buffer ) ) ||
+                    tpm->sequenceSize + buffer.t.size > BENCH_SEQUENCE_MAX )
+            {
+                responseCode = TPM_RC_SIZE;
+                break;
+            }
+            memcpy( tpm->sequence + tpm->sequenceSize, buffer.t.buffer, buffer.t.size );
+            tpm->sequenceSize += buffer.t.size;
+
+            if( Get32( command + 6 ) == TPM_CC_SequenceUpdate )
+            {
+                next = Put32( next, 0 );
+            }
+            else
+            {
+                buffer.t.size = (UINT16)tpm->sequenceSize;
+                memcpy( buffer.t.buffer, tpm->sequence, tpm->sequenceSize );
+                HostHmac( tpm->sequenceAlg, &tpm->sequenceKey.b, bufferList, &digest );
+                next = Put32( next, sizeof( UINT16 ) + digest.t.size + 8 );
+                next = PutDigestAndTicket( next, &digest );
+            }
+            next = PutPasswordResponse( next, 0 );
+            break;
+
+        case TPM_CC_FlushContext:
+            break;
+
+        default:
+            responseCode = TPM_RC_COMMAND_CODE;
+            break;
+    }
+
+done:
+    if( responseCode != TPM_RC_SUCCESS )
+    {
+        tag = TPM_ST_NO_SESSIONS;
+        next = response + sizeof( TPM20_ErrorResponse );
+    }
+
+    *responseSize = next - response;
+    Put16( response, tag );
+    Put32( response + 2, (UINT32)*responseSize );
+    Put32( response + 6, responseCode );
+
+    return TSS2_RC_SUCCESS;
+}
+
+static UINT32 BenchHandleToName( TPM_HANDLE handle, TPM2B_NAME *name )
+{
+    if( handle == BENCH_OBJECT_HANDLE )
+    {
+        *name = objectName;
+    }
+    else
+    {
+        name->t.size = sizeof( TPM_HANDLE );
+        Put32( name->t.name, handle );
+    }
+    return TPM_RC_SUCCESS;
+}
+
+// The sample session code's debug output would otherwise be timed too.
+static int QuietPrintf( printf_type type, const char *format, va_list args )
+{
+    return 0;
+}
+
+static UINT64 Now()
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (UINT64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void Fail( const char *what, TSS2_RC rval )
+{
+    printf( "%s failed: 0x%x\n", what, rval );
+    exit( 1 );
+}
+
+//
+// One Unseal through the session: command HMAC, the command itself and a
+// check of the response HMAC, the session continuing.
+//
+static TSS2_RC Unseal( TSS2_SYS_CONTEXT *sysContext, SESSION *session )
+{
+    TPMS_AUTH_COMMAND sessionAuth;
+    TPMS_AUTH_COMMAND *sessionAuthArray[1] = { &sessionAuth };
+    TSS2_SYS_CMD_AUTHS sessionAuths = { 1, &sessionAuthArray[0] };
+    TPMS_AUTH_RESPONSE responseAuth;
+    TPMS_AUTH_RESPONSE *responseAuthArray[1] = { &responseAuth };
+    TSS2_SYS_RSP_AUTHS responseAuths = { 1, &responseAuthArray[0] };
+    TPM2B_SENSITIVE_DATA outData;
+    TSS2_RC rval;
+
+    rval = Tss2_Sys_Unseal_Prepare( sysContext, BENCH_OBJECT_HANDLE );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    sessionAuth.sessionHandle = session->sessionHandle;
+    sessionAuth.nonce.t.size = 16;
+    memset( sessionAuth.nonce.t.buffer, 0xa5, sessionAuth.nonce.t.size );
+    *( (UINT8 *)&sessionAuth.sessionAttributes ) = 0;
+    sessionAuth.sessionAttributes.continueSession = 1;
+    RollNonces( session, &sessionAuth.nonce );
+
+    rval = ComputeCommandHmacs( sysContext, BENCH_OBJECT_HANDLE, TPM_HT_NO_HANDLE,
+            &sessionAuths, TPM_RC_FAILURE );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    INIT_SIMPLE_TPM2B_SIZE( outData );
+    rval = Tss2_Sys_Unseal( sysContext, BENCH_OBJECT_HANDLE, &sessionAuths, &outData, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    RollNonces( session, &responseAuths.rspAuths[0]->nonce );
+    rval = CheckResponseHMACs( sysContext, rval, &sessionAuths, BENCH_OBJECT_HANDLE,
+            TPM_HT_NO_HANDLE, &responseAuths );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    if( outData.t.size != objectSecret.t.size ||
+            memcmp( outData.t.buffer, objectSecret.t.buffer, outData.t.size ) != 0 )
+    {
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+    }
+
+    return TPM_RC_SUCCESS;
+}
+
+static void TimeUnseal( TSS2_SYS_CONTEXT *sysContext, SESSION *session, const char *name, UINT32 iterations )
+{
+    UINT32 commands = LoopbackTctiGetCommandCount( resMgrTctiContext );
+    UINT64 start, elapsed;
+    TSS2_RC rval;
+    UINT32 i;
+
+    start = Now();
+    for( i = 0; i < iterations; i++ )
+    {
+        rval = Unseal( sysContext, session );
+        if( rval != TPM_RC_SUCCESS )
+            Fail( name, rval );
+    }
+    elapsed = Now() - start;
+    commands = LoopbackTctiGetCommandCount( resMgrTctiContext ) - commands;
+
+    printf( "%-24s %10.0f %10.1f %10.1f\n", name, (double)iterations * 1000000000 / elapsed,
+            (double)elapsed / iterations / 1000, (double)commands / iterations );
+}
+
+int main( int argc, char *argv[] )
+{
+    UINT32 iterations = DEFAULT_ITERATIONS;
+    BENCH_TPM tpm;
+    TCTI_LOOPBACK_CONF config = { BenchResponder, &tpm, 0, NULL, NULL };
+    TSS2_SYS_CONTEXT *sysContext;
+    SESSION *session;
+    TPM2B_NONCE nonceCaller;
+    TPM2B_ENCRYPTED_SECRET encryptedSalt;
+    TPMT_SYM_DEF symmetric;
+    size_t size;
+    TSS2_RC rval;
+
+    if( argc > 1 )
+        iterations = strtoul( argv[1], NULL, 10 );
+    if( argc > 2 )
+        config.latency = strtoul( argv[2], NULL, 10 );
+    if( iterations == 0 || argc > 3 )
+    {
+        printf( "Usage: %s [iterations [latency-ns]]\n", argv[0] );
+        return 1;
+    }
+
+    SetDebugHooks( QuietPrintf, 0 );
+
+    memset( &tpm, 0, sizeof( tpm ) );
+    objectName.t.size = sizeof( TPM_ALG_ID ) + SHA256_DIGEST_SIZE;
+    Put16( objectName.t.name, TPM_ALG_SHA256 );
+    memset( objectName.t.name + 2, 0x0b, SHA256_DIGEST_SIZE );
+    objectSecret.t.size = 32;
+    memset( objectSecret.t.buffer, 0x5c, objectSecret.t.size );
+
+    rval = InitLoopbackTcti( NULL, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+    resMgrTctiContext = malloc( size );
+    rval = InitLoopbackTcti( resMgrTctiContext, &size, &config );
+    if( rval != TSS2_RC_SUCCESS )
+        Fail( "InitLoopbackTcti", rval );
+
+    sysContext = InitSysContext( 0, resMgrTctiContext, &abiVersion );
+    if( sysContext == 0 )
+        Fail( "InitSysContext", TSS2_SYS_RC_INSUFFICIENT_CONTEXT );
+
+    InitEntities();
+    rval = AddEntity( BENCH_OBJECT_HANDLE, (TPM2B_AUTH *)&objectAuth );
+    if( rval != TPM_RC_SUCCESS )
+        Fail( "AddEntity", rval );
+
+    nonceCaller.t.size = 0;
+    encryptedSalt.t.size = 0;
+    symmetric.algorithm = TPM_ALG_NULL;
+    rval = StartAuthSessionWithParams( &session, TPM_RH_NULL, 0, TPM_RH_NULL, 0,
+            &nonceCaller, &encryptedSalt, TPM_SE_HMAC, &symmetric, TPM_ALG_SHA256,
+            resMgrTctiContext );
+    if( rval != TPM_RC_SUCCESS )
+        Fail( "StartAuthSessionWithParams", rval );
+
+    printf( "%u iterations, %u ns latency:\n", iterations, config.latency );
+    printf( "%-24s %10s %10s %10s\n", "", "unseal/s", "us/unseal", "commands" );
+
+    HmacFunctionPtr = TpmHmac;
+    HashFunctionPtr = TpmHash;
+    TimeUnseal( sysContext, session, "TPM hash/HMAC", iterations );
+
+    HmacFunctionPtr = HostHmac;
+    HashFunctionPtr = HostHash;
+    HostCryptoUseAcceleration( 0 );
+    TimeUnseal( sysContext, session, "host, portable", iterations );
+
+    HostCryptoUseAcceleration( 1 );
+    TimeUnseal( sysContext, session, "host, accelerated", iterations );
+
+    EndAuthSession( session );
+    TeardownSysContext( &sysContext );
+    tss2_tcti_finalize( resMgrTctiContext );
+    free( resMgrTctiContext );
+
+    return 0;
+}
@@ -29,6 +29,9 @@
 #include "sample.h"
 #include <string.h>
 
+// Big enough for an EncryptDecrypt of a whole TPM2B_MAX_BUFFER.
+#define CFB_CONTEXT_SIZE 2048
+
 TSS2_RC GetBlockSizeInBits( TPMI_ALG_SYM algorithm, UINT32 *blockSizeInBits )
 {
     TSS2_RC rval = TSS2_RC_SUCCESS;
@@ -124,7 +127,7 @@ UINT32 LoadSessionEncryptDecryptKey( TPMT_SYM_DEF *symmetric, TPM2B_MAX_BUFFER *
     inPublic.t.publicArea.parameters.symDetail.sym.mode = symmetric->mode;
     inPublic.t.publicArea.unique.sym.t.size = 0;
 
-    sysContext = InitSysContext( 1000, resMgrTctiContext, &abiVersion );
+    sysContext = AcquireSysContext( 1000, resMgrTctiContext, &abiVersion );
     if( sysContext == 0 )
     {
         return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
@@ -133,7 +136,7 @@ UINT32 LoadSessionEncryptDecryptKey( TPMT_SYM_DEF *symmetric, TPM2B_MAX_BUFFER *
     INIT_SIMPLE_TPM2B_SIZE( *keyName );
     rval = Tss2_Sys_LoadExternal( sysContext, 0, &inPrivate, &inPublic, TPM_RH_NULL, keyHandle, keyName, 0 );
 
-    TeardownSysContext( &sysContext );
+    ReleaseSysContext( &sysContext );
 
     return rval;
 }
@@ -157,10 +160,10 @@ TSS2_RC EncryptCFB( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX
     // Authorization array for command (only has one auth structure).
     TSS2_SYS_CMD_AUTHS sessionsData = { 1, &sessionDataArray[0] };
 
-    sysContext = InitSysContext( 1000, resMgrTctiContext, &abiVersion );
+    sysContext = AcquireSysContext( CFB_CONTEXT_SIZE, resMgrTctiContext, &abiVersion );
     if( sysContext == 0 )
     {
-        TeardownSysContext( &sysContext );
+        ReleaseSysContext( &sysContext );
         return TSS2_APP_RC_TEARDOWN_SYS_CONTEXT_FAILED;
     }
 
@@ -186,7 +189,7 @@ TSS2_RC EncryptCFB( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX
             }
         }
     }
-    TeardownSysContext( &sysContext );
+    ReleaseSysContext( &sysContext );
 
     return rval;
 }
@@ -211,10 +214,10 @@ TSS2_RC DecryptCFB( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUF
     TSS2_SYS_CMD_AUTHS sessionsData = { 1, &sessionDataArray[0] };
 
 
-    sysContext = InitSysContext( 1000, resMgrTctiContext, &abiVersion );
+    sysContext = AcquireSysContext( CFB_CONTEXT_SIZE, resMgrTctiContext, &abiVersion );
     if( sysContext == 0 )
     {
-        TeardownSysContext( &sysContext );
+        ReleaseSysContext( &sysContext );
         return TSS2_APP_RC_TEARDOWN_SYS_CONTEXT_FAILED;
     }
 
@@ -240,11 +243,48 @@ TSS2_RC DecryptCFB( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUF
             }
         }
     }
-    TeardownSysContext( &sysContext );
+    ReleaseSysContext( &sysContext );
 
     return rval;
 }
 
+//
+// In-process versions of EncryptCFB and DecryptCFB: same key and IV
+// derivation, but AES-CFB is done on the host, so the session key never
+// leaves the process and no TPM commands are needed.
+//
+static TSS2_RC HostCFB( SESSION *session, TPMI_YES_NO decrypt, TPM2B_MAX_BUFFER *outputData,
+    TPM2B_MAX_BUFFER *inputData, TPM2B_AUTH *authValue )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    TPM2B_MAX_BUFFER key;
+    TPM2B_IV iv;
+
+    rval = GenerateSessionEncryptDecryptKey( session, &key, &iv, authValue );
+
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        memmove( &outputData->t.buffer[0], &inputData->t.buffer[0], inputData->t.size );
+        outputData->t.size = inputData->t.size;
+
+        rval = HostAesCfb( decrypt, &key.b, &iv, &outputData->t.buffer[0], outputData->t.size );
+    }
+
+    memset( &key, 0, sizeof( key ) );
+
+    return rval;
+}
+
+TSS2_RC HostEncryptCFB( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue )
+{
+    return HostCFB( session, NO, encryptedData, clearData, authValue );
+}
+
+TSS2_RC HostDecryptCFB( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue )
+{
+    return HostCFB( session, YES, clearData, encryptedData, authValue );
+}
+
 
 TSS2_RC EncryptDecryptXOR( SESSION *session, TPM2B_MAX_BUFFER *outputData, TPM2B_MAX_BUFFER *inputData, TPM2B_AUTH *authValue )
 {
@@ -276,7 +316,7 @@ TSS2_RC EncryptCommandParam( SESSION *session, TPM2B_MAX_BUFFER *encryptedData,
     if( session->symmetric.algorithm == TPM_ALG_AES )
     {
         // CFB mode encryption.
-        rval = EncryptCFB( session, encryptedData, clearData, authValue );
+        rval = (*EncryptCfbFunctionPtr)( session, encryptedData, clearData, authValue );
     }
     else
     {
@@ -294,7 +334,7 @@ TSS2_RC DecryptResponseParam( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM
     if( session->symmetric.algorithm == TPM_ALG_AES )
     {
         // CFB mode decryption.
-        rval = DecryptCFB( session, clearData, encryptedData, authValue );
+        rval = (*DecryptCfbFunctionPtr)( session, clearData, encryptedData, authValue );
     }
     else
     {
@@ -28,6 +28,14 @@
 #include <sapi/tpm20.h>
 #include "sample.h"
 #include "sysapi_util.h"
+#include <stdlib.h>
+
+//
+// Entities are kept in a hash table keyed by handle; each ENTITY is
+// allocated separately so pointers returned by GetEntity stay valid until
+// the entity is deleted.
+//
+static HANDLE_TABLE entityTable = { 0, 0, 0 };
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,89 +44,86 @@ extern "C" {
 
 void InitEntities()
 {
-    int i;
-    for( i = 0; i < MAX_NUM_ENTITIES; i++ )
-    {
-        entities[i].entityHandle = TPM_HT_NO_HANDLE;
-    }
+    HandleTableClear( &entityTable, free );
 }
 
 #ifdef __cplusplus
 }
 #endif
 
+//
+// Adding a handle that is already present replaces its authValue.
+//
 TPM_RC AddEntity( TPM_HANDLE entityHandle, TPM2B_AUTH *auth )
 {
-    int i;
-    TPM_RC rval = TPM_RC_FAILURE;
+    ENTITY *entity;
 
-    for( i = 0; i < MAX_NUM_ENTITIES; i++ )
+    entity = (ENTITY *)HandleTableFind( &entityTable, entityHandle );
+    if( entity == 0 )
     {
-        if( entities[i].entityHandle == TPM_HT_NO_HANDLE )
+        entity = (ENTITY *)calloc( 1, sizeof( ENTITY ) );
+        if( entity == 0 )
+            return TPM_RC_FAILURE;
+
+        entity->entityHandle = entityHandle;
+        if( HandleTableInsert( &entityTable, entityHandle, entity, 0 ) != TPM_RC_SUCCESS )
         {
-            entities[i].entityHandle = entityHandle;
-            CopySizedByteBuffer( &( entities[i].entityAuth.b ), &( auth->b ) );
+            free( entity );
+            return TPM_RC_FAILURE;
+        }
+    }
 
-            if( ( entityHandle >> HR_SHIFT ) == TPM_HT_NV_INDEX )
-            {
-                entities[i].nvNameChanged = 0;
-            }
+    CopySizedByteBuffer( &( entity->entityAuth.b ), &( auth->b ) );
 
-            rval = TPM_RC_SUCCESS;
-            break;
-        }
+    if( ( entityHandle >> HR_SHIFT ) == TPM_HT_NV_INDEX )
+    {
+        entity->nvNameChanged = 0;
     }
-    return rval;
+
+    return TPM_RC_SUCCESS;
 }
 
 TPM_RC DeleteEntity( TPM_HANDLE entityHandle )
 {
-    int i;
-    TPM_RC rval = TPM_RC_FAILURE;
+    ENTITY *entity;
 
-    for( i = 0; i < MAX_NUM_ENTITIES; i++ )
-    {
-        if( entities[i].entityHandle == entityHandle )
-        {
-            entities[i].entityHandle = TPM_HT_NO_HANDLE;
-            rval = TPM_RC_SUCCESS;
-            break;
-        }
-    }
-    return rval;
+    entity = (ENTITY *)HandleTableRemove( &entityTable, entityHandle );
+    if( entity == 0 )
+        return TPM_RC_FAILURE;
+
+    free( entity );
+
+    return TPM_RC_SUCCESS;
 }
 
 TPM_RC GetEntityAuth( TPM_HANDLE entityHandle, TPM2B_AUTH *auth )
 {
-    int i;
-    TPM_RC rval = TPM_RC_FAILURE;
+    ENTITY *entity;
 
-    for( i = 0; i < MAX_NUM_ENTITIES; i++ )
-    {
-        if( entities[i].entityHandle == entityHandle )
-        {
-            CopySizedByteBuffer( &( auth->b ), &( entities[i].entityAuth.b ) );
-            rval = TPM_RC_SUCCESS;
-            break;
-        }
-    }
-    return rval;
+    entity = (ENTITY *)HandleTableFind( &entityTable, entityHandle );
+    if( entity == 0 )
+        return TPM_RC_FAILURE;
+
+    CopySizedByteBuffer( &( auth->b ), &( entity->entityAuth.b ) );
+
+    return TPM_RC_SUCCESS;
 }
 
 
 TPM_RC GetEntity( TPM_HANDLE entityHandle, ENTITY **entity )
 {
-    int i;
-    TPM_RC rval = TPM_RC_FAILURE;
+    ENTITY *found;
 
-    for( i = 0; i < MAX_NUM_ENTITIES; i++ )
-    {
-        if( entities[i].entityHandle == entityHandle )
-        {
-            *entity = &( entities[i] );
-            rval = TPM_RC_SUCCESS;
-        }
-    }
-    return rval;
+    found = (ENTITY *)HandleTableFind( &entityTable, entityHandle );
+    if( found == 0 )
+        return TPM_RC_FAILURE;
+
+    *entity = found;
+
+    return TPM_RC_SUCCESS;
 }
 
+UINT32 GetEntityCount()
+{
+    return entityTable.count;
+}
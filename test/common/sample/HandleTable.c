@@ -0,0 +1,227 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Open-addressed hash table mapping TPM handles to caller-owned pointers.
+// Used by the entity and session bookkeeping so that lookups stay constant
+// time however many entities or sessions the application keeps.
+//
+// Linear probing, with deletion done by shifting later entries of the same
+// probe run back, so there are no tombstones and lookups never degrade.
+// The table doubles when it gets half full.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include <stdlib.h>
+
+#define HANDLE_TABLE_MIN_CAPACITY 16
+
+static UINT32 HandleTableSlot( HANDLE_TABLE *table, TPM_HANDLE handle )
+{
+    // Fibonacci hashing; handles tend to be sequential within a range, so
+    // multiply to spread them over the whole table.
+    return ( (UINT32)( handle * 0x9e3779b1 ) ) & ( table->capacity - 1 );
+}
+
+static TPM_RC HandleTableResize( HANDLE_TABLE *table, UINT32 capacity )
+{
+    HANDLE_TABLE_ENTRY *oldEntries = table->entries;
+    UINT32 oldCapacity = table->capacity;
+    UINT32 i, slot;
+
+    table->entries = (HANDLE_TABLE_ENTRY *)calloc( capacity, sizeof( HANDLE_TABLE_ENTRY ) );
+    if( table->entries == 0 )
+    {
+        table->entries = oldEntries;
+        return APPLICATION_ERROR( TSS2_BASE_RC_INSUFFICIENT_BUFFER );
+    }
+    table->capacity = capacity;
+
+    for( i = 0; i < oldCapacity; i++ )
+    {
+        if( oldEntries[i].value != 0 )
+        {
+            for( slot = HandleTableSlot( table, oldEntries[i].handle );
+                    table->entries[slot].value != 0;
+                    slot = ( slot + 1 ) & ( capacity - 1 ) )
+                ;
+            table->entries[slot] = oldEntries[i];
+        }
+    }
+
+    free( oldEntries );
+
+    return TPM_RC_SUCCESS;
+}
+
+void *HandleTableFind( HANDLE_TABLE *table, TPM_HANDLE handle )
+{
+    UINT32 slot;
+
+    if( table->count == 0 )
+        return 0;
+
+    for( slot = HandleTableSlot( table, handle );
+            table->entries[slot].value != 0;
+            slot = ( slot + 1 ) & ( table->capacity - 1 ) )
+    {
+        if( table->entries[slot].handle == handle )
+            return table->entries[slot].value;
+    }
+
+    return 0;
+}
+
+//
+// Adds or replaces the pointer stored for handle.  If an entry for the
+// handle already existed, *oldValue (when not NULL) gets the pointer it
+// replaced; otherwise it is set to NULL.
+//
+TPM_RC HandleTableInsert( HANDLE_TABLE *table, TPM_HANDLE handle, void *value, void **oldValue )
+{
+    TPM_RC rval;
+    UINT32 slot;
+
+    if( oldValue != 0 )
+        *oldValue = 0;
+
+    if( value == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    if( ( table->count + 1 ) * 2 > table->capacity )
+    {
+        rval = HandleTableResize( table, table->capacity == 0 ?
+                HANDLE_TABLE_MIN_CAPACITY : table->capacity * 2 );
+        if( rval != TPM_RC_SUCCESS )
+            return rval;
+    }
+
+    for( slot = HandleTableSlot( table, handle );
+            table->entries[slot].value != 0;
+            slot = ( slot + 1 ) & ( table->capacity - 1 ) )
+    {
+        if( table->entries[slot].handle == handle )
+        {
+            if( oldValue != 0 )
+                *oldValue = table->entries[slot].value;
+            table->entries[slot].value = value;
+            return TPM_RC_SUCCESS;
+        }
+    }
+
+    table->entries[slot].handle = handle;
+    table->entries[slot].value = value;
+    table->count++;
+
+    return TPM_RC_SUCCESS;
+}
+
+void *HandleTableRemove( HANDLE_TABLE *table, TPM_HANDLE handle )
+{
+    UINT32 mask = table->capacity - 1;
+    UINT32 slot, next, home;
+    void *value;
+
+    if( table->count == 0 )
+        return 0;
+
+    for( slot = HandleTableSlot( table, handle );
+            table->entries[slot].value != 0 && table->entries[slot].handle != handle;
+            slot = ( slot + 1 ) & mask )
+        ;
+
+    value = table->entries[slot].value;
+    if( value == 0 )
+        return 0;
+
+    // Close the hole: move back any later entry in the run whose home slot
+    // is not between the hole and its current position.
+    for( next = ( slot + 1 ) & mask; table->entries[next].value != 0; next = ( next + 1 ) & mask )
+    {
+        home = HandleTableSlot( table, table->entries[next].handle );
+        if( ( ( next - home ) & mask ) >= ( ( next - slot ) & mask ) )
+        {
+            table->entries[slot] = table->entries[next];
+            slot = next;
+        }
+    }
+
+    table->entries[slot].value = 0;
+    table->count--;
+
+    return value;
+}
+
+//
+// Removes every entry whose handle type (the handle's top byte) matches
+// handleType, calling freeValue, if not NULL, on each removed pointer.
+//
+void HandleTableRemoveType( HANDLE_TABLE *table, UINT8 handleType, void ( *freeValue )( void *value ) )
+{
+    UINT32 i = 0;
+    void *value;
+
+    // A removal can shift a later entry into slot i, so only advance past
+    // slots that were kept.
+    while( i < table->capacity )
+    {
+        if( table->entries[i].value != 0 && ( table->entries[i].handle >> HR_SHIFT ) == handleType )
+        {
+            value = HandleTableRemove( table, table->entries[i].handle );
+            if( freeValue != 0 )
+                freeValue( value );
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+//
+// Empties the table and releases its storage.  If freeValue is not NULL it
+// is called for every stored pointer first.
+//
+void HandleTableClear( HANDLE_TABLE *table, void ( *freeValue )( void *value ) )
+{
+    UINT32 i;
+
+    if( freeValue != 0 )
+    {
+        for( i = 0; i < table->capacity; i++ )
+        {
+            if( table->entries[i].value != 0 )
+                freeValue( table->entries[i].value );
+        }
+    }
+
+    free( table->entries );
+    table->entries = 0;
+    table->capacity = 0;
+    table->count = 0;
+}
@@ -0,0 +1,287 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Streaming hash and HMAC sequences.
+//
+// Input is gathered into full MAX_DIGEST_BUFFER chunks however it is
+// handed in (many small buffers, one large mmap'd region or a file
+// descriptor), so a sequence costs one SequenceUpdate per chunk rather
+// than one per input buffer.  The last, possibly partial, chunk goes out
+// with SequenceComplete.
+//
+// Each SequenceUpdate is sent with ExecuteAsync and only collected when
+// the next chunk is ready to go, so reading the file (or copying the next
+// chunk) overlaps with the TPM hashing the previous one.  Two sys contexts
+// are used so the next command can be marshalled while the previous one
+// is still in flight.
+//
+// The sequence handle stays loaded from HashStreamStart until
+// HashStreamComplete or HashStreamAbort.  The HASH_STREAM must not be
+// moved while the sequence is open.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define HASH_STREAM_CONTEXT_SIZE 3000
+
+static void HashStreamTeardown( HASH_STREAM *stream )
+{
+    ReleaseSysContext( &stream->sysContext[0] );
+    ReleaseSysContext( &stream->sysContext[1] );
+}
+
+//
+// Starts a hash sequence for hashAlg, or an HMAC sequence if hmacKey is
+// not TPM_RH_NULL; keyAuth is the key's authValue (NULL for none).
+//
+TSS2_RC HashStreamStart( HASH_STREAM *stream, TSS2_TCTI_CONTEXT *tctiContext, TPMI_ALG_HASH hashAlg,
+    TPMI_DH_OBJECT hmacKey, TPM2B_AUTH *keyAuth )
+{
+    TSS2_RC rval;
+    TPM2B_AUTH nullAuth;
+    TPMS_AUTH_COMMAND keyCmdAuth;
+    TPMS_AUTH_COMMAND *keyCmdAuthList[1] = { &keyCmdAuth };
+    TSS2_SYS_CMD_AUTHS keyCmdAuths = { 1, &keyCmdAuthList[0] };
+
+    if( stream == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    memset( stream, 0, sizeof( HASH_STREAM ) );
+    nullAuth.t.size = 0;
+
+    // The sequence is created with an empty authValue, so every update is
+    // authorized with the same empty password.
+    stream->sequenceAuth.sessionHandle = TPM_RS_PW;
+    stream->sequenceAuthList[0] = &stream->sequenceAuth;
+    stream->cmdAuths.cmdAuthsCount = 1;
+    stream->cmdAuths.cmdAuths = &stream->sequenceAuthList[0];
+
+    stream->sysContext[0] = AcquireSysContext( HASH_STREAM_CONTEXT_SIZE, tctiContext, &abiVersion );
+    stream->sysContext[1] = AcquireSysContext( HASH_STREAM_CONTEXT_SIZE, tctiContext, &abiVersion );
+    if( stream->sysContext[0] == 0 || stream->sysContext[1] == 0 )
+    {
+        HashStreamTeardown( stream );
+        return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
+    }
+
+    if( hmacKey == TPM_RH_NULL )
+    {
+        rval = Tss2_Sys_HashSequenceStart( stream->sysContext[0], 0, &nullAuth, hashAlg,
+                &stream->sequenceHandle, 0 );
+    }
+    else
+    {
+        memset( &keyCmdAuth, 0, sizeof( keyCmdAuth ) );
+        keyCmdAuth.sessionHandle = TPM_RS_PW;
+        if( keyAuth != 0 )
+            CopySizedByteBuffer( &keyCmdAuth.hmac.b, &keyAuth->b );
+
+        rval = Tss2_Sys_HMAC_Start( stream->sysContext[0], hmacKey, &keyCmdAuths, &nullAuth, hashAlg,
+                &stream->sequenceHandle, 0 );
+    }
+
+    if( rval != TPM_RC_SUCCESS )
+        HashStreamTeardown( stream );
+
+    return rval;
+}
+
+static TSS2_RC HashStreamFinishPending( HASH_STREAM *stream )
+{
+    TSS2_RC rval;
+
+    if( stream->pending == 0 )
+        return TSS2_RC_SUCCESS;
+
+    rval = Tss2_Sys_ExecuteFinish( stream->pending, TSS2_TCTI_TIMEOUT_BLOCK );
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        // SequenceUpdate has no response parameters.
+        rval = CommonComplete( stream->pending );
+    }
+    stream->pending = 0;
+
+    return rval;
+}
+
+//
+// Sends the full chunk in stream->buffer.  The previous update is
+// collected after this one is marshalled and before it is sent.
+//
+static TSS2_RC HashStreamSend( HASH_STREAM *stream )
+{
+    TSS2_SYS_CONTEXT *sysContext = stream->sysContext[stream->current];
+    TSS2_RC rval;
+
+    rval = Tss2_Sys_ReserveCmdAuths( sysContext, &stream->cmdAuths );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = Tss2_Sys_SequenceUpdate_Prepare( sysContext, stream->sequenceHandle, &stream->buffer );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = Tss2_Sys_SetCmdAuths( sysContext, &stream->cmdAuths );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = HashStreamFinishPending( stream );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = Tss2_Sys_ExecuteAsync( sysContext );
+
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        stream->pending = sysContext;
+        stream->current ^= 1;
+        stream->buffer.t.size = 0;
+        stream->updates++;
+    }
+
+    return rval;
+}
+
+TSS2_RC HashStreamUpdate( HASH_STREAM *stream, const UINT8 *data, size_t size )
+{
+    TSS2_RC rval;
+    size_t count;
+
+    if( stream == 0 || ( data == 0 && size != 0 ) )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    while( size > 0 )
+    {
+        // A full chunk is only sent once more data arrives, so the last
+        // one can go out with SequenceComplete.
+        if( stream->buffer.t.size == MAX_DIGEST_BUFFER )
+        {
+            rval = HashStreamSend( stream );
+            if( rval != TSS2_RC_SUCCESS )
+                return rval;
+        }
+
+        count = MAX_DIGEST_BUFFER - stream->buffer.t.size;
+        if( count > size )
+            count = size;
+
+        memcpy( &stream->buffer.t.buffer[stream->buffer.t.size], data, count );
+        stream->buffer.t.size += (UINT16)count;
+        data += count;
+        size -= count;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Hashes everything that can be read from fd, up to end of file.  Each
+// read fills the chunk buffer while the previous chunk is being hashed.
+//
+TSS2_RC HashStreamUpdateFd( HASH_STREAM *stream, int fd )
+{
+    TSS2_RC rval;
+    ssize_t count;
+
+    if( stream == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    for( ;; )
+    {
+        if( stream->buffer.t.size == MAX_DIGEST_BUFFER )
+        {
+            rval = HashStreamSend( stream );
+            if( rval != TSS2_RC_SUCCESS )
+                return rval;
+        }
+
+        count = read( fd, &stream->buffer.t.buffer[stream->buffer.t.size],
+                MAX_DIGEST_BUFFER - stream->buffer.t.size );
+        if( count == 0 )
+            break;
+
+        if( count < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            return APPLICATION_ERROR( TSS2_BASE_RC_IO_ERROR );
+        }
+
+        stream->buffer.t.size += (UINT16)count;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Sends whatever is left and ends the sequence; validation may be NULL.
+// The sequence is gone afterwards whether or not this succeeded.
+//
+TSS2_RC HashStreamComplete( HASH_STREAM *stream, TPMI_RH_HIERARCHY hierarchy, TPM2B_DIGEST *result,
+    TPMT_TK_HASHCHECK *validation )
+{
+    TSS2_RC rval;
+    TPMT_TK_HASHCHECK ticket;
+
+    if( stream == 0 || result == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    result->b.size = 0;
+
+    rval = HashStreamFinishPending( stream );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        HashStreamAbort( stream );
+        return rval;
+    }
+
+    INIT_SIMPLE_TPM2B_SIZE( *result );
+    rval = Tss2_Sys_SequenceComplete( stream->sysContext[stream->current], stream->sequenceHandle,
+            &stream->cmdAuths, &stream->buffer, hierarchy, result,
+            validation != 0 ? validation : &ticket, 0 );
+    if( rval != TPM_RC_SUCCESS )
+    {
+        result->b.size = 0;
+        HashStreamAbort( stream );
+        return rval;
+    }
+
+    HashStreamTeardown( stream );
+
+    return rval;
+}
+
+//
+// Drops an open sequence without producing a result.
+//
+void HashStreamAbort( HASH_STREAM *stream )
+{
+    if( stream == 0 || stream->sysContext[0] == 0 )
+        return;
+
+    HashStreamFinishPending( stream );
+    Tss2_Sys_FlushContext( stream->sysContext[0], stream->sequenceHandle );
+    HashStreamTeardown( stream );
+}
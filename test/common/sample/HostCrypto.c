@@ -0,0 +1,755 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Host-side (software) hash, HMAC and AES-CFB functions.
+//
+// HostHash and HostHmac have the same signatures as TpmHash and TpmHmac and
+// can be assigned to HashFunctionPtr / HmacFunctionPtr.  Unlike the TPM
+// versions, they don't cost any TPM round trips, which matters for HMAC
+// sessions: every command and response HMAC, every cpHash/rpHash and every
+// KDFa block go through these pointers.  HostAesCfb does the same for the
+// CFB parameter encryption of AES decrypt/encrypt sessions.
+//
+// SHA-1 and SHA-256 use the x86 SHA extensions and AES uses AES-NI when the
+// CPU has them; everything else, and every other CPU, uses the portable C
+// code below.
+//
+
+#include <string.h>
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+#define HOST_CRYPTO_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define HOST_HASH_MAX_BLOCK_SIZE SHA512_BLOCK_SIZE
+
+typedef void (*HOST_COMPRESS_FUNC)( void *state, const UINT8 *data, size_t blocks );
+
+typedef struct {
+    union {
+        UINT32 s32[8];
+        UINT64 s64[8];
+    } state;
+    UINT8 block[HOST_HASH_MAX_BLOCK_SIZE];
+    UINT32 used;
+    UINT64 length;
+    UINT16 blockSize;
+    UINT16 digestSize;
+    HOST_COMPRESS_FUNC compress;
+} HOST_HASH_CTX;
+
+static const UINT32 sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const UINT64 sha512K[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+#define ROTL32( x, n ) ( ( (x) << (n) ) | ( (x) >> ( 32 - (n) ) ) )
+#define ROTR32( x, n ) ( ( (x) >> (n) ) | ( (x) << ( 32 - (n) ) ) )
+#define ROTR64( x, n ) ( ( (x) >> (n) ) | ( (x) << ( 64 - (n) ) ) )
+
+static UINT32 LoadBe32( const UINT8 *p )
+{
+    return ( (UINT32)p[0] << 24 ) | ( (UINT32)p[1] << 16 ) | ( (UINT32)p[2] << 8 ) | p[3];
+}
+
+static UINT64 LoadBe64( const UINT8 *p )
+{
+    return ( (UINT64)LoadBe32( p ) << 32 ) | LoadBe32( p + 4 );
+}
+
+static void StoreBe32( UINT8 *p, UINT32 v )
+{
+    p[0] = (UINT8)( v >> 24 );
+    p[1] = (UINT8)( v >> 16 );
+    p[2] = (UINT8)( v >> 8 );
+    p[3] = (UINT8)v;
+}
+
+static void StoreBe64( UINT8 *p, UINT64 v )
+{
+    StoreBe32( p, (UINT32)( v >> 32 ) );
+    StoreBe32( p + 4, (UINT32)v );
+}
+
+//
+// Portable compression functions.
+//
+static void Sha1Compress( void *statePtr, const UINT8 *data, size_t blocks )
+{
+    UINT32 *state = (UINT32 *)statePtr;
+    UINT32 w[80], a, b, c, d, e, f, k, t;
+    int i;
+
+    for( ; blocks > 0; blocks--, data += SHA1_BLOCK_SIZE )
+    {
+        for( i = 0; i < 16; i++ )
+            w[i] = LoadBe32( data + 4 * i );
+        for( ; i < 80; i++ )
+            w[i] = ROTL32( w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1 );
+
+        a = state[0]; b = state[1]; c = state[2]; d = state[3]; e = state[4];
+
+        for( i = 0; i < 80; i++ )
+        {
+            if( i < 20 )
+            {
+                f = ( b & c ) | ( ~b & d );
+                k = 0x5a827999;
+            }
+            else if( i < 40 )
+            {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            }
+            else if( i < 60 )
+            {
+                f = ( b & c ) | ( b & d ) | ( c & d );
+                k = 0x8f1bbcdc;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            t = ROTL32( a, 5 ) + f + e + k + w[i];
+            e = d; d = c; c = ROTL32( b, 30 ); b = a; a = t;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+    }
+}
+
+static void Sha256Compress( void *statePtr, const UINT8 *data, size_t blocks )
+{
+    UINT32 *state = (UINT32 *)statePtr;
+    UINT32 w[64], s[8], t1, t2;
+    int i;
+
+    for( ; blocks > 0; blocks--, data += SHA256_BLOCK_SIZE )
+    {
+        for( i = 0; i < 16; i++ )
+            w[i] = LoadBe32( data + 4 * i );
+        for( ; i < 64; i++ )
+            w[i] = ( ROTR32( w[i - 2], 17 ) ^ ROTR32( w[i - 2], 19 ) ^ ( w[i - 2] >> 10 ) ) + w[i - 7] +
+                   ( ROTR32( w[i - 15], 7 ) ^ ROTR32( w[i - 15], 18 ) ^ ( w[i - 15] >> 3 ) ) + w[i - 16];
+
+        memcpy( s, state, sizeof( s ) );
+
+        for( i = 0; i < 64; i++ )
+        {
+            t1 = s[7] + ( ROTR32( s[4], 6 ) ^ ROTR32( s[4], 11 ) ^ ROTR32( s[4], 25 ) ) +
+                 ( ( s[4] & s[5] ) ^ ( ~s[4] & s[6] ) ) + sha256K[i] + w[i];
+            t2 = ( ROTR32( s[0], 2 ) ^ ROTR32( s[0], 13 ) ^ ROTR32( s[0], 22 ) ) +
+                 ( ( s[0] & s[1] ) ^ ( s[0] & s[2] ) ^ ( s[1] & s[2] ) );
+            s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+            s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+        }
+
+        for( i = 0; i < 8; i++ )
+            state[i] += s[i];
+    }
+}
+
+static void Sha512Compress( void *statePtr, const UINT8 *data, size_t blocks )
+{
+    UINT64 *state = (UINT64 *)statePtr;
+    UINT64 w[80], s[8], t1, t2;
+    int i;
+
+    for( ; blocks > 0; blocks--, data += SHA512_BLOCK_SIZE )
+    {
+        for( i = 0; i < 16; i++ )
+            w[i] = LoadBe64( data + 8 * i );
+        for( ; i < 80; i++ )
+            w[i] = ( ROTR64( w[i - 2], 19 ) ^ ROTR64( w[i - 2], 61 ) ^ ( w[i - 2] >> 6 ) ) + w[i - 7] +
+                   ( ROTR64( w[i - 15], 1 ) ^ ROTR64( w[i - 15], 8 ) ^ ( w[i - 15] >> 7 ) ) + w[i - 16];
+
+        memcpy( s, state, sizeof( s ) );
+
+        for( i = 0; i < 80; i++ )
+        {
+            t1 = s[7] + ( ROTR64( s[4], 14 ) ^ ROTR64( s[4], 18 ) ^ ROTR64( s[4], 41 ) ) +
+                 ( ( s[4] & s[5] ) ^ ( ~s[4] & s[6] ) ) + sha512K[i] + w[i];
+            t2 = ( ROTR64( s[0], 28 ) ^ ROTR64( s[0], 34 ) ^ ROTR64( s[0], 39 ) ) +
+                 ( ( s[0] & s[1] ) ^ ( s[0] & s[2] ) ^ ( s[1] & s[2] ) );
+            s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+            s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+        }
+
+        for( i = 0; i < 8; i++ )
+            state[i] += s[i];
+    }
+}
+
+#ifdef HOST_CRYPTO_X86
+//
+// SHA extensions (SHA-NI) versions.  The state layout is the same as for the
+// portable functions, so the two can be mixed freely within one hash.
+//
+#define SHA_NI_TARGET __attribute__(( target( "sha,sse4.1,ssse3" ) ))
+
+#define SHA1_NI_ROUNDS( func, g )                                           \
+    e = _mm_sha1nexte_epu32( abcdPrev, w[g] );                              \
+    abcdPrev = abcd;                                                        \
+    abcd = _mm_sha1rnds4_epu32( abcd, e, func );
+
+static SHA_NI_TARGET void Sha1CompressShaNi( void *statePtr, const UINT8 *data, size_t blocks )
+{
+    UINT32 *state = (UINT32 *)statePtr;
+    const __m128i mask = _mm_set_epi64x( 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL );
+    __m128i abcd, abcdSave, abcdPrev, e, eSave, w[20];
+    int g;
+
+    abcd = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)state ), 0x1b );
+    eSave = _mm_set_epi32( state[4], 0, 0, 0 );
+
+    for( ; blocks > 0; blocks--, data += SHA1_BLOCK_SIZE )
+    {
+        for( g = 0; g < 4; g++ )
+            w[g] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 16 * g ) ), mask );
+        for( ; g < 20; g++ )
+            w[g] = _mm_sha1msg2_epu32( _mm_xor_si128( _mm_sha1msg1_epu32( w[g - 4], w[g - 3] ), w[g - 2] ), w[g - 1] );
+
+        abcdSave = abcd;
+
+        // Rounds 0-3 take E from the state; later groups derive it from A.
+        e = _mm_add_epi32( eSave, w[0] );
+        abcdPrev = abcd;
+        abcd = _mm_sha1rnds4_epu32( abcd, e, 0 );
+
+        SHA1_NI_ROUNDS( 0, 1 ) SHA1_NI_ROUNDS( 0, 2 ) SHA1_NI_ROUNDS( 0, 3 ) SHA1_NI_ROUNDS( 0, 4 )
+        SHA1_NI_ROUNDS( 1, 5 ) SHA1_NI_ROUNDS( 1, 6 ) SHA1_NI_ROUNDS( 1, 7 ) SHA1_NI_ROUNDS( 1, 8 )
+        SHA1_NI_ROUNDS( 1, 9 ) SHA1_NI_ROUNDS( 2, 10 ) SHA1_NI_ROUNDS( 2, 11 ) SHA1_NI_ROUNDS( 2, 12 )
+        SHA1_NI_ROUNDS( 2, 13 ) SHA1_NI_ROUNDS( 2, 14 ) SHA1_NI_ROUNDS( 3, 15 ) SHA1_NI_ROUNDS( 3, 16 )
+        SHA1_NI_ROUNDS( 3, 17 ) SHA1_NI_ROUNDS( 3, 18 ) SHA1_NI_ROUNDS( 3, 19 )
+
+        eSave = _mm_sha1nexte_epu32( abcdPrev, eSave );
+        abcd = _mm_add_epi32( abcd, abcdSave );
+    }
+
+    _mm_storeu_si128( (__m128i *)state, _mm_shuffle_epi32( abcd, 0x1b ) );
+    state[4] = (UINT32)_mm_extract_epi32( eSave, 3 );
+}
+
+static SHA_NI_TARGET void Sha256CompressShaNi( void *statePtr, const UINT8 *data, size_t blocks )
+{
+    UINT32 *state = (UINT32 *)statePtr;
+    const __m128i mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+    __m128i state0, state1, save0, save1, msg, tmp, w[16];
+    int g;
+
+    // Rearrange a..h into the ABEF / CDGH halves the instructions expect.
+    tmp = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)&state[0] ), 0xb1 );
+    state1 = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)&state[4] ), 0x1b );
+    state0 = _mm_alignr_epi8( tmp, state1, 8 );
+    state1 = _mm_blend_epi16( state1, tmp, 0xf0 );
+
+    for( ; blocks > 0; blocks--, data += SHA256_BLOCK_SIZE )
+    {
+        save0 = state0;
+        save1 = state1;
+
+        for( g = 0; g < 16; g++ )
+        {
+            if( g < 4 )
+            {
+                w[g] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)( data + 16 * g ) ), mask );
+            }
+            else
+            {
+                tmp = _mm_add_epi32( _mm_sha256msg1_epu32( w[g - 4], w[g - 3] ), _mm_alignr_epi8( w[g - 1], w[g - 2], 4 ) );
+                w[g] = _mm_sha256msg2_epu32( tmp, w[g - 1] );
+            }
+
+            msg = _mm_add_epi32( w[g], _mm_loadu_si128( (const __m128i *)&sha256K[4 * g] ) );
+            state1 = _mm_sha256rnds2_epu32( state1, state0, msg );
+            state0 = _mm_sha256rnds2_epu32( state0, state1, _mm_shuffle_epi32( msg, 0x0e ) );
+        }
+
+        state0 = _mm_add_epi32( state0, save0 );
+        state1 = _mm_add_epi32( state1, save1 );
+    }
+
+    tmp = _mm_shuffle_epi32( state0, 0x1b );
+    state1 = _mm_shuffle_epi32( state1, 0xb1 );
+    _mm_storeu_si128( (__m128i *)&state[0], _mm_blend_epi16( tmp, state1, 0xf0 ) );
+    _mm_storeu_si128( (__m128i *)&state[4], _mm_alignr_epi8( state1, tmp, 8 ) );
+}
+
+static int ShaNiAvailable( void )
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if( __get_cpuid_max( 0, 0 ) < 7 )
+        return 0;
+
+    __cpuid( 1, eax, ebx, ecx, edx );
+    if( !( ecx & bit_SSSE3 ) || !( ecx & bit_SSE4_1 ) )
+        return 0;
+
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    return ( ebx & ( 1 << 29 ) ) != 0;
+}
+
+static int AesNiAvailable( void )
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+        return 0;
+
+    return ( ecx & bit_AES ) && ( edx & bit_SSE2 );
+}
+#endif
+
+// -1: not probed yet, 0: portable C, 1: SHA extensions / AES-NI.
+static int useShaNi = -1;
+static int useAesNi = -1;
+
+void HostCryptoUseAcceleration( int enable )
+{
+#ifdef HOST_CRYPTO_X86
+    useShaNi = enable ? ShaNiAvailable() : 0;
+    useAesNi = enable ? AesNiAvailable() : 0;
+#else
+    useShaNi = 0;
+    useAesNi = 0;
+#endif
+}
+
+static TPM_RC HostHashInit( HOST_HASH_CTX *ctx, TPMI_ALG_HASH hashAlg )
+{
+    static const UINT32 sha1Init[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    static const UINT32 sha256Init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    static const UINT64 sha384Init[8] = {
+        0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+        0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL };
+    static const UINT64 sha512Init[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+
+    if( useShaNi < 0 )
+        HostCryptoUseAcceleration( 1 );
+
+    ctx->used = 0;
+    ctx->length = 0;
+
+    switch( hashAlg )
+    {
+        case TPM_ALG_SHA1:
+            memcpy( ctx->state.s32, sha1Init, sizeof( sha1Init ) );
+            ctx->blockSize = SHA1_BLOCK_SIZE;
+            ctx->digestSize = SHA1_DIGEST_SIZE;
+            ctx->compress = Sha1Compress;
+#ifdef HOST_CRYPTO_X86
+            if( useShaNi )
+                ctx->compress = Sha1CompressShaNi;
+#endif
+            break;
+        case TPM_ALG_SHA256:
+            memcpy( ctx->state.s32, sha256Init, sizeof( sha256Init ) );
+            ctx->blockSize = SHA256_BLOCK_SIZE;
+            ctx->digestSize = SHA256_DIGEST_SIZE;
+            ctx->compress = Sha256Compress;
+#ifdef HOST_CRYPTO_X86
+            if( useShaNi )
+                ctx->compress = Sha256CompressShaNi;
+#endif
+            break;
+        case TPM_ALG_SHA384:
+            memcpy( ctx->state.s64, sha384Init, sizeof( sha384Init ) );
+            ctx->blockSize = SHA384_BLOCK_SIZE;
+            ctx->digestSize = SHA384_DIGEST_SIZE;
+            ctx->compress = Sha512Compress;
+            break;
+        case TPM_ALG_SHA512:
+            memcpy( ctx->state.s64, sha512Init, sizeof( sha512Init ) );
+            ctx->blockSize = SHA512_BLOCK_SIZE;
+            ctx->digestSize = SHA512_DIGEST_SIZE;
+            ctx->compress = Sha512Compress;
+            break;
+        default:
+            return TSS2_APP_RC_BAD_ALGORITHM;
+    }
+
+    return TPM_RC_SUCCESS;
+}
+
+static void HostHashUpdate( HOST_HASH_CTX *ctx, const UINT8 *data, size_t size )
+{
+    size_t n;
+
+    ctx->length += size;
+
+    if( ctx->used != 0 )
+    {
+        n = ctx->blockSize - ctx->used;
+        if( n > size )
+            n = size;
+        memcpy( ctx->block + ctx->used, data, n );
+        ctx->used += (UINT32)n;
+        data += n;
+        size -= n;
+
+        if( ctx->used < ctx->blockSize )
+            return;
+
+        ctx->compress( &ctx->state, ctx->block, 1 );
+        ctx->used = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer.
+    n = size / ctx->blockSize;
+    if( n != 0 )
+    {
+        ctx->compress( &ctx->state, data, n );
+        data += n * ctx->blockSize;
+        size -= n * ctx->blockSize;
+    }
+
+    memcpy( ctx->block, data, size );
+    ctx->used = (UINT32)size;
+}
+
+static void HostHashFinal( HOST_HASH_CTX *ctx, UINT8 *digest )
+{
+    // SHA-384/512 use a 128-bit length field, the others a 64-bit one.
+    UINT32 lengthSize = ( ctx->blockSize == SHA512_BLOCK_SIZE ) ? 16 : 8;
+    UINT64 bits = ctx->length * 8;
+    int i;
+
+    ctx->block[ctx->used++] = 0x80;
+    if( ctx->used > ctx->blockSize - lengthSize )
+    {
+        memset( ctx->block + ctx->used, 0, ctx->blockSize - ctx->used );
+        ctx->compress( &ctx->state, ctx->block, 1 );
+        ctx->used = 0;
+    }
+    memset( ctx->block + ctx->used, 0, ctx->blockSize - ctx->used );
+    StoreBe64( ctx->block + ctx->blockSize - 8, bits );
+    ctx->compress( &ctx->state, ctx->block, 1 );
+
+    if( ctx->blockSize == SHA512_BLOCK_SIZE )
+    {
+        for( i = 0; i < ctx->digestSize / 8; i++ )
+            StoreBe64( digest + 8 * i, ctx->state.s64[i] );
+    }
+    else
+    {
+        for( i = 0; i < ctx->digestSize / 4; i++ )
+            StoreBe32( digest + 4 * i, ctx->state.s32[i] );
+    }
+}
+
+//
+// This function does a hash on a string of data.
+//
+UINT32 HostHash( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result )
+{
+    HOST_HASH_CTX ctx;
+    TPM_RC rval;
+
+    result->t.size = 0;
+
+    rval = HostHashInit( &ctx, hashAlg );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    HostHashUpdate( &ctx, data, size );
+    HostHashFinal( &ctx, result->t.buffer );
+    result->t.size = ctx.digestSize;
+
+    return TPM_RC_SUCCESS;
+}
+
+//
+// This function does an HMAC on a null-terminated list of input buffers.
+//
+UINT32 HostHmac( TPMI_ALG_HASH hashAlg, TPM2B *key, TPM2B **bufferList, TPM2B_DIGEST *result )
+{
+    HOST_HASH_CTX ctx;
+    UINT8 pad[HOST_HASH_MAX_BLOCK_SIZE];
+    UINT8 innerDigest[SHA512_DIGEST_SIZE];
+    TPM_RC rval;
+    int i;
+
+    result->t.size = 0;
+
+    rval = HostHashInit( &ctx, hashAlg );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    // Keys longer than a block are hashed first.
+    memset( pad, 0, sizeof( pad ) );
+    if( key != 0 && key->size > ctx.blockSize )
+    {
+        HostHashUpdate( &ctx, key->buffer, key->size );
+        HostHashFinal( &ctx, pad );
+        HostHashInit( &ctx, hashAlg );
+    }
+    else if( key != 0 )
+    {
+        memcpy( pad, key->buffer, key->size );
+    }
+
+    for( i = 0; i < ctx.blockSize; i++ )
+        pad[i] ^= 0x36;
+    HostHashUpdate( &ctx, pad, ctx.blockSize );
+    for( i = 0; bufferList[i] != 0; i++ )
+        HostHashUpdate( &ctx, bufferList[i]->buffer, bufferList[i]->size );
+    HostHashFinal( &ctx, innerDigest );
+
+    HostHashInit( &ctx, hashAlg );
+    for( i = 0; i < ctx.blockSize; i++ )
+        pad[i] ^= 0x36 ^ 0x5c;
+    HostHashUpdate( &ctx, pad, ctx.blockSize );
+    HostHashUpdate( &ctx, innerDigest, ctx.digestSize );
+    HostHashFinal( &ctx, result->t.buffer );
+    result->t.size = ctx.digestSize;
+
+    return TPM_RC_SUCCESS;
+}
+
+//
+// AES, encryption direction only: CFB uses the block cipher forwards for
+// both encryption and decryption.
+//
+typedef struct {
+    UINT8 roundKeys[16 * 15];
+    int rounds;
+} HOST_AES_KEY;
+
+static const UINT8 aesSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+#define XTIME( x ) ( (UINT8)( ( (x) << 1 ) ^ ( ( (x) & 0x80 ) ? 0x1b : 0 ) ) )
+
+static TSS2_RC AesExpandKey( HOST_AES_KEY *aesKey, const UINT8 *key, UINT16 keySize )
+{
+    static const UINT8 rcon[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+    int nk = keySize / 4;
+    int i, j;
+    UINT8 t[4], tmp;
+
+    if( keySize != 16 && keySize != 24 && keySize != 32 )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_SIZE );
+
+    aesKey->rounds = nk + 6;
+    memcpy( aesKey->roundKeys, key, keySize );
+
+    for( i = nk; i < 4 * ( aesKey->rounds + 1 ); i++ )
+    {
+        memcpy( t, &aesKey->roundKeys[4 * ( i - 1 )], 4 );
+        if( i % nk == 0 )
+        {
+            tmp = t[0];
+            t[0] = aesSbox[t[1]] ^ rcon[i / nk - 1];
+            t[1] = aesSbox[t[2]];
+            t[2] = aesSbox[t[3]];
+            t[3] = aesSbox[tmp];
+        }
+        else if( nk > 6 && i % nk == 4 )
+        {
+            for( j = 0; j < 4; j++ )
+                t[j] = aesSbox[t[j]];
+        }
+        for( j = 0; j < 4; j++ )
+            aesKey->roundKeys[4 * i + j] = aesKey->roundKeys[4 * ( i - nk ) + j] ^ t[j];
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+static void AesEncryptBlock( const HOST_AES_KEY *aesKey, const UINT8 *in, UINT8 *out )
+{
+    const UINT8 *rk = aesKey->roundKeys;
+    UINT8 s[16], t[16], x;
+    int r, c, i;
+
+    for( i = 0; i < 16; i++ )
+        s[i] = in[i] ^ rk[i];
+
+    for( r = 1; r <= aesKey->rounds; r++ )
+    {
+        // SubBytes and ShiftRows.
+        for( c = 0; c < 4; c++ )
+            for( i = 0; i < 4; i++ )
+                t[4 * c + i] = aesSbox[s[4 * ( ( c + i ) & 3 ) + i]];
+
+        // MixColumns, except in the last round.
+        if( r != aesKey->rounds )
+        {
+            for( c = 0; c < 4; c++ )
+            {
+                x = t[4 * c] ^ t[4 * c + 1] ^ t[4 * c + 2] ^ t[4 * c + 3];
+                s[4 * c]     = t[4 * c]     ^ x ^ XTIME( t[4 * c]     ^ t[4 * c + 1] );
+                s[4 * c + 1] = t[4 * c + 1] ^ x ^ XTIME( t[4 * c + 1] ^ t[4 * c + 2] );
+                s[4 * c + 2] = t[4 * c + 2] ^ x ^ XTIME( t[4 * c + 2] ^ t[4 * c + 3] );
+                s[4 * c + 3] = t[4 * c + 3] ^ x ^ XTIME( t[4 * c + 3] ^ t[4 * c] );
+            }
+        }
+        else
+        {
+            memcpy( s, t, sizeof( s ) );
+        }
+
+        for( i = 0; i < 16; i++ )
+            s[i] ^= rk[16 * r + i];
+    }
+
+    memcpy( out, s, sizeof( s ) );
+}
+
+#ifdef HOST_CRYPTO_X86
+static __attribute__(( target( "aes,sse2" ) )) void AesEncryptBlockAesNi( const HOST_AES_KEY *aesKey, const UINT8 *in, UINT8 *out )
+{
+    const __m128i *rk = (const __m128i *)aesKey->roundKeys;
+    __m128i block;
+    int r;
+
+    block = _mm_xor_si128( _mm_loadu_si128( (const __m128i *)in ), _mm_loadu_si128( rk ) );
+    for( r = 1; r < aesKey->rounds; r++ )
+        block = _mm_aesenc_si128( block, _mm_loadu_si128( rk + r ) );
+    block = _mm_aesenclast_si128( block, _mm_loadu_si128( rk + aesKey->rounds ) );
+    _mm_storeu_si128( (__m128i *)out, block );
+}
+#endif
+
+//
+// AES-CFB (128-bit feedback, as used by TPM 2.0 parameter encryption), done
+// in place on data.  A trailing partial block is handled like the TPM does:
+// only as many key stream bytes as needed are used.
+//
+// key must be 16, 24 or 32 bytes and iv must be 16 bytes.
+//
+TSS2_RC HostAesCfb( TPMI_YES_NO decrypt, TPM2B *key, TPM2B_IV *iv, UINT8 *data, UINT32 size )
+{
+    void (*encryptBlock)( const HOST_AES_KEY *aesKey, const UINT8 *in, UINT8 *out ) = AesEncryptBlock;
+    HOST_AES_KEY aesKey;
+    UINT8 feedback[16], keyStream[16], cipherByte;
+    UINT32 offset, i, n;
+    TSS2_RC rval;
+
+    if( key == 0 || iv == 0 || ( data == 0 && size != 0 ) )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_REFERENCE );
+
+    if( iv->t.size != sizeof( feedback ) )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_SIZE );
+
+    rval = AesExpandKey( &aesKey, key->buffer, key->size );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    if( useAesNi < 0 )
+        HostCryptoUseAcceleration( 1 );
+#ifdef HOST_CRYPTO_X86
+    if( useAesNi )
+        encryptBlock = AesEncryptBlockAesNi;
+#endif
+
+    memcpy( feedback, iv->t.buffer, sizeof( feedback ) );
+
+    for( offset = 0; offset < size; offset += n )
+    {
+        n = ( size - offset < sizeof( keyStream ) ) ? size - offset : sizeof( keyStream );
+
+        encryptBlock( &aesKey, feedback, keyStream );
+
+        for( i = 0; i < n; i++ )
+        {
+            if( decrypt )
+            {
+                cipherByte = data[offset + i];
+                data[offset + i] = cipherByte ^ keyStream[i];
+            }
+            else
+            {
+                cipherByte = data[offset + i] ^ keyStream[i];
+                data[offset + i] = cipherByte;
+            }
+            feedback[i] = cipherByte;
+        }
+    }
+
+    // Don't leave the key schedule behind on the stack.
+    memset( &aesKey, 0, sizeof( aesKey ) );
+    memset( keyStream, 0, sizeof( keyStream ) );
+
+    return TSS2_RC_SUCCESS;
+}
@@ -56,17 +56,17 @@ UINT32 LoadExternalHMACKey( TPMI_ALG_HASH hashAlg, TPM2B *key, TPM_HANDLE *keyHa
     inPublic.t.publicArea.parameters.keyedHashDetail.scheme.details.hmac.hashAlg = hashAlg;
     inPublic.t.publicArea.unique.keyedHash.t.size = 0;
 
-    sysContext = InitSysContext( 1000, resMgrTctiContext, &abiVersion );
+    sysContext = AcquireSysContext( 1000, resMgrTctiContext, &abiVersion );
     if( sysContext == 0 )
     {
-        TeardownSysContext( &sysContext );
+        ReleaseSysContext( &sysContext );
         return TSS2_APP_ERROR_LEVEL + TPM_RC_FAILURE;
     }
 
     INIT_SIMPLE_TPM2B_SIZE( *keyName );
     rval = Tss2_Sys_LoadExternal( sysContext, 0, &inPrivate, &inPublic, TPM_RH_NULL, keyHandle, keyName, 0 );
 
-    TeardownSysContext( &sysContext );
+    ReleaseSysContext( &sysContext );
 
     return rval;
 }
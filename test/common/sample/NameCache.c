@@ -0,0 +1,283 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Name cache for the handles used in cpHash and HMAC computation.
+//
+// TpmHandleToName reads the name from the TPM every time, which costs one
+// TPM2_ReadPublic or TPM2_NV_ReadPublic per handle per authorized command.
+// CachedHandleToName keeps names keyed by handle and only goes to the TPM
+// on a miss.  NV entries also keep the TPMS_NV_PUBLIC, so that when an
+// attribute that is part of the name changes (TPMA_NV_WRITTEN after the
+// first write, or the lock bits), the new name is computed locally instead
+// of being read back.
+//
+// The cache has to be told about commands that change or retire names;
+// call NameCacheUpdate after each command, or use NameCacheInvalidate
+// directly.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    TPM2B_NAME name;
+    TPMS_NV_PUBLIC nvPublic;        // Only used for NV indices.
+} NAME_CACHE_ENTRY;
+
+static HANDLE_TABLE nameTable = { 0, 0, 0 };
+static NAME_CACHE_STATS nameCacheStats = { 0, 0, 0 };
+
+//
+// Name of an NV index: nameAlg || H_nameAlg( marshalled TPMS_NV_PUBLIC ).
+//
+static UINT32 NvPublicToName( TPMS_NV_PUBLIC *nvPublic, TPM2B_NAME *name )
+{
+    UINT8 marshalled[sizeof( TPMS_NV_PUBLIC ) + sizeof( UINT16 )];
+    UINT8 *ptr = &marshalled[0];
+    TPM2B_DIGEST digest;
+    UINT32 rval;
+
+    *(UINT32 *)ptr = CHANGE_ENDIAN_DWORD( nvPublic->nvIndex );
+    ptr += sizeof( UINT32 );
+    *(UINT16 *)ptr = CHANGE_ENDIAN_WORD( nvPublic->nameAlg );
+    ptr += sizeof( UINT16 );
+    *(UINT32 *)ptr = CHANGE_ENDIAN_DWORD( *(UINT32 *)&nvPublic->attributes );
+    ptr += sizeof( UINT32 );
+    *(UINT16 *)ptr = CHANGE_ENDIAN_WORD( nvPublic->authPolicy.t.size );
+    ptr += sizeof( UINT16 );
+    memcpy( ptr, &nvPublic->authPolicy.t.buffer[0], nvPublic->authPolicy.t.size );
+    ptr += nvPublic->authPolicy.t.size;
+    *(UINT16 *)ptr = CHANGE_ENDIAN_WORD( nvPublic->dataSize );
+    ptr += sizeof( UINT16 );
+
+    INIT_SIMPLE_TPM2B_SIZE( digest );
+    rval = (*HashFunctionPtr)( nvPublic->nameAlg, (UINT16)( ptr - &marshalled[0] ), &marshalled[0], &digest );
+    if( rval != TPM_RC_SUCCESS )
+        return rval;
+
+    *(UINT16 *)&name->t.name[0] = CHANGE_ENDIAN_WORD( nvPublic->nameAlg );
+    memcpy( &name->t.name[sizeof( UINT16 )], &digest.t.buffer[0], digest.t.size );
+    name->t.size = sizeof( UINT16 ) + digest.t.size;
+
+    return TPM_RC_SUCCESS;
+}
+
+static UINT32 ReadName( TPM_HANDLE handle, NAME_CACHE_ENTRY *entry )
+{
+    TSS2_SYS_CONTEXT *sysContext;
+    TPM2B_NV_PUBLIC nvPublic;
+    UINT32 rval;
+
+    if( ( handle >> HR_SHIFT ) != TPM_HT_NV_INDEX )
+        return TpmHandleToName( handle, &entry->name );
+
+    sysContext = AcquireSysContext( 1000, resMgrTctiContext, &abiVersion );
+    if( sysContext == 0 )
+        return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
+
+    nvPublic.t.size = 0;
+    INIT_SIMPLE_TPM2B_SIZE( entry->name );
+    rval = Tss2_Sys_NV_ReadPublic( sysContext, handle, 0, &nvPublic, &entry->name, 0 );
+    ReleaseSysContext( &sysContext );
+
+    if( rval == TPM_RC_SUCCESS )
+        entry->nvPublic = nvPublic.t.nvPublic;
+
+    return rval;
+}
+
+//
+// Drop-in replacement for TpmHandleToName, e.g. as HandleToNameFunctionPtr.
+//
+UINT32 CachedHandleToName( TPM_HANDLE handle, TPM2B_NAME *name )
+{
+    NAME_CACHE_ENTRY *entry;
+    UINT32 rval;
+
+    switch( handle >> HR_SHIFT )
+    {
+        case TPM_HT_NV_INDEX:
+        case TPM_HT_TRANSIENT:
+        case TPM_HT_PERSISTENT:
+            break;
+
+        default:
+            // Name is the handle itself; nothing to save.
+            return TpmHandleToName( handle, name );
+    }
+
+    entry = (NAME_CACHE_ENTRY *)HandleTableFind( &nameTable, handle );
+    if( entry != 0 )
+    {
+        nameCacheStats.hits++;
+        CopySizedByteBuffer( &name->b, &entry->name.b );
+        return TPM_RC_SUCCESS;
+    }
+
+    nameCacheStats.misses++;
+
+    entry = (NAME_CACHE_ENTRY *)calloc( 1, sizeof( NAME_CACHE_ENTRY ) );
+    if( entry == 0 )
+        return TpmHandleToName( handle, name );
+
+    rval = ReadName( handle, entry );
+    if( rval == TPM_RC_SUCCESS )
+    {
+        CopySizedByteBuffer( &name->b, &entry->name.b );
+        if( HandleTableInsert( &nameTable, handle, entry, 0 ) == TPM_RC_SUCCESS )
+            return rval;
+    }
+    else
+    {
+        name->t.size = 0;
+    }
+
+    free( entry );
+    return rval;
+}
+
+void NameCacheInvalidate( TPM_HANDLE handle )
+{
+    free( HandleTableRemove( &nameTable, handle ) );
+}
+
+void NameCacheClear()
+{
+    HandleTableClear( &nameTable, free );
+}
+
+//
+// Sets attributes in a cached NV index's public area and recomputes its
+// name locally.  If the index isn't cached, or the new name can't be
+// computed, the entry is dropped and the next lookup reads it again.
+//
+void NameCacheSetNvAttributes( TPM_HANDLE nvIndex, UINT32 attributes )
+{
+    NAME_CACHE_ENTRY *entry;
+
+    entry = (NAME_CACHE_ENTRY *)HandleTableFind( &nameTable, nvIndex );
+    if( entry == 0 )
+        return;
+
+    if( ( *(UINT32 *)&entry->nvPublic.attributes & attributes ) == attributes )
+        return;
+
+    *(UINT32 *)&entry->nvPublic.attributes |= attributes;
+    if( NvPublicToName( &entry->nvPublic, &entry->name ) == TPM_RC_SUCCESS )
+        nameCacheStats.localNames++;
+    else
+        NameCacheInvalidate( nvIndex );
+}
+
+//
+// Command stream hook.  Call after a command completes, with the same
+// handle1 and handle2 passed to ComputeCommandHmacs / CheckResponseHMACs
+// (the command's first and second handles, TPM_HT_NO_HANDLE if absent).
+// The command code and any response handle are taken from sysContext.
+//
+void NameCacheUpdate( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDLE handle2,
+    TPM_RC responseCode )
+{
+    TPM_CC commandCode;
+    TPM_HANDLE responseHandle;
+
+    if( sysContext == 0 || responseCode != TPM_RC_SUCCESS )
+        return;
+
+    commandCode = CHANGE_ENDIAN_DWORD( SYS_CONTEXT->commandCodeSwapped );
+
+    switch( commandCode )
+    {
+        case TPM_CC_NV_Write:
+        case TPM_CC_NV_Increment:
+        case TPM_CC_NV_Extend:
+        case TPM_CC_NV_SetBits:
+            NameCacheSetNvAttributes( handle2, TPMA_NV_TPMA_NV_WRITTEN );
+            break;
+
+        case TPM_CC_NV_WriteLock:
+            NameCacheSetNvAttributes( handle2, TPMA_NV_TPMA_NV_WRITELOCKED );
+            break;
+
+        case TPM_CC_NV_ReadLock:
+            NameCacheSetNvAttributes( handle2, TPMA_NV_TPMA_NV_READLOCKED );
+            break;
+
+        case TPM_CC_NV_UndefineSpace:
+            NameCacheInvalidate( handle2 );
+            break;
+
+        case TPM_CC_NV_UndefineSpaceSpecial:
+            NameCacheInvalidate( handle1 );
+            break;
+
+        case TPM_CC_NV_GlobalWriteLock:
+            HandleTableRemoveType( &nameTable, TPM_HT_NV_INDEX, free );
+            break;
+
+        case TPM_CC_FlushContext:
+            // flushHandle is a parameter, not a handle, so drop every
+            // transient name; freed handles get reused by the next load.
+            HandleTableRemoveType( &nameTable, TPM_HT_TRANSIENT, free );
+            break;
+
+        case TPM_CC_EvictControl:
+            HandleTableRemoveType( &nameTable, TPM_HT_PERSISTENT, free );
+            break;
+
+        case TPM_CC_Startup:
+        case TPM_CC_Clear:
+            // Resets lock and written bits, and Clear removes owner
+            // objects and indices.
+            NameCacheClear();
+            break;
+
+        default:
+            if( GetNumResponseHandles( commandCode ) > 0 )
+            {
+                responseHandle = CHANGE_ENDIAN_DWORD(
+                        *(TPM_HANDLE *)( SYS_CONTEXT->tpmOutBuffPtr + sizeof( TPM20_Header_Out ) ) );
+                NameCacheInvalidate( responseHandle );
+            }
+    }
+}
+
+void NameCacheGetStats( NAME_CACHE_STATS *stats )
+{
+    *stats = nameCacheStats;
+}
+
+void NameCacheResetStats()
+{
+    nameCacheStats.hits = 0;
+    nameCacheStats.misses = 0;
+    nameCacheStats.localNames = 0;
+}
@@ -0,0 +1,259 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Streaming NV reads and writes.
+//
+// NV_Read and NV_Write move at most TPM_PT_NV_BUFFER_MAX bytes per
+// command.  NvStreamRead and NvStreamWrite take a region of any length (up
+// to the 64K offset range), split it into chunks of that size and move it
+// straight between the caller's buffer and the command/response buffers.
+//
+// The same authorization area (stream->cmdAuths) is used for every chunk.
+// When it doesn't change between commands (password authorizations), the
+// next chunk is marshalled in a second sys context while the TPM executes
+// the current one.  For HMAC sessions, set stream->chunkAuth: it is called
+// after each chunk is prepared (responseCode TPM_RC_NO_RESPONSE) and after
+// each response is received, and chunks are then sent one at a time.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include <string.h>
+
+#define NV_STREAM_CONTEXT_SIZE 4096
+
+void NvStreamTeardown( NV_STREAM *stream )
+{
+    ReleaseSysContext( &stream->sysContext[0] );
+    ReleaseSysContext( &stream->sysContext[1] );
+}
+
+//
+// Sets up the two sys contexts and reads TPM_PT_NV_BUFFER_MAX once; the
+// chunk size is the smaller of that and MAX_NV_BUFFER_SIZE.
+//
+TSS2_RC NvStreamInit( NV_STREAM *stream, TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_SYS_CMD_AUTHS *cmdAuths, TSS2_SYS_RSP_AUTHS *rspAuths )
+{
+    TSS2_RC rval;
+    TPMI_YES_NO moreData;
+    TPMS_CAPABILITY_DATA capabilityData;
+
+    if( stream == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    memset( stream, 0, sizeof( NV_STREAM ) );
+    stream->cmdAuths = cmdAuths;
+    stream->rspAuths = rspAuths;
+    stream->chunkSize = MAX_NV_BUFFER_SIZE;
+
+    stream->sysContext[0] = AcquireSysContext( NV_STREAM_CONTEXT_SIZE, tctiContext, &abiVersion );
+    stream->sysContext[1] = AcquireSysContext( NV_STREAM_CONTEXT_SIZE, tctiContext, &abiVersion );
+    if( stream->sysContext[0] == 0 || stream->sysContext[1] == 0 )
+    {
+        NvStreamTeardown( stream );
+        return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
+    }
+
+    rval = Tss2_Sys_GetCapability( stream->sysContext[0], 0, TPM_CAP_TPM_PROPERTIES,
+            TPM_PT_NV_BUFFER_MAX, 1, &moreData, &capabilityData, 0 );
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        NvStreamTeardown( stream );
+        return rval;
+    }
+
+    if( capabilityData.data.tpmProperties.count > 0 &&
+            capabilityData.data.tpmProperties.tpmProperty[0].property == TPM_PT_NV_BUFFER_MAX &&
+            capabilityData.data.tpmProperties.tpmProperty[0].value > 0 &&
+            capabilityData.data.tpmProperties.tpmProperty[0].value < stream->chunkSize )
+    {
+        stream->chunkSize = (UINT16)capabilityData.data.tpmProperties.tpmProperty[0].value;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC PrepareChunk( NV_STREAM *stream, TSS2_SYS_CONTEXT *sysContext, UINT8 write,
+    TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex, UINT16 offset, UINT8 *data, UINT16 size )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    TPM2B_MAX_NV_BUFFER nvData;
+
+    // Leave room for the authorization area so the chunk isn't moved
+    // again by SetCmdAuths.
+    if( stream->cmdAuths != 0 )
+        rval = Tss2_Sys_ReserveCmdAuths( sysContext, stream->cmdAuths );
+
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        if( write )
+        {
+            nvData.t.size = size;
+            memcpy( &nvData.t.buffer[0], data, size );
+            rval = Tss2_Sys_NV_Write_Prepare( sysContext, authHandle, nvIndex, &nvData, offset );
+        }
+        else
+        {
+            rval = Tss2_Sys_NV_Read_Prepare( sysContext, authHandle, nvIndex, size, offset );
+        }
+    }
+
+    if( rval == TSS2_RC_SUCCESS && stream->chunkAuth != 0 )
+        rval = ( *stream->chunkAuth )( stream, sysContext, authHandle, nvIndex, TPM_RC_NO_RESPONSE );
+
+    if( rval == TSS2_RC_SUCCESS && stream->cmdAuths != 0 )
+        rval = Tss2_Sys_SetCmdAuths( sysContext, stream->cmdAuths );
+
+    return rval;
+}
+
+static TSS2_RC FinishChunk( NV_STREAM *stream, TSS2_SYS_CONTEXT *sysContext, UINT8 write,
+    TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex, UINT8 *data, UINT16 size )
+{
+    TSS2_RC rval;
+    TSS2_SYS_BUFFER_VIEW view;
+
+    rval = Tss2_Sys_ExecuteFinish( sysContext, TSS2_TCTI_TIMEOUT_BLOCK );
+
+    if( rval == TSS2_RC_SUCCESS && stream->cmdAuths != 0 && stream->cmdAuths->cmdAuthsCount != 0 &&
+            stream->rspAuths != 0 )
+        rval = Tss2_Sys_GetRspAuths( sysContext, stream->rspAuths );
+
+    if( rval == TSS2_RC_SUCCESS && stream->chunkAuth != 0 )
+        rval = ( *stream->chunkAuth )( stream, sysContext, authHandle, nvIndex, TPM_RC_SUCCESS );
+
+    if( rval == TSS2_RC_SUCCESS )
+    {
+        if( write )
+        {
+            // NV_Write has no response parameters.
+            rval = CommonComplete( sysContext );
+        }
+        else
+        {
+            // Copy straight from the response buffer to the caller's.
+            rval = Tss2_Sys_NV_Read_CompleteView( sysContext, &view );
+            if( rval == TSS2_RC_SUCCESS )
+            {
+                if( view.size != size )
+                    rval = TSS2_SYS_RC_MALFORMED_RESPONSE;
+                else
+                    memcpy( data, view.buffer, size );
+            }
+        }
+    }
+
+    if( rval == TSS2_RC_SUCCESS )
+        stream->chunks++;
+
+    return rval;
+}
+
+static TSS2_RC NvStreamTransfer( NV_STREAM *stream, UINT8 write, TPMI_RH_NV_AUTH authHandle,
+    TPMI_RH_NV_INDEX nvIndex, UINT16 offset, UINT8 *data, UINT32 size )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS, finishRval;
+    TSS2_SYS_CONTEXT *sysContext, *pendingContext = 0;
+    UINT8 *pendingData = 0;
+    UINT16 pendingSize = 0, chunk;
+    UINT32 done = 0;
+    UINT8 pipeline, current = 0;
+
+    if( stream == 0 || stream->sysContext[0] == 0 || ( data == 0 && size != 0 ) )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    if( (UINT32)offset + size > 0x10000 )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+
+    pipeline = ( stream->chunkAuth == 0 && stream->sysContext[1] != 0 );
+
+    while( done < size )
+    {
+        chunk = (UINT16)( size - done < stream->chunkSize ? size - done : stream->chunkSize );
+        sysContext = stream->sysContext[current];
+
+        // Without pipelining the previous chunk has to complete before the
+        // next one is prepared (its authorization depends on the response).
+        if( !pipeline && pendingContext != 0 )
+        {
+            rval = FinishChunk( stream, pendingContext, write, authHandle, nvIndex, pendingData, pendingSize );
+            pendingContext = 0;
+            if( rval != TSS2_RC_SUCCESS )
+                break;
+        }
+
+        rval = PrepareChunk( stream, sysContext, write, authHandle, nvIndex,
+                (UINT16)( offset + done ), data + done, chunk );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        if( pendingContext != 0 )
+        {
+            rval = FinishChunk( stream, pendingContext, write, authHandle, nvIndex, pendingData, pendingSize );
+            pendingContext = 0;
+            if( rval != TSS2_RC_SUCCESS )
+                break;
+        }
+
+        rval = Tss2_Sys_ExecuteAsync( sysContext );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        pendingContext = sysContext;
+        pendingData = data + done;
+        pendingSize = chunk;
+        done += chunk;
+        if( pipeline )
+            current ^= 1;
+    }
+
+    // Always collect the response of a command that was sent, so the TCTI
+    // is ready for the next one.
+    if( pendingContext != 0 )
+    {
+        finishRval = FinishChunk( stream, pendingContext, write, authHandle, nvIndex, pendingData, pendingSize );
+        if( rval == TSS2_RC_SUCCESS )
+            rval = finishRval;
+    }
+
+    return rval;
+}
+
+TSS2_RC NvStreamRead( NV_STREAM *stream, TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex,
+    UINT16 offset, UINT8 *data, UINT32 size )
+{
+    return NvStreamTransfer( stream, 0, authHandle, nvIndex, offset, data, size );
+}
+
+TSS2_RC NvStreamWrite( NV_STREAM *stream, TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex,
+    UINT16 offset, const UINT8 *data, UINT32 size )
+{
+    return NvStreamTransfer( stream, 1, authHandle, nvIndex, offset, (UINT8 *)data, size );
+}
@@ -0,0 +1,436 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Consistent multi-bank PCR snapshots.
+//
+// PCR_Read returns at most eight digests per command, in bank order and,
+// within a bank, in PCR order.  PcrSnapshotTake takes the whole
+// bank/PCR selection wanted, splits it into as few PCR_Read commands as
+// that allows and sends them back to back: the next command is
+// marshalled in a second sys context while the TPM executes the current
+// one.
+//
+// All reads of a snapshot must report the same pcrUpdateCounter;
+// otherwise a PCR changed between them and the snapshot is taken again,
+// up to PCR_SNAPSHOT_MAX_TRIES times.  PCRs the TPM doesn't return (an
+// unallocated bank, for instance) are left out of the snapshot.
+//
+// The digests are stored back to back, bank by bank and in PCR order
+// within a bank; PcrSnapshotDigest finds one without searching.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include <string.h>
+
+#define PCR_SNAPSHOT_CONTEXT_SIZE 3000
+
+// Number of digests one PCR_Read can return.
+#define PCR_READ_MAX_DIGESTS ( sizeof( ( (TPML_DIGEST *)0 )->digests ) / sizeof( TPM2B_DIGEST ) )
+
+typedef struct {
+    TSS2_SYS_CONTEXT *sysContext[2];
+    PCR_SNAPSHOT *snapshot;
+    UINT32 wanted[HASH_COUNT];
+    UINT32 got[HASH_COUNT];
+    UINT8 counterValid;
+    UINT8 counterChanged;
+} PCR_READER;
+
+static UINT32 PcrMaskFromSelect( UINT8 sizeofSelect, const BYTE *pcrSelect )
+{
+    UINT32 mask = 0;
+    UINT8 i;
+
+    for( i = 0; i < sizeofSelect && i < PCR_SELECT_MAX; i++ )
+        mask |= (UINT32)pcrSelect[i] << ( i * 8 );
+
+    return mask;
+}
+
+static UINT32 CountBits( UINT32 mask )
+{
+    UINT32 count = 0;
+
+    for( ; mask != 0; mask &= mask - 1 )
+        count++;
+
+    return count;
+}
+
+// Digests are first stored in one slot per bank and PCR, and packed once
+// the snapshot is complete.
+static BYTE *SparseDigest( PCR_SNAPSHOT *snapshot, UINT32 bank, UINT32 pcr )
+{
+    return &snapshot->digests[( bank * IMPLEMENTATION_PCR + pcr ) * MAX_DIGEST_SIZE];
+}
+
+//
+// Adds pcrMask (bit n selects PCR n) for bank hash to selection, merging
+// with an existing entry for the same bank.
+//
+void PcrSelectionAdd( TPML_PCR_SELECTION *selection, TPMI_ALG_HASH hash, UINT32 pcrMask )
+{
+    UINT32 i;
+    UINT8 j;
+
+    for( i = 0; i < selection->count; i++ )
+    {
+        if( selection->pcrSelections[i].hash == hash )
+            break;
+    }
+
+    if( i == selection->count )
+    {
+        if( i == HASH_COUNT )
+            return;
+        selection->count++;
+        selection->pcrSelections[i].hash = hash;
+        selection->pcrSelections[i].sizeofSelect = PCR_SELECT_MAX;
+        memset( &selection->pcrSelections[i].pcrSelect[0], 0, PCR_SELECT_MAX );
+    }
+    else if( selection->pcrSelections[i].sizeofSelect < PCR_SELECT_MAX )
+    {
+        memset( &selection->pcrSelections[i].pcrSelect[selection->pcrSelections[i].sizeofSelect], 0,
+                PCR_SELECT_MAX - selection->pcrSelections[i].sizeofSelect );
+        selection->pcrSelections[i].sizeofSelect = PCR_SELECT_MAX;
+    }
+
+    for( j = 0; j < PCR_SELECT_MAX; j++ )
+        selection->pcrSelections[i].pcrSelect[j] |= (BYTE)( pcrMask >> ( j * 8 ) );
+}
+
+static INT32 FindBank( PCR_SNAPSHOT *snapshot, TPMI_ALG_HASH hash )
+{
+    UINT32 i;
+
+    for( i = 0; i < snapshot->bankCount; i++ )
+    {
+        if( snapshot->banks[i].hash == hash )
+            return (INT32)i;
+    }
+
+    return -1;
+}
+
+//
+// Builds the next PCR_Read selection: the first PCR_READ_MAX_DIGESTS
+// PCRs still in remaining, in the order the TPM returns them.
+//
+static void NextReadSelection( PCR_READER *reader, UINT32 *remaining, TPML_PCR_SELECTION *selection )
+{
+    UINT32 bank, pcr, count = 0;
+
+    selection->count = 0;
+    for( bank = 0; bank < reader->snapshot->bankCount && count < PCR_READ_MAX_DIGESTS; bank++ )
+    {
+        for( pcr = 0; pcr < IMPLEMENTATION_PCR && count < PCR_READ_MAX_DIGESTS; pcr++ )
+        {
+            if( remaining[bank] & ( 1u << pcr ) )
+            {
+                PcrSelectionAdd( selection, reader->snapshot->banks[bank].hash, 1u << pcr );
+                remaining[bank] &= ~( 1u << pcr );
+                count++;
+            }
+        }
+    }
+}
+
+static TSS2_RC FinishRead( PCR_READER *reader, TSS2_SYS_CONTEXT *sysContext )
+{
+    PCR_SNAPSHOT *snapshot = reader->snapshot;
+    TSS2_RC rval;
+    UINT32 pcrUpdateCounter, i, pcr, mask, next = 0;
+    TPML_PCR_SELECTION pcrSelectionOut;
+    TPML_DIGEST pcrValues;
+    INT32 bank;
+
+    rval = Tss2_Sys_ExecuteFinish( sysContext, TSS2_TCTI_TIMEOUT_BLOCK );
+    if( rval == TSS2_RC_SUCCESS )
+        rval = Tss2_Sys_PCR_Read_Complete( sysContext, &pcrUpdateCounter, &pcrSelectionOut, &pcrValues );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    snapshot->reads++;
+
+    if( !reader->counterValid )
+    {
+        snapshot->pcrUpdateCounter = pcrUpdateCounter;
+        reader->counterValid = 1;
+    }
+    else if( pcrUpdateCounter != snapshot->pcrUpdateCounter )
+    {
+        reader->counterChanged = 1;
+    }
+
+    // Digests come back in the order of pcrSelectionOut.
+    for( i = 0; i < pcrSelectionOut.count; i++ )
+    {
+        mask = PcrMaskFromSelect( pcrSelectionOut.pcrSelections[i].sizeofSelect,
+                &pcrSelectionOut.pcrSelections[i].pcrSelect[0] );
+        if( mask == 0 )
+            continue;
+
+        bank = FindBank( snapshot, pcrSelectionOut.pcrSelections[i].hash );
+        if( bank < 0 || ( mask & ~reader->wanted[bank] ) != 0 )
+            return TSS2_SYS_RC_MALFORMED_RESPONSE;
+
+        for( pcr = 0; pcr < IMPLEMENTATION_PCR; pcr++ )
+        {
+            if( !( mask & ( 1u << pcr ) ) )
+                continue;
+
+            if( next >= pcrValues.count ||
+                    pcrValues.digests[next].t.size != snapshot->banks[bank].digestSize )
+                return TSS2_SYS_RC_MALFORMED_RESPONSE;
+
+            memcpy( SparseDigest( snapshot, bank, pcr ), &pcrValues.digests[next].t.buffer[0],
+                    snapshot->banks[bank].digestSize );
+            next++;
+        }
+        reader->got[bank] |= mask;
+    }
+
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Reads every wanted PCR not read yet, pipelining the reads.
+//
+static TSS2_RC ReadPass( PCR_READER *reader )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS, finishRval;
+    TSS2_SYS_CONTEXT *sysContext, *pendingContext = 0;
+    TPML_PCR_SELECTION selection;
+    UINT32 remaining[HASH_COUNT];
+    UINT32 bank;
+    UINT8 current = 0;
+
+    for( bank = 0; bank < reader->snapshot->bankCount; bank++ )
+        remaining[bank] = reader->wanted[bank] & ~reader->got[bank];
+
+    for( ;; )
+    {
+        NextReadSelection( reader, &remaining[0], &selection );
+        if( selection.count == 0 )
+            break;
+
+        sysContext = reader->sysContext[current];
+        rval = Tss2_Sys_PCR_Read_Prepare( sysContext, &selection );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        if( pendingContext != 0 )
+        {
+            rval = FinishRead( reader, pendingContext );
+            pendingContext = 0;
+            if( rval != TSS2_RC_SUCCESS )
+                break;
+        }
+
+        rval = Tss2_Sys_ExecuteAsync( sysContext );
+        if( rval != TSS2_RC_SUCCESS )
+            break;
+
+        pendingContext = sysContext;
+        current ^= 1;
+    }
+
+    // Always collect the response of a command that was sent, so the TCTI
+    // is ready for the next one.
+    if( pendingContext != 0 )
+    {
+        finishRval = FinishRead( reader, pendingContext );
+        if( rval == TSS2_RC_SUCCESS )
+            rval = finishRval;
+    }
+
+    return rval;
+}
+
+//
+// One attempt at a snapshot.  PCRs the TPM left out of a response are
+// asked for again, until a pass returns nothing new.
+//
+static TSS2_RC ReadAll( PCR_READER *reader )
+{
+    TSS2_RC rval;
+    UINT32 bank, count = 0, lastCount;
+    UINT8 complete;
+
+    memset( &reader->got[0], 0, sizeof( reader->got ) );
+    reader->counterValid = 0;
+    reader->counterChanged = 0;
+
+    for( ;; )
+    {
+        rval = ReadPass( reader );
+        if( rval != TSS2_RC_SUCCESS || reader->counterChanged )
+            return rval;
+
+        lastCount = count;
+        count = 0;
+        complete = 1;
+        for( bank = 0; bank < reader->snapshot->bankCount; bank++ )
+        {
+            count += CountBits( reader->got[bank] );
+            if( reader->got[bank] != reader->wanted[bank] )
+                complete = 0;
+        }
+
+        if( complete || count == lastCount )
+            return TSS2_RC_SUCCESS;
+    }
+}
+
+// Moves the digests from their sparse slots to the packed layout.
+static void PackDigests( PCR_READER *reader )
+{
+    PCR_SNAPSHOT *snapshot = reader->snapshot;
+    UINT32 bank, pcr, offset = 0;
+    UINT16 digestSize;
+
+    for( bank = 0; bank < snapshot->bankCount; bank++ )
+    {
+        digestSize = snapshot->banks[bank].digestSize;
+        snapshot->banks[bank].pcrMask = reader->got[bank];
+        snapshot->banks[bank].offset = offset;
+
+        // The packed position never lies after the sparse one, so going
+        // forwards never overwrites a digest still to be moved.
+        for( pcr = 0; pcr < IMPLEMENTATION_PCR; pcr++ )
+        {
+            if( reader->got[bank] & ( 1u << pcr ) )
+            {
+                memmove( &snapshot->digests[offset], SparseDigest( snapshot, bank, pcr ), digestSize );
+                offset += digestSize;
+            }
+        }
+    }
+    snapshot->digestsSize = offset;
+}
+
+//
+// Reads the PCRs in selection into snapshot.  Returns
+// APPLICATION_ERROR( TSS2_BASE_RC_TRY_AGAIN ) if the PCRs kept changing
+// while they were read.
+//
+TSS2_RC PcrSnapshotTake( TSS2_TCTI_CONTEXT *tctiContext, TPML_PCR_SELECTION *selection, PCR_SNAPSHOT *snapshot )
+{
+    TSS2_RC rval = TSS2_RC_SUCCESS;
+    PCR_READER reader;
+    UINT32 i, attempt;
+    INT32 bank;
+
+    if( selection == 0 || snapshot == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    memset( snapshot, 0, sizeof( PCR_SNAPSHOT ) );
+    memset( &reader, 0, sizeof( reader ) );
+    reader.snapshot = snapshot;
+
+    if( selection->count > HASH_COUNT )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+
+    for( i = 0; i < selection->count; i++ )
+    {
+        bank = FindBank( snapshot, selection->pcrSelections[i].hash );
+        if( bank < 0 )
+        {
+            bank = (INT32)snapshot->bankCount;
+            snapshot->banks[bank].hash = selection->pcrSelections[i].hash;
+            snapshot->banks[bank].digestSize = GetDigestSize( selection->pcrSelections[i].hash );
+            if( snapshot->banks[bank].digestSize == 0 || snapshot->banks[bank].digestSize > MAX_DIGEST_SIZE )
+                return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+            snapshot->bankCount++;
+        }
+        reader.wanted[bank] |= PcrMaskFromSelect( selection->pcrSelections[i].sizeofSelect,
+                &selection->pcrSelections[i].pcrSelect[0] );
+    }
+
+    reader.sysContext[0] = AcquireSysContext( PCR_SNAPSHOT_CONTEXT_SIZE, tctiContext, &abiVersion );
+    reader.sysContext[1] = AcquireSysContext( PCR_SNAPSHOT_CONTEXT_SIZE, tctiContext, &abiVersion );
+    if( reader.sysContext[0] == 0 || reader.sysContext[1] == 0 )
+    {
+        rval = TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
+        goto exit;
+    }
+
+    for( attempt = 0; attempt < PCR_SNAPSHOT_MAX_TRIES; attempt++ )
+    {
+        if( attempt > 0 )
+            snapshot->retries++;
+
+        rval = ReadAll( &reader );
+        if( rval != TSS2_RC_SUCCESS || !reader.counterChanged )
+            break;
+    }
+
+    if( rval == TSS2_RC_SUCCESS && reader.counterChanged )
+        rval = APPLICATION_ERROR( TSS2_BASE_RC_TRY_AGAIN );
+
+    if( rval == TSS2_RC_SUCCESS )
+        PackDigests( &reader );
+
+exit:
+    if( rval != TSS2_RC_SUCCESS )
+    {
+        for( i = 0; i < snapshot->bankCount; i++ )
+            snapshot->banks[i].pcrMask = 0;
+    }
+
+    ReleaseSysContext( &reader.sysContext[0] );
+    ReleaseSysContext( &reader.sysContext[1] );
+
+    return rval;
+}
+
+//
+// Returns the digest of pcr in bank hash (digestSize bytes), or NULL if
+// the snapshot doesn't have it.
+//
+BYTE *PcrSnapshotDigest( PCR_SNAPSHOT *snapshot, TPMI_ALG_HASH hash, UINT32 pcr )
+{
+    INT32 bank;
+    PCR_SNAPSHOT_BANK *entry;
+
+    if( snapshot == 0 || pcr >= IMPLEMENTATION_PCR )
+        return 0;
+
+    bank = FindBank( snapshot, hash );
+    if( bank < 0 )
+        return 0;
+
+    entry = &snapshot->banks[bank];
+    if( !( entry->pcrMask & ( 1u << pcr ) ) )
+        return 0;
+
+    return &snapshot->digests[entry->offset +
+            CountBits( entry->pcrMask & ( ( 1u << pcr ) - 1 ) ) * entry->digestSize];
+}
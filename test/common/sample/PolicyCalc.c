@@ -0,0 +1,322 @@
+//**********************************************************************;
+// Copyright (c) 2015, Intel Corporation
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//**********************************************************************;
+
+//
+// Host-side policy digest calculator.
+//
+// Computes the policyDigest a trial session would end up with, without
+// talking to the TPM.  Each PolicyCalcXxx function applies the update of
+// the TPM2_PolicyXxx command, as specified in TPM 2.0 Part 3, to
+// policy->digest.  Hashing is done in-process with HostHash.
+//
+// Like a trial session, nothing is checked against TPM state: PCR values
+// must be supplied by the caller (see PolicyCalcPcrDigest), and PolicyOR
+// and PolicyAuthorize don't check that the current digest is one of the
+// branches or was approved.
+//
+
+#include <sapi/tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include <string.h>
+
+#define POLICY_CALC_BUFFER_SIZE 1024
+
+typedef struct {
+    BYTE buffer[POLICY_CALC_BUFFER_SIZE];
+    UINT32 size;
+    TSS2_RC rval;
+} POLICY_CALC_INPUT;
+
+static void AppendBytes( POLICY_CALC_INPUT *input, const BYTE *data, UINT32 size )
+{
+    if( input->rval != TSS2_RC_SUCCESS )
+        return;
+
+    if( size > POLICY_CALC_BUFFER_SIZE - input->size )
+    {
+        input->rval = APPLICATION_ERROR( TSS2_BASE_RC_INSUFFICIENT_BUFFER );
+        return;
+    }
+
+    memcpy( &input->buffer[input->size], data, size );
+    input->size += size;
+}
+
+static void AppendUint16( POLICY_CALC_INPUT *input, UINT16 value )
+{
+    BYTE bytes[2];
+
+    bytes[0] = (BYTE)( value >> 8 );
+    bytes[1] = (BYTE)value;
+    AppendBytes( input, bytes, 2 );
+}
+
+static void AppendUint32( POLICY_CALC_INPUT *input, UINT32 value )
+{
+    AppendUint16( input, (UINT16)( value >> 16 ) );
+    AppendUint16( input, (UINT16)value );
+}
+
+// Starts the hash input for policyDigest new := H( policyDigest old || code || ... ).
+static void StartUpdate( POLICY_CALC *policy, POLICY_CALC_INPUT *input, TPM_CC commandCode )
+{
+    input->size = 0;
+    input->rval = TSS2_RC_SUCCESS;
+    AppendBytes( input, &policy->digest.t.buffer[0], policy->digest.t.size );
+    AppendUint32( input, commandCode );
+}
+
+static TSS2_RC HashInput( TPMI_ALG_HASH hashAlg, POLICY_CALC_INPUT *input, TPM2B_DIGEST *result )
+{
+    if( input->rval != TSS2_RC_SUCCESS )
+        return input->rval;
+
+    INIT_SIMPLE_TPM2B_SIZE( *result );
+    return HostHash( hashAlg, (UINT16)input->size, &input->buffer[0], result );
+}
+
+static TSS2_RC FinishUpdate( POLICY_CALC *policy, POLICY_CALC_INPUT *input )
+{
+    return HashInput( policy->hashAlg, input, &policy->digest );
+}
+
+//
+// PolicyUpdate() from Part 3: the digest is extended with the command
+// code and a name, then separately with policyRef.
+//
+static TSS2_RC PolicyUpdate( POLICY_CALC *policy, TPM_CC commandCode, TPM2B_NAME *name, TPM2B_NONCE *policyRef )
+{
+    POLICY_CALC_INPUT input;
+    TSS2_RC rval;
+
+    StartUpdate( policy, &input, commandCode );
+    AppendBytes( &input, &name->t.name[0], name->t.size );
+    rval = FinishUpdate( policy, &input );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    input.size = 0;
+    AppendBytes( &input, &policy->digest.t.buffer[0], policy->digest.t.size );
+    if( policyRef != 0 )
+        AppendBytes( &input, &policyRef->t.buffer[0], policyRef->t.size );
+
+    return FinishUpdate( policy, &input );
+}
+
+//
+// Starts a policy for a session with authHash hashAlg; the digest is all
+// zeros, as in a new session.
+//
+TSS2_RC PolicyCalcInit( POLICY_CALC *policy, TPMI_ALG_HASH hashAlg )
+{
+    UINT16 digestSize;
+
+    if( policy == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    digestSize = GetDigestSize( hashAlg );
+    if( digestSize == 0 )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+
+    policy->hashAlg = hashAlg;
+    policy->digest.t.size = digestSize;
+    memset( &policy->digest.t.buffer[0], 0, digestSize );
+
+    return TSS2_RC_SUCCESS;
+}
+
+//
+// Computes the pcrDigest argument of PolicyPCR: the hash of the PCR
+// values, concatenated in the order PCR_Read returns them.
+//
+TSS2_RC PolicyCalcPcrDigest( TPMI_ALG_HASH hashAlg, TPML_DIGEST *pcrValues, TPM2B_DIGEST *pcrDigest )
+{
+    POLICY_CALC_INPUT input;
+    UINT32 i;
+
+    if( pcrValues == 0 || pcrDigest == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    input.size = 0;
+    input.rval = TSS2_RC_SUCCESS;
+    for( i = 0; i < pcrValues->count; i++ )
+        AppendBytes( &input, &pcrValues->digests[i].t.buffer[0], pcrValues->digests[i].t.size );
+
+    return HashInput( hashAlg, &input, pcrDigest );
+}
+
+TSS2_RC PolicyCalcPCR( POLICY_CALC *policy, TPM2B_DIGEST *pcrDigest, TPML_PCR_SELECTION *pcrs )
+{
+    POLICY_CALC_INPUT input;
+    UINT32 i;
+
+    if( policy == 0 || pcrDigest == 0 || pcrs == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    // A trial session would read the PCRs itself; offline they have to be
+    // given.
+    if( pcrDigest->t.size == 0 || pcrs->count > HASH_COUNT )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+
+    StartUpdate( policy, &input, TPM_CC_PolicyPCR );
+    AppendUint32( &input, pcrs->count );
+    for( i = 0; i < pcrs->count; i++ )
+    {
+        if( pcrs->pcrSelections[i].sizeofSelect > PCR_SELECT_MAX )
+            return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+        AppendUint16( &input, pcrs->pcrSelections[i].hash );
+        AppendBytes( &input, &pcrs->pcrSelections[i].sizeofSelect, 1 );
+        AppendBytes( &input, &pcrs->pcrSelections[i].pcrSelect[0], pcrs->pcrSelections[i].sizeofSelect );
+    }
+    AppendBytes( &input, &pcrDigest->t.buffer[0], pcrDigest->t.size );
+
+    return FinishUpdate( policy, &input );
+}
+
+TSS2_RC PolicyCalcCommandCode( POLICY_CALC *policy, TPM_CC code )
+{
+    POLICY_CALC_INPUT input;
+
+    if( policy == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    StartUpdate( policy, &input, TPM_CC_PolicyCommandCode );
+    AppendUint32( &input, code );
+
+    return FinishUpdate( policy, &input );
+}
+
+TSS2_RC PolicyCalcAuthValue( POLICY_CALC *policy )
+{
+    POLICY_CALC_INPUT input;
+
+    if( policy == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    StartUpdate( policy, &input, TPM_CC_PolicyAuthValue );
+
+    return FinishUpdate( policy, &input );
+}
+
+//
+// PolicyPassword deliberately extends the digest with
+// TPM_CC_PolicyAuthValue, so the two give the same policy.
+//
+TSS2_RC PolicyCalcPassword( POLICY_CALC *policy )
+{
+    return PolicyCalcAuthValue( policy );
+}
+
+TSS2_RC PolicyCalcOR( POLICY_CALC *policy, TPML_DIGEST *pHashList )
+{
+    POLICY_CALC_INPUT input;
+    UINT32 i;
+
+    if( policy == 0 || pHashList == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    if( pHashList->count < 2 || pHashList->count > 8 )
+        return APPLICATION_ERROR( TSS2_BASE_RC_BAD_VALUE );
+
+    // The digest is reset before it is extended with the branches.
+    memset( &policy->digest.t.buffer[0], 0, policy->digest.t.size );
+    StartUpdate( policy, &input, TPM_CC_PolicyOR );
+    for( i = 0; i < pHashList->count; i++ )
+        AppendBytes( &input, &pHashList->digests[i].t.buffer[0], pHashList->digests[i].t.size );
+
+    return FinishUpdate( policy, &input );
+}
+
+TSS2_RC PolicyCalcLocality( POLICY_CALC *policy, TPMA_LOCALITY locality )
+{
+    POLICY_CALC_INPUT input;
+
+    if( policy == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    StartUpdate( policy, &input, TPM_CC_PolicyLocality );
+    AppendBytes( &input, (BYTE *)&locality, 1 );
+
+    return FinishUpdate( policy, &input );
+}
+
+//
+// nvIndexName is the Name of the NV index.  The comparison arguments are
+// folded into args = H( operandB || offset || operation ) first.
+//
+TSS2_RC PolicyCalcNV( POLICY_CALC *policy, TPM2B_NAME *nvIndexName, TPM2B_OPERAND *operandB,
+    UINT16 offset, TPM_EO operation )
+{
+    POLICY_CALC_INPUT input;
+    TPM2B_DIGEST args;
+    TSS2_RC rval;
+
+    if( policy == 0 || nvIndexName == 0 || operandB == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    input.size = 0;
+    input.rval = TSS2_RC_SUCCESS;
+    AppendBytes( &input, &operandB->t.buffer[0], operandB->t.size );
+    AppendUint16( &input, offset );
+    AppendUint16( &input, operation );
+    rval = HashInput( policy->hashAlg, &input, &args );
+    if( rval != TSS2_RC_SUCCESS )
+        return rval;
+
+    StartUpdate( policy, &input, TPM_CC_PolicyNV );
+    AppendBytes( &input, &args.t.buffer[0], args.t.size );
+    AppendBytes( &input, &nvIndexName->t.name[0], nvIndexName->t.size );
+
+    return FinishUpdate( policy, &input );
+}
+
+//
+// authObjectName is the Name of the entity whose authorization is
+// required; policyRef may be NULL.
+//
+TSS2_RC PolicyCalcSecret( POLICY_CALC *policy, TPM2B_NAME *authObjectName, TPM2B_NONCE *policyRef )
+{
+    if( policy == 0 || authObjectName == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    return PolicyUpdate( policy, TPM_CC_PolicySecret, authObjectName, policyRef );
+}
+
+//
+// keySignName is the Name of the key that signs approved policies; the
+// digest is reset first, so anything before PolicyAuthorize is dropped.
+//
+TSS2_RC PolicyCalcAuthorize( POLICY_CALC *policy, TPM2B_NAME *keySignName, TPM2B_NONCE *policyRef )
+{
+    if( policy == 0 || keySignName == 0 )
+        return TSS2_APP_RC_BAD_REFERENCE;
+
+    memset( &policy->digest.t.buffer[0], 0, policy->digest.t.size );
+
+    return PolicyUpdate( policy, TPM_CC_PolicyAuthorize, keySignName, policyRef );
+}
@@ -32,33 +32,24 @@
 
 #define SESSIONS_ARRAY_COUNT MAX_NUM_SESSIONS+1
 
-typedef struct _SESSION_LIST_ENTRY *SESSION_LIST_ENTRY_PTR;
-
-typedef struct _SESSION_LIST_ENTRY{
-    SESSION session;
-    SESSION_LIST_ENTRY_PTR nextEntry;
-} SESSION_LIST_ENTRY;
-
-SESSION_LIST_ENTRY *sessionsList = 0;
+//
+// Started sessions are kept in a hash table keyed by session handle, so
+// the per-command lookups done while computing and checking HMACs don't
+// depend on how many sessions are open.  A session only goes into the
+// table once StartAuthSession has given it a handle.
+//
+static HANDLE_TABLE sessionTable = { 0, 0, 0 };
 INT16 sessionEntriesUsed = 0;
 
 
-TPM_RC AddSession( SESSION_LIST_ENTRY **sessionEntry )
+TPM_RC AddSession( SESSION **session )
 {
-    SESSION_LIST_ENTRY **lastEntry, *newEntry;
-
 //    DebugPrintf( 0, "In AddSession\n" );
 
-    // find end of list.
-    for( lastEntry = &sessionsList; *lastEntry != 0; lastEntry = &( (SESSION_LIST_ENTRY *)*lastEntry)->nextEntry )
-        ;
-
     // allocate space for session structure.
-    newEntry = (SESSION_LIST_ENTRY *)malloc( sizeof( SESSION_LIST_ENTRY ) );
-    if( newEntry != 0 )
+    *session = (SESSION *)calloc( 1, sizeof( SESSION ) );
+    if( *session != 0 )
     {
-        *sessionEntry = *lastEntry = newEntry;
-        newEntry->nextEntry = 0;
         sessionEntriesUsed++;
         return TPM_RC_SUCCESS;
     }
@@ -71,39 +62,32 @@ TPM_RC AddSession( SESSION_LIST_ENTRY **sessionEntry )
 
 void DeleteSession( SESSION *session )
 {
-    SESSION_LIST_ENTRY *predSession;
-    SESSION_LIST_ENTRY *newNextEntry;
-
 //    DebugPrintf( 0, "In DeleteSession\n" );
 
-    if( session == &sessionsList->session )
-        sessionsList = 0;
-    else
-    {
-        // Find predecessor.
-        for( predSession = sessionsList;
-                predSession != 0 && &( ( ( SESSION_LIST_ENTRY *)predSession->nextEntry )->session ) != session;
-                predSession = predSession->nextEntry )
-            ;
+    if( session == 0 )
+        return;
 
-        if( predSession != 0 )
-        {
-            sessionEntriesUsed--;
+    // Only remove the table entry if it is this session; one that failed
+    // to start may carry a stale handle.
+    if( HandleTableFind( &sessionTable, session->sessionHandle ) == session )
+        HandleTableRemove( &sessionTable, session->sessionHandle );
 
-            newNextEntry = ( (SESSION_LIST_ENTRY *)predSession->nextEntry)->nextEntry;
+    sessionEntriesUsed--;
+    free( session );
+}
 
-            free( predSession->nextEntry );
 
-            predSession->nextEntry = newNextEntry;
-        }
-    }
+void InitSessionsTable()
+{
+    HandleTableClear( &sessionTable, free );
+    sessionEntriesUsed = 0;
 }
 
 
 TPM_RC GetSessionStruct( TPMI_SH_AUTH_SESSION sessionHandle, SESSION **session )
 {
     TPM_RC rval = TSS2_APP_RC_GET_SESSION_STRUCT_FAILED;
-    SESSION_LIST_ENTRY *sessionEntry;
+    SESSION *found;
 
     DebugPrintf( 0, "In GetSessionStruct\n" );
 
@@ -112,14 +96,10 @@ TPM_RC GetSessionStruct( TPMI_SH_AUTH_SESSION sessionHandle, SESSION **session )
         //
         // Get pointer to session structure using the sessionHandle
         //
-        for( sessionEntry = sessionsList;
-                sessionEntry != 0 && sessionEntry->session.sessionHandle != sessionHandle;
-                sessionEntry = sessionEntry->nextEntry )
-            ;
-
-        if( sessionEntry != 0 )
+        found = (SESSION *)HandleTableFind( &sessionTable, sessionHandle );
+        if( found != 0 )
         {
-            *session = &sessionEntry->session;
+            *session = found;
             rval = TSS2_RC_SUCCESS;
         }
     }
@@ -167,7 +147,7 @@ TPM_RC StartAuthSession( SESSION *session, TSS2_TCTI_CONTEXT *tctiContext )
 
     key.t.size = 0;
 
-    tmpSysContext = InitSysContext( 1000, tctiContext, &abiVersion );
+    tmpSysContext = AcquireSysContext( 1000, tctiContext, &abiVersion );
     if( tmpSysContext == 0 )
         return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
 
@@ -201,14 +181,14 @@ TPM_RC StartAuthSession( SESSION *session, TSS2_TCTI_CONTEXT *tctiContext )
             rval = ConcatSizedByteBuffer( (TPM2B_MAX_BUFFER *)&key, &( session->authValueBind.b ) );
             if( rval != TPM_RC_SUCCESS )
             {
-                TeardownSysContext( &tmpSysContext );
+                ReleaseSysContext( &tmpSysContext );
                 return(  rval );
             }
 
             rval = ConcatSizedByteBuffer( (TPM2B_MAX_BUFFER *)&key, &( session->salt.b ) );
             if( rval != TPM_RC_SUCCESS )
             {
-                TeardownSysContext( &tmpSysContext );
+                ReleaseSysContext( &tmpSysContext );
                 return( rval );
             }
 
@@ -226,7 +206,7 @@ TPM_RC StartAuthSession( SESSION *session, TSS2_TCTI_CONTEXT *tctiContext )
 
             if( rval != TPM_RC_SUCCESS )
             {
-                TeardownSysContext( &tmpSysContext );
+                ReleaseSysContext( &tmpSysContext );
                 return( TSS2_APP_RC_CREATE_SESSION_KEY_FAILED );
             }
         }
@@ -236,7 +216,7 @@ TPM_RC StartAuthSession( SESSION *session, TSS2_TCTI_CONTEXT *tctiContext )
         session->nvNameChanged = 0;
     }
 
-    TeardownSysContext( &tmpSysContext );
+    ReleaseSysContext( &tmpSysContext );
 
     return rval;
 }
@@ -258,12 +238,10 @@ TPM_RC StartAuthSessionWithParams( SESSION **session,
     TSS2_TCTI_CONTEXT *tctiContext )
 {
     TPM_RC rval;
-    SESSION_LIST_ENTRY *sessionEntry;
 
-    rval = AddSession( &sessionEntry );
+    rval = AddSession( session );
     if( rval == TSS2_RC_SUCCESS )
     {
-        *session = &sessionEntry->session;
 
         // Copy handles to session struct.
         (*session)->bind = bind;
@@ -310,15 +288,16 @@ TPM_RC StartAuthSessionWithParams( SESSION **session,
             (*session)->authValueBind.t.size = 0;
 
         rval = StartAuthSession( *session, tctiContext );
+        if( rval == TSS2_RC_SUCCESS )
+        {
+            rval = HandleTableInsert( &sessionTable, (*session)->sessionHandle, *session, 0 );
+        }
+
         if( rval != TSS2_RC_SUCCESS )
         {
             DeleteSession( *session );
         }
     }
-    else
-    {
-        DeleteSession( *session );
-    }
     return( rval );
 }
 
@@ -29,6 +29,7 @@
 #include "sample.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "sysapi_util.h"
 
 //
@@ -44,7 +45,12 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
     UINT32 i;
     TPM2B_NAME name1;
     TPM2B_NAME name2;
-    TPM2B_MAX_BUFFER hashInput; // Byte stream to be hashed to create pHash
+    // Byte stream to be hashed to create pHash: the response code, command
+    // code, names and up to a whole command's worth of parameters.
+    struct {
+        UINT16 size;
+        BYTE buffer[2 * sizeof( UINT32 ) + 2 * sizeof( TPMU_NAME ) + MAX_COMMAND_SIZE];
+    } hashInput;
     UINT8 *hashInputPtr;
     size_t parametersSize;
     const uint8_t *startParams;
@@ -66,7 +72,7 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
         else
         {
             // Get names for the handles
-            rval = TpmHandleToName( handle1, &name1 );
+            rval = (*HandleToNameFunctionPtr)( handle1, &name1 );
             if( rval != TPM_RC_SUCCESS )
                 return rval;
         }
@@ -90,7 +96,7 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
         }
         else
         {
-            rval = TpmHandleToName( handle2, &name2 );
+            rval = (*HandleToNameFunctionPtr)( handle2, &name2 );
             if( rval != TPM_RC_SUCCESS )
                 return rval;
         }
@@ -108,12 +114,12 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
 #endif
 
     // Create pHash input byte stream:  first add response code, if any.
-    hashInput.b.size = 0;
+    hashInput.size = 0;
     if( responseCode != TPM_RC_NO_RESPONSE )
     {
-        hashInputPtr = &( hashInput.t.buffer[hashInput.b.size] );
+        hashInputPtr = &( hashInput.buffer[hashInput.size] );
         *(UINT32 *)hashInputPtr = CHANGE_ENDIAN_DWORD( responseCode );
-        hashInput.b.size += 4;
+        hashInput.size += 4;
         hashInputPtr += 4;
     }
 
@@ -122,25 +128,22 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
     if( rval != TPM_RC_SUCCESS )
         return rval;
 
-    hashInputPtr = &( hashInput.t.buffer[hashInput.b.size] );
+    hashInputPtr = &( hashInput.buffer[hashInput.size] );
     *(UINT32 *)hashInputPtr = CHANGE_ENDIAN_DWORD( *(UINT32 *)cmdCodePtr );
-    hashInput.t.size += 4;
+    hashInput.size += 4;
 
     // Create pHash input byte stream:  now add in names for the handles.
-    rval = ConcatSizedByteBuffer( &hashInput, &( name1.b ) );
-    if( rval != TPM_RC_SUCCESS )
-        return rval;
-
-    rval = ConcatSizedByteBuffer( &hashInput, &( name2.b ) );
-    if( rval != TPM_RC_SUCCESS )
-        return rval;
+    memcpy( &hashInput.buffer[hashInput.size], name1.t.name, name1.t.size );
+    hashInput.size += name1.t.size;
+    memcpy( &hashInput.buffer[hashInput.size], name2.t.name, name2.t.size );
+    hashInput.size += name2.t.size;
 
-    if( ( hashInput.t.size + parametersSize ) <= sizeof( hashInput.t.buffer ) )
+    if( ( hashInput.size + parametersSize ) <= sizeof( hashInput.buffer ) )
     {
         // Create pHash input byte stream:  now add in parameters byte stream
         for( i = 0; i < parametersSize; i++ )
-            hashInput.t.buffer[hashInput.t.size + i ] = startParams[i];
-        hashInput.t.size += (UINT16)parametersSize;
+            hashInput.buffer[hashInput.size + i ] = startParams[i];
+        hashInput.size += (UINT16)parametersSize;
     }
     else
     {
@@ -149,17 +152,17 @@ TPM_RC TpmCalcPHash( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDL
     }
 #ifdef DEBUG
     DebugPrintf( 0, "\n\nPHASH input bytes= \n" );
-    PrintSizedBuffer( &(hashInput.b) );
+    PrintSizedBuffer( (TPM2B *)&hashInput );
 #endif
 
     // Now hash the whole mess.
-    if( hashInput.t.size > sizeof( hashInput.t.buffer ) )
+    if( hashInput.size > sizeof( hashInput.buffer ) )
     {
         rval = APPLICATION_ERROR( TSS2_BASE_RC_INSUFFICIENT_BUFFER );
     }
     else
     {
-        rval = TpmHash( authHash, hashInput.t.size, &( hashInput.t.buffer[0] ), pHash );
+        rval = (*HashFunctionPtr)( authHash, hashInput.size, &( hashInput.buffer[0] ), pHash );
         if( rval != TPM_RC_SUCCESS )
             return rval;
 #ifdef DEBUG
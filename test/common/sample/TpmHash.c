@@ -43,75 +43,45 @@ UINT32 TpmHash( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *re
     for( i = 0; i < size; i++ )
         dataSizedBuffer.t.buffer[i] = data[i];
 
-    sysContext = InitSysContext( 3000, resMgrTctiContext, &abiVersion );
+    sysContext = AcquireSysContext( 3000, resMgrTctiContext, &abiVersion );
     if( sysContext == 0 )
         return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
 
     INIT_SIMPLE_TPM2B_SIZE( *result );
     rval = Tss2_Sys_Hash ( sysContext, 0, &dataSizedBuffer, hashAlg, TPM_RH_NULL, result, 0, 0);
 
-    TeardownSysContext( &sysContext );
+    ReleaseSysContext( &sysContext );
 
     return rval;
 }
 
 
 //
-// This function does a hash on an array of data strings.
+// This function does a hash on an array of data strings.  The strings are
+// gathered into full chunks, so short strings don't cost a command each.
 //
 UINT32 TpmHashSequence( TPMI_ALG_HASH hashAlg, UINT8 numBuffers, TPM2B_DIGEST *bufferList, TPM2B_DIGEST *result )
 {
     UINT32 rval;
-    TSS2_SYS_CONTEXT *sysContext;
-    TPM2B_AUTH nullAuth;
-    TPMI_DH_OBJECT sequenceHandle;
+    HASH_STREAM stream;
     int i;
-    TPM2B emptyBuffer;
-    TPMT_TK_HASHCHECK validation;
-
-    TPMS_AUTH_COMMAND cmdAuth;
-    TPMS_AUTH_COMMAND *cmdSessionArray[1] = { &cmdAuth };
-    TSS2_SYS_CMD_AUTHS cmdAuthArray = { 1, &cmdSessionArray[0] };
-
-    nullAuth.t.size = 0;
-    emptyBuffer.size = 0;
 
     // Set result size to 0, in case any errors occur
     result->b.size = 0;
 
-    // Init input sessions struct
-    cmdAuth.sessionHandle = TPM_RS_PW;
-    cmdAuth.nonce.t.size = 0;
-    *( (UINT8 *)((void *)&cmdAuth.sessionAttributes ) ) = 0;
-    cmdAuth.hmac.t.size = 0;
-
-    sysContext = InitSysContext( 3000, resMgrTctiContext, &abiVersion );
-    if( sysContext == 0 )
-        return TSS2_APP_RC_INIT_SYS_CONTEXT_FAILED;
-
-    rval = Tss2_Sys_HashSequenceStart( sysContext, 0, &nullAuth, hashAlg, &sequenceHandle, 0 );
-
+    rval = HashStreamStart( &stream, resMgrTctiContext, hashAlg, TPM_RH_NULL, 0 );
     if( rval != TPM_RC_SUCCESS )
         return( rval );
 
     for( i = 0; i < numBuffers; i++ )
     {
-        rval = Tss2_Sys_SequenceUpdate ( sysContext, sequenceHandle, &cmdAuthArray, (TPM2B_MAX_BUFFER *)&bufferList[i], 0 );
-
+        rval = HashStreamUpdate( &stream, bufferList[i].t.buffer, bufferList[i].t.size );
         if( rval != TPM_RC_SUCCESS )
+        {
+            HashStreamAbort( &stream );
             return( rval );
+        }
     }
 
-    INIT_SIMPLE_TPM2B_SIZE( *result );
-    rval = Tss2_Sys_SequenceComplete ( sysContext, sequenceHandle, &cmdAuthArray, ( TPM2B_MAX_BUFFER *)&emptyBuffer,
-            TPM_RH_PLATFORM, result, &validation, 0 );
-
-    if( rval != TPM_RC_SUCCESS )
-        return( rval );
-
-    TeardownSysContext( &sysContext );
-
-    return rval;
-
+    return HashStreamComplete( &stream, TPM_RH_PLATFORM, result, 0 );
 }
-
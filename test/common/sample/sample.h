@@ -85,7 +85,6 @@ enum TSS2_APP_RC_CODE
 #define TPM_RC_NO_RESPONSE 0xffffffff
 
 #define MAX_NUM_SESSIONS MAX_ACTIVE_SESSIONS
-#define MAX_NUM_ENTITIES 100
 
 #define APPLICATION_ERROR( errCode ) \
     ( TSS2_APP_ERROR_LEVEL + errCode )
@@ -136,7 +135,10 @@ typedef struct {
 
 //
 // Structure used to maintain entity data.  Right now it just
-// consists of handles/authValue pairs.
+// consists of handles/authValue pairs.  Upper layer code saves and
+// updates these (authValue, specifically) at creation and use time
+// through AddEntity, GetEntity and DeleteEntity; there is no limit on
+// the number of entities.
 //
 typedef struct{
     TPM_HANDLE entityHandle;
@@ -144,11 +146,33 @@ typedef struct{
     UINT8 nvNameChanged;
 } ENTITY;
 
+//
+// Hash table from TPM handle to a caller-owned pointer; see HandleTable.c.
+// A zero-initialized HANDLE_TABLE is empty and ready to use.
+//
+typedef struct {
+    TPM_HANDLE handle;
+    void *value;                    // NULL marks a free slot.
+} HANDLE_TABLE_ENTRY;
+
+typedef struct {
+    HANDLE_TABLE_ENTRY *entries;
+    UINT32 capacity;                // Always 0 or a power of two.
+    UINT32 count;
+} HANDLE_TABLE;
+
+TPM_RC HandleTableInsert( HANDLE_TABLE *table, TPM_HANDLE handle, void *value, void **oldValue );
+void *HandleTableFind( HANDLE_TABLE *table, TPM_HANDLE handle );
+void *HandleTableRemove( HANDLE_TABLE *table, TPM_HANDLE handle );
+void HandleTableRemoveType( HANDLE_TABLE *table, UINT8 handleType, void ( *freeValue )( void *value ) );
+void HandleTableClear( HANDLE_TABLE *table, void ( *freeValue )( void *value ) );
+
 void InitEntities();
 TPM_RC AddEntity( TPM_HANDLE entityHandle, TPM2B_AUTH *auth );
 TPM_RC DeleteEntity( TPM_HANDLE entityHandle );
 TPM_RC GetEntityAuth( TPM_HANDLE entityHandle, TPM2B_AUTH *auth );
 TPM_RC GetEntity( TPM_HANDLE entityHandle, ENTITY **entity );
+UINT32 GetEntityCount();
 TPM_RC GetSessionStruct( TPMI_SH_AUTH_SESSION authHandle, SESSION **pSession );
 TPM_RC GetSessionAlgId( TPMI_SH_AUTH_SESSION authHandle, TPMI_ALG_HASH *sessionAlgId );
 TPM_RC EndAuthSession( SESSION *session );
@@ -185,16 +209,6 @@ TPM_RC StartAuthSessionWithParams( SESSION **session, TPMI_DH_OBJECT tpmKey, TPM
     TPMI_DH_ENTITY bind, TPM2B_AUTH *bindAuth, TPM2B_NONCE *nonceCaller, TPM2B_ENCRYPTED_SECRET *encryptedSalt,
     TPM_SE sessionType, TPMT_SYM_DEF *symmetric, TPMI_ALG_HASH algId, TSS2_TCTI_CONTEXT *tctiContext );
 
-//
-// Used by upper layer code to save and update entity data
-// (authValue, specifically) at creation and use time.
-//
-// NOTE: this really needs to be turned into a linked list
-// with add, find, and remove entries, instead of a fixed
-// length array.
-//
-ENTITY entities[MAX_NUM_ENTITIES+1];
-
 //
 // This function calculates the session HMAC
 //
@@ -300,6 +314,24 @@ TSS2_RC EncryptCommandParam( SESSION *session, TPM2B_MAX_BUFFER *encryptedData,
 
 TSS2_RC DecryptResponseParam( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue );
 
+TSS2_RC EncryptCFB( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue );
+
+TSS2_RC DecryptCFB( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue );
+
+TSS2_RC HostEncryptCFB( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue );
+
+TSS2_RC HostDecryptCFB( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue );
+
+//
+// Pointers to the CFB functions used by EncryptCommandParam and
+// DecryptResponseParam for AES sessions.  EncryptCFB/DecryptCFB do the
+// work on the TPM (LoadExternal, EncryptDecrypt, FlushContext);
+// HostEncryptCFB/HostDecryptCFB do it in-process.
+//
+extern TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue );
+
+extern TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue );
+
 TPM_RC KDFa( TPMI_ALG_HASH hashAlg, TPM2B *key, char *label, TPM2B *contextU, TPM2B *contextV,
     UINT16 bits, TPM2B_MAX_BUFFER *resultKey );
 
@@ -315,8 +347,138 @@ TPM_RC TpmHmac( TPMI_ALG_HASH hashAlg, TPM2B *key,TPM2B **bufferList, TPM2B_DIGE
 
 UINT32 TpmHash( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result );
 
+//
+// Host-side software versions of TpmHash and TpmHmac; these can be assigned
+// to HashFunctionPtr and HmacFunctionPtr to avoid the TPM round trips.
+// HostAesCfb does AES-CFB in place on data.
+// HostCryptoUseAcceleration( 0 ) forces the portable C code even on CPUs
+// with SHA extensions or AES-NI.
+//
+UINT32 HostHash( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result );
+
+UINT32 HostHmac( TPMI_ALG_HASH hashAlg, TPM2B *key, TPM2B **bufferList, TPM2B_DIGEST *result );
+
+TSS2_RC HostAesCfb( TPMI_YES_NO decrypt, TPM2B *key, TPM2B_IV *iv, UINT8 *data, UINT32 size );
+
+void HostCryptoUseAcceleration( int enable );
+
+//
+// Streaming NV access; see NvStream.c.  Fill in chunkAuth and userData
+// after NvStreamInit when the authorization changes with every command.
+//
+typedef struct _NV_STREAM NV_STREAM;
+
+struct _NV_STREAM {
+    TSS2_SYS_CONTEXT *sysContext[2];
+    UINT16 chunkSize;               // min( TPM_PT_NV_BUFFER_MAX, MAX_NV_BUFFER_SIZE )
+    TSS2_SYS_CMD_AUTHS *cmdAuths;   // Used for every chunk; may be NULL.
+    TSS2_SYS_RSP_AUTHS *rspAuths;   // Response auths of the latest chunk.
+    TPM_RC ( *chunkAuth )( NV_STREAM *stream, TSS2_SYS_CONTEXT *sysContext,
+        TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex, TPM_RC responseCode );
+    void *userData;
+    UINT32 chunks;                  // Chunks completed since NvStreamInit.
+};
+
+TSS2_RC NvStreamInit( NV_STREAM *stream, TSS2_TCTI_CONTEXT *tctiContext,
+    TSS2_SYS_CMD_AUTHS *cmdAuths, TSS2_SYS_RSP_AUTHS *rspAuths );
+TSS2_RC NvStreamRead( NV_STREAM *stream, TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex,
+    UINT16 offset, UINT8 *data, UINT32 size );
+TSS2_RC NvStreamWrite( NV_STREAM *stream, TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex,
+    UINT16 offset, const UINT8 *data, UINT32 size );
+void NvStreamTeardown( NV_STREAM *stream );
+
+//
+// Streaming hash/HMAC sequence; see HashStream.c.
+//
+typedef struct {
+    TSS2_SYS_CONTEXT *sysContext[2];
+    TSS2_SYS_CONTEXT *pending;      // Context with a SequenceUpdate in flight.
+    UINT8 current;                  // Context the next command is built in.
+    TPMI_DH_OBJECT sequenceHandle;
+    TPMS_AUTH_COMMAND sequenceAuth;
+    TPMS_AUTH_COMMAND *sequenceAuthList[1];
+    TSS2_SYS_CMD_AUTHS cmdAuths;
+    TPM2B_MAX_BUFFER buffer;        // Input not sent to the TPM yet.
+    UINT32 updates;                 // SequenceUpdate commands sent.
+} HASH_STREAM;
+
+TSS2_RC HashStreamStart( HASH_STREAM *stream, TSS2_TCTI_CONTEXT *tctiContext, TPMI_ALG_HASH hashAlg,
+    TPMI_DH_OBJECT hmacKey, TPM2B_AUTH *keyAuth );
+TSS2_RC HashStreamUpdate( HASH_STREAM *stream, const UINT8 *data, size_t size );
+TSS2_RC HashStreamUpdateFd( HASH_STREAM *stream, int fd );
+TSS2_RC HashStreamComplete( HASH_STREAM *stream, TPMI_RH_HIERARCHY hierarchy, TPM2B_DIGEST *result,
+    TPMT_TK_HASHCHECK *validation );
+void HashStreamAbort( HASH_STREAM *stream );
+
+//
+// Consistent multi-bank PCR snapshot; see PcrSnapshot.c.
+//
+#define PCR_SNAPSHOT_MAX_TRIES 4
+
+typedef struct {
+    TPMI_ALG_HASH hash;
+    UINT16 digestSize;
+    UINT32 pcrMask;                 // PCRs in the snapshot; bit n is PCR n.
+    UINT32 offset;                  // First digest of the bank in digests[].
+} PCR_SNAPSHOT_BANK;
+
+typedef struct {
+    UINT32 pcrUpdateCounter;        // Same for every digest in the snapshot.
+    UINT32 bankCount;
+    PCR_SNAPSHOT_BANK banks[HASH_COUNT];
+    UINT32 reads;                   // PCR_Read commands, over all tries.
+    UINT32 retries;                 // Tries restarted because a PCR changed.
+    UINT32 digestsSize;
+    BYTE digests[HASH_COUNT * IMPLEMENTATION_PCR * MAX_DIGEST_SIZE];
+} PCR_SNAPSHOT;
+
+void PcrSelectionAdd( TPML_PCR_SELECTION *selection, TPMI_ALG_HASH hash, UINT32 pcrMask );
+TSS2_RC PcrSnapshotTake( TSS2_TCTI_CONTEXT *tctiContext, TPML_PCR_SELECTION *selection, PCR_SNAPSHOT *snapshot );
+BYTE *PcrSnapshotDigest( PCR_SNAPSHOT *snapshot, TPMI_ALG_HASH hash, UINT32 pcr );
+
+//
+// Host-side policy digest calculator; see PolicyCalc.c.
+//
+typedef struct {
+    TPMI_ALG_HASH hashAlg;
+    TPM2B_DIGEST digest;
+} POLICY_CALC;
+
+TSS2_RC PolicyCalcInit( POLICY_CALC *policy, TPMI_ALG_HASH hashAlg );
+TSS2_RC PolicyCalcPcrDigest( TPMI_ALG_HASH hashAlg, TPML_DIGEST *pcrValues, TPM2B_DIGEST *pcrDigest );
+TSS2_RC PolicyCalcPCR( POLICY_CALC *policy, TPM2B_DIGEST *pcrDigest, TPML_PCR_SELECTION *pcrs );
+TSS2_RC PolicyCalcCommandCode( POLICY_CALC *policy, TPM_CC code );
+TSS2_RC PolicyCalcAuthValue( POLICY_CALC *policy );
+TSS2_RC PolicyCalcPassword( POLICY_CALC *policy );
+TSS2_RC PolicyCalcOR( POLICY_CALC *policy, TPML_DIGEST *pHashList );
+TSS2_RC PolicyCalcLocality( POLICY_CALC *policy, TPMA_LOCALITY locality );
+TSS2_RC PolicyCalcNV( POLICY_CALC *policy, TPM2B_NAME *nvIndexName, TPM2B_OPERAND *operandB,
+    UINT16 offset, TPM_EO operation );
+TSS2_RC PolicyCalcSecret( POLICY_CALC *policy, TPM2B_NAME *authObjectName, TPM2B_NONCE *policyRef );
+TSS2_RC PolicyCalcAuthorize( POLICY_CALC *policy, TPM2B_NAME *keySignName, TPM2B_NONCE *policyRef );
+
 UINT32 TpmHandleToName( TPM_HANDLE handle, TPM2B_NAME *name );
 
+//
+// Name cache; see NameCache.c.  hits are lookups answered from the cache,
+// misses are lookups that read the name from the TPM, and localNames are
+// NV names recomputed on the host after an attribute change.
+//
+typedef struct {
+    UINT32 hits;
+    UINT32 misses;
+    UINT32 localNames;
+} NAME_CACHE_STATS;
+
+UINT32 CachedHandleToName( TPM_HANDLE handle, TPM2B_NAME *name );
+void NameCacheInvalidate( TPM_HANDLE handle );
+void NameCacheClear();
+void NameCacheSetNvAttributes( TPM_HANDLE nvIndex, UINT32 attributes );
+void NameCacheUpdate( TSS2_SYS_CONTEXT *sysContext, TPM_HANDLE handle1, TPM_HANDLE handle2,
+    TPM_RC responseCode );
+void NameCacheGetStats( NAME_CACHE_STATS *stats );
+void NameCacheResetStats();
+
 int TpmClientPrintf( UINT8 type, const char *format, ...);
 
 #ifdef __cplusplus
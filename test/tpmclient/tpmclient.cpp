@@ -179,6 +179,10 @@ UINT32 (*HmacFunctionPtr)( TPM_ALG_ID hashAlg, TPM2B *key,TPM2B **bufferList, TP
 
 UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = TpmHash;
 
+TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue ) = EncryptCFB;
+
+TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue ) = DecryptCFB;
+
 UINT32 (*HandleToNameFunctionPtr)( TPM_HANDLE handle, TPM2B_NAME *name ) = TpmHandleToName;
 
 TPMI_SH_AUTH_SESSION StartPolicySession();
@@ -296,6 +300,7 @@ void Cleanup()
     if( resMgrTctiContext != 0 )
     {
         PlatformCommand( resMgrTctiContext, MS_SIM_POWER_OFF );
+        DrainSysContextPool();
         TeardownTctiContext( &resMgrTctiContext );
     }
 
@@ -1313,6 +1318,51 @@ void TestTpmGetCapability()
     }
 }
 
+//
+// Right-sized context with separate command and response buffers: a
+// command the TPM rejected is still in the command buffer, so it can be
+// sent again without another _Prepare.
+//
+void TestSeparateBuffers()
+{
+    UINT32 rval, firstRval;
+    UINT32 maxCommandSize, maxResponseSize;
+    TSS2_SYS_CONTEXT *buffersSysContext;
+    TPM2B_DIGEST randomBytes;
+
+    DebugPrintf( NO_PREFIX, "\nSEPARATE BUFFERS TESTS:\n" );
+
+    rval = GetTpmBufferSizes( sysContext, &maxCommandSize, &maxResponseSize );
+    CheckPassed( rval );
+
+    buffersSysContext = InitSysContextWithBuffers( maxCommandSize, maxResponseSize, resMgrTctiContext, &abiVersion );
+    if( buffersSysContext == 0 )
+    {
+        InitSysContextFailure();
+    }
+
+    rval = Tss2_Sys_GetCapability_Prepare( buffersSysContext, 0xff, TPM_PT_MANUFACTURER, 1 );
+    CheckPassed( rval );
+
+    firstRval = Tss2_Sys_Execute( buffersSysContext );
+    if( firstRval == TSS2_RC_SUCCESS )
+    {
+        DebugPrintf( NO_PREFIX, "\tGetCapability with bad capability passed\n" );
+        Cleanup();
+    }
+
+    // Resend without _Prepare; the TPM must see the same command.
+    rval = Tss2_Sys_Execute( buffersSysContext );
+    CheckFailed( rval, firstRval );
+
+    INIT_SIMPLE_TPM2B_SIZE( randomBytes );
+    rval = Tss2_Sys_GetRandom( buffersSysContext, 0, 20, &randomBytes, 0 );
+    CheckPassed( rval );
+
+    // Not pooled; released contexts with caller buffers are just freed.
+    ReleaseSysContext( &buffersSysContext );
+}
+
 void TestTpmClear()
 {
     UINT32 rval;
@@ -3096,6 +3146,182 @@ void TestPolicy()
     }
 }
 
+//
+// Starts a trial session for TestPolicyCalc.
+//
+TPM_RC StartTrialSession( SESSION **trialSession )
+{
+    TPM2B_ENCRYPTED_SECRET encryptedSalt = { {0}, };
+    TPMT_SYM_DEF symmetric;
+    TPM2B_NONCE nonceCaller;
+
+    nonceCaller.t.size = 0;
+    symmetric.algorithm = TPM_ALG_NULL;
+
+    return StartAuthSessionWithParams( trialSession, TPM_RH_NULL, 0, TPM_RH_NULL, 0, &nonceCaller,
+            &encryptedSalt, TPM_SE_TRIAL, &symmetric, TPM_ALG_SHA256, resMgrTctiContext );
+}
+
+//
+// Reads the trial session's digest, ends the session and checks the
+// digest against the one computed on the host.
+//
+void CheckTrialDigest( SESSION *trialSession, POLICY_CALC *policy, TPM2B_DIGEST *tpmDigest )
+{
+    TPM_RC rval;
+
+    INIT_SIMPLE_TPM2B_SIZE( *tpmDigest );
+    rval = Tss2_Sys_PolicyGetDigest( sysContext, trialSession->sessionHandle, 0, tpmDigest, 0 );
+    CheckPassed( rval );
+
+    rval = Tss2_Sys_FlushContext( sysContext, trialSession->sessionHandle );
+    CheckPassed( rval );
+
+    rval = EndAuthSession( trialSession );
+    CheckPassed( rval );
+
+    if( tpmDigest->t.size != policy->digest.t.size ||
+            memcmp( &tpmDigest->t.buffer[0], &policy->digest.t.buffer[0], tpmDigest->t.size ) != 0 )
+    {
+        DebugPrintf( NO_PREFIX, "ERROR!! host policy digest doesn't match the TPM's\n" );
+        Cleanup();
+    }
+}
+
+//
+// Builds policies with trial sessions and with the host-side calculator,
+// and checks that the digests match.
+//
+void TestPolicyCalc()
+{
+    TPM_RC rval;
+    SESSION *trialSession;
+    POLICY_CALC policy;
+    TPMA_LOCALITY locality;
+    TPML_PCR_SELECTION pcrs, pcrSelectionOut;
+    TPML_DIGEST pcrValues, branches;
+    UINT32 pcrUpdateCounter;
+    TPM2B_DIGEST pcrDigest, tpmDigest;
+    TPM2B_NAME platformName, keySignName;
+    TPM2B_NONCE policyRef, nonceTpm;
+    TPM2B_DIGEST cpHash;
+    TPM2B_TIMEOUT timeout;
+    TPMT_TK_AUTH policyTicket;
+    TPMT_TK_VERIFIED checkTicket;
+    TPM2B_DIGEST approvedPolicy;
+    TPMS_AUTH_COMMAND sessionData;
+    TPMS_AUTH_COMMAND *sessionDataArray[1] = { &sessionData };
+    TSS2_SYS_CMD_AUTHS sessionsData = { 1, &sessionDataArray[0] };
+
+    DebugPrintf( NO_PREFIX, "\nPOLICY CALCULATOR TESTS:\n" );
+
+    // Branch 1: locality, command code, password and PCRs.
+    *(UINT8 *)( (void *)&locality ) = 0;
+    locality.TPM_LOC_THREE = 1;
+
+    pcrs.count = 0;
+    PcrSelectionAdd( &pcrs, TPM_ALG_SHA1, ( 1 << PCR_0 ) | ( 1 << PCR_3 ) );
+    rval = Tss2_Sys_PCR_Read( sysContext, 0, &pcrs, &pcrUpdateCounter, &pcrSelectionOut, &pcrValues, 0 );
+    CheckPassed( rval );
+    rval = PolicyCalcPcrDigest( TPM_ALG_SHA256, &pcrValues, &pcrDigest );
+    CheckPassed( rval );
+
+    rval = StartTrialSession( &trialSession );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyLocality( sysContext, trialSession->sessionHandle, 0, locality, 0 );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyCommandCode( sysContext, trialSession->sessionHandle, 0, TPM_CC_NV_Read, 0 );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyPassword( sysContext, trialSession->sessionHandle, 0, 0 );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyPCR( sysContext, trialSession->sessionHandle, 0, &pcrDigest, &pcrs, 0 );
+    CheckPassed( rval );
+
+    rval = PolicyCalcInit( &policy, TPM_ALG_SHA256 );
+    CheckPassed( rval );
+    rval = PolicyCalcLocality( &policy, locality );
+    CheckPassed( rval );
+    rval = PolicyCalcCommandCode( &policy, TPM_CC_NV_Read );
+    CheckPassed( rval );
+    rval = PolicyCalcPassword( &policy );
+    CheckPassed( rval );
+    rval = PolicyCalcPCR( &policy, &pcrDigest, &pcrs );
+    CheckPassed( rval );
+
+    CheckTrialDigest( trialSession, &policy, &branches.digests[0] );
+
+    // Branch 2: auth value.
+    rval = StartTrialSession( &trialSession );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyAuthValue( sysContext, trialSession->sessionHandle, 0, 0 );
+    CheckPassed( rval );
+
+    rval = PolicyCalcInit( &policy, TPM_ALG_SHA256 );
+    CheckPassed( rval );
+    rval = PolicyCalcAuthValue( &policy );
+    CheckPassed( rval );
+
+    CheckTrialDigest( trialSession, &policy, &branches.digests[1] );
+    branches.count = 2;
+
+    // OR of the two branches, then platform authorization.
+    platformName.t.size = 4;
+    platformName.t.name[0] = (BYTE)( TPM_RH_PLATFORM >> 24 );
+    platformName.t.name[1] = (BYTE)( TPM_RH_PLATFORM >> 16 );
+    platformName.t.name[2] = (BYTE)( TPM_RH_PLATFORM >> 8 );
+    platformName.t.name[3] = (BYTE)TPM_RH_PLATFORM;
+    policyRef.t.size = 3;
+    memcpy( &policyRef.t.buffer[0], "ref", 3 );
+
+    sessionData.sessionHandle = TPM_RS_PW;
+    sessionData.nonce.t.size = 0;
+    sessionData.hmac.t.size = 0;
+    *( (UINT8 *)((void *)&sessionData.sessionAttributes ) ) = 0;
+
+    rval = StartTrialSession( &trialSession );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyOR( sysContext, trialSession->sessionHandle, 0, &branches, 0 );
+    CheckPassed( rval );
+    nonceTpm.t.size = 0;
+    cpHash.t.size = 0;
+    INIT_SIMPLE_TPM2B_SIZE( timeout );
+    rval = Tss2_Sys_PolicySecret( sysContext, TPM_RH_PLATFORM, trialSession->sessionHandle, &sessionsData,
+            &nonceTpm, &cpHash, &policyRef, 0, &timeout, &policyTicket, 0 );
+    CheckPassed( rval );
+
+    rval = PolicyCalcInit( &policy, TPM_ALG_SHA256 );
+    CheckPassed( rval );
+    rval = PolicyCalcOR( &policy, &branches );
+    CheckPassed( rval );
+    rval = PolicyCalcSecret( &policy, &platformName, &policyRef );
+    CheckPassed( rval );
+
+    CheckTrialDigest( trialSession, &policy, &tpmDigest );
+
+    // PolicyAuthorize; a trial session doesn't check the ticket.
+    keySignName.t.size = 34;
+    keySignName.t.name[0] = (BYTE)( TPM_ALG_SHA256 >> 8 );
+    keySignName.t.name[1] = (BYTE)TPM_ALG_SHA256;
+    memset( &keySignName.t.name[2], 0xaa, 32 );
+    approvedPolicy = tpmDigest;
+    checkTicket.tag = TPM_ST_VERIFIED;
+    checkTicket.hierarchy = TPM_RH_NULL;
+    checkTicket.digest.t.size = 0;
+
+    rval = StartTrialSession( &trialSession );
+    CheckPassed( rval );
+    rval = Tss2_Sys_PolicyAuthorize( sysContext, trialSession->sessionHandle, 0, &approvedPolicy,
+            &policyRef, &keySignName, &checkTicket, 0 );
+    CheckPassed( rval );
+
+    rval = PolicyCalcInit( &policy, TPM_ALG_SHA256 );
+    CheckPassed( rval );
+    rval = PolicyCalcAuthorize( &policy, &keySignName, &policyRef );
+    CheckPassed( rval );
+
+    CheckTrialDigest( trialSession, &policy, &tpmDigest );
+}
+
 #define MAX_TEST_SEQUENCES 10
 void TestHash()
 {
@@ -7216,12 +7442,16 @@ void TpmTest()
 
         TestTpmGetCapability();
 
+        TestSeparateBuffers();
+
         TestPcrExtend();
 
         TestHash();
 
         TestPolicy();
 
+        TestPolicyCalc();
+
         TestTpmClear();
 
         TestChangeEps();
@@ -7275,7 +7505,7 @@ char version[] = "0.90";
 
 void PrintHelp()
 {
-    printf( "TPM client test app, Version %s\nUsage:  tpmclient [-rmhost hostname|ip_addr] [-rmport port] [-passes passNum] [-demoDelay delay] [-dbg dbgLevel] [-startAuthSessionTest] "
+    printf( "TPM client test app, Version %s\nUsage:  tpmclient [-rmhost hostname|ip_addr] [-rmport port] [-passes passNum] [-demoDelay delay] [-dbg dbgLevel] [-startAuthSessionTest] [-hostCrypto] "
 #if __linux || __unix
             "[-localTctiTest]"
 #endif
@@ -7290,6 +7520,7 @@ void PrintHelp()
             "   0 (high level test results)\n"
             "   1 (test app send/receive byte streams)\n"
             "-startAuthSessionTest enables some special tests of the resource manager for starting sessions\n"
+            "-hostCrypto does session HMACs, cpHash/rpHash, KDFa and CFB parameter encryption on the host instead of the TPM\n"
 #if __linux || __unix
             "-localTctiTest enables a TCTI interface test against a local TPM.  WARNING:  This test requires no resource manager and a local TPM\n"
 #endif
@@ -7306,9 +7537,9 @@ int main(int argc, char* argv[])
 
     setvbuf (stdout, NULL, _IONBF, BUFSIZ);
 #ifdef SHARED_OUT_FILE
-    if( argc > 12 )
+    if( argc > 13 )
 #else
-    if( argc > 10 )
+    if( argc > 11 )
 #endif
     {
         PrintHelp();
@@ -7365,6 +7596,13 @@ int main(int argc, char* argv[])
                     return 1;
                 }
             }
+            else if( 0 == strcmp( argv[count], "-hostCrypto" ) )
+            {
+                HmacFunctionPtr = HostHmac;
+                HashFunctionPtr = HostHash;
+                EncryptCfbFunctionPtr = HostEncryptCFB;
+                DecryptCfbFunctionPtr = HostDecryptCFB;
+            }
 #if __linux || __unix
             else if( 0 == strcmp( argv[count], "-localTctiTest" ) )
             {
@@ -7412,6 +7650,7 @@ int main(int argc, char* argv[])
     {
         TpmTest();
         TeardownSysContext( &sysContext );
+        DrainSysContextPool();
         TeardownTctiContext( &resMgrTctiContext );
     }
 
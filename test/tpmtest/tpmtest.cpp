@@ -181,6 +181,10 @@ UINT32 (*HmacFunctionPtr)( TPM_ALG_ID hashAlg, TPM2B *key,TPM2B **bufferList, TP
 
 UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = TpmHash;
 
+TSS2_RC (*EncryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *encryptedData, TPM2B_MAX_BUFFER *clearData, TPM2B_AUTH *authValue ) = EncryptCFB;
+
+TSS2_RC (*DecryptCfbFunctionPtr)( SESSION *session, TPM2B_MAX_BUFFER *clearData, TPM2B_MAX_BUFFER *encryptedData, TPM2B_AUTH *authValue ) = DecryptCFB;
+
 UINT32 (*HandleToNameFunctionPtr)( TPM_HANDLE handle, TPM2B_NAME *name ) = TpmHandleToName;
 
 TPMI_SH_AUTH_SESSION StartPolicySession();
@@ -9032,7 +9036,7 @@ char version[] = "0.90";
 void PrintHelp()
 {
     printf(
-            "TPM client test app, Version %s\nUsage:  tpmclient [-host hostname|ip_addr] [-port port] [-type type] [-passes passNum] [-demoDelay delay] [-dbg dbgLevel] [-startAuthSessionTest]\n"
+            "TPM client test app, Version %s\nUsage:  tpmclient [-host hostname|ip_addr] [-port port] [-type type] [-passes passNum] [-demoDelay delay] [-dbg dbgLevel] [-startAuthSessionTest] [-hostCrypto]\n"
             "\n"
             "where:\n"
             "\n"
@@ -9046,6 +9050,7 @@ void PrintHelp()
             "   2 (resource manager send/receive byte streams)\n"
             "   3 (resource manager tables)\n"
             "-startAuthSessionTest enables some special tests of the resource manager for starting sessions\n"
+            "-hostCrypto does session HMACs, cpHash/rpHash, KDFa and CFB parameter encryption on the host instead of the TPM\n"
             , version, DEFAULT_HOSTNAME, DEFAULT_RESMGR_TPM_PORT );
 }
 
@@ -9075,7 +9080,7 @@ int main(int argc, char* argv[])
 
     setbuf(stdout, NULL);
     setvbuf (stdout, NULL, _IONBF, BUFSIZ);
-    if( argc > 8 )
+    if( argc > 9 )
     {
         PrintHelp();
         return 1;
@@ -9135,6 +9140,13 @@ int main(int argc, char* argv[])
             {
                 startAuthSessionTestOnly = 1;
             }
+            else if( 0 == strcmp( argv[count], "-hostCrypto" ) )
+            {
+                HmacFunctionPtr = HostHmac;
+                HashFunctionPtr = HostHash;
+                EncryptCfbFunctionPtr = HostEncryptCFB;
+                DecryptCfbFunctionPtr = HostDecryptCFB;
+            }
             else
             {
                 PrintHelp();
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+
+#define MAX_SIZE_CTX 4096
+
+typedef struct {
+    TSS2_SYS_CONTEXT *legacy;
+    TSS2_SYS_CONTEXT *reserved;
+    TPMS_AUTH_COMMAND session;
+    TPMS_AUTH_COMMAND *sessions [1];
+    TSS2_SYS_CMD_AUTHS cmdAuths;
+    TPM2B_MAX_NV_BUFFER nvData;
+} reserve_data_t;
+
+/*
+ * Build a sys context without a TCTI; only _Prepare and SetCmdAuths are
+ * exercised here.
+ */
+static TSS2_SYS_CONTEXT *
+sys_context_new (void)
+{
+    size_t size = Tss2_Sys_GetContextSize (MAX_SIZE_CTX);
+    TSS2_SYS_CONTEXT *sysContext = calloc (1, size);
+
+    assert_non_null (sysContext);
+    InitSysContextPtrs (sysContext, size);
+    InitSysContextFields (sysContext);
+    SYS_CONTEXT->previousStage = CMD_STAGE_INITIALIZE;
+
+    return sysContext;
+}
+
+static void
+reserve_setup (void **state)
+{
+    reserve_data_t *data = calloc (1, sizeof (reserve_data_t));
+    UINT16 i;
+
+    data->legacy   = sys_context_new ();
+    data->reserved = sys_context_new ();
+
+    data->session.sessionHandle = TPM_RS_PW;
+    data->session.nonce.t.size  = 16;
+    data->session.hmac.t.size   = 32;
+    for (i = 0; i < data->session.hmac.t.size; i++)
+        data->session.hmac.t.buffer [i] = (BYTE)i;
+    data->sessions [0]       = &data->session;
+    data->cmdAuths.cmdAuthsCount = 1;
+    data->cmdAuths.cmdAuths  = data->sessions;
+
+    data->nvData.t.size = MAX_NV_BUFFER_SIZE;
+    for (i = 0; i < data->nvData.t.size; i++)
+        data->nvData.t.buffer [i] = (BYTE)(i * 7);
+
+    *state = data;
+}
+
+static void
+reserve_teardown (void **state)
+{
+    reserve_data_t *data = (reserve_data_t *)*state;
+
+    free (data->legacy);
+    free (data->reserved);
+    free (data);
+}
+
+static void
+assert_same_command (TSS2_SYS_CONTEXT *a, TSS2_SYS_CONTEXT *b)
+{
+    _TSS2_SYS_CONTEXT_BLOB *ctxA = (_TSS2_SYS_CONTEXT_BLOB *)a;
+    _TSS2_SYS_CONTEXT_BLOB *ctxB = (_TSS2_SYS_CONTEXT_BLOB *)b;
+    UINT32 size = CHANGE_ENDIAN_DWORD (((TPM20_Header_In *)ctxA->tpmInBuffPtr)->commandSize);
+
+    assert_int_equal (size, CHANGE_ENDIAN_DWORD (((TPM20_Header_In *)ctxB->tpmInBuffPtr)->commandSize));
+    assert_memory_equal (ctxA->tpmInBuffPtr, ctxB->tpmInBuffPtr, size);
+    assert_int_equal (ctxA->cpBufferUsedSize, ctxB->cpBufferUsedSize);
+    assert_memory_equal (ctxA->cpBuffer, ctxB->cpBuffer, ctxA->cpBufferUsedSize);
+}
+
+/*
+ * A reserved authorization area must produce the same command bytes as the
+ * legacy path, without moving the parameters that _Prepare marshalled.
+ */
+static void
+reserve_matches_legacy (void **state)
+{
+    reserve_data_t *data = (reserve_data_t *)*state;
+    _TSS2_SYS_CONTEXT_BLOB *ctx = (_TSS2_SYS_CONTEXT_BLOB *)data->reserved;
+    UINT8 *cpBuffer;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_NV_Write_Prepare (data->legacy, TPM_RH_OWNER, 0x01500000,
+                                    &data->nvData, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_SetCmdAuths (data->legacy, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = Tss2_Sys_ReserveCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_NV_Write_Prepare (data->reserved, TPM_RH_OWNER, 0x01500000,
+                                    &data->nvData, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    cpBuffer = ctx->cpBuffer;
+    rc = Tss2_Sys_SetCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    assert_true (ctx->cpBuffer == cpBuffer);
+    assert_int_equal (ctx->cmdAuthsGap, 0);
+    assert_same_command (data->legacy, data->reserved);
+}
+
+/*
+ * The reservation applies to one command only; the next _Prepare gives the
+ * gap back, even if SetCmdAuths was never called.
+ */
+static void
+reserve_is_one_shot (void **state)
+{
+    reserve_data_t *data = (reserve_data_t *)*state;
+    _TSS2_SYS_CONTEXT_BLOB *ctx = (_TSS2_SYS_CONTEXT_BLOB *)data->reserved;
+    UINT8 *tpmInBuffPtr = ctx->tpmInBuffPtr;
+    UINT32 maxCommandSize = ctx->maxCommandSize;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_ReserveCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_GetRandom_Prepare (data->reserved, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_true (ctx->tpmInBuffPtr != tpmInBuffPtr);
+
+    rc = Tss2_Sys_GetRandom_Prepare (data->reserved, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_true (ctx->tpmInBuffPtr == tpmInBuffPtr);
+    assert_int_equal (ctx->maxCommandSize, maxCommandSize);
+
+    rc = Tss2_Sys_GetRandom_Prepare (data->legacy, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_same_command (data->legacy, data->reserved);
+}
+
+/* A larger authorization area than reserved falls back to moving the parameters. */
+static void
+reserve_too_small (void **state)
+{
+    reserve_data_t *data = (reserve_data_t *)*state;
+    TSS2_RC rc;
+
+    data->session.hmac.t.size = 0;
+    rc = Tss2_Sys_ReserveCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    data->session.hmac.t.size = 32;
+
+    rc = Tss2_Sys_NV_Write_Prepare (data->reserved, TPM_RH_OWNER, 0x01500000,
+                                    &data->nvData, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_SetCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = Tss2_Sys_NV_Write_Prepare (data->legacy, TPM_RH_OWNER, 0x01500000,
+                                    &data->nvData, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_SetCmdAuths (data->legacy, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    assert_same_command (data->legacy, data->reserved);
+}
+
+static void
+reserve_bad_session (void **state)
+{
+    reserve_data_t *data = (reserve_data_t *)*state;
+    TSS2_RC rc;
+
+    data->sessions [0] = NULL;
+    rc = Tss2_Sys_ReserveCmdAuths (data->reserved, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_VALUE);
+
+    rc = Tss2_Sys_ReserveCmdAuths (NULL, &data->cmdAuths);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_REFERENCE);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (reserve_matches_legacy,
+                                  reserve_setup,
+                                  reserve_teardown),
+        unit_test_setup_teardown (reserve_is_one_shot,
+                                  reserve_setup,
+                                  reserve_teardown),
+        unit_test_setup_teardown (reserve_too_small,
+                                  reserve_setup,
+                                  reserve_teardown),
+        unit_test_setup_teardown (reserve_bad_session,
+                                  reserve_setup,
+                                  reserve_teardown),
+    };
+    return run_tests (tests);
+}
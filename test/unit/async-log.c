@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "debug.h"
+#include "asynclog.h"
+
+/* Every test shares the one ring, so the first AsyncLogInit fixes it at this. */
+#define RING_SLOTS 64
+#define THREADS 4
+#define THREAD_MESSAGES 10000
+
+typedef struct {
+    FILE *out;
+    UINT64 dropped;
+    char text [8192];
+} async_log_data_t;
+
+static void
+async_log_setup (void **state)
+{
+    async_log_data_t *data = calloc (1, sizeof (async_log_data_t));
+
+    assert_int_equal (AsyncLogInit (RING_SLOTS), 0);
+    data->out = tmpfile ();
+    assert_non_null (data->out);
+    data->dropped = AsyncLogGetDroppedCount ();
+    *state = data;
+}
+
+static void
+async_log_teardown (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+
+    AsyncLogStop ();
+    fclose (data->out);
+    free (data);
+}
+
+/* Reads back everything drained so far. */
+static const char *
+drained_text (async_log_data_t *data)
+{
+    size_t size;
+
+    rewind (data->out);
+    size = fread (data->text, 1, sizeof (data->text) - 1, data->out);
+    data->text [size] = '\0';
+    return data->text;
+}
+
+/* Queued messages come out in order, laid out as the synchronous ones are. */
+static void
+async_log_order (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+    UINT8 buffer [18];
+    UINT32 i;
+
+    for (i = 0; i < sizeof (buffer); i++)
+        buffer [i] = (UINT8)i;
+
+    DebugPrintf (NO_PREFIX, "Cmd sent: %s\n", "TPM2_GetRandom");
+    DebugPrintBuffer (RM_PREFIX, buffer, sizeof (buffer));
+    DebugPrintfCallback (NULL, RM_PREFIX, "rc: 0x%x\n", 0x101);
+    assert_string_equal (drained_text (data), "");
+
+    assert_int_equal (AsyncLogDrain (data->out), 3);
+    assert_string_equal (drained_text (data),
+        "Cmd sent: TPM2_GetRandom\n"
+        "\n||  00 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e 0f "
+        "\n||  10 11 \n\n"
+        "||  rc: 0x101\n");
+    assert_int_equal (AsyncLogGetDroppedCount (), data->dropped);
+}
+
+/* A full ring drops the message and counts it instead of waiting. */
+static void
+async_log_overflow (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+    char expected [64];
+    UINT32 i;
+
+    for (i = 0; i < RING_SLOTS + 10; i++)
+        DebugPrintf (NO_PREFIX, "%d\n", i);
+
+    assert_int_equal (AsyncLogGetDroppedCount () - data->dropped, 10);
+    assert_int_equal (AsyncLogDrain (data->out), RING_SLOTS);
+    sprintf (expected, "%d\nasynclog: 10 messages dropped\n", RING_SLOTS - 1);
+    assert_non_null (strstr (drained_text (data), expected));
+
+    /* With room again, messages are queued again. */
+    DebugPrintf (NO_PREFIX, "again\n");
+    assert_int_equal (AsyncLogDrain (data->out), 1);
+    assert_int_equal (AsyncLogGetDroppedCount () - data->dropped, 10);
+}
+
+/* Records spanning several slots survive wrapping round the ring. */
+static void
+async_log_wrap (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+    UINT8 buffer [200];
+    UINT32 lap, i;
+
+    memset (buffer, 0xab, sizeof (buffer));
+    for (lap = 0; lap < 20; lap++) {
+        for (i = 0; i < 5; i++)
+            DebugPrintBuffer (NO_PREFIX, buffer, sizeof (buffer));
+        assert_int_equal (AsyncLogDrain (data->out), 5);
+    }
+    assert_int_equal (AsyncLogGetDroppedCount (), data->dropped);
+}
+
+/* Buffers bigger than a quarter of the ring are cut short, not dropped. */
+static void
+async_log_truncate (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+    UINT8 buffer [1000];
+
+    memset (buffer, 0, sizeof (buffer));
+    DebugPrintBuffer (NO_PREFIX, buffer, sizeof (buffer));
+    assert_int_equal (AsyncLogDrain (data->out), 1);
+    assert_non_null (strstr (drained_text (data), "... 116 more bytes\n\n"));
+    assert_int_equal (AsyncLogGetDroppedCount (), data->dropped);
+}
+
+static void *
+log_thread (void *arg)
+{
+    UINT32 i;
+
+    for (i = 0; i < THREAD_MESSAGES; i++)
+        DebugPrintf (NO_PREFIX, "thread %u message %u\n", (UINT32)(size_t)arg, i);
+    return NULL;
+}
+
+/* Concurrent writers: every message is either written or counted as dropped. */
+static void
+async_log_threads (void **state)
+{
+    async_log_data_t *data = (async_log_data_t *)*state;
+    pthread_t threads [THREADS];
+    size_t written = 0;
+    UINT32 i;
+
+    for (i = 0; i < THREADS; i++)
+        assert_int_equal (pthread_create (&threads [i], NULL, log_thread, (void *)(size_t)i), 0);
+    for (i = 0; i < 1000; i++)
+        written += AsyncLogDrain (data->out);
+    for (i = 0; i < THREADS; i++)
+        pthread_join (threads [i], NULL);
+    written += AsyncLogDrain (data->out);
+
+    assert_int_equal (written + AsyncLogGetDroppedCount () - data->dropped,
+                      THREADS * THREAD_MESSAGES);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (async_log_order,
+                                  async_log_setup,
+                                  async_log_teardown),
+        unit_test_setup_teardown (async_log_overflow,
+                                  async_log_setup,
+                                  async_log_teardown),
+        unit_test_setup_teardown (async_log_wrap,
+                                  async_log_setup,
+                                  async_log_teardown),
+        unit_test_setup_teardown (async_log_truncate,
+                                  async_log_setup,
+                                  async_log_teardown),
+        unit_test_setup_teardown (async_log_threads,
+                                  async_log_setup,
+                                  async_log_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+
+#define BUFFER_SIZE 256
+
+typedef struct {
+    _TSS2_SYS_CONTEXT_BLOB context;
+    UINT8 buffer [BUFFER_SIZE];
+} complete_view_data_t;
+
+/*
+ * Lay out a TPM_ST_NO_SESSIONS response with the given parameter area and
+ * put the context in the state it would be in after Tss2_Sys_ExecuteFinish.
+ */
+static void
+build_response (complete_view_data_t *data,
+                const UINT8          *params,
+                UINT32                paramsSize)
+{
+    TPM20_Header_Out *header = (TPM20_Header_Out *)data->buffer;
+
+    memset (&data->context, 0, sizeof (data->context));
+    memset (data->buffer, 0, BUFFER_SIZE);
+
+    header->tag          = CHANGE_ENDIAN_WORD (TPM_ST_NO_SESSIONS);
+    header->responseSize = CHANGE_ENDIAN_DWORD (sizeof (TPM20_Header_Out) + paramsSize);
+    header->responseCode = CHANGE_ENDIAN_DWORD (TPM_RC_SUCCESS);
+    memcpy (data->buffer + sizeof (TPM20_Header_Out), params, paramsSize);
+
+    data->context.tpmInBuffPtr    = data->buffer;
+    data->context.tpmOutBuffPtr   = data->buffer;
+    data->context.maxCommandSize  = BUFFER_SIZE;
+    data->context.maxResponseSize = BUFFER_SIZE;
+    data->context.rspParamsSize   = (UINT32 *)(data->buffer + sizeof (TPM20_Header_Out));
+    data->context.previousStage   = CMD_STAGE_RECEIVE_RESPONSE;
+    data->context.rval            = TSS2_RC_SUCCESS;
+}
+
+void
+complete_view_setup (void **state)
+{
+    *state = calloc (1, sizeof (complete_view_data_t));
+}
+
+void
+complete_view_teardown (void **state)
+{
+    if (*state)
+        free (*state);
+}
+
+/*
+ * The view must point straight into the response buffer and agree with
+ * what the copying _Complete function produces.
+ */
+void
+complete_view_nv_read (void **state)
+{
+    complete_view_data_t *data = (complete_view_data_t *)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT *)&data->context;
+    UINT8 params [] = { 0x00, 0x04, 0xde, 0xad, 0xbe, 0xef };
+    TSS2_SYS_BUFFER_VIEW view = { 0, NULL };
+    TPM2B_MAX_NV_BUFFER copy;
+    TSS2_RC rc;
+
+    build_response (data, params, sizeof (params));
+    rc = Tss2_Sys_NV_Read_CompleteView (sysContext, &view);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (view.size, 4);
+    assert_true (view.buffer == data->buffer + sizeof (TPM20_Header_Out) + 2);
+
+    build_response (data, params, sizeof (params));
+    copy.t.size = sizeof (copy.t.buffer);
+    rc = Tss2_Sys_NV_Read_Complete (sysContext, &copy);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (copy.t.size, view.size);
+    assert_memory_equal (copy.t.buffer, view.buffer, view.size);
+}
+
+/* Two consecutive TPM2B views; a NULL view skips its parameter. */
+void
+complete_view_encrypt_decrypt (void **state)
+{
+    complete_view_data_t *data = (complete_view_data_t *)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT *)&data->context;
+    UINT8 params [] = { 0x00, 0x02, 0x11, 0x22, 0x00, 0x03, 0x33, 0x44, 0x55 };
+    TSS2_SYS_BUFFER_VIEW ivOut = { 0, NULL };
+    TSS2_RC rc;
+
+    build_response (data, params, sizeof (params));
+    rc = Tss2_Sys_EncryptDecrypt_CompleteView (sysContext, NULL, &ivOut);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (ivOut.size, 3);
+    assert_int_equal (ivOut.buffer [0], 0x33);
+    assert_int_equal (ivOut.buffer [2], 0x55);
+}
+
+void
+complete_view_context_save (void **state)
+{
+    complete_view_data_t *data = (complete_view_data_t *)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT *)&data->context;
+    UINT8 params [] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, /* sequence */
+        0x80, 0x00, 0x00, 0x01,                         /* savedHandle */
+        0x40, 0x00, 0x00, 0x01,                         /* hierarchy */
+        0x00, 0x02, 0xab, 0xcd,                         /* contextBlob */
+    };
+    TSS2_SYS_CONTEXT_VIEW view;
+    TSS2_RC rc;
+
+    build_response (data, params, sizeof (params));
+    rc = Tss2_Sys_ContextSave_CompleteView (sysContext, &view);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_true (view.sequence == 0x0102);
+    assert_int_equal (view.savedHandle, 0x80000001);
+    assert_int_equal (view.hierarchy, TPM_RH_OWNER);
+    assert_int_equal (view.contextBlob.size, 2);
+    assert_true (view.contextBlob.buffer ==
+                 data->buffer + sizeof (TPM20_Header_Out) + 16 + 2);
+}
+
+/* A size field that runs past the end of the buffer must be rejected. */
+void
+complete_view_truncated (void **state)
+{
+    complete_view_data_t *data = (complete_view_data_t *)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT *)&data->context;
+    UINT8 params [] = { 0xff, 0xff };
+    TSS2_SYS_BUFFER_VIEW view = { 0, NULL };
+    TSS2_RC rc;
+
+    build_response (data, params, sizeof (params));
+    rc = Tss2_Sys_GetRandom_CompleteView (sysContext, &view);
+    assert_int_equal (rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+    assert_null (view.buffer);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (complete_view_nv_read,
+                                  complete_view_setup,
+                                  complete_view_teardown),
+        unit_test_setup_teardown (complete_view_encrypt_decrypt,
+                                  complete_view_setup,
+                                  complete_view_teardown),
+        unit_test_setup_teardown (complete_view_context_save,
+                                  complete_view_setup,
+                                  complete_view_teardown),
+        unit_test_setup_teardown (complete_view_truncated,
+                                  complete_view_setup,
+                                  complete_view_teardown),
+    };
+    return run_tests (tests);
+}
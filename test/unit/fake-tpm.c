@@ -0,0 +1,55 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "fake-tpm.h"
+
+static TSS2_RC
+fake_transmit (TSS2_TCTI_CONTEXT *tctiContext, size_t size, uint8_t *command)
+{
+    fake_tpm_t *tpm = (fake_tpm_t *)tctiContext;
+
+    assert_false (tpm->pending);
+    assert_true (size >= 10);
+    tpm->pending = 1;
+    tpm->responseSize = 0;
+    tpm->handler (tpm, command, size);
+    assert_true (tpm->responseSize >= 10);
+
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC
+fake_receive (TSS2_TCTI_CONTEXT *tctiContext, size_t *size, uint8_t *response,
+              int32_t timeout)
+{
+    fake_tpm_t *tpm = (fake_tpm_t *)tctiContext;
+
+    assert_true (tpm->pending);
+    assert_true (*size >= tpm->responseSize);
+    tpm->pending = 0;
+    memcpy (response, tpm->response, tpm->responseSize);
+    *size = tpm->responseSize;
+
+    return TSS2_RC_SUCCESS;
+}
+
+void
+fake_tpm_init (fake_tpm_t *tpm, fake_tpm_handler_t handler)
+{
+    memset (tpm, 0, sizeof (*tpm));
+    tpm->common.version  = 1;
+    tpm->common.transmit = fake_transmit;
+    tpm->common.receive  = fake_receive;
+    tpm->handler         = handler;
+}
+
+void
+fake_tpm_respond (fake_tpm_t *tpm, TPM_ST tag, TPM_RC rc, UINT8 *end)
+{
+    put16 (tpm->response, tag);
+    put32 (tpm->response + 2, end - tpm->response);
+    put32 (tpm->response + 6, rc);
+    tpm->responseSize = end - tpm->response;
+}
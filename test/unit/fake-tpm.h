@@ -0,0 +1,37 @@
+#ifndef FAKE_TPM_H
+#define FAKE_TPM_H
+
+#include <tpm20.h>
+
+/*
+ * A TCTI that plays a TPM for the unit tests.  Each test embeds fake_tpm_t
+ * as the first member of its own TPM state and supplies a handler; the
+ * handler is called with every command transmitted and builds the response
+ * in 'response', usually ending with fake_tpm_respond.  The next receive
+ * hands it back.  Sending a second command before the response has been
+ * collected, or receiving with nothing sent, fails the test.
+ */
+typedef struct fake_tpm fake_tpm_t;
+
+typedef void (*fake_tpm_handler_t) (fake_tpm_t *tpm, const UINT8 *command,
+                                    size_t size);
+
+struct fake_tpm {
+    TSS2_TCTI_CONTEXT_COMMON_V1 common;
+    fake_tpm_handler_t handler;
+    UINT8 response [4096];
+    size_t responseSize;
+    int pending;
+};
+
+static inline UINT16 get16 (const UINT8 *p) { return (UINT16)(p [0] << 8 | p [1]); }
+static inline UINT32 get32 (const UINT8 *p) { return (UINT32)get16 (p) << 16 | get16 (p + 2); }
+static inline UINT8 *put16 (UINT8 *p, UINT16 v) { p [0] = v >> 8; p [1] = (UINT8)v; return p + 2; }
+static inline UINT8 *put32 (UINT8 *p, UINT32 v) { return put16 (put16 (p, v >> 16), (UINT16)v); }
+
+void fake_tpm_init (fake_tpm_t *tpm, fake_tpm_handler_t handler);
+
+/* Fills in the response header for a response body ending at end. */
+void fake_tpm_respond (fake_tpm_t *tpm, TPM_ST tag, TPM_RC rc, UINT8 *end);
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+
+#define NUM_HANDLES 5000
+
+static void
+handle_table_teardown (void **state)
+{
+    HandleTableClear ((HANDLE_TABLE *)*state, NULL);
+    free (*state);
+}
+
+static void
+handle_table_setup (void **state)
+{
+    *state = calloc (1, sizeof (HANDLE_TABLE));
+}
+
+/*
+ * Insert enough handles to force several resizes, then check that every
+ * one is still found and that misses stay misses.
+ */
+static void
+handle_table_insert_find (void **state)
+{
+    HANDLE_TABLE *table = (HANDLE_TABLE *)*state;
+    static int values [NUM_HANDLES];
+    void *old;
+    TPM_RC rc;
+    int i;
+
+    assert_null (HandleTableFind (table, 0x01500000));
+
+    for (i = 0; i < NUM_HANDLES; i++) {
+        rc = HandleTableInsert (table, 0x01500000 + i, &values [i], &old);
+        assert_int_equal (rc, TPM_RC_SUCCESS);
+        assert_null (old);
+    }
+    assert_int_equal (table->count, NUM_HANDLES);
+    assert_true (table->count * 2 <= table->capacity);
+
+    for (i = 0; i < NUM_HANDLES; i++)
+        assert_true (HandleTableFind (table, 0x01500000 + i) == &values [i]);
+    assert_null (HandleTableFind (table, 0x01500000 + NUM_HANDLES));
+    assert_null (HandleTableFind (table, 0x81000000));
+
+    rc = HandleTableInsert (table, 0x01500000, &values [1], &old);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_true (old == &values [0]);
+    assert_int_equal (table->count, NUM_HANDLES);
+    assert_true (HandleTableFind (table, 0x01500000) == &values [1]);
+
+    rc = HandleTableInsert (table, 0x01500000, NULL, &old);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_REFERENCE);
+}
+
+/*
+ * Remove every other handle; the backward shift must keep the remaining
+ * handles reachable from their home slots.
+ */
+static void
+handle_table_remove (void **state)
+{
+    HANDLE_TABLE *table = (HANDLE_TABLE *)*state;
+    static int values [NUM_HANDLES];
+    int i;
+
+    for (i = 0; i < NUM_HANDLES; i++)
+        HandleTableInsert (table, 0x80000000 + i * 3, &values [i], NULL);
+
+    for (i = 0; i < NUM_HANDLES; i += 2)
+        assert_true (HandleTableRemove (table, 0x80000000 + i * 3) == &values [i]);
+    assert_null (HandleTableRemove (table, 0x80000000));
+    assert_int_equal (table->count, NUM_HANDLES / 2);
+
+    for (i = 0; i < NUM_HANDLES; i++) {
+        if (i % 2)
+            assert_true (HandleTableFind (table, 0x80000000 + i * 3) == &values [i]);
+        else
+            assert_null (HandleTableFind (table, 0x80000000 + i * 3));
+    }
+}
+
+/* The entity API is no longer limited to a fixed number of entries. */
+static void
+entity_no_limit (void **state)
+{
+    TPM2B_AUTH auth, out;
+    ENTITY *entity;
+    TPM_RC rc;
+    int i;
+
+    InitEntities ();
+    for (i = 0; i < NUM_HANDLES; i++) {
+        auth.t.size = 4;
+        memcpy (auth.t.buffer, &i, 4);
+        rc = AddEntity (0x01500000 + i, &auth);
+        assert_int_equal (rc, TPM_RC_SUCCESS);
+    }
+    assert_int_equal (GetEntityCount (), NUM_HANDLES);
+
+    for (i = 0; i < NUM_HANDLES; i++) {
+        rc = GetEntityAuth (0x01500000 + i, &out);
+        assert_int_equal (rc, TPM_RC_SUCCESS);
+        assert_int_equal (out.t.size, 4);
+        assert_memory_equal (out.t.buffer, &i, 4);
+    }
+
+    rc = GetEntity (0x01500010, &entity);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_int_equal (entity->entityHandle, 0x01500010);
+    entity->nvNameChanged = 1;
+
+    /* Adding an existing handle updates it in place. */
+    auth.t.size = 0;
+    rc = AddEntity (0x01500010, &auth);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_int_equal (GetEntityCount (), NUM_HANDLES);
+    assert_int_equal (entity->entityAuth.t.size, 0);
+    assert_int_equal (entity->nvNameChanged, 0);
+
+    rc = DeleteEntity (0x01500010);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    rc = DeleteEntity (0x01500010);
+    assert_int_equal (rc, TPM_RC_FAILURE);
+    rc = GetEntityAuth (0x01500010, &out);
+    assert_int_equal (rc, TPM_RC_FAILURE);
+
+    InitEntities ();
+    assert_int_equal (GetEntityCount (), 0);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (handle_table_insert_find,
+                                  handle_table_setup,
+                                  handle_table_teardown),
+        unit_test_setup_teardown (handle_table_remove,
+                                  handle_table_setup,
+                                  handle_table_teardown),
+        unit_test (entity_no_limit),
+    };
+    return run_tests (tests);
+}
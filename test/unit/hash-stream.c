@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include "fake-tpm.h"
+
+TSS2_TCTI_CONTEXT *resMgrTctiContext = NULL;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+#define SEQUENCE_HANDLE 0x80000010
+#define HMAC_KEY        0x80000001
+#define DATA_SIZE       8192
+
+/*
+ * A TCTI that plays a TPM with a single sequence object.  The "digest" it
+ * returns is the byte count followed by a byte sum; the test compares the
+ * bytes the TPM saw instead.
+ */
+typedef struct {
+    fake_tpm_t base;
+    UINT8 seen [DATA_SIZE];
+    UINT32 seenSize;
+    UINT32 failUpdate;          /* SequenceUpdate with this number fails */
+    int open;
+    int updates;
+    int completes;
+    int flushes;
+    TPM_HANDLE startHandle;
+} hash_tpm_t;
+
+/* Skips the authorization area, checking it holds one empty password. */
+static const UINT8 *
+skip_auths (const UINT8 *p)
+{
+    assert_int_equal (get32 (p), 9);
+    assert_int_equal (get32 (p + 4), TPM_RS_PW);
+    return p + 4 + 9;
+}
+
+static UINT8 *
+rsp_auths (UINT8 *r, UINT8 *params)
+{
+    put32 (params, r - params - 4);
+    r = put16 (r, 0);
+    *r++ = 0;
+    return put16 (r, 0);
+}
+
+static void
+absorb (hash_tpm_t *tpm, const UINT8 *p)
+{
+    UINT16 size = get16 (p);
+
+    assert_true (size <= MAX_DIGEST_BUFFER);
+    assert_true (tpm->seenSize + size <= DATA_SIZE);
+    memcpy (tpm->seen + tpm->seenSize, p + 2, size);
+    tpm->seenSize += size;
+}
+
+static void
+hash_command (fake_tpm_t *base, const UINT8 *command, size_t size)
+{
+    hash_tpm_t *tpm = (hash_tpm_t *)base;
+    TPM_CC cc = get32 (command + 6);
+    const UINT8 *p = command + 10;
+    UINT8 *r = tpm->base.response + 10, *params;
+    UINT32 sum = 0, i;
+
+    switch (cc) {
+    case TPM_CC_HashSequenceStart:
+    case TPM_CC_HMAC_Start:
+        assert_false (tpm->open);
+        tpm->open = 1;
+        tpm->seenSize = 0;
+        if (cc == TPM_CC_HMAC_Start) {
+            tpm->startHandle = get32 (p);
+            skip_auths (p + 4);
+            r = put32 (r, SEQUENCE_HANDLE);
+            r = rsp_auths (r + 4, r);
+            fake_tpm_respond (&tpm->base, TPM_ST_SESSIONS, TPM_RC_SUCCESS, r);
+        } else {
+            tpm->startHandle = TPM_RH_NULL;
+            r = put32 (r, SEQUENCE_HANDLE);
+            fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_SUCCESS, r);
+        }
+        break;
+
+    case TPM_CC_SequenceUpdate:
+        assert_true (tpm->open);
+        assert_int_equal (get32 (p), SEQUENCE_HANDLE);
+        p = skip_auths (p + 4);
+        assert_int_equal (get16 (p), MAX_DIGEST_BUFFER);
+        if (++tpm->updates == tpm->failUpdate) {
+            fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_FAILURE, r);
+            break;
+        }
+        absorb (tpm, p);
+        params = r;
+        r = rsp_auths (r + 4, params);
+        fake_tpm_respond (&tpm->base, TPM_ST_SESSIONS, TPM_RC_SUCCESS, r);
+        break;
+
+    case TPM_CC_SequenceComplete:
+        assert_true (tpm->open);
+        assert_int_equal (get32 (p), SEQUENCE_HANDLE);
+        p = skip_auths (p + 4);
+        absorb (tpm, p);
+        tpm->open = 0;
+        tpm->completes++;
+        for (i = 0; i < tpm->seenSize; i++)
+            sum += tpm->seen [i];
+        params = r;
+        r += 4;
+        r = put16 (r, 8);
+        r = put32 (r, tpm->seenSize);
+        r = put32 (r, sum);
+        r = put16 (r, TPM_ST_HASHCHECK);
+        r = put32 (r, TPM_RH_NULL);
+        r = put16 (r, 0);
+        r = rsp_auths (r, params);
+        fake_tpm_respond (&tpm->base, TPM_ST_SESSIONS, TPM_RC_SUCCESS, r);
+        break;
+
+    case TPM_CC_FlushContext:
+        assert_int_equal (get32 (p), SEQUENCE_HANDLE);
+        tpm->open = 0;
+        tpm->flushes++;
+        fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_SUCCESS, r);
+        break;
+
+    default:
+        fail ();
+    }
+}
+
+typedef struct {
+    hash_tpm_t tpm;
+    HASH_STREAM stream;
+    TPM2B_DIGEST result;
+    UINT8 in [DATA_SIZE];
+} hash_stream_data_t;
+
+static void
+hash_stream_setup (void **state)
+{
+    hash_stream_data_t *data = calloc (1, sizeof (hash_stream_data_t));
+    UINT32 i;
+
+    fake_tpm_init (&data->tpm.base, hash_command);
+
+    for (i = 0; i < sizeof (data->in); i++)
+        data->in [i] = (UINT8)(i * 7 + (i >> 8));
+
+    *state = data;
+}
+
+static void
+hash_stream_teardown (void **state)
+{
+    free (*state);
+}
+
+static TSS2_RC
+stream_start (hash_stream_data_t *data, TPMI_DH_OBJECT hmacKey)
+{
+    return HashStreamStart (&data->stream, (TSS2_TCTI_CONTEXT *)&data->tpm,
+                            TPM_ALG_SHA256, hmacKey, NULL);
+}
+
+static void
+assert_result (hash_stream_data_t *data, UINT32 size)
+{
+    UINT32 sum = 0, i;
+
+    assert_int_equal (data->tpm.seenSize, size);
+    assert_memory_equal (data->tpm.seen, data->in, size);
+    for (i = 0; i < size; i++)
+        sum += data->in [i];
+    assert_int_equal (data->result.t.size, 8);
+    assert_int_equal (get32 (data->result.t.buffer), size);
+    assert_int_equal (get32 (data->result.t.buffer + 4), sum);
+    assert_false (data->tpm.open);
+    assert_false (data->tpm.base.pending);
+}
+
+/*
+ * Small buffers are gathered into full chunks; the last chunk, even a
+ * full one, goes out with SequenceComplete.
+ */
+static void
+hash_stream_coalesce (void **state)
+{
+    hash_stream_data_t *data = (hash_stream_data_t *)*state;
+    TSS2_RC rc;
+    int i;
+
+    rc = stream_start (data, HMAC_KEY);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.startHandle, HMAC_KEY);
+
+    for (i = 0; i < 7; i++) {
+        rc = HashStreamUpdate (&data->stream, data->in + i * 100, 100);
+        assert_int_equal (rc, TSS2_RC_SUCCESS);
+    }
+    rc = HashStreamUpdate (&data->stream, data->in + 700, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdate (&data->stream, data->in + 700, 2000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.updates, 2);
+    assert_int_equal (data->stream.updates, 2);
+    assert_result (data, 2700);
+}
+
+static void
+hash_stream_chunk_boundary (void **state)
+{
+    hash_stream_data_t *data = (hash_stream_data_t *)*state;
+    TPMT_TK_HASHCHECK validation;
+    TSS2_RC rc;
+
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.startHandle, TPM_RH_NULL);
+    rc = HashStreamUpdate (&data->stream, data->in, MAX_DIGEST_BUFFER);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, &validation);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.updates, 0);
+    assert_int_equal (validation.tag, TPM_ST_HASHCHECK);
+    assert_result (data, MAX_DIGEST_BUFFER);
+
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdate (&data->stream, data->in, MAX_DIGEST_BUFFER * 2);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.updates, 1);
+    assert_result (data, MAX_DIGEST_BUFFER * 2);
+
+    /* Nothing at all. */
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_result (data, 0);
+}
+
+/* Data read from a descriptor, after some handed in directly. */
+static void
+hash_stream_fd (void **state)
+{
+    hash_stream_data_t *data = (hash_stream_data_t *)*state;
+    int fds [2];
+    TSS2_RC rc;
+
+    assert_int_equal (pipe (fds), 0);
+    assert_int_equal (write (fds [1], data->in + 300, 5000), 5000);
+    close (fds [1]);
+
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdate (&data->stream, data->in, 300);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdateFd (&data->stream, fds [0]);
+    close (fds [0]);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.updates, 5);
+    assert_result (data, 5300);
+}
+
+/*
+ * A failed update is reported by the next call that collects it, and the
+ * sequence is flushed; so is one abandoned after a read error.
+ */
+static void
+hash_stream_errors (void **state)
+{
+    hash_stream_data_t *data = (hash_stream_data_t *)*state;
+    TSS2_RC rc;
+
+    data->tpm.failUpdate = 2;
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdate (&data->stream, data->in, MAX_DIGEST_BUFFER * 2 + 1);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamComplete (&data->stream, TPM_RH_NULL, &data->result, NULL);
+    assert_int_equal (rc, TPM_RC_FAILURE);
+    assert_int_equal (data->result.t.size, 0);
+    assert_int_equal (data->tpm.completes, 0);
+    assert_int_equal (data->tpm.flushes, 1);
+    assert_false (data->tpm.open);
+    assert_false (data->tpm.base.pending);
+
+    rc = stream_start (data, TPM_RH_NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = HashStreamUpdateFd (&data->stream, -1);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_IO_ERROR));
+    HashStreamAbort (&data->stream);
+    assert_int_equal (data->tpm.flushes, 2);
+    assert_false (data->tpm.open);
+
+    rc = HashStreamUpdate (NULL, data->in, 1);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_REFERENCE);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (hash_stream_coalesce,
+                                  hash_stream_setup,
+                                  hash_stream_teardown),
+        unit_test_setup_teardown (hash_stream_chunk_boundary,
+                                  hash_stream_setup,
+                                  hash_stream_teardown),
+        unit_test_setup_teardown (hash_stream_fd,
+                                  hash_stream_setup,
+                                  hash_stream_teardown),
+        unit_test_setup_teardown (hash_stream_errors,
+                                  hash_stream_setup,
+                                  hash_stream_teardown),
+    };
+    return run_tests (tests);
+}
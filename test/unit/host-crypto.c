@@ -0,0 +1,320 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+
+static void
+hex_to_bin (const char *hex, BYTE *bin, UINT16 *size)
+{
+    unsigned int byte;
+
+    for (*size = 0; hex [0] != '\0' && hex [1] != '\0'; hex += 2) {
+        sscanf (hex, "%2x", &byte);
+        bin [(*size)++] = (BYTE)byte;
+    }
+}
+
+static void
+assert_digest (TPM2B_DIGEST *digest, const char *expected)
+{
+    BYTE bin [sizeof (TPMU_HA)];
+    UINT16 size;
+
+    hex_to_bin (expected, bin, &size);
+    assert_int_equal (digest->t.size, size);
+    assert_memory_equal (digest->t.buffer, bin, size);
+}
+
+typedef struct {
+    TPMI_ALG_HASH hashAlg;
+    const char   *message;
+    const char   *digest;
+} hash_vector_t;
+
+static const hash_vector_t hash_vectors [] = {
+    { TPM_ALG_SHA1, "abc",
+      "a9993e364706816aba3e25717850c26c9cd0d89d" },
+    { TPM_ALG_SHA1, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+    { TPM_ALG_SHA256, "abc",
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { TPM_ALG_SHA256, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { TPM_ALG_SHA384, "abc",
+      "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed"
+      "8086072ba1e7cc2358baeca134c825a7" },
+    { TPM_ALG_SHA512, "abc",
+      "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+      "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" },
+};
+
+/* FIPS 180 example vectors, with and without the SHA extensions. */
+static void
+host_hash_known_answer (void **state)
+{
+    TPM2B_DIGEST digest;
+    size_t i;
+    int accel;
+    UINT32 rc;
+
+    for (accel = 0; accel <= 1; accel++) {
+        HostCryptoUseAcceleration (accel);
+        for (i = 0; i < sizeof (hash_vectors) / sizeof (hash_vectors [0]); i++) {
+            rc = HostHash (hash_vectors [i].hashAlg,
+                           strlen (hash_vectors [i].message),
+                           (BYTE *)hash_vectors [i].message, &digest);
+            assert_int_equal (rc, TPM_RC_SUCCESS);
+            assert_digest (&digest, hash_vectors [i].digest);
+        }
+    }
+}
+
+/*
+ * The accelerated SHA-1/SHA-256 code must agree with the portable code for
+ * every length around the block and padding boundaries.
+ */
+static void
+host_hash_accel_matches_portable (void **state)
+{
+    static const TPMI_ALG_HASH algs [] = { TPM_ALG_SHA1, TPM_ALG_SHA256 };
+    BYTE data [300];
+    TPM2B_DIGEST portable, accel;
+    UINT16 size;
+    size_t i;
+
+    for (size = 0; size < sizeof (data); size++)
+        data [size] = (BYTE)(size * 31 + 7);
+
+    for (i = 0; i < sizeof (algs) / sizeof (algs [0]); i++) {
+        for (size = 0; size <= sizeof (data); size++) {
+            HostCryptoUseAcceleration (0);
+            HostHash (algs [i], size, data, &portable);
+            HostCryptoUseAcceleration (1);
+            HostHash (algs [i], size, data, &accel);
+            assert_int_equal (portable.t.size, accel.t.size);
+            assert_memory_equal (portable.t.buffer, accel.t.buffer, portable.t.size);
+        }
+    }
+}
+
+/* RFC 2202 / RFC 4231 test cases 2 and 6; the data is split across buffers. */
+static void
+host_hmac_known_answer (void **state)
+{
+    static const char longKeyData [] = "Test Using Larger Than Block-Size Key - Hash Key First";
+    TPM2B_DIGEST key, part1, part2, digest;
+    TPM2B_MAX_BUFFER longKey, longData;
+    TPM2B *bufferList [3];
+    UINT32 rc;
+
+    key.t.size = 4;
+    memcpy (key.t.buffer, "Jefe", 4);
+    part1.t.size = 8;
+    memcpy (part1.t.buffer, "what do ", 8);
+    part2.t.size = 20;
+    memcpy (part2.t.buffer, "ya want for nothing?", 20);
+    bufferList [0] = &part1.b;
+    bufferList [1] = &part2.b;
+    bufferList [2] = NULL;
+
+    rc = HostHmac (TPM_ALG_SHA1, &key.b, bufferList, &digest);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_digest (&digest, "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+
+    rc = HostHmac (TPM_ALG_SHA256, &key.b, bufferList, &digest);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_digest (&digest, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    rc = HostHmac (TPM_ALG_SHA512, &key.b, bufferList, &digest);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_digest (&digest,
+                   "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea250554"
+                   "9758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737");
+
+    longKey.t.size = 131;
+    memset (longKey.t.buffer, 0xaa, longKey.t.size);
+    longData.t.size = strlen (longKeyData);
+    memcpy (longData.t.buffer, longKeyData, longData.t.size);
+    bufferList [0] = &longData.b;
+    bufferList [1] = NULL;
+
+    rc = HostHmac (TPM_ALG_SHA256, &longKey.b, bufferList, &digest);
+    assert_int_equal (rc, TPM_RC_SUCCESS);
+    assert_digest (&digest, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
+static void
+host_crypto_bad_algorithm (void **state)
+{
+    TPM2B_DIGEST digest;
+    TPM2B *bufferList [1] = { NULL };
+    UINT32 rc;
+
+    rc = HostHash (TPM_ALG_SM3_256, 0, NULL, &digest);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_ALGORITHM);
+    assert_int_equal (digest.t.size, 0);
+
+    rc = HostHmac (TPM_ALG_NULL, NULL, bufferList, &digest);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_ALGORITHM);
+    assert_int_equal (digest.t.size, 0);
+}
+
+typedef struct {
+    const char *key;
+    const char *iv;
+    const char *plain;
+    const char *cipher;
+} aes_vector_t;
+
+/*
+ * FIPS-197 appendix C (CFB with IV = plaintext over a zero block gives the
+ * raw block encryption) and SP 800-38A F.3.13 / F.3.17.
+ */
+static const aes_vector_t aes_vectors [] = {
+    { "000102030405060708090a0b0c0d0e0f",
+      "00112233445566778899aabbccddeeff",
+      "00000000000000000000000000000000",
+      "69c4e0d86a7b0430d8cdb78070b4c55a" },
+    { "000102030405060708090a0b0c0d0e0f1011121314151617",
+      "00112233445566778899aabbccddeeff",
+      "00000000000000000000000000000000",
+      "dda97ca4864cdfe06eaf70a0ec0d7191" },
+    { "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+      "00112233445566778899aabbccddeeff",
+      "00000000000000000000000000000000",
+      "8ea2b7ca516745bfeafc49904b496089" },
+    { "2b7e151628aed2a6abf7158809cf4f3c",
+      "000102030405060708090a0b0c0d0e0f",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+      "3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b"
+      "26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6" },
+    { "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+      "000102030405060708090a0b0c0d0e0f",
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710",
+      "dc7e84bfda79164b7ecd8486985d386039ffed143b28b1c832113c6331e5407b"
+      "df10132415e54b92a13ed0a8267ae2f975a385741ab9cef82031623d55b1e471" },
+};
+
+/* Encrypt and decrypt each vector in place, with and without AES-NI. */
+static void
+host_aes_cfb_known_answer (void **state)
+{
+    TPM2B_MAX_BUFFER key;
+    TPM2B_IV iv;
+    BYTE data [64], plain [64], cipher [64];
+    UINT16 plainSize, cipherSize;
+    size_t i;
+    int accel;
+    TSS2_RC rc;
+
+    for (accel = 0; accel <= 1; accel++) {
+        HostCryptoUseAcceleration (accel);
+        for (i = 0; i < sizeof (aes_vectors) / sizeof (aes_vectors [0]); i++) {
+            hex_to_bin (aes_vectors [i].key, key.t.buffer, &key.t.size);
+            hex_to_bin (aes_vectors [i].plain, plain, &plainSize);
+            hex_to_bin (aes_vectors [i].cipher, cipher, &cipherSize);
+            assert_int_equal (plainSize, cipherSize);
+
+            hex_to_bin (aes_vectors [i].iv, iv.t.buffer, &iv.t.size);
+            memcpy (data, plain, plainSize);
+            rc = HostAesCfb (NO, &key.b, &iv, data, plainSize);
+            assert_int_equal (rc, TSS2_RC_SUCCESS);
+            assert_memory_equal (data, cipher, cipherSize);
+
+            hex_to_bin (aes_vectors [i].iv, iv.t.buffer, &iv.t.size);
+            rc = HostAesCfb (YES, &key.b, &iv, data, cipherSize);
+            assert_int_equal (rc, TSS2_RC_SUCCESS);
+            assert_memory_equal (data, plain, plainSize);
+        }
+    }
+}
+
+/*
+ * Partial final blocks: every length must round-trip and agree with the
+ * leading bytes of the full-block encryption.
+ */
+static void
+host_aes_cfb_partial_block (void **state)
+{
+    TPM2B_MAX_BUFFER key;
+    TPM2B_IV iv;
+    BYTE full [80], data [80];
+    UINT16 size;
+    int accel;
+    TSS2_RC rc;
+
+    key.t.size = 16;
+    for (size = 0; size < key.t.size; size++)
+        key.t.buffer [size] = (BYTE)(size + 1);
+
+    for (accel = 0; accel <= 1; accel++) {
+        HostCryptoUseAcceleration (accel);
+        for (size = 0; size < sizeof (full); size++)
+            full [size] = (BYTE)(size * 13);
+        iv.t.size = 16;
+        memset (iv.t.buffer, 0x5a, iv.t.size);
+        rc = HostAesCfb (NO, &key.b, &iv, full, sizeof (full));
+        assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+        for (size = 0; size <= sizeof (data); size++) {
+            UINT16 j;
+
+            for (j = 0; j < size; j++)
+                data [j] = (BYTE)(j * 13);
+            memset (iv.t.buffer, 0x5a, iv.t.size);
+            rc = HostAesCfb (NO, &key.b, &iv, data, size);
+            assert_int_equal (rc, TSS2_RC_SUCCESS);
+            assert_memory_equal (data, full, size);
+
+            memset (iv.t.buffer, 0x5a, iv.t.size);
+            rc = HostAesCfb (YES, &key.b, &iv, data, size);
+            assert_int_equal (rc, TSS2_RC_SUCCESS);
+            for (j = 0; j < size; j++)
+                assert_int_equal (data [j], (BYTE)(j * 13));
+        }
+    }
+}
+
+static void
+host_aes_cfb_bad_params (void **state)
+{
+    TPM2B_MAX_BUFFER key;
+    TPM2B_IV iv;
+    BYTE data [16] = { 0 };
+    TSS2_RC rc;
+
+    key.t.size = 20;
+    memset (key.t.buffer, 0, key.t.size);
+    iv.t.size = 16;
+    memset (iv.t.buffer, 0, iv.t.size);
+    rc = HostAesCfb (NO, &key.b, &iv, data, sizeof (data));
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_SIZE));
+
+    key.t.size = 16;
+    iv.t.size = 8;
+    rc = HostAesCfb (NO, &key.b, &iv, data, sizeof (data));
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_SIZE));
+
+    rc = HostAesCfb (NO, NULL, &iv, data, sizeof (data));
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_REFERENCE));
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test (host_hash_known_answer),
+        unit_test (host_hash_accel_matches_portable),
+        unit_test (host_hmac_known_answer),
+        unit_test (host_crypto_bad_algorithm),
+        unit_test (host_aes_cfb_known_answer),
+        unit_test (host_aes_cfb_partial_block),
+        unit_test (host_aes_cfb_bad_params),
+    };
+    return run_tests (tests);
+}
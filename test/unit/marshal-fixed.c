@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+
+#include "sys_api_marshalUnmarshal.h"
+#include "sysapi_util.h"
+
+/*
+ * Size of the fixed region used by these tests: a UINT64, two UINT32s, a
+ * UINT16 and a UINT8. This is the same shape as the fixed prefix of
+ * TPMS_CLOCK_INFO plus a trailing UINT16.
+ */
+#define FIXED_REGION_SIZE \
+    (sizeof (UINT64) + 2 * sizeof (UINT32) + sizeof (UINT16) + sizeof (UINT8))
+
+typedef struct {
+    uint8_t  slow [FIXED_REGION_SIZE];
+    uint8_t  fast [FIXED_REGION_SIZE];
+    TSS2_RC  rc;
+} marshal_fixed_data_t;
+
+void
+marshal_fixed_setup (void **state)
+{
+    marshal_fixed_data_t *data;
+
+    data     = calloc (1, sizeof (marshal_fixed_data_t));
+    data->rc = TSS2_RC_SUCCESS;
+
+    *state = data;
+}
+
+void
+marshal_fixed_teardown (void **state)
+{
+    if (*state)
+        free (*state);
+}
+/**
+ * Marshal the same values through the checked Marshal_* functions and the
+ * CheckFixedRegion / Put_* fast path. The resulting byte streams must be
+ * identical and both must advance nextData to the end of the region.
+ */
+void
+marshal_fixed_matches_checked (void **state)
+{
+    marshal_fixed_data_t *data = (marshal_fixed_data_t*)*state;
+    uint8_t *slowNext = data->slow, *fastNext = data->fast;
+    TSS2_RC slowRc = TSS2_RC_SUCCESS;
+
+    Marshal_UINT64 (data->slow, sizeof (data->slow), &slowNext,
+                    0x0102030405060708ULL, &slowRc);
+    Marshal_UINT32 (data->slow, sizeof (data->slow), &slowNext,
+                    0xdeadbeef, &slowRc);
+    Marshal_UINT32 (data->slow, sizeof (data->slow), &slowNext,
+                    0x40000001, &slowRc);
+    Marshal_UINT16 (data->slow, sizeof (data->slow), &slowNext,
+                    0xa55a, &slowRc);
+    Marshal_UINT8 (data->slow, sizeof (data->slow), &slowNext,
+                   0x7f, &slowRc);
+    assert_int_equal (slowRc, TSS2_RC_SUCCESS);
+
+    CheckFixedRegion (data->fast, sizeof (data->fast), &fastNext,
+                      FIXED_REGION_SIZE, &data->rc);
+    assert_int_equal (data->rc, TSS2_RC_SUCCESS);
+    Put_UINT64 (&fastNext, 0x0102030405060708ULL);
+    Put_UINT32 (&fastNext, 0xdeadbeef);
+    Put_UINT32 (&fastNext, 0x40000001);
+    Put_UINT16 (&fastNext, 0xa55a);
+    Put_UINT8 (&fastNext, 0x7f);
+
+    assert_memory_equal (data->slow, data->fast, FIXED_REGION_SIZE);
+    assert_int_equal (slowNext - data->slow, fastNext - data->fast);
+}
+/**
+ * Unmarshal a known big-endian byte stream with the Get_* helpers and check
+ * that the host values are what the checked Unmarshal_* functions return.
+ */
+void
+unmarshal_fixed_matches_checked (void **state)
+{
+    marshal_fixed_data_t *data = (marshal_fixed_data_t*)*state;
+    uint8_t *slowNext = data->slow, *fastNext = data->slow;
+    TSS2_RC slowRc = TSS2_RC_SUCCESS;
+    UINT64 u64;
+    UINT32 u32a, u32b;
+    UINT16 u16;
+    UINT8 u8;
+    size_t i;
+
+    for (i = 0; i < sizeof (data->slow); i++)
+        data->slow [i] = (uint8_t)(0xf0 - i * 7);
+
+    Unmarshal_UINT64 (data->slow, sizeof (data->slow), &slowNext, &u64, &slowRc);
+    Unmarshal_UINT32 (data->slow, sizeof (data->slow), &slowNext, &u32a, &slowRc);
+    Unmarshal_UINT32 (data->slow, sizeof (data->slow), &slowNext, &u32b, &slowRc);
+    Unmarshal_UINT16 (data->slow, sizeof (data->slow), &slowNext, &u16, &slowRc);
+    Unmarshal_UINT8 (data->slow, sizeof (data->slow), &slowNext, &u8, &slowRc);
+    assert_int_equal (slowRc, TSS2_RC_SUCCESS);
+
+    CheckFixedRegion (data->slow, sizeof (data->slow), &fastNext,
+                      FIXED_REGION_SIZE, &data->rc);
+    assert_int_equal (data->rc, TSS2_RC_SUCCESS);
+    assert_true (Get_UINT64 (&fastNext) == u64);
+    assert_int_equal (Get_UINT32 (&fastNext), u32a);
+    assert_int_equal (Get_UINT32 (&fastNext), u32b);
+    assert_int_equal (Get_UINT16 (&fastNext), u16);
+    assert_int_equal (Get_UINT8 (&fastNext), u8);
+    assert_int_equal (fastNext, slowNext);
+}
+/**
+ * A region one byte larger than the remaining buffer must be rejected with
+ * TSS2_SYS_RC_INSUFFICIENT_CONTEXT, exactly as the last of the equivalent
+ * checked calls would be, and nextData must not move.
+ */
+void
+marshal_fixed_too_small (void **state)
+{
+    marshal_fixed_data_t *data = (marshal_fixed_data_t*)*state;
+    uint8_t *nextData = data->fast + sizeof (UINT32);
+    TSS2_RC rc;
+
+    rc = CheckFixedRegion (data->fast, sizeof (data->fast), &nextData,
+                           FIXED_REGION_SIZE, &data->rc);
+    assert_int_equal (rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+    assert_int_equal (data->rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+    assert_int_equal (nextData, data->fast + sizeof (UINT32));
+}
+/**
+ * nextData before the start of the buffer is a bad reference.
+ */
+void
+marshal_fixed_under_ptr (void **state)
+{
+    marshal_fixed_data_t *data = (marshal_fixed_data_t*)*state;
+    uint8_t *nextData = data->fast - sizeof (uint8_t);
+
+    CheckFixedRegion (data->fast, sizeof (data->fast), &nextData,
+                      sizeof (UINT16), &data->rc);
+    assert_int_equal (data->rc, TSS2_SYS_RC_BAD_REFERENCE);
+}
+/**
+ * An error already recorded in 'rc' is preserved and returned; no other
+ * parameter is looked at.
+ */
+void
+marshal_fixed_rc_previous_fail (void **state)
+{
+    TSS2_RC rc = TSS2_SYS_RC_BAD_SIZE;
+
+    assert_int_equal (CheckFixedRegion (NULL, 0, NULL, 4, &rc),
+                      TSS2_SYS_RC_BAD_SIZE);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_SIZE);
+}
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (marshal_fixed_matches_checked,
+                                  marshal_fixed_setup,
+                                  marshal_fixed_teardown),
+        unit_test_setup_teardown (unmarshal_fixed_matches_checked,
+                                  marshal_fixed_setup,
+                                  marshal_fixed_teardown),
+        unit_test_setup_teardown (marshal_fixed_too_small,
+                                  marshal_fixed_setup,
+                                  marshal_fixed_teardown),
+        unit_test_setup_teardown (marshal_fixed_under_ptr,
+                                  marshal_fixed_setup,
+                                  marshal_fixed_teardown),
+        unit_test (marshal_fixed_rc_previous_fail),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,571 @@
+#include <string.h>
+
+#include <tpm20.h>
+
+#include "sysapi_util.h"
+#include "marshal-reference.h"
+
+/*
+ * Like the functions they stand in for, these trust the counts they
+ * unmarshal: they are only ever given well-formed input.
+ */
+#define IN_ARGS  SYS_CONTEXT->tpmInBuffPtr, SYS_CONTEXT->maxCommandSize, &SYS_CONTEXT->nextData
+#define OUT_ARGS SYS_CONTEXT->tpmOutBuffPtr, SYS_CONTEXT->maxResponseSize, &SYS_CONTEXT->nextData
+#define RVAL     &SYS_CONTEXT->rval
+
+static void
+put8 (TSS2_SYS_CONTEXT *sysContext, UINT8 value)
+{
+    Marshal_UINT8 (IN_ARGS, value, RVAL);
+}
+
+static void
+put16 (TSS2_SYS_CONTEXT *sysContext, UINT16 value)
+{
+    Marshal_UINT16 (IN_ARGS, value, RVAL);
+}
+
+static void
+put32 (TSS2_SYS_CONTEXT *sysContext, UINT32 value)
+{
+    Marshal_UINT32 (IN_ARGS, value, RVAL);
+}
+
+static void
+put_tpm2b (TSS2_SYS_CONTEXT *sysContext, const TPM2B *value)
+{
+    Marshal_Simple_TPM2B (IN_ARGS, (TPM2B *)value, RVAL);
+}
+
+static void
+get8 (TSS2_SYS_CONTEXT *sysContext, UINT8 *value)
+{
+    Unmarshal_UINT8 (OUT_ARGS, value, RVAL);
+}
+
+static void
+get16 (TSS2_SYS_CONTEXT *sysContext, UINT16 *value)
+{
+    Unmarshal_UINT16 (OUT_ARGS, value, RVAL);
+}
+
+static void
+get32 (TSS2_SYS_CONTEXT *sysContext, UINT32 *value)
+{
+    Unmarshal_UINT32 (OUT_ARGS, value, RVAL);
+}
+
+static void
+get_tpm2b (TSS2_SYS_CONTEXT *sysContext, TPM2B *value)
+{
+    Unmarshal_Simple_TPM2B_NoSizeCheck (OUT_ARGS, value, RVAL);
+}
+
+/* TPMT_SYM_DEF_OBJECT: the key size and the mode depend on the algorithm. */
+static void
+marshal_sym_def_object (TSS2_SYS_CONTEXT *sysContext,
+                        const TPMT_SYM_DEF_OBJECT *sym)
+{
+    put16 (sysContext, sym->algorithm);
+    switch (sym->algorithm) {
+#ifdef TPM_ALG_AES
+    case TPM_ALG_AES:
+#endif
+#ifdef TPM_ALG_SM4
+    case TPM_ALG_SM4:
+#endif
+#ifdef TPM_ALG_CAMELLIA
+    case TPM_ALG_CAMELLIA:
+#endif
+        put16 (sysContext, sym->keyBits.sym);
+        put16 (sysContext, sym->mode.sym);
+        break;
+#ifdef TPM_ALG_XOR
+    case TPM_ALG_XOR:
+#endif
+        put16 (sysContext, sym->keyBits.exclusiveOr);
+        break;
+    }
+}
+
+static void
+unmarshal_sym_def_object (TSS2_SYS_CONTEXT *sysContext,
+                          TPMT_SYM_DEF_OBJECT *sym)
+{
+    get16 (sysContext, &sym->algorithm);
+    switch (sym->algorithm) {
+#ifdef TPM_ALG_AES
+    case TPM_ALG_AES:
+#endif
+#ifdef TPM_ALG_SM4
+    case TPM_ALG_SM4:
+#endif
+#ifdef TPM_ALG_CAMELLIA
+    case TPM_ALG_CAMELLIA:
+#endif
+        get16 (sysContext, &sym->keyBits.sym);
+        get16 (sysContext, &sym->mode.sym);
+        break;
+#ifdef TPM_ALG_XOR
+    case TPM_ALG_XOR:
+#endif
+        get16 (sysContext, &sym->keyBits.exclusiveOr);
+        break;
+    }
+}
+
+/* TPMT_RSA_SCHEME and TPMT_ECC_SCHEME: a scheme and its TPMU_ASYM_SCHEME. */
+static void
+marshal_asym_scheme (TSS2_SYS_CONTEXT *sysContext, TPMI_ALG_ASYM_SCHEME scheme,
+                     const TPMU_ASYM_SCHEME *details)
+{
+    put16 (sysContext, scheme);
+    switch (scheme) {
+#ifdef TPM_ALG_ECDAA
+    case TPM_ALG_ECDAA:
+#endif
+        put16 (sysContext, details->ecdaa.hashAlg);
+        put16 (sysContext, details->ecdaa.count);
+        break;
+#ifdef TPM_ALG_ECDH
+    case TPM_ALG_ECDH:
+#endif
+#ifdef TPM_ALG_ECMQV
+    case TPM_ALG_ECMQV:
+#endif
+#ifdef TPM_ALG_RSASSA
+    case TPM_ALG_RSASSA:
+#endif
+#ifdef TPM_ALG_RSAPSS
+    case TPM_ALG_RSAPSS:
+#endif
+#ifdef TPM_ALG_ECDSA
+    case TPM_ALG_ECDSA:
+#endif
+#ifdef TPM_ALG_SM2
+    case TPM_ALG_SM2:
+#endif
+#ifdef TPM_ALG_ECSCHNORR
+    case TPM_ALG_ECSCHNORR:
+#endif
+#ifdef TPM_ALG_OAEP
+    case TPM_ALG_OAEP:
+#endif
+        put16 (sysContext, details->anySig.hashAlg);
+        break;
+    }
+}
+
+static void
+unmarshal_asym_scheme (TSS2_SYS_CONTEXT *sysContext,
+                       TPMI_ALG_ASYM_SCHEME *scheme, TPMU_ASYM_SCHEME *details)
+{
+    get16 (sysContext, scheme);
+    switch (*scheme) {
+#ifdef TPM_ALG_ECDAA
+    case TPM_ALG_ECDAA:
+#endif
+        get16 (sysContext, &details->ecdaa.hashAlg);
+        get16 (sysContext, &details->ecdaa.count);
+        break;
+#ifdef TPM_ALG_ECDH
+    case TPM_ALG_ECDH:
+#endif
+#ifdef TPM_ALG_ECMQV
+    case TPM_ALG_ECMQV:
+#endif
+#ifdef TPM_ALG_RSASSA
+    case TPM_ALG_RSASSA:
+#endif
+#ifdef TPM_ALG_RSAPSS
+    case TPM_ALG_RSAPSS:
+#endif
+#ifdef TPM_ALG_ECDSA
+    case TPM_ALG_ECDSA:
+#endif
+#ifdef TPM_ALG_SM2
+    case TPM_ALG_SM2:
+#endif
+#ifdef TPM_ALG_ECSCHNORR
+    case TPM_ALG_ECSCHNORR:
+#endif
+#ifdef TPM_ALG_OAEP
+    case TPM_ALG_OAEP:
+#endif
+        get16 (sysContext, &details->anySig.hashAlg);
+        break;
+    }
+}
+
+static int
+kdf_has_hash (TPMI_ALG_KDF scheme)
+{
+    switch (scheme) {
+#ifdef TPM_ALG_MGF1
+    case TPM_ALG_MGF1:
+#endif
+#ifdef TPM_ALG_KDF1_SP800_56A
+    case TPM_ALG_KDF1_SP800_56A:
+#endif
+#ifdef TPM_ALG_KDF2
+    case TPM_ALG_KDF2:
+#endif
+#ifdef TPM_ALG_KDF1_SP800_108
+    case TPM_ALG_KDF1_SP800_108:
+#endif
+        return 1;
+    }
+    return 0;
+}
+
+static void
+marshal_public_area (TSS2_SYS_CONTEXT *sysContext, const TPMT_PUBLIC *area)
+{
+    const TPMU_PUBLIC_PARMS *parms = &area->parameters;
+    UINT32 attributes;
+
+    memcpy (&attributes, &area->objectAttributes, sizeof (attributes));
+    put16 (sysContext, area->type);
+    put16 (sysContext, area->nameAlg);
+    put32 (sysContext, attributes);
+    put_tpm2b (sysContext, &area->authPolicy.b);
+
+    switch (area->type) {
+#ifdef TPM_ALG_KEYEDHASH
+    case TPM_ALG_KEYEDHASH:
+#endif
+        put16 (sysContext, parms->keyedHashDetail.scheme.scheme);
+        switch (parms->keyedHashDetail.scheme.scheme) {
+#ifdef TPM_ALG_HMAC
+        case TPM_ALG_HMAC:
+#endif
+            put16 (sysContext, parms->keyedHashDetail.scheme.details.hmac.hashAlg);
+            break;
+#ifdef TPM_ALG_XOR
+        case TPM_ALG_XOR:
+#endif
+            put16 (sysContext, parms->keyedHashDetail.scheme.details.exclusiveOr.hashAlg);
+            put16 (sysContext, parms->keyedHashDetail.scheme.details.exclusiveOr.kdf);
+            break;
+        }
+        put_tpm2b (sysContext, &area->unique.keyedHash.b);
+        break;
+#ifdef TPM_ALG_SYMCIPHER
+    case TPM_ALG_SYMCIPHER:
+#endif
+        marshal_sym_def_object (sysContext, &parms->symDetail.sym);
+        put_tpm2b (sysContext, &area->unique.sym.b);
+        break;
+#ifdef TPM_ALG_RSA
+    case TPM_ALG_RSA:
+#endif
+        marshal_sym_def_object (sysContext, &parms->rsaDetail.symmetric);
+        marshal_asym_scheme (sysContext, parms->rsaDetail.scheme.scheme,
+                             &parms->rsaDetail.scheme.details);
+        put16 (sysContext, parms->rsaDetail.keyBits);
+        put32 (sysContext, parms->rsaDetail.exponent);
+        put_tpm2b (sysContext, &area->unique.rsa.b);
+        break;
+#ifdef TPM_ALG_ECC
+    case TPM_ALG_ECC:
+#endif
+        marshal_sym_def_object (sysContext, &parms->eccDetail.symmetric);
+        marshal_asym_scheme (sysContext, parms->eccDetail.scheme.scheme,
+                             &parms->eccDetail.scheme.details);
+        put16 (sysContext, parms->eccDetail.curveID);
+        put16 (sysContext, parms->eccDetail.kdf.scheme);
+        if (kdf_has_hash (parms->eccDetail.kdf.scheme))
+            put16 (sysContext, parms->eccDetail.kdf.details.mgf1.hashAlg);
+        put_tpm2b (sysContext, &area->unique.ecc.x.b);
+        put_tpm2b (sysContext, &area->unique.ecc.y.b);
+        break;
+    }
+}
+
+static void
+unmarshal_public_area (TSS2_SYS_CONTEXT *sysContext, TPMT_PUBLIC *area)
+{
+    TPMU_PUBLIC_PARMS *parms = &area->parameters;
+    UINT32 attributes = 0;
+
+    get16 (sysContext, &area->type);
+    get16 (sysContext, &area->nameAlg);
+    get32 (sysContext, &attributes);
+    memcpy (&area->objectAttributes, &attributes, sizeof (attributes));
+    get_tpm2b (sysContext, &area->authPolicy.b);
+
+    switch (area->type) {
+#ifdef TPM_ALG_KEYEDHASH
+    case TPM_ALG_KEYEDHASH:
+#endif
+        get16 (sysContext, &parms->keyedHashDetail.scheme.scheme);
+        switch (parms->keyedHashDetail.scheme.scheme) {
+#ifdef TPM_ALG_HMAC
+        case TPM_ALG_HMAC:
+#endif
+            get16 (sysContext, &parms->keyedHashDetail.scheme.details.hmac.hashAlg);
+            break;
+#ifdef TPM_ALG_XOR
+        case TPM_ALG_XOR:
+#endif
+            get16 (sysContext, &parms->keyedHashDetail.scheme.details.exclusiveOr.hashAlg);
+            get16 (sysContext, &parms->keyedHashDetail.scheme.details.exclusiveOr.kdf);
+            break;
+        }
+        get_tpm2b (sysContext, &area->unique.keyedHash.b);
+        break;
+#ifdef TPM_ALG_SYMCIPHER
+    case TPM_ALG_SYMCIPHER:
+#endif
+        unmarshal_sym_def_object (sysContext, &parms->symDetail.sym);
+        get_tpm2b (sysContext, &area->unique.sym.b);
+        break;
+#ifdef TPM_ALG_RSA
+    case TPM_ALG_RSA:
+#endif
+        unmarshal_sym_def_object (sysContext, &parms->rsaDetail.symmetric);
+        unmarshal_asym_scheme (sysContext, &parms->rsaDetail.scheme.scheme,
+                               &parms->rsaDetail.scheme.details);
+        get16 (sysContext, &parms->rsaDetail.keyBits);
+        get32 (sysContext, &parms->rsaDetail.exponent);
+        get_tpm2b (sysContext, &area->unique.rsa.b);
+        break;
+#ifdef TPM_ALG_ECC
+    case TPM_ALG_ECC:
+#endif
+        unmarshal_sym_def_object (sysContext, &parms->eccDetail.symmetric);
+        unmarshal_asym_scheme (sysContext, &parms->eccDetail.scheme.scheme,
+                               &parms->eccDetail.scheme.details);
+        get16 (sysContext, &parms->eccDetail.curveID);
+        get16 (sysContext, &parms->eccDetail.kdf.scheme);
+        if (kdf_has_hash (parms->eccDetail.kdf.scheme))
+            get16 (sysContext, &parms->eccDetail.kdf.details.mgf1.hashAlg);
+        get_tpm2b (sysContext, &area->unique.ecc.x.b);
+        get_tpm2b (sysContext, &area->unique.ecc.y.b);
+        break;
+    }
+}
+
+void
+ref_marshal_TPM2B_PUBLIC (TSS2_SYS_CONTEXT *sysContext,
+                          const TPM2B_PUBLIC *value)
+{
+    UINT8 *sizePtr = SYS_CONTEXT->nextData;
+
+    put16 (sysContext, value->t.size);
+    marshal_public_area (sysContext, &value->t.publicArea);
+    if (SYS_CONTEXT->rval == TSS2_RC_SUCCESS)
+        *(UINT16 *)sizePtr = CHANGE_ENDIAN_WORD (SYS_CONTEXT->nextData - sizePtr - 2);
+}
+
+void
+ref_unmarshal_TPM2B_PUBLIC (TSS2_SYS_CONTEXT *sysContext, TPM2B_PUBLIC *value)
+{
+    get16 (sysContext, &value->t.size);
+    unmarshal_public_area (sysContext, &value->t.publicArea);
+}
+
+void
+ref_marshal_TPMS_CONTEXT (TSS2_SYS_CONTEXT *sysContext,
+                          const TPMS_CONTEXT *value)
+{
+    Marshal_UINT64 (IN_ARGS, value->sequence, RVAL);
+    put32 (sysContext, value->savedHandle);
+    put32 (sysContext, value->hierarchy);
+    put_tpm2b (sysContext, &value->contextBlob.b);
+}
+
+void
+ref_unmarshal_TPMS_CONTEXT (TSS2_SYS_CONTEXT *sysContext, TPMS_CONTEXT *value)
+{
+    Unmarshal_UINT64 (OUT_ARGS, &value->sequence, RVAL);
+    get32 (sysContext, &value->savedHandle);
+    get32 (sysContext, &value->hierarchy);
+    get_tpm2b (sysContext, &value->contextBlob.b);
+}
+
+void
+ref_marshal_TPML_PCR_SELECTION (TSS2_SYS_CONTEXT *sysContext,
+                                const TPML_PCR_SELECTION *value)
+{
+    UINT32 i, j;
+
+    put32 (sysContext, value->count);
+    for (i = 0; i < value->count; i++) {
+        const TPMS_PCR_SELECTION *selection = &value->pcrSelections [i];
+
+        put16 (sysContext, selection->hash);
+        put8 (sysContext, selection->sizeofSelect);
+        for (j = 0; j < selection->sizeofSelect; j++)
+            put8 (sysContext, selection->pcrSelect [j]);
+    }
+}
+
+void
+ref_unmarshal_TPML_PCR_SELECTION (TSS2_SYS_CONTEXT *sysContext,
+                                  TPML_PCR_SELECTION *value)
+{
+    UINT32 i, j;
+
+    get32 (sysContext, &value->count);
+    for (i = 0; i < value->count; i++) {
+        TPMS_PCR_SELECTION *selection = &value->pcrSelections [i];
+
+        get16 (sysContext, &selection->hash);
+        get8 (sysContext, &selection->sizeofSelect);
+        for (j = 0; j < selection->sizeofSelect; j++)
+            get8 (sysContext, &selection->pcrSelect [j]);
+    }
+}
+
+void
+ref_marshal_TPML_DIGEST (TSS2_SYS_CONTEXT *sysContext, const TPML_DIGEST *value)
+{
+    UINT32 i;
+
+    put32 (sysContext, value->count);
+    for (i = 0; i < value->count; i++)
+        put_tpm2b (sysContext, &value->digests [i].b);
+}
+
+void
+ref_unmarshal_TPML_DIGEST (TSS2_SYS_CONTEXT *sysContext, TPML_DIGEST *value)
+{
+    UINT32 i;
+
+    get32 (sysContext, &value->count);
+    for (i = 0; i < value->count; i++)
+        get_tpm2b (sysContext, &value->digests [i].b);
+}
+
+void
+ref_marshal_TPMS_CAPABILITY_DATA (TSS2_SYS_CONTEXT *sysContext,
+                                  const TPMS_CAPABILITY_DATA *value)
+{
+    const TPMU_CAPABILITIES *data = &value->data;
+    UINT32 attributes, i, j;
+
+    put32 (sysContext, value->capability);
+    switch (value->capability) {
+    case TPM_CAP_ALGS:
+        put32 (sysContext, data->algorithms.count);
+        for (i = 0; i < data->algorithms.count; i++) {
+            put16 (sysContext, data->algorithms.algProperties [i].alg);
+            memcpy (&attributes, &data->algorithms.algProperties [i].algProperties,
+                    sizeof (attributes));
+            put32 (sysContext, attributes);
+        }
+        break;
+    case TPM_CAP_HANDLES:
+        put32 (sysContext, data->handles.count);
+        for (i = 0; i < data->handles.count; i++)
+            put32 (sysContext, data->handles.handle [i]);
+        break;
+    case TPM_CAP_COMMANDS:
+        put32 (sysContext, data->command.count);
+        for (i = 0; i < data->command.count; i++) {
+            memcpy (&attributes, &data->command.commandAttributes [i],
+                    sizeof (attributes));
+            put32 (sysContext, attributes);
+        }
+        break;
+    case TPM_CAP_PP_COMMANDS:
+    case TPM_CAP_AUDIT_COMMANDS:
+        put32 (sysContext, data->ppCommands.count);
+        for (i = 0; i < data->ppCommands.count; i++)
+            put32 (sysContext, data->ppCommands.commandCodes [i]);
+        break;
+    case TPM_CAP_PCRS:
+        ref_marshal_TPML_PCR_SELECTION (sysContext, &data->assignedPCR);
+        break;
+    case TPM_CAP_TPM_PROPERTIES:
+        put32 (sysContext, data->tpmProperties.count);
+        for (i = 0; i < data->tpmProperties.count; i++) {
+            put32 (sysContext, data->tpmProperties.tpmProperty [i].property);
+            put32 (sysContext, data->tpmProperties.tpmProperty [i].value);
+        }
+        break;
+    case TPM_CAP_PCR_PROPERTIES:
+        put32 (sysContext, data->pcrProperties.count);
+        for (i = 0; i < data->pcrProperties.count; i++) {
+            const TPMS_TAGGED_PCR_SELECT *sel = &data->pcrProperties.pcrProperty [i];
+
+            put32 (sysContext, sel->tag);
+            put8 (sysContext, sel->sizeofSelect);
+            for (j = 0; j < sel->sizeofSelect; j++)
+                put8 (sysContext, sel->pcrSelect [j]);
+        }
+        break;
+    case TPM_CAP_ECC_CURVES:
+        put32 (sysContext, data->eccCurves.count);
+        for (i = 0; i < data->eccCurves.count; i++)
+            put16 (sysContext, data->eccCurves.eccCurves [i]);
+        break;
+    }
+}
+
+void
+ref_unmarshal_TPMS_CAPABILITY_DATA (TSS2_SYS_CONTEXT *sysContext,
+                                    TPMS_CAPABILITY_DATA *value)
+{
+    TPMU_CAPABILITIES *data = &value->data;
+    UINT32 attributes, i, j;
+
+    get32 (sysContext, &value->capability);
+    switch (value->capability) {
+    case TPM_CAP_ALGS:
+        get32 (sysContext, &data->algorithms.count);
+        for (i = 0; i < data->algorithms.count; i++) {
+            get16 (sysContext, &data->algorithms.algProperties [i].alg);
+            get32 (sysContext, &attributes);
+            memcpy (&data->algorithms.algProperties [i].algProperties,
+                    &attributes, sizeof (attributes));
+        }
+        break;
+    case TPM_CAP_HANDLES:
+        get32 (sysContext, &data->handles.count);
+        for (i = 0; i < data->handles.count; i++)
+            get32 (sysContext, &data->handles.handle [i]);
+        break;
+    case TPM_CAP_COMMANDS:
+        get32 (sysContext, &data->command.count);
+        for (i = 0; i < data->command.count; i++) {
+            get32 (sysContext, &attributes);
+            memcpy (&data->command.commandAttributes [i], &attributes,
+                    sizeof (attributes));
+        }
+        break;
+    case TPM_CAP_PP_COMMANDS:
+    case TPM_CAP_AUDIT_COMMANDS:
+        get32 (sysContext, &data->ppCommands.count);
+        for (i = 0; i < data->ppCommands.count; i++)
+            get32 (sysContext, &data->ppCommands.commandCodes [i]);
+        break;
+    case TPM_CAP_PCRS:
+        ref_unmarshal_TPML_PCR_SELECTION (sysContext, &data->assignedPCR);
+        break;
+    case TPM_CAP_TPM_PROPERTIES:
+        get32 (sysContext, &data->tpmProperties.count);
+        for (i = 0; i < data->tpmProperties.count; i++) {
+            get32 (sysContext, &data->tpmProperties.tpmProperty [i].property);
+            get32 (sysContext, &data->tpmProperties.tpmProperty [i].value);
+        }
+        break;
+    case TPM_CAP_PCR_PROPERTIES:
+        get32 (sysContext, &data->pcrProperties.count);
+        for (i = 0; i < data->pcrProperties.count; i++) {
+            TPMS_TAGGED_PCR_SELECT *sel = &data->pcrProperties.pcrProperty [i];
+
+            get32 (sysContext, &sel->tag);
+            get8 (sysContext, &sel->sizeofSelect);
+            for (j = 0; j < sel->sizeofSelect; j++)
+                get8 (sysContext, &sel->pcrSelect [j]);
+        }
+        break;
+    case TPM_CAP_ECC_CURVES:
+        get32 (sysContext, &data->eccCurves.count);
+        for (i = 0; i < data->eccCurves.count; i++)
+            get16 (sysContext, &data->eccCurves.eccCurves [i]);
+        break;
+    }
+}
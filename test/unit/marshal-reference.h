@@ -0,0 +1,38 @@
+#ifndef MARSHAL_REFERENCE_H
+#define MARSHAL_REFERENCE_H
+
+#include <tpm20.h>
+
+/*
+ * Field-by-field marshalling of the types that the table engine handles,
+ * written the way the hand-written Marshal_* / Unmarshal_* functions were
+ * before they moved to marshal_table_types.c: every scalar and TPM2B goes
+ * through its own Marshal_UINTxx / Marshal_Simple_TPM2B call and its own
+ * overflow check.  test/unit/marshal-table checks the engine against these
+ * and test/bench/marshalbench times one against the other.
+ *
+ * Marshalling writes at nextData in the sysContext's command buffer,
+ * unmarshalling reads at nextData in its response buffer.
+ */
+void ref_marshal_TPM2B_PUBLIC (TSS2_SYS_CONTEXT *sysContext,
+                               const TPM2B_PUBLIC *value);
+void ref_unmarshal_TPM2B_PUBLIC (TSS2_SYS_CONTEXT *sysContext,
+                                 TPM2B_PUBLIC *value);
+void ref_marshal_TPMS_CONTEXT (TSS2_SYS_CONTEXT *sysContext,
+                               const TPMS_CONTEXT *value);
+void ref_unmarshal_TPMS_CONTEXT (TSS2_SYS_CONTEXT *sysContext,
+                                 TPMS_CONTEXT *value);
+void ref_marshal_TPML_PCR_SELECTION (TSS2_SYS_CONTEXT *sysContext,
+                                     const TPML_PCR_SELECTION *value);
+void ref_unmarshal_TPML_PCR_SELECTION (TSS2_SYS_CONTEXT *sysContext,
+                                       TPML_PCR_SELECTION *value);
+void ref_marshal_TPML_DIGEST (TSS2_SYS_CONTEXT *sysContext,
+                              const TPML_DIGEST *value);
+void ref_unmarshal_TPML_DIGEST (TSS2_SYS_CONTEXT *sysContext,
+                                TPML_DIGEST *value);
+void ref_marshal_TPMS_CAPABILITY_DATA (TSS2_SYS_CONTEXT *sysContext,
+                                       const TPMS_CAPABILITY_DATA *value);
+void ref_unmarshal_TPMS_CAPABILITY_DATA (TSS2_SYS_CONTEXT *sysContext,
+                                         TPMS_CAPABILITY_DATA *value);
+
+#endif
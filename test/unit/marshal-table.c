@@ -0,0 +1,633 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+
+#include "sysapi_util.h"
+#include "marshal-reference.h"
+
+/*
+ * Differential tests for the table-driven marshaller. Randomized structures
+ * are marshalled and unmarshalled both through the table engine and through
+ * the field-by-field reference code in marshal-reference.c. The two must
+ * agree byte for byte on the wire and field for field in memory.
+ */
+#define BUFFER_SIZE 16384
+#define ITERATIONS  200
+
+typedef struct {
+    _TSS2_SYS_CONTEXT_BLOB ref;
+    UINT8 refBuffer [BUFFER_SIZE];
+    UINT8 tableBuffer [BUFFER_SIZE];
+    UINT8 *tableNext;
+    TSS2_RC tableRc;
+} marshal_table_data_t;
+
+static void
+reset_buffers (marshal_table_data_t *data)
+{
+    memset (&data->ref, 0, sizeof (data->ref));
+    data->ref.tpmInBuffPtr    = data->refBuffer;
+    data->ref.tpmOutBuffPtr   = data->refBuffer;
+    data->ref.maxCommandSize  = BUFFER_SIZE;
+    data->ref.maxResponseSize = BUFFER_SIZE;
+    data->ref.nextData        = data->refBuffer;
+    data->ref.rval            = TSS2_RC_SUCCESS;
+    data->tableNext           = data->tableBuffer;
+    data->tableRc             = TSS2_RC_SUCCESS;
+}
+
+static void
+rewind_buffers (marshal_table_data_t *data)
+{
+    data->ref.nextData = data->refBuffer;
+    data->tableNext    = data->tableBuffer;
+}
+
+void
+marshal_table_setup (void **state)
+{
+    marshal_table_data_t *data;
+
+    data = calloc (1, sizeof (marshal_table_data_t));
+    reset_buffers (data);
+    srand (0x7e18e9de);
+
+    *state = data;
+}
+
+void
+marshal_table_teardown (void **state)
+{
+    if (*state)
+        free (*state);
+}
+
+static UINT32
+rand32 (void)
+{
+    return ((UINT32)rand () << 16) ^ (UINT32)rand ();
+}
+
+static void
+rand_bytes (BYTE *buffer, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        buffer [i] = (BYTE)rand ();
+}
+
+static void
+rand_pcr_selection (TPMS_PCR_SELECTION *selection)
+{
+    selection->hash = (TPMI_ALG_HASH)rand ();
+    selection->sizeofSelect = rand () % (PCR_SELECT_MAX + 1);
+    rand_bytes (selection->pcrSelect, selection->sizeofSelect);
+}
+
+static void
+assert_same_wire (marshal_table_data_t *data)
+{
+    assert_int_equal (data->ref.rval, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tableRc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->ref.nextData - data->refBuffer,
+                      data->tableNext - data->tableBuffer);
+    assert_memory_equal (data->refBuffer, data->tableBuffer,
+                         data->tableNext - data->tableBuffer);
+}
+
+/**
+ * TPML_PCR_SELECTION: count followed by a counted array of nested structures
+ * that each carry their own counted UINT8 array.  The SAPI marshals these
+ * with hand-written functions; they must agree with the table too.
+ */
+void
+marshal_table_TPML_PCR_SELECTION (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT*)&data->ref;
+    _TSS2_SYS_CONTEXT_BLOB sapi;
+    TPML_PCR_SELECTION in, refOut, tableOut, sapiOut;
+    UINT32 i;
+    int n;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        memset (&in, 0, sizeof (in));
+        memset (&refOut, 0, sizeof (refOut));
+        memset (&tableOut, 0, sizeof (tableOut));
+        reset_buffers (data);
+
+        in.count = rand () % (HASH_COUNT + 1);
+        for (i = 0; i < in.count; i++)
+            rand_pcr_selection (&in.pcrSelections [i]);
+
+        ref_marshal_TPML_PCR_SELECTION (sysContext, &in);
+        Marshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                       &MarshalType_TPML_PCR_SELECTION, &in, &data->tableRc);
+        assert_same_wire (data);
+
+        rewind_buffers (data);
+        ref_unmarshal_TPML_PCR_SELECTION (sysContext, &refOut);
+        Unmarshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                         &MarshalType_TPML_PCR_SELECTION, &tableOut,
+                         &data->tableRc);
+        assert_same_wire (data);
+        assert_memory_equal (&refOut, &tableOut, sizeof (refOut));
+        assert_memory_equal (&in, &tableOut, sizeof (in));
+
+        memset (&sapiOut, 0, sizeof (sapiOut));
+        rewind_buffers (data);
+        sapi = data->ref;
+        sapi.tpmInBuffPtr = sapi.tpmOutBuffPtr = sapi.nextData = data->tableBuffer;
+        ref_marshal_TPML_PCR_SELECTION (sysContext, &in);
+        Marshal_TPML_PCR_SELECTION ((TSS2_SYS_CONTEXT*)&sapi, &in);
+        data->tableNext = sapi.nextData;
+        data->tableRc = sapi.rval;
+        assert_same_wire (data);
+
+        sapi.nextData = data->tableBuffer;
+        Unmarshal_TPML_PCR_SELECTION ((TSS2_SYS_CONTEXT*)&sapi, &sapiOut);
+        data->tableNext = sapi.nextData;
+        data->tableRc = sapi.rval;
+        assert_same_wire (data);
+        assert_memory_equal (&in, &sapiOut, sizeof (in));
+    }
+}
+
+/**
+ * TPMS_CONTEXT: fixed scalars followed by a large TPM2B.
+ */
+void
+marshal_table_TPMS_CONTEXT (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT*)&data->ref;
+    TPMS_CONTEXT in, refOut, tableOut;
+    int n;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        memset (&in, 0, sizeof (in));
+        memset (&refOut, 0, sizeof (refOut));
+        memset (&tableOut, 0, sizeof (tableOut));
+        reset_buffers (data);
+
+        in.sequence    = ((UINT64)rand32 () << 32) | rand32 ();
+        in.savedHandle = rand32 ();
+        in.hierarchy   = rand32 ();
+        in.contextBlob.t.size = rand () % (sizeof (in.contextBlob.t.buffer) + 1);
+        rand_bytes (in.contextBlob.t.buffer, in.contextBlob.t.size);
+
+        ref_marshal_TPMS_CONTEXT (sysContext, &in);
+        Marshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                       &MarshalType_TPMS_CONTEXT, &in, &data->tableRc);
+        assert_same_wire (data);
+
+        rewind_buffers (data);
+        ref_unmarshal_TPMS_CONTEXT (sysContext, &refOut);
+        Unmarshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                         &MarshalType_TPMS_CONTEXT, &tableOut, &data->tableRc);
+        assert_same_wire (data);
+        assert_memory_equal (&refOut, &tableOut, sizeof (refOut));
+    }
+}
+
+/**
+ * TPML_DIGEST: counted array of TPM2Bs.
+ */
+void
+marshal_table_TPML_DIGEST (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT*)&data->ref;
+    TPML_DIGEST in, refOut, tableOut;
+    UINT32 i;
+    int n;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        memset (&in, 0, sizeof (in));
+        memset (&refOut, 0, sizeof (refOut));
+        memset (&tableOut, 0, sizeof (tableOut));
+        reset_buffers (data);
+
+        in.count = rand () % 9;
+        for (i = 0; i < in.count; i++) {
+            in.digests [i].t.size = rand () % (sizeof (in.digests [i].t.buffer) + 1);
+            rand_bytes (in.digests [i].t.buffer, in.digests [i].t.size);
+        }
+
+        ref_marshal_TPML_DIGEST (sysContext, &in);
+        Marshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                       &MarshalType_TPML_DIGEST, &in, &data->tableRc);
+        assert_same_wire (data);
+
+        rewind_buffers (data);
+        ref_unmarshal_TPML_DIGEST (sysContext, &refOut);
+        Unmarshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                         &MarshalType_TPML_DIGEST, &tableOut, &data->tableRc);
+        assert_same_wire (data);
+        assert_memory_equal (&refOut, &tableOut, sizeof (refOut));
+    }
+}
+
+/**
+ * TPMS_CAPABILITY_DATA: a union selected by the preceding capability field.
+ * Each arm in turn is filled with random data.
+ */
+void
+marshal_table_TPMS_CAPABILITY_DATA (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT*)&data->ref;
+    static const TPM_CAP capabilities [] = {
+        TPM_CAP_ALGS, TPM_CAP_HANDLES, TPM_CAP_COMMANDS, TPM_CAP_PP_COMMANDS,
+        TPM_CAP_AUDIT_COMMANDS, TPM_CAP_PCRS, TPM_CAP_TPM_PROPERTIES,
+        TPM_CAP_PCR_PROPERTIES, TPM_CAP_ECC_CURVES,
+    };
+    TPMS_CAPABILITY_DATA *in, *refOut, *tableOut;
+    UINT32 i;
+    int n;
+
+    in       = calloc (1, sizeof (*in));
+    refOut   = calloc (1, sizeof (*refOut));
+    tableOut = calloc (1, sizeof (*tableOut));
+
+    for (n = 0; n < ITERATIONS; n++) {
+        memset (in, 0, sizeof (*in));
+        memset (refOut, 0, sizeof (*refOut));
+        memset (tableOut, 0, sizeof (*tableOut));
+        reset_buffers (data);
+
+        in->capability = capabilities [n % (sizeof (capabilities) / sizeof (capabilities [0]))];
+        switch (in->capability) {
+        case TPM_CAP_ALGS:
+            in->data.algorithms.count = rand () % (MAX_CAP_ALGS + 1);
+            for (i = 0; i < in->data.algorithms.count; i++) {
+                in->data.algorithms.algProperties [i].alg = (TPM_ALG_ID)rand ();
+                rand_bytes ((BYTE*)&in->data.algorithms.algProperties [i].algProperties,
+                            sizeof (TPMA_ALGORITHM));
+            }
+            break;
+        case TPM_CAP_HANDLES:
+            in->data.handles.count = rand () % (MAX_CAP_HANDLES + 1);
+            for (i = 0; i < in->data.handles.count; i++)
+                in->data.handles.handle [i] = rand32 ();
+            break;
+        case TPM_CAP_COMMANDS:
+            in->data.command.count = rand () % (MAX_CAP_CC + 1);
+            rand_bytes ((BYTE*)in->data.command.commandAttributes,
+                        in->data.command.count * sizeof (TPMA_CC));
+            break;
+        case TPM_CAP_PP_COMMANDS:
+        case TPM_CAP_AUDIT_COMMANDS:
+            in->data.ppCommands.count = rand () % (MAX_CAP_CC + 1);
+            for (i = 0; i < in->data.ppCommands.count; i++)
+                in->data.ppCommands.commandCodes [i] = rand32 ();
+            break;
+        case TPM_CAP_PCRS:
+            in->data.assignedPCR.count = rand () % (HASH_COUNT + 1);
+            for (i = 0; i < in->data.assignedPCR.count; i++)
+                rand_pcr_selection (&in->data.assignedPCR.pcrSelections [i]);
+            break;
+        case TPM_CAP_TPM_PROPERTIES:
+            in->data.tpmProperties.count = rand () % (MAX_TPM_PROPERTIES + 1);
+            for (i = 0; i < in->data.tpmProperties.count; i++) {
+                in->data.tpmProperties.tpmProperty [i].property = rand32 ();
+                in->data.tpmProperties.tpmProperty [i].value = rand32 ();
+            }
+            break;
+        case TPM_CAP_PCR_PROPERTIES:
+            in->data.pcrProperties.count = rand () % (MAX_PCR_PROPERTIES + 1);
+            for (i = 0; i < in->data.pcrProperties.count; i++) {
+                TPMS_TAGGED_PCR_SELECT *sel = &in->data.pcrProperties.pcrProperty [i];
+                sel->tag = rand32 ();
+                sel->sizeofSelect = rand () % (PCR_SELECT_MAX + 1);
+                rand_bytes (sel->pcrSelect, sel->sizeofSelect);
+            }
+            break;
+        case TPM_CAP_ECC_CURVES:
+            in->data.eccCurves.count = rand () % (MAX_ECC_CURVES + 1);
+            for (i = 0; i < in->data.eccCurves.count; i++)
+                in->data.eccCurves.eccCurves [i] = (TPM_ECC_CURVE)rand ();
+            break;
+        }
+
+        ref_marshal_TPMS_CAPABILITY_DATA (sysContext, in);
+        Marshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                       &MarshalType_TPMS_CAPABILITY_DATA, in, &data->tableRc);
+        assert_same_wire (data);
+
+        rewind_buffers (data);
+        ref_unmarshal_TPMS_CAPABILITY_DATA (sysContext, refOut);
+        Unmarshal_Table (data->tableBuffer, BUFFER_SIZE, &data->tableNext,
+                         &MarshalType_TPMS_CAPABILITY_DATA, tableOut,
+                         &data->tableRc);
+        assert_same_wire (data);
+        assert_memory_equal (refOut, tableOut, sizeof (*refOut));
+        assert_memory_equal (in, tableOut, sizeof (*in));
+    }
+
+    free (in);
+    free (refOut);
+    free (tableOut);
+}
+#define PICK(choices) (choices [rand () % (sizeof (choices) / sizeof (choices [0]))])
+
+static const TPM_ALG_ID public_types [] = {
+#ifdef TPM_ALG_KEYEDHASH
+    TPM_ALG_KEYEDHASH,
+#endif
+#ifdef TPM_ALG_SYMCIPHER
+    TPM_ALG_SYMCIPHER,
+#endif
+#ifdef TPM_ALG_RSA
+    TPM_ALG_RSA,
+#endif
+#ifdef TPM_ALG_ECC
+    TPM_ALG_ECC,
+#endif
+};
+static const TPM_ALG_ID keyedhash_schemes [] = {
+#ifdef TPM_ALG_HMAC
+    TPM_ALG_HMAC,
+#endif
+#ifdef TPM_ALG_XOR
+    TPM_ALG_XOR,
+#endif
+#ifdef TPM_ALG_NULL
+    TPM_ALG_NULL,
+#endif
+};
+static const TPM_ALG_ID sym_algorithms [] = {
+#ifdef TPM_ALG_AES
+    TPM_ALG_AES,
+#endif
+#ifdef TPM_ALG_SM4
+    TPM_ALG_SM4,
+#endif
+#ifdef TPM_ALG_CAMELLIA
+    TPM_ALG_CAMELLIA,
+#endif
+#ifdef TPM_ALG_XOR
+    TPM_ALG_XOR,
+#endif
+#ifdef TPM_ALG_NULL
+    TPM_ALG_NULL,
+#endif
+};
+static const TPM_ALG_ID asym_schemes [] = {
+#ifdef TPM_ALG_ECDH
+    TPM_ALG_ECDH,
+#endif
+#ifdef TPM_ALG_ECMQV
+    TPM_ALG_ECMQV,
+#endif
+#ifdef TPM_ALG_RSASSA
+    TPM_ALG_RSASSA,
+#endif
+#ifdef TPM_ALG_RSAPSS
+    TPM_ALG_RSAPSS,
+#endif
+#ifdef TPM_ALG_ECDSA
+    TPM_ALG_ECDSA,
+#endif
+#ifdef TPM_ALG_ECDAA
+    TPM_ALG_ECDAA,
+#endif
+#ifdef TPM_ALG_SM2
+    TPM_ALG_SM2,
+#endif
+#ifdef TPM_ALG_ECSCHNORR
+    TPM_ALG_ECSCHNORR,
+#endif
+#ifdef TPM_ALG_RSAES
+    TPM_ALG_RSAES,
+#endif
+#ifdef TPM_ALG_OAEP
+    TPM_ALG_OAEP,
+#endif
+#ifdef TPM_ALG_NULL
+    TPM_ALG_NULL,
+#endif
+};
+static const TPM_ALG_ID kdf_schemes [] = {
+#ifdef TPM_ALG_MGF1
+    TPM_ALG_MGF1,
+#endif
+#ifdef TPM_ALG_KDF1_SP800_56A
+    TPM_ALG_KDF1_SP800_56A,
+#endif
+#ifdef TPM_ALG_KDF2
+    TPM_ALG_KDF2,
+#endif
+#ifdef TPM_ALG_KDF1_SP800_108
+    TPM_ALG_KDF1_SP800_108,
+#endif
+#ifdef TPM_ALG_NULL
+    TPM_ALG_NULL,
+#endif
+};
+
+static void
+rand_tpm2b (TPM2B *value, size_t capacity)
+{
+    value->size = rand () % (capacity + 1);
+    rand_bytes (value->buffer, value->size);
+}
+
+static void
+rand_sym_def_object (TPMT_SYM_DEF_OBJECT *sym)
+{
+    sym->algorithm = PICK (sym_algorithms);
+    if (sym->algorithm == TPM_ALG_XOR) {
+        sym->keyBits.exclusiveOr = (TPMI_ALG_HASH)rand ();
+    } else if (sym->algorithm != TPM_ALG_NULL) {
+        sym->keyBits.sym = (TPM_KEY_BITS)rand ();
+        sym->mode.sym = (TPMI_ALG_SYM_MODE)rand ();
+    }
+}
+
+static void
+rand_asym_scheme (TPMI_ALG_ASYM_SCHEME *scheme, TPMU_ASYM_SCHEME *details)
+{
+    *scheme = PICK (asym_schemes);
+    if (*scheme == TPM_ALG_ECDAA) {
+        details->ecdaa.hashAlg = (TPMI_ALG_HASH)rand ();
+        details->ecdaa.count = (UINT16)rand ();
+    } else if (*scheme != TPM_ALG_RSAES && *scheme != TPM_ALG_NULL) {
+        details->anySig.hashAlg = (TPMI_ALG_HASH)rand ();
+    }
+}
+
+/*
+ * Only the members selected by type and the schemes are set; the rest of
+ * the unions stays zero, as unmarshalling leaves it.
+ */
+static void
+rand_public (TPM2B_PUBLIC *value)
+{
+    TPMT_PUBLIC *area = &value->t.publicArea;
+    TPMU_PUBLIC_PARMS *parms = &area->parameters;
+    UINT32 attributes = rand32 ();
+
+    area->type = PICK (public_types);
+    area->nameAlg = (TPMI_ALG_HASH)rand ();
+    memcpy (&area->objectAttributes, &attributes, sizeof (attributes));
+    rand_tpm2b (&area->authPolicy.b, sizeof (area->authPolicy.t.buffer));
+
+    switch (area->type) {
+    case TPM_ALG_KEYEDHASH:
+        parms->keyedHashDetail.scheme.scheme = PICK (keyedhash_schemes);
+        if (parms->keyedHashDetail.scheme.scheme == TPM_ALG_HMAC) {
+            parms->keyedHashDetail.scheme.details.hmac.hashAlg = (TPMI_ALG_HASH)rand ();
+        } else if (parms->keyedHashDetail.scheme.scheme == TPM_ALG_XOR) {
+            parms->keyedHashDetail.scheme.details.exclusiveOr.hashAlg = (TPMI_ALG_HASH)rand ();
+            parms->keyedHashDetail.scheme.details.exclusiveOr.kdf = (TPMI_ALG_KDF)rand ();
+        }
+        rand_tpm2b (&area->unique.keyedHash.b, sizeof (area->unique.keyedHash.t.buffer));
+        break;
+    case TPM_ALG_SYMCIPHER:
+        rand_sym_def_object (&parms->symDetail.sym);
+        rand_tpm2b (&area->unique.sym.b, sizeof (area->unique.sym.t.buffer));
+        break;
+    case TPM_ALG_RSA:
+        rand_sym_def_object (&parms->rsaDetail.symmetric);
+        rand_asym_scheme (&parms->rsaDetail.scheme.scheme,
+                          &parms->rsaDetail.scheme.details);
+        parms->rsaDetail.keyBits = (TPMI_RSA_KEY_BITS)rand ();
+        parms->rsaDetail.exponent = rand32 ();
+        rand_tpm2b (&area->unique.rsa.b, sizeof (area->unique.rsa.t.buffer));
+        break;
+    case TPM_ALG_ECC:
+        rand_sym_def_object (&parms->eccDetail.symmetric);
+        rand_asym_scheme (&parms->eccDetail.scheme.scheme,
+                          &parms->eccDetail.scheme.details);
+        parms->eccDetail.curveID = (TPMI_ECC_CURVE)rand ();
+        parms->eccDetail.kdf.scheme = PICK (kdf_schemes);
+        if (parms->eccDetail.kdf.scheme != TPM_ALG_NULL)
+            parms->eccDetail.kdf.details.mgf1.hashAlg = (TPMI_ALG_HASH)rand ();
+        rand_tpm2b (&area->unique.ecc.x.b, sizeof (area->unique.ecc.x.t.buffer));
+        rand_tpm2b (&area->unique.ecc.y.b, sizeof (area->unique.ecc.y.t.buffer));
+        break;
+    }
+}
+
+/**
+ * TPM2B_PUBLIC: a size-prefixed TPMT_PUBLIC whose parameters and unique
+ * identifier are unions selected by its type, with nested unions for the
+ * schemes.  The table side goes through Marshal_TPM2B_PUBLIC and
+ * Unmarshal_TPM2B_PUBLIC, which wrap the table engine.
+ */
+void
+marshal_table_TPM2B_PUBLIC (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TSS2_SYS_CONTEXT *sysContext = (TSS2_SYS_CONTEXT*)&data->ref;
+    _TSS2_SYS_CONTEXT_BLOB table;
+    TPM2B_PUBLIC in, refOut, tableOut;
+    int n;
+
+    for (n = 0; n < ITERATIONS; n++) {
+        memset (&in, 0, sizeof (in));
+        memset (&refOut, 0, sizeof (refOut));
+        memset (&tableOut, 0, sizeof (tableOut));
+        reset_buffers (data);
+        table = data->ref;
+        table.tpmInBuffPtr = table.tpmOutBuffPtr = table.nextData = data->tableBuffer;
+
+        rand_public (&in);
+
+        ref_marshal_TPM2B_PUBLIC (sysContext, &in);
+        Marshal_TPM2B_PUBLIC ((TSS2_SYS_CONTEXT*)&table, &in);
+        data->tableNext = table.nextData;
+        data->tableRc = table.rval;
+        assert_same_wire (data);
+
+        rewind_buffers (data);
+        table.nextData = data->tableBuffer;
+        ref_unmarshal_TPM2B_PUBLIC (sysContext, &refOut);
+        Unmarshal_TPM2B_PUBLIC ((TSS2_SYS_CONTEXT*)&table, &tableOut);
+        data->tableNext = table.nextData;
+        data->tableRc = table.rval;
+        assert_same_wire (data);
+        assert_memory_equal (&refOut, &tableOut, sizeof (refOut));
+        /* in.t.size was 0; the wire carries the real size. */
+        in.t.size = refOut.t.size;
+        assert_memory_equal (&in, &tableOut, sizeof (in));
+    }
+}
+/**
+ * A count larger than the destination array is a malformed response and
+ * must not be unmarshalled.
+ */
+void
+unmarshal_table_count_too_large (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TPML_HANDLE handles;
+    UINT8 *nextData = data->tableBuffer;
+    TSS2_RC rc = TSS2_RC_SUCCESS;
+
+    Marshal_UINT32 (data->tableBuffer, BUFFER_SIZE, &nextData,
+                    MAX_CAP_HANDLES + 1, &rc);
+    nextData = data->tableBuffer;
+
+    Unmarshal_Table (data->tableBuffer, BUFFER_SIZE, &nextData,
+                     &MarshalType_TPML_HANDLE, &handles, &rc);
+    assert_int_equal (rc, TSS2_SYS_RC_MALFORMED_RESPONSE);
+}
+/**
+ * A response that ends in the middle of a structure is rejected with
+ * TSS2_SYS_RC_INSUFFICIENT_CONTEXT, the same as the hand-written functions.
+ */
+void
+unmarshal_table_truncated (void **state)
+{
+    marshal_table_data_t *data = (marshal_table_data_t*)*state;
+    TPMS_CONTEXT context = { 0 };
+    UINT8 *nextData = data->tableBuffer;
+    TSS2_RC rc = TSS2_RC_SUCCESS;
+
+    context.contextBlob.t.size = 32;
+    Marshal_Table (data->tableBuffer, BUFFER_SIZE, &nextData,
+                   &MarshalType_TPMS_CONTEXT, &context, &rc);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    /* Only the fixed part of the structure is available. */
+    nextData = data->tableBuffer;
+    Unmarshal_Table (data->tableBuffer,
+                     sizeof (UINT64) + 2 * sizeof (UINT32),
+                     &nextData, &MarshalType_TPMS_CONTEXT, &context, &rc);
+    assert_int_equal (rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+}
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (marshal_table_TPML_PCR_SELECTION,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (marshal_table_TPMS_CONTEXT,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (marshal_table_TPML_DIGEST,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (marshal_table_TPMS_CAPABILITY_DATA,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (marshal_table_TPM2B_PUBLIC,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (unmarshal_table_count_too_large,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+        unit_test_setup_teardown (unmarshal_table_truncated,
+                                  marshal_table_setup,
+                                  marshal_table_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+
+#define NV_INDEX    0x01500020
+#define NV_ATTR     0x00040004  /* AUTHWRITE | AUTHREAD */
+
+/* Names of NV_INDEX, SHA-256, empty policy, 32 bytes; unwritten and written. */
+static const char *nvName =
+    "000bf22f3bc5dc2e9fe402dd43a1c6d0b62dcfc86bb9c5fe2fef40af76d860a80c92";
+static const char *nvNameWritten =
+    "000be1dc9116bcf6d414100afa070358084aa013a9ea52d3870f39e96dbe9e1f5337";
+
+/*
+ * Stand-ins for the TPM: count the reads the cache makes and play back a
+ * fixed NV public area and object names.
+ */
+TSS2_TCTI_CONTEXT *resMgrTctiContext = NULL;
+TSS2_ABI_VERSION abiVersion;
+UINT32 (*HashFunctionPtr)( TPMI_ALG_HASH hashAlg, UINT16 size, BYTE *data, TPM2B_DIGEST *result ) = HostHash;
+
+static int tpmReads;
+static TPMA_NV tpmNvAttributes;
+
+TSS2_SYS_CONTEXT *
+AcquireSysContext (UINT16 maxCommandSize, TSS2_TCTI_CONTEXT *tctiContext,
+                TSS2_ABI_VERSION *abiVersion)
+{
+    return (TSS2_SYS_CONTEXT *)&tpmReads;
+}
+
+void
+ReleaseSysContext (TSS2_SYS_CONTEXT **sysContext)
+{
+    *sysContext = NULL;
+}
+
+static void
+hex_to_name (const char *hex, TPM2B_NAME *name)
+{
+    unsigned int byte;
+
+    for (name->t.size = 0; hex [0] != '\0'; hex += 2) {
+        sscanf (hex, "%2x", &byte);
+        name->t.name [name->t.size++] = (BYTE)byte;
+    }
+}
+
+TPM_RC
+Tss2_Sys_NV_ReadPublic (TSS2_SYS_CONTEXT *sysContext, TPMI_RH_NV_INDEX nvIndex,
+                        TSS2_SYS_CMD_AUTHS const *cmdAuthsArray,
+                        TPM2B_NV_PUBLIC *nvPublic, TPM2B_NAME *nvName_,
+                        TSS2_SYS_RSP_AUTHS *rspAuthsArray)
+{
+    tpmReads++;
+    memset (&nvPublic->t.nvPublic, 0, sizeof (nvPublic->t.nvPublic));
+    nvPublic->t.nvPublic.nvIndex    = nvIndex;
+    nvPublic->t.nvPublic.nameAlg    = TPM_ALG_SHA256;
+    nvPublic->t.nvPublic.attributes = tpmNvAttributes;
+    nvPublic->t.nvPublic.dataSize   = 32;
+    hex_to_name ((*(UINT32 *)&tpmNvAttributes & TPMA_NV_TPMA_NV_WRITTEN) ?
+                 nvNameWritten : nvName, nvName_);
+    return TPM_RC_SUCCESS;
+}
+
+UINT32
+TpmHandleToName (TPM_HANDLE handle, TPM2B_NAME *name)
+{
+    if ((handle >> HR_SHIFT) == TPM_HT_TRANSIENT ||
+        (handle >> HR_SHIFT) == TPM_HT_PERSISTENT)
+        tpmReads++;
+    name->t.size = sizeof (TPM_HANDLE);
+    *(TPM_HANDLE *)name->t.name = handle + tpmReads;
+    return TPM_RC_SUCCESS;
+}
+
+typedef struct {
+    _TSS2_SYS_CONTEXT_BLOB context;
+    UINT8 buffer [64];
+} name_cache_data_t;
+
+static void
+name_cache_setup (void **state)
+{
+    tpmReads = 0;
+    *(UINT32 *)&tpmNvAttributes = NV_ATTR;
+    NameCacheClear ();
+    NameCacheResetStats ();
+    *state = calloc (1, sizeof (name_cache_data_t));
+}
+
+static void
+name_cache_teardown (void **state)
+{
+    NameCacheClear ();
+    free (*state);
+}
+
+/* Put sysContext in the state it is in after the given command completed. */
+static TSS2_SYS_CONTEXT *
+completed (name_cache_data_t *data, TPM_CC commandCode, TPM_HANDLE responseHandle)
+{
+    data->context.commandCodeSwapped = CHANGE_ENDIAN_DWORD (commandCode);
+    data->context.tpmOutBuffPtr = data->buffer;
+    *(TPM_HANDLE *)(data->buffer + sizeof (TPM20_Header_Out)) =
+        CHANGE_ENDIAN_DWORD (responseHandle);
+    return (TSS2_SYS_CONTEXT *)&data->context;
+}
+
+static void
+assert_name (TPM2B_NAME *name, const char *hex)
+{
+    TPM2B_NAME expected;
+
+    hex_to_name (hex, &expected);
+    assert_int_equal (name->t.size, expected.t.size);
+    assert_memory_equal (name->t.name, expected.t.name, expected.t.size);
+}
+
+/*
+ * The NV_Write / NV_Read loop in tpmclient needs the index name twice per
+ * command (auth handle and NV index).  Uncached that is two NV_ReadPublic
+ * calls per command; cached it is one read in total, and the name change
+ * caused by the first write is computed locally.
+ */
+static void
+name_cache_nv_write_read (void **state)
+{
+    name_cache_data_t *data = (name_cache_data_t *)*state;
+    NAME_CACHE_STATS stats;
+    TPM2B_NAME name1, name2;
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        assert_int_equal (CachedHandleToName (NV_INDEX, &name1), TPM_RC_SUCCESS);
+        assert_int_equal (CachedHandleToName (NV_INDEX, &name2), TPM_RC_SUCCESS);
+        assert_name (&name1, i == 0 ? nvName : nvNameWritten);
+        assert_name (&name2, i == 0 ? nvName : nvNameWritten);
+
+        if (i == 0)
+            *(UINT32 *)&tpmNvAttributes |= TPMA_NV_TPMA_NV_WRITTEN;
+        NameCacheUpdate (completed (data, i % 2 ? TPM_CC_NV_Read : TPM_CC_NV_Write, 0),
+                         NV_INDEX, NV_INDEX, TPM_RC_SUCCESS);
+    }
+
+    NameCacheGetStats (&stats);
+    assert_int_equal (tpmReads, 1);
+    assert_int_equal (stats.misses, 1);
+    assert_int_equal (stats.hits, 199);
+    assert_int_equal (stats.localNames, 1);
+}
+
+/* A failed command must not change any cached state. */
+static void
+name_cache_failed_command (void **state)
+{
+    name_cache_data_t *data = (name_cache_data_t *)*state;
+    TPM2B_NAME name;
+
+    CachedHandleToName (NV_INDEX, &name);
+    NameCacheUpdate (completed (data, TPM_CC_NV_Write, 0),
+                     NV_INDEX, NV_INDEX, TPM_RC_NV_LOCKED);
+    CachedHandleToName (NV_INDEX, &name);
+    assert_name (&name, nvName);
+
+    NameCacheUpdate (completed (data, TPM_CC_NV_UndefineSpace, 0),
+                     TPM_RH_OWNER, NV_INDEX, TPM_RC_SUCCESS);
+    CachedHandleToName (NV_INDEX, &name);
+    assert_int_equal (tpmReads, 2);
+}
+
+/*
+ * Transient names go on FlushContext and when a load returns a handle;
+ * persistent names go on EvictControl.  Other handles are never cached.
+ */
+static void
+name_cache_object_invalidation (void **state)
+{
+    name_cache_data_t *data = (name_cache_data_t *)*state;
+    TPM2B_NAME name;
+
+    CachedHandleToName (0x80000001, &name);
+    CachedHandleToName (0x80000002, &name);
+    CachedHandleToName (0x81000001, &name);
+    CachedHandleToName (NV_INDEX, &name);
+    assert_int_equal (tpmReads, 4);
+
+    NameCacheUpdate (completed (data, TPM_CC_Load, 0x80000001),
+                     0x80000002, TPM_HT_NO_HANDLE, TPM_RC_SUCCESS);
+    CachedHandleToName (0x80000001, &name);
+    CachedHandleToName (0x80000002, &name);
+    assert_int_equal (tpmReads, 5);
+
+    NameCacheUpdate (completed (data, TPM_CC_FlushContext, 0),
+                     TPM_HT_NO_HANDLE, TPM_HT_NO_HANDLE, TPM_RC_SUCCESS);
+    CachedHandleToName (0x80000001, &name);
+    CachedHandleToName (0x80000002, &name);
+    CachedHandleToName (0x81000001, &name);
+    CachedHandleToName (NV_INDEX, &name);
+    assert_int_equal (tpmReads, 7);
+
+    NameCacheUpdate (completed (data, TPM_CC_EvictControl, 0),
+                     TPM_RH_OWNER, 0x80000001, TPM_RC_SUCCESS);
+    CachedHandleToName (0x81000001, &name);
+    CachedHandleToName (0x80000001, &name);
+    assert_int_equal (tpmReads, 8);
+
+    CachedHandleToName (TPM_RH_OWNER, &name);
+    assert_int_equal (name.t.size, sizeof (TPM_HANDLE));
+    assert_int_equal (tpmReads, 8);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (name_cache_nv_write_read,
+                                  name_cache_setup,
+                                  name_cache_teardown),
+        unit_test_setup_teardown (name_cache_failed_command,
+                                  name_cache_setup,
+                                  name_cache_teardown),
+        unit_test_setup_teardown (name_cache_object_invalidation,
+                                  name_cache_setup,
+                                  name_cache_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,303 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include "fake-tpm.h"
+
+TSS2_TCTI_CONTEXT *resMgrTctiContext = NULL;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+#define NV_INDEX 0x01500030
+
+/*
+ * A TCTI that plays a TPM with one 64K NV index.  It handles only the
+ * commands NvStreamInit, NvStreamRead and NvStreamWrite send.
+ */
+typedef struct {
+    fake_tpm_t base;
+    UINT8 nv [0x10000];
+    UINT32 nvBufferMax;
+    UINT32 failOffset;          /* NV_Write at this offset fails */
+    int nvCommands;
+    int bufferSwitches;
+    const UINT8 *lastBuffer;
+} nv_tpm_t;
+
+static void
+nv_command (fake_tpm_t *base, const UINT8 *command, size_t size)
+{
+    nv_tpm_t *tpm = (nv_tpm_t *)base;
+    TPM_ST tag = get16 (command);
+    TPM_CC cc = get32 (command + 6);
+    const UINT8 *p = command + 10;
+    UINT8 *r = tpm->base.response + 10, *params;
+    UINT32 authEnd = 0, sessions = 0, i;
+    UINT16 dataSize, offset;
+    const UINT8 *data = NULL;
+
+    if (cc == TPM_CC_GetCapability) {
+        *r++ = NO;
+        r = put32 (r, TPM_CAP_TPM_PROPERTIES);
+        r = put32 (r, 1);
+        r = put32 (r, TPM_PT_NV_BUFFER_MAX);
+        r = put32 (r, tpm->nvBufferMax);
+        fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_SUCCESS, r);
+        return;
+    }
+
+    assert_true (cc == TPM_CC_NV_Read || cc == TPM_CC_NV_Write);
+    assert_int_equal (get32 (p + 4), NV_INDEX);
+    p += 8;
+
+    if (tpm->lastBuffer != NULL && tpm->lastBuffer != command)
+        tpm->bufferSwitches++;
+    tpm->lastBuffer = command;
+    tpm->nvCommands++;
+
+    if (tag == TPM_ST_SESSIONS) {
+        authEnd = get32 (p);
+        p += 4;
+        for (i = 0; i < authEnd; sessions++) {
+            i += 4;
+            i += 2 + get16 (p + i);
+            i += 1;
+            i += 2 + get16 (p + i);
+        }
+        p += authEnd;
+    }
+
+    if (cc == TPM_CC_NV_Write) {
+        dataSize = get16 (p);
+        data = p + 2;
+        offset = get16 (p + 2 + dataSize);
+    } else {
+        dataSize = get16 (p);
+        offset = get16 (p + 2);
+    }
+
+    if (dataSize > tpm->nvBufferMax || (UINT32)offset + dataSize > sizeof (tpm->nv) ||
+        (data != NULL && offset == tpm->failOffset)) {
+        fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_VALUE, r);
+        return;
+    }
+
+    params = r;
+    if (tag == TPM_ST_SESSIONS)
+        r += 4;
+    if (data != NULL) {
+        memcpy (tpm->nv + offset, data, dataSize);
+    } else {
+        r = put16 (r, dataSize);
+        memcpy (r, tpm->nv + offset, dataSize);
+        r += dataSize;
+    }
+    if (tag == TPM_ST_SESSIONS) {
+        put32 (params, r - params - 4);
+        for (i = 0; i < sessions; i++) {
+            r = put16 (r, 0);
+            *r++ = 1;
+            r = put16 (r, 0);
+        }
+    }
+    fake_tpm_respond (&tpm->base, tag, TPM_RC_SUCCESS, r);
+}
+
+typedef struct {
+    nv_tpm_t tpm;
+    NV_STREAM stream;
+    TPMS_AUTH_COMMAND cmdAuth;
+    TPMS_AUTH_COMMAND *cmdAuthList [1];
+    TSS2_SYS_CMD_AUTHS cmdAuths;
+    TPMS_AUTH_RESPONSE rspAuth;
+    TPMS_AUTH_RESPONSE *rspAuthList [1];
+    TSS2_SYS_RSP_AUTHS rspAuths;
+    UINT8 in [0x10000];
+    UINT8 out [0x10000];
+    int hookCalls;
+    TPM_RC lastHookCode;
+} nv_stream_data_t;
+
+static void
+nv_stream_setup (void **state)
+{
+    nv_stream_data_t *data = calloc (1, sizeof (nv_stream_data_t));
+    UINT32 i;
+
+    fake_tpm_init (&data->tpm.base, nv_command);
+    data->tpm.nvBufferMax = 512;
+    data->tpm.failOffset = 0xffffffff;
+
+    data->cmdAuth.sessionHandle   = TPM_RS_PW;
+    data->cmdAuthList [0]         = &data->cmdAuth;
+    data->cmdAuths.cmdAuthsCount  = 1;
+    data->cmdAuths.cmdAuths       = data->cmdAuthList;
+    data->rspAuthList [0]         = &data->rspAuth;
+    data->rspAuths.rspAuthsCount  = 1;
+    data->rspAuths.rspAuths       = data->rspAuthList;
+
+    for (i = 0; i < sizeof (data->in); i++)
+        data->in [i] = (UINT8)(i * 7 + (i >> 8));
+
+    *state = data;
+}
+
+static void
+nv_stream_teardown (void **state)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)*state;
+
+    NvStreamTeardown (&data->stream);
+    free (data);
+}
+
+static TSS2_RC
+stream_init (nv_stream_data_t *data)
+{
+    return NvStreamInit (&data->stream, (TSS2_TCTI_CONTEXT *)&data->tpm,
+                         &data->cmdAuths, &data->rspAuths);
+}
+
+/*
+ * A region that isn't a multiple of the chunk size, at an odd offset,
+ * goes out and comes back unchanged in TPM_PT_NV_BUFFER_MAX sized chunks,
+ * alternating between the two command buffers.
+ */
+static void
+nv_stream_round_trip (void **state)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = stream_init (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->stream.chunkSize, 512);
+
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 100, data->in, 5000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_memory_equal (data->tpm.nv + 100, data->in, 5000);
+    assert_int_equal (data->tpm.nvCommands, 10);
+    assert_int_equal (data->tpm.bufferSwitches, 9);
+
+    rc = NvStreamRead (&data->stream, NV_INDEX, NV_INDEX, 100, data->out, 5000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_memory_equal (data->out, data->in, 5000);
+    assert_int_equal (data->stream.chunks, 20);
+    assert_int_equal (data->rspAuth.sessionAttributes.continueSession, 1);
+
+    /* The whole 64K index, up to the last offset. */
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 0, data->in, 0x10000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = NvStreamRead (&data->stream, NV_INDEX, NV_INDEX, 0, data->out, 0x10000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_memory_equal (data->out, data->in, 0x10000);
+}
+
+/* A TPM that accepts more than MAX_NV_BUFFER_SIZE still gets chunks of that size. */
+static void
+nv_stream_chunk_size_capped (void **state)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)*state;
+    TSS2_RC rc;
+
+    data->tpm.nvBufferMax = 4096;
+    rc = stream_init (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->stream.chunkSize, MAX_NV_BUFFER_SIZE);
+
+    NvStreamTeardown (&data->stream);
+    data->stream.cmdAuths = NULL;
+    rc = NvStreamInit (&data->stream, (TSS2_TCTI_CONTEXT *)&data->tpm, NULL, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 0, data->in, 3000);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tpm.nvCommands, 3);
+    assert_memory_equal (data->tpm.nv, data->in, 3000);
+}
+
+static TPM_RC
+count_chunk_auth (NV_STREAM *stream, TSS2_SYS_CONTEXT *sysContext,
+                  TPMI_RH_NV_AUTH authHandle, TPMI_RH_NV_INDEX nvIndex,
+                  TPM_RC responseCode)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)stream->userData;
+
+    /* Calls alternate: prepare, response, prepare, ... */
+    assert_int_equal (responseCode,
+                      data->hookCalls % 2 ? TPM_RC_SUCCESS : TPM_RC_NO_RESPONSE);
+    assert_int_equal (data->tpm.base.pending, 0);
+    data->hookCalls++;
+
+    return TPM_RC_SUCCESS;
+}
+
+/* With a per-chunk authorization hook, chunks go one at a time. */
+static void
+nv_stream_chunk_auth (void **state)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = stream_init (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    data->stream.chunkAuth = count_chunk_auth;
+    data->stream.userData = data;
+
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 0, data->in, 1100);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->hookCalls, 6);
+    assert_int_equal (data->tpm.bufferSwitches, 0);
+    assert_memory_equal (data->tpm.nv, data->in, 1100);
+}
+
+/*
+ * A TPM error stops the stream; the chunk already in flight is collected
+ * so the next call works.  Regions past the 64K offset range are refused.
+ */
+static void
+nv_stream_errors (void **state)
+{
+    nv_stream_data_t *data = (nv_stream_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = stream_init (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 0xff00, data->in, 0x101);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_VALUE));
+    assert_int_equal (data->tpm.nvCommands, 0);
+
+    data->tpm.failOffset = 1024;
+    rc = NvStreamWrite (&data->stream, NV_INDEX, NV_INDEX, 0, data->in, 4096);
+    assert_int_equal (rc, TPM_RC_VALUE);
+    assert_false (data->tpm.base.pending);
+    assert_memory_equal (data->tpm.nv, data->in, 1024);
+
+    data->tpm.failOffset = 0xffffffff;
+    rc = NvStreamRead (&data->stream, NV_INDEX, NV_INDEX, 0, data->out, 1024);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_memory_equal (data->out, data->in, 1024);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (nv_stream_round_trip,
+                                  nv_stream_setup,
+                                  nv_stream_teardown),
+        unit_test_setup_teardown (nv_stream_chunk_size_capped,
+                                  nv_stream_setup,
+                                  nv_stream_teardown),
+        unit_test_setup_teardown (nv_stream_chunk_auth,
+                                  nv_stream_setup,
+                                  nv_stream_teardown),
+        unit_test_setup_teardown (nv_stream_errors,
+                                  nv_stream_setup,
+                                  nv_stream_teardown),
+    };
+    return run_tests (tests);
+}
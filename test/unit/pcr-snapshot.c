@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+#include "sysapi_util.h"
+#include "fake-tpm.h"
+
+TSS2_TCTI_CONTEXT *resMgrTctiContext = NULL;
+TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+#define ALL_PCRS 0x00ffffff
+
+/*
+ * A TCTI that plays a TPM with SHA1 and SHA256 banks.  Like a real TPM it
+ * returns the selected PCRs in order, up to maxDigests of them, and skips
+ * banks it doesn't have.  Every PCR_Read numbered in extendAt bumps the
+ * update counter (and all PCR values) before it is answered.
+ */
+typedef struct {
+    fake_tpm_t base;
+    UINT32 maxDigests;
+    UINT32 counter;
+    int extendAt [4];
+    int reads;
+} pcr_tpm_t;
+
+static UINT16
+bank_size (TPMI_ALG_HASH hash)
+{
+    return hash == TPM_ALG_SHA1 ? 20 : hash == TPM_ALG_SHA256 ? 32 : 0;
+}
+
+static UINT8
+pcr_byte (TPMI_ALG_HASH hash, UINT32 pcr, UINT32 counter, UINT32 i)
+{
+    return (UINT8)(hash * 31 + pcr * 7 + counter * 13 + i);
+}
+
+static void
+pcr_command (fake_tpm_t *base, const UINT8 *command, size_t size)
+{
+    pcr_tpm_t *tpm = (pcr_tpm_t *)base;
+    const UINT8 *p = command + 10;
+    UINT8 *r = tpm->base.response + 10, *outCount, *digests;
+    UINT8 digestBuffer [512];
+    UINT32 count, i, j, pcr, sent = 0, banksOut = 0;
+    UINT16 hash, digestSize;
+    UINT8 sizeofSelect, *select;
+
+    assert_int_equal (get32 (command + 6), TPM_CC_PCR_Read);
+
+    tpm->reads++;
+    for (i = 0; i < 4; i++)
+        if (tpm->extendAt [i] == tpm->reads)
+            tpm->counter++;
+
+    r = put32 (r, tpm->counter);
+    outCount = r;
+    r += 4;
+    digests = digestBuffer;
+
+    count = get32 (p);
+    p += 4;
+    for (i = 0; i < count; i++) {
+        hash = get16 (p);
+        sizeofSelect = p [2];
+        digestSize = bank_size (hash);
+        r = put16 (r, hash);
+        *r++ = sizeofSelect;
+        select = r;
+        memset (select, 0, sizeofSelect);
+        r += sizeofSelect;
+        banksOut++;
+        for (pcr = 0; pcr < sizeofSelect * 8u; pcr++) {
+            if (!(p [3 + pcr / 8] & (1 << (pcr % 8))) || digestSize == 0 ||
+                pcr >= IMPLEMENTATION_PCR || sent == tpm->maxDigests)
+                continue;
+            select [pcr / 8] |= 1 << (pcr % 8);
+            digests = put16 (digests, digestSize);
+            for (j = 0; j < digestSize; j++)
+                *digests++ = pcr_byte (hash, pcr, tpm->counter, j);
+            sent++;
+        }
+        p += 3 + sizeofSelect;
+    }
+    put32 (outCount, banksOut);
+    r = put32 (r, sent);
+    memcpy (r, digestBuffer, digests - digestBuffer);
+    r += digests - digestBuffer;
+
+    fake_tpm_respond (&tpm->base, TPM_ST_NO_SESSIONS, TPM_RC_SUCCESS, r);
+}
+
+typedef struct {
+    pcr_tpm_t tpm;
+    TPML_PCR_SELECTION selection;
+    PCR_SNAPSHOT snapshot;
+} pcr_snapshot_data_t;
+
+static void
+pcr_snapshot_setup (void **state)
+{
+    pcr_snapshot_data_t *data = calloc (1, sizeof (pcr_snapshot_data_t));
+
+    fake_tpm_init (&data->tpm.base, pcr_command);
+    data->tpm.maxDigests = 8;
+    data->tpm.counter = 100;
+
+    *state = data;
+}
+
+static void
+pcr_snapshot_teardown (void **state)
+{
+    free (*state);
+}
+
+static TSS2_RC
+take (pcr_snapshot_data_t *data)
+{
+    return PcrSnapshotTake ((TSS2_TCTI_CONTEXT *)&data->tpm, &data->selection,
+                            &data->snapshot);
+}
+
+/* Checks every PCR in mask of bank hash against the values for counter. */
+static void
+assert_bank (PCR_SNAPSHOT *snapshot, TPMI_ALG_HASH hash, UINT32 mask, UINT32 counter)
+{
+    UINT32 pcr, i;
+    BYTE *digest;
+
+    for (pcr = 0; pcr < IMPLEMENTATION_PCR; pcr++) {
+        digest = PcrSnapshotDigest (snapshot, hash, pcr);
+        if (!(mask & (1u << pcr))) {
+            assert_null (digest);
+            continue;
+        }
+        assert_non_null (digest);
+        for (i = 0; i < bank_size (hash); i++)
+            assert_int_equal (digest [i], pcr_byte (hash, pcr, counter, i));
+    }
+}
+
+/*
+ * All 24 PCRs of two banks take six reads, and come back packed: SHA1
+ * first, then SHA256, each in PCR order.
+ */
+static void
+pcr_snapshot_two_banks (void **state)
+{
+    pcr_snapshot_data_t *data = (pcr_snapshot_data_t *)*state;
+    TSS2_RC rc;
+
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA1, ALL_PCRS);
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA256, 0x00ff0000);
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA256, 0x0000ffff);
+    assert_int_equal (data->selection.count, 2);
+
+    rc = take (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->snapshot.reads, 6);
+    assert_int_equal (data->snapshot.retries, 0);
+    assert_int_equal (data->snapshot.pcrUpdateCounter, 100);
+    assert_int_equal (data->snapshot.bankCount, 2);
+    assert_int_equal (data->snapshot.digestsSize, 24 * 20 + 24 * 32);
+    assert_int_equal (data->snapshot.banks [1].offset, 24 * 20);
+    assert_true (PcrSnapshotDigest (&data->snapshot, TPM_ALG_SHA256, 0) ==
+                 data->snapshot.digests + 24 * 20);
+    assert_bank (&data->snapshot, TPM_ALG_SHA1, ALL_PCRS, 100);
+    assert_bank (&data->snapshot, TPM_ALG_SHA256, ALL_PCRS, 100);
+    assert_false (data->tpm.base.pending);
+}
+
+/*
+ * A TPM that returns fewer digests than asked for is asked again for the
+ * rest; a bank it doesn't have is left out of the snapshot.
+ */
+static void
+pcr_snapshot_partial (void **state)
+{
+    pcr_snapshot_data_t *data = (pcr_snapshot_data_t *)*state;
+    TSS2_RC rc;
+
+    data->tpm.maxDigests = 5;
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA256, 0x00a5a5a5);
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA384, ALL_PCRS);
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA1, 0x00000003);
+
+    rc = take (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_bank (&data->snapshot, TPM_ALG_SHA256, 0x00a5a5a5, 100);
+    assert_bank (&data->snapshot, TPM_ALG_SHA1, 0x00000003, 100);
+    assert_null (PcrSnapshotDigest (&data->snapshot, TPM_ALG_SHA384, 0));
+    assert_int_equal (data->snapshot.banks [1].pcrMask, 0);
+    assert_int_equal (data->snapshot.digestsSize, 12 * 32 + 2 * 20);
+}
+
+/*
+ * A PCR that changes between reads restarts the snapshot; if they keep
+ * changing, the caller is told to try again.
+ */
+static void
+pcr_snapshot_counter_changes (void **state)
+{
+    pcr_snapshot_data_t *data = (pcr_snapshot_data_t *)*state;
+    TSS2_RC rc;
+
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA1, ALL_PCRS);
+    PcrSelectionAdd (&data->selection, TPM_ALG_SHA256, ALL_PCRS);
+
+    data->tpm.extendAt [0] = 3;
+    rc = take (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->snapshot.retries, 1);
+    assert_int_equal (data->snapshot.pcrUpdateCounter, 101);
+    assert_bank (&data->snapshot, TPM_ALG_SHA1, ALL_PCRS, 101);
+    assert_bank (&data->snapshot, TPM_ALG_SHA256, ALL_PCRS, 101);
+    assert_false (data->tpm.base.pending);
+
+    /* One change per try. */
+    data->tpm.reads = 0;
+    data->tpm.extendAt [0] = 2;
+    data->tpm.extendAt [1] = 8;
+    data->tpm.extendAt [2] = 14;
+    data->tpm.extendAt [3] = 20;
+    rc = take (data);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_TRY_AGAIN));
+    assert_int_equal (data->snapshot.retries, PCR_SNAPSHOT_MAX_TRIES - 1);
+    assert_null (PcrSnapshotDigest (&data->snapshot, TPM_ALG_SHA1, 0));
+    assert_false (data->tpm.base.pending);
+}
+
+static void
+pcr_snapshot_bad_selection (void **state)
+{
+    pcr_snapshot_data_t *data = (pcr_snapshot_data_t *)*state;
+    TSS2_RC rc;
+
+    PcrSelectionAdd (&data->selection, TPM_ALG_NULL, ALL_PCRS);
+    rc = take (data);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_VALUE));
+    assert_int_equal (data->tpm.reads, 0);
+
+    rc = PcrSnapshotTake ((TSS2_TCTI_CONTEXT *)&data->tpm, NULL, &data->snapshot);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_REFERENCE);
+
+    /* Nothing selected is an empty snapshot. */
+    data->selection.count = 0;
+    rc = take (data);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->snapshot.reads, 0);
+    assert_int_equal (data->snapshot.digestsSize, 0);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (pcr_snapshot_two_banks,
+                                  pcr_snapshot_setup,
+                                  pcr_snapshot_teardown),
+        unit_test_setup_teardown (pcr_snapshot_partial,
+                                  pcr_snapshot_setup,
+                                  pcr_snapshot_teardown),
+        unit_test_setup_teardown (pcr_snapshot_counter_changes,
+                                  pcr_snapshot_setup,
+                                  pcr_snapshot_teardown),
+        unit_test_setup_teardown (pcr_snapshot_bad_selection,
+                                  pcr_snapshot_setup,
+                                  pcr_snapshot_teardown),
+    };
+    return run_tests (tests);
+}
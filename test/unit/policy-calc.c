@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sample.h"
+
+/*
+ * Expected digests were computed independently from the update rules in
+ * TPM 2.0 Part 3; the PolicyAuthValue one is the well-known value.
+ */
+static const UINT8 authValueDigest [] = {
+    0x8f, 0xcd, 0x21, 0x69, 0xab, 0x92, 0x69, 0x4e,
+    0x0c, 0x63, 0x3f, 0x1a, 0xb7, 0x72, 0x84, 0x2b,
+    0x82, 0x41, 0xbb, 0xc2, 0x02, 0x88, 0x98, 0x1f,
+    0xc7, 0xac, 0x1e, 0xdd, 0xc1, 0xfd, 0xdb, 0x0e,
+};
+
+/* PolicyLocality( 3 ), PolicyCommandCode( NV_Read ), PolicyPCR( SHA1 0,3 ) */
+static const UINT8 chainDigest [] = {
+    0x30, 0xce, 0x14, 0x0a, 0x41, 0x50, 0xff, 0xd9,
+    0xc4, 0x80, 0x9b, 0x51, 0x16, 0xb5, 0x30, 0x46,
+    0xce, 0x49, 0x38, 0x54, 0x00, 0x82, 0xa8, 0x8a,
+    0xb9, 0x00, 0x69, 0xcd, 0x8d, 0xf7, 0xbb, 0x6c,
+};
+
+/* PolicyOR( chain, authValue ) */
+static const UINT8 orDigest [] = {
+    0x8d, 0xc1, 0x6f, 0x28, 0x71, 0x5f, 0xcf, 0x70,
+    0xf1, 0x23, 0xa0, 0x12, 0xe6, 0x82, 0xf7, 0xb5,
+    0x8a, 0x7d, 0x23, 0xfe, 0x7b, 0x34, 0x74, 0x09,
+    0x2d, 0x4e, 0xd7, 0x9f, 0x6a, 0x8d, 0x0e, 0xa9,
+};
+
+/* ... then PolicySecret( TPM_RH_OWNER, "ref" ) */
+static const UINT8 secretDigest [] = {
+    0x9b, 0x23, 0x66, 0xed, 0xa9, 0x78, 0xf5, 0x33,
+    0xec, 0x51, 0xcf, 0x84, 0xab, 0xc4, 0x2d, 0x91,
+    0x2f, 0x37, 0x29, 0x4d, 0xf1, 0x4b, 0x52, 0x1a,
+    0xce, 0x58, 0x15, 0x61, 0xb6, 0xde, 0x20, 0xbb,
+};
+
+/* PolicyAuthorize( keySign, empty policyRef ) */
+static const UINT8 authorizeDigest [] = {
+    0xa4, 0xf7, 0xbf, 0xab, 0x24, 0x72, 0xe1, 0x43,
+    0xef, 0x60, 0xd4, 0x10, 0x94, 0xcb, 0xe7, 0xce,
+    0xc1, 0x68, 0x17, 0x93, 0x8d, 0x7d, 0xb6, 0x3e,
+    0xcf, 0x34, 0x43, 0x27, 0xa3, 0x61, 0x02, 0xe0,
+};
+
+/* PolicyNV( name, 01020304, 0, TPM_EO_UNSIGNED_LE ) */
+static const UINT8 nvDigest [] = {
+    0xae, 0x9e, 0x5c, 0x52, 0x82, 0x92, 0x3a, 0x2e,
+    0xd4, 0x5c, 0xd2, 0x90, 0x8a, 0x8e, 0x80, 0x9c,
+    0x7b, 0x8c, 0xda, 0x2e, 0x4d, 0x37, 0x78, 0xf5,
+    0xde, 0x1a, 0x6a, 0x77, 0xd7, 0xa1, 0xf5, 0xc2,
+};
+
+static void
+assert_digest (POLICY_CALC *policy, const UINT8 *expected)
+{
+    assert_int_equal (policy->digest.t.size, 32);
+    assert_memory_equal (policy->digest.t.buffer, expected, 32);
+}
+
+/* An entity name: SHA256 nameAlg followed by a fixed digest. */
+static void
+test_name (TPM2B_NAME *name)
+{
+    name->t.size = 34;
+    name->t.name [0] = 0x00;
+    name->t.name [1] = 0x0b;
+    memset (&name->t.name [2], 0xaa, 32);
+}
+
+static void
+policy_calc_password (void **state)
+{
+    POLICY_CALC policy;
+    TSS2_RC rc;
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA256);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcAuthValue (&policy);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, authValueDigest);
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA256);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcPassword (&policy);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, authValueDigest);
+}
+
+static void
+policy_calc_chain (void **state)
+{
+    POLICY_CALC policy;
+    TPMA_LOCALITY locality;
+    TPML_DIGEST pcrValues;
+    TPML_PCR_SELECTION pcrs;
+    TPM2B_DIGEST pcrDigest;
+    TPML_DIGEST branches;
+    TPM2B_NAME ownerName;
+    TPM2B_NONCE policyRef;
+    TSS2_RC rc;
+
+    *(UINT8 *)&locality = 0;
+    locality.TPM_LOC_THREE = 1;
+
+    pcrValues.count = 2;
+    pcrValues.digests [0].t.size = 20;
+    memset (pcrValues.digests [0].t.buffer, 0, 20);
+    pcrValues.digests [1].t.size = 20;
+    memset (pcrValues.digests [1].t.buffer, 1, 20);
+
+    pcrs.count = 1;
+    pcrs.pcrSelections [0].hash = TPM_ALG_SHA1;
+    pcrs.pcrSelections [0].sizeofSelect = 3;
+    pcrs.pcrSelections [0].pcrSelect [0] = 0x09;
+    pcrs.pcrSelections [0].pcrSelect [1] = 0;
+    pcrs.pcrSelections [0].pcrSelect [2] = 0;
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA256);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcLocality (&policy, locality);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcCommandCode (&policy, TPM_CC_NV_Read);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcPcrDigest (TPM_ALG_SHA256, &pcrValues, &pcrDigest);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcPCR (&policy, &pcrDigest, &pcrs);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, chainDigest);
+
+    branches.count = 2;
+    branches.digests [0] = policy.digest;
+    branches.digests [1].t.size = 32;
+    memcpy (branches.digests [1].t.buffer, authValueDigest, 32);
+    rc = PolicyCalcOR (&policy, &branches);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, orDigest);
+
+    ownerName.t.size = 4;
+    ownerName.t.name [0] = 0x40;
+    ownerName.t.name [1] = 0x00;
+    ownerName.t.name [2] = 0x00;
+    ownerName.t.name [3] = 0x01;
+    policyRef.t.size = 3;
+    memcpy (policyRef.t.buffer, "ref", 3);
+    rc = PolicyCalcSecret (&policy, &ownerName, &policyRef);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, secretDigest);
+}
+
+/* PolicyAuthorize drops whatever came before it. */
+static void
+policy_calc_authorize_nv (void **state)
+{
+    POLICY_CALC policy;
+    TPM2B_NAME name;
+    TPM2B_OPERAND operandB;
+    TSS2_RC rc;
+
+    test_name (&name);
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA256);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcAuthValue (&policy);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcAuthorize (&policy, &name, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, authorizeDigest);
+
+    operandB.t.size = 4;
+    operandB.t.buffer [0] = 1;
+    operandB.t.buffer [1] = 2;
+    operandB.t.buffer [2] = 3;
+    operandB.t.buffer [3] = 4;
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA256);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = PolicyCalcNV (&policy, &name, &operandB, 0, TPM_EO_UNSIGNED_LE);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_digest (&policy, nvDigest);
+}
+
+static void
+policy_calc_bad_input (void **state)
+{
+    POLICY_CALC policy;
+    TPML_DIGEST branches;
+    TPML_PCR_SELECTION pcrs;
+    TPM2B_DIGEST pcrDigest;
+    TSS2_RC rc;
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_NULL);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_VALUE));
+
+    rc = PolicyCalcInit (&policy, TPM_ALG_SHA1);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (policy.digest.t.size, 20);
+
+    branches.count = 1;
+    rc = PolicyCalcOR (&policy, &branches);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_VALUE));
+
+    /* Offline, PolicyPCR can't read the PCRs itself. */
+    pcrs.count = 0;
+    pcrDigest.t.size = 0;
+    rc = PolicyCalcPCR (&policy, &pcrDigest, &pcrs);
+    assert_int_equal (rc, APPLICATION_ERROR (TSS2_BASE_RC_BAD_VALUE));
+
+    rc = PolicyCalcSecret (&policy, NULL, NULL);
+    assert_int_equal (rc, TSS2_APP_RC_BAD_REFERENCE);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test (policy_calc_password),
+        unit_test (policy_calc_chain),
+        unit_test (policy_calc_authorize_nv),
+        unit_test (policy_calc_bad_input),
+    };
+    return run_tests (tests);
+}
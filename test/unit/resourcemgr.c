@@ -0,0 +1,693 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+#include <sapi/tpm20.h>
+#include <tcti/tcti_loopback.h>
+#include "sysapi_util.h"
+#include "syscontext.h"
+#include "resourcemgr.h"
+#include "rmstore.h"
+
+/* Defined by the resource manager. */
+extern TSS2_TCTI_CONTEXT *downstreamTctiContext;
+extern TSS2_RC InitResourceMgr (int debugLevel);
+extern TSS2_RC FlushSessionsAndClearTable (UINT64 connectionId);
+extern TSS2_SYS_CONTEXT *resMgrSysContext;
+extern TSS2_RC GetCommandsCached (TSS2_SYS_CONTEXT *resMgrSysContext, const char *cacheFile,
+                                  UINT32 manufacturer, UINT32 firmwareVersion1,
+                                  UINT32 firmwareVersion2, UINT32 numCommands,
+                                  TPML_CCA **supportedCommands);
+
+/* Connection the tests' commands come from. */
+#define CONNECTION 1
+
+/* Properties reported for TPM_CAP_TPM_PROPERTIES, in increasing order. */
+static const UINT32 tpmProperties [][2] = {
+    { TPM_PT_MANUFACTURER, 0x494e5443 },
+    { TPM_PT_FIRMWARE_VERSION_1, 1 },
+    { TPM_PT_FIRMWARE_VERSION_2, 2 },
+    { TPM_PT_ACTIVE_SESSIONS_MAX, 64 },
+    { TPM_PT_CONTEXT_GAP_MAX, 255 },
+    { TPM_PT_MAX_COMMAND_SIZE, 4096 },
+    { TPM_PT_MAX_RESPONSE_SIZE, 4096 },
+    { TPM_PT_TOTAL_COMMANDS, 7 },
+    { TPM_PT_HR_LOADED, 0 },
+};
+
+/* TPMA_CC for a command taking cHandles handles, returning rHandle. */
+#define COMMAND_ATTRIBUTES(cc, cHandles, rHandle) \
+    (((cc) & 0xffff) | ((UINT32)(cHandles) << 25) | ((UINT32)(rHandle) << 28))
+
+/* Commands reported for TPM_CAP_COMMANDS. */
+static const UINT32 tpmCommands [] = {
+    COMMAND_ATTRIBUTES (TPM_CC_Startup, 0, 0),
+    COMMAND_ATTRIBUTES (TPM_CC_GetCapability, 0, 0),
+    COMMAND_ATTRIBUTES (TPM_CC_GetRandom, 0, 0),
+    COMMAND_ATTRIBUTES (TPM_CC_LoadExternal, 0, 1),
+    COMMAND_ATTRIBUTES (TPM_CC_VerifySignature, 1, 0),
+    COMMAND_ATTRIBUTES (TPM_CC_Certify, 2, 0),
+    COMMAND_ATTRIBUTES (TPM_CC_StartAuthSession, 2, 1),
+};
+
+static const uint8_t getRandomCommand [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x01, 0x7b, 0x00, 0x04,
+};
+
+typedef struct {
+    /* GetRandom is answered with this code 'failures' times, then succeeds. */
+    TPM_RC failureCode;
+    UINT32 failures;
+    UINT32 getRandomCalls;
+    UINT8 lastCommand [sizeof (getRandomCommand)];
+    /* Objects loaded with LoadExternal or ContextLoad. */
+    UINT32 loads;
+    UINT32 verifyCalls;
+    TPM_HANDLE verifiedHandle;
+    /* Reported by ReadClock. */
+    UINT32 resetCount;
+    UINT32 restartCount;
+    /* GetCapability calls, by capability. */
+    UINT32 propertyQueries;
+    UINT32 commandQueries;
+    UINT32 handleQueries;
+} tpm_data_t;
+
+/* Two backends; tests that don't care about backends use the primary. */
+static TSS2_TCTI_CONTEXT *tcti [2];
+static tpm_data_t tpm [2];
+
+static uint8_t *
+put32 (uint8_t *buffer, UINT32 value)
+{
+    buffer [0] = (uint8_t)(value >> 24);
+    buffer [1] = (uint8_t)(value >> 16);
+    buffer [2] = (uint8_t)(value >> 8);
+    buffer [3] = (uint8_t)value;
+    return buffer + 4;
+}
+
+static uint8_t *
+put16 (uint8_t *buffer, UINT16 value)
+{
+    buffer [0] = (uint8_t)(value >> 8);
+    buffer [1] = (uint8_t)value;
+    return buffer + 2;
+}
+
+static UINT32
+get32 (const uint8_t *buffer)
+{
+    return ((UINT32)buffer [0] << 24) | ((UINT32)buffer [1] << 16) |
+           ((UINT32)buffer [2] << 8) | buffer [3];
+}
+
+/* Every object is handle 0x80000000 and the context blob is its backend. */
+#define OBJECT_HANDLE 0x80000000
+
+/* Just enough of a TPM for InitResourceMgr, GetRandom and one object. */
+static TSS2_RC
+tpm_responder (void *data, const uint8_t *command, size_t commandSize,
+               uint8_t *response, size_t *responseSize)
+{
+    tpm_data_t *tpm = (tpm_data_t *)data;
+    TPM_CC commandCode = get32 (command + 6);
+    uint8_t *next = response + sizeof (TPM20_ErrorResponse);
+    TPM_RC responseCode = TPM_RC_SUCCESS;
+    UINT32 capability, property, count, found = 0, i;
+    uint8_t *countPtr;
+
+    if (commandCode == TPM_CC_GetCapability && commandSize >= 22) {
+        capability = get32 (command + 10);
+        property = get32 (command + 14);
+        count = get32 (command + 18);
+        *next++ = 0;
+        next = put32 (next, capability);
+        countPtr = next;
+        next += 4;
+        if (capability == TPM_CAP_TPM_PROPERTIES) {
+            tpm->propertyQueries++;
+            for (i = 0; i < sizeof (tpmProperties) / sizeof (tpmProperties [0]) && found < count; i++) {
+                if (tpmProperties [i][0] >= property) {
+                    next = put32 (next, tpmProperties [i][0]);
+                    next = put32 (next, tpmProperties [i][1]);
+                    found++;
+                }
+            }
+        } else if (capability == TPM_CAP_HANDLES) {
+            tpm->handleQueries++;
+        } else if (capability == TPM_CAP_COMMANDS) {
+            tpm->commandQueries++;
+            for (i = 0; i < sizeof (tpmCommands) / sizeof (tpmCommands [0]) && found < count; i++) {
+                next = put32 (next, tpmCommands [i]);
+                found++;
+            }
+        }
+        put32 (countPtr, found);
+    } else if (commandCode == TPM_CC_GetRandom) {
+        tpm->getRandomCalls++;
+        memcpy (tpm->lastCommand, command, sizeof (tpm->lastCommand));
+        if (tpm->failures > 0) {
+            tpm->failures--;
+            responseCode = tpm->failureCode;
+        } else {
+            /* Different bytes for every call. */
+            count = command [10] << 8 | command [11];
+            next = put16 (next, count);
+            for (i = 0; i < count; i++)
+                *next++ = (uint8_t)(0xde + tpm->getRandomCalls + i);
+        }
+    } else if (commandCode == TPM_CC_ReadClock) {
+        memset (next, 0, 16);
+        next = put32 (next + 16, tpm->resetCount);
+        next = put32 (next, tpm->restartCount);
+        *next++ = 1;
+    } else if (commandCode == TPM_CC_LoadExternal || commandCode == TPM_CC_ContextLoad) {
+        tpm->loads++;
+        next = put32 (next, OBJECT_HANDLE);
+        if (commandCode == TPM_CC_LoadExternal)
+            next = put16 (next, 0);
+    } else if (commandCode == TPM_CC_ContextSave) {
+        next = put32 (next, 0);
+        next = put32 (next, tpm->loads);
+        next = put32 (next, OBJECT_HANDLE);
+        next = put32 (next, TPM_RH_NULL);
+        next = put16 (next, 1);
+        *next++ = (uint8_t)(tpm - &tpm [0]);
+    } else if (commandCode == TPM_CC_VerifySignature) {
+        tpm->verifyCalls++;
+        tpm->verifiedHandle = get32 (command + 10);
+    } else if (commandCode != TPM_CC_Startup && commandCode != TPM_CC_FlushContext) {
+        responseCode = TPM_RC_COMMAND_CODE;
+    }
+
+    *responseSize = next - response;
+    response [0] = 0x80;
+    response [1] = 0x01;
+    put32 (response + 2, (UINT32)*responseSize);
+    put32 (response + 6, responseCode);
+    return TSS2_RC_SUCCESS;
+}
+
+/* The resource manager is a singleton; bring it up once for every test. */
+static void
+resourcemgr_setup (void **state)
+{
+    TCTI_LOOPBACK_CONF conf = { tpm_responder, NULL, 0, NULL, NULL };
+    size_t size;
+    int i;
+
+    memset (tpm, 0, sizeof (tpm));
+    rmRetryLimit = RESMGR_DEFAULT_RETRY_LIMIT;
+    rmRetryInitialSleepUs = 1;
+    rmRetryMaxSleepUs = 4;
+    rmDefaultCommandTimeoutMs = 0;
+    rmCancelWaitMs = RESMGR_DEFAULT_CANCEL_WAIT_MS;
+    ResMgrSetCommandTimeout (TPM_CC_GetRandom, 0);
+
+    if (tcti [0] == NULL) {
+        InitLoopbackTcti (NULL, &size, &conf);
+        for (i = 0; i < 2; i++) {
+            conf.responderData = &tpm [i];
+            tcti [i] = calloc (1, size);
+            assert_int_equal (InitLoopbackTcti (tcti [i], &size, &conf), TSS2_RC_SUCCESS);
+            assert_int_equal (ResMgrAddBackend (tcti [i]), TSS2_RC_SUCCESS);
+        }
+        assert_true (downstreamTctiContext == tcti [0]);
+        assert_int_equal (InitResourceMgr (-1), TSS2_RC_SUCCESS);
+        /* One round trip for each kind of thing the RM needs to know. */
+        assert_int_equal (tpm [0].propertyQueries, 1);
+        assert_int_equal (tpm [0].commandQueries, 1);
+        assert_int_equal (tpm [1].propertyQueries, 1);
+        /* No sessions are loaded, so only objects are looked for. */
+        assert_int_equal (tpm [1].handleQueries, 1);
+        memset (tpm, 0, sizeof (tpm));
+    }
+    *state = tpm;
+}
+
+static void
+resourcemgr_teardown (void **state)
+{
+    LoopbackTctiSetLatency (tcti [0], 0);
+    LoopbackTctiSetLatency (tcti [1], 0);
+    LoopbackTctiSetWedged (tcti [0], 0);
+}
+
+/* Sends a GetRandom through the RM and returns the response code it gets. */
+static TPM_RC
+get_random (void)
+{
+    uint8_t command [sizeof (getRandomCommand)];
+    uint8_t response [64];
+    UINT32 responseSize = sizeof (response);
+
+    memcpy (command, getRandomCommand, sizeof (command));
+    assert_int_equal (ResourceMgrSendTpmCommand (downstreamTctiContext, sizeof (command), command),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (ResourceMgrReceiveTpmResponse (downstreamTctiContext, &responseSize,
+                                                     response, TSS2_TCTI_TIMEOUT_BLOCK),
+                      TSS2_RC_SUCCESS);
+    assert_true (responseSize >= sizeof (TPM20_ErrorResponse));
+    return get32 (response + 6);
+}
+
+/* TPM_RC_RETRY and TPM_RC_YIELDED never reach the client. */
+static void
+resourcemgr_retry (void **state)
+{
+    RESMGR_STATS before, after;
+
+    ResMgrGetStats (&before);
+    tpm [0].failureCode = TPM_RC_RETRY;
+    tpm [0].failures = 2;
+    assert_int_equal (get_random (), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].getRandomCalls, 3);
+    assert_memory_equal (tpm [0].lastCommand, getRandomCommand, sizeof (getRandomCommand));
+
+    tpm [0].failureCode = TPM_RC_YIELDED;
+    tpm [0].failures = 1;
+    assert_int_equal (get_random (), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].getRandomCalls, 5);
+
+    ResMgrGetStats (&after);
+    assert_int_equal (after.commands - before.commands, 2);
+    assert_int_equal (after.retriedCommands - before.retriedCommands, 2);
+    assert_int_equal (after.retries - before.retries, 3);
+    assert_int_equal (after.retriesExhausted, before.retriesExhausted);
+    assert_true (after.retrySleepUs > before.retrySleepUs);
+}
+
+/* Past the limit the client gets the TPM's answer. */
+static void
+resourcemgr_retry_exhausted (void **state)
+{
+    RESMGR_STATS before, after;
+
+    ResMgrGetStats (&before);
+    rmRetryLimit = 3;
+    tpm [0].failureCode = TPM_RC_TESTING;
+    tpm [0].failures = 100;
+    assert_int_equal (get_random (), TPM_RC_TESTING);
+    assert_int_equal (tpm [0].getRandomCalls, 4);
+
+    ResMgrGetStats (&after);
+    assert_int_equal (after.retries - before.retries, 3);
+    assert_int_equal (after.retriesExhausted - before.retriesExhausted, 1);
+    /* Sleeps double, but never past the cap. */
+    assert_int_equal (after.retrySleepUs - before.retrySleepUs, 1 + 2 + 4);
+}
+
+/* Other errors are passed straight through. */
+static void
+resourcemgr_no_retry (void **state)
+{
+    RESMGR_STATS before, after;
+
+    ResMgrGetStats (&before);
+    tpm [0].failureCode = TPM_RC_VALUE;
+    tpm [0].failures = 1;
+    assert_int_equal (get_random (), TPM_RC_VALUE);
+    assert_int_equal (tpm [0].getRandomCalls, 1);
+    ResMgrGetStats (&after);
+    assert_int_equal (after.retries, before.retries);
+}
+
+/* An overdue command is canceled and the RM goes on to the next one. */
+static void
+resourcemgr_timeout (void **state)
+{
+    RESMGR_STATS before, after;
+
+    ResMgrGetStats (&before);
+    assert_int_equal (ResMgrSetCommandTimeout (TPM_CC_GetRandom, 5), TSS2_RC_SUCCESS);
+    assert_int_equal (ResMgrGetCommandTimeout (TPM_CC_GetRandom), 5);
+    assert_int_equal (ResMgrGetCommandTimeout (TPM_CC_Startup), 0);
+
+    LoopbackTctiSetLatency (downstreamTctiContext, 200 * 1000 * 1000);
+    assert_int_equal (get_random (), TPM_RC_CANCELED);
+    ResMgrGetStats (&after);
+    assert_int_equal (after.timeouts - before.timeouts, 1);
+
+    /* Fast enough, or with no timeout, commands complete as usual. */
+    LoopbackTctiSetLatency (downstreamTctiContext, 1000 * 1000);
+    assert_int_equal (get_random (), TPM_RC_SUCCESS);
+    assert_int_equal (ResMgrSetCommandTimeout (TPM_CC_GetRandom, 0), TSS2_RC_SUCCESS);
+    LoopbackTctiSetLatency (downstreamTctiContext, 10 * 1000 * 1000);
+    assert_int_equal (get_random (), TPM_RC_SUCCESS);
+    ResMgrGetStats (&after);
+    assert_int_equal (after.timeouts - before.timeouts, 1);
+}
+
+static void
+resourcemgr_timeout_table (void **state)
+{
+    UINT32 i;
+
+    rmDefaultCommandTimeoutMs = 1000;
+    assert_int_equal (ResMgrGetCommandTimeout (TPM_CC_Sign), 1000);
+    for (i = 0; i < RESMGR_MAX_COMMAND_TIMEOUTS - 1; i++)
+        assert_int_equal (ResMgrSetCommandTimeout (TPM_CC_FIRST + i, 10), TSS2_RC_SUCCESS);
+    assert_int_equal (ResMgrSetCommandTimeout (TPM_CC_LAST, 10), TSS2_RESMGR_TOO_MANY_TIMEOUTS);
+    /* Existing entries can still be changed. */
+    assert_int_equal (ResMgrSetCommandTimeout (TPM_CC_FIRST, 20), TSS2_RC_SUCCESS);
+    assert_int_equal (ResMgrGetCommandTimeout (TPM_CC_FIRST), 20);
+
+    for (i = 0; i < RESMGR_MAX_COMMAND_TIMEOUTS - 1; i++)
+        ResMgrSetCommandTimeout (TPM_CC_FIRST + i, 0);
+}
+
+/* Stateless commands go to whichever backend is idle. */
+static void
+resourcemgr_stateless_balance (void **state)
+{
+    uint8_t getCapability [] = {
+        0x80, 0x01, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x01, 0x7a,
+        0x00, 0x00, 0x00, 0x01, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    };
+    uint8_t command [sizeof (getRandomCommand)];
+    uint8_t response [64];
+    UINT32 responseSize;
+    int i;
+
+    assert_true (ResMgrStatelessCommand (getRandomCommand, sizeof (getRandomCommand)));
+    /* TPM_CAP_HANDLES would show the client the RM's real handles. */
+    assert_false (ResMgrStatelessCommand (getCapability, sizeof (getCapability)));
+    put32 (getCapability + 10, TPM_CAP_TPM_PROPERTIES);
+    assert_true (ResMgrStatelessCommand (getCapability, sizeof (getCapability)));
+    memcpy (command, getRandomCommand, sizeof (command));
+    put16 (command, TPM_ST_SESSIONS);
+    assert_false (ResMgrStatelessCommand (command, sizeof (command)));
+
+    for (i = 0; i < 4; i++) {
+        memcpy (command, getRandomCommand, sizeof (command));
+        responseSize = sizeof (response);
+        assert_int_equal (ResMgrSendStatelessCommand (3, command, sizeof (command),
+                                                      response, &responseSize),
+                          TSS2_RC_SUCCESS);
+        assert_int_equal (get32 (response + 6), TPM_RC_SUCCESS);
+    }
+    assert_int_equal (tpm [0].getRandomCalls, 2);
+    assert_int_equal (tpm [1].getRandomCalls, 2);
+}
+
+static void *
+stateless_client (void *data)
+{
+    uint8_t command [sizeof (getRandomCommand)];
+    uint8_t response [64];
+    UINT32 responseSize;
+    long failures = 0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        memcpy (command, getRandomCommand, sizeof (command));
+        responseSize = sizeof (response);
+        if (ResMgrSendStatelessCommand (3, command, sizeof (command),
+                                        response, &responseSize) != TSS2_RC_SUCCESS ||
+                get32 (response + 6) != TPM_RC_SUCCESS)
+            failures++;
+    }
+    return (void *)failures;
+}
+
+/* Clients running stateless commands at once use both backends. */
+static void
+resourcemgr_stateless_concurrent (void **state)
+{
+    pthread_t threads [2];
+    void *failures;
+    int i;
+
+    LoopbackTctiSetLatency (tcti [0], 5 * 1000 * 1000);
+    LoopbackTctiSetLatency (tcti [1], 5 * 1000 * 1000);
+    for (i = 0; i < 2; i++)
+        assert_int_equal (pthread_create (&threads [i], NULL, stateless_client, NULL), 0);
+    for (i = 0; i < 2; i++) {
+        assert_int_equal (pthread_join (threads [i], &failures), 0);
+        assert_true (failures == NULL);
+    }
+    assert_int_equal (tpm [0].getRandomCalls + tpm [1].getRandomCalls, 8);
+    assert_true (tpm [0].getRandomCalls > 0);
+    assert_true (tpm [1].getRandomCalls > 0);
+}
+
+/* Runs a command for CONNECTION and returns its response code and handle. */
+static TPM_RC
+execute (uint8_t *command, UINT32 commandSize, TPM_HANDLE *handle)
+{
+    uint8_t response [64];
+    UINT32 responseSize = sizeof (response);
+
+    put32 (command + 2, commandSize);
+    assert_int_equal (ResMgrExecuteCommand (CONNECTION, 3, command, commandSize,
+                                            response, &responseSize),
+                      TSS2_RC_SUCCESS);
+    if (handle != NULL)
+        *handle = get32 (response + 10);
+    return get32 (response + 6);
+}
+
+static TPM_RC
+load_external (TPMI_RH_HIERARCHY hierarchy, TPM_HANDLE *handle)
+{
+    uint8_t command [10 + 2 + 2 + 8 + 4] = { 0 };
+    uint8_t *next = command;
+
+    next = put16 (next, TPM_ST_NO_SESSIONS);
+    next = put32 (next, 0);
+    next = put32 (next, TPM_CC_LoadExternal);
+    next = put16 (next, 0);
+    next = put16 (next, 8);
+    put32 (next + 8, hierarchy);
+    return execute (command, sizeof (command), handle);
+}
+
+static TPM_RC
+handle_command (TPM_CC commandCode, TPM_HANDLE handle0, TPM_HANDLE handle1)
+{
+    uint8_t command [10 + 4 + 4];
+
+    put16 (command, TPM_ST_NO_SESSIONS);
+    put32 (command + 6, commandCode);
+    put32 (command + 10, handle0);
+    put32 (command + 14, handle1);
+    return execute (command, commandCode == TPM_CC_VerifySignature ? 14 : 18, NULL);
+}
+
+/*
+ * External keys for the NULL hierarchy are spread over the backends, and
+ * commands using them follow them; a command can't mix backends.
+ */
+static void
+resourcemgr_backend_routing (void **state)
+{
+    TPM_HANDLE keys [2];
+    UINT32 first, primaryLoads;
+
+    assert_int_equal (load_external (TPM_RH_NULL, &keys [0]), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].loads + tpm [1].loads, 1);
+    first = tpm [1].loads;
+    assert_int_equal (load_external (TPM_RH_NULL, &keys [1]), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [!first].loads, 1);
+    assert_true (keys [0] != keys [1]);
+
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, keys [0], 0), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [first].verifyCalls, 1);
+    assert_int_equal (tpm [first].verifiedHandle, OBJECT_HANDLE);
+    assert_int_equal (tpm [!first].verifyCalls, 0);
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, keys [1], 0), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [!first].verifyCalls, 1);
+
+    assert_int_equal (handle_command (TPM_CC_Certify, keys [0], keys [1]),
+                      TSS2_RESMGR_BACKEND_MISMATCH);
+    /* Sessions belong to the primary. */
+    assert_int_equal (handle_command (TPM_CC_StartAuthSession, keys [first ? 0 : 1], TPM_RH_NULL),
+                      TSS2_RESMGR_BACKEND_MISMATCH);
+
+    /* Keys in other hierarchies stay in the primary. */
+    primaryLoads = tpm [0].loads;
+    assert_int_equal (load_external (TPM_RH_OWNER, NULL), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].loads, primaryLoads + 1);
+
+    FlushSessionsAndClearTable (CONNECTION);
+}
+
+/*
+ * A TPM that ignores the cancel is given up on: the client gets
+ * TPM_RC_CANCELED, and other commands for that TPM fail at once until it
+ * answers, when what the command had loaded is flushed.
+ */
+static void
+resourcemgr_abandon (void **state)
+{
+    RESMGR_STATS before, after;
+    TPM_HANDLE key;
+    UINT32 loads, handleQueries;
+
+    assert_int_equal (load_external (TPM_RH_OWNER, &key), TPM_RC_SUCCESS);
+    ResMgrGetStats (&before);
+    rmDefaultCommandTimeoutMs = 5;
+    rmCancelWaitMs = 5;
+    LoopbackTctiSetWedged (tcti [0], 1);
+    LoopbackTctiSetLatency (tcti [0], 100 * 1000 * 1000);
+    loads = tpm [0].loads;
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, key, 0), TPM_RC_CANCELED);
+    assert_int_equal (tpm [0].loads, loads + 1);
+    ResMgrGetStats (&after);
+    assert_int_equal (after.timeouts - before.timeouts, 1);
+    assert_int_equal (after.abandoned - before.abandoned, 1);
+
+    handleQueries = tpm [0].handleQueries;
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, key, 0),
+                      TSS2_RESMGR_BACKEND_UNRESPONSIVE);
+    assert_int_equal (tpm [0].verifyCalls, 1);
+
+    /* Once the TPM answers, objects and sessions are flushed and the
+       key is loaded again from its saved context.  The RM looks for
+       leftover objects after every command, too. */
+    usleep (100 * 1000);
+    LoopbackTctiSetLatency (tcti [0], 0);
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, key, 0), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].handleQueries, handleQueries + 2 + 1);
+    assert_int_equal (tpm [0].loads, loads + 2);
+    assert_int_equal (tpm [0].verifyCalls, 2);
+
+    FlushSessionsAndClearTable (CONNECTION);
+}
+
+/*
+ * A token lets a client take back its objects from an RM restarted with
+ * the same store, as long as the TPM hasn't been reset.
+ */
+static void
+resourcemgr_store (void **state)
+{
+    char storeFile [] = "/tmp/resourcemgr-store-XXXXXX";
+    const RM_STORE_ENTRY *record;
+    RM_STORE_STATE storeState;
+    UINT32 count;
+    TPM_HANDLE key, otherKey;
+    UINT64 token = 0, badToken;
+    int fd;
+
+    fd = mkstemp (storeFile);
+    assert_true (fd >= 0);
+    close (fd);
+
+    assert_int_equal (ResMgrOpenStore (storeFile), TSS2_RC_SUCCESS);
+    assert_int_equal (load_external (TPM_RH_OWNER, &key), TPM_RC_SUCCESS);
+    assert_int_equal (ResMgrReattach (CONNECTION, &token), TSS2_RC_SUCCESS);
+    assert_true (token != 0);
+    record = RmStoreCurrent (&storeState, &count);
+    assert_non_null (record);
+    assert_int_equal (count, 1);
+    assert_int_equal (record->virtualHandle, key);
+    assert_true (record->token == token);
+
+    /* The RM dies: its table goes, the file stays. */
+    ResMgrCloseStore ();
+    FlushSessionsAndClearTable (CONNECTION);
+
+    assert_int_equal (ResMgrOpenStore (storeFile), TSS2_RC_SUCCESS);
+    /* Restored entries are nobody's until a client reattaches. */
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, key, 0), TSS2_RESMGR_UNOWNED_HANDLE);
+    badToken = token + 1;
+    assert_int_equal (ResMgrReattach (CONNECTION, &badToken), TSS2_RESMGR_UNKNOWN_TOKEN);
+    assert_int_equal (ResMgrReattach (CONNECTION, &token), TSS2_RC_SUCCESS);
+    assert_int_equal (handle_command (TPM_CC_VerifySignature, key, 0), TPM_RC_SUCCESS);
+    assert_int_equal (tpm [0].verifiedHandle, OBJECT_HANDLE);
+    /* The restored handle isn't handed out again. */
+    assert_int_equal (load_external (TPM_RH_OWNER, &otherKey), TPM_RC_SUCCESS);
+    assert_true (otherKey != key);
+    assert_int_equal (ResMgrReattach (CONNECTION + 1, &token), TSS2_RESMGR_UNKNOWN_TOKEN);
+
+    /* Contexts from before a TPM reset are no good. */
+    ResMgrCloseStore ();
+    FlushSessionsAndClearTable (CONNECTION);
+    tpm [0].resetCount++;
+    assert_int_equal (ResMgrOpenStore (storeFile), TSS2_RC_SUCCESS);
+    assert_int_equal (ResMgrReattach (CONNECTION, &token), TSS2_RESMGR_UNKNOWN_TOKEN);
+    record = RmStoreCurrent (&storeState, &count);
+    assert_non_null (record);
+    assert_int_equal (count, 0);
+    assert_int_equal (storeState.resetCount, 1);
+
+    ResMgrCloseStore ();
+    unlink (storeFile);
+}
+
+/* The command table is read from the TPM once for each firmware version. */
+static void
+resourcemgr_command_cache (void **state)
+{
+    char cacheFile [] = "/tmp/resourcemgr-commands-XXXXXX";
+    TPML_CCA *commands [3];
+    int fd;
+
+    fd = mkstemp (cacheFile);
+    assert_true (fd >= 0);
+    close (fd);
+
+    assert_int_equal (GetCommandsCached (resMgrSysContext, cacheFile, 0x494e5443, 1, 2, 7, &commands [0]),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (tpm [0].commandQueries, 1);
+    assert_int_equal (GetCommandsCached (resMgrSysContext, cacheFile, 0x494e5443, 1, 2, 7, &commands [1]),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (tpm [0].commandQueries, 1);
+    assert_int_equal (commands [1]->count, 7);
+    assert_memory_equal (commands [0], commands [1], sizeof (UINT32) + 7 * sizeof (TPMA_CC));
+
+    assert_int_equal (GetCommandsCached (resMgrSysContext, cacheFile, 0x494e5443, 1, 3, 7, &commands [2]),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (tpm [0].commandQueries, 2);
+
+    free (commands [0]);
+    free (commands [1]);
+    free (commands [2]);
+    unlink (cacheFile);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (resourcemgr_retry,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_retry_exhausted,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_no_retry,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_timeout,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_timeout_table,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_stateless_balance,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_stateless_concurrent,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_backend_routing,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_abandon,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_store,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+        unit_test_setup_teardown (resourcemgr_command_cache,
+                                  resourcemgr_setup,
+                                  resourcemgr_teardown),
+    };
+    return run_tests (tests);
+}
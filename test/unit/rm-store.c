@@ -0,0 +1,228 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cmocka.h>
+#include <sapi/tpm20.h>
+#include "rmstore.h"
+
+#define CAPACITY 4
+
+typedef struct {
+    char fileName [32];
+} store_data_t;
+
+static void
+store_setup (void **state)
+{
+    store_data_t *data = calloc (1, sizeof (store_data_t));
+    int fd;
+
+    strcpy (data->fileName, "/tmp/rm-store-XXXXXX");
+    fd = mkstemp (data->fileName);
+    assert_true (fd >= 0);
+    close (fd);
+    assert_int_equal (RmStoreOpen (data->fileName, CAPACITY), 0);
+    *state = data;
+}
+
+static void
+store_teardown (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+
+    RmStoreClose ();
+    unlink (data->fileName);
+    free (data);
+}
+
+/*
+ * Commits count entries with virtual handles base, base + 1, ... and
+ * contexts with blobSize bytes of blob each.
+ */
+static void
+commit_blobs (UINT32 count, TPM_HANDLE base, UINT32 resetCount, UINT16 blobSize)
+{
+    RM_STORE_STATE state = { resetCount, 0, 0 };
+    TPMS_CONTEXT context;
+    UINT32 i;
+
+    assert_non_null (RmStoreBegin (count));
+    memset (&context, 0, sizeof (context));
+    context.contextBlob.t.size = blobSize;
+    for (i = 0; i < count; i++) {
+        memset (context.contextBlob.t.buffer, base + i, blobSize);
+        RmStorePut (i, base + i, 0, 0, 0, 1, 0, &context);
+    }
+    RmStoreCommit (&state, count);
+}
+
+static void
+commit (UINT32 count, TPM_HANDLE base, UINT32 resetCount)
+{
+    commit_blobs (count, base, resetCount, 0);
+}
+
+static void
+reopen (store_data_t *data, UINT32 capacity)
+{
+    RmStoreClose ();
+    assert_int_equal (RmStoreOpen (data->fileName, capacity), 0);
+}
+
+static void
+store_empty (void **state)
+{
+    RM_STORE_STATE storeState;
+    UINT32 count;
+
+    assert_null (RmStoreCurrent (&storeState, &count));
+    assert_null (RmStoreBegin (CAPACITY + 1));
+    RmStoreClose ();
+    assert_int_equal (RmStoreOpen ("/nonexistent/dir/store", CAPACITY), -1);
+}
+
+/* What was committed is there after a reopen. */
+static void
+store_commit (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+    const RM_STORE_ENTRY *entries;
+    RM_STORE_STATE storeState;
+    UINT32 count;
+
+    commit (2, 0x80000000, 5);
+    commit (3, 0x80000010, 6);
+    reopen (data, CAPACITY);
+
+    entries = RmStoreCurrent (&storeState, &count);
+    assert_non_null (entries);
+    assert_int_equal (count, 3);
+    assert_int_equal (storeState.resetCount, 6);
+    assert_int_equal (entries [2].virtualHandle, 0x80000012);
+}
+
+/*
+ * An image the writer died filling in leaves the previous one current,
+ * even if its header already claims to be newer.
+ */
+static void
+store_torn_commit (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+    const RM_STORE_ENTRY *entries;
+    RM_STORE_STATE storeState;
+    RM_STORE_ENTRY *next;
+    UINT64 generation = 99;
+    UINT32 count;
+    int fd;
+
+    commit (1, 0x80000000, 1);
+    commit (2, 0x80000010, 2);
+    next = RmStoreBegin (3);
+    memset (next, 0xff, 3 * sizeof (RM_STORE_ENTRY));
+    /* The first image's generation follows its magic and entry size. */
+    fd = open (data->fileName, O_WRONLY);
+    assert_true (fd >= 0);
+    assert_int_equal (pwrite (fd, &generation, sizeof (generation), 8), sizeof (generation));
+    close (fd);
+    reopen (data, CAPACITY);
+
+    entries = RmStoreCurrent (&storeState, &count);
+    assert_non_null (entries);
+    assert_int_equal (count, 2);
+    assert_int_equal (storeState.resetCount, 2);
+    assert_int_equal (entries [0].virtualHandle, 0x80000010);
+}
+
+/* An image with a damaged entry isn't used. */
+static void
+store_corrupt_entry (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+    const RM_STORE_ENTRY *entries;
+    RM_STORE_STATE storeState;
+    RM_STORE_ENTRY *current;
+    UINT32 count;
+
+    commit_blobs (1, 0x80000000, 1, 16);
+    commit_blobs (2, 0x80000010, 2, 16);
+    current = (RM_STORE_ENTRY *)RmStoreCurrent (&storeState, &count);
+    current [1].context.contextBlob.t.buffer [15] ^= 1;
+    reopen (data, CAPACITY);
+
+    entries = RmStoreCurrent (&storeState, &count);
+    assert_non_null (entries);
+    assert_int_equal (count, 1);
+    assert_int_equal (storeState.resetCount, 1);
+}
+
+/*
+ * Entries left as they were and entries whose blobs shrank or grew both
+ * check out after a reopen.
+ */
+static void
+store_reuse (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+    const RM_STORE_ENTRY *entries;
+    RM_STORE_STATE storeState;
+    UINT32 count;
+
+    commit_blobs (2, 0x80000000, 1, 100);
+    commit_blobs (2, 0x80000000, 1, 100);
+    commit_blobs (3, 0x80000000, 1, 100);
+    commit_blobs (3, 0x80000000, 1, 10);
+    commit_blobs (3, 0x80000000, 1, 200);
+    reopen (data, CAPACITY);
+    commit_blobs (3, 0x80000000, 1, 200);
+    reopen (data, CAPACITY);
+
+    entries = RmStoreCurrent (&storeState, &count);
+    assert_non_null (entries);
+    assert_int_equal (count, 3);
+    assert_int_equal (entries [2].virtualHandle, 0x80000002);
+    assert_int_equal (entries [2].context.contextBlob.t.size, 200);
+    assert_int_equal (entries [2].context.contextBlob.t.buffer [199], 2);
+}
+
+/* A file made for another capacity is started afresh. */
+static void
+store_capacity_change (void **state)
+{
+    store_data_t *data = (store_data_t *)*state;
+    RM_STORE_STATE storeState;
+    UINT32 count;
+
+    commit (1, 0x80000000, 1);
+    reopen (data, CAPACITY * 2);
+    assert_null (RmStoreCurrent (&storeState, &count));
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (store_empty,
+                                  store_setup,
+                                  store_teardown),
+        unit_test_setup_teardown (store_commit,
+                                  store_setup,
+                                  store_teardown),
+        unit_test_setup_teardown (store_torn_commit,
+                                  store_setup,
+                                  store_teardown),
+        unit_test_setup_teardown (store_corrupt_entry,
+                                  store_setup,
+                                  store_teardown),
+        unit_test_setup_teardown (store_reuse,
+                                  store_setup,
+                                  store_teardown),
+        unit_test_setup_teardown (store_capacity_change,
+                                  store_setup,
+                                  store_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+#include "syscontext.h"
+#include "fake-tpm.h"
+
+#define CMD_BUFFER_SIZE 64
+#define RSP_BUFFER_SIZE 128
+
+static TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+/*
+ * Fake TPM: remembers every command sent and answers the first 'retries'
+ * of them with TPM_RC_RETRY.  The rest get a GetCapability response with
+ * one TPM property, a PCR_Read response with one SHA1 PCR, or otherwise a
+ * GetRandom response.
+ */
+typedef struct {
+    fake_tpm_t base;
+    UINT32 transmits;
+    UINT32 retries;
+    UINT8 sent [2][CMD_BUFFER_SIZE];
+    size_t sentSize [2];
+} buffers_tpm_t;
+
+typedef struct {
+    buffers_tpm_t tcti;
+    TSS2_SYS_CONTEXT *sysContext;
+    UINT8 cmdBuffer [CMD_BUFFER_SIZE];
+    UINT8 rspBuffer [RSP_BUFFER_SIZE];
+} buffers_data_t;
+
+static void
+buffers_command (fake_tpm_t *base, const UINT8 *command, size_t size)
+{
+    buffers_tpm_t *tcti = (buffers_tpm_t *)base;
+    UINT32 slot = tcti->transmits < 2 ? tcti->transmits : 1;
+    UINT8 *r = base->response + 10;
+    UINT16 i;
+
+    assert_true (size <= CMD_BUFFER_SIZE);
+    memcpy (tcti->sent [slot], command, size);
+    tcti->sentSize [slot] = size;
+    tcti->transmits++;
+
+    if (tcti->transmits <= tcti->retries) {
+        fake_tpm_respond (base, TPM_ST_NO_SESSIONS, TPM_RC_RETRY, r);
+        return;
+    }
+
+    switch (get32 (command + 6)) {
+    case TPM_CC_GetCapability:
+        *r++ = 0;
+        r = put32 (r, TPM_CAP_TPM_PROPERTIES);
+        r = put32 (r, 1);
+        r = put32 (r, TPM_PT_MAX_RESPONSE_SIZE);
+        r = put32 (r, RSP_BUFFER_SIZE);
+        break;
+    case TPM_CC_PCR_Read:
+        r = put32 (r, 0x1234);
+        r = put32 (r, 1);
+        r = put16 (r, TPM_ALG_SHA1);
+        *r++ = 3;
+        *r++ = 0x01;
+        *r++ = 0;
+        *r++ = 0;
+        r = put32 (r, 1);
+        r = put16 (r, 20);
+        for (i = 0; i < 20; i++)
+            *r++ = (UINT8)(0xb0 + i);
+        break;
+    default:
+        r = put16 (r, 16);
+        for (i = 0; i < 16; i++)
+            *r++ = (UINT8)(0xa0 + i);
+        break;
+    }
+    fake_tpm_respond (base, TPM_ST_NO_SESSIONS, TPM_RC_SUCCESS, r);
+}
+
+static void
+buffers_setup (void **state)
+{
+    buffers_data_t *data = calloc (1, sizeof (buffers_data_t));
+    size_t size = Tss2_Sys_GetContextSize (1);
+    TSS2_RC rc;
+
+    fake_tpm_init (&data->tcti.base, buffers_command);
+
+    data->sysContext = calloc (1, size);
+    assert_non_null (data->sysContext);
+    rc = Tss2_Sys_InitializeWithBuffers (data->sysContext, size,
+                                         (TSS2_TCTI_CONTEXT *)&data->tcti,
+                                         &abiVersion,
+                                         data->cmdBuffer, CMD_BUFFER_SIZE,
+                                         data->rspBuffer, RSP_BUFFER_SIZE);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    *state = data;
+}
+
+static void
+buffers_teardown (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+
+    free (data->sysContext);
+    free (data);
+}
+
+/*
+ * Commands are built in the command buffer, responses land in the response
+ * buffer, and a TPM_RC_RETRY can be resent as is.
+ */
+static void
+buffers_retry_resubmit (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TPM2B_DIGEST randomBytes;
+    TSS2_RC rc;
+
+    data->tcti.retries = 1;
+
+    rc = Tss2_Sys_GetRandom_Prepare (data->sysContext, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_true (((_TSS2_SYS_CONTEXT_BLOB *)data->sysContext)->tpmInBuffPtr == data->cmdBuffer);
+
+    rc = Tss2_Sys_Execute (data->sysContext);
+    assert_int_equal (rc, TPM_RC_RETRY);
+
+    rc = Tss2_Sys_Execute (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->tcti.transmits, 2);
+    assert_int_equal (data->tcti.sentSize [0], 12);
+    assert_int_equal (data->tcti.sentSize [1], data->tcti.sentSize [0]);
+    assert_memory_equal (data->tcti.sent [1], data->tcti.sent [0], data->tcti.sentSize [0]);
+
+    randomBytes.t.size = sizeof (randomBytes.t.buffer);
+    rc = Tss2_Sys_GetRandom_Complete (data->sysContext, &randomBytes);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (randomBytes.t.size, 16);
+    assert_int_equal (randomBytes.t.buffer [0], 0xa0);
+    assert_int_equal (data->rspBuffer [12], 0xa0);
+}
+
+/* A successful response can't be resent; the command must be prepared again. */
+static void
+buffers_no_resubmit_after_success (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_GetRandom_Prepare (data->sysContext, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_Execute (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = Tss2_Sys_ExecuteAsync (data->sysContext);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_SEQUENCE);
+}
+
+/* The command buffer alone bounds what _Prepare can marshal. */
+static void
+buffers_small_command (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TPM2B_MAX_NV_BUFFER nvData;
+    TSS2_RC rc;
+
+    memset (&nvData, 0x5a, sizeof (nvData));
+    nvData.t.size = CMD_BUFFER_SIZE;
+    rc = Tss2_Sys_NV_Write_Prepare (data->sysContext, TPM_RH_OWNER, 0x01500000,
+                                    &nvData, 0);
+    assert_int_equal (rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+
+    nvData.t.size = 16;
+    rc = Tss2_Sys_NV_Write_Prepare (data->sysContext, TPM_RH_OWNER, 0x01500000,
+                                    &nvData, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+}
+
+static void
+buffers_bad_args (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)&data->tcti;
+    size_t size = Tss2_Sys_GetContextSize (1);
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_InitializeWithBuffers (data->sysContext, size, tcti, &abiVersion,
+                                         NULL, CMD_BUFFER_SIZE,
+                                         data->rspBuffer, RSP_BUFFER_SIZE);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_REFERENCE);
+
+    rc = Tss2_Sys_InitializeWithBuffers (data->sysContext, size, tcti, &abiVersion,
+                                         data->cmdBuffer, 4,
+                                         data->rspBuffer, RSP_BUFFER_SIZE);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_SIZE);
+
+    rc = Tss2_Sys_InitializeWithBuffers (data->sysContext, size, tcti, &abiVersion,
+                                         data->rspBuffer, CMD_BUFFER_SIZE,
+                                         data->rspBuffer + CMD_BUFFER_SIZE - 1,
+                                         RSP_BUFFER_SIZE - CMD_BUFFER_SIZE);
+    assert_int_equal (rc, TSS2_SYS_RC_BAD_VALUE);
+
+    rc = Tss2_Sys_InitializeWithBuffers (data->sysContext, 8, tcti, &abiVersion,
+                                         data->cmdBuffer, CMD_BUFFER_SIZE,
+                                         data->rspBuffer, RSP_BUFFER_SIZE);
+    assert_int_equal (rc, TSS2_SYS_RC_INSUFFICIENT_CONTEXT);
+}
+
+/*
+ * _Complete reads the response out of the response buffer, not the
+ * command buffer: the fixed-size fields ahead of the structures too.
+ */
+static void
+buffers_complete_from_response (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TPMI_YES_NO moreData = 1;
+    TPMS_CAPABILITY_DATA capabilityData;
+    TPML_PCR_SELECTION pcrSelectionIn, pcrSelectionOut;
+    TPML_DIGEST pcrValues;
+    UINT32 pcrUpdateCounter = 0;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_GetCapability (data->sysContext, NULL, TPM_CAP_TPM_PROPERTIES,
+                                 TPM_PT_MAX_RESPONSE_SIZE, 1, &moreData,
+                                 &capabilityData, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (moreData, 0);
+    assert_int_equal (capabilityData.capability, TPM_CAP_TPM_PROPERTIES);
+    assert_int_equal (capabilityData.data.tpmProperties.count, 1);
+    assert_int_equal (capabilityData.data.tpmProperties.tpmProperty [0].property,
+                      TPM_PT_MAX_RESPONSE_SIZE);
+    assert_int_equal (capabilityData.data.tpmProperties.tpmProperty [0].value,
+                      RSP_BUFFER_SIZE);
+
+    memset (&pcrSelectionIn, 0, sizeof (pcrSelectionIn));
+    pcrSelectionIn.count = 1;
+    pcrSelectionIn.pcrSelections [0].hash = TPM_ALG_SHA1;
+    pcrSelectionIn.pcrSelections [0].sizeofSelect = 3;
+    pcrSelectionIn.pcrSelections [0].pcrSelect [0] = 0x01;
+    rc = Tss2_Sys_PCR_Read (data->sysContext, NULL, &pcrSelectionIn,
+                            &pcrUpdateCounter, &pcrSelectionOut, &pcrValues,
+                            NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (pcrUpdateCounter, 0x1234);
+    assert_int_equal (pcrSelectionOut.count, 1);
+    assert_int_equal (pcrSelectionOut.pcrSelections [0].hash, TPM_ALG_SHA1);
+    assert_int_equal (pcrSelectionOut.pcrSelections [0].pcrSelect [0], 0x01);
+    assert_int_equal (pcrValues.count, 1);
+    assert_int_equal (pcrValues.digests [0].t.size, 20);
+    assert_int_equal (pcrValues.digests [0].t.buffer [19], 0xb0 + 19);
+}
+
+/* Contexts with caller buffers are freed on release, never pooled. */
+static void
+buffers_not_pooled (void **state)
+{
+    buffers_data_t *data = (buffers_data_t *)*state;
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)&data->tcti;
+    TSS2_SYS_CONTEXT *sysContext;
+
+    sysContext = InitSysContextWithBuffers (CMD_BUFFER_SIZE, RSP_BUFFER_SIZE,
+                                            tcti, &abiVersion);
+    assert_non_null (sysContext);
+    assert_true (((_TSS2_SYS_CONTEXT_BLOB *)sysContext)->separateBuffers);
+    ReleaseSysContext (&sysContext);
+    assert_null (sysContext);
+
+    sysContext = AcquireSysContext (CMD_BUFFER_SIZE, tcti, &abiVersion);
+    assert_non_null (sysContext);
+    assert_false (((_TSS2_SYS_CONTEXT_BLOB *)sysContext)->separateBuffers);
+    assert_true (((_TSS2_SYS_CONTEXT_BLOB *)sysContext)->tpmInBuffPtr ==
+                 (UINT8 *)sysContext + sizeof (_TSS2_SYS_CONTEXT_BLOB));
+    TeardownSysContext (&sysContext);
+    DrainSysContextPool ();
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (buffers_retry_resubmit,
+                                  buffers_setup,
+                                  buffers_teardown),
+        unit_test_setup_teardown (buffers_no_resubmit_after_success,
+                                  buffers_setup,
+                                  buffers_teardown),
+        unit_test_setup_teardown (buffers_small_command,
+                                  buffers_setup,
+                                  buffers_teardown),
+        unit_test_setup_teardown (buffers_bad_args,
+                                  buffers_setup,
+                                  buffers_teardown),
+        unit_test_setup_teardown (buffers_complete_from_response,
+                                  buffers_setup,
+                                  buffers_teardown),
+        unit_test_setup_teardown (buffers_not_pooled,
+                                  buffers_setup,
+                                  buffers_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,410 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+extern "C" {
+#include <cmocka.h>
+}
+/* Compile every command's await path, not only the ones called below. */
+#define TSS2_SYS_CORO_INSTANTIATE_ALL
+#include <sapi/tss2_sys_coro.hpp>
+#include <time.h>
+
+static TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+/* GetRandom response with 4 bytes of "randomness". */
+static const uint8_t getRandomResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0xde, 0xad, 0xbe, 0xef,
+};
+
+/* Unseal response with a password session: "sec", continueSession set. */
+static const uint8_t unsealResponse [] = {
+    0x80, 0x02, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x03, 's', 'e', 'c',
+    0x00, 0x00, 0x01, 0x00, 0x00,
+};
+
+/* FlushContext response: no parameters. */
+static const uint8_t flushContextResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* TPM_RC_VALUE. */
+static const uint8_t errorResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x84,
+};
+
+#define LATENCY (5 * 1000 * 1000)
+
+/* TPM_RC_COMMAND_CODE, for commands without a canned response. */
+static const uint8_t commandCodeResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x01, 0x43,
+};
+
+/*
+ * A TCTI that answers from canned responses, one per command code, each
+ * 'latency' ns after its command went out.  A receive with a timeout
+ * shorter than that gives TSS2_TCTI_RC_TRY_AGAIN.  It has no poll handles
+ * to report: its responses need nothing but time.
+ */
+typedef struct {
+    TSS2_TCTI_CONTEXT_COMMON_V1 common;
+    struct {
+        TPM_CC commandCode;
+        const uint8_t *response;
+        size_t size;
+    } canned [4];
+    size_t cannedCount;
+    const uint8_t *response;
+    size_t responseSize;
+    uint64_t latency;
+    uint64_t ready;
+    int pending;
+    unsigned commandCount;
+} fake_tcti_t;
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static TSS2_RC
+fake_transmit (TSS2_TCTI_CONTEXT *tctiContext, size_t size, uint8_t *command)
+{
+    fake_tcti_t *tcti = (fake_tcti_t *)tctiContext;
+    TPM_CC commandCode;
+    size_t i;
+
+    assert_false (tcti->pending);
+    assert_true (size >= 10);
+    commandCode = (TPM_CC)command [6] << 24 | command [7] << 16 |
+                  command [8] << 8 | command [9];
+
+    tcti->response = commandCodeResponse;
+    tcti->responseSize = sizeof (commandCodeResponse);
+    for (i = 0; i < tcti->cannedCount; i++) {
+        if (tcti->canned [i].commandCode == commandCode) {
+            tcti->response = tcti->canned [i].response;
+            tcti->responseSize = tcti->canned [i].size;
+        }
+    }
+    tcti->ready = now_ns () + tcti->latency;
+    tcti->pending = 1;
+    tcti->commandCount++;
+
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC
+fake_receive (TSS2_TCTI_CONTEXT *tctiContext, size_t *size, uint8_t *response,
+              int32_t timeout)
+{
+    fake_tcti_t *tcti = (fake_tcti_t *)tctiContext;
+    uint64_t deadline = tcti->ready;
+
+    assert_true (tcti->pending);
+    if (timeout != TSS2_TCTI_TIMEOUT_BLOCK &&
+        now_ns () + (uint64_t)timeout * 1000000 < tcti->ready)
+        deadline = now_ns () + (uint64_t)timeout * 1000000;
+    while (now_ns () < deadline)
+        ;
+    if (deadline < tcti->ready)
+        return TSS2_TCTI_RC_TRY_AGAIN;
+
+    assert_true (*size >= tcti->responseSize);
+    memcpy (response, tcti->response, tcti->responseSize);
+    *size = tcti->responseSize;
+    tcti->pending = 0;
+
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC
+fake_get_poll_handles (TSS2_TCTI_CONTEXT *tctiContext,
+                       TSS2_TCTI_POLL_HANDLE *handles, size_t *num_handles)
+{
+    *num_handles = 0;
+    return TSS2_RC_SUCCESS;
+}
+
+static void
+fake_tcti_init (fake_tcti_t *tcti, uint64_t latency)
+{
+    memset (tcti, 0, sizeof (*tcti));
+    tcti->common.version = 1;
+    tcti->common.transmit = fake_transmit;
+    tcti->common.receive = fake_receive;
+    tcti->common.getPollHandles = fake_get_poll_handles;
+    tcti->latency = latency;
+}
+
+/* Answers commandCode with response from now on. */
+static void
+fake_tcti_set_response (fake_tcti_t *tcti, TPM_CC commandCode,
+                        const uint8_t *response, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < tcti->cannedCount; i++) {
+        if (tcti->canned [i].commandCode == commandCode)
+            break;
+    }
+    assert_true (i < sizeof (tcti->canned) / sizeof (tcti->canned [0]));
+    tcti->canned [i].commandCode = commandCode;
+    tcti->canned [i].response = response;
+    tcti->canned [i].size = size;
+    if (i == tcti->cannedCount)
+        tcti->cannedCount++;
+}
+
+typedef struct {
+    fake_tcti_t tcti;
+    TSS2_SYS_CONTEXT *sysContext;
+    tss2::PollScheduler scheduler;
+    tss2::Tpm *tpm;
+} coro_data_t;
+
+static void
+coro_setup (void **state)
+{
+    coro_data_t *data = new coro_data_t ();
+    size_t size;
+    TSS2_RC rc;
+
+    fake_tcti_init (&data->tcti, LATENCY);
+    fake_tcti_set_response (&data->tcti, TPM_CC_GetRandom, getRandomResponse,
+                            sizeof (getRandomResponse));
+    fake_tcti_set_response (&data->tcti, TPM_CC_Unseal, unsealResponse,
+                            sizeof (unsealResponse));
+
+    size = Tss2_Sys_GetContextSize (0);
+    data->sysContext = (TSS2_SYS_CONTEXT *)calloc (1, size);
+    rc = Tss2_Sys_Initialize (data->sysContext, size,
+                              (TSS2_TCTI_CONTEXT *)&data->tcti, &abiVersion);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    data->tpm = new tss2::Tpm (data->sysContext, data->scheduler);
+    *state = data;
+}
+
+static void
+coro_teardown (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+
+    delete data->tpm;
+    free (data->sysContext);
+    delete data;
+}
+
+static tss2::Task
+get_random (tss2::Tpm &tpm, int count, tss2::Result< tss2::GetRandomOut > *result)
+{
+    for (int i = 0; i < count; i++) {
+        *result = co_await tpm.GetRandom (4);
+        if (!result->Ok ())
+            break;
+    }
+}
+
+static void
+assert_random (tss2::Result< tss2::GetRandomOut > *result)
+{
+    assert_int_equal (result->rc, TSS2_RC_SUCCESS);
+    assert_int_equal (result->randomBytes.t.size, 4);
+    assert_memory_equal (result->randomBytes.t.buffer, "\xde\xad\xbe\xef", 4);
+}
+
+/*
+ * A command that isn't answered at once suspends the coroutine until the
+ * scheduler resumes it; the next command starts from there.
+ */
+static void
+coro_suspend (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::GetRandomOut > result;
+
+    tss2::Task task = get_random (*data->tpm, 3, &result);
+    assert_false (task.Done ());
+    assert_false (data->scheduler.Empty ());
+    assert_int_equal (data->tcti.commandCount, 1);
+
+    data->scheduler.Run ();
+    assert_true (task.Done ());
+    assert_true (data->scheduler.Empty ());
+    assert_int_equal (data->tcti.commandCount, 3);
+    assert_random (&result);
+}
+
+/* An answer that is already there doesn't suspend at all. */
+static void
+coro_ready (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::GetRandomOut > result;
+
+    data->tcti.latency = 0;
+    tss2::Task task = get_random (*data->tpm, 2, &result);
+    assert_true (task.Done ());
+    assert_true (data->scheduler.Empty ());
+    assert_random (&result);
+}
+
+/* Without poll handles the command is waited for, blocking. */
+static void
+coro_no_poll_handles (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::GetRandomOut > result;
+
+    data->tcti.common.getPollHandles = NULL;
+    tss2::Task task = get_random (*data->tpm, 1, &result);
+    assert_true (task.Done ());
+    assert_true (data->scheduler.Empty ());
+    assert_random (&result);
+}
+
+static tss2::Task
+unseal (tss2::Tpm &tpm, TSS2_SYS_RSP_AUTHS *rspAuths,
+        tss2::Result< tss2::UnsealOut > *result)
+{
+    TPMS_AUTH_COMMAND cmdAuth = {};
+    TPMS_AUTH_COMMAND *cmdAuthList [1] = { &cmdAuth };
+    TSS2_SYS_CMD_AUTHS cmdAuths = { 1, cmdAuthList };
+
+    cmdAuth.sessionHandle = TPM_RS_PW;
+    *result = co_await tpm.Unseal (0x80000001, &cmdAuths, rspAuths);
+}
+
+/* Authorizations go out with the command and come back with the response. */
+static void
+coro_sessions (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::UnsealOut > result;
+    TPMS_AUTH_RESPONSE rspAuth = {};
+    TPMS_AUTH_RESPONSE *rspAuthList [1] = { &rspAuth };
+    TSS2_SYS_RSP_AUTHS rspAuths = { 1, rspAuthList };
+
+    tss2::Task task = unseal (*data->tpm, &rspAuths, &result);
+    data->scheduler.Run ();
+    assert_true (task.Done ());
+    assert_int_equal (result.rc, TSS2_RC_SUCCESS);
+    assert_int_equal (result.outData.t.size, 3);
+    assert_memory_equal (result.outData.t.buffer, "sec", 3);
+    assert_int_equal (rspAuth.sessionAttributes.continueSession, 1);
+}
+
+static tss2::Task
+flush (tss2::Tpm &tpm, tss2::Result< tss2::NoOutput > *result)
+{
+    *result = co_await tpm.FlushContext (0x80000001);
+}
+
+/*
+ * A command without response parameters still has its response header
+ * looked at, so Tss2_Sys_GetRpBuffer describes its response rather than
+ * the one before it: after a response with sessions, whose parameters
+ * start behind parameterSize, comes one without, whose parameters start
+ * right after the header.
+ */
+static void
+coro_no_output (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::UnsealOut > unsealed;
+    tss2::Result< tss2::NoOutput > flushed;
+    TPMS_AUTH_RESPONSE rspAuth = {};
+    TPMS_AUTH_RESPONSE *rspAuthList [1] = { &rspAuth };
+    TSS2_SYS_RSP_AUTHS rspAuths = { 1, rspAuthList };
+    const uint8_t *sessionsRpBuffer, *rpBuffer;
+    size_t rpBufferUsedSize;
+    TSS2_RC rc;
+
+    data->tcti.latency = 0;
+    fake_tcti_set_response (&data->tcti, TPM_CC_FlushContext, flushContextResponse,
+                            sizeof (flushContextResponse));
+
+    tss2::Task first = unseal (*data->tpm, &rspAuths, &unsealed);
+    assert_true (first.Done ());
+    assert_int_equal (unsealed.rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_GetRpBuffer (data->sysContext, &rpBufferUsedSize, &sessionsRpBuffer);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (rpBufferUsedSize, 5);
+
+    tss2::Task second = flush (*data->tpm, &flushed);
+    assert_true (second.Done ());
+    assert_int_equal (flushed.rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_GetRpBuffer (data->sysContext, &rpBufferUsedSize, &rpBuffer);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (rpBufferUsedSize, 0);
+    assert_true (rpBuffer == sessionsRpBuffer - sizeof (UINT32));
+}
+
+static tss2::Task
+sign_without_scheme (tss2::Tpm &tpm, tss2::Result< tss2::SignOut > *result)
+{
+    TPM2B_DIGEST digest = {};
+    TPMT_TK_HASHCHECK validation = {};
+
+    *result = co_await tpm.Sign (0x80000001, &digest, NULL, &validation);
+}
+
+/*
+ * TPM errors, and errors from _Prepare, come back in rc; the latter
+ * without sending anything.
+ */
+static void
+coro_errors (void **state)
+{
+    coro_data_t *data = (coro_data_t *)*state;
+    tss2::Result< tss2::GetRandomOut > random;
+    tss2::Result< tss2::SignOut > signature;
+
+    fake_tcti_set_response (&data->tcti, TPM_CC_GetRandom, errorResponse,
+                            sizeof (errorResponse));
+    tss2::Task task = get_random (*data->tpm, 2, &random);
+    data->scheduler.Run ();
+    assert_true (task.Done ());
+    assert_int_equal (random.rc, TPM_RC_VALUE);
+    assert_int_equal (random.Level (), TSS2_TPM_ERROR_LEVEL);
+    assert_int_equal (data->tcti.commandCount, 1);
+
+    tss2::Task sign = sign_without_scheme (*data->tpm, &signature);
+    assert_true (sign.Done ());
+    assert_int_equal (signature.rc, TSS2_SYS_RC_BAD_REFERENCE);
+    assert_int_equal (signature.Level (), TSS2_SYS_ERROR_LEVEL);
+    assert_int_equal (data->tcti.commandCount, 1);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (coro_suspend,
+                                  coro_setup,
+                                  coro_teardown),
+        unit_test_setup_teardown (coro_ready,
+                                  coro_setup,
+                                  coro_teardown),
+        unit_test_setup_teardown (coro_no_poll_handles,
+                                  coro_setup,
+                                  coro_teardown),
+        unit_test_setup_teardown (coro_sessions,
+                                  coro_setup,
+                                  coro_teardown),
+        unit_test_setup_teardown (coro_no_output,
+                                  coro_setup,
+                                  coro_teardown),
+        unit_test_setup_teardown (coro_errors,
+                                  coro_setup,
+                                  coro_teardown),
+    };
+    return run_tests (tests);
+}
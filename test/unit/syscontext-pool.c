@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+#include "syscontext.h"
+
+static TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+static TSS2_RC
+null_transmit (TSS2_TCTI_CONTEXT *tctiContext, size_t size, uint8_t *command)
+{
+    return TSS2_RC_SUCCESS;
+}
+
+static TSS2_RC
+null_receive (TSS2_TCTI_CONTEXT *tctiContext, size_t *size, uint8_t *response,
+              int32_t timeout)
+{
+    return TSS2_RC_SUCCESS;
+}
+
+typedef struct {
+    TSS2_TCTI_CONTEXT_COMMON_V1 tcti [2];
+} pool_data_t;
+
+static void
+pool_setup (void **state)
+{
+    pool_data_t *data = calloc (1, sizeof (pool_data_t));
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        data->tcti [i].version  = 1;
+        data->tcti [i].transmit = null_transmit;
+        data->tcti [i].receive  = null_receive;
+    }
+    *state = data;
+}
+
+static void
+pool_teardown (void **state)
+{
+    DrainSysContextPool ();
+    free (*state);
+}
+
+/*
+ * A released context comes back for the same TCTI and a size it can hold,
+ * but not for another TCTI or a bigger size.
+ */
+static void
+pool_reuse (void **state)
+{
+    pool_data_t *data = (pool_data_t *)*state;
+    TSS2_TCTI_CONTEXT *tcti0 = (TSS2_TCTI_CONTEXT *)&data->tcti [0];
+    TSS2_TCTI_CONTEXT *tcti1 = (TSS2_TCTI_CONTEXT *)&data->tcti [1];
+    TSS2_SYS_CONTEXT *first, *other;
+
+    first = AcquireSysContext (1000, tcti0, &abiVersion);
+    assert_non_null (first);
+    ReleaseSysContext (&first);
+    assert_null (first);
+
+    other = AcquireSysContext (1000, tcti1, &abiVersion);
+    assert_non_null (other);
+    first = AcquireSysContext (2000, tcti0, &abiVersion);
+    assert_non_null (first);
+    ReleaseSysContext (&first);
+    ReleaseSysContext (&other);
+
+    first = AcquireSysContext (500, tcti0, &abiVersion);
+    other = AcquireSysContext (2000, tcti0, &abiVersion);
+    assert_non_null (first);
+    assert_non_null (other);
+    assert_true (first != other);
+    assert_true (((_TSS2_SYS_CONTEXT_BLOB *)first)->tctiContext == tcti0);
+    assert_true (((_TSS2_SYS_CONTEXT_BLOB *)other)->maxCommandSize >= 2000);
+    ReleaseSysContext (&first);
+    ReleaseSysContext (&other);
+}
+
+/*
+ * A reused context starts clean, even after a command that reserved an
+ * authorization area and was never sent.
+ */
+static void
+pool_reset (void **state)
+{
+    pool_data_t *data = (pool_data_t *)*state;
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)&data->tcti [0];
+    TSS2_SYS_CONTEXT *sysContext, *again;
+    _TSS2_SYS_CONTEXT_BLOB *ctx;
+    TPMS_AUTH_COMMAND session;
+    TPMS_AUTH_COMMAND *sessions [1] = { &session };
+    TSS2_SYS_CMD_AUTHS cmdAuths = { 1, sessions };
+    UINT8 *tpmInBuffPtr;
+    UINT32 maxCommandSize;
+    TSS2_RC rc;
+
+    memset (&session, 0, sizeof (session));
+    session.sessionHandle = TPM_RS_PW;
+
+    sysContext = AcquireSysContext (1000, tcti, &abiVersion);
+    assert_non_null (sysContext);
+    ctx = (_TSS2_SYS_CONTEXT_BLOB *)sysContext;
+    tpmInBuffPtr = ctx->tpmInBuffPtr;
+    maxCommandSize = ctx->maxCommandSize;
+
+    rc = Tss2_Sys_ReserveCmdAuths (sysContext, &cmdAuths);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_GetRandom_Prepare (sysContext, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_true (ctx->tpmInBuffPtr != tpmInBuffPtr);
+    ctx->decryptAllowed = 1;
+    ReleaseSysContext (&sysContext);
+
+    again = AcquireSysContext (1000, tcti, &abiVersion);
+    assert_true (again == (TSS2_SYS_CONTEXT *)ctx);
+    assert_true (ctx->tpmInBuffPtr == tpmInBuffPtr);
+    assert_int_equal (ctx->maxCommandSize, maxCommandSize);
+    assert_int_equal (ctx->cmdAuthsGap, 0);
+    assert_int_equal (ctx->decryptAllowed, 0);
+    assert_int_equal (ctx->previousStage, CMD_STAGE_INITIALIZE);
+    assert_true (ctx->nextData == tpmInBuffPtr);
+
+    rc = Tss2_Sys_GetRandom_Prepare (again, 16);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    ReleaseSysContext (&again);
+}
+
+/* The pool keeps eight contexts; releases past that free the context. */
+static void
+pool_full (void **state)
+{
+    pool_data_t *data = (pool_data_t *)*state;
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)&data->tcti [0];
+    TSS2_SYS_CONTEXT *contexts [12], *pooled [8], *sysContext;
+    int i, j, found;
+
+    for (i = 0; i < 12; i++) {
+        contexts [i] = AcquireSysContext (100, tcti, &abiVersion);
+        assert_non_null (contexts [i]);
+    }
+    memcpy (pooled, contexts, sizeof (pooled));
+    for (i = 0; i < 12; i++) {
+        ReleaseSysContext (&contexts [i]);
+        assert_null (contexts [i]);
+    }
+
+    for (i = 0; i < 8; i++) {
+        contexts [i] = AcquireSysContext (100, tcti, &abiVersion);
+        for (j = 0, found = 0; j < 8; j++)
+            found |= (contexts [i] == pooled [j]);
+        assert_true (found);
+    }
+    for (i = 0; i < 8; i++)
+        ReleaseSysContext (&contexts [i]);
+
+    /* Draining frees them all; new contexts still work. */
+    DrainSysContextPool ();
+    sysContext = AcquireSysContext (100, tcti, &abiVersion);
+    assert_non_null (sysContext);
+    ReleaseSysContext (&sysContext);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (pool_reuse,
+                                  pool_setup,
+                                  pool_teardown),
+        unit_test_setup_teardown (pool_reset,
+                                  pool_setup,
+                                  pool_teardown),
+        unit_test_setup_teardown (pool_full,
+                                  pool_setup,
+                                  pool_teardown),
+    };
+    return run_tests (tests);
+}
@@ -122,6 +122,50 @@ tcti_device_log_called_test (void **state)
 }
 /* end tcti_dev_init_log */
 
+/* Initialize a TCTI context on /dev/null and check that the poll handle
+ * interface reports exactly one handle: the file descriptor of the device
+ * waiting for input. A NULL handle array is used to query the count.
+ */
+static void
+tcti_device_get_poll_handles_test (void **state)
+{
+    size_t tcti_size = 0;
+    size_t num_handles = 0;
+    TSS2_RC ret = TSS2_RC_SUCCESS;
+    TSS2_TCTI_CONTEXT *ctx = NULL;
+    TSS2_TCTI_POLL_HANDLE handles[2];
+    TCTI_DEVICE_CONF conf = {
+        "/dev/null", tcti_dev_init_log_callback, NULL
+    };
+
+    ret = InitDeviceTcti (NULL, &tcti_size, NULL);
+    assert_true (ret == TSS2_RC_SUCCESS);
+    ctx = calloc (1, tcti_size);
+    assert_non_null (ctx);
+    ret = InitDeviceTcti (ctx, 0, &conf);
+    assert_true (ret == TSS2_RC_SUCCESS);
+
+    ret = tss2_tcti_get_poll_handles (ctx, NULL, &num_handles);
+    assert_int_equal (ret, TSS2_RC_SUCCESS);
+    assert_int_equal (num_handles, 1);
+
+    num_handles = 0;
+    ret = tss2_tcti_get_poll_handles (ctx, handles, &num_handles);
+    assert_int_equal (ret, TSS2_TCTI_RC_INSUFFICIENT_BUFFER);
+    assert_int_equal (num_handles, 1);
+
+    num_handles = 2;
+    ret = tss2_tcti_get_poll_handles (ctx, handles, &num_handles);
+    assert_int_equal (ret, TSS2_RC_SUCCESS);
+    assert_int_equal (num_handles, 1);
+    assert_int_equal (handles[0].fd,
+                      ((TSS2_TCTI_CONTEXT_INTEL*)ctx)->devFile);
+    assert_int_equal (handles[0].events, POLLIN);
+
+    tss2_tcti_finalize (ctx);
+    free (ctx);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -131,6 +175,7 @@ main(int argc, char* argv[])
         unit_test (tcti_device_init_log_test),
         unit_test (tcti_device_log_called_test),
         unit_test (tcti_device_init_null_config_test),
+        unit_test (tcti_device_get_poll_handles_test),
     };
     return run_tests(tests);
 }
@@ -0,0 +1,271 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+#include "tcti/tcti_loopback.h"
+
+static TSS2_ABI_VERSION abiVersion = { TSSWG_INTEROP, TSS_SAPI_FIRST_FAMILY, TSS_SAPI_FIRST_LEVEL, TSS_SAPI_FIRST_VERSION };
+
+/* GetRandom response with 4 bytes of "randomness". */
+static const uint8_t getRandomResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0xde, 0xad, 0xbe, 0xef,
+};
+
+typedef struct {
+    TSS2_TCTI_CONTEXT *tcti;
+    TSS2_SYS_CONTEXT *sysContext;
+    UINT32 responderCalls;
+} loopback_data_t;
+
+/* Answers TPM2_Startup with success and leaves everything else alone. */
+static TSS2_RC
+startup_responder (void *data, const uint8_t *command, size_t commandSize,
+                   uint8_t *response, size_t *responseSize)
+{
+    loopback_data_t *loopback = (loopback_data_t *)data;
+    TPM_CC commandCode = CHANGE_ENDIAN_DWORD (((TPM20_Header_In *)command)->commandCode);
+    TPM_RC responseCode = commandCode == TPM_CC_Startup ? TPM_RC_SUCCESS : TPM_RC_COMMAND_CODE;
+
+    loopback->responderCalls++;
+    assert_true (*responseSize >= 10);
+    memcpy (response, "\x80\x01\x00\x00\x00\x0a", 6);
+    response [6] = (uint8_t)(responseCode >> 24);
+    response [7] = (uint8_t)(responseCode >> 16);
+    response [8] = (uint8_t)(responseCode >> 8);
+    response [9] = (uint8_t)responseCode;
+    *responseSize = 10;
+    return TSS2_RC_SUCCESS;
+}
+
+static void
+loopback_setup_latency (void **state, uint32_t latency)
+{
+    loopback_data_t *data = calloc (1, sizeof (loopback_data_t));
+    TCTI_LOOPBACK_CONF conf = { startup_responder, data, latency, NULL, NULL };
+    size_t size;
+    TSS2_RC rc;
+
+    assert_non_null (data);
+    rc = InitLoopbackTcti (NULL, &size, NULL);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    data->tcti = calloc (1, size);
+    rc = InitLoopbackTcti (data->tcti, &size, &conf);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    size = Tss2_Sys_GetContextSize (0);
+    data->sysContext = calloc (1, size);
+    rc = Tss2_Sys_Initialize (data->sysContext, size, data->tcti, &abiVersion);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    *state = data;
+}
+
+static void
+loopback_setup (void **state)
+{
+    loopback_setup_latency (state, 0);
+}
+
+static void
+loopback_setup_slow (void **state)
+{
+    loopback_setup_latency (state, 20 * 1000 * 1000);
+}
+
+static void
+loopback_teardown (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+
+    Tss2_Sys_Finalize (data->sysContext);
+    free (data->sysContext);
+    tss2_tcti_finalize (data->tcti);
+    free (data->tcti);
+    free (data);
+}
+
+static void
+loopback_init_null (void **state)
+{
+    size_t size;
+
+    assert_int_equal (InitLoopbackTcti (NULL, NULL, NULL), TSS2_TCTI_RC_BAD_VALUE);
+    assert_int_equal (InitLoopbackTcti ((TSS2_TCTI_CONTEXT *)&size, &size, NULL),
+                      TSS2_TCTI_RC_BAD_VALUE);
+}
+
+/* Canned responses win over the responder and go through the SAPI intact. */
+static void
+loopback_canned (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    TPM2B_DIGEST randomBytes;
+    TSS2_RC rc;
+
+    rc = LoopbackTctiSetResponse (data->tcti, TPM_CC_GetRandom,
+                                  getRandomResponse, sizeof (getRandomResponse));
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    randomBytes.t.size = sizeof (randomBytes.t.buffer);
+    rc = Tss2_Sys_GetRandom (data->sysContext, 0, 4, &randomBytes, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (randomBytes.t.size, 4);
+    assert_memory_equal (randomBytes.t.buffer, getRandomResponse + 12, 4);
+    assert_int_equal (data->responderCalls, 0);
+    assert_int_equal (LoopbackTctiGetCommandCount (data->tcti), 1);
+
+    /* Removing the entry hands the command to the responder again. */
+    rc = LoopbackTctiSetResponse (data->tcti, TPM_CC_GetRandom, NULL, 0);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_GetRandom (data->sysContext, 0, 4, &randomBytes, 0);
+    assert_int_equal (rc, TPM_RC_COMMAND_CODE);
+    assert_int_equal (data->responderCalls, 1);
+}
+
+static void
+loopback_responder (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_Startup (data->sysContext, TPM_SU_CLEAR);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (data->responderCalls, 1);
+
+    rc = LoopbackTctiSetResponse (data->tcti, TPM_CC_GetRandom,
+                                  getRandomResponse, 4);
+    assert_int_equal (rc, TSS2_TCTI_RC_BAD_VALUE);
+}
+
+/* The TCTI enforces transmit/receive ordering and reports short buffers. */
+static void
+loopback_sequence (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    uint8_t command [] = { 0x80, 0x01, 0x00, 0x00, 0x00, 0x0c,
+                           0x00, 0x00, 0x01, 0x7b, 0x00, 0x04 };
+    uint8_t response [sizeof (getRandomResponse)];
+    size_t size;
+    TSS2_RC rc;
+
+    LoopbackTctiSetResponse (data->tcti, TPM_CC_GetRandom,
+                             getRandomResponse, sizeof (getRandomResponse));
+
+    size = sizeof (response);
+    rc = tss2_tcti_receive (data->tcti, &size, response, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_TCTI_RC_BAD_SEQUENCE);
+
+    rc = tss2_tcti_transmit (data->tcti, sizeof (command), command);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = tss2_tcti_transmit (data->tcti, sizeof (command), command);
+    assert_int_equal (rc, TSS2_TCTI_RC_BAD_SEQUENCE);
+
+    size = 4;
+    rc = tss2_tcti_receive (data->tcti, &size, response, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_TCTI_RC_INSUFFICIENT_BUFFER);
+    assert_int_equal (size, sizeof (getRandomResponse));
+
+    rc = tss2_tcti_receive (data->tcti, &size, response, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_memory_equal (response, getRandomResponse, size);
+}
+
+/* With latency, a non-blocking receive says try again until it has passed. */
+static void
+loopback_latency (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    TSS2_RC rc;
+
+    rc = Tss2_Sys_Startup_Prepare (data->sysContext, TPM_SU_CLEAR);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteAsync (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_NONE);
+    assert_int_equal (rc, TSS2_TCTI_RC_TRY_AGAIN);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+}
+
+/* Canceling before the latency has passed fails the command at once. */
+static void
+loopback_cancel (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    TSS2_RC rc;
+
+    assert_int_equal (tss2_tcti_cancel (data->tcti), TSS2_TCTI_RC_BAD_SEQUENCE);
+
+    rc = Tss2_Sys_Startup_Prepare (data->sysContext, TPM_SU_CLEAR);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteAsync (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_NONE);
+    assert_int_equal (rc, TSS2_TCTI_RC_TRY_AGAIN);
+
+    assert_int_equal (tss2_tcti_cancel (data->tcti), TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_NONE);
+    assert_int_equal (rc, TPM_RC_CANCELED);
+
+    /* Without latency the command is done before it can be canceled. */
+    assert_int_equal (LoopbackTctiSetLatency (data->tcti, 0), TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_Startup_Prepare (data->sysContext, TPM_SU_CLEAR);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteAsync (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    assert_int_equal (tss2_tcti_cancel (data->tcti), TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+}
+
+/* A wedged TCTI ignores cancel and answers only after its latency. */
+static void
+loopback_wedged (void **state)
+{
+    loopback_data_t *data = (loopback_data_t *)*state;
+    TSS2_RC rc;
+
+    assert_int_equal (LoopbackTctiSetWedged (data->tcti, 1), TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_Startup_Prepare (data->sysContext, TPM_SU_CLEAR);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteAsync (data->sysContext);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+
+    assert_int_equal (tss2_tcti_cancel (data->tcti), TSS2_RC_SUCCESS);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_NONE);
+    assert_int_equal (rc, TSS2_TCTI_RC_TRY_AGAIN);
+    rc = Tss2_Sys_ExecuteFinish (data->sysContext, TSS2_TCTI_TIMEOUT_BLOCK);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test (loopback_init_null),
+        unit_test_setup_teardown (loopback_canned,
+                                  loopback_setup,
+                                  loopback_teardown),
+        unit_test_setup_teardown (loopback_responder,
+                                  loopback_setup,
+                                  loopback_teardown),
+        unit_test_setup_teardown (loopback_sequence,
+                                  loopback_setup,
+                                  loopback_teardown),
+        unit_test_setup_teardown (loopback_latency,
+                                  loopback_setup_slow,
+                                  loopback_teardown),
+        unit_test_setup_teardown (loopback_cancel,
+                                  loopback_setup_slow,
+                                  loopback_teardown),
+        unit_test_setup_teardown (loopback_wedged,
+                                  loopback_setup_slow,
+                                  loopback_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+#include "tcti/tcti_loopback.h"
+#include "tcti/tcti_record.h"
+
+/* GetRandom response with 4 bytes of "randomness". */
+static const uint8_t getRandomResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0xde, 0xad, 0xbe, 0xef,
+};
+
+static const uint8_t getRandomCommand [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x01, 0x7b, 0x00, 0x04,
+};
+
+typedef struct {
+    TSS2_TCTI_CONTEXT *loopback;
+    TSS2_TCTI_CONTEXT *record;
+    char logFile [32];
+} record_data_t;
+
+static TSS2_TCTI_CONTEXT *
+record_tcti_new (record_data_t *data, uint32_t connection)
+{
+    TCTI_RECORD_CONF conf = { data->loopback, data->logFile, connection, NULL, NULL };
+    TSS2_TCTI_CONTEXT *tcti;
+    size_t size;
+    TSS2_RC rc;
+
+    rc = InitRecordTcti (NULL, &size, &conf);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    tcti = calloc (1, size);
+    rc = InitRecordTcti (tcti, &size, &conf);
+    assert_int_equal (rc, TSS2_RC_SUCCESS);
+    return tcti;
+}
+
+static void
+record_setup (void **state)
+{
+    record_data_t *data = calloc (1, sizeof (record_data_t));
+    TCTI_LOOPBACK_CONF conf = { NULL, NULL, 0, NULL, NULL };
+    size_t size;
+    int fd;
+
+    strcpy (data->logFile, "/tmp/tcti-record-XXXXXX");
+    fd = mkstemp (data->logFile);
+    assert_true (fd >= 0);
+    close (fd);
+    unlink (data->logFile);
+
+    InitLoopbackTcti (NULL, &size, &conf);
+    data->loopback = calloc (1, size);
+    assert_int_equal (InitLoopbackTcti (data->loopback, &size, &conf), TSS2_RC_SUCCESS);
+    LoopbackTctiSetResponse (data->loopback, TPM_CC_GetRandom,
+                             getRandomResponse, sizeof (getRandomResponse));
+
+    data->record = record_tcti_new (data, 7);
+    *state = data;
+}
+
+static void
+record_teardown (void **state)
+{
+    record_data_t *data = (record_data_t *)*state;
+
+    tss2_tcti_finalize (data->record);
+    free (data->record);
+    free (data->loopback);
+    unlink (data->logFile);
+    free (data);
+}
+
+static void
+round_trip (TSS2_TCTI_CONTEXT *tcti)
+{
+    uint8_t response [64];
+    size_t size = sizeof (response);
+
+    assert_int_equal (tss2_tcti_transmit (tcti, sizeof (getRandomCommand),
+                                          (uint8_t *)getRandomCommand),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (tss2_tcti_receive (tcti, &size, response, TSS2_TCTI_TIMEOUT_BLOCK),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (size, sizeof (getRandomResponse));
+    assert_memory_equal (response, getRandomResponse, size);
+}
+
+static void
+record_init_bad (void **state)
+{
+    record_data_t *data = (record_data_t *)*state;
+    TCTI_RECORD_CONF conf = { NULL, data->logFile, 0, NULL, NULL };
+    TSS2_TCTI_CONTEXT *context;
+    size_t size;
+
+    assert_int_equal (InitRecordTcti (NULL, NULL, &conf), TSS2_TCTI_RC_BAD_VALUE);
+    assert_int_equal (InitRecordTcti (NULL, &size, &conf), TSS2_RC_SUCCESS);
+    context = calloc (1, size);
+    assert_int_equal (InitRecordTcti (context, &size, &conf), TSS2_TCTI_RC_BAD_VALUE);
+    conf.downstream = data->loopback;
+    conf.logFile = "/nonexistent/dir/log";
+    assert_int_equal (InitRecordTcti (context, &size, &conf), TSS2_TCTI_RC_IO_ERROR);
+    free (context);
+}
+
+/* Each command/response pair becomes one record, as the caller saw it. */
+static void
+record_pairs (void **state)
+{
+    record_data_t *data = (record_data_t *)*state;
+    const TCTI_RECORD_HEADER *header;
+    TCTI_RECORD_LOG log;
+
+    round_trip (data->record);
+    assert_int_equal (tss2_tcti_set_locality (data->record, 1), TSS2_RC_SUCCESS);
+    round_trip (data->record);
+    assert_int_equal (RecordTctiGetDroppedCount (data->record), 0);
+
+    assert_int_equal (RecordLogOpen (&log, data->logFile), TSS2_RC_SUCCESS);
+    header = RecordLogNext (&log);
+    assert_non_null (header);
+    assert_int_equal (header->connection, 7);
+    assert_int_equal (header->locality, 3);
+    assert_int_equal (header->commandSize, sizeof (getRandomCommand));
+    assert_int_equal (header->responseSize, sizeof (getRandomResponse));
+    assert_memory_equal (TCTI_RECORD_COMMAND (header), getRandomCommand, sizeof (getRandomCommand));
+    assert_memory_equal (TCTI_RECORD_RESPONSE (header), getRandomResponse, sizeof (getRandomResponse));
+
+    header = RecordLogNext (&log);
+    assert_non_null (header);
+    assert_int_equal (header->locality, 1);
+    assert_null (RecordLogNext (&log));
+    RecordLogClose (&log);
+}
+
+/* Asking for the response size alone is not a response. */
+static void
+record_size_query (void **state)
+{
+    record_data_t *data = (record_data_t *)*state;
+    TCTI_RECORD_LOG log;
+    size_t size;
+
+    assert_int_equal (tss2_tcti_transmit (data->record, sizeof (getRandomCommand),
+                                          (uint8_t *)getRandomCommand),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (tss2_tcti_receive (data->record, &size, NULL, TSS2_TCTI_TIMEOUT_BLOCK),
+                      TSS2_RC_SUCCESS);
+    assert_int_equal (size, sizeof (getRandomResponse));
+
+    assert_int_equal (RecordLogOpen (&log, data->logFile), TSS2_RC_SUCCESS);
+    assert_null (RecordLogNext (&log));
+    RecordLogClose (&log);
+}
+
+/* A second recorder appends to the same log. */
+static void
+record_shared_log (void **state)
+{
+    record_data_t *data = (record_data_t *)*state;
+    TSS2_TCTI_CONTEXT *other = record_tcti_new (data, 8);
+    const TCTI_RECORD_HEADER *header;
+    TCTI_RECORD_LOG log;
+
+    round_trip (data->record);
+    round_trip (other);
+    round_trip (data->record);
+    tss2_tcti_finalize (other);
+    free (other);
+
+    assert_int_equal (RecordLogOpen (&log, data->logFile), TSS2_RC_SUCCESS);
+    header = RecordLogNext (&log);
+    assert_int_equal (header->connection, 7);
+    header = RecordLogNext (&log);
+    assert_int_equal (header->connection, 8);
+    header = RecordLogNext (&log);
+    assert_int_equal (header->connection, 7);
+    assert_null (RecordLogNext (&log));
+    RecordLogClose (&log);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (record_init_bad,
+                                  record_setup,
+                                  record_teardown),
+        unit_test_setup_teardown (record_pairs,
+                                  record_setup,
+                                  record_teardown),
+        unit_test_setup_teardown (record_size_query,
+                                  record_setup,
+                                  record_teardown),
+        unit_test_setup_teardown (record_shared_log,
+                                  record_setup,
+                                  record_teardown),
+    };
+    return run_tests (tests);
+}
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <cmocka.h>
+#include <tpm20.h>
+#include "sysapi_util.h"
+#include "tcti/tcti_trace.h"
+#include "tracehooks.h"
+
+#define RING_SIZE 16
+
+static const uint8_t getRandomCommand [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x01, 0x7b, 0x00, 0x04,
+};
+
+/* GetRandom response with 4 bytes of "randomness". */
+static const uint8_t getRandomResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0xde, 0xad, 0xbe, 0xef,
+};
+
+static const uint8_t retryResponse [] = {
+    0x80, 0x01, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x09, 0x22,
+};
+
+static void
+traced_command (TSS2_TCTI_CONTEXT *tcti, const uint8_t *response, size_t size)
+{
+    TCTI_TRACE (TctiTraceSend (tcti, getRandomCommand, sizeof (getRandomCommand)));
+    TCTI_TRACE (TctiTraceFirstByte (tcti));
+    TCTI_TRACE (TctiTraceComplete (tcti, response, size));
+}
+
+static void
+trace_setup (void **state)
+{
+    TCTI_TRACE_RECORD records [RING_SIZE];
+    TSS2_TCTI_CONTEXT_INTEL *tcti = calloc (1, sizeof (TSS2_TCTI_CONTEXT_INTEL));
+
+    tcti->status.locality = 3;
+    TctiTraceEnable (RING_SIZE);
+    while (TctiTraceDrain (records, RING_SIZE) != 0)
+        ;
+    *state = tcti;
+}
+
+static void
+trace_teardown (void **state)
+{
+    TctiTraceEnable (0);
+    free (*state);
+}
+
+static void
+trace_disabled (void **state)
+{
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)*state;
+    TCTI_TRACE_RECORD record;
+
+    TctiTraceEnable (0);
+    traced_command (tcti, getRandomResponse, sizeof (getRandomResponse));
+    assert_int_equal (TctiTraceDrain (&record, 1), 0);
+}
+
+static void
+trace_record (void **state)
+{
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)*state;
+    TCTI_TRACE_RECORD records [2];
+
+    traced_command (tcti, getRandomResponse, sizeof (getRandomResponse));
+    traced_command (tcti, retryResponse, sizeof (retryResponse));
+
+    assert_int_equal (TctiTraceDrain (records, 2), 2);
+    assert_int_equal (records [0].commandCode, TPM_CC_GetRandom);
+    assert_int_equal (records [0].commandSize, sizeof (getRandomCommand));
+    assert_int_equal (records [0].responseCode, TPM_RC_SUCCESS);
+    assert_int_equal (records [0].responseSize, sizeof (getRandomResponse));
+    assert_int_equal (records [0].locality, 3);
+    assert_true (records [0].sendTime != 0);
+    assert_true (records [0].sendTime <= records [0].firstByteTime);
+    assert_true (records [0].firstByteTime <= records [0].completeTime);
+    assert_int_equal (records [1].responseCode, TPM_RC_RETRY);
+    assert_true (records [0].completeTime <= records [1].sendTime);
+    assert_int_equal (TctiTraceDrain (records, 2), 0);
+}
+
+/* A command sent before tracing was enabled isn't traced. */
+static void
+trace_enabled_late (void **state)
+{
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)*state;
+    TCTI_TRACE_RECORD record;
+
+    TctiTraceEnable (0);
+    TCTI_TRACE (TctiTraceSend (tcti, getRandomCommand, sizeof (getRandomCommand)));
+    TctiTraceEnable (RING_SIZE);
+    TCTI_TRACE (TctiTraceComplete (tcti, getRandomResponse, sizeof (getRandomResponse)));
+    assert_int_equal (TctiTraceDrain (&record, 1), 0);
+}
+
+/* A full ring drops new records and counts them. */
+static void
+trace_overflow (void **state)
+{
+    TSS2_TCTI_CONTEXT *tcti = (TSS2_TCTI_CONTEXT *)*state;
+    TCTI_TRACE_RECORD records [RING_SIZE + 4];
+    uint64_t dropped = TctiTraceGetDroppedCount ();
+    int i;
+
+    for (i = 0; i < RING_SIZE + 4; i++)
+        traced_command (tcti, getRandomResponse, sizeof (getRandomResponse));
+    assert_int_equal (TctiTraceGetDroppedCount () - dropped, 4);
+    assert_int_equal (TctiTraceDrain (records, RING_SIZE + 4), RING_SIZE);
+
+    traced_command (tcti, getRandomResponse, sizeof (getRandomResponse));
+    assert_int_equal (TctiTraceDrain (records, RING_SIZE + 4), 1);
+}
+
+static void *
+trace_thread (void *data)
+{
+    TSS2_TCTI_CONTEXT_INTEL tcti;
+    int i;
+
+    memset (&tcti, 0, sizeof (tcti));
+    for (i = 0; i < 5; i++)
+        traced_command ((TSS2_TCTI_CONTEXT *)&tcti, getRandomResponse,
+                        sizeof (getRandomResponse));
+    return NULL;
+}
+
+/* Each thread has its own ring; records outlive the thread. */
+static void
+trace_threads (void **state)
+{
+    TCTI_TRACE_RECORD records [RING_SIZE];
+    pthread_t threads [3];
+    int i;
+
+    for (i = 0; i < 3; i++)
+        assert_int_equal (pthread_create (&threads [i], NULL, trace_thread, NULL), 0);
+    for (i = 0; i < 3; i++)
+        pthread_join (threads [i], NULL);
+
+    assert_int_equal (TctiTraceDrain (records, 4), 4);
+    assert_int_equal (TctiTraceDrain (records, RING_SIZE), 11);
+}
+
+int
+main (void)
+{
+    const UnitTest tests [] = {
+        unit_test_setup_teardown (trace_disabled,
+                                  trace_setup,
+                                  trace_teardown),
+        unit_test_setup_teardown (trace_record,
+                                  trace_setup,
+                                  trace_teardown),
+        unit_test_setup_teardown (trace_enabled_late,
+                                  trace_setup,
+                                  trace_teardown),
+        unit_test_setup_teardown (trace_overflow,
+                                  trace_setup,
+                                  trace_teardown),
+        unit_test_setup_teardown (trace_threads,
+                                  trace_setup,
+                                  trace_teardown),
+    };
+    return run_tests (tests);
+}